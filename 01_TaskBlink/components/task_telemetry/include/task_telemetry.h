@@ -0,0 +1,130 @@
+#ifndef __TASK_TELEMETRY_H__
+#define __TASK_TELEMETRY_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "driver/uart.h"
+
+/*
+ * 任务遥测：周期性地给所有任务拍"快照"（栈水位、CPU占用、堆最小剩余、队列深度），
+ * 以紧凑的二进制格式存入环形缓冲区，需要时再通过日志或者串口导出。
+ *
+ * 依赖 menuconfig 中的两个选项（见工程的 sdkconfig.defaults）：
+ *   CONFIG_FREERTOS_USE_TRACE_FACILITY      -> uxTaskGetSystemState()
+ *   CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS -> 每个任务的运行时间计数
+ */
+
+#define TASK_TELEMETRY_MAGIC 0x4D4C5454 // "TTLM"，串口二进制导出的帧头
+#define TASK_TELEMETRY_VERSION 2
+#define TASK_TELEMETRY_ID_NONE 0xFF // 名字表满了以后新任务的编号
+#define TASK_TELEMETRY_CPU_UNKNOWN 0xFFFF // 任务第一次被采到（或者第一个快照），还没有上一次的运行时间计数
+
+// 遥测配置
+typedef struct
+{
+    uint32_t period_ms;        /*!< 快照周期 */
+    uint16_t ring_depth;       /*!< 环形缓冲区中保留的快照个数 */
+    uint8_t max_tasks;         /*!< 每个快照最多记录的任务数，同时也是名字表的容量 */
+    uint8_t max_queues;        /*!< 最多可以登记的队列数 */
+    UBaseType_t task_priority; /*!< 采样任务的优先级 */
+    uint32_t task_stack;       /*!< 采样任务的栈大小 */
+} task_telemetry_config_t;
+
+#define TASK_TELEMETRY_DEFAULT_CONFIG() \
+    {                                   \
+        .period_ms = 3000,              \
+        .ring_depth = 16,               \
+        .max_tasks = 16,                \
+        .max_queues = 4,                \
+        .task_priority = 1,             \
+        .task_stack = 3072,             \
+    }
+
+// 以下三个结构体即环形缓冲区中的存储格式，也是串口导出的格式（小端）
+// 一个快照 = 快照头 + task_count 条任务记录 + queue_count 条队列记录
+typedef struct __attribute__((packed))
+{
+    uint32_t timestamp_ms;  /*!< 拍快照时的系统时间 */
+    uint32_t heap_free;     /*!< 当前剩余堆 */
+    uint32_t heap_min_free; /*!< 上电以来最小剩余堆 */
+    uint16_t cpu_idle;      /*!< 本周期空闲任务的CPU占比，千分比，第一个快照为 TASK_TELEMETRY_CPU_UNKNOWN */
+    uint8_t task_count;
+    uint8_t queue_count;
+} task_telemetry_snapshot_t;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t id;          /*!< 名字表中的编号，见 task_telemetry_task_name() */
+    uint8_t priority;    /*!< 当前优先级 */
+    uint8_t state;       /*!< eTaskState */
+    uint16_t stack_free; /*!< 栈的历史最小剩余（高水位），字节 */
+    uint16_t cpu;        /*!< 本周期的CPU占比，千分比，或 TASK_TELEMETRY_CPU_UNKNOWN */
+} task_telemetry_task_t;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t id;      /*!< 登记顺序 */
+    uint8_t waiting; /*!< 队列中的消息数 */
+    uint8_t spaces;  /*!< 队列剩余空间 */
+} task_telemetry_queue_t;
+
+// 二进制导出的输出函数，返回实际写出的字节数
+typedef int (*task_telemetry_write_fn_t)(void *ctx, const void *data, size_t len);
+
+/**
+ * @description: 初始化并启动采样任务
+ * @return       ESP_OK / ESP_ERR_NO_MEM / ESP_ERR_INVALID_STATE（已初始化）/ ESP_ERR_NOT_SUPPORTED（未打开跟踪选项）
+ * @param {task_telemetry_config_t} *config 配置，传NULL使用默认配置
+ */
+esp_err_t task_telemetry_init(const task_telemetry_config_t *config);
+
+/**
+ * @description: 登记一个需要记录深度的队列
+ * @return       ESP_OK / ESP_ERR_NO_MEM（超过 max_queues）
+ * @param {char} *name 队列名，只保存指针，需要是常量字符串
+ * @param {QueueHandle_t} queue 队列句柄
+ */
+esp_err_t task_telemetry_watch_queue(const char *name, QueueHandle_t queue);
+
+/**
+ * @description: 立即拍一个快照（不等周期到达）
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE
+ */
+esp_err_t task_telemetry_sample(void);
+
+/**
+ * @description: 根据编号查询任务名
+ * @return       任务名，编号无效时返回 "?"
+ * @param {uint8_t} id 任务记录中的 id
+ */
+const char *task_telemetry_task_name(uint8_t id);
+
+/**
+ * @description: 用日志打印最新的一个快照
+ */
+void task_telemetry_log_latest(void);
+
+/**
+ * @description: 用日志打印环形缓冲区内每个任务的最小栈余量和最大CPU占比，用于调整栈大小
+ */
+void task_telemetry_log_summary(void);
+
+/**
+ * @description: 以二进制格式导出名字表和全部快照（从旧到新）
+ * @return       ESP_OK / ESP_FAIL（输出函数写失败）
+ * @param {task_telemetry_write_fn_t} write 输出函数
+ * @param {void} *ctx 输出函数的参数
+ */
+esp_err_t task_telemetry_dump(task_telemetry_write_fn_t write, void *ctx);
+
+/**
+ * @description: 通过串口导出二进制数据，串口驱动需已安装
+ * @return       同 task_telemetry_dump()
+ * @param {uart_port_t} port 串口号
+ */
+esp_err_t task_telemetry_dump_uart(uart_port_t port);
+
+#endif /* __TASK_TELEMETRY_H__ */
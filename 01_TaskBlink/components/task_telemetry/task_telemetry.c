@@ -0,0 +1,535 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_system.h"
+#include "esp_log.h"
+#include "task_telemetry.h"
+
+static const char *TAG = "task_telemetry";
+
+// 没打开这两个选项时没有 uxTaskGetSystemState() 和运行时间计数，只有 init 报错返回
+#define TELEMETRY_SUPPORTED (configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS)
+
+// 名字表的一项：快照里只存1字节的编号，名字只存一份
+typedef struct
+{
+    char name[configMAX_TASK_NAME_LEN];
+    UBaseType_t task_number; /*!< FreeRTOS 分配的任务序号，用来识别同一个任务 */
+    uint32_t last_seen;      /*!< 最后一次出现在快照中的序号 */
+    bool used;
+} telemetry_name_t;
+
+typedef struct
+{
+    const char *name;
+    QueueHandle_t handle;
+} telemetry_queue_t;
+
+typedef struct
+{
+    task_telemetry_config_t config;
+    SemaphoreHandle_t lock;
+    TaskHandle_t task;
+
+    telemetry_name_t *names;  /*!< max_tasks 项 */
+    telemetry_queue_t *queues; /*!< max_queues 项 */
+    uint8_t queue_count;
+
+    TaskStatus_t *status; /*!< uxTaskGetSystemState() 的工作区 */
+    TaskStatus_t *prev;   /*!< 上一次的结果，按任务序号找上一次的运行时间计数，与名字表无关 */
+    UBaseType_t prev_count; /*!< prev 的有效项数，0表示还没有快照 */
+    UBaseType_t status_len; /*!< status 和 prev 的项数 */
+
+    uint8_t *ring;      /*!< ring_depth 个定长槽 */
+    size_t slot_size;   /*!< 每个槽的字节数 */
+    uint16_t head;      /*!< 下一个写入的槽 */
+    uint16_t count;     /*!< 有效快照数 */
+    uint32_t seq;       /*!< 快照序号 */
+    uint32_t last_total; /*!< 上一次的总运行时间 */
+} telemetry_t;
+
+static telemetry_t *s_tm = NULL;
+
+/**
+ * @description: 根据任务序号找到（或分配）名字表中的编号
+ * @return       编号，表满时返回 TASK_TELEMETRY_ID_NONE
+ * @param {TaskStatus_t} *st 任务状态
+ */
+static uint8_t telemetry_name_id(const TaskStatus_t *st)
+{
+    int free_id = -1;
+    for (int i = 0; i < s_tm->config.max_tasks; i++)
+    {
+        telemetry_name_t *n = &s_tm->names[i];
+        if (n->used && n->task_number == st->xTaskNumber)
+        {
+            return i;
+        }
+        // 已经在整个环形缓冲区里都不再出现的任务，它的编号可以回收
+        bool stale = n->used && (s_tm->seq - n->last_seen) > s_tm->config.ring_depth;
+        if (free_id < 0 && (!n->used || stale))
+        {
+            free_id = i;
+        }
+    }
+    if (free_id < 0)
+    {
+        return TASK_TELEMETRY_ID_NONE;
+    }
+
+    telemetry_name_t *n = &s_tm->names[free_id];
+    strlcpy(n->name, st->pcTaskName, sizeof(n->name));
+    n->task_number = st->xTaskNumber;
+    n->used = true;
+    return free_id;
+}
+
+/**
+ * @description: 计算任务在本周期的运行时间
+ * @return       上一次快照中没有这个任务（刚创建或第一个快照）时返回 false
+ * @param {TaskStatus_t} *st 任务状态
+ * @param {uint32_t} *delta 输出，本周期的运行时间计数
+ */
+static bool telemetry_runtime_delta(const TaskStatus_t *st, uint32_t *delta)
+{
+    for (UBaseType_t i = 0; i < s_tm->prev_count; i++)
+    {
+        if (s_tm->prev[i].xTaskNumber == st->xTaskNumber)
+        {
+            *delta = st->ulRunTimeCounter - s_tm->prev[i].ulRunTimeCounter;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @description: 拍一个快照写入环形缓冲区，调用前需持有锁
+ */
+static void telemetry_take_snapshot(void)
+{
+    uint32_t total = 0;
+#if TELEMETRY_SUPPORTED
+    UBaseType_t n = uxTaskGetSystemState(s_tm->status, s_tm->status_len, &total);
+#else
+    UBaseType_t n = 0; // 不会执行到：init 失败时 s_tm 为 NULL
+#endif
+    if (n == 0)
+    {
+        // 工作区不够大（运行中又创建了任务），扩容后下个周期再采
+        UBaseType_t want = uxTaskGetNumberOfTasks() + 4;
+        TaskStatus_t *st = realloc(s_tm->status, want * sizeof(TaskStatus_t));
+        if (st)
+        {
+            s_tm->status = st;
+            st = realloc(s_tm->prev, want * sizeof(TaskStatus_t));
+        }
+        if (st)
+        {
+            s_tm->prev = st;
+            s_tm->status_len = want;
+        }
+        ESP_LOGW(TAG, "task status buffer grown to %u", (unsigned)s_tm->status_len);
+        return;
+    }
+
+    // 单核的C3上占比就是相对于整个CPU；双核芯片上是相对于单个核
+    uint32_t total_delta = total - s_tm->last_total;
+    s_tm->last_total = total;
+    s_tm->seq++;
+
+    uint8_t *slot = s_tm->ring + (size_t)s_tm->head * s_tm->slot_size;
+    task_telemetry_snapshot_t *snap = (task_telemetry_snapshot_t *)slot;
+    task_telemetry_task_t *rec = (task_telemetry_task_t *)(slot + sizeof(*snap));
+
+    // 没有上一次计数的任务（包括名字表满了没有编号的）占比记为未知，不能拿累计的运行时间当本周期的
+    bool first = s_tm->prev_count == 0;
+    uint32_t idle_delta = 0;
+    uint8_t task_count = 0;
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        const TaskStatus_t *st = &s_tm->status[i];
+        uint8_t id = telemetry_name_id(st);
+        if (id != TASK_TELEMETRY_ID_NONE)
+        {
+            s_tm->names[id].last_seen = s_tm->seq;
+        }
+        uint32_t delta = 0;
+        bool known = telemetry_runtime_delta(st, &delta);
+        if (known && strncmp(st->pcTaskName, "IDLE", 4) == 0)
+        {
+            idle_delta += delta;
+        }
+        if (task_count >= s_tm->config.max_tasks)
+        {
+            continue;
+        }
+
+        rec[task_count].id = id;
+        rec[task_count].priority = st->uxCurrentPriority;
+        rec[task_count].state = st->eCurrentState;
+        rec[task_count].stack_free = st->usStackHighWaterMark > 0xFFFF ? 0xFFFF : st->usStackHighWaterMark;
+        rec[task_count].cpu = !known ? TASK_TELEMETRY_CPU_UNKNOWN
+                              : total_delta ? (uint16_t)(((uint64_t)delta * 1000) / total_delta) : 0;
+        task_count++;
+    }
+
+    // 这次的结果留作下一次的“上一次”
+    TaskStatus_t *prev = s_tm->prev;
+    s_tm->prev = s_tm->status;
+    s_tm->prev_count = n;
+    s_tm->status = prev;
+
+    task_telemetry_queue_t *qrec = (task_telemetry_queue_t *)(rec + task_count);
+    for (uint8_t i = 0; i < s_tm->queue_count; i++)
+    {
+        UBaseType_t waiting = uxQueueMessagesWaiting(s_tm->queues[i].handle);
+        UBaseType_t spaces = uxQueueSpacesAvailable(s_tm->queues[i].handle);
+        qrec[i].id = i;
+        qrec[i].waiting = waiting > 0xFF ? 0xFF : waiting;
+        qrec[i].spaces = spaces > 0xFF ? 0xFF : spaces;
+    }
+
+    snap->timestamp_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    snap->heap_free = esp_get_free_heap_size();
+    snap->heap_min_free = esp_get_minimum_free_heap_size();
+    snap->cpu_idle = first ? TASK_TELEMETRY_CPU_UNKNOWN
+                           : total_delta ? (uint16_t)(((uint64_t)idle_delta * 1000) / total_delta) : 0;
+    snap->task_count = task_count;
+    snap->queue_count = s_tm->queue_count;
+
+    s_tm->head = (s_tm->head + 1) % s_tm->config.ring_depth;
+    if (s_tm->count < s_tm->config.ring_depth)
+    {
+        s_tm->count++;
+    }
+}
+
+/**
+ * @description: 取第 i 个快照（0为最旧的），调用前需持有锁
+ */
+static const task_telemetry_snapshot_t *telemetry_get(uint16_t i)
+{
+    uint16_t oldest = (s_tm->head + s_tm->config.ring_depth - s_tm->count) % s_tm->config.ring_depth;
+    uint16_t slot = (oldest + i) % s_tm->config.ring_depth;
+    return (const task_telemetry_snapshot_t *)(s_tm->ring + (size_t)slot * s_tm->slot_size);
+}
+
+static size_t telemetry_snapshot_size(const task_telemetry_snapshot_t *snap)
+{
+    return sizeof(*snap) + snap->task_count * sizeof(task_telemetry_task_t) + snap->queue_count * sizeof(task_telemetry_queue_t);
+}
+
+/**
+ * @description: 千分比格式化为 "xx.x%"，未知时为 "?"
+ * @return       buf
+ */
+static const char *telemetry_permille(uint16_t v, char *buf, size_t len)
+{
+    if (v == TASK_TELEMETRY_CPU_UNKNOWN)
+    {
+        strlcpy(buf, "    ?", len);
+    }
+    else
+    {
+        snprintf(buf, len, "%3u.%u%%", v / 10, v % 10);
+    }
+    return buf;
+}
+
+#if TELEMETRY_SUPPORTED
+static void telemetry_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(s_tm->config.period_ms));
+        xSemaphoreTake(s_tm->lock, portMAX_DELAY);
+        telemetry_take_snapshot();
+        xSemaphoreGive(s_tm->lock);
+    }
+}
+#endif
+
+esp_err_t task_telemetry_init(const task_telemetry_config_t *config)
+{
+#if !TELEMETRY_SUPPORTED
+    ESP_LOGE(TAG, "enable CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS");
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (s_tm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const task_telemetry_config_t def = TASK_TELEMETRY_DEFAULT_CONFIG();
+    if (!config)
+    {
+        config = &def;
+    }
+    if (config->ring_depth == 0 || config->max_tasks == 0 || config->max_tasks >= TASK_TELEMETRY_ID_NONE || config->period_ms == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_tm = calloc(1, sizeof(telemetry_t));
+    if (!s_tm)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    s_tm->config = *config;
+    s_tm->slot_size = sizeof(task_telemetry_snapshot_t) + config->max_tasks * sizeof(task_telemetry_task_t) + config->max_queues * sizeof(task_telemetry_queue_t);
+    s_tm->status_len = uxTaskGetNumberOfTasks() + 4;
+
+    s_tm->lock = xSemaphoreCreateMutex();
+    s_tm->names = calloc(config->max_tasks, sizeof(telemetry_name_t));
+    s_tm->queues = calloc(config->max_queues ? config->max_queues : 1, sizeof(telemetry_queue_t));
+    s_tm->status = malloc(s_tm->status_len * sizeof(TaskStatus_t));
+    s_tm->prev = malloc(s_tm->status_len * sizeof(TaskStatus_t));
+    s_tm->ring = malloc(s_tm->slot_size * config->ring_depth);
+    if (!s_tm->lock || !s_tm->names || !s_tm->queues || !s_tm->status || !s_tm->prev || !s_tm->ring)
+    {
+        goto err;
+    }
+
+    if (xTaskCreate(telemetry_task, "telemetry", config->task_stack, NULL, config->task_priority, &s_tm->task) != pdPASS)
+    {
+        goto err;
+    }
+    ESP_LOGI(TAG, "started: %u snapshots x %u bytes, every %u ms",
+             config->ring_depth, (unsigned)s_tm->slot_size, (unsigned)config->period_ms);
+    return ESP_OK;
+
+err:
+    if (s_tm->lock)
+    {
+        vSemaphoreDelete(s_tm->lock);
+    }
+    free(s_tm->names);
+    free(s_tm->queues);
+    free(s_tm->status);
+    free(s_tm->prev);
+    free(s_tm->ring);
+    free(s_tm);
+    s_tm = NULL;
+    return ESP_ERR_NO_MEM;
+#endif
+}
+
+esp_err_t task_telemetry_watch_queue(const char *name, QueueHandle_t queue)
+{
+    if (!s_tm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!queue)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    xSemaphoreTake(s_tm->lock, portMAX_DELAY);
+    if (s_tm->queue_count < s_tm->config.max_queues)
+    {
+        s_tm->queues[s_tm->queue_count].name = name;
+        s_tm->queues[s_tm->queue_count].handle = queue;
+        s_tm->queue_count++;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(s_tm->lock);
+    return ret;
+}
+
+esp_err_t task_telemetry_sample(void)
+{
+    if (!s_tm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_tm->lock, portMAX_DELAY);
+    telemetry_take_snapshot();
+    xSemaphoreGive(s_tm->lock);
+    return ESP_OK;
+}
+
+const char *task_telemetry_task_name(uint8_t id)
+{
+    if (!s_tm || id >= s_tm->config.max_tasks || !s_tm->names[id].used)
+    {
+        return "?";
+    }
+    return s_tm->names[id].name;
+}
+
+void task_telemetry_log_latest(void)
+{
+    if (!s_tm)
+    {
+        return;
+    }
+    xSemaphoreTake(s_tm->lock, portMAX_DELAY);
+    if (s_tm->count == 0)
+    {
+        xSemaphoreGive(s_tm->lock);
+        ESP_LOGI(TAG, "no snapshot yet");
+        return;
+    }
+    const task_telemetry_snapshot_t *snap = telemetry_get(s_tm->count - 1);
+    const task_telemetry_task_t *rec = (const task_telemetry_task_t *)(snap + 1);
+    const task_telemetry_queue_t *qrec = (const task_telemetry_queue_t *)(rec + snap->task_count);
+
+    char cpu[8];
+    ESP_LOGI(TAG, "t=%u ms heap=%u min=%u idle=%s",
+             snap->timestamp_ms, snap->heap_free, snap->heap_min_free, telemetry_permille(snap->cpu_idle, cpu, sizeof(cpu)));
+    for (int i = 0; i < snap->task_count; i++)
+    {
+        ESP_LOGI(TAG, "  %-16s prio=%2u stack_free=%5u cpu=%s",
+                 task_telemetry_task_name(rec[i].id), rec[i].priority, rec[i].stack_free,
+                 telemetry_permille(rec[i].cpu, cpu, sizeof(cpu)));
+    }
+    for (int i = 0; i < snap->queue_count; i++)
+    {
+        ESP_LOGI(TAG, "  queue %-10s waiting=%u spaces=%u",
+                 s_tm->queues[qrec[i].id].name, qrec[i].waiting, qrec[i].spaces);
+    }
+    xSemaphoreGive(s_tm->lock);
+}
+
+void task_telemetry_log_summary(void)
+{
+    if (!s_tm)
+    {
+        return;
+    }
+    xSemaphoreTake(s_tm->lock, portMAX_DELAY);
+    ESP_LOGI(TAG, "summary over %u snapshots, heap min free %u", s_tm->count, esp_get_minimum_free_heap_size());
+    for (uint8_t id = 0; id < s_tm->config.max_tasks; id++)
+    {
+        if (!s_tm->names[id].used)
+        {
+            continue;
+        }
+        uint16_t min_stack = 0xFFFF;
+        uint16_t max_cpu = 0;
+        uint32_t cpu_sum = 0;
+        uint16_t cpu_hits = 0; /*!< 占比已知的快照数 */
+        uint16_t hits = 0;
+        for (uint16_t i = 0; i < s_tm->count; i++)
+        {
+            const task_telemetry_snapshot_t *snap = telemetry_get(i);
+            const task_telemetry_task_t *rec = (const task_telemetry_task_t *)(snap + 1);
+            for (int t = 0; t < snap->task_count; t++)
+            {
+                if (rec[t].id != id)
+                {
+                    continue;
+                }
+                min_stack = rec[t].stack_free < min_stack ? rec[t].stack_free : min_stack;
+                if (rec[t].cpu != TASK_TELEMETRY_CPU_UNKNOWN)
+                {
+                    max_cpu = rec[t].cpu > max_cpu ? rec[t].cpu : max_cpu;
+                    cpu_sum += rec[t].cpu;
+                    cpu_hits++;
+                }
+                hits++;
+            }
+        }
+        if (hits)
+        {
+            char avg[8], max[8];
+            uint16_t avg_cpu = cpu_hits ? cpu_sum / cpu_hits : TASK_TELEMETRY_CPU_UNKNOWN;
+            ESP_LOGI(TAG, "  %-16s min stack_free=%5u cpu avg=%s max=%s",
+                     s_tm->names[id].name, min_stack, telemetry_permille(avg_cpu, avg, sizeof(avg)),
+                     telemetry_permille(cpu_hits ? max_cpu : TASK_TELEMETRY_CPU_UNKNOWN, max, sizeof(max)));
+        }
+    }
+    xSemaphoreGive(s_tm->lock);
+}
+
+esp_err_t task_telemetry_dump(task_telemetry_write_fn_t write, void *ctx)
+{
+    if (!s_tm || !write)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_tm->lock, portMAX_DELAY);
+
+    /*
+     * 格式：
+     *   u32 magic, u8 version, u8 名字数, u8 队列数, u16 快照数
+     *   名字数 x  { u8 id, u8 len, char name[len] }
+     *   队列数 x  { u8 len, char name[len] }
+     *   快照数 x  { u16 len, 快照(len字节) }
+     */
+    uint8_t names = 0;
+    for (uint8_t id = 0; id < s_tm->config.max_tasks; id++)
+    {
+        names += s_tm->names[id].used;
+    }
+    uint8_t hdr[9];
+    uint32_t magic = TASK_TELEMETRY_MAGIC;
+    memcpy(hdr, &magic, 4);
+    hdr[4] = TASK_TELEMETRY_VERSION;
+    hdr[5] = names;
+    hdr[6] = s_tm->queue_count;
+    memcpy(&hdr[7], &s_tm->count, 2);
+    if (write(ctx, hdr, sizeof(hdr)) != sizeof(hdr))
+    {
+        ret = ESP_FAIL;
+        goto out;
+    }
+
+    for (uint8_t id = 0; id < s_tm->config.max_tasks; id++)
+    {
+        if (!s_tm->names[id].used)
+        {
+            continue;
+        }
+        uint8_t rec[2 + configMAX_TASK_NAME_LEN];
+        rec[0] = id;
+        rec[1] = strnlen(s_tm->names[id].name, configMAX_TASK_NAME_LEN);
+        memcpy(&rec[2], s_tm->names[id].name, rec[1]);
+        if (write(ctx, rec, 2 + rec[1]) != 2 + rec[1])
+        {
+            ret = ESP_FAIL;
+            goto out;
+        }
+    }
+    for (uint8_t i = 0; i < s_tm->queue_count; i++)
+    {
+        uint8_t len = s_tm->queues[i].name ? strnlen(s_tm->queues[i].name, 0xFF) : 0;
+        if (write(ctx, &len, 1) != 1 || (len && write(ctx, s_tm->queues[i].name, len) != len))
+        {
+            ret = ESP_FAIL;
+            goto out;
+        }
+    }
+    for (uint16_t i = 0; i < s_tm->count; i++)
+    {
+        const task_telemetry_snapshot_t *snap = telemetry_get(i);
+        uint16_t len = telemetry_snapshot_size(snap);
+        if (write(ctx, &len, 2) != 2 || write(ctx, snap, len) != len)
+        {
+            ret = ESP_FAIL;
+            goto out;
+        }
+    }
+
+out:
+    xSemaphoreGive(s_tm->lock);
+    return ret;
+}
+
+static int telemetry_uart_write(void *ctx, const void *data, size_t len)
+{
+    return uart_write_bytes((uart_port_t)(intptr_t)ctx, data, len);
+}
+
+esp_err_t task_telemetry_dump_uart(uart_port_t port)
+{
+    return task_telemetry_dump(telemetry_uart_write, (void *)(intptr_t)port);
+}
@@ -12,6 +12,7 @@
 #include "esp_log.h"
 #include "led_strip.h"
 #include "sdkconfig.h"
+#include "task_telemetry.h"
 
 // 宏定义RGB-LED对应的GPIO口
 #define BLINK_GPIO_R 3
@@ -72,40 +73,25 @@ led_t led_rgb_init_b = {
 
 void app_main(void)
 {
-    // 任务句柄，本例用于得到任务的空闲堆栈空间大小
-    TaskHandle_t rgbTaskHandle_r;
-    TaskHandle_t rgbTaskHandle_g;
-    TaskHandle_t rgbTaskHandle_b;
-
-    // 用于接收Task得到空闲堆栈空间大小的返回值
-    UBaseType_t rbgTaski;
+    // 任务遥测：周期性记录所有任务的栈水位、CPU占用和堆剩余，代替手动轮询每个任务句柄
+    task_telemetry_config_t telemetry_config = TASK_TELEMETRY_DEFAULT_CONFIG();
+    ESP_ERROR_CHECK(task_telemetry_init(&telemetry_config));
 
     // 创建任务，传入之前定义的结构体参数
-    xTaskCreate(blink_led_Task, "LED_R", 2048, (void *)&led_rgb_init_r, 1, &rgbTaskHandle_r);
+    xTaskCreate(blink_led_Task, "LED_R", 2048, (void *)&led_rgb_init_r, 1, NULL);
 
-    xTaskCreate(blink_led_Task, "LED_G", 2048, (void *)&led_rgb_init_g, 1, &rgbTaskHandle_g);
+    xTaskCreate(blink_led_Task, "LED_G", 2048, (void *)&led_rgb_init_g, 1, NULL);
 
-    xTaskCreate(blink_led_Task, "LED_B", 2048, (void *)&led_rgb_init_b, 1, &rgbTaskHandle_b);
+    xTaskCreate(blink_led_Task, "LED_B", 2048, (void *)&led_rgb_init_b, 1, NULL);
 
     while (1)
     {
-        // 得到任务的空闲堆栈大小
-        // 返回值越趋近于0，说明剩余空间越小
-        // 如果返回值为0或者可能为负，即堆栈溢出，会导致系统重启
-        // 不确定的时候可以先设置为一个较大的值，然后调试再适当调整
-        rbgTaski = uxTaskGetStackHighWaterMark(rgbTaskHandle_r);
-        // 打印得到的堆栈空间的大小
-        printf("rbgTaski = %d\t", rbgTaski);
-
-        rbgTaski = uxTaskGetStackHighWaterMark(rgbTaskHandle_g);
-        printf("rbgTaski = %d\t", rbgTaski);
-
-        rbgTaski = uxTaskGetStackHighWaterMark(rgbTaskHandle_b);
-        printf("rbgTaski = %d\n", rbgTaski);
-
-        vTaskDelay(3000 / portTICK_PERIOD_MS);
+        vTaskDelay(30000 / portTICK_PERIOD_MS);
 
-        // 在笔者的平台下稳定运行时输出的实例：
-        // rbgTaski = 168  rbgTaski = 156  rbgTaski = 160
+        // 打印环形缓冲区内每个任务的最小栈余量（stack_free）和CPU占比
+        // stack_free 越趋近于0，说明剩余空间越小；为0即可能栈溢出，会导致系统重启
+        // 不确定的时候可以先设置为一个较大的值，运行一段时间后根据这里的结果再适当调整
+        // 需要原始数据时可调用 task_telemetry_dump_uart() 以二进制导出
+        task_telemetry_log_summary();
     }
 }
@@ -0,0 +1,71 @@
+#include "adc_reader.h"
+#include "esp_log.h"
+
+static const char *TAG = "adc_reader";
+
+/**
+ * @description: ADC校准初始化
+ * @return       eFuse 中有校准值时返回 true
+ */
+static bool adc_reader_calibration_init(adc_reader_t *reader)
+{
+    // 检查efuse
+    esp_err_t ret = esp_adc_cal_check_efuse(ADC_READER_CALI_SCHEME);
+    if (ret == ESP_ERR_NOT_SUPPORTED)
+    {
+        // 不支持校准方案，跳过软件校准
+        ESP_LOGW(TAG, "Calibration scheme not supported, skip software calibration");
+    }
+    else if (ret == ESP_ERR_INVALID_VERSION)
+    {
+        // eFuse没有烧写，跳过软件校准
+        ESP_LOGW(TAG, "eFuse not burnt, skip software calibration");
+    }
+    else if (ret == ESP_OK)
+    {
+        // 初始化存储ADC特性的结构体
+        esp_adc_cal_characterize(ADC_UNIT_1, reader->atten, ADC_WIDTH_BIT_DEFAULT, 0, &reader->chars);
+        return true;
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Invalid arg");
+    }
+    return false;
+}
+
+esp_err_t adc_reader_init(adc_reader_t *reader, adc1_channel_t channel, adc_atten_t atten)
+{
+    if (!reader)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *reader = (adc_reader_t){
+        .channel = channel,
+        .atten = atten,
+    };
+    reader->calibrated = adc_reader_calibration_init(reader);
+
+    // 配置ADC位宽（12位）和衰减
+    esp_err_t ret = adc1_config_width(ADC_WIDTH_BIT_DEFAULT);
+    if (ret == ESP_OK)
+    {
+        ret = adc1_config_channel_atten(channel, atten);
+    }
+    return ret;
+}
+
+esp_err_t adc_reader_read(const adc_reader_t *reader, int *raw, uint32_t *mv)
+{
+    int value = adc1_get_raw(reader->channel);
+    if (value < 0)
+    {
+        return ESP_FAIL;
+    }
+    *raw = value;
+    if (mv)
+    {
+        *mv = reader->calibrated ? esp_adc_cal_raw_to_voltage(value, &reader->chars) : 0;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,40 @@
+#ifndef __ADC_READER_H__
+#define __ADC_READER_H__
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/adc.h"
+#include "esp_adc_cal.h"
+
+/*
+ * ADC1 单个通道的读取和校准：eFuse 中有两点校准值（TP）时读数换算成电压，否则只有原始读数。
+ */
+
+// 校准方案
+#define ADC_READER_CALI_SCHEME ESP_ADC_CAL_VAL_EFUSE_TP
+
+typedef struct
+{
+    adc1_channel_t channel;
+    adc_atten_t atten;
+    bool calibrated;                      /*!< 有校准值，可以换算电压 */
+    esp_adc_cal_characteristics_t chars;  /*!< 校准得到的特性 */
+} adc_reader_t;
+
+/**
+ * @description: 检查 eFuse 中的校准值，配置位宽和通道的衰减
+ * @return       ESP_OK（没有校准值时也返回 ESP_OK，calibrated 为 false）/ ESP_ERR_INVALID_ARG
+ * @param {adc1_channel_t} channel
+ * @param {adc_atten_t} atten 衰减，用于增大测量范围
+ */
+esp_err_t adc_reader_init(adc_reader_t *reader, adc1_channel_t channel, adc_atten_t atten);
+
+/**
+ * @description: 读一次
+ * @return       ESP_OK / ESP_FAIL（读取失败）
+ * @param {int} *raw 原始读数
+ * @param {uint32_t} *mv 电压，没有校准值时为 0；可以为 NULL
+ */
+esp_err_t adc_reader_read(const adc_reader_t *reader, int *raw, uint32_t *mv);
+
+#endif /* __ADC_READER_H__ */
@@ -0,0 +1,136 @@
+#ifndef __SD_ASYNC_WRITER_H__
+#define __SD_ASYNC_WRITER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+/*
+ * 异步日志写入：生产者（传感器任务）把记录拷贝进N块大缓冲区中的当前块，
+ * 写满的块交给专门的写任务，以缓冲区大小（扇区整数倍）为单位、在对齐的文件偏移处写入。
+ * SD卡偶尔的长延时（擦除、垃圾回收）只会占用空闲缓冲区，不会阻塞生产者；
+ * 空闲缓冲区耗尽时生产者最多等待 timeout，超时则丢弃整条记录并计数。
+ */
+
+#define SD_WRITER_SECTOR_SIZE 512
+
+typedef struct sd_writer_sink_s sd_writer_sink_t;
+
+/**
+ * @brief 写任务的输出端
+ */
+struct sd_writer_sink_s
+{
+    /**
+     * @brief 在 offset 处写入 len 字节。offset 总是缓冲区大小的整数倍；
+     *        未写满的缓冲区会被提前写出（空闲和 flush 时，len 不是扇区的整数倍），之后写满时会在同一 offset 再写一次
+     */
+    esp_err_t (*write)(sd_writer_sink_t *sink, uint64_t offset, const void *buf, size_t len);
+    esp_err_t (*sync)(sd_writer_sink_t *sink);
+    esp_err_t (*del)(sd_writer_sink_t *sink); /*!< 关闭并释放 */
+};
+
+typedef enum
+{
+    SD_WRITER_FSYNC_NEVER,        /*!< 只在 sd_writer_flush() 和删除时 fsync */
+    SD_WRITER_FSYNC_EVERY_BUFFER, /*!< 每写完一块缓冲区 fsync */
+    SD_WRITER_FSYNC_EVERY_N,      /*!< 每写完 fsync_every 块缓冲区 fsync */
+    SD_WRITER_FSYNC_INTERVAL,     /*!< 距离上次 fsync 超过 fsync_interval_ms 后 fsync */
+} sd_writer_fsync_policy_t;
+
+typedef struct
+{
+    size_t buffer_size;        /*!< 每块缓冲区大小，必须是 SD_WRITER_SECTOR_SIZE 的整数倍 */
+    uint8_t buffer_count;      /*!< 缓冲区块数，至少2 */
+    sd_writer_fsync_policy_t fsync_policy;
+    uint32_t fsync_every;      /*!< SD_WRITER_FSYNC_EVERY_N 的 N */
+    uint32_t fsync_interval_ms; /*!< SD_WRITER_FSYNC_INTERVAL 的间隔 */
+    uint32_t idle_flush_ms;    /*!< 没有写满的块时，每隔这么久把当前块已有的数据写出，0表示不写 */
+    UBaseType_t task_priority;
+    uint32_t task_stack;
+} sd_writer_config_t;
+
+#define SD_WRITER_DEFAULT_CONFIG()                     \
+    {                                                  \
+        .buffer_size = 16 * 1024,                      \
+        .buffer_count = 2,                             \
+        .fsync_policy = SD_WRITER_FSYNC_INTERVAL,      \
+        .fsync_every = 0,                              \
+        .fsync_interval_ms = 1000,                     \
+        .idle_flush_ms = 1000,                         \
+        .task_priority = 5,                            \
+        .task_stack = 3072,                            \
+    }
+
+typedef struct
+{
+    uint32_t records;          /*!< 成功写入缓冲区的记录数 */
+    uint32_t records_dropped;  /*!< 因没有空闲缓冲区而丢弃的记录数 */
+    uint64_t bytes;
+    uint64_t bytes_dropped;
+    uint32_t buffers_written;  /*!< 写出的满缓冲区块数 */
+    uint32_t partial_writes;   /*!< 提前写出的未满缓冲区次数 */
+    uint32_t syncs;
+    uint32_t max_write_us;     /*!< 输出端单次 write 的最长耗时 */
+    uint32_t max_sync_us;      /*!< 输出端单次 sync 的最长耗时 */
+    uint32_t max_wait_us;      /*!< 生产者因背压等待的最长时间 */
+    uint8_t max_in_flight;     /*!< 同时等待写出的缓冲区最大块数 */
+    esp_err_t last_error;      /*!< 输出端最近一次错误 */
+} sd_writer_stats_t;
+
+typedef struct sd_writer_s *sd_writer_handle_t;
+
+/**
+ * @description: 创建写入器和写任务
+ * @return       句柄，参数错误或内存不足返回NULL
+ * @param {sd_writer_config_t} *config 配置
+ * @param {sd_writer_sink_t} *sink 输出端，删除写入器时一起释放
+ */
+sd_writer_handle_t sd_writer_create(const sd_writer_config_t *config, sd_writer_sink_t *sink);
+
+/**
+ * @description: 追加一条记录（拷贝），记录不会被拆开丢弃：要么整条写入，要么整条丢弃
+ * @return       ESP_OK / ESP_ERR_TIMEOUT（没有空闲缓冲区，已丢弃）/ ESP_ERR_INVALID_SIZE（记录比缓冲区大）
+ * @param {sd_writer_handle_t} writer 句柄
+ * @param {void} *data 记录
+ * @param {size_t} len 记录长度
+ * @param {TickType_t} timeout 最长等待时间，传0表示从不阻塞
+ */
+esp_err_t sd_writer_append(sd_writer_handle_t writer, const void *data, size_t len, TickType_t timeout);
+
+/**
+ * @description: 把目前为止追加的所有数据写出并 fsync，返回时数据已落盘
+ * @return       ESP_OK / ESP_ERR_TIMEOUT / 输出端的错误
+ * @param {sd_writer_handle_t} writer 句柄
+ * @param {TickType_t} timeout 最长等待时间
+ */
+esp_err_t sd_writer_flush(sd_writer_handle_t writer, TickType_t timeout);
+
+/**
+ * @description: 读取统计信息
+ */
+void sd_writer_get_stats(sd_writer_handle_t writer, sd_writer_stats_t *stats);
+
+/**
+ * @description: 写出剩余数据，停止写任务，释放缓冲区和输出端
+ * @return       最后一次 flush 的结果
+ */
+esp_err_t sd_writer_delete(sd_writer_handle_t writer);
+
+// 文件输出端的配置，latency_us/stall_* 用于模拟SD卡的写延时，测试背压和丢弃
+typedef struct
+{
+    const char *path;
+    uint32_t latency_us; /*!< 每次写附加的固定延时 */
+    uint32_t stall_every; /*!< 每 stall_every 次写注入一次长延时，0表示不注入 */
+    uint32_t stall_us;   /*!< 长延时 */
+} sd_writer_file_config_t;
+
+/**
+ * @description: 基于 POSIX 文件接口的输出端，ESP32上通过VFS写FAT，PC上写普通文件
+ * @return       输出端，打开文件失败返回NULL
+ */
+sd_writer_sink_t *sd_writer_sink_new_file(const sd_writer_file_config_t *config);
+
+#endif /* __SD_ASYNC_WRITER_H__ */
@@ -0,0 +1,512 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "sd_async_writer.h"
+
+static const char *TAG = "sd_writer";
+
+// 写任务的工作队列消息
+typedef enum
+{
+    WRITER_MSG_FULL,    /*!< 写满的缓冲区，写出后归还空闲队列 */
+    WRITER_MSG_PARTIAL, /*!< 未满的当前缓冲区，写出已有部分后 fsync，用于 flush */
+    WRITER_MSG_STOP,    /*!< 停止写任务 */
+} writer_msg_kind_t;
+
+typedef struct
+{
+    uint8_t kind;
+    uint8_t index;   /*!< 缓冲区编号 */
+    uint32_t len;    /*!< 要写出的字节数 */
+    uint32_t seq;    /*!< PARTIAL 的序号，完成后写入 done_seq */
+    uint64_t offset; /*!< 文件偏移 */
+} writer_msg_t;
+
+struct sd_writer_s
+{
+    sd_writer_config_t config;
+    sd_writer_sink_t *sink;
+    uint8_t **buffers;
+
+    QueueHandle_t free_queue; /*!< 空闲缓冲区编号 */
+    QueueHandle_t work_queue; /*!< writer_msg_t */
+    SemaphoreHandle_t lock;   /*!< 保护生产者一侧的状态 */
+    SemaphoreHandle_t flush_lock;
+    SemaphoreHandle_t done;   /*!< 写任务处理完 PARTIAL 后释放 */
+    SemaphoreHandle_t stopped; /*!< 写任务处理完 STOP 后释放 */
+    TaskHandle_t task;
+    uint32_t flush_seq;       /*!< 最近一次 flush 的序号，持有 flush_lock 时访问 */
+    volatile uint32_t done_seq; /*!< 写任务最近完成的 PARTIAL 的序号 */
+    esp_err_t flush_result;
+
+    // 生产者一侧，持有 lock 时访问
+    uint8_t current;     /*!< 当前正在填充的缓冲区 */
+    size_t used;         /*!< 当前缓冲区已用字节 */
+    uint64_t offset;     /*!< 当前缓冲区对应的文件偏移 */
+
+    // 写任务一侧
+    uint32_t unsynced;   /*!< 上次 fsync 以后写出的缓冲区块数 */
+    int64_t last_sync_us;
+    size_t idle_written; /*!< 空闲时已提前写出的当前缓冲区字节数 */
+    uint64_t idle_offset;
+
+    portMUX_TYPE stats_lock;
+    sd_writer_stats_t stats;
+};
+
+static uint32_t writer_elapsed_us(int64_t start)
+{
+    int64_t d = esp_timer_get_time() - start;
+    return d > UINT32_MAX ? UINT32_MAX : (uint32_t)d;
+}
+
+static void writer_record_error(sd_writer_handle_t w, esp_err_t err)
+{
+    if (err != ESP_OK)
+    {
+        portENTER_CRITICAL(&w->stats_lock);
+        w->stats.last_error = err;
+        portEXIT_CRITICAL(&w->stats_lock);
+        ESP_LOGE(TAG, "sink error 0x%x", err);
+    }
+}
+
+static esp_err_t writer_sink_write(sd_writer_handle_t w, uint64_t offset, const void *buf, size_t len)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = w->sink->write(w->sink, offset, buf, len);
+    uint32_t us = writer_elapsed_us(start);
+    portENTER_CRITICAL(&w->stats_lock);
+    if (us > w->stats.max_write_us)
+    {
+        w->stats.max_write_us = us;
+    }
+    portEXIT_CRITICAL(&w->stats_lock);
+    writer_record_error(w, ret);
+    return ret;
+}
+
+static esp_err_t writer_sink_sync(sd_writer_handle_t w)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = w->sink->sync(w->sink);
+    uint32_t us = writer_elapsed_us(start);
+    w->unsynced = 0;
+    w->last_sync_us = esp_timer_get_time();
+    portENTER_CRITICAL(&w->stats_lock);
+    w->stats.syncs++;
+    if (us > w->stats.max_sync_us)
+    {
+        w->stats.max_sync_us = us;
+    }
+    portEXIT_CRITICAL(&w->stats_lock);
+    writer_record_error(w, ret);
+    return ret;
+}
+
+// 按 fsync 策略判断是否需要同步
+static bool writer_sync_due(sd_writer_handle_t w)
+{
+    if (w->unsynced == 0)
+    {
+        return false;
+    }
+    switch (w->config.fsync_policy)
+    {
+    case SD_WRITER_FSYNC_EVERY_BUFFER:
+        return true;
+    case SD_WRITER_FSYNC_EVERY_N:
+        return w->unsynced >= w->config.fsync_every;
+    case SD_WRITER_FSYNC_INTERVAL:
+        return esp_timer_get_time() - w->last_sync_us >= (int64_t)w->config.fsync_interval_ms * 1000;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @description: 空闲时把当前缓冲区新增的数据提前写出，限制掉电时丢失的数据量。
+ *               偏移是对齐的，长度是已有的字节数，不补齐到扇区（补齐会在文件末尾留下填充）；
+ *               写满后在同一偏移整块重写，稳定状态下的写仍是扇区对齐的
+ *               生产者只会在 used 之后追加，写任务读 [0, used) 不会冲突；
+ *               这块缓冲区在写任务把它作为 FULL 写出之前不会被复用
+ */
+static void writer_idle_flush(sd_writer_handle_t w)
+{
+    if (xSemaphoreTake(w->lock, 0) != pdTRUE)
+    {
+        return;
+    }
+    uint8_t index = w->current;
+    size_t used = w->used;
+    uint64_t offset = w->offset;
+    xSemaphoreGive(w->lock);
+
+    if (used == 0 || (offset == w->idle_offset && used == w->idle_written))
+    {
+        return;
+    }
+    if (writer_sink_write(w, offset, w->buffers[index], used) == ESP_OK)
+    {
+        w->idle_offset = offset;
+        w->idle_written = used;
+        w->unsynced++;
+        portENTER_CRITICAL(&w->stats_lock);
+        w->stats.partial_writes++;
+        portEXIT_CRITICAL(&w->stats_lock);
+    }
+}
+
+static void writer_task(void *arg)
+{
+    sd_writer_handle_t w = (sd_writer_handle_t)arg;
+    uint32_t wait_ms = 0;
+    if (w->config.idle_flush_ms)
+    {
+        wait_ms = w->config.idle_flush_ms;
+    }
+    if (w->config.fsync_policy == SD_WRITER_FSYNC_INTERVAL && (wait_ms == 0 || w->config.fsync_interval_ms < wait_ms))
+    {
+        wait_ms = w->config.fsync_interval_ms;
+    }
+    const TickType_t wait = wait_ms ? pdMS_TO_TICKS(wait_ms) : portMAX_DELAY;
+
+    writer_msg_t msg;
+    while (1)
+    {
+        if (xQueueReceive(w->work_queue, &msg, wait) != pdTRUE)
+        {
+            if (w->config.idle_flush_ms)
+            {
+                writer_idle_flush(w);
+            }
+            if (writer_sync_due(w))
+            {
+                writer_sink_sync(w);
+            }
+            continue;
+        }
+
+        if (msg.kind == WRITER_MSG_FULL)
+        {
+            writer_sink_write(w, msg.offset, w->buffers[msg.index], msg.len);
+            w->unsynced++;
+            xQueueSend(w->free_queue, &msg.index, portMAX_DELAY);
+            portENTER_CRITICAL(&w->stats_lock);
+            w->stats.buffers_written++;
+            portEXIT_CRITICAL(&w->stats_lock);
+            if (writer_sync_due(w))
+            {
+                writer_sink_sync(w);
+            }
+        }
+        else if (msg.kind == WRITER_MSG_PARTIAL)
+        {
+            esp_err_t ret = ESP_OK;
+            if (msg.len)
+            {
+                ret = writer_sink_write(w, msg.offset, w->buffers[msg.index], msg.len);
+                w->idle_offset = msg.offset;
+                w->idle_written = msg.len;
+                portENTER_CRITICAL(&w->stats_lock);
+                w->stats.partial_writes++;
+                portEXIT_CRITICAL(&w->stats_lock);
+            }
+            esp_err_t sync_ret = writer_sink_sync(w);
+            w->flush_result = ret != ESP_OK ? ret : sync_ret;
+            w->done_seq = msg.seq;
+            xSemaphoreGive(w->done);
+        }
+        else
+        {
+            xSemaphoreGive(w->stopped);
+            vTaskDelete(NULL);
+        }
+    }
+}
+
+/**
+ * @description: 当前缓冲区交给写任务，换一块空闲缓冲区，调用前需持有 lock
+ */
+static void writer_hand_off(sd_writer_handle_t w, uint8_t next)
+{
+    writer_msg_t msg = {
+        .kind = WRITER_MSG_FULL,
+        .index = w->current,
+        .len = w->config.buffer_size,
+        .offset = w->offset,
+    };
+    // 队列中最多 buffer_count - 1 个 FULL、一个 PARTIAL（见 sd_writer_flush）和 STOP，不会满
+    xQueueSend(w->work_queue, &msg, portMAX_DELAY);
+    w->current = next;
+    w->offset += w->config.buffer_size;
+    w->used = 0;
+
+    uint8_t in_flight = w->config.buffer_count - 1 - uxQueueMessagesWaiting(w->free_queue);
+    portENTER_CRITICAL(&w->stats_lock);
+    if (in_flight > w->stats.max_in_flight)
+    {
+        w->stats.max_in_flight = in_flight;
+    }
+    portEXIT_CRITICAL(&w->stats_lock);
+}
+
+static void writer_count_drop(sd_writer_handle_t w, size_t len)
+{
+    portENTER_CRITICAL(&w->stats_lock);
+    w->stats.records_dropped++;
+    w->stats.bytes_dropped += len;
+    portEXIT_CRITICAL(&w->stats_lock);
+}
+
+esp_err_t sd_writer_append(sd_writer_handle_t w, const void *data, size_t len, TickType_t timeout)
+{
+    if (!w || (!data && len))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (len > w->config.buffer_size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    int64_t start = esp_timer_get_time();
+    if (xSemaphoreTake(w->lock, timeout) != pdTRUE)
+    {
+        writer_count_drop(w, len);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    const uint8_t *src = data;
+    size_t room = w->config.buffer_size - w->used;
+    if (len > room)
+    {
+        // 先拿到下一块缓冲区再开始拷贝，拿不到就整条丢弃，不会留下半条记录
+        uint8_t next;
+        if (xQueueReceive(w->free_queue, &next, timeout) != pdTRUE)
+        {
+            xSemaphoreGive(w->lock);
+            writer_count_drop(w, len);
+            return ESP_ERR_TIMEOUT;
+        }
+        memcpy(w->buffers[w->current] + w->used, src, room);
+        w->used += room;
+        writer_hand_off(w, next);
+        src += room;
+        len -= room;
+    }
+    memcpy(w->buffers[w->current] + w->used, src, len);
+    w->used += len;
+
+    // 刚好写满时，有空闲缓冲区就立即交出去，否则留到下一次追加
+    if (w->used == w->config.buffer_size)
+    {
+        uint8_t next;
+        if (xQueueReceive(w->free_queue, &next, 0) == pdTRUE)
+        {
+            writer_hand_off(w, next);
+        }
+    }
+    xSemaphoreGive(w->lock);
+
+    uint32_t waited = writer_elapsed_us(start);
+    portENTER_CRITICAL(&w->stats_lock);
+    w->stats.records++;
+    w->stats.bytes += (const uint8_t *)src - (const uint8_t *)data + len;
+    if (waited > w->stats.max_wait_us)
+    {
+        w->stats.max_wait_us = waited;
+    }
+    portEXIT_CRITICAL(&w->stats_lock);
+    return ESP_OK;
+}
+
+/**
+ * @description: 等写任务完成序号为 seq 的 PARTIAL，调用前持有 flush_lock。
+ *               之前超时返回的 flush 完成时也会释放 done，按序号跳过
+ * @return       true 已完成，false 超时
+ */
+static bool writer_wait_done(sd_writer_handle_t w, uint32_t seq, TickType_t start, TickType_t timeout)
+{
+    while (w->done_seq != seq)
+    {
+        TickType_t left = timeout;
+        if (timeout != portMAX_DELAY)
+        {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= timeout)
+            {
+                return false;
+            }
+            left = timeout - elapsed;
+        }
+        if (xSemaphoreTake(w->done, left) != pdTRUE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t sd_writer_flush(sd_writer_handle_t w, TickType_t timeout)
+{
+    if (!w)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    TickType_t start = xTaskGetTickCount();
+    if (xSemaphoreTake(w->flush_lock, timeout) != pdTRUE)
+    {
+        return ESP_ERR_TIMEOUT;
+    }
+    // 上一次超时返回的 PARTIAL 还没写出时先等它，工作队列中最多一个 PARTIAL，
+    // 卡停顿时反复超时的 flush 不会把队列填满、让 append 在 lock 中阻塞
+    if (!writer_wait_done(w, w->flush_seq, start, timeout))
+    {
+        xSemaphoreGive(w->flush_lock);
+        return ESP_ERR_TIMEOUT;
+    }
+    if (xSemaphoreTake(w->lock, timeout) != pdTRUE)
+    {
+        xSemaphoreGive(w->flush_lock);
+        return ESP_ERR_TIMEOUT;
+    }
+    writer_msg_t msg = {
+        .kind = WRITER_MSG_PARTIAL,
+        .index = w->current,
+        .len = w->used,
+        .seq = ++w->flush_seq,
+        .offset = w->offset,
+    };
+    xQueueSend(w->work_queue, &msg, portMAX_DELAY);
+    xSemaphoreGive(w->lock);
+
+    esp_err_t ret = writer_wait_done(w, msg.seq, start, timeout) ? w->flush_result : ESP_ERR_TIMEOUT;
+    xSemaphoreGive(w->flush_lock);
+    return ret;
+}
+
+void sd_writer_get_stats(sd_writer_handle_t w, sd_writer_stats_t *stats)
+{
+    portENTER_CRITICAL(&w->stats_lock);
+    *stats = w->stats;
+    portEXIT_CRITICAL(&w->stats_lock);
+}
+
+static void writer_free(sd_writer_handle_t w)
+{
+    if (w->buffers)
+    {
+        for (int i = 0; i < w->config.buffer_count; i++)
+        {
+            heap_caps_free(w->buffers[i]);
+        }
+        free(w->buffers);
+    }
+    if (w->free_queue)
+    {
+        vQueueDelete(w->free_queue);
+    }
+    if (w->work_queue)
+    {
+        vQueueDelete(w->work_queue);
+    }
+    if (w->lock)
+    {
+        vSemaphoreDelete(w->lock);
+    }
+    if (w->flush_lock)
+    {
+        vSemaphoreDelete(w->flush_lock);
+    }
+    if (w->done)
+    {
+        vSemaphoreDelete(w->done);
+    }
+    if (w->stopped)
+    {
+        vSemaphoreDelete(w->stopped);
+    }
+    free(w);
+}
+
+sd_writer_handle_t sd_writer_create(const sd_writer_config_t *config, sd_writer_sink_t *sink)
+{
+    if (!config || !sink || config->buffer_count < 2 || config->buffer_size == 0 ||
+        config->buffer_size % SD_WRITER_SECTOR_SIZE != 0 ||
+        (config->fsync_policy == SD_WRITER_FSYNC_EVERY_N && config->fsync_every == 0))
+    {
+        return NULL;
+    }
+    sd_writer_handle_t w = calloc(1, sizeof(struct sd_writer_s));
+    if (!w)
+    {
+        return NULL;
+    }
+    w->config = *config;
+    w->sink = sink;
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    w->stats_lock = mux;
+    w->last_sync_us = esp_timer_get_time();
+
+    w->buffers = calloc(config->buffer_count, sizeof(uint8_t *));
+    w->free_queue = xQueueCreate(config->buffer_count, sizeof(uint8_t));
+    w->work_queue = xQueueCreate(config->buffer_count + 2, sizeof(writer_msg_t));
+    w->lock = xSemaphoreCreateMutex();
+    w->flush_lock = xSemaphoreCreateMutex();
+    w->done = xSemaphoreCreateBinary();
+    w->stopped = xSemaphoreCreateBinary();
+    if (!w->buffers || !w->free_queue || !w->work_queue || !w->lock || !w->flush_lock || !w->done || !w->stopped)
+    {
+        goto err;
+    }
+    // 可DMA的对齐缓冲区，SDMMC驱动可以直接从这里多扇区写，不经过中转
+    for (uint8_t i = 0; i < config->buffer_count; i++)
+    {
+        w->buffers[i] = heap_caps_aligned_alloc(4, config->buffer_size, MALLOC_CAP_DMA);
+        if (!w->buffers[i])
+        {
+            ESP_LOGE(TAG, "no memory for %u x %u byte buffers", config->buffer_count, (unsigned)config->buffer_size);
+            goto err;
+        }
+        if (i > 0)
+        {
+            xQueueSend(w->free_queue, &i, 0);
+        }
+    }
+    w->current = 0;
+
+    if (xTaskCreate(writer_task, "sd_writer", config->task_stack, w, config->task_priority, &w->task) != pdPASS)
+    {
+        goto err;
+    }
+    return w;
+
+err:
+    writer_free(w);
+    return NULL;
+}
+
+esp_err_t sd_writer_delete(sd_writer_handle_t w)
+{
+    if (!w)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 工作队列按顺序处理，这次 flush 完成时之前的消息都已处理完
+    esp_err_t ret = sd_writer_flush(w, portMAX_DELAY);
+
+    writer_msg_t msg = {.kind = WRITER_MSG_STOP};
+    xQueueSend(w->work_queue, &msg, portMAX_DELAY);
+    xSemaphoreTake(w->stopped, portMAX_DELAY);
+
+    w->sink->del(w->sink);
+    writer_free(w);
+    return ret;
+}
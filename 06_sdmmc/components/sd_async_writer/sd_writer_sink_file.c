@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "sd_async_writer.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+static const char *TAG = "sd_writer_file";
+
+typedef struct
+{
+    sd_writer_sink_t parent;
+    int fd;
+    uint64_t position; /*!< 当前文件位置，顺序写时省掉 lseek */
+    uint32_t writes;
+    sd_writer_file_config_t config;
+} sink_file_t;
+
+static esp_err_t sink_file_write(sd_writer_sink_t *sink, uint64_t offset, const void *buf, size_t len)
+{
+    sink_file_t *f = __containerof(sink, sink_file_t, parent);
+
+    // 模拟SD卡的写延时
+    f->writes++;
+    uint32_t delay_us = f->config.latency_us;
+    if (f->config.stall_every && f->writes % f->config.stall_every == 0)
+    {
+        delay_us += f->config.stall_us;
+    }
+    if (delay_us)
+    {
+        usleep(delay_us);
+    }
+
+    if (offset != f->position && lseek(f->fd, (off_t)offset, SEEK_SET) < 0)
+    {
+        return ESP_FAIL;
+    }
+    const uint8_t *p = buf;
+    size_t left = len;
+    while (left)
+    {
+        ssize_t n = write(f->fd, p, left);
+        if (n <= 0)
+        {
+            f->position = UINT64_MAX;
+            return ESP_FAIL;
+        }
+        p += n;
+        left -= n;
+    }
+    f->position = offset + len;
+    return ESP_OK;
+}
+
+static esp_err_t sink_file_sync(sd_writer_sink_t *sink)
+{
+    sink_file_t *f = __containerof(sink, sink_file_t, parent);
+    return fsync(f->fd) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t sink_file_del(sd_writer_sink_t *sink)
+{
+    sink_file_t *f = __containerof(sink, sink_file_t, parent);
+    int ret = close(f->fd);
+    free(f);
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+sd_writer_sink_t *sd_writer_sink_new_file(const sd_writer_file_config_t *config)
+{
+    if (!config || !config->path)
+    {
+        return NULL;
+    }
+    sink_file_t *f = calloc(1, sizeof(sink_file_t));
+    if (!f)
+    {
+        return NULL;
+    }
+    f->fd = open(config->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (f->fd < 0)
+    {
+        ESP_LOGE(TAG, "failed to open %s", config->path);
+        free(f);
+        return NULL;
+    }
+    f->config = *config;
+    f->parent.write = sink_file_write;
+    f->parent.sync = sink_file_sync;
+    f->parent.del = sink_file_del;
+    return &f->parent;
+}
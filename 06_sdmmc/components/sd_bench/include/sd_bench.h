@@ -0,0 +1,131 @@
+#ifndef __SD_BENCH_H__
+#define __SD_BENCH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/*
+ * SD卡吞吐量测试：按块大小（512B~64KiB）、顺序/随机访问、缓冲/同步IO、是否预分配文件
+ * 的所有组合依次测试，给出 MB/s、单次操作延迟的分位数和CPU占用。
+ *
+ * 测试本身不依赖ESP-IDF，文件操作通过 sd_bench_io_t 完成，
+ * 在PC上用同一份代码对普通文件（或者块设备文件）做测试，见 host/ 目录。
+ */
+
+// 访问方式，可按位组合
+#define SD_BENCH_ACCESS_SEQ (1 << 0)    /*!< 顺序读写 */
+#define SD_BENCH_ACCESS_RANDOM (1 << 1) /*!< 按块对齐的随机读写 */
+
+// IO方式，可按位组合
+#define SD_BENCH_IO_BUFFERED (1 << 0) /*!< C标准库 FILE* 缓冲读写 */
+#define SD_BENCH_IO_SYNC (1 << 1)     /*!< POSIX read/write，每次写后 fsync */
+
+// 预分配，可按位组合
+#define SD_BENCH_PREALLOC_OFF (1 << 0) /*!< 边写边分配簇 */
+#define SD_BENCH_PREALLOC_ON (1 << 1)  /*!< 写之前先把文件扩展到测试大小 */
+
+#define SD_BENCH_CPU_UNKNOWN 0xFFFF // 平台不支持统计CPU占用
+
+typedef struct sd_bench_io_s sd_bench_io_t;
+
+/**
+ * @brief 测试用的文件操作接口，返回 esp_err_t 的函数成功时返回 ESP_OK
+ */
+struct sd_bench_io_s
+{
+    esp_err_t (*open)(sd_bench_io_t *io, const char *path, bool write, bool buffered, size_t chunk);
+    int (*write)(sd_bench_io_t *io, const void *buf, size_t len); /*!< 返回写入字节数，出错返回负数 */
+    int (*read)(sd_bench_io_t *io, void *buf, size_t len);        /*!< 返回读出字节数，出错返回负数 */
+    esp_err_t (*seek)(sd_bench_io_t *io, uint64_t offset);
+    esp_err_t (*sync)(sd_bench_io_t *io);
+    esp_err_t (*preallocate)(sd_bench_io_t *io, uint64_t size); /*!< 在打开（写）的文件上扩展到 size */
+    esp_err_t (*close)(sd_bench_io_t *io);
+    esp_err_t (*remove)(sd_bench_io_t *io, const char *path);
+    /**
+     * @brief 到目前为止CPU的忙碌时间（微秒），不支持时为NULL
+     */
+    uint64_t (*cpu_busy_us)(sd_bench_io_t *io);
+    esp_err_t (*del)(sd_bench_io_t *io);
+};
+
+typedef struct
+{
+    const char *path;        /*!< 测试文件路径 */
+    uint64_t file_size;      /*!< 每组测试读写的总字节数 */
+    uint32_t min_chunk;      /*!< 最小块大小，按2倍递增到 max_chunk */
+    uint32_t max_chunk;      /*!< 最大块大小 */
+    uint8_t access;          /*!< SD_BENCH_ACCESS_* */
+    uint8_t io;              /*!< SD_BENCH_IO_* */
+    uint8_t prealloc;        /*!< SD_BENCH_PREALLOC_* */
+    uint32_t random_ops;     /*!< 随机访问每组的操作次数，0表示与顺序相同（file_size/chunk） */
+    uint32_t latency_samples; /*!< 每组保留的延迟样本数（蓄水池抽样），决定分位数精度和内存占用 */
+    uint32_t seed;           /*!< 随机访问的种子 */
+    bool verify;             /*!< 读回时校验数据 */
+} sd_bench_config_t;
+
+#define SD_BENCH_DEFAULT_CONFIG(file_path)                                  \
+    {                                                                       \
+        .path = file_path,                                                  \
+        .file_size = 4 * 1024 * 1024,                                       \
+        .min_chunk = 512,                                                   \
+        .max_chunk = 64 * 1024,                                             \
+        .access = SD_BENCH_ACCESS_SEQ | SD_BENCH_ACCESS_RANDOM,             \
+        .io = SD_BENCH_IO_BUFFERED | SD_BENCH_IO_SYNC,                      \
+        .prealloc = SD_BENCH_PREALLOC_OFF | SD_BENCH_PREALLOC_ON,           \
+        .random_ops = 256,                                                  \
+        .latency_samples = 1024,                                            \
+        .seed = 0x5D5D1234,                                                 \
+        .verify = true,                                                     \
+    }
+
+// 一组测试的结果
+typedef struct
+{
+    uint32_t chunk;
+    uint8_t access;   /*!< 单个 SD_BENCH_ACCESS_* */
+    uint8_t io;       /*!< 单个 SD_BENCH_IO_* */
+    uint8_t prealloc; /*!< 单个 SD_BENCH_PREALLOC_* */
+    bool write;
+    esp_err_t err;   /*!< 出错时后面的数据无效 */
+    uint32_t ops;
+    uint64_t bytes;
+    uint64_t elapsed_us;
+    float mb_per_s;   /*!< 1MB = 1000000 字节 */
+    uint32_t lat_p50_us;
+    uint32_t lat_p90_us;
+    uint32_t lat_p99_us;
+    uint32_t lat_max_us;
+    uint16_t cpu;     /*!< CPU占用，千分比，或 SD_BENCH_CPU_UNKNOWN */
+} sd_bench_result_t;
+
+typedef void (*sd_bench_report_cb_t)(const sd_bench_result_t *result, void *ctx);
+
+/**
+ * @description: 按配置跑完所有组合，每组（写、读各一组）的结果通过回调给出
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG / ESP_ERR_NO_MEM；单组失败记录在结果的 err 中，不中断测试
+ * @param {sd_bench_io_t} *io 文件操作接口
+ * @param {sd_bench_config_t} *config 配置
+ * @param {sd_bench_report_cb_t} cb 结果回调，可以为NULL
+ * @param {void} *ctx 回调参数
+ */
+esp_err_t sd_bench_run(sd_bench_io_t *io, const sd_bench_config_t *config, sd_bench_report_cb_t cb, void *ctx);
+
+/**
+ * @description: 打印结果表头
+ */
+void sd_bench_print_header(void);
+
+/**
+ * @description: 以表格的一行打印结果，可直接作为 sd_bench_run() 的回调
+ */
+void sd_bench_print_result(const sd_bench_result_t *result, void *ctx);
+
+/**
+ * @description: 基于 POSIX/C 标准库文件接口的实现，在ESP32上通过VFS访问FAT，在PC上访问普通文件
+ * @return       接口实例，失败返回NULL，用完调用 io->del(io)
+ */
+sd_bench_io_t *sd_bench_io_new_posix(void);
+
+#endif /* __SD_BENCH_H__ */
@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sd_bench.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+// 延迟样本，蓄水池抽样，保证任意操作次数下内存固定
+typedef struct
+{
+    uint32_t *samples;
+    uint32_t capacity;
+    uint32_t count; /*!< 已保存的样本数 */
+    uint32_t seen;  /*!< 已观察到的操作数 */
+    uint32_t max;
+} bench_latency_t;
+
+static uint64_t bench_now_us(void)
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+// xorshift32，随机偏移和蓄水池抽样用
+static uint32_t bench_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void bench_latency_add(bench_latency_t *lat, uint32_t us, uint32_t *rng)
+{
+    lat->seen++;
+    if (us > lat->max)
+    {
+        lat->max = us;
+    }
+    if (lat->count < lat->capacity)
+    {
+        lat->samples[lat->count++] = us;
+        return;
+    }
+    uint32_t j = bench_rand(rng) % lat->seen;
+    if (j < lat->capacity)
+    {
+        lat->samples[j] = us;
+    }
+}
+
+static int bench_cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// 样本排序后取分位数，permille 为千分位
+static uint32_t bench_percentile(const bench_latency_t *lat, uint32_t permille)
+{
+    if (lat->count == 0)
+    {
+        return 0;
+    }
+    uint32_t idx = (uint32_t)(((uint64_t)lat->count * permille) / 1000);
+    if (idx >= lat->count)
+    {
+        idx = lat->count - 1;
+    }
+    return lat->samples[idx];
+}
+
+// 每个块的前8字节写入块在文件中的偏移，读回时用来校验
+static void bench_stamp(uint8_t *buf, uint64_t offset)
+{
+    memcpy(buf, &offset, sizeof(offset));
+}
+
+static bool bench_check(const uint8_t *buf, uint64_t offset)
+{
+    return memcmp(buf, &offset, sizeof(offset)) == 0;
+}
+
+/**
+ * @description: 跑一组测试（写或读）
+ * @return       结果中的 err
+ */
+static esp_err_t bench_pass(sd_bench_io_t *io, const sd_bench_config_t *cfg, sd_bench_result_t *r,
+                            uint8_t *buf, bench_latency_t *lat)
+{
+    const uint64_t blocks = cfg->file_size / r->chunk;
+    const bool random = r->access == SD_BENCH_ACCESS_RANDOM;
+    const bool buffered = r->io == SD_BENCH_IO_BUFFERED;
+    uint32_t ops = blocks;
+    if (random && cfg->random_ops)
+    {
+        ops = cfg->random_ops;
+    }
+    uint32_t rng = cfg->seed ^ r->chunk;
+    uint32_t lat_rng = cfg->seed;
+
+    lat->count = 0;
+    lat->seen = 0;
+    lat->max = 0;
+
+    esp_err_t ret = io->open(io, cfg->path, r->write, buffered, r->chunk);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    // 预分配和随机写的"先铺满文件"都不计入时间
+    if (r->write && r->prealloc == SD_BENCH_PREALLOC_ON)
+    {
+        ret = io->preallocate(io, (uint64_t)blocks * r->chunk);
+    }
+    else if (r->write && random)
+    {
+        memset(buf, 0, r->chunk);
+        for (uint64_t b = 0; b < blocks && ret == ESP_OK; b++)
+        {
+            bench_stamp(buf, b * r->chunk);
+            if (io->write(io, buf, r->chunk) != (int)r->chunk)
+            {
+                ret = ESP_FAIL;
+            }
+        }
+        if (ret == ESP_OK)
+        {
+            ret = io->sync(io);
+        }
+    }
+    if (ret == ESP_OK)
+    {
+        ret = io->seek(io, 0);
+    }
+
+    uint64_t cpu_start = io->cpu_busy_us ? io->cpu_busy_us(io) : 0;
+    uint64_t start = bench_now_us();
+    for (uint32_t i = 0; i < ops && ret == ESP_OK; i++)
+    {
+        uint64_t block = random ? bench_rand(&rng) % blocks : i;
+        uint64_t offset = block * r->chunk;
+        uint64_t t0 = bench_now_us();
+        if (random)
+        {
+            ret = io->seek(io, offset);
+            if (ret != ESP_OK)
+            {
+                break;
+            }
+        }
+        if (r->write)
+        {
+            bench_stamp(buf, offset);
+            if (io->write(io, buf, r->chunk) != (int)r->chunk)
+            {
+                ret = ESP_FAIL;
+                break;
+            }
+            if (!buffered && io->sync(io) != ESP_OK)
+            {
+                ret = ESP_FAIL;
+                break;
+            }
+        }
+        else
+        {
+            if (io->read(io, buf, r->chunk) != (int)r->chunk)
+            {
+                ret = ESP_FAIL;
+                break;
+            }
+            if (cfg->verify && !bench_check(buf, offset))
+            {
+                ret = ESP_ERR_INVALID_CRC;
+                break;
+            }
+        }
+        bench_latency_add(lat, (uint32_t)(bench_now_us() - t0), &lat_rng);
+    }
+    // 缓冲写的数据在 close 时才真正落盘，计入总时间
+    esp_err_t close_ret = io->close(io);
+    uint64_t elapsed = bench_now_us() - start;
+    uint64_t cpu_used = io->cpu_busy_us ? io->cpu_busy_us(io) - cpu_start : 0;
+    if (ret == ESP_OK)
+    {
+        ret = close_ret;
+    }
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    qsort(lat->samples, lat->count, sizeof(uint32_t), bench_cmp_u32);
+    r->ops = ops;
+    r->bytes = (uint64_t)ops * r->chunk;
+    r->elapsed_us = elapsed;
+    r->mb_per_s = elapsed ? (float)r->bytes / elapsed : 0;
+    r->lat_p50_us = bench_percentile(lat, 500);
+    r->lat_p90_us = bench_percentile(lat, 900);
+    r->lat_p99_us = bench_percentile(lat, 990);
+    r->lat_max_us = lat->max;
+    r->cpu = SD_BENCH_CPU_UNKNOWN;
+    if (io->cpu_busy_us && elapsed)
+    {
+        uint64_t permille = cpu_used * 1000 / elapsed;
+        r->cpu = permille > 1000 ? 1000 : permille;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sd_bench_run(sd_bench_io_t *io, const sd_bench_config_t *config, sd_bench_report_cb_t cb, void *ctx)
+{
+    if (!io || !config || !config->path || config->min_chunk == 0 || config->max_chunk < config->min_chunk ||
+        config->file_size < config->max_chunk || config->latency_samples == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t *buf = malloc(config->max_chunk);
+    bench_latency_t lat = {
+        .samples = malloc(config->latency_samples * sizeof(uint32_t)),
+        .capacity = config->latency_samples,
+    };
+    if (!buf || !lat.samples)
+    {
+        free(buf);
+        free(lat.samples);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(buf, 0xA5, config->max_chunk);
+
+    static const uint8_t accesses[] = {SD_BENCH_ACCESS_SEQ, SD_BENCH_ACCESS_RANDOM};
+    static const uint8_t ios[] = {SD_BENCH_IO_BUFFERED, SD_BENCH_IO_SYNC};
+    static const uint8_t preallocs[] = {SD_BENCH_PREALLOC_OFF, SD_BENCH_PREALLOC_ON};
+
+    for (uint32_t chunk = config->min_chunk; chunk <= config->max_chunk; chunk *= 2)
+    {
+        for (int a = 0; a < 2; a++)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                for (int p = 0; p < 2; p++)
+                {
+                    if (!(config->access & accesses[a]) || !(config->io & ios[i]) || !(config->prealloc & preallocs[p]))
+                    {
+                        continue;
+                    }
+                    // 每组先删掉旧文件，保证"不预分配"时确实是从空文件开始分配簇
+                    io->remove(io, config->path);
+
+                    sd_bench_result_t r = {
+                        .chunk = chunk,
+                        .access = accesses[a],
+                        .io = ios[i],
+                        .prealloc = preallocs[p],
+                        .write = true,
+                    };
+                    r.err = bench_pass(io, config, &r, buf, &lat);
+                    if (cb)
+                    {
+                        cb(&r, ctx);
+                    }
+                    if (r.err != ESP_OK)
+                    {
+                        continue;
+                    }
+
+                    r = (sd_bench_result_t){
+                        .chunk = chunk,
+                        .access = accesses[a],
+                        .io = ios[i],
+                        .prealloc = preallocs[p],
+                        .write = false,
+                    };
+                    r.err = bench_pass(io, config, &r, buf, &lat);
+                    if (cb)
+                    {
+                        cb(&r, ctx);
+                    }
+                }
+            }
+        }
+        if (chunk > UINT32_MAX / 2)
+        {
+            break;
+        }
+    }
+    io->remove(io, config->path);
+
+    free(buf);
+    free(lat.samples);
+    return ESP_OK;
+}
+
+void sd_bench_print_header(void)
+{
+    printf("%-5s %6s %-4s %-4s %-5s %6s %9s %8s %8s %8s %8s %6s\n",
+           "op", "chunk", "acc", "io", "alloc", "ops", "MB/s", "p50(us)", "p90(us)", "p99(us)", "max(us)", "cpu%");
+}
+
+void sd_bench_print_result(const sd_bench_result_t *r, void *ctx)
+{
+    const char *op = r->write ? "write" : "read";
+    const char *acc = r->access == SD_BENCH_ACCESS_SEQ ? "seq" : "rand";
+    const char *io = r->io == SD_BENCH_IO_BUFFERED ? "buf" : "sync";
+    const char *alloc = r->prealloc == SD_BENCH_PREALLOC_ON ? "pre" : "-";
+    if (r->err != ESP_OK)
+    {
+        printf("%-5s %6u %-4s %-4s %-5s failed (0x%x)\n", op, (unsigned)r->chunk, acc, io, alloc, r->err);
+        return;
+    }
+    printf("%-5s %6u %-4s %-4s %-5s %6u %9.3f %8u %8u %8u %8u ",
+           op, (unsigned)r->chunk, acc, io, alloc, (unsigned)r->ops, r->mb_per_s,
+           (unsigned)r->lat_p50_us, (unsigned)r->lat_p90_us, (unsigned)r->lat_p99_us, (unsigned)r->lat_max_us);
+    if (r->cpu == SD_BENCH_CPU_UNKNOWN)
+    {
+        printf("%6s\n", "n/a");
+    }
+    else
+    {
+        printf("%4u.%u\n", r->cpu / 10, r->cpu % 10);
+    }
+}
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/cdefs.h>
+#include "sd_bench.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+// ESP32上空闲任务的运行时间需要 CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#if !defined(ESP_PLATFORM) || configGENERATE_RUN_TIME_STATS
+#define BENCH_HAS_CPU_TIME 1
+#endif
+
+// 缓冲模式的 stdio 缓冲区大小，与块大小无关：小块在这里合并，大块直接写穿，和同步模式比较的是C库缓冲的效果
+#define BENCH_STDIO_BUF_SIZE 4096
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+typedef struct
+{
+    sd_bench_io_t parent;
+    FILE *file;     /*!< 缓冲模式 */
+    int fd;         /*!< 同步模式 */
+    char *vbuf;     /*!< 缓冲模式下 setvbuf 的缓冲区 */
+} bench_posix_t;
+
+static esp_err_t posix_open(sd_bench_io_t *io, const char *path, bool write, bool buffered, size_t chunk)
+{
+    bench_posix_t *p = __containerof(io, bench_posix_t, parent);
+    p->file = NULL;
+    p->fd = -1;
+    if (buffered)
+    {
+        // 随机写要在已有文件上改写，所以写模式用 "r+b"，文件不存在再用 "wb" 创建
+        p->file = fopen(path, write ? "r+b" : "rb");
+        if (!p->file && write)
+        {
+            p->file = fopen(path, "wb");
+        }
+        if (!p->file)
+        {
+            return ESP_FAIL;
+        }
+        p->vbuf = malloc(BENCH_STDIO_BUF_SIZE);
+        if (p->vbuf)
+        {
+            setvbuf(p->file, p->vbuf, _IOFBF, BENCH_STDIO_BUF_SIZE);
+        }
+        return ESP_OK;
+    }
+    p->fd = open(path, write ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    return p->fd < 0 ? ESP_FAIL : ESP_OK;
+}
+
+static int posix_write(sd_bench_io_t *io, const void *buf, size_t len)
+{
+    bench_posix_t *p = __containerof(io, bench_posix_t, parent);
+    if (p->file)
+    {
+        return fwrite(buf, 1, len, p->file);
+    }
+    return write(p->fd, buf, len);
+}
+
+static int posix_read(sd_bench_io_t *io, void *buf, size_t len)
+{
+    bench_posix_t *p = __containerof(io, bench_posix_t, parent);
+    if (p->file)
+    {
+        return fread(buf, 1, len, p->file);
+    }
+    return read(p->fd, buf, len);
+}
+
+static esp_err_t posix_seek(sd_bench_io_t *io, uint64_t offset)
+{
+    bench_posix_t *p = __containerof(io, bench_posix_t, parent);
+    if (p->file)
+    {
+        return fseek(p->file, (long)offset, SEEK_SET) == 0 ? ESP_OK : ESP_FAIL;
+    }
+    return lseek(p->fd, (off_t)offset, SEEK_SET) < 0 ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t posix_sync(sd_bench_io_t *io)
+{
+    bench_posix_t *p = __containerof(io, bench_posix_t, parent);
+    if (p->file)
+    {
+        if (fflush(p->file) != 0)
+        {
+            return ESP_FAIL;
+        }
+        return fsync(fileno(p->file)) == 0 ? ESP_OK : ESP_FAIL;
+    }
+    return fsync(p->fd) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @description: 写文件的最后一个字节把文件扩展到 size。
+ *               FAT上这一步会一次性分配好整条簇链，之后的写入不再更新FAT表
+ */
+static esp_err_t posix_preallocate(sd_bench_io_t *io, uint64_t size)
+{
+    const uint8_t zero = 0;
+    if (size == 0)
+    {
+        return ESP_OK;
+    }
+    if (posix_seek(io, size - 1) != ESP_OK || posix_write(io, &zero, 1) != 1)
+    {
+        return ESP_FAIL;
+    }
+    return posix_sync(io);
+}
+
+static esp_err_t posix_close(sd_bench_io_t *io)
+{
+    bench_posix_t *p = __containerof(io, bench_posix_t, parent);
+    int ret = 0;
+    if (p->file)
+    {
+        ret = fclose(p->file);
+        p->file = NULL;
+    }
+    if (p->fd >= 0)
+    {
+        ret = close(p->fd);
+        p->fd = -1;
+    }
+    free(p->vbuf);
+    p->vbuf = NULL;
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t posix_remove(sd_bench_io_t *io, const char *path)
+{
+    return unlink(path) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+#ifdef BENCH_HAS_CPU_TIME
+/**
+ * @description: CPU忙碌时间。ESP32上用总时间减去空闲任务的运行时间（需要打开运行时间统计），
+ *               PC上用进程的CPU时间
+ */
+static uint64_t posix_cpu_busy_us(sd_bench_io_t *io)
+{
+#ifdef ESP_PLATFORM
+    // 运行时间统计的时钟源是 esp_timer（微秒），32位计数约71分钟回绕，单组测试远小于此
+    static uint32_t last_idle = 0;
+    static uint64_t idle_total = 0;
+    uint32_t idle = ulTaskGetIdleRunTimeCounter();
+    idle_total += (uint32_t)(idle - last_idle);
+    last_idle = idle;
+    return esp_timer_get_time() - idle_total;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+#endif
+
+static esp_err_t posix_del(sd_bench_io_t *io)
+{
+    bench_posix_t *p = __containerof(io, bench_posix_t, parent);
+    posix_close(io);
+    free(p);
+    return ESP_OK;
+}
+
+sd_bench_io_t *sd_bench_io_new_posix(void)
+{
+    bench_posix_t *p = calloc(1, sizeof(bench_posix_t));
+    if (!p)
+    {
+        return NULL;
+    }
+    p->fd = -1;
+    p->parent.open = posix_open;
+    p->parent.write = posix_write;
+    p->parent.read = posix_read;
+    p->parent.seek = posix_seek;
+    p->parent.sync = posix_sync;
+    p->parent.preallocate = posix_preallocate;
+    p->parent.close = posix_close;
+    p->parent.remove = posix_remove;
+#ifdef BENCH_HAS_CPU_TIME
+    p->parent.cpu_busy_us = posix_cpu_busy_us;
+#endif
+    p->parent.del = posix_del;
+    return &p->parent;
+}
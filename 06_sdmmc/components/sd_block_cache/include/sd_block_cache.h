@@ -0,0 +1,121 @@
+#ifndef __SD_BLOCK_CACHE_H__
+#define __SD_BLOCK_CACHE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+/*
+ * 读数据（回放、上传日志）用的块缓存：设备按 block_size 为单位读入 block_count 个缓冲块，LRU淘汰。
+ * 连续 seq_trigger 次访问相邻的块后认为是顺序读，由预读任务在后台读入后面 readahead 个块，
+ * 消费者解码当前块的同时下一块已经在读，吞吐量接近总线速度，不再受每次读调用的固定延时限制。
+ *
+ * 只支持一个读任务调用 sd_cache_read()；设备的 read 会同时被读任务和预读任务调用。
+ */
+
+typedef struct sd_cache_dev_s sd_cache_dev_t;
+
+/**
+ * @brief 被缓存的设备
+ */
+struct sd_cache_dev_s
+{
+    /**
+     * @brief 读 len 字节，offset 和 len 都是块大小的整数倍；超出设备末尾的部分填零
+     */
+    esp_err_t (*read)(sd_cache_dev_t *dev, uint64_t offset, void *buf, size_t len);
+    esp_err_t (*size)(sd_cache_dev_t *dev, uint64_t *size); /*!< 设备字节数 */
+    esp_err_t (*del)(sd_cache_dev_t *dev); /*!< 关闭并释放 */
+};
+
+typedef struct
+{
+    size_t block_size;         /*!< 缓存块大小，512的整数倍 */
+    uint16_t block_count;      /*!< 缓存块数，至少 readahead + 2 */
+    uint16_t readahead;        /*!< 顺序读时预读的块数，0表示不预读 */
+    uint8_t seq_trigger;       /*!< 连续几次相邻访问后开始预读 */
+    UBaseType_t task_priority; /*!< 预读任务优先级 */
+    uint32_t task_stack;
+} sd_cache_config_t;
+
+#define SD_CACHE_DEFAULT_CONFIG()   \
+    {                               \
+        .block_size = 8 * 1024,     \
+        .block_count = 8,           \
+        .readahead = 4,             \
+        .seq_trigger = 2,           \
+        .task_priority = 4,         \
+        .task_stack = 3072,         \
+    }
+
+typedef struct
+{
+    uint32_t hits;           /*!< 命中已读入的块 */
+    uint32_t misses;         /*!< 读任务自己从设备读的块 */
+    uint32_t waits;          /*!< 块正在预读，读任务等待它读完 */
+    uint32_t prefetched;     /*!< 预读任务读入的块 */
+    uint32_t prefetch_used;  /*!< 预读的块中后来被访问的 */
+    uint32_t evicted;
+    uint64_t bytes;          /*!< sd_cache_read() 返回的总字节数 */
+    esp_err_t last_error;
+} sd_cache_stats_t;
+
+typedef struct sd_cache_s *sd_cache_handle_t;
+
+/**
+ * @description: 创建缓存和预读任务
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG / ESP_ERR_NO_MEM
+ * @param {sd_cache_dev_t} *dev 设备，删除缓存时一起释放
+ */
+esp_err_t sd_cache_create(sd_cache_dev_t *dev, const sd_cache_config_t *config, sd_cache_handle_t *out);
+
+/**
+ * @description: 读任意偏移和长度的数据
+ * @return       ESP_OK / 设备的错误
+ * @param {uint64_t} offset 字节偏移
+ * @param {void} *buf 输出
+ * @param {size_t} len 要读的字节数
+ * @param {size_t} *read_len 实际读到的字节数（到设备末尾为止），可以为NULL
+ */
+esp_err_t sd_cache_read(sd_cache_handle_t cache, uint64_t offset, void *buf, size_t len, size_t *read_len);
+
+/**
+ * @description: 丢弃所有缓存块（设备内容被其他途径改写后调用）
+ */
+void sd_cache_invalidate(sd_cache_handle_t cache);
+
+void sd_cache_get_stats(sd_cache_handle_t cache, sd_cache_stats_t *stats);
+
+/**
+ * @description: 停止预读任务，释放缓存和设备
+ */
+esp_err_t sd_cache_delete(sd_cache_handle_t cache);
+
+// 文件设备的配置，latency_us 在每次读调用上附加延时，用于在PC上模拟SD卡的命令开销
+typedef struct
+{
+    const char *path;
+    uint32_t latency_us;
+} sd_cache_file_config_t;
+
+/**
+ * @description: 基于 pread 的设备，ESP32上读FAT中的文件，PC上读普通文件
+ * @return       设备，打开失败返回NULL
+ */
+sd_cache_dev_t *sd_cache_dev_new_file(const sd_cache_file_config_t *config);
+
+#ifdef ESP_PLATFORM
+#include "sdmmc_cmd.h"
+/**
+ * @description: 直接读SD卡扇区的设备（如 sd_contig_log 的数据区），缓存块必须是扇区的整数倍
+ * @return       设备，内存不足返回NULL
+ * @param {sdmmc_card_t} *card 卡
+ * @param {uint64_t} first_sector 设备起始扇区
+ * @param {uint64_t} sectors 设备扇区数
+ */
+sd_cache_dev_t *sd_cache_dev_new_sdmmc(sdmmc_card_t *card, uint64_t first_sector, uint64_t sectors);
+#endif
+
+#endif /* __SD_BLOCK_CACHE_H__ */
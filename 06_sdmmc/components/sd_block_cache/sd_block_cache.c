@@ -0,0 +1,386 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sd_block_cache.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "sd_cache";
+
+#define CACHE_NO_BLOCK UINT64_MAX
+#define CACHE_MSG_STOP UINT64_MAX
+
+typedef enum
+{
+    ENTRY_EMPTY = 0,
+    ENTRY_LOADING, /*!< 正在从设备读，数据不可用，也不能被淘汰 */
+    ENTRY_VALID,
+} entry_state_t;
+
+typedef struct
+{
+    uint64_t block;
+    uint32_t stamp;      /*!< 最近一次使用的时间，越小越先淘汰 */
+    uint32_t generation; /*!< 开始读时的 cache->generation，读完时不同说明期间被作废 */
+    uint8_t state;
+    bool prefetched;     /*!< 由预读任务读入，还没被访问过 */
+    uint8_t *data;
+} cache_entry_t;
+
+struct sd_cache_s
+{
+    sd_cache_dev_t *dev;
+    sd_cache_config_t config;
+    uint64_t dev_size;
+    cache_entry_t *entries;
+    SemaphoreHandle_t lock;  /*!< 保护 entries 的状态、顺序检测和统计 */
+    QueueHandle_t queue;     /*!< 要预读的块号 */
+    SemaphoreHandle_t done;  /*!< 预读任务退出时释放 */
+    TaskHandle_t task;
+    TaskHandle_t waiter;     /*!< 等待块读完的读任务 */
+    uint32_t stamp;
+    uint32_t generation;
+    uint64_t last_block;     /*!< 上一次访问的块 */
+    uint32_t run;            /*!< 连续访问相邻块的次数 */
+    uint64_t next_prefetch;  /*!< 下一个要交给预读任务的块 */
+    sd_cache_stats_t stats;
+};
+
+static cache_entry_t *cache_find(sd_cache_handle_t c, uint64_t block)
+{
+    for (uint16_t i = 0; i < c->config.block_count; i++)
+    {
+        if (c->entries[i].state != ENTRY_EMPTY && c->entries[i].block == block)
+        {
+            return &c->entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @description: 选一个块用来读入新数据：优先用空块，否则淘汰最久没用的有效块
+ * @return       找不到（全部在读）返回NULL
+ */
+static cache_entry_t *cache_victim(sd_cache_handle_t c)
+{
+    cache_entry_t *victim = NULL;
+    for (uint16_t i = 0; i < c->config.block_count; i++)
+    {
+        cache_entry_t *e = &c->entries[i];
+        if (e->state == ENTRY_EMPTY)
+        {
+            return e;
+        }
+        // 无符号差值，stamp 回绕后仍能比较先后
+        if (e->state == ENTRY_VALID && (!victim || (int32_t)(e->stamp - victim->stamp) < 0))
+        {
+            victim = e;
+        }
+    }
+    if (victim)
+    {
+        c->stats.evicted++;
+    }
+    return victim;
+}
+
+/**
+ * @description: 从设备读一块到 e，调用前持有 lock 并已把 e 标记为 ENTRY_LOADING，返回时仍持有 lock
+ */
+static esp_err_t cache_load(sd_cache_handle_t c, cache_entry_t *e)
+{
+    uint64_t block = e->block;
+    uint32_t generation = e->generation;
+    xSemaphoreGive(c->lock);
+    esp_err_t ret = c->dev->read(c->dev, block * c->config.block_size, e->data, c->config.block_size);
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    if (ret != ESP_OK)
+    {
+        c->stats.last_error = ret;
+    }
+    e->state = ret == ESP_OK && generation == c->generation ? ENTRY_VALID : ENTRY_EMPTY;
+    e->stamp = ++c->stamp;
+    if (c->waiter)
+    {
+        xTaskNotifyGive(c->waiter);
+        c->waiter = NULL;
+    }
+    return ret;
+}
+
+static void cache_task(void *arg)
+{
+    sd_cache_handle_t c = (sd_cache_handle_t)arg;
+    uint64_t block;
+    while (1)
+    {
+        xQueueReceive(c->queue, &block, portMAX_DELAY);
+        if (block == CACHE_MSG_STOP)
+        {
+            xSemaphoreGive(c->done);
+            vTaskDelete(NULL);
+        }
+        xSemaphoreTake(c->lock, portMAX_DELAY);
+        // 读任务已经离开这一段（跳读或已经读过去）时不再预读
+        bool wanted = c->last_block != CACHE_NO_BLOCK && block > c->last_block &&
+                      block <= c->last_block + c->config.readahead && !cache_find(c, block);
+        cache_entry_t *e = wanted ? cache_victim(c) : NULL;
+        if (e)
+        {
+            e->block = block;
+            e->state = ENTRY_LOADING;
+            e->prefetched = true;
+            e->generation = c->generation;
+            if (cache_load(c, e) == ESP_OK)
+            {
+                c->stats.prefetched++;
+            }
+        }
+        xSemaphoreGive(c->lock);
+    }
+}
+
+/**
+ * @description: 记录对 block 的访问，连续访问相邻块达到 seq_trigger 次后把后面的块交给预读任务，调用前持有 lock
+ */
+static void cache_track(sd_cache_handle_t c, uint64_t block)
+{
+    if (block == c->last_block)
+    {
+        return;
+    }
+    if (c->last_block != CACHE_NO_BLOCK && block == c->last_block + 1)
+    {
+        c->run++;
+    }
+    else
+    {
+        c->run = 0;
+        c->next_prefetch = 0;
+    }
+    c->last_block = block;
+    if (c->config.readahead == 0 || c->run < c->config.seq_trigger)
+    {
+        return;
+    }
+    uint64_t last = (c->dev_size - 1) / c->config.block_size;
+    uint64_t end = block + c->config.readahead;
+    uint64_t next = c->next_prefetch > block ? c->next_prefetch : block + 1;
+    for (; next <= end && next <= last; next++)
+    {
+        if (xQueueSend(c->queue, &next, 0) != pdTRUE)
+        {
+            break;
+        }
+    }
+    c->next_prefetch = next;
+}
+
+esp_err_t sd_cache_read(sd_cache_handle_t c, uint64_t offset, void *buf, size_t len, size_t *read_len)
+{
+    if (!c || (!buf && len))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset >= c->dev_size)
+    {
+        len = 0;
+    }
+    else if (len > c->dev_size - offset)
+    {
+        len = c->dev_size - offset;
+    }
+    uint8_t *dst = buf;
+    size_t done = 0;
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    while (done < len)
+    {
+        uint64_t pos = offset + done;
+        uint64_t block = pos / c->config.block_size;
+        size_t in_block = pos % c->config.block_size;
+        size_t n = c->config.block_size - in_block;
+        n = n < len - done ? n : len - done;
+
+        cache_track(c, block);
+        cache_entry_t *e = cache_find(c, block);
+        if (e && e->state == ENTRY_LOADING)
+        {
+            // 预读任务正在读这一块，等它读完再查一次
+            c->stats.waits++;
+            c->waiter = xTaskGetCurrentTaskHandle();
+            xSemaphoreGive(c->lock);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            xSemaphoreTake(c->lock, portMAX_DELAY);
+            continue;
+        }
+        if (e)
+        {
+            c->stats.hits++;
+            if (e->prefetched)
+            {
+                c->stats.prefetch_used++;
+                e->prefetched = false;
+            }
+            e->stamp = ++c->stamp;
+        }
+        else
+        {
+            e = cache_victim(c);
+            if (!e)
+            {
+                ret = ESP_ERR_NO_MEM;
+                break;
+            }
+            c->stats.misses++;
+            e->block = block;
+            e->state = ENTRY_LOADING;
+            e->prefetched = false;
+            e->generation = c->generation;
+            ret = cache_load(c, e);
+            if (ret != ESP_OK)
+            {
+                break;
+            }
+            if (e->state != ENTRY_VALID)
+            {
+                continue; // 读的过程中被作废
+            }
+        }
+        memcpy(dst + done, e->data + in_block, n);
+        done += n;
+    }
+    c->stats.bytes += done;
+    xSemaphoreGive(c->lock);
+    if (read_len)
+    {
+        *read_len = done;
+    }
+    return ret;
+}
+
+void sd_cache_invalidate(sd_cache_handle_t c)
+{
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    xQueueReset(c->queue);
+    c->generation++;
+    for (uint16_t i = 0; i < c->config.block_count; i++)
+    {
+        if (c->entries[i].state == ENTRY_VALID)
+        {
+            c->entries[i].state = ENTRY_EMPTY;
+        }
+    }
+    c->last_block = CACHE_NO_BLOCK;
+    c->run = 0;
+    c->next_prefetch = 0;
+    c->dev->size(c->dev, &c->dev_size);
+    xSemaphoreGive(c->lock);
+}
+
+void sd_cache_get_stats(sd_cache_handle_t c, sd_cache_stats_t *stats)
+{
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    *stats = c->stats;
+    xSemaphoreGive(c->lock);
+}
+
+static void cache_free(sd_cache_handle_t c)
+{
+    if (c->entries)
+    {
+        for (uint16_t i = 0; i < c->config.block_count; i++)
+        {
+            heap_caps_free(c->entries[i].data);
+        }
+        free(c->entries);
+    }
+    if (c->lock)
+    {
+        vSemaphoreDelete(c->lock);
+    }
+    if (c->queue)
+    {
+        vQueueDelete(c->queue);
+    }
+    if (c->done)
+    {
+        vSemaphoreDelete(c->done);
+    }
+    free(c);
+}
+
+esp_err_t sd_cache_create(sd_cache_dev_t *dev, const sd_cache_config_t *config, sd_cache_handle_t *out)
+{
+    if (!dev || !config || !out || config->block_size == 0 || config->block_size % 512 ||
+        config->block_count < config->readahead + 2)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sd_cache_handle_t c = calloc(1, sizeof(struct sd_cache_s));
+    if (!c)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    c->dev = dev;
+    c->config = *config;
+    c->last_block = CACHE_NO_BLOCK;
+    esp_err_t ret = dev->size(dev, &c->dev_size);
+    if (ret != ESP_OK)
+    {
+        free(c);
+        return ret;
+    }
+
+    c->entries = calloc(config->block_count, sizeof(cache_entry_t));
+    c->lock = xSemaphoreCreateMutex();
+    // 每次访问最多补 readahead 个块，再加一个停止消息的位置
+    c->queue = xQueueCreate(config->readahead + 2, sizeof(uint64_t));
+    c->done = xSemaphoreCreateBinary();
+    if (!c->entries || !c->lock || !c->queue || !c->done)
+    {
+        cache_free(c);
+        return ESP_ERR_NO_MEM;
+    }
+    // 可DMA的缓冲区，SDMMC驱动直接多扇区读到这里
+    for (uint16_t i = 0; i < config->block_count; i++)
+    {
+        c->entries[i].data = heap_caps_aligned_alloc(4, config->block_size, MALLOC_CAP_DMA);
+        if (!c->entries[i].data)
+        {
+            ESP_LOGE(TAG, "no memory for %u x %u byte blocks", config->block_count, (unsigned)config->block_size);
+            cache_free(c);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (xTaskCreate(cache_task, "sd_cache", config->task_stack, c, config->task_priority, &c->task) != pdPASS)
+    {
+        cache_free(c);
+        return ESP_ERR_NO_MEM;
+    }
+    *out = c;
+    return ESP_OK;
+}
+
+esp_err_t sd_cache_delete(sd_cache_handle_t c)
+{
+    if (!c)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 清空队列后停止消息一定放得下；预读任务处理完手上的块才会收到它
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    xQueueReset(c->queue);
+    c->last_block = CACHE_NO_BLOCK;
+    xSemaphoreGive(c->lock);
+    uint64_t stop = CACHE_MSG_STOP;
+    xQueueSend(c->queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(c->done, portMAX_DELAY);
+
+    esp_err_t ret = c->dev->del(c->dev);
+    cache_free(c);
+    return ret;
+}
@@ -0,0 +1,89 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "sd_block_cache.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+typedef struct
+{
+    sd_cache_dev_t parent;
+    int fd;
+    uint32_t latency_us;
+} cache_dev_file_t;
+
+static esp_err_t file_read(sd_cache_dev_t *dev, uint64_t offset, void *buf, size_t len)
+{
+    cache_dev_file_t *f = __containerof(dev, cache_dev_file_t, parent);
+    if (f->latency_us)
+    {
+        usleep(f->latency_us);
+    }
+    uint8_t *dst = buf;
+    while (len)
+    {
+        // pread 不改变文件位置，读任务和预读任务可以同时读
+        ssize_t n = pread(f->fd, dst, len, (off_t)offset);
+        if (n < 0)
+        {
+            return ESP_FAIL;
+        }
+        if (n == 0)
+        {
+            memset(dst, 0, len);
+            return ESP_OK;
+        }
+        dst += n;
+        offset += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t file_size(sd_cache_dev_t *dev, uint64_t *size)
+{
+    cache_dev_file_t *f = __containerof(dev, cache_dev_file_t, parent);
+    struct stat st;
+    if (fstat(f->fd, &st) != 0)
+    {
+        return ESP_FAIL;
+    }
+    *size = st.st_size;
+    return ESP_OK;
+}
+
+static esp_err_t file_del(sd_cache_dev_t *dev)
+{
+    cache_dev_file_t *f = __containerof(dev, cache_dev_file_t, parent);
+    int ret = close(f->fd);
+    free(f);
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+sd_cache_dev_t *sd_cache_dev_new_file(const sd_cache_file_config_t *config)
+{
+    if (!config || !config->path)
+    {
+        return NULL;
+    }
+    cache_dev_file_t *f = calloc(1, sizeof(cache_dev_file_t));
+    if (!f)
+    {
+        return NULL;
+    }
+    f->fd = open(config->path, O_RDONLY);
+    if (f->fd < 0)
+    {
+        free(f);
+        return NULL;
+    }
+    f->latency_us = config->latency_us;
+    f->parent.read = file_read;
+    f->parent.size = file_size;
+    f->parent.del = file_del;
+    return &f->parent;
+}
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sd_block_cache.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+#define SECTOR_SIZE 512
+
+typedef struct
+{
+    sd_cache_dev_t parent;
+    sdmmc_card_t *card;
+    uint64_t first_sector;
+    uint64_t sectors;
+} cache_dev_sdmmc_t;
+
+static esp_err_t sdmmc_dev_read(sd_cache_dev_t *dev, uint64_t offset, void *buf, size_t len)
+{
+    cache_dev_sdmmc_t *d = __containerof(dev, cache_dev_sdmmc_t, parent);
+    uint64_t sector = offset / SECTOR_SIZE;
+    size_t count = len / SECTOR_SIZE;
+    size_t avail = sector < d->sectors ? (d->sectors - sector < count ? d->sectors - sector : count) : 0;
+    if (avail < count)
+    {
+        memset((uint8_t *)buf + avail * SECTOR_SIZE, 0, (count - avail) * SECTOR_SIZE);
+    }
+    // 缓存块是可DMA的，驱动一条多块读命令读完，不经过内部的中转缓冲区
+    return avail ? sdmmc_read_sectors(d->card, buf, d->first_sector + sector, avail) : ESP_OK;
+}
+
+static esp_err_t sdmmc_dev_size(sd_cache_dev_t *dev, uint64_t *size)
+{
+    *size = __containerof(dev, cache_dev_sdmmc_t, parent)->sectors * SECTOR_SIZE;
+    return ESP_OK;
+}
+
+static esp_err_t sdmmc_dev_del(sd_cache_dev_t *dev)
+{
+    free(__containerof(dev, cache_dev_sdmmc_t, parent));
+    return ESP_OK;
+}
+
+sd_cache_dev_t *sd_cache_dev_new_sdmmc(sdmmc_card_t *card, uint64_t first_sector, uint64_t sectors)
+{
+    if (!card || card->csd.sector_size != SECTOR_SIZE)
+    {
+        return NULL;
+    }
+    cache_dev_sdmmc_t *d = calloc(1, sizeof(cache_dev_sdmmc_t));
+    if (!d)
+    {
+        return NULL;
+    }
+    d->card = card;
+    d->first_sector = first_sector;
+    d->sectors = sectors;
+    d->parent.read = sdmmc_dev_read;
+    d->parent.size = sdmmc_dev_size;
+    d->parent.del = sdmmc_dev_del;
+    return &d->parent;
+}
@@ -0,0 +1,68 @@
+#ifndef __SD_BRINGUP_H__
+#define __SD_BRINGUP_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_vfs_fat.h"
+#include "driver/sdmmc_host.h"
+#include "sdmmc_cmd.h"
+
+/*
+ * SD卡初始化时自动协商总线宽度和时钟：
+ *
+ *   1. 先检查 D1~D3 上有没有外部上拉（没接线的引脚读出来是低电平），没有且没开内部上拉时不尝试4线
+ *   2. 按 4线高速(40MHz) -> 4线默认(20MHz) -> 1线高速 -> 1线默认 的顺序逐个尝试：
+ *      初始化卡（卡不支持高速时驱动自动停在默认时钟），再连续几遍读同一段扇区，
+ *      要求全部成功（数据线CRC正确）且每遍内容相同，失败就换下一种
+ *   3. 用第一种通过的组合挂载文件系统
+ */
+
+typedef struct
+{
+    sdmmc_host_t host;          /*!< 主机配置，max_freq_khz 会被覆盖 */
+    sdmmc_slot_config_t slot;   /*!< 引脚配置，width 为最多尝试的线数（1或4） */
+    bool try_high_speed;        /*!< 是否尝试高速模式 */
+    uint32_t probe_sectors;     /*!< 每遍读的扇区数，0表示只初始化不读 */
+    uint8_t probe_passes;       /*!< 读几遍 */
+} sd_bringup_config_t;
+
+#define SD_BRINGUP_DEFAULT_CONFIG()           \
+    {                                         \
+        .host = SDMMC_HOST_DEFAULT(),         \
+        .slot = SDMMC_SLOT_CONFIG_DEFAULT(),  \
+        .try_high_speed = true,               \
+        .probe_sectors = 64,                  \
+        .probe_passes = 3,                    \
+    }
+
+typedef struct
+{
+    uint8_t width;         /*!< 协商得到的线数 */
+    uint32_t freq_khz;     /*!< 协商得到的时钟 */
+    bool high_speed;       /*!< 是否为高速模式 */
+    bool dat_pullups;      /*!< D1~D3 检测到上拉 */
+    uint8_t attempts;      /*!< 尝试过的组合数 */
+    uint32_t probe_kbps;   /*!< 探测读取的速度，KB/s，0表示未测 */
+} sd_bringup_result_t;
+
+/**
+ * @description: 协商总线宽度和时钟并挂载文件系统
+ * @return       ESP_OK / ESP_FAIL（文件系统挂载失败）/ 所有组合都失败时最后一次的错误
+ * @param {char} *mount_point 挂载点
+ * @param {sd_bringup_config_t} *config 配置
+ * @param {esp_vfs_fat_sdmmc_mount_config_t} *mount_config 文件系统配置
+ * @param {sdmmc_card_t} **card 输出卡信息
+ * @param {sd_bringup_result_t} *result 输出协商结果，可以为NULL
+ */
+esp_err_t sd_bringup_mount(const char *mount_point, const sd_bringup_config_t *config,
+                           const esp_vfs_fat_sdmmc_mount_config_t *mount_config,
+                           sdmmc_card_t **card, sd_bringup_result_t *result);
+
+/**
+ * @description: 打印卡信息（sdmmc_card_print_info）和协商得到的总线宽度、时钟
+ */
+void sd_bringup_print_info(FILE *stream, const sdmmc_card_t *card, const sd_bringup_result_t *result);
+
+#endif /* __SD_BRINGUP_H__ */
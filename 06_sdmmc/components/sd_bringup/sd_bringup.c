@@ -0,0 +1,220 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sd_bringup.h"
+#include "driver/gpio.h"
+#include "soc/soc_caps.h"
+#include "soc/sdmmc_periph.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+
+static const char *TAG = "sd_bringup";
+
+typedef struct
+{
+    uint8_t width;
+    bool high_speed;
+} bringup_mode_t;
+
+// 按速度从高到低尝试
+static const bringup_mode_t s_modes[] = {
+    {4, true},
+    {4, false},
+    {1, true},
+    {1, false},
+};
+
+// D1~D3 的GPIO
+static void bringup_dat_gpios(const sd_bringup_config_t *config, gpio_num_t gpios[3])
+{
+#ifdef SOC_SDMMC_USE_GPIO_MATRIX
+    gpios[0] = config->slot.d1;
+    gpios[1] = config->slot.d2;
+    gpios[2] = config->slot.d3;
+#else
+    const sdmmc_slot_info_t *info = &sdmmc_slot_info[config->host.slot];
+    gpios[0] = info->d1_gpio;
+    gpios[1] = info->d2_gpio;
+    gpios[2] = info->d3_gpio;
+#endif
+}
+
+/**
+ * @description: 检查 D1~D3 是否有外部上拉：打开内部下拉后仍读到高电平说明接了上拉电阻（也就接到了卡上）
+ * @return       三根线都有上拉返回true
+ */
+static bool bringup_check_pullups(const sd_bringup_config_t *config)
+{
+    gpio_num_t gpios[3];
+    bringup_dat_gpios(config, gpios);
+    bool ok = true;
+    for (int i = 0; i < 3; i++)
+    {
+        if (gpios[i] < 0)
+        {
+            return false;
+        }
+        gpio_reset_pin(gpios[i]);
+        gpio_set_direction(gpios[i], GPIO_MODE_INPUT);
+        gpio_set_pull_mode(gpios[i], GPIO_PULLDOWN_ONLY);
+        esp_rom_delay_us(50);
+        if (gpio_get_level(gpios[i]) == 0)
+        {
+            ESP_LOGW(TAG, "no pull-up on D%d (GPIO%d)", i + 1, gpios[i]);
+            ok = false;
+        }
+        gpio_reset_pin(gpios[i]);
+    }
+    return ok;
+}
+
+/**
+ * @description: 连续几遍读同一段扇区，检查数据线是否可靠
+ * @return       ESP_OK / 读扇区的错误（CRC错误、超时）/ ESP_ERR_INVALID_CRC（两遍内容不同）
+ */
+static esp_err_t bringup_probe(sdmmc_card_t *card, const sd_bringup_config_t *config, uint32_t *kbps)
+{
+    size_t sectors = config->probe_sectors;
+    if (sectors > (size_t)card->csd.capacity)
+    {
+        sectors = card->csd.capacity;
+    }
+    size_t len = sectors * card->csd.sector_size;
+    uint8_t *first = heap_caps_malloc(len, MALLOC_CAP_DMA);
+    uint8_t *again = heap_caps_malloc(len, MALLOC_CAP_DMA);
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (first && again)
+    {
+        int64_t start = esp_timer_get_time();
+        ret = sdmmc_read_sectors(card, first, 0, sectors);
+        for (uint8_t pass = 1; pass < config->probe_passes && ret == ESP_OK; pass++)
+        {
+            ret = sdmmc_read_sectors(card, again, 0, sectors);
+            if (ret == ESP_OK && memcmp(first, again, len) != 0)
+            {
+                ret = ESP_ERR_INVALID_CRC;
+            }
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (ret == ESP_OK && elapsed > 0)
+        {
+            uint64_t passes = config->probe_passes ? config->probe_passes : 1;
+            *kbps = (uint32_t)(passes * len * 1000 / elapsed);
+        }
+    }
+    heap_caps_free(first);
+    heap_caps_free(again);
+    return ret;
+}
+
+/**
+ * @description: 用一种总线宽度和时钟初始化卡并探测，结束后释放主机，由挂载重新初始化
+ */
+static esp_err_t bringup_try(const sd_bringup_config_t *config, sdmmc_host_t *host, sdmmc_slot_config_t *slot,
+                             sd_bringup_result_t *result)
+{
+    esp_err_t ret = host->init();
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    sdmmc_card_t *card = calloc(1, sizeof(sdmmc_card_t));
+    if (!card)
+    {
+        host->deinit();
+        return ESP_ERR_NO_MEM;
+    }
+    ret = sdmmc_host_init_slot(host->slot, slot);
+    if (ret == ESP_OK)
+    {
+        ret = sdmmc_card_init(host, card);
+    }
+    if (ret == ESP_OK)
+    {
+        result->width = 1 << card->log_bus_width;
+        result->freq_khz = card->max_freq_khz;
+        result->high_speed = card->max_freq_khz >= SDMMC_FREQ_HIGHSPEED;
+        result->probe_kbps = 0;
+        if (config->probe_sectors && config->probe_passes)
+        {
+            ret = bringup_probe(card, config, &result->probe_kbps);
+        }
+    }
+    host->deinit();
+    free(card);
+    return ret;
+}
+
+esp_err_t sd_bringup_mount(const char *mount_point, const sd_bringup_config_t *config,
+                           const esp_vfs_fat_sdmmc_mount_config_t *mount_config,
+                           sdmmc_card_t **card, sd_bringup_result_t *result)
+{
+    if (!mount_point || !config || !mount_config || !card)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sd_bringup_result_t local;
+    if (!result)
+    {
+        result = &local;
+    }
+    memset(result, 0, sizeof(*result));
+
+    bool try_4bit = config->slot.width >= 4 && (config->host.flags & SDMMC_HOST_FLAG_4BIT);
+    if (try_4bit)
+    {
+        result->dat_pullups = bringup_check_pullups(config);
+        // 只靠内部上拉时检测不到外部上拉，但接线可能是对的，交给读扇区探测判断
+        if (!result->dat_pullups && !(config->slot.flags & SDMMC_SLOT_FLAG_INTERNAL_PULLUP))
+        {
+            ESP_LOGW(TAG, "D1-D3 not connected, 4-bit mode skipped");
+            try_4bit = false;
+        }
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    for (size_t i = 0; i < sizeof(s_modes) / sizeof(s_modes[0]); i++)
+    {
+        const bringup_mode_t *mode = &s_modes[i];
+        if ((mode->width == 4 && !try_4bit) || (mode->high_speed && !config->try_high_speed))
+        {
+            continue;
+        }
+        sdmmc_host_t host = config->host;
+        sdmmc_slot_config_t slot = config->slot;
+        host.max_freq_khz = mode->high_speed ? SDMMC_FREQ_HIGHSPEED : SDMMC_FREQ_DEFAULT;
+        slot.width = mode->width;
+        result->attempts++;
+
+        ret = bringup_try(config, &host, &slot, result);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGW(TAG, "%d-bit %s failed (%s)", mode->width, mode->high_speed ? "high speed" : "default speed",
+                     esp_err_to_name(ret));
+            continue;
+        }
+        ESP_LOGI(TAG, "%d-bit, %u kHz: probe OK, %u KB/s", result->width, result->freq_khz, result->probe_kbps);
+
+        ret = esp_vfs_fat_sdmmc_mount(mount_point, &host, &slot, mount_config, card);
+        if (ret == ESP_OK || ret == ESP_FAIL)
+        {
+            // ESP_FAIL 是文件系统的问题，换总线模式也没用
+            return ret;
+        }
+        ESP_LOGW(TAG, "mount in %d-bit mode failed (%s)", result->width, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+void sd_bringup_print_info(FILE *stream, const sdmmc_card_t *card, const sd_bringup_result_t *result)
+{
+    sdmmc_card_print_info(stream, card);
+    fprintf(stream, "Bus: %d-bit, %d kHz%s\n", 1 << card->log_bus_width, card->max_freq_khz,
+            card->max_freq_khz >= SDMMC_FREQ_HIGHSPEED ? " (high speed)" : "");
+    if (result)
+    {
+        fprintf(stream, "Negotiation: %u attempt(s), D1-D3 pull-ups %s, probe read %u KB/s\n",
+                result->attempts, result->dat_pullups ? "detected" : "not detected", result->probe_kbps);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef __SD_CONTIG_LOG_H__
+#define __SD_CONTIG_LOG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdmmc_cmd.h"
+#include "sd_contig_log_header.h"
+
+/*
+ * 预分配的连续日志文件：打开时用FatFs一次性分配固定大小、簇号连续的文件，
+ * 算出文件在卡上的起始扇区后关闭文件。之后的追加直接用 sdmmc_write_sectors 写这段扇区，
+ * 热路径上不再有簇链分配、FAT表和目录项的更新，写入速度稳定。
+ *
+ * 有效数据长度记录在文件开头的头扇区中（格式见 sd_contig_log_header.h），
+ * 文件在FAT中始终是完整的预分配大小，PC上照常可读，按头截取即可（host/sd_contig_extract）。
+ *
+ * 打开期间不要再通过VFS/FatFs写这个文件。句柄不是线程安全的，只能在一个任务中使用。
+ */
+
+typedef struct
+{
+    sdmmc_card_t *card;         /*!< esp_vfs_fat_sdmmc_mount 得到的卡 */
+    const char *path;           /*!< 文件在FAT卷中的路径，如 "log.bin"（不带挂载点） */
+    uint64_t capacity;          /*!< 数据区大小，向上取整到扇区 */
+    uint32_t buffer_sectors;    /*!< 暂存缓冲区扇区数，写满一次性写出 */
+    uint32_t header_every;      /*!< 每写出这么多次缓冲区更新一次头，0表示只在 sync 时更新 */
+    bool truncate;              /*!< true：丢弃已有数据从头写；false：从头中记录的长度处继续 */
+} sd_contig_log_config_t;
+
+#define SD_CONTIG_LOG_DEFAULT_CONFIG(c, p, size) \
+    {                                            \
+        .card = (c),                             \
+        .path = (p),                             \
+        .capacity = (size),                      \
+        .buffer_sectors = 64,                    \
+        .header_every = 16,                      \
+        .truncate = false,                       \
+    }
+
+typedef struct sd_contig_log_s *sd_contig_log_handle_t;
+
+/**
+ * @description: 打开（不存在或大小不对时重新预分配）连续日志文件
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG / ESP_ERR_NO_MEM /
+ *               ESP_ERR_INVALID_STATE（卷上没有足够大的连续空闲空间）/ ESP_FAIL（FatFs错误）
+ * @param {sd_contig_log_config_t} *config 配置
+ * @param {sd_contig_log_handle_t} *out 句柄
+ */
+esp_err_t sd_contig_log_open(const sd_contig_log_config_t *config, sd_contig_log_handle_t *out);
+
+/**
+ * @description: 追加数据，暂存缓冲区写满时直接写扇区
+ * @return       ESP_OK / ESP_ERR_INVALID_SIZE（超出容量，什么都不写）/ 写扇区的错误
+ */
+esp_err_t sd_contig_log_append(sd_contig_log_handle_t log, const void *data, size_t len);
+
+/**
+ * @description: 写出暂存缓冲区中的数据（末尾不满一个扇区的部分补零）并更新头，返回时数据已在卡上
+ */
+esp_err_t sd_contig_log_sync(sd_contig_log_handle_t log);
+
+/**
+ * @description: 已写入的字节数（包括还在暂存缓冲区中的）
+ */
+uint64_t sd_contig_log_size(sd_contig_log_handle_t log);
+
+/**
+ * @description: sync 后释放句柄
+ * @return       sync 的结果
+ */
+esp_err_t sd_contig_log_close(sd_contig_log_handle_t log);
+
+#endif /* __SD_CONTIG_LOG_H__ */
@@ -0,0 +1,54 @@
+#ifndef __SD_CONTIG_LOG_HEADER_H__
+#define __SD_CONTIG_LOG_HEADER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/*
+ * 连续日志文件的格式，ESP32和PC共用：
+ *
+ *   扇区0、扇区1  头（两份交替更新，取CRC正确且 generation 较大的一份，写到一半掉电也有一份可用）
+ *   扇区2 ...     数据，有效长度为头中的 fill
+ *
+ * 文件在FAT中的大小始终是预分配的大小，PC上读取时按头中的 fill 截取数据即可。
+ */
+
+#define SD_CONTIG_LOG_MAGIC 0x474F4C43 // "CLOG"
+#define SD_CONTIG_LOG_VERSION 1
+#define SD_CONTIG_LOG_SECTOR_SIZE 512
+#define SD_CONTIG_LOG_HEADER_SECTORS 2
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_sectors; /*!< 数据区之前的扇区数 */
+    uint64_t capacity;       /*!< 数据区字节数 */
+    uint64_t fill;           /*!< 有效数据字节数 */
+    uint32_t generation;     /*!< 每写一次头加一，决定写到哪个头扇区 */
+    uint32_t crc;            /*!< 以上字段的CRC32 */
+} sd_contig_log_header_t;
+
+/**
+ * @description: 填好头的CRC，写入一个扇区大小的缓冲区（其余字节清零）
+ * @param {sd_contig_log_header_t} *header 头，会更新其中的 crc
+ * @param {uint8_t} *sector 输出，SD_CONTIG_LOG_SECTOR_SIZE 字节
+ */
+void sd_contig_log_header_encode(sd_contig_log_header_t *header, uint8_t *sector);
+
+/**
+ * @description: 检查一个头扇区
+ * @return       头有效返回true
+ */
+bool sd_contig_log_header_decode(const uint8_t *sector, sd_contig_log_header_t *header);
+
+/**
+ * @description: 从两个头扇区中选出有效且较新的一份
+ * @return       ESP_OK / ESP_ERR_NOT_FOUND（两份都无效）
+ * @param {uint8_t} *sectors 前 SD_CONTIG_LOG_HEADER_SECTORS 个扇区
+ */
+esp_err_t sd_contig_log_header_pick(const uint8_t *sectors, sd_contig_log_header_t *header);
+
+#endif /* __SD_CONTIG_LOG_HEADER_H__ */
@@ -0,0 +1,365 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sd_contig_log.h"
+#include "ff.h"
+#include "diskio_sdmmc.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "contig_log";
+
+#define SECTOR SD_CONTIG_LOG_SECTOR_SIZE
+
+#if FF_MAX_SS == FF_MIN_SS
+#define CONTIG_FS_SECTOR_SIZE(fs) FF_MAX_SS
+#else
+#define CONTIG_FS_SECTOR_SIZE(fs) ((fs)->ssize)
+#endif
+
+struct sd_contig_log_s
+{
+    sdmmc_card_t *card;
+    size_t first_sector;    /*!< 文件第一个扇区（头扇区0）在卡上的扇区号 */
+    uint32_t buffer_sectors;
+    uint32_t header_every;
+    uint32_t writes_since_header;
+    uint8_t *stage;         /*!< 暂存缓冲区，对应数据区从 stage_sector 开始的扇区 */
+    size_t stage_sector;
+    size_t stage_len;
+    uint8_t *header_buf;    /*!< 读写头扇区用，两个扇区大小 */
+    sd_contig_log_header_t header;
+};
+
+static esp_err_t contig_write_header(sd_contig_log_handle_t log)
+{
+    log->header.fill = (uint64_t)log->stage_sector * SECTOR + log->stage_len;
+    log->header.generation++;
+    sd_contig_log_header_encode(&log->header, log->header_buf);
+    // 两个头扇区轮流写，写到一半掉电时另一个扇区仍是上一次的完整头
+    esp_err_t ret = sdmmc_write_sectors(log->card, log->header_buf,
+                                        log->first_sector + (log->header.generation & 1), 1);
+    log->writes_since_header = 0;
+    return ret;
+}
+
+static void contig_free(sd_contig_log_handle_t log)
+{
+    heap_caps_free(log->stage);
+    heap_caps_free(log->header_buf);
+    free(log);
+}
+
+// 暂存缓冲区写满后整块写出
+static esp_err_t contig_write_stage(sd_contig_log_handle_t log)
+{
+    esp_err_t ret = sdmmc_write_sectors(log->card, log->stage,
+                                        log->first_sector + SD_CONTIG_LOG_HEADER_SECTORS + log->stage_sector,
+                                        log->buffer_sectors);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    log->stage_sector += log->buffer_sectors;
+    log->stage_len = 0;
+    if (log->header_every && ++log->writes_since_header >= log->header_every)
+    {
+        ret = contig_write_header(log);
+    }
+    return ret;
+}
+
+/**
+ * @description: 把文件扩展到 size 字节。有 f_expand 时一次分配连续的簇，
+ *               否则靠 f_lseek 越过文件末尾逐簇分配，空卷上通常也是连续的，由调用者检查
+ */
+static FRESULT contig_expand(FIL *fil, FSIZE_t size)
+{
+#if FF_USE_EXPAND
+    return f_expand(fil, size, 1);
+#else
+    FRESULT fr = f_lseek(fil, size);
+    if (fr == FR_OK && f_tell(fil) != size)
+    {
+        fr = FR_DENIED; // 卷已满
+    }
+    return fr;
+#endif
+}
+
+/**
+ * @description: 检查文件的簇链是否连续
+ * @return       连续返回true
+ */
+static bool contig_is_contiguous(FIL *fil, FSIZE_t size)
+{
+    const DWORD sclust = fil->obj.sclust;
+    const FSIZE_t cluster_bytes = (FSIZE_t)fil->obj.fs->csize * SECTOR;
+    // f_lseek 向后seek时从当前簇继续找，整个循环只遍历一遍簇链；
+    // 偏移取簇边界，FatFs 不会读数据扇区，此时 fil->clust 是偏移前一个字节所在的簇
+    for (DWORD i = 1;; i++)
+    {
+        FSIZE_t ofs = (FSIZE_t)i * cluster_bytes;
+        if (ofs > size)
+        {
+            ofs = size;
+        }
+        if (f_lseek(fil, ofs) != FR_OK || fil->clust != sclust + i - 1)
+        {
+            return false;
+        }
+        if (ofs == size)
+        {
+            return true;
+        }
+    }
+}
+
+/**
+ * @description: 打开或预分配文件，得到文件第一个扇区在卡上的扇区号
+ * @param {bool} *fresh 文件是新分配的时置为true
+ */
+static esp_err_t contig_allocate(const sd_contig_log_config_t *config, FSIZE_t size, size_t *first_sector, bool *fresh)
+{
+    BYTE pdrv = ff_diskio_get_pdrv_card(config->card);
+    if (pdrv == 0xFF)
+    {
+        ESP_LOGE(TAG, "card is not mounted");
+        return ESP_ERR_INVALID_STATE;
+    }
+    char path[128];
+    if (snprintf(path, sizeof(path), "%u:/%s", pdrv, config->path) >= (int)sizeof(path))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    FIL *fil = calloc(1, sizeof(FIL));
+    if (!fil)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_OK;
+    FRESULT fr = f_open(fil, path, FA_READ | FA_WRITE | FA_OPEN_ALWAYS);
+    if (fr != FR_OK)
+    {
+        ESP_LOGE(TAG, "f_open %s failed (%d)", path, fr);
+        free(fil);
+        return ESP_FAIL;
+    }
+    FATFS *fs = fil->obj.fs;
+    if (CONTIG_FS_SECTOR_SIZE(fs) != SECTOR)
+    {
+        ESP_LOGE(TAG, "unsupported sector size %u", (unsigned)CONTIG_FS_SECTOR_SIZE(fs));
+        ret = ESP_ERR_NOT_SUPPORTED;
+        goto done;
+    }
+
+    if (f_size(fil) != size)
+    {
+        *fresh = true;
+        fr = f_lseek(fil, 0);
+        if (fr == FR_OK)
+        {
+            fr = f_truncate(fil);
+        }
+        if (fr == FR_OK)
+        {
+            fr = contig_expand(fil, size);
+        }
+        if (fr == FR_DENIED)
+        {
+            ESP_LOGE(TAG, "no contiguous free space for %llu bytes", (unsigned long long)size);
+            ret = ESP_ERR_INVALID_STATE;
+            goto done;
+        }
+        if (fr != FR_OK)
+        {
+            ESP_LOGE(TAG, "allocate %s failed (%d)", path, fr);
+            ret = ESP_FAIL;
+            goto done;
+        }
+        // 让目录项中的文件大小先落盘，之后不再经过FatFs
+        fr = f_sync(fil);
+        if (fr != FR_OK)
+        {
+            ret = ESP_FAIL;
+            goto done;
+        }
+    }
+
+    if (fil->obj.sclust < 2 || !contig_is_contiguous(fil, size))
+    {
+        // 空闲空间碎片化时分配出的簇链不连续，删掉文件，以免下次打开时直接沿用
+        ESP_LOGE(TAG, "%s is fragmented, reformat the card or free space", path);
+        f_close(fil);
+        f_unlink(path);
+        free(fil);
+        return ESP_ERR_INVALID_STATE;
+    }
+    *first_sector = fs->database + (LBA_t)fs->csize * (fil->obj.sclust - 2);
+
+done:
+    fr = f_close(fil);
+    if (ret == ESP_OK && fr != FR_OK)
+    {
+        ret = ESP_FAIL;
+    }
+    free(fil);
+    return ret;
+}
+
+esp_err_t sd_contig_log_open(const sd_contig_log_config_t *config, sd_contig_log_handle_t *out)
+{
+    if (!config || !config->card || !config->path || !out || config->capacity == 0 || config->buffer_sectors == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint64_t capacity = (config->capacity + SECTOR - 1) / SECTOR * SECTOR;
+    if (capacity / SECTOR + SD_CONTIG_LOG_HEADER_SECTORS > (uint64_t)config->card->csd.capacity)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    sd_contig_log_handle_t log = calloc(1, sizeof(struct sd_contig_log_s));
+    if (!log)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    log->card = config->card;
+    log->buffer_sectors = config->buffer_sectors;
+    log->header_every = config->header_every;
+    log->stage = heap_caps_aligned_alloc(4, config->buffer_sectors * SECTOR, MALLOC_CAP_DMA);
+    log->header_buf = heap_caps_aligned_alloc(4, SD_CONTIG_LOG_HEADER_SECTORS * SECTOR, MALLOC_CAP_DMA);
+    if (!log->stage || !log->header_buf)
+    {
+        ESP_LOGE(TAG, "no memory for %u sector buffer", (unsigned)config->buffer_sectors);
+        contig_free(log);
+        return ESP_ERR_NO_MEM;
+    }
+
+    bool fresh = config->truncate;
+    esp_err_t ret = contig_allocate(config, SD_CONTIG_LOG_HEADER_SECTORS * SECTOR + capacity, &log->first_sector, &fresh);
+    if (ret == ESP_OK)
+    {
+        ret = sdmmc_read_sectors(log->card, log->header_buf, log->first_sector, SD_CONTIG_LOG_HEADER_SECTORS);
+    }
+    if (ret != ESP_OK)
+    {
+        contig_free(log);
+        return ret;
+    }
+
+    sd_contig_log_header_t old;
+    bool have_old = sd_contig_log_header_pick(log->header_buf, &old) == ESP_OK;
+    if (have_old && !fresh && old.capacity == capacity)
+    {
+        // 从上次的长度处继续，末尾不满一个扇区的部分读回暂存缓冲区
+        log->header = old;
+        log->stage_sector = old.fill / SECTOR;
+        log->stage_len = old.fill % SECTOR;
+        if (log->stage_len)
+        {
+            ret = sdmmc_read_sectors(log->card, log->stage,
+                                     log->first_sector + SD_CONTIG_LOG_HEADER_SECTORS + log->stage_sector, 1);
+        }
+        ESP_LOGI(TAG, "resume at %llu bytes", (unsigned long long)old.fill);
+    }
+    else
+    {
+        log->header = (sd_contig_log_header_t){
+            .magic = SD_CONTIG_LOG_MAGIC,
+            .version = SD_CONTIG_LOG_VERSION,
+            .header_sectors = SD_CONTIG_LOG_HEADER_SECTORS,
+            .capacity = capacity,
+            // 接着旧头的 generation 往下写，保证新头比残留的旧头新
+            .generation = have_old ? old.generation : 0,
+        };
+        ret = contig_write_header(log);
+    }
+    if (ret != ESP_OK)
+    {
+        contig_free(log);
+        return ret;
+    }
+    ESP_LOGI(TAG, "%s: %llu bytes at sector %u", config->path, (unsigned long long)capacity, (unsigned)log->first_sector);
+    *out = log;
+    return ESP_OK;
+}
+
+esp_err_t sd_contig_log_append(sd_contig_log_handle_t log, const void *data, size_t len)
+{
+    const size_t stage_size = log->buffer_sectors * SECTOR;
+    if (sd_contig_log_size(log) + len > log->header.capacity)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t *p = data;
+    while (len)
+    {
+        // 上次写出失败时缓冲区仍是满的，先重试
+        if (log->stage_len == stage_size)
+        {
+            esp_err_t ret = contig_write_stage(log);
+            if (ret != ESP_OK)
+            {
+                return ret;
+            }
+        }
+        size_t n = stage_size - log->stage_len;
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(log->stage + log->stage_len, p, n);
+        log->stage_len += n;
+        p += n;
+        len -= n;
+        if (log->stage_len == stage_size)
+        {
+            esp_err_t ret = contig_write_stage(log);
+            if (ret != ESP_OK)
+            {
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t sd_contig_log_sync(sd_contig_log_handle_t log)
+{
+    esp_err_t ret = ESP_OK;
+    if (log->stage_len == log->buffer_sectors * SECTOR)
+    {
+        ret = contig_write_stage(log);
+    }
+    else if (log->stage_len)
+    {
+        // 不满的部分补零写出，数据留在缓冲区中，写满时在同一位置再写一次
+        size_t sectors = (log->stage_len + SECTOR - 1) / SECTOR;
+        memset(log->stage + log->stage_len, 0, sectors * SECTOR - log->stage_len);
+        ret = sdmmc_write_sectors(log->card, log->stage,
+                                  log->first_sector + SD_CONTIG_LOG_HEADER_SECTORS + log->stage_sector, sectors);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = contig_write_header(log);
+    }
+    return ret;
+}
+
+uint64_t sd_contig_log_size(sd_contig_log_handle_t log)
+{
+    return (uint64_t)log->stage_sector * SECTOR + log->stage_len;
+}
+
+esp_err_t sd_contig_log_close(sd_contig_log_handle_t log)
+{
+    if (!log)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = sd_contig_log_sync(log);
+    contig_free(log);
+    return ret;
+}
@@ -0,0 +1,41 @@
+#include <string.h>
+#include "sd_contig_log_header.h"
+#include "esp_rom_crc.h"
+
+void sd_contig_log_header_encode(sd_contig_log_header_t *header, uint8_t *sector)
+{
+    header->crc = esp_rom_crc32_le(0, (const uint8_t *)header, offsetof(sd_contig_log_header_t, crc));
+    memset(sector, 0, SD_CONTIG_LOG_SECTOR_SIZE);
+    memcpy(sector, header, sizeof(*header));
+}
+
+bool sd_contig_log_header_decode(const uint8_t *sector, sd_contig_log_header_t *header)
+{
+    memcpy(header, sector, sizeof(*header));
+    return header->magic == SD_CONTIG_LOG_MAGIC &&
+           header->version == SD_CONTIG_LOG_VERSION &&
+           header->header_sectors == SD_CONTIG_LOG_HEADER_SECTORS &&
+           header->fill <= header->capacity &&
+           header->crc == esp_rom_crc32_le(0, (const uint8_t *)header, offsetof(sd_contig_log_header_t, crc));
+}
+
+esp_err_t sd_contig_log_header_pick(const uint8_t *sectors, sd_contig_log_header_t *header)
+{
+    sd_contig_log_header_t h[2];
+    bool ok0 = sd_contig_log_header_decode(sectors, &h[0]);
+    bool ok1 = sd_contig_log_header_decode(sectors + SD_CONTIG_LOG_SECTOR_SIZE, &h[1]);
+    if (!ok0 && !ok1)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (ok0 && ok1)
+    {
+        // generation 回绕时用有符号差比较
+        *header = (int32_t)(h[1].generation - h[0].generation) > 0 ? h[1] : h[0];
+    }
+    else
+    {
+        *header = ok0 ? h[0] : h[1];
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,122 @@
+#ifndef __SD_JOURNAL_H__
+#define __SD_JOURNAL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * 掉电安全的日志追加。文件由定长块组成，块 i 写在偏移 i * block_size 处：
+ *
+ *   块头（sd_journal_block_header_t）：魔数、文件随机数 nonce、块序号（等于块号）、记录数、CRC32
+ *   记录：2字节长度 + 数据，记录不跨块
+ *
+ * sd_journal_commit() 把当前块（未满也一样）写出并 fsync 后返回，此后这些记录不会再丢：
+ * 提交过的块不会再被改写，下一条记录从新块开始。
+ *
+ * 打开时用二分查找定位最后一个有效块（有效块总是文件开头连续的一段），多GB的文件也只需读 O(log n) 个块。
+ * 未 fsync 的块数最多 sync_every 个，掉电后只有这个范围内可能出现空洞，打开时再检查尾部前后
+ * 各 sync_every 个块：尾部退到第一个空洞处，之后残留的块作废，保证"有效块连续"在下次打开时仍然成立，
+ * 读到的记录顺序也与写入顺序一致。
+ */
+
+#define SD_JOURNAL_MAGIC 0x314A4453 // "SDJ1"
+#define SD_JOURNAL_RECORD_HEADER 2  // 记录长度字段
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t nonce;   /*!< 创建日志时生成，区分同一个文件中上一次日志残留的块 */
+    uint32_t seq;     /*!< 块号 */
+    uint16_t used;    /*!< 块头之后已用的字节数 */
+    uint16_t records; /*!< 记录数 */
+    uint32_t crc;     /*!< 块头（不含本字段）和已用部分的CRC32 */
+} sd_journal_block_header_t;
+
+typedef struct sd_journal_io_s sd_journal_io_t;
+
+/**
+ * @brief 日志文件的读写接口，测试时可以换成注入故障的实现
+ */
+struct sd_journal_io_s
+{
+    esp_err_t (*read)(sd_journal_io_t *io, uint64_t offset, void *buf, size_t len);
+    esp_err_t (*write)(sd_journal_io_t *io, uint64_t offset, const void *buf, size_t len);
+    esp_err_t (*sync)(sd_journal_io_t *io);
+    esp_err_t (*size)(sd_journal_io_t *io, uint64_t *size);
+    esp_err_t (*del)(sd_journal_io_t *io); /*!< 关闭并释放 */
+};
+
+typedef struct
+{
+    uint32_t block_size; /*!< 块大小，512的整数倍，不超过64 KiB */
+    uint32_t sync_every; /*!< 最多这么多块未 fsync，至少1，越大打开时多读的块越多 */
+    uint32_t nonce;      /*!< 新建日志时使用的随机数，0表示自动生成 */
+} sd_journal_config_t;
+
+#define SD_JOURNAL_DEFAULT_CONFIG() \
+    {                               \
+        .block_size = 4096,         \
+        .sync_every = 16,           \
+        .nonce = 0,                 \
+    }
+
+typedef struct
+{
+    uint32_t blocks;          /*!< 有效块数（下一块写在这里） */
+    uint32_t mount_reads;     /*!< 打开时读的块数 */
+    uint32_t stale_cleared;   /*!< 打开时作废的残留块数 */
+    uint32_t nonce;
+    bool created;             /*!< 打开时新建了日志 */
+} sd_journal_info_t;
+
+typedef struct sd_journal_s *sd_journal_handle_t;
+
+// 读取记录时每条记录调用一次，返回false停止
+typedef bool (*sd_journal_record_cb_t)(void *ctx, const void *data, size_t len);
+
+/**
+ * @description: 打开日志并恢复尾部
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG / ESP_ERR_NO_MEM / io 的错误
+ * @param {sd_journal_io_t} *io 读写接口，关闭日志时一起释放
+ * @param {sd_journal_config_t} *config 配置，同一个文件每次打开的 block_size 必须相同
+ * @param {sd_journal_handle_t} *out 句柄
+ */
+esp_err_t sd_journal_open(sd_journal_io_t *io, const sd_journal_config_t *config, sd_journal_handle_t *out);
+
+/**
+ * @description: 追加一条记录。只放进当前块，块写满时写出，sd_journal_commit() 之前掉电可能丢失
+ * @return       ESP_OK / ESP_ERR_INVALID_SIZE（记录放不进一个块）/ io 的错误
+ */
+esp_err_t sd_journal_append(sd_journal_handle_t journal, const void *data, size_t len);
+
+/**
+ * @description: 写出当前块并 fsync，返回 ESP_OK 后之前追加的所有记录都已落盘
+ */
+esp_err_t sd_journal_commit(sd_journal_handle_t journal);
+
+/**
+ * @description: 从头依次读出已写出的记录（当前块中未写出的不包括），损坏的块跳过
+ * @return       ESP_OK / io 的错误
+ */
+esp_err_t sd_journal_read(sd_journal_handle_t journal, sd_journal_record_cb_t cb, void *ctx);
+
+/**
+ * @description: 读取日志状态
+ */
+void sd_journal_get_info(sd_journal_handle_t journal, sd_journal_info_t *info);
+
+/**
+ * @description: 提交剩余记录，释放句柄和读写接口
+ * @return       sd_journal_commit() 的结果
+ */
+esp_err_t sd_journal_close(sd_journal_handle_t journal);
+
+/**
+ * @description: 基于 POSIX pread/pwrite 的读写接口，文件不存在时创建
+ * @return       读写接口，打开文件失败返回NULL
+ */
+sd_journal_io_t *sd_journal_io_new_posix(const char *path);
+
+#endif /* __SD_JOURNAL_H__ */
@@ -0,0 +1,342 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sd_journal.h"
+#include "esp_rom_crc.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_system.h"
+#else
+#include <time.h>
+#endif
+
+#define HEADER_SIZE sizeof(sd_journal_block_header_t)
+
+struct sd_journal_s
+{
+    sd_journal_io_t *io;
+    uint32_t block_size;
+    uint32_t sync_every;
+    uint32_t nonce;
+    uint32_t tail;      /*!< 当前块的块号，之前的块都已写出 */
+    uint32_t unsynced;  /*!< 上次 fsync 之后写出的块数 */
+    uint16_t used;      /*!< 当前块已用字节数 */
+    uint16_t records;
+    uint8_t *block;     /*!< 当前块 */
+    uint8_t *scratch;   /*!< 读块用 */
+    sd_journal_info_t info;
+};
+
+static uint32_t journal_block_crc(const uint8_t *block, const sd_journal_block_header_t *h)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)h, offsetof(sd_journal_block_header_t, crc));
+    return esp_rom_crc32_le(crc, (const uint8_t *)block + HEADER_SIZE, h->used);
+}
+
+/**
+ * @description: 检查 scratch 中的块，块属于本日志（nonce相同）、块号正确且CRC正确才算有效
+ * @return       有效返回true
+ */
+static bool journal_check_block(sd_journal_handle_t j, uint32_t index, sd_journal_block_header_t *h)
+{
+    memcpy(h, j->scratch, HEADER_SIZE);
+    return h->magic == SD_JOURNAL_MAGIC && h->nonce == j->nonce && h->seq == index &&
+           h->used <= j->block_size - HEADER_SIZE && journal_block_crc(j->scratch, h) == h->crc;
+}
+
+/**
+ * @description: 把块读入 scratch 并检查
+ * @return       ESP_OK / ESP_ERR_NOT_FOUND（无效）/ io 的错误
+ */
+static esp_err_t journal_read_block(sd_journal_handle_t j, uint32_t index, sd_journal_block_header_t *h)
+{
+    esp_err_t ret = j->io->read(j->io, (uint64_t)index * j->block_size, j->scratch, j->block_size);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    return journal_check_block(j, index, h) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t journal_sync(sd_journal_handle_t j)
+{
+    esp_err_t ret = j->io->sync(j->io);
+    if (ret == ESP_OK)
+    {
+        j->unsynced = 0;
+    }
+    return ret;
+}
+
+// 写出当前块，写失败时保留当前块，下次可以重试
+static esp_err_t journal_write_block(sd_journal_handle_t j)
+{
+    // 未 fsync 的块不能超过 sync_every 个，恢复时只检查这么大的范围；上次 fsync 失败时先重试
+    if (j->unsynced >= j->sync_every)
+    {
+        esp_err_t ret = journal_sync(j);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+    sd_journal_block_header_t h = {
+        .magic = SD_JOURNAL_MAGIC,
+        .nonce = j->nonce,
+        .seq = j->tail,
+        .used = j->used,
+        .records = j->records,
+    };
+    memset(j->block + HEADER_SIZE + j->used, 0, j->block_size - HEADER_SIZE - j->used);
+    h.crc = journal_block_crc(j->block, &h);
+    memcpy(j->block, &h, HEADER_SIZE);
+    esp_err_t ret = j->io->write(j->io, (uint64_t)j->tail * j->block_size, j->block, j->block_size);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    j->tail++;
+    j->used = 0;
+    j->records = 0;
+    j->unsynced++;
+    return ESP_OK;
+}
+
+/**
+ * @description: 恢复尾部。块0无效时新建日志；否则二分查找最后一个有效块，
+ *               再检查它前后各 sync_every 个块
+ */
+static esp_err_t journal_recover(sd_journal_handle_t j, uint32_t config_nonce)
+{
+    uint64_t size;
+    esp_err_t ret = j->io->size(j->io, &size);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    uint64_t n64 = size / j->block_size;
+    uint32_t n = n64 > UINT32_MAX ? UINT32_MAX : (uint32_t)n64;
+
+    sd_journal_block_header_t h;
+    ret = ESP_ERR_NOT_FOUND;
+    if (n > 0)
+    {
+        ret = j->io->read(j->io, 0, j->scratch, j->block_size);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        j->info.mount_reads++;
+        // 日志的 nonce 以块0为准
+        memcpy(&h, j->scratch, HEADER_SIZE);
+        j->nonce = h.nonce;
+        ret = journal_check_block(j, 0, &h) ? ESP_OK : ESP_ERR_NOT_FOUND;
+    }
+    if (ret == ESP_ERR_NOT_FOUND)
+    {
+        // 块0都没写完整说明从未提交过，换一个 nonce，文件中旧日志的块全部视为无效
+        j->nonce = config_nonce;
+        if (j->nonce == 0)
+        {
+#ifdef ESP_PLATFORM
+            j->nonce = esp_random();
+#else
+            j->nonce = (uint32_t)time(NULL) ^ (uint32_t)(uintptr_t)j ^ (uint32_t)clock();
+#endif
+        }
+        j->tail = 0;
+        j->info.created = true;
+        return ESP_OK;
+    }
+
+    // lo 总是有效，hi 总是无效（n 视为无效）
+    uint32_t lo = 0;
+    uint32_t hi = n;
+    while (hi - lo > 1)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        ret = journal_read_block(j, mid, &h);
+        j->info.mount_reads++;
+        if (ret == ESP_OK)
+        {
+            lo = mid;
+        }
+        else if (ret == ESP_ERR_NOT_FOUND)
+        {
+            hi = mid;
+        }
+        else
+        {
+            return ret;
+        }
+    }
+
+    // 掉电前未 fsync 的块（最多 sync_every 个）可能只有一部分落盘，在二分查找的结果附近留下空洞。
+    // 尾部退到其中第一个无效块处，保证尾部之前全部有效，这是下次二分查找的前提；
+    // 空洞之后残留的有效块都没有提交过，作废掉，否则新写的块之后会读到这些旧记录
+    uint32_t tail = hi;
+    for (uint32_t i = hi > j->sync_every ? hi - j->sync_every : 1; i < hi; i++)
+    {
+        ret = journal_read_block(j, i, &h);
+        j->info.mount_reads++;
+        if (ret == ESP_ERR_NOT_FOUND)
+        {
+            tail = i;
+            break;
+        }
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+    j->tail = tail;
+
+    bool cleared = false;
+    for (uint32_t i = tail + 1; i <= hi + j->sync_every && i < n; i++)
+    {
+        ret = journal_read_block(j, i, &h);
+        j->info.mount_reads++;
+        if (ret == ESP_ERR_NOT_FOUND)
+        {
+            continue;
+        }
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        memset(j->scratch, 0, HEADER_SIZE);
+        ret = j->io->write(j->io, (uint64_t)i * j->block_size, j->scratch, HEADER_SIZE);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        j->info.stale_cleared++;
+        cleared = true;
+    }
+    return cleared ? journal_sync(j) : ESP_OK;
+}
+
+esp_err_t sd_journal_open(sd_journal_io_t *io, const sd_journal_config_t *config, sd_journal_handle_t *out)
+{
+    if (!io || !config || !out || config->block_size == 0 || config->block_size % 512 ||
+        config->block_size > 65536 || config->sync_every == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sd_journal_handle_t j = calloc(1, sizeof(struct sd_journal_s));
+    if (!j)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    j->io = io;
+    j->block_size = config->block_size;
+    j->sync_every = config->sync_every;
+    j->block = malloc(config->block_size);
+    j->scratch = malloc(config->block_size);
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (j->block && j->scratch)
+    {
+        ret = journal_recover(j, config->nonce);
+    }
+    if (ret != ESP_OK)
+    {
+        free(j->block);
+        free(j->scratch);
+        free(j);
+        return ret;
+    }
+    *out = j;
+    return ESP_OK;
+}
+
+esp_err_t sd_journal_append(sd_journal_handle_t journal, const void *data, size_t len)
+{
+    const size_t capacity = journal->block_size - HEADER_SIZE;
+    const size_t need = SD_JOURNAL_RECORD_HEADER + len;
+    if (need > capacity || len > UINT16_MAX)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (journal->used + need > capacity)
+    {
+        esp_err_t ret = journal_write_block(journal);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+    uint8_t *p = journal->block + HEADER_SIZE + journal->used;
+    p[0] = len & 0xFF;
+    p[1] = len >> 8;
+    memcpy(p + SD_JOURNAL_RECORD_HEADER, data, len);
+    journal->used += need;
+    journal->records++;
+    return ESP_OK;
+}
+
+esp_err_t sd_journal_commit(sd_journal_handle_t journal)
+{
+    if (journal->records)
+    {
+        esp_err_t ret = journal_write_block(journal);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+    }
+    return journal->unsynced ? journal_sync(journal) : ESP_OK;
+}
+
+esp_err_t sd_journal_read(sd_journal_handle_t journal, sd_journal_record_cb_t cb, void *ctx)
+{
+    for (uint32_t i = 0; i < journal->tail; i++)
+    {
+        sd_journal_block_header_t h;
+        esp_err_t ret = journal_read_block(journal, i, &h);
+        if (ret == ESP_ERR_NOT_FOUND)
+        {
+            continue; // 掉电时未 fsync 的块，其中没有已提交的记录
+        }
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        const uint8_t *p = journal->scratch + HEADER_SIZE;
+        const uint8_t *end = p + h.used;
+        for (uint16_t r = 0; r < h.records && p + SD_JOURNAL_RECORD_HEADER <= end; r++)
+        {
+            size_t len = p[0] | (p[1] << 8);
+            p += SD_JOURNAL_RECORD_HEADER;
+            if (p + len > end)
+            {
+                break;
+            }
+            if (!cb(ctx, p, len))
+            {
+                return ESP_OK;
+            }
+            p += len;
+        }
+    }
+    return ESP_OK;
+}
+
+void sd_journal_get_info(sd_journal_handle_t journal, sd_journal_info_t *info)
+{
+    *info = journal->info;
+    info->blocks = journal->tail;
+    info->nonce = journal->nonce;
+}
+
+esp_err_t sd_journal_close(sd_journal_handle_t journal)
+{
+    if (!journal)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = sd_journal_commit(journal);
+    journal->io->del(journal->io);
+    free(journal->block);
+    free(journal->scratch);
+    free(journal);
+    return ret;
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "sd_journal.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+typedef struct
+{
+    sd_journal_io_t parent;
+    int fd;
+} journal_posix_t;
+
+static esp_err_t posix_read(sd_journal_io_t *io, uint64_t offset, void *buf, size_t len)
+{
+    journal_posix_t *p = __containerof(io, journal_posix_t, parent);
+    uint8_t *dst = buf;
+    while (len)
+    {
+        ssize_t n = pread(p->fd, dst, len, (off_t)offset);
+        if (n < 0)
+        {
+            return ESP_FAIL;
+        }
+        if (n == 0)
+        {
+            // 文件末尾之后按全零处理，二分查找会把它当作无效块
+            memset(dst, 0, len);
+            return ESP_OK;
+        }
+        dst += n;
+        offset += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t posix_write(sd_journal_io_t *io, uint64_t offset, const void *buf, size_t len)
+{
+    journal_posix_t *p = __containerof(io, journal_posix_t, parent);
+    const uint8_t *src = buf;
+    while (len)
+    {
+        ssize_t n = pwrite(p->fd, src, len, (off_t)offset);
+        if (n <= 0)
+        {
+            return ESP_FAIL;
+        }
+        src += n;
+        offset += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t posix_sync(sd_journal_io_t *io)
+{
+    journal_posix_t *p = __containerof(io, journal_posix_t, parent);
+    return fsync(p->fd) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t posix_size(sd_journal_io_t *io, uint64_t *size)
+{
+    journal_posix_t *p = __containerof(io, journal_posix_t, parent);
+    struct stat st;
+    if (fstat(p->fd, &st) != 0)
+    {
+        return ESP_FAIL;
+    }
+    *size = st.st_size;
+    return ESP_OK;
+}
+
+static esp_err_t posix_del(sd_journal_io_t *io)
+{
+    journal_posix_t *p = __containerof(io, journal_posix_t, parent);
+    int ret = close(p->fd);
+    free(p);
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+sd_journal_io_t *sd_journal_io_new_posix(const char *path)
+{
+    journal_posix_t *p = calloc(1, sizeof(journal_posix_t));
+    if (!p)
+    {
+        return NULL;
+    }
+    p->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (p->fd < 0)
+    {
+        free(p);
+        return NULL;
+    }
+    p->parent.read = posix_read;
+    p->parent.write = posix_write;
+    p->parent.sync = posix_sync;
+    p->parent.size = posix_size;
+    p->parent.del = posix_del;
+    return &p->parent;
+}
@@ -0,0 +1,120 @@
+#ifndef __TSLOG_H__
+#define __TSLOG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * 传感器时间序列的二进制压缩格式，ESP32上编码、PC上解码（host/tslog_dump），两边共用这份代码。
+ *
+ * 数据由固定 TSLOG_BLOCK_SIZE 字节的块组成，块与扇区对齐，每块可以单独解码：
+ *
+ *   块头（tslog_block_header_t，小端）：块序号、本块第一个和最后一个样本的时间、样本数、CRC32
+ *   样本：第一个样本的时间就是块头中的 t_min，各通道值直接写入；
+ *         之后每个样本写时间间隔的差值（delta-of-delta，固定采样率时为0）和各通道与上一样本的差值，
+ *         全部用 zigzag + varint 编码，变化缓慢的数据每个值只占1字节
+ *   块尾补零
+ *
+ * 块头中有时间范围，按时间查找时只需二分读块头（tslog_seek），不用扫描整个文件。
+ */
+
+#define TSLOG_MAGIC 0x314C5354 // "TSL1"
+#define TSLOG_VERSION 1
+#define TSLOG_BLOCK_SIZE 512
+#define TSLOG_MAX_CHANNELS 8
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t seq;         /*!< 块序号，依次加一 */
+    uint64_t t_min;       /*!< 第一个样本的时间 */
+    uint64_t t_max;       /*!< 最后一个样本的时间 */
+    uint16_t count;       /*!< 样本数 */
+    uint16_t payload_len; /*!< 编码后的样本字节数 */
+    uint8_t channels;     /*!< 每个样本的通道数 */
+    uint8_t version;
+    uint16_t reserved;
+    uint32_t crc;         /*!< 块头（不含本字段）和样本数据的CRC32 */
+} tslog_block_header_t;
+
+#define TSLOG_PAYLOAD_SIZE (TSLOG_BLOCK_SIZE - sizeof(tslog_block_header_t))
+
+// 输出一个写满（或 flush 时未满）的块，block 总是 TSLOG_BLOCK_SIZE 字节
+typedef esp_err_t (*tslog_write_fn_t)(void *ctx, const uint8_t *block);
+
+// 解码时每个样本调用一次，返回false停止解码
+typedef bool (*tslog_sample_cb_t)(void *ctx, uint64_t t, const int32_t *values, uint8_t channels);
+
+// 按块号读取一个块，tslog_seek 使用
+typedef esp_err_t (*tslog_read_fn_t)(void *ctx, uint32_t index, uint8_t *block);
+
+// 编码器状态，不需要动态内存，可以放在栈上或静态变量中
+typedef struct
+{
+    uint8_t block[TSLOG_BLOCK_SIZE];
+    size_t len;                         /*!< 当前块已用的样本字节数 */
+    uint16_t count;
+    uint8_t channels;
+    uint32_t seq;
+    uint64_t t_prev;
+    int64_t delta_prev;
+    int32_t prev[TSLOG_MAX_CHANNELS];
+    tslog_write_fn_t write;
+    void *ctx;
+    uint32_t blocks;                    /*!< 已输出的块数 */
+    uint64_t samples;                   /*!< 已编码的样本数 */
+} tslog_encoder_t;
+
+/**
+ * @description: 初始化编码器
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG
+ * @param {tslog_encoder_t} *enc 编码器
+ * @param {uint8_t} channels 每个样本的通道数，1 ~ TSLOG_MAX_CHANNELS
+ * @param {uint32_t} first_seq 第一个块的序号
+ * @param {tslog_write_fn_t} write 块输出函数
+ * @param {void} *ctx 传给 write
+ */
+esp_err_t tslog_encoder_init(tslog_encoder_t *enc, uint8_t channels, uint32_t first_seq, tslog_write_fn_t write, void *ctx);
+
+/**
+ * @description: 编码一个样本，当前块放不下时先输出当前块
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG（时间倒退）/ write 返回的错误（该块已丢弃，样本进入新块）
+ * @param {uint64_t} t 时间，通常是微秒，不能小于上一个样本
+ * @param {int32_t} *values channels 个通道值
+ */
+esp_err_t tslog_encoder_add(tslog_encoder_t *enc, uint64_t t, const int32_t *values);
+
+/**
+ * @description: 输出未满的当前块（没有样本时什么都不做）
+ * @return       ESP_OK / write 返回的错误
+ */
+esp_err_t tslog_encoder_flush(tslog_encoder_t *enc);
+
+/**
+ * @description: 检查块头和CRC
+ * @return       ESP_OK / ESP_ERR_NOT_FOUND（不是tslog块，如未写过的区域）/ ESP_ERR_INVALID_CRC / ESP_ERR_INVALID_VERSION
+ * @param {uint8_t} *block TSLOG_BLOCK_SIZE 字节
+ * @param {tslog_block_header_t} *header 输出块头，可以为NULL
+ */
+esp_err_t tslog_block_check(const uint8_t *block, tslog_block_header_t *header);
+
+/**
+ * @description: 校验并解码一个块
+ * @return       ESP_OK / tslog_block_check 的错误 / ESP_ERR_INVALID_SIZE（样本数据损坏）
+ */
+esp_err_t tslog_block_decode(const uint8_t *block, tslog_sample_cb_t cb, void *ctx);
+
+/**
+ * @description: 二分查找第一个 t_max >= t 的有效块，损坏的块被跳过
+ * @return       ESP_OK / ESP_ERR_NOT_FOUND（所有块都早于t）/ read 返回的错误
+ * @param {tslog_read_fn_t} read 读块函数
+ * @param {uint32_t} block_count 总块数
+ * @param {uint64_t} t 时间
+ * @param {uint32_t} *index 输出块号
+ * @param {uint8_t} *block 工作缓冲区，返回时是找到的块
+ */
+esp_err_t tslog_seek(tslog_read_fn_t read, void *ctx, uint32_t block_count, uint64_t t, uint32_t *index, uint8_t *block);
+
+#endif /* __TSLOG_H__ */
@@ -0,0 +1,282 @@
+#include <string.h>
+#include "tslog.h"
+#include "esp_rom_crc.h"
+
+// 一个样本编码后的最大字节数：时间 10 字节 + 每个通道差值（33位）5 字节
+#define TSLOG_SAMPLE_MAX (10 + 5 * TSLOG_MAX_CHANNELS)
+
+static inline uint64_t tslog_zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t tslog_unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline size_t tslog_put_varint(uint8_t *p, uint64_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80)
+    {
+        p[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+/**
+ * @description: 读一个varint
+ * @return       读取的字节数，数据不完整或超过10字节返回0
+ */
+static inline size_t tslog_get_varint(const uint8_t *p, const uint8_t *end, uint64_t *v)
+{
+    uint64_t x = 0;
+    for (size_t n = 0; n < 10 && p + n < end; n++)
+    {
+        x |= (uint64_t)(p[n] & 0x7F) << (7 * n);
+        if (!(p[n] & 0x80))
+        {
+            *v = x;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @description: 编码一个样本到 out
+ * @return       编码后的字节数
+ * @param {bool} first 是否为块中第一个样本（时间在块头中，值不做差分）
+ */
+static size_t tslog_encode_sample(const tslog_encoder_t *enc, bool first, uint64_t t, const int32_t *values,
+                                  uint8_t *out, int64_t *delta)
+{
+    size_t n = 0;
+    *delta = 0;
+    if (!first)
+    {
+        *delta = (int64_t)(t - enc->t_prev);
+        n += tslog_put_varint(out + n, tslog_zigzag(*delta - enc->delta_prev));
+    }
+    for (uint8_t c = 0; c < enc->channels; c++)
+    {
+        int64_t d = first ? values[c] : (int64_t)values[c] - enc->prev[c];
+        n += tslog_put_varint(out + n, tslog_zigzag(d));
+    }
+    return n;
+}
+
+esp_err_t tslog_encoder_init(tslog_encoder_t *enc, uint8_t channels, uint32_t first_seq, tslog_write_fn_t write, void *ctx)
+{
+    if (!enc || !write || channels == 0 || channels > TSLOG_MAX_CHANNELS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(enc, 0, sizeof(*enc));
+    enc->channels = channels;
+    enc->seq = first_seq;
+    enc->write = write;
+    enc->ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t tslog_encoder_flush(tslog_encoder_t *enc)
+{
+    if (enc->count == 0)
+    {
+        return ESP_OK;
+    }
+    tslog_block_header_t *h = (tslog_block_header_t *)enc->block;
+    h->magic = TSLOG_MAGIC;
+    h->seq = enc->seq++;
+    h->t_max = enc->t_prev;
+    h->count = enc->count;
+    h->payload_len = enc->len;
+    h->channels = enc->channels;
+    h->version = TSLOG_VERSION;
+    h->reserved = 0;
+    memset(enc->block + sizeof(*h) + enc->len, 0, TSLOG_PAYLOAD_SIZE - enc->len);
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)h, offsetof(tslog_block_header_t, crc));
+    h->crc = esp_rom_crc32_le(crc, (const uint8_t *)enc->block + sizeof(*h), enc->len);
+
+    // 不论输出成功与否都开始新块，编码器不保留旧数据
+    enc->count = 0;
+    enc->len = 0;
+    enc->blocks++;
+    return enc->write(enc->ctx, enc->block);
+}
+
+esp_err_t tslog_encoder_add(tslog_encoder_t *enc, uint64_t t, const int32_t *values)
+{
+    if (enc->count && t < enc->t_prev)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t sample[TSLOG_SAMPLE_MAX];
+    int64_t delta;
+    size_t n = tslog_encode_sample(enc, enc->count == 0, t, values, sample, &delta);
+    esp_err_t ret = ESP_OK;
+    if (enc->count && (enc->len + n > TSLOG_PAYLOAD_SIZE || enc->count == UINT16_MAX))
+    {
+        ret = tslog_encoder_flush(enc);
+        n = tslog_encode_sample(enc, true, t, values, sample, &delta);
+    }
+    if (enc->count == 0)
+    {
+        ((tslog_block_header_t *)enc->block)->t_min = t;
+    }
+    memcpy(enc->block + sizeof(tslog_block_header_t) + enc->len, sample, n);
+    enc->len += n;
+    enc->count++;
+    enc->samples++;
+    enc->t_prev = t;
+    enc->delta_prev = delta;
+    memcpy(enc->prev, values, enc->channels * sizeof(int32_t));
+    return ret;
+}
+
+esp_err_t tslog_block_check(const uint8_t *block, tslog_block_header_t *header)
+{
+    tslog_block_header_t h;
+    memcpy(&h, block, sizeof(h));
+    if (h.magic != TSLOG_MAGIC)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (h.version != TSLOG_VERSION)
+    {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (h.payload_len > TSLOG_PAYLOAD_SIZE || h.channels == 0 || h.channels > TSLOG_MAX_CHANNELS || h.count == 0)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&h, offsetof(tslog_block_header_t, crc));
+    if (esp_rom_crc32_le(crc, (const uint8_t *)block + sizeof(h), h.payload_len) != h.crc)
+    {
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (header)
+    {
+        *header = h;
+    }
+    return ESP_OK;
+}
+
+esp_err_t tslog_block_decode(const uint8_t *block, tslog_sample_cb_t cb, void *ctx)
+{
+    tslog_block_header_t h;
+    esp_err_t ret = tslog_block_check(block, &h);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    const uint8_t *p = block + sizeof(h);
+    const uint8_t *end = p + h.payload_len;
+    int32_t values[TSLOG_MAX_CHANNELS];
+    uint64_t t = h.t_min;
+    int64_t delta = 0;
+    for (uint16_t i = 0; i < h.count; i++)
+    {
+        uint64_t v;
+        size_t n;
+        if (i)
+        {
+            n = tslog_get_varint(p, end, &v);
+            if (n == 0)
+            {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            p += n;
+            delta += tslog_unzigzag(v);
+            t += delta;
+        }
+        for (uint8_t c = 0; c < h.channels; c++)
+        {
+            n = tslog_get_varint(p, end, &v);
+            if (n == 0)
+            {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            p += n;
+            int64_t d = tslog_unzigzag(v);
+            values[c] = i ? (int32_t)((int64_t)values[c] + d) : (int32_t)d;
+        }
+        if (!cb(ctx, t, values, h.channels))
+        {
+            return ESP_OK;
+        }
+    }
+    return p == end && t == h.t_max ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/**
+ * @description: 从 from 开始找第一个有效块（不超过 to）
+ * @return       ESP_OK / ESP_ERR_NOT_FOUND / read 的错误
+ */
+static esp_err_t tslog_next_valid(tslog_read_fn_t read, void *ctx, uint32_t from, uint32_t to, uint8_t *block,
+                                  uint32_t *index, tslog_block_header_t *header)
+{
+    for (uint32_t i = from; i < to; i++)
+    {
+        esp_err_t ret = read(ctx, i, block);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        if (tslog_block_check(block, header) == ESP_OK)
+        {
+            *index = i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t tslog_seek(tslog_read_fn_t read, void *ctx, uint32_t block_count, uint64_t t, uint32_t *index, uint8_t *block)
+{
+    tslog_block_header_t h;
+    uint32_t lo = 0;
+    uint32_t hi = block_count;
+    // 不变式：答案（第一个 t_max >= t 的有效块）不在 [0, lo) 中，也不在 [hi, 第一个有效块之后)
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint32_t v;
+        esp_err_t ret = tslog_next_valid(read, ctx, mid, hi, block, &v, &h);
+        if (ret == ESP_ERR_NOT_FOUND)
+        {
+            hi = mid; // [mid, hi) 全部损坏
+            continue;
+        }
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        if (h.t_max < t)
+        {
+            lo = v + 1;
+        }
+        else
+        {
+            hi = mid; // v 可能就是答案，最后从 lo 向后找第一个有效块时会找到它
+        }
+    }
+    while (lo < block_count)
+    {
+        esp_err_t ret = tslog_next_valid(read, ctx, lo, block_count, block, index, &h);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+        if (h.t_max >= t)
+        {
+            return ESP_OK;
+        }
+        lo = *index + 1;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
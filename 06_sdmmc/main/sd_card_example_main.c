@@ -7,15 +7,30 @@
 #include "sdmmc_cmd.h"
 #include "driver/sdmmc_host.h"
 #include "esp_timer.h"
+#include "sd_bench.h"
+#include "sd_bringup.h"
+#include "sd_async_writer.h"
+#include "sd_contig_log.h"
+#include "tslog.h"
+#include "sd_journal.h"
+#include "sd_block_cache.h"
 
 static const char *TAG = "example";
 
 #define MOUNT_POINT "/sdcard"
 
-#define TEST_FILE_SIZE (4 * 1024 * 1024)
+// 连续日志演示中写入的定长记录
+typedef struct
+{
+    uint32_t timestamp_us;
+    uint32_t seq;
+    int16_t value[4];
+} log_record_t;
 
-void testReadFile(const char *path, char *buf, int len);
-void testWriteFile(const char *path, char *buf, int len);
+static void logger_demo(void);
+static void replay_demo(void);
+static void contig_log_demo(sdmmc_card_t *card);
+static void journal_demo(void);
 
 void app_main(void)
 {
@@ -42,33 +57,37 @@ void app_main(void)
     // production applications.
 
     ESP_LOGI(TAG, "Using SDMMC peripheral");
-    sdmmc_host_t host = SDMMC_HOST_DEFAULT();
+    sd_bringup_config_t bringup_config = SD_BRINGUP_DEFAULT_CONFIG();
 
     // This initializes the slot without card detect (CD) and write protect (WP) signals.
-    // Modify slot_config.gpio_cd and slot_config.gpio_wp if your board has these signals.
-    sdmmc_slot_config_t slot_config = SDMMC_SLOT_CONFIG_DEFAULT();
-
-    // To use 1-line SD mode, change this to 1:
-    slot_config.width = 1;
+    // Modify bringup_config.slot.gpio_cd and bringup_config.slot.gpio_wp if your board has these signals.
+    // 总线宽度和时钟自动协商：4线/高速不可用时依次退回，CONFIG_EXAMPLE_SD_BUS_WIDTH 为最多尝试的线数
+    bringup_config.slot.width = CONFIG_EXAMPLE_SD_BUS_WIDTH;
+#ifdef CONFIG_EXAMPLE_SD_HIGH_SPEED
+    bringup_config.try_high_speed = true;
+#else
+    bringup_config.try_high_speed = false;
+#endif
 
     // On chips where the GPIOs used for SD card can be configured, set them in
-    // the slot_config structure:
+    // the bringup_config.slot structure:
 #ifdef SOC_SDMMC_USE_GPIO_MATRIX
-    slot_config.clk = GPIO_NUM_10;
-    slot_config.cmd = GPIO_NUM_11;
-    slot_config.d0 = GPIO_NUM_9;
-    // slot_config.d1 = GPIO_NUM_4;
-    // slot_config.d2 = GPIO_NUM_12;
-    // slot_config.d3 = GPIO_NUM_13;
+    bringup_config.slot.clk = GPIO_NUM_10;
+    bringup_config.slot.cmd = GPIO_NUM_11;
+    bringup_config.slot.d0 = GPIO_NUM_9;
+    bringup_config.slot.d1 = GPIO_NUM_4;
+    bringup_config.slot.d2 = GPIO_NUM_12;
+    bringup_config.slot.d3 = GPIO_NUM_13;
 #endif
 
     // Enable internal pullups on enabled pins. The internal pullups
     // are insufficient however, please make sure 10k external pullups are
     // connected on the bus. This is for debug / example purpose only.
-    slot_config.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
+    bringup_config.slot.flags |= SDMMC_SLOT_FLAG_INTERNAL_PULLUP;
 
     ESP_LOGI(TAG, "Mounting filesystem");
-    ret = esp_vfs_fat_sdmmc_mount(mount_point, &host, &slot_config, &mount_config, &card);
+    sd_bringup_result_t bringup;
+    ret = sd_bringup_mount(mount_point, &bringup_config, &mount_config, &card, &bringup);
 
     if (ret != ESP_OK)
     {
@@ -87,68 +106,249 @@ void app_main(void)
     }
     ESP_LOGI(TAG, "Filesystem mounted");
 
-    // Card has been initialized, print its properties
-    sdmmc_card_print_info(stdout, card);
+    // Card has been initialized, print its properties and the negotiated bus mode
+    sd_bringup_print_info(stdout, card, &bringup);
 
     // Use POSIX and C standard library functions to work with files:
+    // 吞吐量测试：块大小从 MIN 到 MAX 按2倍递增，顺序/随机、缓冲/同步、是否预分配的所有组合
+    sd_bench_config_t bench_config = SD_BENCH_DEFAULT_CONFIG(MOUNT_POINT "/bench.bin");
+    bench_config.file_size = CONFIG_EXAMPLE_BENCH_FILE_SIZE_KB * 1024;
+    bench_config.min_chunk = CONFIG_EXAMPLE_BENCH_MIN_CHUNK;
+    bench_config.max_chunk = CONFIG_EXAMPLE_BENCH_MAX_CHUNK;
+    bench_config.random_ops = CONFIG_EXAMPLE_BENCH_RANDOM_OPS;
 
-    const char *file_w = MOUNT_POINT "/write.txt";
+    sd_bench_io_t *bench_io = sd_bench_io_new_posix();
+    if (!bench_io)
+    {
+        ESP_LOGE(TAG, "Failed to create benchmark io");
+        return;
+    }
+    sd_bench_print_header();
+    ret = sd_bench_run(bench_io, &bench_config, sd_bench_print_result, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Benchmark failed (%s)", esp_err_to_name(ret));
+    }
+    bench_io->del(bench_io);
+
+    journal_demo();
+    logger_demo();
+    replay_demo();
+    contig_log_demo(card);
+}
+
+// 统计日志中的记录数
+static bool journal_count_cb(void *ctx, const void *data, size_t len)
+{
+    (*(uint32_t *)ctx)++;
+    return true;
+}
 
-    char *buf_ = "6666";
+/**
+ * @description: 打开（恢复）掉电安全日志，打印恢复耗时，再追加 CONFIG_EXAMPLE_JOURNAL_RECORDS 条记录并提交。
+ *               每次启动运行一次，中途断电后重启可以看到已提交的记录都还在
+ */
+static void journal_demo(void)
+{
+    sd_journal_io_t *io = sd_journal_io_new_posix(MOUNT_POINT "/journal.bin");
+    if (!io)
+    {
+        ESP_LOGE(TAG, "Failed to open journal file");
+        return;
+    }
+    sd_journal_config_t journal_config = SD_JOURNAL_DEFAULT_CONFIG();
+    sd_journal_handle_t journal;
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = sd_journal_open(io, &journal_config, &journal);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to recover journal (%s)", esp_err_to_name(ret));
+        io->del(io);
+        return;
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    sd_journal_info_t info;
+    sd_journal_get_info(journal, &info);
+    uint32_t records = 0;
+    sd_journal_read(journal, journal_count_cb, &records);
+    ESP_LOGI(TAG, "Journal %s: %u blocks, %u records, recovered in %lld us (%u block reads, %u stale blocks cleared)",
+             info.created ? "created" : "recovered", info.blocks, records, elapsed, info.mount_reads, info.stale_cleared);
+
+    log_record_t rec = {0};
+    for (int i = 0; i < CONFIG_EXAMPLE_JOURNAL_RECORDS && ret == ESP_OK; i++)
+    {
+        rec.timestamp_us = (uint32_t)esp_timer_get_time();
+        rec.seq = records + i;
+        ret = sd_journal_append(journal, &rec, sizeof(rec));
+    }
+    if (ret == ESP_OK)
+    {
+        ret = sd_journal_commit(journal);
+    }
+    ESP_LOGI(TAG, "Journal: appended %d records (%s)", CONFIG_EXAMPLE_JOURNAL_RECORDS, esp_err_to_name(ret));
+    sd_journal_close(journal);
+}
 
-    testWriteFile(file_w, buf_, sizeof(buf_));
+// 高频日志演示的状态：样本先用 tslog 压缩，每满一块（512字节）交给异步写入器
+typedef struct
+{
+    sd_writer_handle_t writer;
+    tslog_encoder_t encoder;
+    uint32_t seq;
+} logger_ctx_t;
 
-    testReadFile(file_w, buf_, sizeof(buf_));
+static esp_err_t logger_write_block(void *ctx, const uint8_t *block)
+{
+    logger_ctx_t *logger = (logger_ctx_t *)ctx;
+    return sd_writer_append(logger->writer, block, TSLOG_BLOCK_SIZE, 0);
 }
 
-void testWriteFile(const char *path, char *buf, int len)
+// esp_timer 回调中采样并编码，timeout 为0，SD卡再慢也不会阻塞采样
+static void logger_sample_cb(void *arg)
 {
-    unsigned long start_time = esp_timer_get_time() / 1000;
-    ESP_LOGI(TAG, "Test write %s", path);
+    logger_ctx_t *logger = (logger_ctx_t *)arg;
+    uint32_t seq = logger->seq++;
+    const int32_t value[4] = {seq & 0xFFF, (seq >> 1) & 0xFFF, (seq >> 2) & 0xFFF, (seq >> 3) & 0xFFF};
+    tslog_encoder_add(&logger->encoder, esp_timer_get_time(), value);
+}
 
-    FILE *file_ = fopen(path, "wb");
-    if (!file_)
+/**
+ * @description: 以 CONFIG_EXAMPLE_LOGGER_RATE_HZ 的频率记录 CONFIG_EXAMPLE_LOGGER_SECONDS 秒，打印丢弃数和最长写延时
+ */
+static void logger_demo(void)
+{
+    static logger_ctx_t logger;
+    sd_writer_file_config_t file_config = {.path = MOUNT_POINT "/log.tsl"};
+    sd_writer_sink_t *sink = sd_writer_sink_new_file(&file_config);
+    if (!sink)
     {
-        ESP_LOGE(TAG, "Failed to open file for writing");
         return;
     }
-    int loop = TEST_FILE_SIZE / len;
-    while (loop--)
+    sd_writer_config_t writer_config = SD_WRITER_DEFAULT_CONFIG();
+    logger.writer = sd_writer_create(&writer_config, sink);
+    if (!logger.writer)
     {
-        if (fwrite(buf, 1, len, file_) <= 0)
-        {
-            ESP_LOGE(TAG, "Write failed");
-            return;
-        }
+        ESP_LOGE(TAG, "Failed to create log writer");
+        sink->del(sink);
+        return;
     }
-    fclose(file_);
+    tslog_encoder_init(&logger.encoder, 4, 0, logger_write_block, &logger);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = logger_sample_cb,
+        .arg = &logger,
+        .name = "logger",
+    };
+    esp_timer_handle_t timer;
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer));
+    ESP_LOGI(TAG, "Logging %d Hz for %d s", CONFIG_EXAMPLE_LOGGER_RATE_HZ, CONFIG_EXAMPLE_LOGGER_SECONDS);
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, 1000000 / CONFIG_EXAMPLE_LOGGER_RATE_HZ));
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_EXAMPLE_LOGGER_SECONDS * 1000));
+    esp_timer_stop(timer);
+    esp_timer_delete(timer);
+    tslog_encoder_flush(&logger.encoder);
 
-    unsigned long time_used = (esp_timer_get_time() / 1000) - start_time;
-    printf("Write file used: %ld ms, %f KB/s\n", time_used, (float)TEST_FILE_SIZE / time_used);
+    sd_writer_stats_t stats;
+    sd_writer_get_stats(logger.writer, &stats);
+    sd_writer_delete(logger.writer);
+    ESP_LOGI(TAG, "Logged %llu samples in %u blocks (%.2f bytes/sample), dropped %u blocks, worst write %u us, worst sync %u us",
+             logger.encoder.samples, logger.encoder.blocks,
+             logger.encoder.samples ? (float)logger.encoder.blocks * TSLOG_BLOCK_SIZE / logger.encoder.samples : 0.0f,
+             stats.records_dropped, stats.max_write_us, stats.max_sync_us);
 }
 
-void testReadFile(const char *path, char *buf, int len)
+// 回放时统计样本数，模拟对数据的处理
+static bool replay_sample_cb(void *ctx, uint64_t t, const int32_t *values, uint8_t channels)
 {
-    unsigned long start_time = esp_timer_get_time() / 1000;
-    ESP_LOGI(TAG, "Test read %s", path);
+    (*(uint64_t *)ctx)++;
+    return true;
+}
 
-    FILE *file_ = fopen(path, "rb");
-    if (!file_)
+/**
+ * @description: 通过块缓存按 512 字节逐块读回高频日志并解码，打印读取速度和缓存统计
+ */
+static void replay_demo(void)
+{
+    sd_cache_file_config_t file_config = {.path = MOUNT_POINT "/log.tsl"};
+    sd_cache_dev_t *dev = sd_cache_dev_new_file(&file_config);
+    if (!dev)
     {
-        ESP_LOGE(TAG, "Failed to open file for reading");
+        ESP_LOGE(TAG, "Failed to open log for replay");
         return;
     }
-    int loop = TEST_FILE_SIZE / len;
-    while (loop--)
+    sd_cache_config_t cache_config = SD_CACHE_DEFAULT_CONFIG();
+    cache_config.readahead = CONFIG_EXAMPLE_REPLAY_READAHEAD;
+    if (cache_config.block_count < cache_config.readahead + 2)
     {
-        if (fread(buf, 1, len, file_) <= 0)
+        cache_config.block_count = cache_config.readahead + 2;
+    }
+    sd_cache_handle_t cache;
+    esp_err_t ret = sd_cache_create(dev, &cache_config, &cache);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create block cache (%s)", esp_err_to_name(ret));
+        dev->del(dev);
+        return;
+    }
+
+    uint8_t block[TSLOG_BLOCK_SIZE];
+    uint64_t offset = 0;
+    uint64_t samples = 0;
+    uint32_t bad_blocks = 0;
+    size_t len;
+    int64_t start = esp_timer_get_time();
+    while ((ret = sd_cache_read(cache, offset, block, sizeof(block), &len)) == ESP_OK && len == sizeof(block))
+    {
+        if (tslog_block_decode(block, replay_sample_cb, &samples) != ESP_OK)
         {
-            ESP_LOGE(TAG, "Read failed");
-            return;
+            bad_blocks++;
         }
+        offset += len;
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    sd_cache_stats_t stats;
+    sd_cache_get_stats(cache, &stats);
+    sd_cache_delete(cache);
+    ESP_LOGI(TAG, "Replayed %llu samples from %llu bytes in %lld ms, %.2f MB/s, %u bad blocks (%s)", samples, offset,
+             elapsed / 1000, elapsed ? (float)offset / elapsed : 0.0f, bad_blocks, esp_err_to_name(ret));
+    ESP_LOGI(TAG, "Cache: %u hits, %u misses, %u waits, %u prefetched (%u used)", stats.hits, stats.misses,
+             stats.waits, stats.prefetched, stats.prefetch_used);
+}
+
+/**
+ * @description: 把连续日志文件从头写满，打印写入速度
+ */
+static void contig_log_demo(sdmmc_card_t *card)
+{
+#if CONFIG_EXAMPLE_CONTIG_LOG_SIZE_MB
+    sd_contig_log_config_t log_config = SD_CONTIG_LOG_DEFAULT_CONFIG(card, "clog.bin", (uint64_t)CONFIG_EXAMPLE_CONTIG_LOG_SIZE_MB << 20);
+    log_config.truncate = true;
+    sd_contig_log_handle_t log;
+    esp_err_t ret = sd_contig_log_open(&log_config, &log);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to open contiguous log (%s)", esp_err_to_name(ret));
+        return;
     }
-    fclose(file_);
 
-    unsigned long time_used = esp_timer_get_time() / 1000 - start_time;
-    printf("Read file used: %ld ms, %f KB/s\r\n", time_used, (float)TEST_FILE_SIZE / time_used);
+    log_record_t rec = {0};
+    int64_t start = esp_timer_get_time();
+    do
+    {
+        rec.timestamp_us = (uint32_t)esp_timer_get_time();
+        ret = sd_contig_log_append(log, &rec, sizeof(rec));
+        rec.seq++;
+    } while (ret == ESP_OK);
+    // 写满时返回 ESP_ERR_INVALID_SIZE，其他错误来自写扇区
+    if (ret != ESP_ERR_INVALID_SIZE)
+    {
+        ESP_LOGE(TAG, "Contiguous log write failed (%s)", esp_err_to_name(ret));
+    }
+    uint64_t bytes = sd_contig_log_size(log);
+    ret = sd_contig_log_close(log);
+    int64_t elapsed = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "Contiguous log: %llu bytes in %lld ms, %.2f MB/s (%s)", bytes, elapsed / 1000,
+             (float)bytes / elapsed, esp_err_to_name(ret));
+#endif
 }
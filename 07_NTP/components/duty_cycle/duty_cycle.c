@@ -0,0 +1,72 @@
+#include "duty_cycle.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_private/esp_clk.h"
+#include "esp_log.h"
+
+static const char *TAG = "duty_cycle";
+
+typedef struct
+{
+    duty_hw_t parent;
+    const duty_cycle_net_t *net;
+} duty_cycle_esp_t;
+
+// RTC 定时器深度睡眠期间继续走，只在上电时清零，与 RTC 内存中的状态一样；
+// 不用 gettimeofday()：NTP 同步和 holdover 会用 settimeofday() 调整系统时间，已经排好的到期时间跟着跳
+static int64_t esp_hw_now_us(duty_hw_t *hw)
+{
+    return (int64_t)esp_clk_rtc_time();
+}
+
+static esp_err_t esp_hw_net_up(duty_hw_t *hw)
+{
+    duty_cycle_esp_t *e = __containerof(hw, duty_cycle_esp_t, parent);
+    return e->net && e->net->up ? e->net->up(e->net->ctx) : ESP_ERR_NOT_SUPPORTED;
+}
+
+static void esp_hw_net_down(duty_hw_t *hw)
+{
+    duty_cycle_esp_t *e = __containerof(hw, duty_cycle_esp_t, parent);
+    if (e->net && e->net->down)
+    {
+        e->net->down(e->net->ctx);
+    }
+}
+
+static void esp_hw_delay(duty_hw_t *hw, int64_t us)
+{
+    TickType_t ticks = pdMS_TO_TICKS((us + 999) / 1000);
+    vTaskDelay(ticks ? ticks : 1);
+}
+
+esp_err_t duty_cycle_run(const duty_config_t *config, duty_state_t *state, const duty_cycle_net_t *net,
+                         int64_t *sleep_us)
+{
+    duty_cycle_esp_t e = {
+        .parent = {
+            .now_us = esp_hw_now_us,
+            .net_up = esp_hw_net_up,
+            .net_down = esp_hw_net_down,
+            .delay = esp_hw_delay,
+        },
+        .net = net,
+    };
+    duty_t d;
+    esp_err_t ret = duty_init(&d, config, &e.parent, state);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    if (d.cold)
+    {
+        ESP_LOGI(TAG, "no valid state in RTC memory, all tasks due");
+    }
+    *sleep_us = duty_run(&d);
+    ESP_LOGI(TAG, "wake %u: %u records pending (%u dropped), network up %u times (%u failed), awake %lld ms, "
+                  "next wake in %lld ms",
+             state->wakes, state->batch_count, state->dropped, state->net_ups, state->net_failures,
+             esp_timer_get_time() / 1000, *sleep_us / 1000);
+    return ESP_OK;
+}
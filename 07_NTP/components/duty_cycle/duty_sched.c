@@ -0,0 +1,240 @@
+#include <string.h>
+#include <stddef.h>
+#include "duty_sched.h"
+#include "esp_rom_crc.h"
+
+// 一次唤醒中最多醒着等几轮（下次到期近于 min_sleep_ms 时），避免任务总是立即到期时不睡眠
+#define DUTY_MAX_PASSES 8
+
+static void duty_seal(duty_state_t *state)
+{
+    state->crc = esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(duty_state_t, crc));
+}
+
+static bool duty_state_valid(const duty_state_t *state, const duty_config_t *config)
+{
+    return state->magic == DUTY_STATE_MAGIC && state->task_count == config->task_count &&
+           state->record_size == config->record_size && state->batch_count <= DUTY_BATCH_BYTES / config->record_size &&
+           state->crc == esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(duty_state_t, crc));
+}
+
+esp_err_t duty_init(duty_t *d, const duty_config_t *config, duty_hw_t *hw, duty_state_t *state)
+{
+    if (!d || !config || !hw || !state || !config->tasks || config->task_count > DUTY_MAX_TASKS ||
+        config->record_size == 0 || config->record_size > DUTY_BATCH_BYTES)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(d, 0, sizeof(*d));
+    d->config = *config;
+    d->hw = hw;
+    d->state = state;
+    if (!duty_state_valid(state, config))
+    {
+        int64_t now = hw->now_us(hw);
+        memset(state, 0, sizeof(*state));
+        state->magic = DUTY_STATE_MAGIC;
+        state->task_count = config->task_count;
+        state->record_size = config->record_size;
+        for (int i = 0; i < config->task_count; i++)
+        {
+            state->tasks[i].next_us = now;
+        }
+        duty_seal(state);
+        d->cold = true;
+    }
+    return ESP_OK;
+}
+
+uint16_t duty_capacity(const duty_t *d)
+{
+    return DUTY_BATCH_BYTES / d->config.record_size;
+}
+
+void duty_push(duty_t *d, const void *record)
+{
+    duty_state_t *s = d->state;
+    uint16_t size = d->config.record_size;
+    if (s->batch_count >= duty_capacity(d))
+    {
+        // 网络长时间不可用：保留最新的记录
+        memmove(s->batch, s->batch + size, (size_t)(s->batch_count - 1) * size);
+        s->batch_count--;
+        s->dropped++;
+    }
+    if (s->batch_count == 0)
+    {
+        s->batch_oldest_us = d->hw->now_us(d->hw);
+    }
+    memcpy(s->batch + (size_t)s->batch_count * size, record, size);
+    s->batch_count++;
+    duty_seal(s);
+}
+
+const void *duty_batch(duty_t *d, uint16_t *count)
+{
+    *count = d->state->batch_count;
+    return d->state->batch;
+}
+
+void duty_consume(duty_t *d, uint16_t n)
+{
+    duty_state_t *s = d->state;
+    uint16_t size = d->config.record_size;
+    n = n > s->batch_count ? s->batch_count : n;
+    memmove(s->batch, s->batch + (size_t)n * size, (size_t)(s->batch_count - n) * size);
+    s->batch_count -= n;
+    // 剩下记录的时间没有保存，仍按原来最旧的一条计算等待时间，只会提前上传
+    duty_seal(s);
+}
+
+/**
+ * @description: 任务的到期时间，上传任务没有记录时为 INT64_MAX
+ */
+static int64_t duty_due_us(const duty_t *d, int i)
+{
+    const duty_task_t *t = &d->config.tasks[i];
+    const duty_state_t *s = d->state;
+    int64_t next = s->tasks[i].next_us;
+    if (t->kind != DUTY_TASK_UPLOAD)
+    {
+        return next;
+    }
+    if (s->batch_count == 0)
+    {
+        return INT64_MAX;
+    }
+    int64_t due = s->batch_count >= d->config.batch_threshold ? next
+                                                               : s->batch_oldest_us + (int64_t)t->period_s * 1000000;
+    return due > next ? due : next;
+}
+
+/**
+ * @description: 到期或在 slack_s 之内
+ */
+static bool duty_within_slack(const duty_t *d, int i, int64_t now)
+{
+    int64_t due = duty_due_us(d, i);
+    return due != INT64_MAX && due - (int64_t)d->config.tasks[i].slack_s * 1000000 <= now;
+}
+
+static void duty_run_task(duty_t *d, int i)
+{
+    const duty_task_t *t = &d->config.tasks[i];
+    duty_task_state_t *ts = &d->state->tasks[i];
+    int64_t start = d->hw->now_us(d->hw);
+    uint32_t next_s = t->run(d, t->arg, ts->data);
+    int64_t end = d->hw->now_us(d->hw);
+    ts->runs++;
+    if (t->kind == DUTY_TASK_UPLOAD)
+    {
+        ts->next_us = end + (int64_t)next_s * 1000000;
+        if (d->state->batch_count >= d->config.batch_threshold)
+        {
+            // 没有传完，过一会再试
+            int64_t retry = end + (int64_t)d->config.net_retry_s * 1000000;
+            ts->next_us = ts->next_us > retry ? ts->next_us : retry;
+        }
+    }
+    else if (next_s)
+    {
+        ts->next_us = end + (int64_t)next_s * 1000000;
+    }
+    else
+    {
+        // 晚了时按原来的节拍，不累积误差；提前运行（slack）时从这次算起，间隔不超过 period_s
+        int64_t period = (int64_t)t->period_s * 1000000;
+        int64_t base = ts->next_us < start ? ts->next_us : start;
+        ts->next_us = base + period > start ? base + period : start + period;
+    }
+    duty_seal(d->state);
+}
+
+/**
+ * @description: 运行一轮：到期和 slack 之内的本地任务；有网络任务到期时打开网络，运行 slack 之内的网络任务
+ */
+static void duty_pass(duty_t *d)
+{
+    const duty_config_t *c = &d->config;
+    int64_t now = d->hw->now_us(d->hw);
+    for (int i = 0; i < c->task_count; i++)
+    {
+        if (c->tasks[i].kind == DUTY_TASK_LOCAL && duty_within_slack(d, i, now))
+        {
+            duty_run_task(d, i);
+        }
+    }
+
+    // 本地任务可能刚好攒满了一批记录
+    now = d->hw->now_us(d->hw);
+    bool need = false;
+    for (int i = 0; i < c->task_count; i++)
+    {
+        need |= c->tasks[i].kind != DUTY_TASK_LOCAL && duty_due_us(d, i) <= now;
+    }
+    if (need && !d->net_up && !d->net_failed)
+    {
+        if (d->hw->net_up(d->hw) == ESP_OK)
+        {
+            d->net_up = true;
+            d->state->net_ups++;
+        }
+        else
+        {
+            d->net_failed = true;
+            d->state->net_failures++;
+        }
+    }
+    for (int i = 0; i < c->task_count; i++)
+    {
+        if (c->tasks[i].kind == DUTY_TASK_LOCAL)
+        {
+            continue;
+        }
+        now = d->hw->now_us(d->hw);
+        if (d->net_up && duty_within_slack(d, i, now))
+        {
+            duty_run_task(d, i);
+        }
+        else if (d->net_failed && duty_due_us(d, i) <= now)
+        {
+            d->state->tasks[i].next_us = now + (int64_t)c->net_retry_s * 1000000;
+        }
+    }
+    duty_seal(d->state);
+}
+
+int64_t duty_run(duty_t *d)
+{
+    const duty_config_t *c = &d->config;
+    d->state->wakes++;
+    int64_t wait = 0;
+    for (int pass = 0; pass < DUTY_MAX_PASSES; pass++)
+    {
+        duty_pass(d);
+        int64_t now = d->hw->now_us(d->hw);
+        int64_t next = INT64_MAX;
+        for (int i = 0; i < c->task_count; i++)
+        {
+            int64_t due = duty_due_us(d, i);
+            next = due < next ? due : next;
+        }
+        wait = next == INT64_MAX ? (int64_t)c->max_sleep_s * 1000000 : next - now;
+        wait = wait < 0 ? 0 : wait;
+        if (wait >= (int64_t)c->min_sleep_ms * 1000 || pass == DUTY_MAX_PASSES - 1)
+        {
+            break;
+        }
+        d->hw->delay(d->hw, wait);
+    }
+    if (d->net_up)
+    {
+        d->hw->net_down(d->hw);
+        d->net_up = false;
+    }
+    if (wait > (int64_t)c->max_sleep_s * 1000000)
+    {
+        wait = (int64_t)c->max_sleep_s * 1000000;
+    }
+    return wait;
+}
@@ -0,0 +1,28 @@
+#ifndef __DUTY_CYCLE_H__
+#define __DUTY_CYCLE_H__
+
+#include "duty_sched.h"
+
+/*
+ * duty_sched 在 ESP-IDF 上的驱动：系统时间（深度睡眠中由 RTC 定时器维持）作为时钟，
+ * 短间隔用 vTaskDelay 醒着等，网络的打开和关闭由应用提供。
+ * duty_state_t 应放在 RTC_DATA_ATTR 变量中。
+ */
+
+typedef struct
+{
+    esp_err_t (*up)(void *ctx); /*!< 打开网络，等到可用或失败 */
+    void (*down)(void *ctx);
+    void *ctx;
+} duty_cycle_net_t;
+
+/**
+ * @description: 运行这次唤醒到期的任务，返回后由调用者进入深度睡眠
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG
+ * @param {duty_state_t} *state RTC 内存中的状态
+ * @param {int64_t} *sleep_us 到下次唤醒的时间
+ */
+esp_err_t duty_cycle_run(const duty_config_t *config, duty_state_t *state, const duty_cycle_net_t *net,
+                         int64_t *sleep_us);
+
+#endif /* __DUTY_CYCLE_H__ */
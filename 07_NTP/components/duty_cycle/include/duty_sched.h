@@ -0,0 +1,156 @@
+#ifndef __DUTY_SCHED_H__
+#define __DUTY_SCHED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * 深度睡眠的占空比调度，与 ESP-IDF 无关，可以在PC上用模拟的时钟和功耗测试。
+ *
+ * 每个子系统是一个任务：本地任务（采样）到期就唤醒运行；网络任务（同步）到期时才打开网络；
+ * 上传任务不按周期，采样攒够 batch_threshold 条或最旧的一条等了 period_s 才到期。
+ * 网络打开后，slack_s 之内快到期的网络任务和上传一起做，本地任务同样合并到同一次唤醒中。
+ * 每次唤醒运行到期的任务后，算出最早的到期时间作为下次唤醒的时间。
+ *
+ * 任务的下次到期时间、每个任务自己的小状态和待上传的记录都放在 RTC 内存（duty_state_t）中，
+ * 唤醒后不必重新采集或重新初始化；状态无效（断电）时所有任务立即到期。
+ * 时间用深度睡眠中不停的时钟，单位微秒。函数不可重入。
+ */
+
+#define DUTY_STATE_MAGIC 0x59545544 // "DUTY"
+#define DUTY_MAX_TASKS 8
+#define DUTY_TASK_DATA_SIZE 16 /*!< 每个任务放在 RTC 内存中的状态 */
+#define DUTY_BATCH_BYTES 1024  /*!< 待上传记录的缓冲区 */
+
+typedef struct duty_s duty_t;
+
+typedef enum
+{
+    DUTY_TASK_LOCAL = 0, /*!< 只用本地外设 */
+    DUTY_TASK_NETWORK,   /*!< 需要网络，按周期到期 */
+    DUTY_TASK_UPLOAD,    /*!< 需要网络，按待上传的记录到期，period_s 是记录最长的等待时间 */
+} duty_kind_t;
+
+typedef struct
+{
+    const char *name;
+    duty_kind_t kind;
+    uint32_t period_s;
+    uint32_t slack_s; /*!< 已经醒着（网络任务：网络已经打开）时，提前这么久之内的也一起运行 */
+    /**
+     * @brief 运行任务
+     * @param data 放在 RTC 内存中的 DUTY_TASK_DATA_SIZE 字节，状态无效时清零
+     * @return 到下次运行的秒数，0 表示按 period_s（上传任务：0 表示不限制）
+     */
+    uint32_t (*run)(duty_t *d, void *arg, uint8_t *data);
+    void *arg;
+} duty_task_t;
+
+typedef struct duty_hw_s duty_hw_t;
+
+/**
+ * @brief 用到的平台操作
+ */
+struct duty_hw_s
+{
+    int64_t (*now_us)(duty_hw_t *hw);            /*!< 深度睡眠中不停的时钟 */
+    esp_err_t (*net_up)(duty_hw_t *hw);          /*!< 打开网络，等到可用或失败 */
+    void (*net_down)(duty_hw_t *hw);
+    void (*delay)(duty_hw_t *hw, int64_t us);    /*!< 醒着等待（不值得深度睡眠的短间隔） */
+};
+
+typedef struct
+{
+    const duty_task_t *tasks;
+    uint8_t task_count;        /*!< 不超过 DUTY_MAX_TASKS */
+    uint16_t record_size;      /*!< 每条待上传记录的字节数 */
+    uint16_t batch_threshold;  /*!< 攒够这么多条记录后上传 */
+    uint32_t min_sleep_ms;     /*!< 下次到期比它近时不睡眠，醒着等 */
+    uint32_t max_sleep_s;      /*!< 没有任务到期时的睡眠时间 */
+    uint32_t net_retry_s;      /*!< 打开网络或上传失败后多久再试 */
+} duty_config_t;
+
+#define DUTY_DEFAULT_CONFIG(t, n, r)    \
+    {                                   \
+        .tasks = t,                     \
+        .task_count = n,                \
+        .record_size = r,               \
+        .batch_threshold = 32,          \
+        .min_sleep_ms = 500,            \
+        .max_sleep_s = 86400,           \
+        .net_retry_s = 600,             \
+    }
+
+typedef struct
+{
+    int64_t next_us;  /*!< 下次到期的时间（上传任务：最早可以再运行的时间） */
+    uint32_t runs;
+    uint8_t data[DUTY_TASK_DATA_SIZE];
+} duty_task_state_t;
+
+/**
+ * @brief 放在 RTC 内存中的状态
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint8_t task_count;
+    uint8_t reserved;
+    uint16_t record_size;
+    uint32_t wakes;
+    uint32_t net_ups;           /*!< 打开网络的次数 */
+    uint32_t net_failures;
+    uint32_t dropped;           /*!< 缓冲区满时丢弃的最旧记录数 */
+    uint16_t batch_count;       /*!< 待上传的记录数 */
+    uint16_t reserved2;
+    int64_t batch_oldest_us;    /*!< 最旧一条记录的时间 */
+    duty_task_state_t tasks[DUTY_MAX_TASKS];
+    uint8_t batch[DUTY_BATCH_BYTES];
+    uint32_t crc;
+} duty_state_t;
+
+struct duty_s
+{
+    duty_config_t config;
+    duty_hw_t *hw;
+    duty_state_t *state;
+    bool cold;        /*!< 状态无效，重新开始 */
+    bool net_up;
+    bool net_failed;  /*!< 本次唤醒打开网络失败过，不再尝试 */
+};
+
+/**
+ * @description: 每次唤醒调用，检查 RTC 内存中的状态，无效时清空并让所有任务立即到期
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG（任务太多或记录太大）
+ */
+esp_err_t duty_init(duty_t *d, const duty_config_t *config, duty_hw_t *hw, duty_state_t *state);
+
+/**
+ * @description: 运行到期的任务，需要时打开网络，结束前关闭网络
+ * @return       到下次唤醒的微秒数
+ */
+int64_t duty_run(duty_t *d);
+
+/**
+ * @description: 添加一条待上传的记录（record_size 字节），缓冲区满时丢弃最旧的一条
+ */
+void duty_push(duty_t *d, const void *record);
+
+/**
+ * @description: 待上传的记录，从旧到新连续存放
+ * @param {uint16_t} *count 记录数
+ */
+const void *duty_batch(duty_t *d, uint16_t *count);
+
+/**
+ * @description: 上传成功后去掉最旧的 n 条记录
+ */
+void duty_consume(duty_t *d, uint16_t n);
+
+/**
+ * @description: 最多能存放多少条记录
+ */
+uint16_t duty_capacity(const duty_t *d);
+
+#endif /* __DUTY_SCHED_H__ */
@@ -0,0 +1,80 @@
+#ifndef __NET_MANAGER_H__
+#define __NET_MANAGER_H__
+
+#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "net_mgr_fsm.h"
+#include "wifi_fast_connect.h"
+
+/*
+ * net_mgr_fsm 在 ESP-IDF 上的驱动：wifi_fast_connect 连接、lwIP SNTP 同步、esp_timer 重试。
+ * 所有事件（Wi-Fi 结果、SNTP 通知、定时器）送入队列，由一个任务串行驱动状态机，
+ * 订阅者回调也在这个任务中调用，回调中不要长时间阻塞。
+ * 调用前需完成 esp_netif_init()、默认事件循环、STA netif 的创建和 esp_wifi_init()。
+ * SNTP 的同步通知由本组件设置，需要自定义校时时重写 sntp_sync_time()。
+ */
+
+typedef struct
+{
+    esp_netif_t *netif;         /*!< STA netif */
+    wifi_fc_config_t wifi;      /*!< ssid 指向的字符串需一直有效 */
+    const char *password;
+    wifi_fc_cache_t *cache;     /*!< RTC 内存中的连接缓存 */
+    const char *sntp_server;    /*!< NULL 表示不启动 SNTP，字符串需一直有效 */
+    uint32_t sntp_interval_ms;  /*!< 第一次同步后的同步间隔，之后可以用 sntp_set_sync_interval() 修改 */
+    bool sntp_smooth;           /*!< 用 adjtime 慢慢调整（没有重写 sntp_sync_time() 时有效） */
+    net_mgr_config_t fsm;
+    UBaseType_t task_priority;
+    uint32_t task_stack;
+} net_manager_config_t;
+
+#define NET_MANAGER_DEFAULT_CONFIG(n, s, p, c)      \
+    {                                               \
+        .netif = n,                                 \
+        .wifi = WIFI_FC_DEFAULT_CONFIG(s),          \
+        .password = p,                              \
+        .cache = c,                                 \
+        .sntp_server = "pool.ntp.org",              \
+        .sntp_interval_ms = 3600000,                \
+        .sntp_smooth = false,                       \
+        .fsm = NET_MGR_DEFAULT_CONFIG(),            \
+        .task_priority = 5,                         \
+        .task_stack = 3072,                         \
+    }
+
+/**
+ * @description: 启动管理任务并在后台开始连接，立即返回
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE（已经启动）/ ESP_ERR_NO_MEM
+ */
+esp_err_t net_manager_start(const net_manager_config_t *config);
+
+/**
+ * @description: 订阅状态变化，当前状态在 mask 中时立即（在调用者的任务中）回调一次
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE（没有启动）/ ESP_ERR_NO_MEM（订阅者已满）
+ * @param {uint32_t} mask 关心的状态，NET_STATE_BIT() 的组合
+ * @param {net_mgr_cb_t} cb 在管理任务中调用
+ */
+esp_err_t net_manager_subscribe(uint32_t mask, net_mgr_cb_t cb, void *ctx);
+
+esp_err_t net_manager_unsubscribe(net_mgr_cb_t cb, void *ctx);
+
+/**
+ * @description: 当前状态，没有启动时为 NET_STATE_OFF
+ */
+net_state_t net_manager_get_state(void);
+
+/**
+ * @description: 等待进入 mask 中的某个状态，只给确实离不开网络的地方用（例如进入深度睡眠前等同步）
+ * @return       ESP_OK / ESP_ERR_TIMEOUT / ESP_ERR_INVALID_STATE（没有启动）
+ * @param {net_state_t} *state 返回时的状态，可以为NULL
+ */
+esp_err_t net_manager_wait(uint32_t mask, TickType_t timeout, net_state_t *state);
+
+esp_err_t net_manager_get_status(net_mgr_status_t *status);
+
+/**
+ * @description: 停止 SNTP 和 Wi-Fi，结束管理任务
+ */
+void net_manager_stop(void);
+
+#endif /* __NET_MANAGER_H__ */
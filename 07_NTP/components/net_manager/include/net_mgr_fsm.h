@@ -0,0 +1,138 @@
+#ifndef __NET_MGR_FSM_H__
+#define __NET_MGR_FSM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * 联网过程（Wi-Fi 连接、取得地址、SNTP 同步）的状态机，与 ESP-IDF 无关，可以在PC上用模拟的驱动测试。
+ *
+ * 连接和 SNTP 都在后台进行，状态变化时通知订阅者，启动流程不必等网络：
+ * 本地外设（RTC、传感器、显示）先工作，需要网络的子系统订阅 ONLINE / SYNCED 后再开始。
+ * 一轮连接（含 wifi_fast_connect 自己的重试）失败后等待 retry_ms 再试，每次加倍到 max_retry_ms，
+ * max_rounds 轮都失败后进入 FAILED。连上后断开时回到 CONNECTING，驱动自动重连，SNTP 暂停。
+ *
+ * 所有事件必须串行送入 net_mgr_handle()，驱动回调和订阅者回调都在 net_mgr_handle() 内部调用。
+ */
+
+#define NET_MGR_MAX_SUBSCRIBERS 8
+
+typedef enum
+{
+    NET_STATE_OFF = 0,    /*!< 没有启动或已停止 */
+    NET_STATE_CONNECTING, /*!< Wi-Fi 连接、等待地址 */
+    NET_STATE_ONLINE,     /*!< 取得地址，SNTP 还没有同步 */
+    NET_STATE_SYNCED,     /*!< 取得地址，本次启动后 SNTP 同步过 */
+    NET_STATE_BACKOFF,    /*!< 一轮连接失败，等待重试 */
+    NET_STATE_FAILED,     /*!< max_rounds 轮连接都失败，Wi-Fi 已关闭 */
+    NET_STATE_MAX,
+} net_state_t;
+
+#define NET_STATE_BIT(s) (1u << (s))
+#define NET_STATE_ALL (NET_STATE_BIT(NET_STATE_MAX) - 1)
+
+typedef enum
+{
+    NET_EVENT_START = 0,
+    NET_EVENT_STOP,
+    NET_EVENT_WIFI_UP,     /*!< 取得地址 */
+    NET_EVENT_WIFI_DOWN,   /*!< 连上后断开，驱动正在重连 */
+    NET_EVENT_WIFI_FAILED, /*!< 这一轮连接的重试用完 */
+    NET_EVENT_TIME_SYNCED, /*!< SNTP 设置了系统时间 */
+    NET_EVENT_TIMEOUT,     /*!< set_timeout() 设置的超时 */
+} net_event_t;
+
+typedef struct net_mgr_driver_s net_mgr_driver_t;
+
+/**
+ * @brief 状态机用到的驱动操作
+ */
+struct net_mgr_driver_s
+{
+    /**
+     * @brief 开始一轮连接（第一次时启动 Wi-Fi），结果以 WIFI_UP / WIFI_FAILED 送回
+     */
+    esp_err_t (*wifi_start)(net_mgr_driver_t *drv);
+    void (*wifi_stop)(net_mgr_driver_t *drv);       /*!< 关闭 Wi-Fi，之后的 wifi_start 重新启动 */
+    esp_err_t (*sntp_start)(net_mgr_driver_t *drv); /*!< 开始 SNTP，同步后送入 TIME_SYNCED */
+    void (*sntp_stop)(net_mgr_driver_t *drv);
+    void (*set_timeout)(net_mgr_driver_t *drv, uint32_t ms); /*!< ms 毫秒后送入超时事件，0 取消 */
+    int64_t (*now_us)(net_mgr_driver_t *drv);               /*!< 单调时钟，测量各阶段的耗时 */
+};
+
+typedef struct
+{
+    bool sntp;             /*!< 取得地址后启动 SNTP */
+    uint32_t retry_ms;     /*!< 一轮连接失败后第一次等待的时间 */
+    uint32_t max_retry_ms; /*!< 等待时间加倍的上限 */
+    uint8_t max_rounds;    /*!< 连续失败几轮后进入 FAILED，0 表示一直重试 */
+} net_mgr_config_t;
+
+#define NET_MGR_DEFAULT_CONFIG()    \
+    {                               \
+        .sntp = true,               \
+        .retry_ms = 10000,          \
+        .max_retry_ms = 300000,     \
+        .max_rounds = 3,            \
+    }
+
+/**
+ * @brief 订阅者回调，state 是新状态，prev 是之前的状态（订阅时立即回调的一次两者相同）
+ */
+typedef void (*net_mgr_cb_t)(void *ctx, net_state_t state, net_state_t prev);
+
+typedef struct
+{
+    net_mgr_cb_t cb;
+    void *ctx;
+    uint32_t mask; /*!< 关心的状态，NET_STATE_BIT() 的组合 */
+} net_mgr_subscriber_t;
+
+typedef struct
+{
+    net_state_t state;
+    uint8_t rounds;          /*!< 连续失败的轮数 */
+    uint16_t disconnects;    /*!< 连上后断开的次数 */
+    uint16_t syncs;          /*!< SNTP 同步的次数 */
+    uint32_t time_to_ip_ms;  /*!< 从启动到第一次取得地址，0 表示还没有 */
+    uint32_t time_to_sync_ms; /*!< 从启动到第一次 SNTP 同步，0 表示还没有 */
+} net_mgr_status_t;
+
+typedef struct
+{
+    net_mgr_config_t config;
+    net_mgr_driver_t *drv;
+    net_state_t state;
+    uint32_t backoff_ms;     /*!< 下一次失败后等待的时间 */
+    int64_t start_us;
+    net_mgr_status_t status;
+    net_mgr_subscriber_t subscribers[NET_MGR_MAX_SUBSCRIBERS];
+} net_mgr_t;
+
+esp_err_t net_mgr_init(net_mgr_t *m, const net_mgr_config_t *config, net_mgr_driver_t *drv);
+
+/**
+ * @description: 订阅状态变化。当前状态在 mask 中时立即回调一次，晚启动的子系统不会错过已经发生的状态
+ * @return       ESP_OK / ESP_ERR_NO_MEM（订阅者已满）/ ESP_ERR_INVALID_ARG
+ * @param {uint32_t} mask 关心的状态，NET_STATE_BIT() 的组合
+ */
+esp_err_t net_mgr_subscribe(net_mgr_t *m, uint32_t mask, net_mgr_cb_t cb, void *ctx);
+
+/**
+ * @description: 取消订阅，可以在回调中调用
+ * @return       ESP_OK / ESP_ERR_NOT_FOUND
+ */
+esp_err_t net_mgr_unsubscribe(net_mgr_t *m, net_mgr_cb_t cb, void *ctx);
+
+/**
+ * @description: 送入一个事件，状态变化时通知订阅者
+ * @return       处理后的状态
+ */
+net_state_t net_mgr_handle(net_mgr_t *m, net_event_t event);
+
+void net_mgr_get_status(const net_mgr_t *m, net_mgr_status_t *status);
+
+const char *net_mgr_state_name(net_state_t state);
+
+#endif /* __NET_MGR_FSM_H__ */
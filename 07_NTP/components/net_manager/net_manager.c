@@ -0,0 +1,349 @@
+#include <stdlib.h>
+#include <string.h>
+#include "net_manager.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "net_mgr";
+
+#define NET_QUEUE_LEN 16
+#define NET_EVENT_EXIT (NET_EVENT_TIMEOUT + 1) // 只在本文件中使用：结束管理任务
+
+typedef struct
+{
+    net_mgr_driver_t parent;
+    net_mgr_t fsm;
+    net_manager_config_t config;
+    QueueHandle_t queue;       /*!< net_event_t，来自事件循环、lwIP 和 esp_timer 任务 */
+    SemaphoreHandle_t lock;    /*!< 保护状态机和订阅者，递归锁：回调中可以订阅和取消订阅 */
+    SemaphoreHandle_t done;    /*!< 管理任务退出后释放 */
+    EventGroupHandle_t states; /*!< 当前状态对应的一位，供 net_manager_wait() 等待 */
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+    bool wifi_started;
+    bool sntp_configured;
+} net_manager_t;
+
+static net_manager_t *s_nm = NULL;
+
+static void net_manager_post(net_manager_t *nm, int event)
+{
+    uint8_t msg = (uint8_t)event;
+    xQueueSend(nm->queue, &msg, portMAX_DELAY);
+}
+
+/**
+ * @description: wifi_fast_connect 的结果回调，在事件循环任务中调用
+ */
+static void net_wifi_cb(void *ctx, const wifi_fc_result_t *result)
+{
+    net_manager_t *nm = (net_manager_t *)ctx;
+    switch (result->state)
+    {
+    case WIFI_FC_STATE_CONNECTED:
+        net_manager_post(nm, NET_EVENT_WIFI_UP);
+        break;
+    case WIFI_FC_STATE_FAILED:
+        net_manager_post(nm, NET_EVENT_WIFI_FAILED);
+        break;
+    default:
+        net_manager_post(nm, NET_EVENT_WIFI_DOWN);
+        break;
+    }
+}
+
+/**
+ * @description: SNTP 设置系统时间后的通知，在 lwIP 任务中调用
+ */
+static void net_sntp_cb(struct timeval *tv)
+{
+    net_manager_t *nm = s_nm;
+    if (nm)
+    {
+        net_manager_post(nm, NET_EVENT_TIME_SYNCED);
+    }
+}
+
+static void net_timer_cb(void *arg)
+{
+    net_manager_post((net_manager_t *)arg, NET_EVENT_TIMEOUT);
+}
+
+static esp_err_t esp_drv_wifi_start(net_mgr_driver_t *drv)
+{
+    net_manager_t *nm = __containerof(drv, net_manager_t, parent);
+    if (nm->wifi_started)
+    {
+        return wifi_fast_connect_retry();
+    }
+    esp_err_t ret = wifi_fast_connect_start(nm->config.netif, &nm->config.wifi, nm->config.password,
+                                            nm->config.cache, net_wifi_cb, nm);
+    nm->wifi_started = ret == ESP_OK;
+    return ret;
+}
+
+static void esp_drv_wifi_stop(net_mgr_driver_t *drv)
+{
+    net_manager_t *nm = __containerof(drv, net_manager_t, parent);
+    if (nm->wifi_started)
+    {
+        wifi_fast_connect_stop();
+        nm->wifi_started = false;
+    }
+}
+
+static esp_err_t esp_drv_sntp_start(net_mgr_driver_t *drv)
+{
+    net_manager_t *nm = __containerof(drv, net_manager_t, parent);
+    if (sntp_enabled())
+    {
+        return ESP_OK;
+    }
+    if (!nm->sntp_configured)
+    {
+        // 同步间隔只在第一次设置，之后由应用按漂移调整
+        sntp_setoperatingmode(SNTP_OPMODE_POLL);
+        sntp_setservername(0, nm->config.sntp_server);
+        sntp_set_time_sync_notification_cb(net_sntp_cb);
+        sntp_set_sync_interval(nm->config.sntp_interval_ms);
+        sntp_set_sync_mode(nm->config.sntp_smooth ? SNTP_SYNC_MODE_SMOOTH : SNTP_SYNC_MODE_IMMED);
+        nm->sntp_configured = true;
+    }
+    sntp_init();
+    return ESP_OK;
+}
+
+static void esp_drv_sntp_stop(net_mgr_driver_t *drv)
+{
+    if (sntp_enabled())
+    {
+        sntp_stop();
+    }
+}
+
+static void esp_drv_set_timeout(net_mgr_driver_t *drv, uint32_t ms)
+{
+    net_manager_t *nm = __containerof(drv, net_manager_t, parent);
+    esp_timer_stop(nm->timer);
+    if (ms)
+    {
+        esp_timer_start_once(nm->timer, (uint64_t)ms * 1000);
+    }
+}
+
+static int64_t esp_drv_now_us(net_mgr_driver_t *drv)
+{
+    return esp_timer_get_time();
+}
+
+/**
+ * @description: 把当前状态反映到事件组，调用前持有 lock
+ */
+static void net_manager_publish(net_manager_t *nm)
+{
+    EventBits_t bit = NET_STATE_BIT(nm->fsm.state);
+    xEventGroupClearBits(nm->states, NET_STATE_ALL & ~bit);
+    xEventGroupSetBits(nm->states, bit);
+}
+
+static void net_manager_task(void *arg)
+{
+    net_manager_t *nm = (net_manager_t *)arg;
+    uint8_t msg;
+    while (xQueueReceive(nm->queue, &msg, portMAX_DELAY) == pdTRUE && msg != NET_EVENT_EXIT)
+    {
+        xSemaphoreTakeRecursive(nm->lock, portMAX_DELAY);
+        net_state_t prev = nm->fsm.state;
+        net_state_t state = net_mgr_handle(&nm->fsm, (net_event_t)msg);
+        net_manager_publish(nm);
+        if (state != prev)
+        {
+            ESP_LOGD(TAG, "%s -> %s, %lld ms since boot", net_mgr_state_name(prev), net_mgr_state_name(state),
+                     esp_timer_get_time() / 1000);
+        }
+        xSemaphoreGiveRecursive(nm->lock);
+    }
+    xSemaphoreGive(nm->done);
+    vTaskDelete(NULL);
+}
+
+static void net_manager_free(net_manager_t *nm)
+{
+    if (nm->timer)
+    {
+        esp_timer_stop(nm->timer);
+        esp_timer_delete(nm->timer);
+    }
+    if (nm->queue)
+    {
+        vQueueDelete(nm->queue);
+    }
+    if (nm->lock)
+    {
+        vSemaphoreDelete(nm->lock);
+    }
+    if (nm->done)
+    {
+        vSemaphoreDelete(nm->done);
+    }
+    if (nm->states)
+    {
+        vEventGroupDelete(nm->states);
+    }
+    free(nm);
+}
+
+esp_err_t net_manager_start(const net_manager_config_t *config)
+{
+    if (!config || !config->netif || !config->password || !config->cache)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_nm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    net_manager_t *nm = calloc(1, sizeof(net_manager_t));
+    if (!nm)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    nm->config = *config;
+    nm->parent.wifi_start = esp_drv_wifi_start;
+    nm->parent.wifi_stop = esp_drv_wifi_stop;
+    nm->parent.sntp_start = esp_drv_sntp_start;
+    nm->parent.sntp_stop = esp_drv_sntp_stop;
+    nm->parent.set_timeout = esp_drv_set_timeout;
+    nm->parent.now_us = esp_drv_now_us;
+    net_mgr_config_t fsm_config = config->fsm;
+    fsm_config.sntp = config->sntp_server != NULL;
+    net_mgr_init(&nm->fsm, &fsm_config, &nm->parent);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = net_timer_cb,
+        .arg = nm,
+        .name = "net_mgr",
+    };
+    nm->queue = xQueueCreate(NET_QUEUE_LEN, sizeof(uint8_t));
+    nm->lock = xSemaphoreCreateRecursiveMutex();
+    nm->done = xSemaphoreCreateBinary();
+    nm->states = xEventGroupCreate();
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (nm->queue && nm->lock && nm->done && nm->states)
+    {
+        ret = esp_timer_create(&timer_args, &nm->timer);
+    }
+    if (ret != ESP_OK)
+    {
+        net_manager_free(nm);
+        return ret;
+    }
+    net_manager_publish(nm);
+#ifdef CONFIG_LWIP_DHCP_GET_NTP_SRV
+    // DHCP 给出的 NTP 服务器优先，需要在取得地址之前设置
+    sntp_servermode_dhcp(1);
+#endif
+
+    s_nm = nm;
+    if (xTaskCreate(net_manager_task, "net_mgr", config->task_stack, nm, config->task_priority, &nm->task) != pdPASS)
+    {
+        s_nm = NULL;
+        net_manager_free(nm);
+        return ESP_ERR_NO_MEM;
+    }
+    net_manager_post(nm, NET_EVENT_START);
+    return ESP_OK;
+}
+
+esp_err_t net_manager_subscribe(uint32_t mask, net_mgr_cb_t cb, void *ctx)
+{
+    net_manager_t *nm = s_nm;
+    if (!nm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTakeRecursive(nm->lock, portMAX_DELAY);
+    esp_err_t ret = net_mgr_subscribe(&nm->fsm, mask, cb, ctx);
+    xSemaphoreGiveRecursive(nm->lock);
+    return ret;
+}
+
+esp_err_t net_manager_unsubscribe(net_mgr_cb_t cb, void *ctx)
+{
+    net_manager_t *nm = s_nm;
+    if (!nm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTakeRecursive(nm->lock, portMAX_DELAY);
+    esp_err_t ret = net_mgr_unsubscribe(&nm->fsm, cb, ctx);
+    xSemaphoreGiveRecursive(nm->lock);
+    return ret;
+}
+
+net_state_t net_manager_get_state(void)
+{
+    net_manager_t *nm = s_nm;
+    if (!nm)
+    {
+        return NET_STATE_OFF;
+    }
+    EventBits_t bits = xEventGroupGetBits(nm->states);
+    for (int s = 0; s < NET_STATE_MAX; s++)
+    {
+        if (bits & NET_STATE_BIT(s))
+        {
+            return (net_state_t)s;
+        }
+    }
+    return NET_STATE_OFF;
+}
+
+esp_err_t net_manager_wait(uint32_t mask, TickType_t timeout, net_state_t *state)
+{
+    net_manager_t *nm = s_nm;
+    if (!nm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    EventBits_t bits = xEventGroupWaitBits(nm->states, mask & NET_STATE_ALL, pdFALSE, pdFALSE, timeout);
+    if (state)
+    {
+        *state = net_manager_get_state();
+    }
+    return (bits & mask) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t net_manager_get_status(net_mgr_status_t *status)
+{
+    net_manager_t *nm = s_nm;
+    if (!nm)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTakeRecursive(nm->lock, portMAX_DELAY);
+    net_mgr_get_status(&nm->fsm, status);
+    xSemaphoreGiveRecursive(nm->lock);
+    return ESP_OK;
+}
+
+void net_manager_stop(void)
+{
+    net_manager_t *nm = s_nm;
+    if (!nm)
+    {
+        return;
+    }
+    // STOP 在管理任务中关闭 SNTP 和 Wi-Fi，之后不会再有 Wi-Fi 回调；最后一个消息让任务退出
+    net_manager_post(nm, NET_EVENT_STOP);
+    net_manager_post(nm, NET_EVENT_EXIT);
+    xSemaphoreTake(nm->done, portMAX_DELAY);
+    esp_timer_stop(nm->timer);
+    s_nm = NULL;
+    net_manager_free(nm);
+}
@@ -0,0 +1,205 @@
+#include <string.h>
+#include "net_mgr_fsm.h"
+
+const char *net_mgr_state_name(net_state_t state)
+{
+    static const char *const names[] = {"off", "connecting", "online", "synced", "backoff", "failed"};
+    return state < sizeof(names) / sizeof(names[0]) ? names[state] : "?";
+}
+
+esp_err_t net_mgr_init(net_mgr_t *m, const net_mgr_config_t *config, net_mgr_driver_t *drv)
+{
+    if (!m || !config || !drv)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(m, 0, sizeof(*m));
+    m->config = *config;
+    m->drv = drv;
+    return ESP_OK;
+}
+
+esp_err_t net_mgr_subscribe(net_mgr_t *m, uint32_t mask, net_mgr_cb_t cb, void *ctx)
+{
+    if (!cb || !(mask & NET_STATE_ALL))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < NET_MGR_MAX_SUBSCRIBERS; i++)
+    {
+        net_mgr_subscriber_t *s = &m->subscribers[i];
+        if (!s->cb)
+        {
+            s->cb = cb;
+            s->ctx = ctx;
+            s->mask = mask;
+            if (mask & NET_STATE_BIT(m->state))
+            {
+                cb(ctx, m->state, m->state);
+            }
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t net_mgr_unsubscribe(net_mgr_t *m, net_mgr_cb_t cb, void *ctx)
+{
+    for (int i = 0; i < NET_MGR_MAX_SUBSCRIBERS; i++)
+    {
+        net_mgr_subscriber_t *s = &m->subscribers[i];
+        if (s->cb == cb && s->ctx == ctx)
+        {
+            memset(s, 0, sizeof(*s));
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @description: 进入新状态，状态变了时按订阅顺序通知
+ */
+static void net_mgr_enter(net_mgr_t *m, net_state_t state)
+{
+    net_state_t prev = m->state;
+    m->state = state;
+    m->status.state = state;
+    if (state == prev)
+    {
+        return;
+    }
+    for (int i = 0; i < NET_MGR_MAX_SUBSCRIBERS; i++)
+    {
+        // 回调中可能取消订阅，先取出来
+        net_mgr_subscriber_t s = m->subscribers[i];
+        if (s.cb && (s.mask & NET_STATE_BIT(state)))
+        {
+            s.cb(s.ctx, state, prev);
+        }
+    }
+}
+
+static uint32_t net_mgr_elapsed_ms(net_mgr_t *m)
+{
+    int64_t ms = (m->drv->now_us(m->drv) - m->start_us) / 1000;
+    return ms > 0 ? (uint32_t)ms : 1;
+}
+
+/**
+ * @description: 一轮连接失败：还能重试时等待 backoff_ms，否则关闭 Wi-Fi
+ */
+static void net_mgr_round_failed(net_mgr_t *m)
+{
+    m->status.rounds++;
+    if (m->config.max_rounds && m->status.rounds >= m->config.max_rounds)
+    {
+        m->drv->set_timeout(m->drv, 0);
+        m->drv->wifi_stop(m->drv);
+        net_mgr_enter(m, NET_STATE_FAILED);
+        return;
+    }
+    m->drv->set_timeout(m->drv, m->backoff_ms);
+    m->backoff_ms = m->backoff_ms > m->config.max_retry_ms / 2 ? m->config.max_retry_ms : m->backoff_ms * 2;
+    net_mgr_enter(m, NET_STATE_BACKOFF);
+}
+
+static void net_mgr_connect(net_mgr_t *m)
+{
+    if (m->drv->wifi_start(m->drv) != ESP_OK)
+    {
+        net_mgr_round_failed(m);
+        return;
+    }
+    net_mgr_enter(m, NET_STATE_CONNECTING);
+}
+
+net_state_t net_mgr_handle(net_mgr_t *m, net_event_t event)
+{
+    const bool up = m->state == NET_STATE_ONLINE || m->state == NET_STATE_SYNCED;
+    switch (event)
+    {
+    case NET_EVENT_START:
+        if (m->state == NET_STATE_OFF || m->state == NET_STATE_FAILED)
+        {
+            if (m->state == NET_STATE_OFF)
+            {
+                memset(&m->status, 0, sizeof(m->status));
+                m->start_us = m->drv->now_us(m->drv);
+            }
+            m->status.rounds = 0;
+            m->backoff_ms = m->config.retry_ms;
+            net_mgr_connect(m);
+        }
+        break;
+    case NET_EVENT_STOP:
+        m->drv->set_timeout(m->drv, 0);
+        if (up && m->config.sntp)
+        {
+            m->drv->sntp_stop(m->drv);
+        }
+        if (m->state != NET_STATE_OFF && m->state != NET_STATE_FAILED)
+        {
+            m->drv->wifi_stop(m->drv);
+        }
+        net_mgr_enter(m, NET_STATE_OFF);
+        break;
+    case NET_EVENT_WIFI_UP:
+        if (m->state == NET_STATE_CONNECTING)
+        {
+            m->status.rounds = 0;
+            m->backoff_ms = m->config.retry_ms;
+            if (!m->status.time_to_ip_ms)
+            {
+                m->status.time_to_ip_ms = net_mgr_elapsed_ms(m);
+            }
+            if (m->config.sntp)
+            {
+                m->drv->sntp_start(m->drv);
+            }
+            // 重连后时间仍然是本次同步过的，SNTP 在后台继续
+            net_mgr_enter(m, m->status.syncs ? NET_STATE_SYNCED : NET_STATE_ONLINE);
+        }
+        break;
+    case NET_EVENT_WIFI_DOWN:
+        if (up)
+        {
+            m->status.disconnects++;
+            if (m->config.sntp)
+            {
+                m->drv->sntp_stop(m->drv);
+            }
+            net_mgr_enter(m, NET_STATE_CONNECTING);
+        }
+        break;
+    case NET_EVENT_WIFI_FAILED:
+        if (m->state == NET_STATE_CONNECTING)
+        {
+            net_mgr_round_failed(m);
+        }
+        break;
+    case NET_EVENT_TIME_SYNCED:
+        if (up)
+        {
+            m->status.syncs++;
+            if (!m->status.time_to_sync_ms)
+            {
+                m->status.time_to_sync_ms = net_mgr_elapsed_ms(m);
+            }
+            net_mgr_enter(m, NET_STATE_SYNCED);
+        }
+        break;
+    case NET_EVENT_TIMEOUT:
+        if (m->state == NET_STATE_BACKOFF)
+        {
+            net_mgr_connect(m);
+        }
+        break;
+    }
+    return m->state;
+}
+
+void net_mgr_get_status(const net_mgr_t *m, net_mgr_status_t *status)
+{
+    *status = m->status;
+}
@@ -0,0 +1,57 @@
+#ifndef __RX8025_H__
+#define __RX8025_H__
+
+#include <stdbool.h>
+#include <time.h>
+#include "esp_err.h"
+#include "driver/i2c.h"
+
+/*
+ * EPSON RX8025T 实时时钟（I2C）。时间寄存器是BCD码，没有秒以下的寄存器：
+ * 读时等秒寄存器跳变，可以得到毫秒级的时间；写秒寄存器时芯片内部的分频计数清零，在整秒写入即可对齐。
+ */
+
+#define RX8025_I2C_ADDR 0x32
+
+typedef struct
+{
+    i2c_port_t port;     /*!< 已经安装驱动的I2C主机 */
+    uint8_t addr;
+    uint32_t timeout_ms; /*!< 每次I2C传输的超时 */
+} rx8025_config_t;
+
+#define RX8025_DEFAULT_CONFIG(p)    \
+    {                               \
+        .port = p,                  \
+        .addr = RX8025_I2C_ADDR,    \
+        .timeout_ms = 100,          \
+    }
+
+typedef struct rx8025_s *rx8025_handle_t;
+
+/**
+ * @description: 初始化芯片（温度补偿间隔2s，关闭中断），检查掉电标志
+ * @return       ESP_OK / I2C的错误
+ * @param {bool} *power_lost 输出，芯片电压曾经过低，时间不可信（设置时间后清除）；可以为NULL
+ */
+esp_err_t rx8025_init(const rx8025_config_t *config, rx8025_handle_t *out, bool *power_lost);
+
+/**
+ * @description: 一次读出全部时间寄存器
+ */
+esp_err_t rx8025_get_time(rx8025_handle_t rtc, struct tm *tm);
+
+/**
+ * @description: 等到秒寄存器跳变后读出时间，返回时刚好是 tm 这一秒的开始
+ * @return       ESP_OK / ESP_ERR_TIMEOUT（1.1秒内没有跳变，芯片停振）/ I2C的错误
+ */
+esp_err_t rx8025_get_time_edge(rx8025_handle_t rtc, struct tm *tm);
+
+/**
+ * @description: 一次写入全部时间寄存器并清除掉电标志，写入时秒以下的计数清零
+ */
+esp_err_t rx8025_set_time(rx8025_handle_t rtc, const struct tm *tm);
+
+void rx8025_delete(rx8025_handle_t rtc);
+
+#endif /* __RX8025_H__ */
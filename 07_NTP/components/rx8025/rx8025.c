@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include "rx8025.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+
+#define RX8025_REG_SEC 0x00
+#define RX8025_REG_EXT 0x0D
+#define RX8025_REG_FLAG 0x0E
+#define RX8025_REG_CTRL 0x0F
+
+#define RX8025_FLAG_VLF 0x02  /*!< 电压过低，数据丢失 */
+#define RX8025_FLAG_VDET 0x01 /*!< 温度补偿停止过 */
+
+struct rx8025_s
+{
+    rx8025_config_t config;
+};
+
+static inline uint8_t bcd2bin(uint8_t v)
+{
+    return (v >> 4) * 10 + (v & 0x0F);
+}
+
+static inline uint8_t bin2bcd(uint8_t v)
+{
+    return ((v / 10) << 4) | (v % 10);
+}
+
+static esp_err_t rx8025_read(rx8025_handle_t rtc, uint8_t reg, uint8_t *data, size_t len)
+{
+    return i2c_master_write_read_device(rtc->config.port, rtc->config.addr, &reg, 1, data, len,
+                                        rtc->config.timeout_ms / portTICK_PERIOD_MS);
+}
+
+static esp_err_t rx8025_write(rx8025_handle_t rtc, uint8_t reg, const uint8_t *data, size_t len)
+{
+    uint8_t buf[8];
+    if (len + 1 > sizeof(buf))
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    buf[0] = reg;
+    for (size_t i = 0; i < len; i++)
+    {
+        buf[i + 1] = data[i];
+    }
+    return i2c_master_write_to_device(rtc->config.port, rtc->config.addr, buf, len + 1,
+                                      rtc->config.timeout_ms / portTICK_PERIOD_MS);
+}
+
+esp_err_t rx8025_init(const rx8025_config_t *config, rx8025_handle_t *out, bool *power_lost)
+{
+    if (!config || !out)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rx8025_handle_t rtc = calloc(1, sizeof(struct rx8025_s));
+    if (!rtc)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    rtc->config = *config;
+    uint8_t flag;
+    esp_err_t ret = rx8025_read(rtc, RX8025_REG_FLAG, &flag, 1);
+    if (ret == ESP_OK)
+    {
+        // 扩展寄存器：WADA=1，TSEL=2；控制寄存器：温度补偿间隔 2s，不开中断（同 05_IIC_RX8025）
+        const uint8_t ext = 0x42;
+        const uint8_t ctrl = 0x40;
+        ret = rx8025_write(rtc, RX8025_REG_EXT, &ext, 1);
+        if (ret == ESP_OK)
+        {
+            ret = rx8025_write(rtc, RX8025_REG_CTRL, &ctrl, 1);
+        }
+    }
+    if (ret != ESP_OK)
+    {
+        free(rtc);
+        return ret;
+    }
+    // VLF 不在这里清除，时间重新设置之前一直表示"不可信"
+    if (power_lost)
+    {
+        *power_lost = flag & RX8025_FLAG_VLF;
+    }
+    *out = rtc;
+    return ESP_OK;
+}
+
+esp_err_t rx8025_get_time(rx8025_handle_t rtc, struct tm *tm)
+{
+    uint8_t r[7];
+    esp_err_t ret = rx8025_read(rtc, RX8025_REG_SEC, r, sizeof(r));
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    *tm = (struct tm){
+        .tm_sec = bcd2bin(r[0] & 0x7F),
+        .tm_min = bcd2bin(r[1] & 0x7F),
+        .tm_hour = bcd2bin(r[2] & 0x3F),
+        .tm_mday = bcd2bin(r[4] & 0x3F),
+        .tm_mon = bcd2bin(r[5] & 0x1F) - 1,
+        .tm_year = bcd2bin(r[6]) + 100,
+        .tm_wday = 0,
+        .tm_isdst = 0,
+    };
+    // 星期寄存器是独热码，bit0 为星期日
+    for (int i = 0; i < 7; i++)
+    {
+        if (r[3] & (1 << i))
+        {
+            tm->tm_wday = i;
+            break;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t rx8025_get_time_edge(rx8025_handle_t rtc, struct tm *tm)
+{
+    uint8_t first, sec;
+    esp_err_t ret = rx8025_read(rtc, RX8025_REG_SEC, &first, 1);
+    int64_t deadline = esp_timer_get_time() + 1100000;
+    while (ret == ESP_OK)
+    {
+        // 一次单字节读约 100us（400kHz），间隔 200us 查询，边沿的误差在 0.3ms 以内
+        esp_rom_delay_us(200);
+        ret = rx8025_read(rtc, RX8025_REG_SEC, &sec, 1);
+        if (ret == ESP_OK && sec != first)
+        {
+            return rx8025_get_time(rtc, tm);
+        }
+        if (esp_timer_get_time() > deadline)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ret;
+}
+
+esp_err_t rx8025_set_time(rx8025_handle_t rtc, const struct tm *tm)
+{
+    if (tm->tm_year < 100 || tm->tm_year > 199)
+    {
+        return ESP_ERR_INVALID_ARG; // 芯片只存 2000~2099 年
+    }
+    const uint8_t r[7] = {
+        bin2bcd(tm->tm_sec),
+        bin2bcd(tm->tm_min),
+        bin2bcd(tm->tm_hour),
+        1 << (tm->tm_wday % 7),
+        bin2bcd(tm->tm_mday),
+        bin2bcd(tm->tm_mon + 1),
+        bin2bcd(tm->tm_year - 100),
+    };
+    esp_err_t ret = rx8025_write(rtc, RX8025_REG_SEC, r, sizeof(r));
+    if (ret == ESP_OK)
+    {
+        const uint8_t flag = 0x00;
+        ret = rx8025_write(rtc, RX8025_REG_FLAG, &flag, 1);
+    }
+    return ret;
+}
+
+void rx8025_delete(rx8025_handle_t rtc)
+{
+    free(rtc);
+}
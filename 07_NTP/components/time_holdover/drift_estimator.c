@@ -0,0 +1,155 @@
+#include <string.h>
+#include <math.h>
+#include "drift_estimator.h"
+
+static uint8_t drift_capacity(const drift_config_t *config)
+{
+    uint8_t n = config->max_samples;
+    return n < 2 ? 2 : n > DRIFT_MAX_SAMPLES ? DRIFT_MAX_SAMPLES : n;
+}
+
+static const drift_sample_t *drift_newest(const drift_estimator_t *de, uint8_t capacity)
+{
+    return &de->samples[(de->head + capacity - 1) % capacity];
+}
+
+void drift_reset(drift_estimator_t *de, const drift_config_t *config)
+{
+    memset(de, 0, sizeof(*de));
+    de->rms_us = config->noise_us;
+    de->poll_s = config->min_poll_s;
+}
+
+/**
+ * @description: 最小二乘拟合 offset = a + b·t。以最新的样本为原点，避免 double 丢失精度
+ */
+static void drift_fit(drift_estimator_t *de, const drift_config_t *config, uint8_t capacity)
+{
+    const drift_sample_t *origin = drift_newest(de, capacity);
+    double mx = 0, my = 0, min_x = 0;
+    for (uint8_t i = 0; i < de->count; i++)
+    {
+        double x = (de->samples[i].t_us - origin->t_us) * 1e-6;
+        mx += x;
+        my += de->samples[i].offset_us - origin->offset_us;
+        min_x = x < min_x ? x : min_x;
+    }
+    mx /= de->count;
+    my /= de->count;
+    double sxx = 0, sxy = 0;
+    for (uint8_t i = 0; i < de->count; i++)
+    {
+        double dx = (de->samples[i].t_us - origin->t_us) * 1e-6 - mx;
+        double dy = (de->samples[i].offset_us - origin->offset_us) - my;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+    if (de->count < 2 || sxx <= 0)
+    {
+        de->valid = false;
+        return;
+    }
+    double b = sxy / sxx; // us/s，即 ppm
+    double a = my - b * mx;
+    double ssr = 0;
+    for (uint8_t i = 0; i < de->count; i++)
+    {
+        double x = (de->samples[i].t_us - origin->t_us) * 1e-6;
+        double r = (de->samples[i].offset_us - origin->offset_us) - (a + b * x);
+        ssr += r * r;
+    }
+    double rms = de->count > 2 ? sqrt(ssr / (de->count - 2)) : 0;
+    rms = rms < config->noise_us ? config->noise_us : rms;
+    double sigma = rms / sqrt(sxx);
+
+    de->freq_ppb = (int32_t)lround(b * 1000);
+    de->sigma_ppb = (int32_t)ceil(sigma * 1000);
+    de->rms_us = (int32_t)ceil(rms);
+    de->fit_t_us = origin->t_us;
+    de->fit_offset_us = origin->offset_us + (int64_t)llround(a);
+    de->valid = -min_x >= config->min_span_s;
+}
+
+/**
+ * @description: 预测误差在 target_us 之内能维持多久，同步间隔最多加倍
+ */
+static void drift_update_poll(drift_estimator_t *de, const drift_config_t *config)
+{
+    uint64_t poll = config->min_poll_s;
+    double budget = config->target_us / 3.0 - de->rms_us;
+    if (de->valid && budget > 0)
+    {
+        double rate = (de->sigma_ppb + config->stability_ppb) * 1e-3; // us/s
+        double horizon = rate > 0 ? budget / rate : (double)config->max_poll_s;
+        poll = horizon > (double)config->max_poll_s ? config->max_poll_s : (uint64_t)horizon;
+        poll = poll > 2ULL * de->poll_s ? 2ULL * de->poll_s : poll;
+        poll = poll < config->min_poll_s ? config->min_poll_s : poll;
+    }
+    de->poll_s = (uint32_t)poll;
+}
+
+static void drift_push(drift_estimator_t *de, uint8_t capacity, int64_t t_us, int64_t offset_us)
+{
+    de->samples[de->head] = (drift_sample_t){.t_us = t_us, .offset_us = offset_us};
+    de->head = (de->head + 1) % capacity;
+    de->count = de->count < capacity ? de->count + 1 : capacity;
+}
+
+drift_result_t drift_add(drift_estimator_t *de, const drift_config_t *config, int64_t t_us, int64_t offset_us)
+{
+    uint8_t capacity = drift_capacity(config);
+    if (de->head >= capacity || de->count > capacity)
+    {
+        drift_reset(de, config); // 配置改小了
+    }
+    if (de->count > 0 && t_us - drift_newest(de, capacity)->t_us < (int64_t)config->min_spacing_s * 1000000)
+    {
+        return DRIFT_TOO_CLOSE;
+    }
+    if (de->valid && de->count >= 3)
+    {
+        int64_t resid = offset_us - drift_predict(de, t_us);
+        double limit = config->outlier_sigma *
+                       (de->rms_us + (de->sigma_ppb + config->stability_ppb) * 1e-9 * (t_us - de->fit_t_us));
+        if (fabs((double)resid) > limit)
+        {
+            if (++de->outliers < config->max_outliers)
+            {
+                // 先按网络延时突变处理，缩短同步间隔尽快确认
+                de->poll_s = de->poll_s / 2 < config->min_poll_s ? config->min_poll_s : de->poll_s / 2;
+                return DRIFT_OUTLIER;
+            }
+            drift_reset(de, config);
+            drift_push(de, capacity, t_us, offset_us);
+            return DRIFT_RESTARTED;
+        }
+    }
+    de->outliers = 0;
+    drift_push(de, capacity, t_us, offset_us);
+    drift_fit(de, config, capacity);
+    drift_update_poll(de, config);
+    return DRIFT_ACCEPTED;
+}
+
+int64_t drift_predict(const drift_estimator_t *de, int64_t t_us)
+{
+    if (de->count == 0)
+    {
+        return 0;
+    }
+    if (de->count < 2)
+    {
+        return de->samples[0].offset_us;
+    }
+    return de->fit_offset_us + (int64_t)((t_us - de->fit_t_us) * (de->freq_ppb * 1e-9));
+}
+
+int64_t drift_error_us(const drift_estimator_t *de, const drift_config_t *config, int64_t dt_us)
+{
+    if (!de->valid)
+    {
+        return INT64_MAX;
+    }
+    double rate = (de->sigma_ppb + config->stability_ppb) * 1e-9;
+    return (int64_t)(3 * (de->rms_us + rate * (dt_us < 0 ? -dt_us : dt_us)));
+}
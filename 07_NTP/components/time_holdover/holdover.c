@@ -0,0 +1,466 @@
+#include <string.h>
+#include <stddef.h>
+#include "holdover.h"
+#include "esp_rom_crc.h"
+
+#define HOLDOVER_DRIFT_SLEW_MAX_US 500000
+
+#define HOLDOVER_FLAG_RTC_VALID 0x02 /*!< 测量过RTC的误差，rtc_last_* 有效 */
+#define HOLDOVER_FLAG_RTC_DRIFT 0x04 /*!< rtc_drift_ppb 已经测出 */
+#define HOLDOVER_FLAG_RTC_BAD 0x08   /*!< RTC不存在、掉电或读写出错，重写成功之前不再读它 */
+
+static void holdover_seal(holdover_state_t *state)
+{
+    state->crc = esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(holdover_state_t, crc));
+}
+
+static bool holdover_state_valid(const holdover_state_t *state)
+{
+    return state->magic == HOLDOVER_STATE_MAGIC &&
+           state->crc == esp_rom_crc32_le(0, (const uint8_t *)state, offsetof(holdover_state_t, crc));
+}
+
+static inline int64_t abs64(int64_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+static inline int32_t clamp32(int64_t v)
+{
+    return v > INT32_MAX ? INT32_MAX : v < -INT32_MAX ? -INT32_MAX : (int32_t)v;
+}
+
+/**
+ * @description: dt 微秒内以 ppb 的频率偏差累积的时间误差，dt 到几十年也不会溢出
+ */
+static inline int64_t holdover_scale(int64_t dt, int32_t ppb)
+{
+    return dt / 1000 * ppb / 1000000;
+}
+
+static inline int32_t holdover_ppb(int64_t error_us, int64_t elapsed_us)
+{
+    return clamp32(error_us * 1000000000LL / elapsed_us);
+}
+
+static int32_t holdover_sys_rate(const holdover_t *h)
+{
+    const drift_estimator_t *de = &h->state->sys_drift;
+    if (!de->valid)
+    {
+        return h->config.sys_ppm * 1000;
+    }
+    int64_t rate = 3LL * ((int64_t)de->sigma_ppb + h->config.drift.stability_ppb);
+    return rate > h->config.sys_margin_ppm * 1000 ? clamp32(rate) : h->config.sys_margin_ppm * 1000;
+}
+
+static int32_t holdover_rtc_rate(const holdover_t *h)
+{
+    return (h->state->flags & HOLDOVER_FLAG_RTC_DRIFT ? h->config.rtc_margin_ppm : h->config.rtc_ppm) * 1000;
+}
+
+static int64_t holdover_sys_uncertainty(const holdover_t *h, int64_t now)
+{
+    const holdover_state_t *s = h->state;
+    if (s->source == HOLDOVER_SOURCE_NONE)
+    {
+        return INT64_MAX;
+    }
+    return s->err_base_us + holdover_scale(abs64(now - s->err_ref_us), s->err_rate_ppb);
+}
+
+// RTC 是对着刚同步过的系统时间测量的，SNTP 的误差也在里面
+static int64_t holdover_rtc_base(const holdover_t *h)
+{
+    return ((int64_t)h->config.rtc_error_ms + h->config.sntp_error_ms) * 1000;
+}
+
+/**
+ * @description: 在 t 时刻从RTC读出的时间（补偿漂移之后）的误差
+ */
+static int64_t holdover_rtc_uncertainty(const holdover_t *h, int64_t t)
+{
+    const holdover_state_t *s = h->state;
+    if (s->flags & HOLDOVER_FLAG_RTC_BAD)
+    {
+        return INT64_MAX;
+    }
+    if (!(s->flags & HOLDOVER_FLAG_RTC_VALID))
+    {
+        return (int64_t)h->config.rtc_cold_error_ms * 1000;
+    }
+    return holdover_rtc_base(h) + holdover_scale(abs64(t - s->rtc_last_us), holdover_rtc_rate(h));
+}
+
+/**
+ * @description: 预计在 t 时刻 RTC - 真实时间 是多少
+ */
+static int64_t holdover_rtc_offset(const holdover_t *h, int64_t t)
+{
+    const holdover_state_t *s = h->state;
+    if (!(s->flags & HOLDOVER_FLAG_RTC_VALID))
+    {
+        return 0;
+    }
+    int64_t offset = s->rtc_last_offset_us;
+    if (s->flags & HOLDOVER_FLAG_RTC_DRIFT)
+    {
+        offset += holdover_scale(t - s->rtc_last_us, s->rtc_drift_ppb);
+    }
+    return offset;
+}
+
+/**
+ * @description: 校正系统时间。时间已知时记入 sys_total_corr_us，测漂移时要扣掉
+ * @param {bool} slew 用 sys_adjust 慢慢调整，否则直接设置
+ */
+static void holdover_sys_apply(holdover_t *h, int64_t delta_us, bool slew)
+{
+    holdover_hw_t *hw = h->hw;
+    if (slew)
+    {
+        hw->sys_adjust(hw, delta_us);
+    }
+    else
+    {
+        hw->sys_set(hw, hw->sys_get(hw) + delta_us);
+    }
+    if (h->state->source != HOLDOVER_SOURCE_NONE)
+    {
+        h->state->sys_total_corr_us += delta_us;
+    }
+}
+
+static void holdover_sys_correct(holdover_t *h, int64_t delta_us)
+{
+    holdover_sys_apply(h, delta_us, h->config.slew_limit_ms && abs64(delta_us) <= (int64_t)h->config.slew_limit_ms * 1000);
+}
+
+/**
+ * @description: 按测出的漂移补偿从 sys_corr_us 到 now 累积的误差
+ */
+static void holdover_apply_drift(holdover_t *h, int64_t now)
+{
+    holdover_state_t *s = h->state;
+    int64_t corr = 0;
+    if (s->sys_drift.valid && s->source != HOLDOVER_SOURCE_NONE)
+    {
+        corr = holdover_scale(now - s->sys_corr_us, s->sys_drift.freq_ppb);
+    }
+    if (corr != 0)
+    {
+        // 持续补偿的量很小，即使 slew_limit_ms 为 0 也用 adjtime，不让时间跳变
+        holdover_sys_apply(h, -corr, abs64(corr) <= HOLDOVER_DRIFT_SLEW_MAX_US || h->config.slew_limit_ms);
+    }
+    s->sys_corr_us = now - corr;
+}
+
+void holdover_rtc_sample(holdover_t *h, holdover_rtc_sample_t *sample)
+{
+    sample->ret = h->hw->rtc_read(h->hw, &sample->rtc_us);
+    sample->sys_us = h->hw->sys_get(h->hw);
+}
+
+/**
+ * @description: 用读出的RTC时间设置系统时间，读出之后系统时间有调整时按读出时的差值校正
+ */
+static esp_err_t holdover_seed_apply(holdover_t *h, const holdover_rtc_sample_t *sample)
+{
+    holdover_state_t *s = h->state;
+    esp_err_t ret = sample->ret;
+    if (ret != ESP_OK)
+    {
+        s->flags |= HOLDOVER_FLAG_RTC_BAD;
+        if (ret == ESP_ERR_INVALID_STATE)
+        {
+            s->flags &= ~(HOLDOVER_FLAG_RTC_VALID | HOLDOVER_FLAG_RTC_DRIFT);
+        }
+        holdover_seal(s);
+        return ret;
+    }
+    int64_t rtc_us = sample->rtc_us;
+    int64_t uncertainty = holdover_rtc_uncertainty(h, rtc_us);
+    int64_t now = rtc_us - holdover_rtc_offset(h, rtc_us);
+    holdover_sys_apply(h, now - sample->sys_us, false);
+    s->source = HOLDOVER_SOURCE_RTC;
+    s->err_base_us = clamp32(uncertainty);
+    s->err_ref_us = now;
+    s->err_rate_ppb = holdover_sys_rate(h);
+    s->sys_corr_us = now;
+    holdover_seal(s);
+    return ESP_OK;
+}
+
+static esp_err_t holdover_seed_from_rtc(holdover_t *h)
+{
+    holdover_rtc_sample_t sample;
+    holdover_rtc_sample(h, &sample);
+    return holdover_seed_apply(h, &sample);
+}
+
+esp_err_t holdover_init(holdover_t *h, const holdover_config_t *config, holdover_hw_t *hw, holdover_state_t *state)
+{
+    if (!h || !config || !hw || !state)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    h->config = *config;
+    h->hw = hw;
+    h->state = state;
+    h->rtc_token_us = 0;
+    if (!holdover_state_valid(state))
+    {
+        memset(state, 0, sizeof(*state));
+        state->magic = HOLDOVER_STATE_MAGIC;
+        drift_reset(&state->sys_drift, &config->drift);
+        holdover_seal(state);
+    }
+    return ESP_OK;
+}
+
+holdover_source_t holdover_boot(holdover_t *h)
+{
+    holdover_state_t *s = h->state;
+    int64_t now = h->hw->sys_get(h->hw);
+    if (s->source != HOLDOVER_SOURCE_NONE && now >= s->err_ref_us)
+    {
+        // 深度睡眠唤醒或软件复位，系统时钟一直在走
+        holdover_check(h);
+        return s->source;
+    }
+    // 系统时钟从头开始了，之前测量漂移的起点也不再有意义
+    s->source = HOLDOVER_SOURCE_NONE;
+    s->sys_total_corr_us = 0;
+    drift_reset(&s->sys_drift, &h->config.drift);
+    s->flags &= ~HOLDOVER_FLAG_RTC_BAD;
+    holdover_seal(s);
+    holdover_seed_from_rtc(h);
+    return s->source;
+}
+
+bool holdover_check_begin(holdover_t *h)
+{
+    holdover_state_t *s = h->state;
+    h->rtc_token_us = s->sync_us;
+    if (s->source == HOLDOVER_SOURCE_NONE)
+    {
+        return !(s->flags & HOLDOVER_FLAG_RTC_BAD);
+    }
+    int64_t now = h->hw->sys_get(h->hw);
+    holdover_apply_drift(h, now);
+    holdover_seal(s);
+    int64_t uncertainty = holdover_sys_uncertainty(h, now);
+    return uncertainty > (int64_t)h->config.max_error_ms * 1000 && holdover_rtc_uncertainty(h, now) < uncertainty;
+}
+
+void holdover_check_rtc(holdover_t *h, const holdover_rtc_sample_t *sample)
+{
+    // 读RTC期间 SNTP 同步过，系统时间已经比RTC准
+    if (h->state->sync_us == h->rtc_token_us)
+    {
+        holdover_seed_apply(h, sample);
+    }
+}
+
+void holdover_check(holdover_t *h)
+{
+    if (holdover_check_begin(h))
+    {
+        holdover_seed_from_rtc(h);
+    }
+}
+
+void holdover_correct(holdover_t *h)
+{
+    if (h->state->source != HOLDOVER_SOURCE_NONE)
+    {
+        holdover_apply_drift(h, h->hw->sys_get(h->hw));
+        holdover_seal(h->state);
+    }
+}
+
+void holdover_on_sntp(holdover_t *h, int64_t true_us)
+{
+    holdover_state_t *s = h->state;
+    int64_t error = h->hw->sys_get(h->hw) - true_us;
+    if (s->source == HOLDOVER_SOURCE_NONE)
+    {
+        // 时间未知时直接设置，不计入校正量：之后振荡器本身的偏差从 0 开始
+        drift_reset(&s->sys_drift, &h->config.drift);
+        s->sys_total_corr_us = 0;
+        drift_add(&s->sys_drift, &h->config.drift, true_us, 0);
+    }
+    else
+    {
+        drift_add(&s->sys_drift, &h->config.drift, true_us, error - s->sys_total_corr_us);
+    }
+
+    holdover_sys_correct(h, -error);
+    s->sys_corr_us = true_us;
+    s->sync_us = true_us;
+    s->source = HOLDOVER_SOURCE_SNTP;
+    s->err_base_us = h->config.sntp_error_ms * 1000;
+    s->err_ref_us = true_us;
+    s->err_rate_ppb = holdover_sys_rate(h);
+    holdover_seal(s);
+}
+
+esp_err_t holdover_sync_rtc_begin(holdover_t *h)
+{
+    holdover_state_t *s = h->state;
+    if (s->source != HOLDOVER_SOURCE_SNTP ||
+        holdover_sys_uncertainty(h, h->hw->sys_get(h->hw)) > (int64_t)h->config.max_error_ms * 1000)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    h->rtc_token_us = s->sync_us;
+    return ESP_OK;
+}
+
+esp_err_t holdover_sync_rtc_measured(holdover_t *h, const holdover_rtc_sample_t *sample, bool *rewrite)
+{
+    holdover_state_t *s = h->state;
+    *rewrite = false;
+    // 读RTC期间 SNTP 又同步过，测量对着的是校正之前的系统时间
+    if (s->sync_us != h->rtc_token_us)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = sample->ret;
+    int64_t now = sample->sys_us;
+    if (ret == ESP_ERR_INVALID_STATE)
+    {
+        s->flags &= ~(HOLDOVER_FLAG_RTC_VALID | HOLDOVER_FLAG_RTC_DRIFT);
+    }
+    else if (ret != ESP_OK)
+    {
+        s->flags |= HOLDOVER_FLAG_RTC_BAD;
+        holdover_seal(s);
+        return ret;
+    }
+    else
+    {
+        int64_t offset = sample->rtc_us - now;
+        if (s->flags & HOLDOVER_FLAG_RTC_VALID)
+        {
+            // 从写入（或第一次测量）算起，间隔越长测得越准
+            int64_t elapsed = now - s->rtc_ref_us;
+            if (elapsed >= (int64_t)h->config.min_drift_interval_s * 1000000)
+            {
+                s->rtc_drift_ppb = holdover_ppb(offset - s->rtc_ref_offset_us, elapsed);
+                s->flags |= HOLDOVER_FLAG_RTC_DRIFT;
+            }
+        }
+        else
+        {
+            s->rtc_ref_us = now;
+            s->rtc_ref_offset_us = clamp32(offset);
+            s->flags |= HOLDOVER_FLAG_RTC_VALID;
+        }
+        s->rtc_last_us = now;
+        s->rtc_last_offset_us = clamp32(offset);
+        s->flags &= ~HOLDOVER_FLAG_RTC_BAD;
+        if (abs64(offset) <= (int64_t)h->config.rtc_rewrite_ms * 1000)
+        {
+            holdover_seal(s);
+            return ESP_OK;
+        }
+    }
+    holdover_seal(s);
+    *rewrite = true;
+    return ESP_OK;
+}
+
+esp_err_t holdover_sync_rtc_written(holdover_t *h, esp_err_t ret)
+{
+    holdover_state_t *s = h->state;
+    if (ret != ESP_OK)
+    {
+        s->flags |= HOLDOVER_FLAG_RTC_BAD;
+        holdover_seal(s);
+        return ret;
+    }
+    // 已测出的漂移是晶振的特性，重写后继续有效
+    int64_t now = h->hw->sys_get(h->hw);
+    s->rtc_ref_us = now;
+    s->rtc_ref_offset_us = 0;
+    s->rtc_last_us = now;
+    s->rtc_last_offset_us = 0;
+    s->flags = (s->flags | HOLDOVER_FLAG_RTC_VALID) & ~HOLDOVER_FLAG_RTC_BAD;
+    holdover_seal(s);
+    return ESP_OK;
+}
+
+esp_err_t holdover_sync_rtc(holdover_t *h)
+{
+    esp_err_t ret = holdover_sync_rtc_begin(h);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    holdover_rtc_sample_t sample;
+    holdover_rtc_sample(h, &sample);
+    bool rewrite;
+    ret = holdover_sync_rtc_measured(h, &sample, &rewrite);
+    if (ret != ESP_OK || !rewrite)
+    {
+        return ret;
+    }
+    return holdover_sync_rtc_written(h, h->hw->rtc_write(h->hw));
+}
+
+/**
+ * @description: 误差从 base_us 开始以 rate_ppb 增长，到达 limit_us 的时间
+ */
+static int64_t holdover_reach(int64_t ref_us, int64_t base_us, int32_t rate_ppb, int64_t limit_us)
+{
+    if (base_us >= limit_us)
+    {
+        return ref_us;
+    }
+    if (rate_ppb <= 0)
+    {
+        return INT64_MAX;
+    }
+    return ref_us + (limit_us - base_us) * 1000 / rate_ppb * 1000000;
+}
+
+void holdover_get_status(holdover_t *h, holdover_status_t *status)
+{
+    const holdover_state_t *s = h->state;
+    int64_t now = h->hw->sys_get(h->hw);
+    int64_t limit = (int64_t)h->config.max_error_ms * 1000;
+    memset(status, 0, sizeof(*status));
+    status->source = s->source;
+    status->uncertainty_us = holdover_sys_uncertainty(h, now);
+    status->sys_drift_valid = s->sys_drift.valid;
+    status->sys_drift_ppb = s->sys_drift.freq_ppb;
+    status->sys_sigma_ppb = s->sys_drift.sigma_ppb;
+    status->poll_s = s->sys_drift.poll_s;
+    status->rtc_drift_valid = s->flags & HOLDOVER_FLAG_RTC_DRIFT;
+    status->rtc_drift_ppb = s->rtc_drift_ppb;
+    status->rtc_offset_us = s->rtc_last_offset_us;
+
+    int64_t next = 0;
+    if (s->source != HOLDOVER_SOURCE_NONE)
+    {
+        next = holdover_reach(s->err_ref_us, s->err_base_us, s->err_rate_ppb, limit);
+        // 系统时钟误差太大时还可以从RTC重新读，两者都超过时才需要网络
+        if ((s->flags & (HOLDOVER_FLAG_RTC_VALID | HOLDOVER_FLAG_RTC_BAD)) == HOLDOVER_FLAG_RTC_VALID)
+        {
+            int64_t rtc_next = holdover_reach(s->rtc_last_us, holdover_rtc_base(h), holdover_rtc_rate(h), limit);
+            next = rtc_next > next ? rtc_next : next;
+        }
+        int64_t last = s->sync_us ? s->sync_us : s->err_ref_us;
+        int64_t deadline = last + (int64_t)h->config.max_interval_s * 1000000;
+        next = deadline < next ? deadline : next;
+    }
+    status->sync_due = next <= now;
+    status->next_sync_us = status->sync_due ? 0 : next;
+}
+
+const char *holdover_source_name(holdover_source_t source)
+{
+    static const char *const names[] = {"none", "rtc", "sntp"};
+    return source < sizeof(names) / sizeof(names[0]) ? names[source] : "?";
+}
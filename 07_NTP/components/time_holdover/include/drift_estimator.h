@@ -0,0 +1,96 @@
+#ifndef __DRIFT_ESTIMATOR_H__
+#define __DRIFT_ESTIMATOR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 时钟频率偏差（漂移）的估计，与 ESP-IDF 无关。
+ *
+ * 每次同步记录一个样本：同步的时间和"未经任何校正的本地时钟 - 真实时间"的偏差。
+ * 对最近 max_samples 个样本做最小二乘直线拟合，斜率就是频率偏差，残差给出测量噪声，
+ * 斜率的标准差加上振荡器本身的频率变化给出估计的可信程度。可信程度越高，同步间隔（poll_s）越长，每次最多加倍。
+ * 偏离拟合直线太远的样本（网络延时突变）丢弃，连续多个都偏离时认为频率变了，重新开始。
+ *
+ * drift_estimator_t 不含指针，可以放在 RTC 内存中。
+ */
+
+#define DRIFT_MAX_SAMPLES 16
+
+typedef struct
+{
+    uint8_t max_samples;    /*!< 参与拟合的样本数，不超过 DRIFT_MAX_SAMPLES */
+    uint8_t outlier_sigma;  /*!< 偏离拟合直线超过几倍残差算离群 */
+    uint8_t max_outliers;   /*!< 连续几个离群后重新开始 */
+    uint32_t min_span_s;    /*!< 样本跨度达到它之后估计才有效 */
+    uint32_t min_spacing_s; /*!< 与上一个样本间隔太短时不记录 */
+    uint32_t noise_us;      /*!< 单次测量误差的下限，样本少时残差不可信 */
+    uint32_t stability_ppb; /*!< 振荡器频率本身的变化（温度、老化），拟合的标准差反映不出来，加在它上面 */
+    uint32_t target_us;     /*!< 两次同步之间允许累积的误差，决定同步间隔 */
+    uint32_t min_poll_s;
+    uint32_t max_poll_s;
+} drift_config_t;
+
+#define DRIFT_DEFAULT_CONFIG()          \
+    {                                   \
+        .max_samples = 8,               \
+        .outlier_sigma = 4,             \
+        .max_outliers = 3,              \
+        .min_span_s = 1800,             \
+        .min_spacing_s = 60,            \
+        .noise_us = 5000,               \
+        .stability_ppb = 200,           \
+        .target_us = 50000,             \
+        .min_poll_s = 300,              \
+        .max_poll_s = 86400,            \
+    }
+
+typedef struct
+{
+    int64_t t_us;      /*!< 同步的时间 */
+    int64_t offset_us; /*!< 未经校正的本地时钟 - 真实时间 */
+} drift_sample_t;
+
+typedef enum
+{
+    DRIFT_ACCEPTED = 0,
+    DRIFT_TOO_CLOSE,  /*!< 与上一个样本间隔不到 min_spacing_s，没有记录 */
+    DRIFT_OUTLIER,    /*!< 偏离拟合直线太远，丢弃 */
+    DRIFT_RESTARTED,  /*!< 连续离群，清空后从这个样本重新开始 */
+} drift_result_t;
+
+typedef struct
+{
+    drift_sample_t samples[DRIFT_MAX_SAMPLES];
+    uint8_t count;
+    uint8_t head;          /*!< 下一个样本写入的位置 */
+    uint8_t outliers;      /*!< 连续离群的个数 */
+    bool valid;            /*!< freq_ppb 可用 */
+    int32_t freq_ppb;      /*!< 本地时钟比真实时间快多少 */
+    int32_t sigma_ppb;     /*!< freq_ppb 的标准差 */
+    int32_t rms_us;        /*!< 拟合残差的均方根（不小于 noise_us） */
+    int64_t fit_t_us;      /*!< 拟合直线经过 (fit_t_us, fit_offset_us) */
+    int64_t fit_offset_us;
+    uint32_t poll_s;       /*!< 建议的同步间隔 */
+} drift_estimator_t;
+
+void drift_reset(drift_estimator_t *de, const drift_config_t *config);
+
+/**
+ * @description: 记录一次同步的结果并重新拟合
+ * @param {int64_t} t_us 同步的时间（真实时间）
+ * @param {int64_t} offset_us 未经校正的本地时钟 - 真实时间，即测得的偏差减去之前所有校正量之和
+ */
+drift_result_t drift_add(drift_estimator_t *de, const drift_config_t *config, int64_t t_us, int64_t offset_us);
+
+/**
+ * @description: 按拟合直线预测 t_us 时的偏差（未经校正的本地时钟 - 真实时间）
+ */
+int64_t drift_predict(const drift_estimator_t *de, int64_t t_us);
+
+/**
+ * @description: 最后一个样本之后 dt_us 的预测误差（3σ）
+ */
+int64_t drift_error_us(const drift_estimator_t *de, const drift_config_t *config, int64_t dt_us);
+
+#endif /* __DRIFT_ESTIMATOR_H__ */
@@ -0,0 +1,213 @@
+#ifndef __HOLDOVER_H__
+#define __HOLDOVER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "drift_estimator.h"
+
+/*
+ * 系统时钟、外部RTC和SNTP三者之间的授时与守时，与 ESP-IDF 无关，可以在PC上用模拟的时钟测试。
+ *
+ * 启动时系统时钟保留着（深度睡眠唤醒）就继续用，否则从RTC读出时间设置系统时钟，不等网络。
+ * SNTP 同步时校正系统时钟，并测出系统时钟和RTC相对于 SNTP 的频率偏差（漂移）：
+ * 系统时钟每次同步的偏差送入 drift_estimator 做最小二乘拟合，RTC 用从写入到现在的总偏差计算。
+ * 之后按测出的漂移持续补偿系统时钟（holdover_correct），按剩余的误差估计当前时间的不确定度，
+ * 不确定度超过 max_error_ms 时才需要再同步；一直联网时按拟合的可信程度给出 SNTP 的同步间隔。
+ * RTC 的误差超过 rtc_rewrite_ms 时用系统时钟重写RTC。
+ *
+ * 时间都是 Unix 时间（UTC），单位微秒。状态放在 RTC 内存（RTC_DATA_ATTR）中，深度睡眠后继续使用。
+ * 函数不可重入，需要调用者加锁。读写RTC要等秒跳变（约1秒），holdover_check 和 holdover_sync_rtc
+ * 另有分步的版本：读写RTC的一步不必持锁，其间 SNTP 同步过时丢弃读出的结果。
+ */
+
+#define HOLDOVER_STATE_MAGIC 0x444C4F48 // "HOLD"
+
+typedef enum
+{
+    HOLDOVER_SOURCE_NONE = 0, /*!< 时间未知 */
+    HOLDOVER_SOURCE_RTC,      /*!< 系统时间由RTC设置 */
+    HOLDOVER_SOURCE_SNTP,     /*!< 系统时间由 SNTP 设置 */
+} holdover_source_t;
+
+typedef struct holdover_hw_s holdover_hw_t;
+
+/**
+ * @brief 用到的时钟操作
+ */
+struct holdover_hw_s
+{
+    /**
+     * @brief 等到RTC的秒跳变后读出时间，返回时刚好是 *us 这一刻
+     * @return ESP_OK / ESP_ERR_INVALID_STATE（RTC掉电过，时间不可信）/ ESP_ERR_NOT_FOUND（没有RTC）/ 其他错误
+     */
+    esp_err_t (*rtc_read)(holdover_hw_t *hw, int64_t *us);
+    esp_err_t (*rtc_write)(holdover_hw_t *hw); /*!< 在系统时间的整秒处把系统时间写入RTC */
+    int64_t (*sys_get)(holdover_hw_t *hw);     /*!< 系统时间，包括 sys_adjust 还没调整完的部分 */
+    void (*sys_set)(holdover_hw_t *hw, int64_t us);
+    void (*sys_adjust)(holdover_hw_t *hw, int64_t delta_us); /*!< 慢慢调整系统时间（adjtime） */
+};
+
+/**
+ * @brief 放在 RTC 内存中的状态
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint8_t source;           /*!< holdover_source_t */
+    uint8_t flags;
+    uint8_t reserved[2];
+    int64_t sync_us;          /*!< 上次 SNTP 同步的时间，0 表示没有同步过 */
+    int64_t err_ref_us;       /*!< 系统时间的误差：err_base_us + |t - err_ref_us| × err_rate_ppb */
+    int64_t sys_corr_us;      /*!< 已经按漂移补偿到的系统时间 */
+    int64_t sys_total_corr_us; /*!< 系统时钟上次从头开始以来所有校正量之和，从测得的偏差中减去后得到振荡器本身的偏差 */
+    int64_t rtc_ref_us;       /*!< 测量RTC漂移的起点（写入RTC或第一次测量的时间） */
+    int64_t rtc_last_us;      /*!< 上次测量RTC误差的时间 */
+    int32_t err_base_us;
+    int32_t err_rate_ppb;
+    int32_t rtc_drift_ppb;    /*!< RTC比真实时间快多少 */
+    int32_t rtc_ref_offset_us;
+    int32_t rtc_last_offset_us; /*!< RTC - 真实时间 */
+    drift_estimator_t sys_drift; /*!< 系统时钟的漂移 */
+    uint32_t crc;
+} holdover_state_t;
+
+typedef struct
+{
+    uint32_t max_error_ms;         /*!< 估计的误差超过它时需要同步 */
+    uint32_t max_interval_s;       /*!< 最长同步间隔 */
+    uint32_t min_drift_interval_s; /*!< 测量RTC漂移的最短时间，太短时测量误差占主导 */
+    uint32_t correct_interval_s;   /*!< 运行中每隔多久按漂移补偿一次系统时钟（由调用者定时调用 holdover_correct） */
+    uint32_t sntp_error_ms;        /*!< 一次 SNTP 同步后的误差 */
+    uint32_t rtc_error_ms;         /*!< 读、写RTC的误差 */
+    uint32_t rtc_cold_error_ms;    /*!< 状态丢失（断电）后RTC时间的误差，RTC上次何时校准未知 */
+    uint32_t rtc_rewrite_ms;       /*!< RTC的误差超过它时重写RTC */
+    uint32_t slew_limit_ms;        /*!< 偏差不超过它时用 sys_adjust 慢慢调整，超过时直接设置；0 表示总是直接设置 */
+    uint16_t sys_ppm;              /*!< 没有测出漂移时系统时钟的误差（深度睡眠中用的是RTC慢速时钟） */
+    uint16_t sys_margin_ppm;       /*!< 补偿漂移后系统时钟剩余误差的下限，拟合给出的 3σ 更大时用 3σ */
+    uint16_t rtc_ppm;              /*!< 没有测出漂移时RTC的误差，RX8025T 为 ±3.4ppm */
+    uint16_t rtc_margin_ppm;       /*!< 补偿漂移后RTC剩余的误差 */
+    drift_config_t drift;          /*!< 系统时钟漂移的估计和 SNTP 同步间隔 */
+} holdover_config_t;
+
+#define HOLDOVER_DEFAULT_CONFIG()           \
+    {                                       \
+        .max_error_ms = 100,                \
+        .max_interval_s = 86400,            \
+        .min_drift_interval_s = 1800,       \
+        .correct_interval_s = 10,           \
+        .sntp_error_ms = 20,                \
+        .rtc_error_ms = 2,                  \
+        .rtc_cold_error_ms = 1000,          \
+        .rtc_rewrite_ms = 20,               \
+        .slew_limit_ms = 100,               \
+        .sys_ppm = 500,                     \
+        .sys_margin_ppm = 50,               \
+        .rtc_ppm = 5,                       \
+        .rtc_margin_ppm = 1,                \
+        .drift = DRIFT_DEFAULT_CONFIG(),    \
+    }
+
+typedef struct
+{
+    holdover_source_t source;
+    int64_t uncertainty_us;   /*!< 当前系统时间的估计误差，时间未知时为 INT64_MAX */
+    int64_t next_sync_us;     /*!< 到这个系统时间需要同步，0 表示现在就需要 */
+    bool sync_due;
+    bool sys_drift_valid;
+    bool rtc_drift_valid;
+    int32_t sys_drift_ppb;
+    int32_t sys_sigma_ppb;    /*!< sys_drift_ppb 的标准差 */
+    int32_t rtc_drift_ppb;
+    int32_t rtc_offset_us;    /*!< 上次测得的 RTC - 真实时间 */
+    uint32_t poll_s;          /*!< 一直联网时建议的 SNTP 同步间隔 */
+} holdover_status_t;
+
+typedef struct
+{
+    holdover_config_t config;
+    holdover_hw_t *hw;
+    holdover_state_t *state;
+    int64_t rtc_token_us; /*!< 开始分步读RTC时的 sync_us */
+} holdover_t;
+
+/**
+ * @brief 一次读RTC的结果
+ */
+typedef struct
+{
+    esp_err_t ret;  /*!< rtc_read 的返回值 */
+    int64_t rtc_us; /*!< 读出的时间 */
+    int64_t sys_us; /*!< 读出后立即取的系统时间 */
+} holdover_rtc_sample_t;
+
+esp_err_t holdover_init(holdover_t *h, const holdover_config_t *config, holdover_hw_t *hw, holdover_state_t *state);
+
+/**
+ * @description: 启动时调用：系统时间还有效时按漂移补偿，无效或误差太大时从RTC读出
+ * @return       系统时间的来源，HOLDOVER_SOURCE_NONE 表示时间未知
+ */
+holdover_source_t holdover_boot(holdover_t *h);
+
+/**
+ * @description: 运行中调用：按漂移补偿系统时间，误差超过 max_error_ms 且RTC更准时从RTC读出
+ */
+void holdover_check(holdover_t *h);
+
+/**
+ * @description: holdover_check 的第一步（持锁）：按漂移补偿系统时间
+ * @return       需要从RTC读出时返回 true，读出后调用 holdover_check_rtc()
+ */
+bool holdover_check_begin(holdover_t *h);
+
+/**
+ * @description: holdover_check 的第二步（持锁）：用读出的RTC时间设置系统时间
+ */
+void holdover_check_rtc(holdover_t *h, const holdover_rtc_sample_t *sample);
+
+/**
+ * @description: 运行中每隔 correct_interval_s 调用：按漂移补偿系统时间（sys_adjust），不访问RTC
+ */
+void holdover_correct(holdover_t *h);
+
+/**
+ * @description: SNTP 得到时间时调用，测量系统时钟漂移并校正系统时间，不访问RTC
+ * @param {int64_t} true_us 这一刻的真实时间
+ */
+void holdover_on_sntp(holdover_t *h, int64_t true_us);
+
+/**
+ * @description: SNTP 同步之后调用：读RTC测量它的误差和漂移，误差超过 rtc_rewrite_ms 时重写。会等RTC的秒跳变，最长约2秒
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE（系统时间还不够准）/ RTC的错误
+ */
+esp_err_t holdover_sync_rtc(holdover_t *h);
+
+/**
+ * @description: holdover_sync_rtc 的第一步（持锁）：检查系统时间是否够准
+ * @return       ESP_OK 时读RTC后调用 holdover_sync_rtc_measured() / ESP_ERR_INVALID_STATE
+ */
+esp_err_t holdover_sync_rtc_begin(holdover_t *h);
+
+/**
+ * @description: holdover_sync_rtc 的第二步（持锁）：计入测得的RTC误差和漂移
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE（读RTC期间 SNTP 又同步过，结果丢弃）/ RTC的错误
+ * @param {bool} *rewrite 输出，需要重写RTC，写完后调用 holdover_sync_rtc_written()
+ */
+esp_err_t holdover_sync_rtc_measured(holdover_t *h, const holdover_rtc_sample_t *sample, bool *rewrite);
+
+/**
+ * @description: holdover_sync_rtc 的第三步（持锁）：记下重写的结果
+ * @param {esp_err_t} ret rtc_write 的返回值
+ */
+esp_err_t holdover_sync_rtc_written(holdover_t *h, esp_err_t ret);
+
+/**
+ * @description: 读RTC，可以不持锁调用；同一时间只能有一个分步的 check 或 sync_rtc 在进行
+ */
+void holdover_rtc_sample(holdover_t *h, holdover_rtc_sample_t *sample);
+
+void holdover_get_status(holdover_t *h, holdover_status_t *status);
+
+const char *holdover_source_name(holdover_source_t source);
+
+#endif /* __HOLDOVER_H__ */
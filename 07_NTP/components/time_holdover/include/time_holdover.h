@@ -0,0 +1,44 @@
+#ifndef __TIME_HOLDOVER_H__
+#define __TIME_HOLDOVER_H__
+
+#include <sys/time.h>
+#include "holdover.h"
+#include "rx8025.h"
+
+/*
+ * holdover 在 ESP-IDF 上的实现：RX8025 作为RTC，gettimeofday/settimeofday/adjtime 操作系统时钟。
+ * 状态应放在 RTC_DATA_ATTR 变量中。函数内部加锁，可以在 SNTP 回调和应用任务中同时调用；
+ * 读写RTC时不持有这个锁，SNTP 回调和 esp_timer 中的定时补偿不会等RTC。
+ */
+
+/**
+ * @description: 启动守时，系统时间无效时立即从RTC读出（最长约1秒），不等网络
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE（已经启动）/ ESP_ERR_NO_MEM
+ * @param {rx8025_handle_t} rtc 已经初始化的RTC，没有RTC时为NULL
+ * @param {bool} rtc_power_lost rx8025_init() 报告的掉电标志
+ * @param {holdover_state_t} *state RTC 内存中的状态
+ * @param {holdover_source_t} *source 输出，系统时间的来源，可以为NULL
+ */
+esp_err_t time_holdover_start(rx8025_handle_t rtc, bool rtc_power_lost, const holdover_config_t *config,
+                              holdover_state_t *state, holdover_source_t *source);
+
+/**
+ * @description: SNTP 得到时间时调用（在 sntp_sync_time() 中），只校正系统时间
+ */
+void time_holdover_sntp_sync(const struct timeval *tv);
+
+/**
+ * @description: SNTP 同步之后在应用任务中调用，测量并按需重写RTC，最长约2秒
+ */
+esp_err_t time_holdover_rtc_sync(void);
+
+/**
+ * @description: 按漂移补偿系统时间，误差太大时从RTC重新读出
+ */
+void time_holdover_check(void);
+
+void time_holdover_get_status(holdover_status_t *status);
+
+void time_holdover_stop(void);
+
+#endif /* __TIME_HOLDOVER_H__ */
@@ -0,0 +1,332 @@
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "time_holdover.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "holdover";
+
+typedef struct
+{
+    holdover_hw_t parent;
+    holdover_t holdover;
+    rx8025_handle_t rtc;
+    bool power_lost;           /*!< RTC掉电过，重写之前读出的时间不可信 */
+    SemaphoreHandle_t lock;    /*!< 保护 holdover，SNTP 回调在 lwIP 任务中调用，持有的时间很短 */
+    SemaphoreHandle_t rtc_lock; /*!< 读写RTC（最长约1秒），不持有 lock */
+    esp_timer_handle_t timer;  /*!< 定时按漂移补偿系统时间 */
+} time_holdover_esp_t;
+
+static time_holdover_esp_t *s_th = NULL;
+
+/**
+ * @description: RTC 中存的是 UTC，不经过 TZ 换算（newlib 没有 timegm）
+ */
+static int64_t tm_to_us(const struct tm *tm)
+{
+    int y = tm->tm_year + 1900;
+    int m = tm->tm_mon + 1;
+    y -= m <= 2;
+    int era = y / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + tm->tm_mday - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+    return ((days * 86400) + tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec) * 1000000LL;
+}
+
+static int64_t sys_now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static esp_err_t esp_hw_rtc_read(holdover_hw_t *hw, int64_t *us)
+{
+    time_holdover_esp_t *t = __containerof(hw, time_holdover_esp_t, parent);
+    if (!t->rtc)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (t->power_lost)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    struct tm tm;
+    esp_err_t ret = rx8025_get_time_edge(t->rtc, &tm);
+    if (ret == ESP_OK)
+    {
+        *us = tm_to_us(&tm);
+    }
+    return ret;
+}
+
+static esp_err_t esp_hw_rtc_write(holdover_hw_t *hw)
+{
+    time_holdover_esp_t *t = __containerof(hw, time_holdover_esp_t, parent);
+    if (!t->rtc)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    // 先用 vTaskDelay 睡到整秒前 20ms，再忙等到整秒写入，写秒寄存器时RTC秒以下的计数清零
+    int64_t now = sys_now();
+    int64_t target = (now / 1000000 + 1) * 1000000;
+    if (target - now > 20000 + portTICK_PERIOD_MS * 1000)
+    {
+        vTaskDelay((target - now - 20000) / 1000 / portTICK_PERIOD_MS);
+    }
+    while ((now = sys_now()) < target)
+    {
+        esp_rom_delay_us(target - now > 100 ? 100 : target - now);
+    }
+    time_t sec = now / 1000000;
+    struct tm tm;
+    gmtime_r(&sec, &tm);
+    esp_err_t ret = rx8025_set_time(t->rtc, &tm);
+    if (ret == ESP_OK)
+    {
+        t->power_lost = false;
+    }
+    return ret;
+}
+
+// adjtime 还没调整完的部分也算进去，否则刚同步后测得的RTC误差不对
+static int64_t esp_hw_sys_get(holdover_hw_t *hw)
+{
+    struct timeval outdelta;
+    int64_t now = sys_now();
+    if (adjtime(NULL, &outdelta) == 0)
+    {
+        now += (int64_t)outdelta.tv_sec * 1000000 + outdelta.tv_usec;
+    }
+    return now;
+}
+
+static void esp_hw_sys_set(holdover_hw_t *hw, int64_t us)
+{
+    // settimeofday 会取消正在进行的 adjtime
+    struct timeval tv = {.tv_sec = us / 1000000, .tv_usec = us % 1000000};
+    settimeofday(&tv, NULL);
+}
+
+static void esp_hw_sys_adjust(holdover_hw_t *hw, int64_t delta_us)
+{
+    // adjtime 设置的是剩余的总调整量，要加上还没调整完的部分
+    struct timeval outdelta;
+    if (adjtime(NULL, &outdelta) == 0)
+    {
+        delta_us += (int64_t)outdelta.tv_sec * 1000000 + outdelta.tv_usec;
+    }
+    struct timeval tv = {.tv_sec = delta_us / 1000000, .tv_usec = delta_us % 1000000};
+    adjtime(&tv, NULL);
+}
+
+static void time_holdover_timer_cb(void *arg)
+{
+    time_holdover_esp_t *t = (time_holdover_esp_t *)arg;
+    // 不阻塞 esp_timer 的任务，锁忙时跳过这一次，补偿量按时间累积，下次一起补上
+    if (xSemaphoreTake(t->lock, 0) != pdTRUE)
+    {
+        return;
+    }
+    holdover_correct(&t->holdover);
+    xSemaphoreGive(t->lock);
+}
+
+static void time_holdover_free(time_holdover_esp_t *t)
+{
+    if (t->timer)
+    {
+        esp_timer_stop(t->timer);
+        esp_timer_delete(t->timer);
+    }
+    if (t->lock)
+    {
+        vSemaphoreDelete(t->lock);
+    }
+    if (t->rtc_lock)
+    {
+        vSemaphoreDelete(t->rtc_lock);
+    }
+    free(t);
+}
+
+esp_err_t time_holdover_start(rx8025_handle_t rtc, bool rtc_power_lost, const holdover_config_t *config,
+                              holdover_state_t *state, holdover_source_t *source)
+{
+    if (!config || !state)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_th)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    time_holdover_esp_t *t = calloc(1, sizeof(time_holdover_esp_t));
+    if (!t)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    t->rtc = rtc;
+    t->power_lost = rtc_power_lost;
+    t->parent.rtc_read = esp_hw_rtc_read;
+    t->parent.rtc_write = esp_hw_rtc_write;
+    t->parent.sys_get = esp_hw_sys_get;
+    t->parent.sys_set = esp_hw_sys_set;
+    t->parent.sys_adjust = esp_hw_sys_adjust;
+    t->lock = xSemaphoreCreateMutex();
+    t->rtc_lock = xSemaphoreCreateMutex();
+    esp_err_t ret = t->lock && t->rtc_lock ? holdover_init(&t->holdover, config, &t->parent, state) : ESP_ERR_NO_MEM;
+    if (ret == ESP_OK && config->correct_interval_s)
+    {
+        const esp_timer_create_args_t timer_args = {
+            .callback = time_holdover_timer_cb,
+            .arg = t,
+            .name = "holdover",
+        };
+        ret = esp_timer_create(&timer_args, &t->timer);
+    }
+    if (ret != ESP_OK)
+    {
+        time_holdover_free(t);
+        return ret;
+    }
+    s_th = t;
+
+    holdover_source_t src = holdover_boot(&t->holdover);
+    holdover_status_t status;
+    holdover_get_status(&t->holdover, &status);
+    if (src == HOLDOVER_SOURCE_NONE)
+    {
+        ESP_LOGW(TAG, "time unknown (rtc %s)", !rtc ? "absent" : rtc_power_lost ? "lost power" : "failed");
+    }
+    else
+    {
+        ESP_LOGI(TAG, "time from %s, error %lld ms", holdover_source_name(src), status.uncertainty_us / 1000);
+    }
+    if (source)
+    {
+        *source = src;
+    }
+    if (t->timer)
+    {
+        esp_timer_start_periodic(t->timer, (uint64_t)config->correct_interval_s * 1000000);
+    }
+    return ESP_OK;
+}
+
+void time_holdover_sntp_sync(const struct timeval *tv)
+{
+    time_holdover_esp_t *t = s_th;
+    if (!t)
+    {
+        settimeofday(tv, NULL);
+        return;
+    }
+    xSemaphoreTake(t->lock, portMAX_DELAY);
+    int64_t before = esp_hw_sys_get(&t->parent);
+    int64_t true_us = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+    holdover_on_sntp(&t->holdover, true_us);
+    const drift_estimator_t *de = &t->holdover.state->sys_drift;
+    int32_t drift = de->freq_ppb, sigma = de->sigma_ppb;
+    unsigned samples = de->count, poll = de->poll_s;
+    xSemaphoreGive(t->lock);
+    ESP_LOGI(TAG, "sntp: offset %lld us, drift %d ± %d ppb (%u samples), poll %u s", before - true_us, drift, sigma,
+             samples, poll);
+}
+
+esp_err_t time_holdover_rtc_sync(void)
+{
+    time_holdover_esp_t *t = s_th;
+    if (!t)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // 读写RTC时只持有 rtc_lock，SNTP 回调和定时补偿不等它
+    xSemaphoreTake(t->rtc_lock, portMAX_DELAY);
+    xSemaphoreTake(t->lock, portMAX_DELAY);
+    esp_err_t ret = holdover_sync_rtc_begin(&t->holdover);
+    xSemaphoreGive(t->lock);
+    bool rewrite = false;
+    if (ret == ESP_OK)
+    {
+        holdover_rtc_sample_t sample;
+        holdover_rtc_sample(&t->holdover, &sample);
+        xSemaphoreTake(t->lock, portMAX_DELAY);
+        ret = holdover_sync_rtc_measured(&t->holdover, &sample, &rewrite);
+        xSemaphoreGive(t->lock);
+    }
+    if (ret == ESP_OK && rewrite)
+    {
+        esp_err_t write_ret = esp_hw_rtc_write(&t->parent);
+        xSemaphoreTake(t->lock, portMAX_DELAY);
+        ret = holdover_sync_rtc_written(&t->holdover, write_ret);
+        xSemaphoreGive(t->lock);
+    }
+    xSemaphoreGive(t->rtc_lock);
+    xSemaphoreTake(t->lock, portMAX_DELAY);
+    int32_t offset = t->holdover.state->rtc_last_offset_us;
+    int32_t drift = t->holdover.state->rtc_drift_ppb;
+    xSemaphoreGive(t->lock);
+    if (ret == ESP_OK)
+    {
+        ESP_LOGI(TAG, "rtc: offset %d us, drift %d ppb", offset, drift);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "rtc sync failed (%s)", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+void time_holdover_check(void)
+{
+    time_holdover_esp_t *t = s_th;
+    if (!t)
+    {
+        return;
+    }
+    xSemaphoreTake(t->rtc_lock, portMAX_DELAY);
+    xSemaphoreTake(t->lock, portMAX_DELAY);
+    bool read_rtc = holdover_check_begin(&t->holdover);
+    xSemaphoreGive(t->lock);
+    if (read_rtc)
+    {
+        holdover_rtc_sample_t sample;
+        holdover_rtc_sample(&t->holdover, &sample);
+        xSemaphoreTake(t->lock, portMAX_DELAY);
+        holdover_check_rtc(&t->holdover, &sample);
+        xSemaphoreGive(t->lock);
+    }
+    xSemaphoreGive(t->rtc_lock);
+}
+
+void time_holdover_get_status(holdover_status_t *status)
+{
+    time_holdover_esp_t *t = s_th;
+    if (!t)
+    {
+        *status = (holdover_status_t){.source = HOLDOVER_SOURCE_NONE, .uncertainty_us = INT64_MAX, .sync_due = true};
+        return;
+    }
+    xSemaphoreTake(t->lock, portMAX_DELAY);
+    holdover_get_status(&t->holdover, status);
+    xSemaphoreGive(t->lock);
+}
+
+void time_holdover_stop(void)
+{
+    time_holdover_esp_t *t = s_th;
+    if (!t)
+    {
+        return;
+    }
+    s_th = NULL;
+    time_holdover_free(t);
+}
@@ -0,0 +1,45 @@
+#ifndef __WIFI_FAST_CONNECT_H__
+#define __WIFI_FAST_CONNECT_H__
+
+#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "wifi_fc_fsm.h"
+
+/*
+ * wifi_fc_fsm 在 ESP-IDF 上的驱动：esp_wifi 连接、esp_netif 设置静态地址、esp_timer 超时。
+ * 调用前需完成 esp_netif_init()、默认事件循环、STA netif 的创建和 esp_wifi_init()，
+ * 缓存应放在 RTC_DATA_ATTR 变量中。同一时间只能有一个连接过程。
+ */
+
+typedef void (*wifi_fast_connect_cb_t)(void *ctx, const wifi_fc_result_t *result);
+
+/**
+ * @description: 启动 Wi-Fi 并在后台连接，连上、失败或连上后断开（result->state 为正在连接的状态，之后自动重连）时调用 cb
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE（已经在连接）/ esp_wifi 的错误
+ * @param {esp_netif_t} *netif STA netif
+ * @param {wifi_fc_config_t} *config SSID 等配置，ssid 指向的字符串需一直有效
+ * @param {char} *password 密码
+ * @param {wifi_fc_cache_t} *cache RTC 内存中的缓存，连接成功后更新
+ * @param {wifi_fast_connect_cb_t} cb 结果回调（在事件循环任务中调用），可以为NULL
+ */
+esp_err_t wifi_fast_connect_start(esp_netif_t *netif, const wifi_fc_config_t *config, const char *password,
+                                  wifi_fc_cache_t *cache, wifi_fast_connect_cb_t cb, void *ctx);
+
+/**
+ * @description: 重试用完（WIFI_FC_STATE_FAILED）后重新开始一轮连接，不重启 Wi-Fi
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE（没有启动或不是失败状态）/ 驱动 connect 的错误
+ */
+esp_err_t wifi_fast_connect_retry(void);
+
+/**
+ * @description: 等待连接结果
+ * @return       ESP_OK（已取得地址）/ ESP_FAIL（重试用完）/ ESP_ERR_TIMEOUT / ESP_ERR_INVALID_STATE（没有启动）
+ */
+esp_err_t wifi_fast_connect_wait(TickType_t timeout, wifi_fc_result_t *result);
+
+/**
+ * @description: 注销事件处理并停止 Wi-Fi，结束连接过程
+ */
+void wifi_fast_connect_stop(void);
+
+#endif /* __WIFI_FAST_CONNECT_H__ */
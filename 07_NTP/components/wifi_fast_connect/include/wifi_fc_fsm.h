@@ -0,0 +1,158 @@
+#ifndef __WIFI_FC_FSM_H__
+#define __WIFI_FC_FSM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * 深度睡眠唤醒后的快速联网状态机，与 ESP-IDF 无关，可以在PC上用模拟的驱动测试。
+ *
+ * 上次连接成功时把 AP 的 BSSID、信道和 DHCP 分到的地址存进 RTC 内存（wifi_fc_cache_t）。
+ * 唤醒后直接在该信道上连接该 BSSID，不做全信道扫描；地址在 ip_reuse_s 之内时直接设为静态地址，跳过 DHCP。
+ * 直连失败（AP换了信道、关机、超时）时记一次失败，退回全信道扫描 + DHCP，成功后更新缓存。
+ *
+ * 所有事件必须串行送入 wifi_fc_handle()，驱动回调在 wifi_fc_handle() / wifi_fc_start() 内部调用。
+ */
+
+#define WIFI_FC_CACHE_MAGIC 0x43465749 // "IWFC"
+
+typedef struct
+{
+    uint32_t ip;      /*!< 与 esp_ip4_addr_t.addr 相同，网络字节序 */
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t dns;
+} wifi_fc_ip_t;
+
+/**
+ * @brief 放在 RTC 内存（RTC_DATA_ATTR）中的连接缓存
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t ssid_hash;     /*!< 换了 SSID 后缓存作废 */
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t fast_failures;  /*!< 连续直连失败的次数 */
+    wifi_fc_ip_t ip;
+    int64_t ip_time_us;     /*!< DHCP 分到地址的时间，rtc_us() 的时间基准 */
+    uint32_t last_time_to_ip_ms;
+    uint32_t crc;
+} wifi_fc_cache_t;
+
+typedef struct wifi_fc_driver_s wifi_fc_driver_t;
+
+/**
+ * @brief 状态机用到的 Wi-Fi 驱动操作
+ */
+struct wifi_fc_driver_s
+{
+    /**
+     * @brief 开始连接，bssid 为 NULL 时全信道扫描后按信号强度选 AP；结果以事件送回
+     */
+    esp_err_t (*connect)(wifi_fc_driver_t *drv, const uint8_t *bssid, uint8_t channel);
+    esp_err_t (*set_ip)(wifi_fc_driver_t *drv, const wifi_fc_ip_t *ip); /*!< 设置静态地址，NULL 表示用 DHCP */
+    esp_err_t (*disconnect)(wifi_fc_driver_t *drv); /*!< 断开或放弃正在进行的连接，之后会收到断开事件 */
+    void (*set_timeout)(wifi_fc_driver_t *drv, uint32_t ms); /*!< ms 毫秒后送入超时事件，0 取消 */
+    int64_t (*now_us)(wifi_fc_driver_t *drv); /*!< 单调时钟，测量连接耗时 */
+    int64_t (*rtc_us)(wifi_fc_driver_t *drv); /*!< 深度睡眠中不停的时钟，判断地址是否过期 */
+};
+
+typedef enum
+{
+    WIFI_FC_STATE_IDLE = 0,
+    WIFI_FC_STATE_FAST_CONNECT, /*!< 用缓存的 BSSID 和信道直连 */
+    WIFI_FC_STATE_SCAN_CONNECT, /*!< 全信道扫描连接 */
+    WIFI_FC_STATE_WAIT_IP,      /*!< 已关联，等待地址 */
+    WIFI_FC_STATE_LEAVING,      /*!< 放弃当前连接，等断开后再重试 */
+    WIFI_FC_STATE_CONNECTED,
+    WIFI_FC_STATE_FAILED,
+} wifi_fc_state_t;
+
+typedef enum
+{
+    WIFI_FC_EVENT_ASSOCIATED = 0, /*!< 关联成功，data 中有 bssid 和 channel */
+    WIFI_FC_EVENT_DISCONNECTED,
+    WIFI_FC_EVENT_GOT_IP,         /*!< 取得地址，data 中有 ip */
+    WIFI_FC_EVENT_TIMEOUT,        /*!< set_timeout() 设置的超时 */
+} wifi_fc_event_t;
+
+typedef struct
+{
+    uint8_t bssid[6];
+    uint8_t channel;
+    wifi_fc_ip_t ip;
+} wifi_fc_event_data_t;
+
+typedef struct
+{
+    const char *ssid;
+    uint32_t fast_timeout_ms;  /*!< 直连到取得地址的超时 */
+    uint32_t scan_timeout_ms;  /*!< 每次扫描连接到取得地址的超时 */
+    uint32_t ip_reuse_s;       /*!< DHCP 分到的地址在多久之内直接复用，0 表示每次都用 DHCP */
+    uint8_t max_retry;         /*!< 扫描连接的重试次数 */
+    uint8_t max_fast_failures; /*!< 连续直连失败几次后不再直连，直到扫描连接成功 */
+} wifi_fc_config_t;
+
+#define WIFI_FC_DEFAULT_CONFIG(s)   \
+    {                               \
+        .ssid = s,                  \
+        .fast_timeout_ms = 3000,    \
+        .scan_timeout_ms = 10000,   \
+        .ip_reuse_s = 1800,         \
+        .max_retry = 5,             \
+        .max_fast_failures = 2,     \
+    }
+
+typedef struct
+{
+    wifi_fc_state_t state;
+    bool fast;             /*!< 直连成功 */
+    bool static_ip;        /*!< 复用了缓存的地址 */
+    bool fell_back;        /*!< 直连失败后退回了扫描 */
+    uint8_t scans;         /*!< 扫描连接的次数 */
+    uint32_t time_to_ip_ms;
+} wifi_fc_result_t;
+
+typedef struct
+{
+    wifi_fc_config_t config;
+    wifi_fc_driver_t *drv;
+    wifi_fc_cache_t *cache;
+    wifi_fc_state_t state;
+    bool fast_attempt;     /*!< 当前这次连接是直连 */
+    uint8_t bssid[6];
+    uint8_t channel;
+    int64_t start_us;
+    wifi_fc_result_t result;
+} wifi_fc_t;
+
+/**
+ * @description: 缓存是否可以用于直连（magic、CRC 和 SSID 都匹配）
+ */
+bool wifi_fc_cache_valid(const wifi_fc_cache_t *cache, const char *ssid);
+
+/**
+ * @description: 作废缓存，例如应用发现缓存的地址已经不能通信
+ */
+void wifi_fc_cache_clear(wifi_fc_cache_t *cache);
+
+esp_err_t wifi_fc_init(wifi_fc_t *fc, const wifi_fc_config_t *config, wifi_fc_driver_t *drv, wifi_fc_cache_t *cache);
+
+/**
+ * @description: 开始连接，缓存有效时直连，否则扫描
+ * @return       驱动 connect 的错误
+ */
+esp_err_t wifi_fc_start(wifi_fc_t *fc);
+
+/**
+ * @description: 送入一个事件
+ * @return       处理后的状态
+ * @param {wifi_fc_event_data_t} *data ASSOCIATED 和 GOT_IP 的数据，其他事件可以为NULL
+ */
+wifi_fc_state_t wifi_fc_handle(wifi_fc_t *fc, wifi_fc_event_t event, const wifi_fc_event_data_t *data);
+
+const char *wifi_fc_state_name(wifi_fc_state_t state);
+
+#endif /* __WIFI_FC_FSM_H__ */
@@ -0,0 +1,364 @@
+#include <stdlib.h>
+#include <string.h>
+#include "wifi_fast_connect.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "esp_wifi.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_private/esp_clk.h"
+#include "esp_log.h"
+
+static const char *TAG = "wifi_fc";
+
+#define WIFI_FC_DONE_BIT BIT0
+
+typedef struct
+{
+    wifi_fc_driver_t parent;
+    wifi_fc_t fsm;
+    esp_netif_t *netif;
+    char password[65];
+    esp_timer_handle_t timer;
+    SemaphoreHandle_t lock;        /*!< 事件循环任务和 esp_timer 任务都会驱动状态机 */
+    EventGroupHandle_t events;
+    esp_event_handler_instance_t wifi_handler;
+    esp_event_handler_instance_t ip_handler;
+    wifi_fast_connect_cb_t cb;
+    void *ctx;
+    bool reported;                 /*!< 本次结果已经通知过 */
+    wifi_fc_state_t last_state;
+} wifi_fc_esp_t;
+
+static wifi_fc_esp_t *s_fc = NULL;
+
+static esp_err_t esp_drv_connect(wifi_fc_driver_t *drv, const uint8_t *bssid, uint8_t channel)
+{
+    wifi_fc_esp_t *w = __containerof(drv, wifi_fc_esp_t, parent);
+    wifi_config_t wifi_config = {
+        .sta = {
+            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+        },
+    };
+    strlcpy((char *)wifi_config.sta.ssid, w->fsm.config.ssid, sizeof(wifi_config.sta.ssid));
+    strlcpy((char *)wifi_config.sta.password, w->password, sizeof(wifi_config.sta.password));
+    if (bssid)
+    {
+        // 指定 BSSID 和信道：只在这一个信道上探测，省掉全信道扫描
+        memcpy(wifi_config.sta.bssid, bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.bssid_set = true;
+        wifi_config.sta.channel = channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    }
+    else
+    {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    esp_err_t ret = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    if (ret == ESP_OK)
+    {
+        ret = esp_wifi_connect();
+    }
+    ESP_LOGD(TAG, "connect %s (%s)", bssid ? "cached AP" : "with scan", esp_err_to_name(ret));
+    return ret;
+}
+
+static esp_err_t esp_drv_set_ip(wifi_fc_driver_t *drv, const wifi_fc_ip_t *ip)
+{
+    wifi_fc_esp_t *w = __containerof(drv, wifi_fc_esp_t, parent);
+    if (!ip)
+    {
+        esp_err_t ret = esp_netif_dhcpc_start(w->netif);
+        return ret == ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED ? ESP_OK : ret;
+    }
+    esp_err_t ret = esp_netif_dhcpc_stop(w->netif);
+    if (ret != ESP_OK && ret != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED)
+    {
+        return ret;
+    }
+    esp_netif_ip_info_t info = {
+        .ip.addr = ip->ip,
+        .netmask.addr = ip->netmask,
+        .gw.addr = ip->gw,
+    };
+    ret = esp_netif_set_ip_info(w->netif, &info);
+    if (ret == ESP_OK && ip->dns)
+    {
+        esp_netif_dns_info_t dns = {
+            .ip.type = ESP_IPADDR_TYPE_V4,
+            .ip.u_addr.ip4.addr = ip->dns,
+        };
+        ret = esp_netif_set_dns_info(w->netif, ESP_NETIF_DNS_MAIN, &dns);
+    }
+    return ret;
+}
+
+static esp_err_t esp_drv_disconnect(wifi_fc_driver_t *drv)
+{
+    return esp_wifi_disconnect();
+}
+
+static void esp_drv_set_timeout(wifi_fc_driver_t *drv, uint32_t ms)
+{
+    wifi_fc_esp_t *w = __containerof(drv, wifi_fc_esp_t, parent);
+    esp_timer_stop(w->timer);
+    if (ms)
+    {
+        esp_timer_start_once(w->timer, (uint64_t)ms * 1000);
+    }
+}
+
+static int64_t esp_drv_now_us(wifi_fc_driver_t *drv)
+{
+    return esp_timer_get_time();
+}
+
+// 与 duty_cycle 一样用 RTC 定时器：深度睡眠期间继续走，不受 SNTP 和 holdover 调整系统时间的影响
+static int64_t esp_drv_rtc_us(wifi_fc_driver_t *drv)
+{
+    return (int64_t)esp_clk_rtc_time();
+}
+
+/**
+ * @description: 把事件送入状态机，连上或失败时通知一次，连上后断开时也通知，调用前持有 lock
+ */
+static void wifi_fc_feed(wifi_fc_esp_t *w, wifi_fc_event_t event, const wifi_fc_event_data_t *data)
+{
+    wifi_fc_state_t state = wifi_fc_handle(&w->fsm, event, data);
+    if (state != WIFI_FC_STATE_CONNECTED && state != WIFI_FC_STATE_FAILED)
+    {
+        // 连上后又断开重连时，通知一次断开，重新等待结果
+        bool dropped = w->last_state == WIFI_FC_STATE_CONNECTED;
+        w->reported = false;
+        w->last_state = state;
+        xEventGroupClearBits(w->events, WIFI_FC_DONE_BIT);
+        if (dropped && w->cb)
+        {
+            w->cb(w->ctx, &w->fsm.result);
+        }
+        return;
+    }
+    w->last_state = state;
+    if (!w->reported)
+    {
+        w->reported = true;
+        const wifi_fc_result_t *r = &w->fsm.result;
+        ESP_LOGI(TAG, "%s: %s%s%s, %u ms, %u scan(s)", wifi_fc_state_name(state), r->fast ? "cached AP" : "scanned",
+                 r->static_ip ? ", reused IP" : "", r->fell_back ? ", fell back" : "", r->time_to_ip_ms, r->scans);
+        xEventGroupSetBits(w->events, WIFI_FC_DONE_BIT);
+        if (w->cb)
+        {
+            w->cb(w->ctx, r);
+        }
+    }
+}
+
+static void wifi_fc_timer_cb(void *arg)
+{
+    wifi_fc_esp_t *w = (wifi_fc_esp_t *)arg;
+    xSemaphoreTake(w->lock, portMAX_DELAY);
+    wifi_fc_feed(w, WIFI_FC_EVENT_TIMEOUT, NULL);
+    xSemaphoreGive(w->lock);
+}
+
+static void wifi_fc_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    wifi_fc_esp_t *w = (wifi_fc_esp_t *)arg;
+    wifi_fc_event_data_t data = {0};
+    xSemaphoreTake(w->lock, portMAX_DELAY);
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START)
+    {
+        wifi_fc_start(&w->fsm);
+    }
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED)
+    {
+        wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *)event_data;
+        memcpy(data.bssid, event->bssid, sizeof(data.bssid));
+        data.channel = event->channel;
+        wifi_fc_feed(w, WIFI_FC_EVENT_ASSOCIATED, &data);
+    }
+    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
+    {
+        wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+        ESP_LOGD(TAG, "disconnected, reason %d", event->reason);
+        wifi_fc_feed(w, WIFI_FC_EVENT_DISCONNECTED, NULL);
+    }
+    else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
+    {
+        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
+        data.ip.ip = event->ip_info.ip.addr;
+        data.ip.netmask = event->ip_info.netmask.addr;
+        data.ip.gw = event->ip_info.gw.addr;
+        esp_netif_dns_info_t dns;
+        if (esp_netif_get_dns_info(w->netif, ESP_NETIF_DNS_MAIN, &dns) == ESP_OK && dns.ip.type == ESP_IPADDR_TYPE_V4)
+        {
+            data.ip.dns = dns.ip.u_addr.ip4.addr;
+        }
+        ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
+        wifi_fc_feed(w, WIFI_FC_EVENT_GOT_IP, &data);
+    }
+    xSemaphoreGive(w->lock);
+}
+
+static void wifi_fc_free(wifi_fc_esp_t *w)
+{
+    if (w->wifi_handler)
+    {
+        esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, w->wifi_handler);
+    }
+    if (w->ip_handler)
+    {
+        esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, w->ip_handler);
+    }
+    if (w->timer)
+    {
+        esp_timer_stop(w->timer);
+        esp_timer_delete(w->timer);
+    }
+    if (w->lock)
+    {
+        vSemaphoreDelete(w->lock);
+    }
+    if (w->events)
+    {
+        vEventGroupDelete(w->events);
+    }
+    free(w);
+}
+
+esp_err_t wifi_fast_connect_start(esp_netif_t *netif, const wifi_fc_config_t *config, const char *password,
+                                  wifi_fc_cache_t *cache, wifi_fast_connect_cb_t cb, void *ctx)
+{
+    if (!netif || !config || !password || !cache)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_fc)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    wifi_fc_esp_t *w = calloc(1, sizeof(wifi_fc_esp_t));
+    if (!w)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    w->netif = netif;
+    w->cb = cb;
+    w->ctx = ctx;
+    strlcpy(w->password, password, sizeof(w->password));
+    w->parent.connect = esp_drv_connect;
+    w->parent.set_ip = esp_drv_set_ip;
+    w->parent.disconnect = esp_drv_disconnect;
+    w->parent.set_timeout = esp_drv_set_timeout;
+    w->parent.now_us = esp_drv_now_us;
+    w->parent.rtc_us = esp_drv_rtc_us;
+    esp_err_t ret = wifi_fc_init(&w->fsm, config, &w->parent, cache);
+    if (ret != ESP_OK)
+    {
+        free(w);
+        return ret;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = wifi_fc_timer_cb,
+        .arg = w,
+        .name = "wifi_fc",
+    };
+    w->lock = xSemaphoreCreateMutex();
+    w->events = xEventGroupCreate();
+    ret = ESP_ERR_NO_MEM;
+    if (w->lock && w->events)
+    {
+        ret = esp_timer_create(&timer_args, &w->timer);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_fc_event_handler, w, &w->wifi_handler);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_fc_event_handler, w, &w->ip_handler);
+    }
+    // 配置放在 RAM 中，每次唤醒都重新设置，不写 flash
+    if (ret == ESP_OK)
+    {
+        ret = esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = esp_wifi_set_mode(WIFI_MODE_STA);
+    }
+    if (ret != ESP_OK)
+    {
+        wifi_fc_free(w);
+        return ret;
+    }
+    s_fc = w;
+    // 状态机在 WIFI_EVENT_STA_START 中启动
+    ret = esp_wifi_start();
+    if (ret != ESP_OK)
+    {
+        wifi_fast_connect_stop();
+    }
+    return ret;
+}
+
+esp_err_t wifi_fast_connect_retry(void)
+{
+    wifi_fc_esp_t *w = s_fc;
+    if (!w)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(w->lock, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    if (w->fsm.state == WIFI_FC_STATE_FAILED)
+    {
+        w->reported = false;
+        xEventGroupClearBits(w->events, WIFI_FC_DONE_BIT);
+        ret = wifi_fc_start(&w->fsm);
+        w->last_state = w->fsm.state;
+    }
+    xSemaphoreGive(w->lock);
+    return ret;
+}
+
+esp_err_t wifi_fast_connect_wait(TickType_t timeout, wifi_fc_result_t *result)
+{
+    wifi_fc_esp_t *w = s_fc;
+    if (!w)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xEventGroupWaitBits(w->events, WIFI_FC_DONE_BIT, pdFALSE, pdFALSE, timeout);
+    xSemaphoreTake(w->lock, portMAX_DELAY);
+    if (result)
+    {
+        *result = w->fsm.result;
+    }
+    wifi_fc_state_t state = w->fsm.state;
+    xSemaphoreGive(w->lock);
+    if (state == WIFI_FC_STATE_CONNECTED)
+    {
+        return ESP_OK;
+    }
+    return state == WIFI_FC_STATE_FAILED ? ESP_FAIL : ESP_ERR_TIMEOUT;
+}
+
+void wifi_fast_connect_stop(void)
+{
+    wifi_fc_esp_t *w = s_fc;
+    if (!w)
+    {
+        return;
+    }
+    // 先注销事件处理和定时器，之后不会再有回调进入状态机
+    esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, w->wifi_handler);
+    esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, w->ip_handler);
+    w->wifi_handler = NULL;
+    w->ip_handler = NULL;
+    esp_wifi_stop();
+    s_fc = NULL;
+    wifi_fc_free(w);
+}
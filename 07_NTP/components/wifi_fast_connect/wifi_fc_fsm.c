@@ -0,0 +1,198 @@
+#include <string.h>
+#include <stddef.h>
+#include "wifi_fc_fsm.h"
+#include "esp_rom_crc.h"
+
+// 放弃连接后等待断开事件的时间，驱动不发断开事件时靠它继续
+#define WIFI_FC_LEAVE_TIMEOUT_MS 500
+
+static uint32_t wifi_fc_ssid_hash(const char *ssid)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)ssid, strlen(ssid));
+}
+
+static void wifi_fc_cache_seal(wifi_fc_cache_t *cache)
+{
+    cache->crc = esp_rom_crc32_le(0, (const uint8_t *)cache, offsetof(wifi_fc_cache_t, crc));
+}
+
+bool wifi_fc_cache_valid(const wifi_fc_cache_t *cache, const char *ssid)
+{
+    return cache && cache->magic == WIFI_FC_CACHE_MAGIC && cache->channel != 0 &&
+           cache->crc == esp_rom_crc32_le(0, (const uint8_t *)cache, offsetof(wifi_fc_cache_t, crc)) &&
+           cache->ssid_hash == wifi_fc_ssid_hash(ssid);
+}
+
+void wifi_fc_cache_clear(wifi_fc_cache_t *cache)
+{
+    memset(cache, 0, sizeof(*cache));
+}
+
+const char *wifi_fc_state_name(wifi_fc_state_t state)
+{
+    static const char *const names[] = {"idle", "fast connect", "scan connect", "wait ip", "leaving", "connected", "failed"};
+    return state < sizeof(names) / sizeof(names[0]) ? names[state] : "?";
+}
+
+esp_err_t wifi_fc_init(wifi_fc_t *fc, const wifi_fc_config_t *config, wifi_fc_driver_t *drv, wifi_fc_cache_t *cache)
+{
+    if (!fc || !config || !config->ssid || !drv || !cache)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(fc, 0, sizeof(*fc));
+    fc->config = *config;
+    fc->drv = drv;
+    fc->cache = cache;
+    return ESP_OK;
+}
+
+/**
+ * @description: 缓存的地址是否还能直接用：DHCP 分到之后不超过 ip_reuse_s，时钟倒退（RTC 定时器复位）时按过期处理
+ */
+static bool wifi_fc_ip_fresh(const wifi_fc_t *fc)
+{
+    const wifi_fc_cache_t *cache = fc->cache;
+    if (fc->config.ip_reuse_s == 0 || cache->ip.ip == 0)
+    {
+        return false;
+    }
+    int64_t age = fc->drv->rtc_us(fc->drv) - cache->ip_time_us;
+    return age >= 0 && age < (int64_t)fc->config.ip_reuse_s * 1000000;
+}
+
+static esp_err_t wifi_fc_begin_scan(wifi_fc_t *fc)
+{
+    fc->state = WIFI_FC_STATE_SCAN_CONNECT;
+    fc->fast_attempt = false;
+    fc->result.static_ip = false;
+    fc->result.scans++;
+    memset(fc->bssid, 0, sizeof(fc->bssid));
+    fc->channel = 0;
+    fc->drv->set_ip(fc->drv, NULL);
+    fc->drv->set_timeout(fc->drv, fc->config.scan_timeout_ms);
+    return fc->drv->connect(fc->drv, NULL, 0);
+}
+
+esp_err_t wifi_fc_start(wifi_fc_t *fc)
+{
+    memset(&fc->result, 0, sizeof(fc->result));
+    fc->start_us = fc->drv->now_us(fc->drv);
+    wifi_fc_cache_t *cache = fc->cache;
+    if (!wifi_fc_cache_valid(cache, fc->config.ssid) || cache->fast_failures >= fc->config.max_fast_failures)
+    {
+        esp_err_t ret = wifi_fc_begin_scan(fc);
+        fc->result.state = fc->state;
+        return ret;
+    }
+    fc->state = WIFI_FC_STATE_FAST_CONNECT;
+    fc->result.state = fc->state;
+    fc->fast_attempt = true;
+    fc->result.static_ip = wifi_fc_ip_fresh(fc);
+    memcpy(fc->bssid, cache->bssid, sizeof(fc->bssid));
+    fc->channel = cache->channel;
+    fc->drv->set_ip(fc->drv, fc->result.static_ip ? &cache->ip : NULL);
+    fc->drv->set_timeout(fc->drv, fc->config.fast_timeout_ms);
+    return fc->drv->connect(fc->drv, cache->bssid, cache->channel);
+}
+
+/**
+ * @description: 当前连接已断开，直连失败时记入缓存并退回扫描，扫描失败时重试
+ */
+static void wifi_fc_next_attempt(wifi_fc_t *fc)
+{
+    if (fc->fast_attempt)
+    {
+        fc->cache->fast_failures++;
+        wifi_fc_cache_seal(fc->cache);
+        fc->result.fell_back = true;
+        wifi_fc_begin_scan(fc);
+    }
+    else if (fc->result.scans > fc->config.max_retry)
+    {
+        fc->drv->set_timeout(fc->drv, 0);
+        fc->drv->disconnect(fc->drv);
+        fc->state = WIFI_FC_STATE_FAILED;
+    }
+    else
+    {
+        wifi_fc_begin_scan(fc);
+    }
+}
+
+static void wifi_fc_connected(wifi_fc_t *fc, const wifi_fc_ip_t *ip)
+{
+    fc->drv->set_timeout(fc->drv, 0);
+    fc->state = WIFI_FC_STATE_CONNECTED;
+    fc->result.fast = fc->fast_attempt;
+    fc->result.time_to_ip_ms = (uint32_t)((fc->drv->now_us(fc->drv) - fc->start_us) / 1000);
+
+    wifi_fc_cache_t *cache = fc->cache;
+    if (fc->channel == 0)
+    {
+        wifi_fc_cache_clear(cache); // 没收到关联事件，不知道连上的是哪个AP
+        return;
+    }
+    cache->magic = WIFI_FC_CACHE_MAGIC;
+    cache->ssid_hash = wifi_fc_ssid_hash(fc->config.ssid);
+    memcpy(cache->bssid, fc->bssid, sizeof(cache->bssid));
+    cache->channel = fc->channel;
+    cache->fast_failures = 0;
+    // 复用的静态地址不延长有效期，以 DHCP 分配的时间为准
+    if (!fc->result.static_ip && ip)
+    {
+        cache->ip = *ip;
+        cache->ip_time_us = fc->drv->rtc_us(fc->drv);
+    }
+    cache->last_time_to_ip_ms = fc->result.time_to_ip_ms;
+    wifi_fc_cache_seal(cache);
+}
+
+wifi_fc_state_t wifi_fc_handle(wifi_fc_t *fc, wifi_fc_event_t event, const wifi_fc_event_data_t *data)
+{
+    const bool connecting = fc->state == WIFI_FC_STATE_FAST_CONNECT || fc->state == WIFI_FC_STATE_SCAN_CONNECT ||
+                            fc->state == WIFI_FC_STATE_WAIT_IP;
+    switch (event)
+    {
+    case WIFI_FC_EVENT_ASSOCIATED:
+        if ((fc->state == WIFI_FC_STATE_FAST_CONNECT || fc->state == WIFI_FC_STATE_SCAN_CONNECT) && data)
+        {
+            memcpy(fc->bssid, data->bssid, sizeof(fc->bssid));
+            fc->channel = data->channel;
+            fc->state = WIFI_FC_STATE_WAIT_IP;
+        }
+        break;
+    case WIFI_FC_EVENT_GOT_IP:
+        if (connecting)
+        {
+            wifi_fc_connected(fc, data ? &data->ip : NULL);
+        }
+        break;
+    case WIFI_FC_EVENT_DISCONNECTED:
+        if (connecting || fc->state == WIFI_FC_STATE_LEAVING)
+        {
+            wifi_fc_next_attempt(fc);
+        }
+        else if (fc->state == WIFI_FC_STATE_CONNECTED)
+        {
+            // 连接中途断开：缓存刚更新过，按唤醒时一样先直连
+            wifi_fc_start(fc);
+        }
+        break;
+    case WIFI_FC_EVENT_TIMEOUT:
+        if (connecting)
+        {
+            // 先断开，等断开事件（或再一次超时）后再开始下一次连接，免得旧连接的断开事件被算到新连接上
+            fc->state = WIFI_FC_STATE_LEAVING;
+            fc->drv->set_timeout(fc->drv, WIFI_FC_LEAVE_TIMEOUT_MS);
+            fc->drv->disconnect(fc->drv);
+        }
+        else if (fc->state == WIFI_FC_STATE_LEAVING)
+        {
+            wifi_fc_next_attempt(fc);
+        }
+        break;
+    }
+    fc->result.state = fc->state;
+    return fc->state;
+}
@@ -18,22 +18,21 @@
 #include "lwip/err.h"
 #include "lwip/sys.h"
 
+#include "esp_timer.h"
+#include "driver/i2c.h"
+#include "driver/adc.h"
+#include "duty_cycle.h"
+#include "net_manager.h"
+#include "time_holdover.h"
+
 static const char *TAG = "NTP_example";
 
 #define WIFI_SSID "llx"
 #define WIFI_PASS "12345678"
 #define MAXIMUM_RETRY 5
 
-/* FreeRTOS event group to signal when we are connected*/
-static EventGroupHandle_t s_wifi_event_group;
-
-/* The event group allows multiple bits for each event, but we only care about two events:
- * - we are connected to the AP with an IP
- * - we failed to connect after the maximum amount of retries */
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT BIT1
-
-static int s_retry_num = 0;
+#define I2C_MASTER_NUM 0
+#define I2C_MASTER_FREQ_HZ 400000
 
 /* Variable holding number of times ESP32 restarted since first boot.
  * It is placed into RTC memory using RTC_DATA_ATTR and
@@ -41,67 +40,205 @@ static int s_retry_num = 0;
  */
 RTC_DATA_ATTR static int boot_count = 0;
 
-static void obtain_time(void);
-static void initialize_sntp(void);
+/* 上次连上的 AP（BSSID、信道）和 DHCP 分到的地址，唤醒后用来直连 */
+RTC_DATA_ATTR static wifi_fc_cache_t s_wifi_cache;
 
-static void event_handler(void *arg, esp_event_base_t event_base,
-                          int32_t event_id, void *event_data);
-void wifi_init_sta(void);
+/* 守时状态：上次同步的时间、测出的系统时钟和RTC漂移 */
+RTC_DATA_ATTR static holdover_state_t s_time_state;
 
-#ifdef CONFIG_SNTP_TIME_SYNC_METHOD_CUSTOM
+/* 占空比调度：各任务的下次到期时间和还没上传的采样记录 */
+RTC_DATA_ATTR static duty_state_t s_duty_state;
+
+/* 一条采样记录，攒在 RTC 内存中批量上传 */
+typedef struct
+{
+    uint32_t time_s; /*!< 采样时的 Unix 时间 */
+    uint16_t raw;    /*!< ADC 原始值 */
+    uint16_t seq;
+} sample_record_t;
+
+static bool start_network(void);
+static void start_time_holdover(void);
+static void print_time(void);
+static void wait_time_adjusted(void);
+
+/* SNTP 得到的时间交给守时服务：拟合漂移，小偏差用 adjtime，大偏差直接设置；
+ * 漂移测得越准，下一次同步间隔越长（lwIP 安排下一次请求时读取同步间隔）*/
 void sntp_sync_time(struct timeval *tv)
 {
-    settimeofday(tv, NULL);
-    ESP_LOGI(TAG, "Time is synchronized from custom code");
+    time_holdover_sntp_sync(tv);
+    holdover_status_t status;
+    time_holdover_get_status(&status);
+    sntp_set_sync_interval(status.poll_s * 1000);
+    ESP_LOGI(TAG, "Time is synchronized by the holdover service, next poll in %u s", status.poll_s);
     sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
 }
-#endif
 
-void time_sync_notification_cb(struct timeval *tv)
+/* 联网状态变化，在 net_manager 的任务中调用 */
+static void on_net_state(void *ctx, net_state_t state, net_state_t prev)
+{
+    ESP_LOGI(TAG, "Network %s -> %s, %lld ms since boot", net_mgr_state_name(prev), net_mgr_state_name(state),
+             esp_timer_get_time() / 1000);
+}
+
+/* 采样任务：读一次 ADC，记录留在 RTC 内存中，攒够一批再上传 */
+static uint32_t sample_task(duty_t *d, void *arg, uint8_t *data)
+{
+    static bool configured = false;
+    if (!configured)
+    {
+        adc1_config_width(ADC_WIDTH_BIT_12);
+        adc1_config_channel_atten(CONFIG_EXAMPLE_ADC_CHANNEL, ADC_ATTEN_DB_11);
+        configured = true;
+    }
+    uint16_t *seq = (uint16_t *)data;
+    sample_record_t record = {
+        .time_s = (uint32_t)time(NULL),
+        .raw = (uint16_t)adc1_get_raw(CONFIG_EXAMPLE_ADC_CHANNEL),
+        .seq = (*seq)++,
+    };
+    duty_push(d, &record);
+    ESP_LOGD(TAG, "Sample %u: %u", record.seq, record.raw);
+    return 0;
+}
+
+/* 同步任务：网络已经打开，等 SNTP 同步后校准RTC，下次按守时服务给出的时间 */
+static uint32_t time_task(duty_t *d, void *arg, uint8_t *data)
+{
+    net_state_t state = NET_STATE_OFF;
+    net_manager_wait(NET_STATE_BIT(NET_STATE_SYNCED) | NET_STATE_BIT(NET_STATE_FAILED),
+                     pdMS_TO_TICKS(CONFIG_EXAMPLE_NET_WAIT_S * 1000), &state);
+    if (state != NET_STATE_SYNCED)
+    {
+        ESP_LOGW(TAG, "Time not synchronized within %d s (network %s)", CONFIG_EXAMPLE_NET_WAIT_S,
+                 net_mgr_state_name(state));
+        return 0;
+    }
+    net_mgr_status_t net_status;
+    net_manager_get_status(&net_status);
+    ESP_LOGI(TAG, "IP after %u ms, time synchronized after %u ms", net_status.time_to_ip_ms,
+             net_status.time_to_sync_ms);
+    time_holdover_rtc_sync();
+    wait_time_adjusted();
+    print_time();
+
+    holdover_status_t status;
+    time_holdover_get_status(&status);
+    struct timeval tv_now;
+    gettimeofday(&tv_now, NULL);
+    int64_t now_us = (int64_t)tv_now.tv_sec * 1000000L + (int64_t)tv_now.tv_usec;
+    int64_t next_s = status.next_sync_us ? (status.next_sync_us - now_us) / 1000000 : 0;
+    return next_s > 60 ? (uint32_t)next_s : 60;
+}
+
+/* 上传任务：示例中没有服务器，只打印这一批记录；实际应用在这里发送，成功后再 duty_consume */
+static uint32_t upload_task(duty_t *d, void *arg, uint8_t *data)
+{
+    uint16_t count;
+    const sample_record_t *records = duty_batch(d, &count);
+    ESP_LOGI(TAG, "Uploading %u samples, seq %u..%u", count, records[0].seq, records[count - 1].seq);
+    for (int i = 0; i < count; i++)
+    {
+        ESP_LOGD(TAG, "  %u %u %u", records[i].time_s, records[i].seq, records[i].raw);
+    }
+    duty_consume(d, count);
+    return 0;
+}
+
+static esp_err_t net_up(void *ctx)
+{
+    if (!start_network())
+    {
+        return ESP_FAIL;
+    }
+    net_state_t state = NET_STATE_OFF;
+    net_manager_wait(NET_STATE_BIT(NET_STATE_ONLINE) | NET_STATE_BIT(NET_STATE_SYNCED) |
+                         NET_STATE_BIT(NET_STATE_FAILED),
+                     pdMS_TO_TICKS(CONFIG_EXAMPLE_NET_WAIT_S * 1000), &state);
+    if (state != NET_STATE_ONLINE && state != NET_STATE_SYNCED)
+    {
+        ESP_LOGW(TAG, "Network not available within %d s (%s)", CONFIG_EXAMPLE_NET_WAIT_S,
+                 net_mgr_state_name(state));
+        net_manager_stop();
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void net_down(void *ctx)
 {
-    ESP_LOGI(TAG, "Notification of a time synchronization event");
+    net_manager_stop();
 }
 
+static const duty_task_t s_tasks[] = {
+    {"sample", DUTY_TASK_LOCAL, CONFIG_EXAMPLE_SAMPLE_PERIOD_S, 1, sample_task, NULL},
+    {"time", DUTY_TASK_NETWORK, 3600, 1800, time_task, NULL},
+    {"upload", DUTY_TASK_UPLOAD, CONFIG_EXAMPLE_UPLOAD_LATENCY_S, CONFIG_EXAMPLE_UPLOAD_LATENCY_S, upload_task, NULL},
+};
+
 void app_main(void)
 {
     ++boot_count;
     ESP_LOGI(TAG, "Boot count: %d", boot_count);
 
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    // Is time set? If not, tm_year will be (1970 - 1900).
-    if (timeinfo.tm_year < (2016 - 1900))
+    // 系统时间无效时从RTC读出，不等网络
+    start_time_holdover();
+
+    // 本地的工作（这里是打印时间）不等网络，时间来自深度睡眠前的系统时钟或RTC
+    print_time();
+
+    /* 每次唤醒只运行到期的任务：采样每次都做，联网只在同步到期或攒够一批记录时才做，
+     * 网络打开后把快到期的同步和上传一起做完 */
+    duty_config_t config = DUTY_DEFAULT_CONFIG(s_tasks, sizeof(s_tasks) / sizeof(s_tasks[0]), sizeof(sample_record_t));
+    config.batch_threshold = CONFIG_EXAMPLE_BATCH_RECORDS;
+    const duty_cycle_net_t net = {.up = net_up, .down = net_down};
+    int64_t sleep_us = 1000000LL * CONFIG_EXAMPLE_SAMPLE_PERIOD_S;
+    esp_err_t ret = duty_cycle_run(&config, &s_duty_state, &net, &sleep_us);
+    if (ret != ESP_OK)
     {
-        ESP_LOGI(TAG, "Time is not set yet. Connecting to WiFi and getting time over NTP.");
-        obtain_time();
-        // update 'now' variable with current time
-        time(&now);
+        ESP_LOGE(TAG, "duty_cycle_run failed (%s)", esp_err_to_name(ret));
     }
-#ifdef CONFIG_SNTP_TIME_SYNC_METHOD_SMOOTH
-    else
+
+    holdover_status_t status;
+    time_holdover_get_status(&status);
+    if (status.source != HOLDOVER_SOURCE_NONE)
     {
-        // add 500 ms error to the current system time.
-        // Only to demonstrate a work of adjusting method!
-        {
-            ESP_LOGI(TAG, "Add a error for test adjtime");
-            struct timeval tv_now;
-            gettimeofday(&tv_now, NULL);
-            int64_t cpu_time = (int64_t)tv_now.tv_sec * 1000000L + (int64_t)tv_now.tv_usec;
-            int64_t error_time = cpu_time + 500 * 1000L;
-            struct timeval tv_error = {.tv_sec = error_time / 1000000L, .tv_usec = error_time % 1000000L};
-            settimeofday(&tv_error, NULL);
-        }
-
-        ESP_LOGI(TAG, "Time was set, now just adjusting it. Use SMOOTH SYNC method.");
-        obtain_time();
-        // update 'now' variable with current time
-        time(&now);
+        ESP_LOGI(TAG, "Time from %s, error within %lld ms", holdover_source_name(status.source),
+                 status.uncertainty_us / 1000);
     }
-#endif
 
+    ESP_LOGI(TAG, "Entering deep sleep for %lld ms", sleep_us / 1000);
+    esp_deep_sleep(sleep_us);
+}
+
+/**
+ * @description: 守时服务用 adjtime 调整小偏差，等它调整完
+ */
+static void wait_time_adjusted(void)
+{
+    if (sntp_get_sync_mode() != SNTP_SYNC_MODE_SMOOTH)
+    {
+        return;
+    }
+    struct timeval outdelta;
+    adjtime(NULL, &outdelta);
+    for (int i = 0; i < 30 && (outdelta.tv_sec != 0 || outdelta.tv_usec != 0); i++)
+    {
+        ESP_LOGI(TAG, "Waiting for adjusting time ... outdelta = %li sec: %li ms: %li us",
+                 (long)outdelta.tv_sec,
+                 outdelta.tv_usec / 1000,
+                 outdelta.tv_usec % 1000);
+        vTaskDelay(2000 / portTICK_PERIOD_MS);
+        adjtime(NULL, &outdelta);
+    }
+}
+
+static void print_time(void)
+{
+    time_t now;
+    struct tm timeinfo;
     char strftime_buf[64];
+    time(&now);
 
     // Set timezone to Eastern Standard Time and print local time
     setenv("TZ", "EST5EDT,M3.2.0/2,M11.1.0", 1);
@@ -116,180 +253,83 @@ void app_main(void)
     localtime_r(&now, &timeinfo);
     strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
     ESP_LOGI(TAG, "The current date/time in Shanghai is: %s", strftime_buf);
-
-    if (sntp_get_sync_mode() == SNTP_SYNC_MODE_SMOOTH)
-    {
-        struct timeval outdelta;
-        while (sntp_get_sync_status() == SNTP_SYNC_STATUS_IN_PROGRESS)
-        {
-            adjtime(NULL, &outdelta);
-            ESP_LOGI(TAG, "Waiting for adjusting time ... outdelta = %li sec: %li ms: %li us",
-                     (long)outdelta.tv_sec,
-                     outdelta.tv_usec / 1000,
-                     outdelta.tv_usec % 1000);
-            vTaskDelay(2000 / portTICK_PERIOD_MS);
-        }
-    }
-
-    const int deep_sleep_sec = 10;
-    ESP_LOGI(TAG, "Entering deep sleep for %d seconds", deep_sleep_sec);
-    esp_deep_sleep(1000000LL * deep_sleep_sec);
 }
 
-static void obtain_time(void)
+/**
+ * @description: 初始化 Wi-Fi 并启动 net_manager，连接、DHCP 和 SNTP 都在后台进行，立即返回
+ */
+static bool start_network(void)
 {
     ESP_ERROR_CHECK(nvs_flash_init());
-    // run only once!!!
-    // ESP_ERROR_CHECK(esp_netif_init());
-    // ESP_ERROR_CHECK(esp_event_loop_create_default());
-
-    /**
-     * NTP server address could be aquired via DHCP,
-     * see LWIP_DHCP_GET_NTP_SRV menuconfig option
-     */
-#ifdef LWIP_DHCP_GET_NTP_SRV
-    sntp_servermode_dhcp(1);
-#endif
-
-    /* This helper function configures Wi-Fi or Ethernet, as selected in menuconfig.
-     * Read "Establishing Wi-Fi or Ethernet Connection" section in
-     * examples/protocols/README.md for more information about this function.
-     */
-
-    
-    // ESP_ERROR_CHECK(example_connect()); // wifi
-    wifi_init_sta();
-    
-    initialize_sntp();
-
-    // wait for time to be set
-    time_t now = 0;
-    struct tm timeinfo = {0};
-    int retry = 0;
-    const int retry_count = 10;
-    while (sntp_get_sync_status() == SNTP_SYNC_STATUS_RESET && ++retry < retry_count)
-    {
-        ESP_LOGI(TAG, "Waiting for system time to be set... (%d/%d)", retry, retry_count);
-        vTaskDelay(2000 / portTICK_PERIOD_MS);
-    }
-    time(&now);
-    localtime_r(&now, &timeinfo);
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    esp_netif_t *netif = esp_netif_create_default_wifi_sta();
 
-    // ESP_ERROR_CHECK(example_disconnect());
-}
+    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
-static void initialize_sntp(void)
-{
-    ESP_LOGI(TAG, "Initializing SNTP");
-    sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    sntp_setservername(0, "pool.ntp.org");
-    sntp_set_time_sync_notification_cb(time_sync_notification_cb);
+    /* 缓存有效时直接连接上次的 AP 并复用地址，失败时退回全信道扫描 + DHCP（最多重试 MAXIMUM_RETRY 次）*/
+    net_manager_config_t config = NET_MANAGER_DEFAULT_CONFIG(netif, WIFI_SSID, WIFI_PASS, &s_wifi_cache);
+    config.wifi.max_retry = MAXIMUM_RETRY;
+    config.wifi.ip_reuse_s = CONFIG_EXAMPLE_WIFI_IP_REUSE_S;
+#ifndef CONFIG_EXAMPLE_WIFI_FAST_CONNECT
+    config.wifi.max_fast_failures = 0;
+#endif
+    holdover_status_t status;
+    time_holdover_get_status(&status);
+    config.sntp_interval_ms = status.poll_s * 1000;
 #ifdef CONFIG_SNTP_TIME_SYNC_METHOD_SMOOTH
-    sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
+    config.sntp_smooth = true;
 #endif
-    sntp_init();
-}
-
-static void event_handler(void *arg, esp_event_base_t event_base,
-                          int32_t event_id, void *event_data)
-{
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START)
-    {
-        esp_wifi_connect();
-    }
-    else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED)
+    // 唤醒后只试一轮，连不上就按时睡眠，下次唤醒再试
+    config.fsm.max_rounds = 1;
+    esp_err_t ret = net_manager_start(&config);
+    if (ret != ESP_OK)
     {
-        if (s_retry_num < MAXIMUM_RETRY)
-        {
-            esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "retry to connect to the AP");
-        }
-        else
-        {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-        }
-        ESP_LOGI(TAG, "connect to the AP fail");
-    }
-    else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP)
-    {
-        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
-        s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        ESP_LOGE(TAG, "net_manager_start failed (%s)", esp_err_to_name(ret));
+        return false;
     }
+    net_manager_subscribe(NET_STATE_ALL & ~NET_STATE_BIT(NET_STATE_OFF), on_net_state, NULL);
+    return true;
 }
 
-void wifi_init_sta(void)
+static void start_time_holdover(void)
 {
-    s_wifi_event_group = xEventGroupCreate();
-
-    ESP_ERROR_CHECK(esp_netif_init());
-
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
-
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
-                                                        &event_handler,
-                                                        NULL,
-                                                        &instance_got_ip));
-
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = WIFI_SSID,
-            .password = WIFI_PASS,
-            /* Setting a password implies station will connect to all security modes including WEP/WPA.
-             * However these modes are deprecated and not advisable to be used. Incase your Access point
-             * doesn't support WPA2, these mode can be enabled by commenting below line */
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
+    i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = CONFIG_EXAMPLE_I2C_SDA,
+        .scl_io_num = CONFIG_EXAMPLE_I2C_SCL,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = I2C_MASTER_FREQ_HZ,
     };
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
-
-    ESP_LOGI(TAG, "wifi_init_sta finished.");
-
-    /* Waiting until either the connection is established (WIFI_CONNECTED_BIT) or connection failed for the maximum
-     * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above) */
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-                                           WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-                                           pdFALSE,
-                                           pdFALSE,
-                                           portMAX_DELAY);
-
-    /* xEventGroupWaitBits() returns the bits before the call returned, hence we can test which event actually
-     * happened. */
-    if (bits & WIFI_CONNECTED_BIT)
+    rx8025_handle_t rtc = NULL;
+    bool power_lost = false;
+    esp_err_t ret = i2c_param_config(I2C_MASTER_NUM, &conf);
+    if (ret == ESP_OK)
     {
-        ESP_LOGI(TAG, "connected to ap SSID:%s password:%s",
-                 WIFI_SSID, WIFI_PASS);
+        ret = i2c_driver_install(I2C_MASTER_NUM, conf.mode, 0, 0, 0);
     }
-    else if (bits & WIFI_FAIL_BIT)
+    if (ret == ESP_OK)
     {
-        ESP_LOGI(TAG, "Failed to connect to SSID:%s, password:%s",
-                 WIFI_SSID, WIFI_PASS);
+        rx8025_config_t rtc_config = RX8025_DEFAULT_CONFIG(I2C_MASTER_NUM);
+        ret = rx8025_init(&rtc_config, &rtc, &power_lost);
     }
-    else
+    if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "UNEXPECTED EVENT");
+        // 没有RTC时仍然可以守时，只是断电后要等网络
+        ESP_LOGW(TAG, "RX8025 not available (%s)", esp_err_to_name(ret));
+        rtc = NULL;
     }
 
-    /* The event will not be processed after unregister */
-    ESP_ERROR_CHECK(esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, instance_got_ip));
-    ESP_ERROR_CHECK(esp_event_handler_instance_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, instance_any_id));
-    vEventGroupDelete(s_wifi_event_group);
+    holdover_config_t config = HOLDOVER_DEFAULT_CONFIG();
+    config.max_error_ms = CONFIG_EXAMPLE_TIME_MAX_ERROR_MS;
+#ifdef CONFIG_SNTP_TIME_SYNC_METHOD_IMMED
+    config.slew_limit_ms = 0;
+#elif defined(CONFIG_SNTP_TIME_SYNC_METHOD_SMOOTH)
+    config.slew_limit_ms = 1000;
+#endif
+    ESP_ERROR_CHECK(time_holdover_start(rtc, power_lost, &config, &s_time_state, NULL));
 }
 
 // void app_main(void)
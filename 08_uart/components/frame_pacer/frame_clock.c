@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "frame_clock.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+struct frame_clock_s
+{
+    frame_pacer_t pacer;
+    SemaphoreHandle_t lock; /*!< 保护 pacer */
+    SemaphoreHandle_t tick; /*!< 定时器到时后释放 */
+    esp_timer_handle_t timer;
+    bool started;           /*!< 已经开始过一帧 */
+};
+
+static void frame_clock_timer_cb(void *arg)
+{
+    struct frame_clock_s *c = (struct frame_clock_s *)arg;
+    xSemaphoreGive(c->tick);
+}
+
+esp_err_t frame_clock_create(uint32_t fps, frame_clock_handle_t *out)
+{
+    if (!out)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct frame_clock_s *c = calloc(1, sizeof(struct frame_clock_s));
+    if (!c)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = frame_pacer_init(&c->pacer, fps, esp_timer_get_time());
+    if (ret != ESP_OK)
+    {
+        free(c);
+        return ret;
+    }
+    c->lock = xSemaphoreCreateMutex();
+    c->tick = xSemaphoreCreateBinary();
+    const esp_timer_create_args_t timer_args = {
+        .callback = frame_clock_timer_cb,
+        .arg = c,
+        .name = "frame_clock",
+    };
+    if (!c->lock || !c->tick || esp_timer_create(&timer_args, &c->timer) != ESP_OK)
+    {
+        c->timer = NULL;
+        frame_clock_delete(c);
+        return ESP_ERR_NO_MEM;
+    }
+    *out = c;
+    return ESP_OK;
+}
+
+uint32_t frame_clock_wait(frame_clock_handle_t c)
+{
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    if (c->started)
+    {
+        frame_pacer_end(&c->pacer, now);
+    }
+    int64_t wait = frame_pacer_wait_us(&c->pacer, now);
+    xSemaphoreGive(c->lock);
+
+    if (wait > 0 && esp_timer_start_once(c->timer, (uint64_t)wait) == ESP_OK)
+    {
+        xSemaphoreTake(c->tick, portMAX_DELAY);
+    }
+
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    uint32_t missed = frame_pacer_begin(&c->pacer, esp_timer_get_time());
+    c->started = true;
+    xSemaphoreGive(c->lock);
+    return missed;
+}
+
+esp_err_t frame_clock_set_fps(frame_clock_handle_t c, uint32_t fps)
+{
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    esp_err_t ret = frame_pacer_set_fps(&c->pacer, fps, esp_timer_get_time());
+    xSemaphoreGive(c->lock);
+    return ret;
+}
+
+void frame_clock_restart(frame_clock_handle_t c)
+{
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    c->pacer.next_us = esp_timer_get_time();
+    c->started = false;
+    xSemaphoreGive(c->lock);
+}
+
+void frame_clock_get_stats(frame_clock_handle_t c, frame_pacer_stats_t *stats)
+{
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    *stats = c->pacer.stats;
+    xSemaphoreGive(c->lock);
+}
+
+void frame_clock_reset_stats(frame_clock_handle_t c)
+{
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    frame_pacer_reset_stats(&c->pacer);
+    xSemaphoreGive(c->lock);
+}
+
+int frame_clock_format(frame_clock_handle_t c, char *buf, size_t size)
+{
+    xSemaphoreTake(c->lock, portMAX_DELAY);
+    int n = frame_pacer_format(&c->pacer, buf, size);
+    xSemaphoreGive(c->lock);
+    return n;
+}
+
+void frame_clock_delete(frame_clock_handle_t c)
+{
+    if (!c)
+    {
+        return;
+    }
+    if (c->timer)
+    {
+        esp_timer_stop(c->timer);
+        esp_timer_delete(c->timer);
+    }
+    if (c->lock)
+    {
+        vSemaphoreDelete(c->lock);
+    }
+    if (c->tick)
+    {
+        vSemaphoreDelete(c->tick);
+    }
+    free(c);
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <string.h>
+#include "frame_pacer.h"
+
+esp_err_t frame_pacer_init(frame_pacer_t *p, uint32_t fps, int64_t now_us)
+{
+    if (!p)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(p, 0, sizeof(*p));
+    p->begin_us = -1;
+    return frame_pacer_set_fps(p, fps, now_us);
+}
+
+esp_err_t frame_pacer_set_fps(frame_pacer_t *p, uint32_t fps, int64_t now_us)
+{
+    if (fps == 0 || fps > 1000000)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    p->period_us = 1000000 / fps;
+    p->next_us = now_us;
+    return ESP_OK;
+}
+
+int64_t frame_pacer_wait_us(const frame_pacer_t *p, int64_t now_us)
+{
+    return p->next_us > now_us ? p->next_us - now_us : 0;
+}
+
+uint32_t frame_pacer_begin(frame_pacer_t *p, int64_t now_us)
+{
+    uint32_t missed = 0;
+    int64_t late = now_us - p->next_us;
+    if (late > 0)
+    {
+        // 已经过去的整帧不再渲染，从最近的时间点开始
+        missed = (uint32_t)(late / p->period_us);
+        late -= (int64_t)missed * p->period_us;
+        p->next_us += (int64_t)missed * p->period_us;
+        if ((uint32_t)late > p->stats.late_max_us)
+        {
+            p->stats.late_max_us = (uint32_t)late;
+        }
+    }
+    p->next_us += p->period_us;
+    p->begin_us = now_us;
+    p->stats.frames++;
+    p->stats.dropped += missed;
+    return missed;
+}
+
+void frame_pacer_end(frame_pacer_t *p, int64_t now_us)
+{
+    if (p->begin_us < 0)
+    {
+        return;
+    }
+    uint32_t work = (uint32_t)(now_us - p->begin_us);
+    p->begin_us = -1;
+    p->stats.work_total_us += work;
+    if (work > p->stats.work_max_us)
+    {
+        p->stats.work_max_us = work;
+    }
+}
+
+void frame_pacer_reset_stats(frame_pacer_t *p)
+{
+    memset(&p->stats, 0, sizeof(p->stats));
+}
+
+int frame_pacer_format(const frame_pacer_t *p, char *buf, size_t size)
+{
+    const frame_pacer_stats_t *s = &p->stats;
+    uint32_t slots = s->frames + s->dropped;
+    return snprintf(buf, size, "fps %u frames %u dropped %u (%u.%u%%) work avg %u max %u us late max %u us\n",
+                    (unsigned)(1000000 / p->period_us), (unsigned)s->frames, (unsigned)s->dropped,
+                    slots ? (unsigned)(s->dropped * 100ull / slots) : 0,
+                    slots ? (unsigned)(s->dropped * 1000ull / slots % 10) : 0,
+                    s->frames ? (unsigned)(s->work_total_us / s->frames) : 0, (unsigned)s->work_max_us,
+                    (unsigned)s->late_max_us);
+}
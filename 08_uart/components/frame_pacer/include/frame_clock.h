@@ -0,0 +1,48 @@
+#ifndef __FRAME_CLOCK_H__
+#define __FRAME_CLOCK_H__
+
+#include "frame_pacer.h"
+
+/*
+ * frame_pacer 在 ESP32 上的使用：用 esp_timer 单次定时器唤醒等待的任务，
+ * 等待的精度为几十微秒，不受 FreeRTOS 节拍（10 ms）的限制。
+ * 一个任务调用 frame_clock_wait()，统计可以在其他任务中读取。
+ */
+
+typedef struct frame_clock_s *frame_clock_handle_t;
+
+/**
+ * @description: 创建，第一帧立即开始
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG / ESP_ERR_NO_MEM
+ */
+esp_err_t frame_clock_create(uint32_t fps, frame_clock_handle_t *out);
+
+/**
+ * @description: 结束上一帧，等到下一帧的时间后开始它
+ * @return       这一帧之前错过的帧数
+ */
+uint32_t frame_clock_wait(frame_clock_handle_t clock);
+
+/**
+ * @description: 修改帧率
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG
+ */
+esp_err_t frame_clock_set_fps(frame_clock_handle_t clock, uint32_t fps);
+
+/**
+ * @description: 停止调用 frame_clock_wait() 一段时间后重新开始：下一帧立即开始，停止的时间不算作错过的帧
+ */
+void frame_clock_restart(frame_clock_handle_t clock);
+
+void frame_clock_get_stats(frame_clock_handle_t clock, frame_pacer_stats_t *stats);
+
+void frame_clock_reset_stats(frame_clock_handle_t clock);
+
+/**
+ * @description: 同 frame_pacer_format
+ */
+int frame_clock_format(frame_clock_handle_t clock, char *buf, size_t size);
+
+void frame_clock_delete(frame_clock_handle_t clock);
+
+#endif /* __FRAME_CLOCK_H__ */
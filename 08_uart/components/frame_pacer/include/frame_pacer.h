@@ -0,0 +1,70 @@
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * 按固定帧率安排每一帧的开始时间，统计错过的帧。
+ * 每一帧预定在 next_us 开始；调用者等 frame_pacer_wait_us() 后调用 frame_pacer_begin()，
+ * 渲染和发送完成后调用 frame_pacer_end()。上一帧的工作超过了帧间隔时，begin 跳过已经错过的时间点，
+ * 返回跳过的帧数（动画按它多前进几帧），不会为了追赶而连续渲染。
+ * 与 ESP-IDF 无关，可以在PC上测试。函数不可重入，由调用者加锁。
+ */
+
+typedef struct
+{
+    uint32_t frames;        /*!< 开始的帧 */
+    uint32_t dropped;       /*!< 错过的帧 */
+    uint32_t late_max_us;   /*!< 开始的时间比预定的晚多少（不算错过的整帧） */
+    uint32_t work_max_us;   /*!< 一帧中 begin 到 end 的最长时间 */
+    uint64_t work_total_us;
+} frame_pacer_stats_t;
+
+typedef struct
+{
+    int64_t period_us;
+    int64_t next_us;        /*!< 下一帧预定开始的时间 */
+    int64_t begin_us;       /*!< 这一帧开始的时间，没有开始时为 -1 */
+    frame_pacer_stats_t stats;
+} frame_pacer_t;
+
+/**
+ * @description: 初始化，第一帧在 now_us 开始
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG（fps 为 0 或超过 1000000）
+ */
+esp_err_t frame_pacer_init(frame_pacer_t *p, uint32_t fps, int64_t now_us);
+
+/**
+ * @description: 修改帧率，下一帧从 now_us 起按新的间隔安排，统计不清除
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG
+ */
+esp_err_t frame_pacer_set_fps(frame_pacer_t *p, uint32_t fps, int64_t now_us);
+
+/**
+ * @description: 到下一帧开始还要等的时间
+ * @return       微秒，已经到了返回 0
+ */
+int64_t frame_pacer_wait_us(const frame_pacer_t *p, int64_t now_us);
+
+/**
+ * @description: 开始一帧
+ * @return       这一帧之前错过的帧数
+ */
+uint32_t frame_pacer_begin(frame_pacer_t *p, int64_t now_us);
+
+/**
+ * @description: 这一帧的工作完成
+ */
+void frame_pacer_end(frame_pacer_t *p, int64_t now_us);
+
+void frame_pacer_reset_stats(frame_pacer_t *p);
+
+/**
+ * @description: 一行：帧率、帧数、错过的帧、平均和最长的工作时间、最晚的开始
+ * @return       需要的长度（不含 '\0'），与 snprintf 相同
+ */
+int frame_pacer_format(const frame_pacer_t *p, char *buf, size_t size);
+
+#endif /* __FRAME_PACER_H__ */
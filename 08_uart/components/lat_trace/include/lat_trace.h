@@ -0,0 +1,70 @@
+#ifndef __LAT_TRACE_H__
+#define __LAT_TRACE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 多级流水线的延迟统计：每个事件在各级记下时间（如 esp_timer_get_time()），
+ * 结束时把相邻两级的间隔和总的延迟加入直方图。
+ * 直方图按 2 的幂分段，每段再分 4 格，误差不超过 25%，加入一个值只要几条指令。
+ * 与 ESP-IDF 无关，可以在PC上测试。函数不可重入，由调用者加锁。
+ */
+
+#define LAT_HIST_SUB 4                          /*!< 每个 2 的幂分几格 */
+#define LAT_HIST_BUCKETS 64                     /*!< 最后一格从 114688 us 开始 */
+#define LAT_MAX_STAGES 6
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[LAT_HIST_BUCKETS];
+} lat_hist_t;
+
+typedef struct
+{
+    uint8_t stages;                             /*!< 时间点的个数，间隔比它少一个 */
+    const char *names[LAT_MAX_STAGES];          /*!< 每个间隔的名字（到这一级为止） */
+    lat_hist_t hist[LAT_MAX_STAGES];            /*!< 相邻两级的间隔，最后一个是总的延迟 */
+} lat_trace_t;
+
+void lat_hist_reset(lat_hist_t *h);
+
+void lat_hist_add(lat_hist_t *h, uint32_t us);
+
+/**
+ * @description: 百分位数，返回所在格的上限（不超过最大值）
+ * @param {uint8_t} pct 0 ~ 100
+ */
+uint32_t lat_hist_percentile(const lat_hist_t *h, uint8_t pct);
+
+/**
+ * @description: 一行：个数、最小、平均、p50、p90、p99、最大，单位 us
+ * @return       需要的长度（不含 '\0'），与 snprintf 相同
+ */
+int lat_hist_format(const lat_hist_t *h, const char *name, char *buf, size_t size);
+
+/**
+ * @description: 初始化
+ * @param {char} **names 每个间隔的名字，stages - 1 个，总的延迟另外叫 "total"
+ * @param {uint8_t} stages 时间点的个数，2 ~ LAT_MAX_STAGES
+ */
+void lat_trace_init(lat_trace_t *t, const char *const *names, uint8_t stages);
+
+/**
+ * @description: 一个事件在各级的时间，stages 个，依次不减
+ */
+void lat_trace_record(lat_trace_t *t, const int64_t *stamps_us);
+
+void lat_trace_reset(lat_trace_t *t);
+
+/**
+ * @description: 每个间隔一行，最后是总的延迟
+ * @return       写入的长度（不含 '\0'）
+ */
+size_t lat_trace_format(const lat_trace_t *t, char *buf, size_t size);
+
+#endif /* __LAT_TRACE_H__ */
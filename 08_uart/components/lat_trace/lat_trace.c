@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+#include "lat_trace.h"
+
+/**
+ * @description: 值所在的格：8 以下每个值一格，之后每个 2 的幂分 LAT_HIST_SUB 格
+ */
+static unsigned lat_bucket(uint32_t us)
+{
+    if (us < 2 * LAT_HIST_SUB)
+    {
+        return us;
+    }
+    unsigned msb = 31 - __builtin_clz(us);
+    unsigned index = LAT_HIST_SUB * (msb - 1) + ((us >> (msb - 2)) & (LAT_HIST_SUB - 1));
+    return index < LAT_HIST_BUCKETS ? index : LAT_HIST_BUCKETS - 1;
+}
+
+/**
+ * @description: 格的下限
+ */
+static uint32_t lat_bucket_low(unsigned index)
+{
+    if (index < 2 * LAT_HIST_SUB)
+    {
+        return index;
+    }
+    unsigned msb = index / LAT_HIST_SUB + 1;
+    return (uint32_t)(LAT_HIST_SUB + index % LAT_HIST_SUB) << (msb - 2);
+}
+
+void lat_hist_reset(lat_hist_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->min_us = UINT32_MAX;
+}
+
+void lat_hist_add(lat_hist_t *h, uint32_t us)
+{
+    h->buckets[lat_bucket(us)]++;
+    h->count++;
+    h->sum_us += us;
+    h->min_us = us < h->min_us ? us : h->min_us;
+    h->max_us = us > h->max_us ? us : h->max_us;
+}
+
+uint32_t lat_hist_percentile(const lat_hist_t *h, uint8_t pct)
+{
+    if (h->count == 0)
+    {
+        return 0;
+    }
+    // 第 rank 个值（从 1 开始）
+    uint64_t rank = ((uint64_t)h->count * pct + 99) / 100;
+    rank = rank ? rank : 1;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < LAT_HIST_BUCKETS; i++)
+    {
+        seen += h->buckets[i];
+        if (seen >= rank)
+        {
+            uint32_t high = i + 1 < LAT_HIST_BUCKETS ? lat_bucket_low(i + 1) - 1 : h->max_us;
+            high = high < h->max_us ? high : h->max_us;
+            return high > h->min_us ? high : h->min_us;
+        }
+    }
+    return h->max_us;
+}
+
+int lat_hist_format(const lat_hist_t *h, const char *name, char *buf, size_t size)
+{
+    if (h->count == 0)
+    {
+        return snprintf(buf, size, "%-8s      0\n", name);
+    }
+    return snprintf(buf, size, "%-8s %6u  min %6u  avg %6u  p50 %6u  p90 %6u  p99 %6u  max %6u us\n", name,
+                    (unsigned)h->count, (unsigned)h->min_us, (unsigned)(h->sum_us / h->count),
+                    (unsigned)lat_hist_percentile(h, 50), (unsigned)lat_hist_percentile(h, 90),
+                    (unsigned)lat_hist_percentile(h, 99), (unsigned)h->max_us);
+}
+
+void lat_trace_init(lat_trace_t *t, const char *const *names, uint8_t stages)
+{
+    memset(t, 0, sizeof(*t));
+    t->stages = stages < 2 ? 2 : stages > LAT_MAX_STAGES ? LAT_MAX_STAGES : stages;
+    for (uint8_t i = 0; i + 1 < t->stages; i++)
+    {
+        t->names[i] = names[i];
+    }
+    t->names[t->stages - 1] = "total";
+    lat_trace_reset(t);
+}
+
+void lat_trace_record(lat_trace_t *t, const int64_t *stamps_us)
+{
+    for (uint8_t i = 0; i + 1 < t->stages; i++)
+    {
+        int64_t d = stamps_us[i + 1] - stamps_us[i];
+        lat_hist_add(&t->hist[i], d > 0 ? (uint32_t)d : 0);
+    }
+    int64_t total = stamps_us[t->stages - 1] - stamps_us[0];
+    lat_hist_add(&t->hist[t->stages - 1], total > 0 ? (uint32_t)total : 0);
+}
+
+void lat_trace_reset(lat_trace_t *t)
+{
+    for (uint8_t i = 0; i < LAT_MAX_STAGES; i++)
+    {
+        lat_hist_reset(&t->hist[i]);
+    }
+}
+
+size_t lat_trace_format(const lat_trace_t *t, char *buf, size_t size)
+{
+    size_t used = 0;
+    for (uint8_t i = 0; i < t->stages; i++)
+    {
+        int n = lat_hist_format(&t->hist[i], t->names[i], buf + (used < size ? used : size),
+                                used < size ? size - used : 0);
+        used += n > 0 ? n : 0;
+    }
+    return used < size ? used : (size ? size - 1 : 0);
+}
@@ -0,0 +1,114 @@
+#ifndef __LED_FX_H__
+#define __LED_FX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * LED 灯效：渐变、HSV 彩虹、淡入淡出、追逐和关键帧时间线，只用整数运算。
+ * 效果按时间（毫秒）把整帧渲染到 fx_rgb_t 数组，每帧只做几次除法，每个 LED 的运算量固定，
+ * 渲染时间与 LED 数成正比。输出时亮度和伽马校正合并成一张 256 项的表，每个分量查一次表，
+ * 同时按灯带的字节顺序写入。与 ESP-IDF 无关，可以在PC上测试。
+ */
+
+#define FX_HUE_MAX 1536 /*!< 色相 0 ~ 1535：0 红、512 绿、1024 蓝 */
+
+typedef struct
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} fx_rgb_t;
+
+typedef enum
+{
+    FX_SOLID = 0, /*!< 整条灯带为 c0 */
+    FX_GRADIENT,  /*!< c0 到 c1 的渐变；移动时为 c0 -> c1 -> c0，首尾相接 */
+    FX_RAINBOW,   /*!< 整条灯带上色相跨 span，饱和度 sat，亮度 val */
+    FX_FADE,      /*!< 整条灯带在 c0 和 c1 之间往返 */
+    FX_CHASE,     /*!< 每 span 个 LED 中 width 个为 c0，其余为 c1，向前移动 */
+    FX_TYPE_MAX,
+} fx_type_t;
+
+typedef struct
+{
+    uint8_t type;       /*!< fx_type_t */
+    fx_rgb_t c0;
+    fx_rgb_t c1;
+    uint16_t period_ms; /*!< 移动、转动一圈或往返一次的时间，0 表示不动 */
+    uint16_t span;      /*!< 彩虹：色相跨度（FX_HUE_MAX 为一圈）；追逐：一组的 LED 数 */
+    uint16_t width;     /*!< 追逐：亮的 LED 数 */
+    uint8_t sat;        /*!< 彩虹的饱和度 */
+    uint8_t val;        /*!< 彩虹的亮度 */
+} fx_effect_t;
+
+typedef struct
+{
+    uint32_t duration_ms; /*!< 这一段的长度 */
+    uint32_t blend_ms;    /*!< 开始时从上一段过渡的时间，0 表示直接切换 */
+    fx_effect_t effect;   /*!< 时间从这一段开始时算起 */
+} fx_keyframe_t;
+
+typedef struct
+{
+    const fx_keyframe_t *frames; /*!< 不复制，需要一直有效 */
+    uint8_t count;
+    bool loop;                   /*!< 否则停在最后一段的结尾 */
+    uint32_t total_ms;
+} fx_timeline_t;
+
+typedef struct
+{
+    uint8_t v[256];
+} fx_lut_t;
+
+typedef enum
+{
+    FX_ORDER_RGB = 0,
+    FX_ORDER_GRB, /*!< WS2812 */
+} fx_order_t;
+
+/**
+ * @description: HSV 转 RGB
+ * @param {uint16_t} hue 0 ~ FX_HUE_MAX - 1，超出时取余
+ */
+fx_rgb_t fx_hsv(uint16_t hue, uint8_t sat, uint8_t val);
+
+/**
+ * @description: a 和 b 按 t 混合，0 为 a，255 为 b
+ */
+fx_rgb_t fx_blend(fx_rgb_t a, fx_rgb_t b, uint8_t t);
+
+/**
+ * @description: 渲染一帧
+ * @param {uint32_t} t_ms 效果开始后的时间
+ */
+void fx_render(const fx_effect_t *e, uint32_t t_ms, fx_rgb_t *frame, size_t n);
+
+/**
+ * @description: 初始化时间线
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG（没有关键帧、长度为 0、过渡比这一段长或效果不存在）
+ */
+esp_err_t fx_timeline_init(fx_timeline_t *tl, const fx_keyframe_t *frames, uint8_t count, bool loop);
+
+/**
+ * @description: 渲染时间线的一帧，过渡时上一段渲染到 scratch 再混合
+ * @param {fx_rgb_t} *scratch n 个，过渡时使用
+ */
+void fx_timeline_render(const fx_timeline_t *tl, uint32_t t_ms, fx_rgb_t *frame, fx_rgb_t *scratch, size_t n);
+
+/**
+ * @description: 亮度和伽马校正（2.2）合并成一张表
+ * @param {uint8_t} brightness 0 ~ 255
+ * @param {bool} gamma false 时只按亮度缩放
+ */
+void fx_lut_build(fx_lut_t *lut, uint8_t brightness, bool gamma);
+
+/**
+ * @description: 每个分量查表，按 order 写入 dst（每个 LED 3 字节）
+ */
+void fx_output(const fx_lut_t *lut, const fx_rgb_t *src, size_t n, uint8_t *dst, fx_order_t order);
+
+#endif /* __LED_FX_H__ */
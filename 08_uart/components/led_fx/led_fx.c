@@ -0,0 +1,284 @@
+#include <string.h>
+#include "led_fx.h"
+
+// (i / 255) ^ 2.2 * 65535
+static const uint16_t s_gamma16[256] = {
+    0, 0, 2, 4, 7, 11, 17, 24, 32, 42, 53, 65,
+    79, 94, 111, 129, 148, 169, 192, 216, 242, 270, 299, 330,
+    362, 396, 432, 469, 508, 549, 591, 635, 681, 729, 779, 830,
+    883, 938, 995, 1053, 1113, 1175, 1239, 1305, 1373, 1443, 1514, 1587,
+    1663, 1740, 1819, 1900, 1983, 2068, 2155, 2243, 2334, 2427, 2521, 2618,
+    2717, 2817, 2920, 3024, 3131, 3240, 3350, 3463, 3578, 3694, 3813, 3934,
+    4057, 4182, 4309, 4438, 4570, 4703, 4838, 4976, 5115, 5257, 5401, 5547,
+    5695, 5845, 5998, 6152, 6309, 6468, 6629, 6792, 6957, 7124, 7294, 7466,
+    7640, 7816, 7994, 8175, 8358, 8543, 8730, 8919, 9111, 9305, 9501, 9699,
+    9900, 10102, 10307, 10515, 10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+    12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140, 14386, 14635, 14885, 15138,
+    15394, 15652, 15912, 16174, 16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+    18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694, 20996, 21301, 21609, 21919,
+    22231, 22546, 22863, 23182, 23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+    26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627, 28988, 29351, 29717, 30086,
+    30457, 30830, 31206, 31585, 31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+    35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981, 38402, 38825, 39252, 39680,
+    40112, 40546, 40982, 41421, 41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+    45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793, 49275, 49761, 50249, 50739,
+    51232, 51728, 52226, 52727, 53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+    57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097, 61642, 62190, 62741, 63295,
+    63851, 64410, 64971, 65535,
+};
+
+/**
+ * @description: a * b / 255 的近似，b 为 255 时等于 a
+ */
+static inline uint8_t fx_scale8(uint8_t a, uint8_t b)
+{
+    return (uint8_t)(((uint16_t)a * (b + 1)) >> 8);
+}
+
+/**
+ * @description: hue 已经在 0 ~ FX_HUE_MAX - 1 之内
+ */
+static inline fx_rgb_t fx_hsv_in_range(uint16_t hue, uint8_t sat, uint8_t val)
+{
+    uint8_t f = hue & 0xFF;
+    uint8_t p = fx_scale8(val, 255 - sat);
+    uint8_t q = fx_scale8(val, 255 - fx_scale8(sat, f));
+    uint8_t t = fx_scale8(val, 255 - fx_scale8(sat, 255 - f));
+    switch (hue >> 8)
+    {
+    case 0:
+        return (fx_rgb_t){val, t, p};
+    case 1:
+        return (fx_rgb_t){q, val, p};
+    case 2:
+        return (fx_rgb_t){p, val, t};
+    case 3:
+        return (fx_rgb_t){p, q, val};
+    case 4:
+        return (fx_rgb_t){t, p, val};
+    default:
+        return (fx_rgb_t){val, p, q};
+    }
+}
+
+fx_rgb_t fx_hsv(uint16_t hue, uint8_t sat, uint8_t val)
+{
+    if (hue >= FX_HUE_MAX)
+    {
+        hue %= FX_HUE_MAX;
+    }
+    return fx_hsv_in_range(hue, sat, val);
+}
+
+/**
+ * @description: w 为 0 ~ 256
+ */
+static inline fx_rgb_t fx_mix(fx_rgb_t a, fx_rgb_t b, uint16_t w)
+{
+    uint16_t iw = 256 - w;
+    return (fx_rgb_t){
+        (uint8_t)((a.r * iw + b.r * w) >> 8),
+        (uint8_t)((a.g * iw + b.g * w) >> 8),
+        (uint8_t)((a.b * iw + b.b * w) >> 8),
+    };
+}
+
+fx_rgb_t fx_blend(fx_rgb_t a, fx_rgb_t b, uint8_t t)
+{
+    return fx_mix(a, b, t + (t >> 7));
+}
+
+static void fx_fill(fx_rgb_t *frame, size_t n, fx_rgb_t c)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        frame[i] = c;
+    }
+}
+
+/**
+ * @description: 周期中的位置，0 ~ scale - 1
+ */
+static uint32_t fx_phase(uint32_t t_ms, uint16_t period_ms, uint32_t scale)
+{
+    return period_ms ? (uint32_t)((uint64_t)(t_ms % period_ms) * scale / period_ms) : 0;
+}
+
+/**
+ * @description: 0 ~ 511 折成 0 ~ 255 ~ 0
+ */
+static inline uint8_t fx_triangle(uint32_t x)
+{
+    return x < 256 ? x : 511 - x;
+}
+
+static void fx_gradient(const fx_effect_t *e, uint32_t t_ms, fx_rgb_t *frame, size_t n)
+{
+    if (e->period_ms == 0)
+    {
+        // 第一个 LED 为 c0，最后一个为 c1，位置用 16 位小数
+        uint32_t step = n > 1 ? (255u << 16) / (n - 1) + 1 : 0;
+        uint32_t acc = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            frame[i] = fx_mix(e->c0, e->c1, (acc >> 16) + (acc >> 23));
+            acc += step;
+        }
+        return;
+    }
+    // 整条灯带为 1 << 24，每 1 << 24 是 c0 -> c1 -> c0 一次
+    uint32_t step = (1u << 24) / n;
+    uint32_t acc = fx_phase(t_ms, e->period_ms, 1u << 24);
+    for (size_t i = 0; i < n; i++)
+    {
+        uint8_t w = fx_triangle((acc & 0xFFFFFF) >> 15);
+        frame[i] = fx_mix(e->c0, e->c1, w + (w >> 7));
+        acc += step;
+    }
+}
+
+static void fx_rainbow(const fx_effect_t *e, uint32_t t_ms, fx_rgb_t *frame, size_t n)
+{
+    // 色相用 16 位小数，每个 LED 加一次，超过一圈减一次
+    const uint32_t wrap = (uint32_t)FX_HUE_MAX << 16;
+    uint32_t span = e->span < FX_HUE_MAX ? e->span : FX_HUE_MAX;
+    uint32_t step = (span << 16) / n;
+    uint32_t acc = fx_phase(t_ms, e->period_ms, wrap);
+    for (size_t i = 0; i < n; i++)
+    {
+        frame[i] = fx_hsv_in_range(acc >> 16, e->sat, e->val);
+        acc += step;
+        if (acc >= wrap)
+        {
+            acc -= wrap;
+        }
+    }
+}
+
+static void fx_chase(const fx_effect_t *e, uint32_t t_ms, fx_rgb_t *frame, size_t n)
+{
+    uint32_t span = e->span ? e->span : 1;
+    uint32_t offset = fx_phase(t_ms, e->period_ms, span);
+    // 第 i 个 LED 在组中的位置为 (i - offset) mod span
+    uint32_t k = (span - offset) % span;
+    for (size_t i = 0; i < n; i++)
+    {
+        frame[i] = k < e->width ? e->c0 : e->c1;
+        if (++k == span)
+        {
+            k = 0;
+        }
+    }
+}
+
+void fx_render(const fx_effect_t *e, uint32_t t_ms, fx_rgb_t *frame, size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    switch (e->type)
+    {
+    case FX_GRADIENT:
+        fx_gradient(e, t_ms, frame, n);
+        break;
+    case FX_RAINBOW:
+        fx_rainbow(e, t_ms, frame, n);
+        break;
+    case FX_FADE:
+        fx_fill(frame, n, e->period_ms ? fx_blend(e->c0, e->c1, fx_triangle(fx_phase(t_ms, e->period_ms, 512))) : e->c0);
+        break;
+    case FX_CHASE:
+        fx_chase(e, t_ms, frame, n);
+        break;
+    case FX_SOLID:
+    default:
+        fx_fill(frame, n, e->c0);
+        break;
+    }
+}
+
+esp_err_t fx_timeline_init(fx_timeline_t *tl, const fx_keyframe_t *frames, uint8_t count, bool loop)
+{
+    if (!tl || !frames || count == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (frames[i].duration_ms == 0 || frames[i].blend_ms > frames[i].duration_ms ||
+            frames[i].effect.type >= FX_TYPE_MAX)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+        total += frames[i].duration_ms;
+    }
+    tl->frames = frames;
+    tl->count = count;
+    tl->loop = loop;
+    tl->total_ms = total;
+    return ESP_OK;
+}
+
+void fx_timeline_render(const fx_timeline_t *tl, uint32_t t_ms, fx_rgb_t *frame, fx_rgb_t *scratch, size_t n)
+{
+    if (tl->loop)
+    {
+        t_ms %= tl->total_ms;
+    }
+    else if (t_ms >= tl->total_ms)
+    {
+        t_ms = tl->total_ms - 1;
+    }
+    uint8_t k = 0;
+    while (t_ms >= tl->frames[k].duration_ms)
+    {
+        t_ms -= tl->frames[k].duration_ms;
+        k++;
+    }
+    const fx_keyframe_t *cur = &tl->frames[k];
+    fx_render(&cur->effect, t_ms, frame, n);
+    if (t_ms >= cur->blend_ms || (k == 0 && !tl->loop))
+    {
+        return;
+    }
+    // 过渡：上一段接着它的时间渲染，按过渡的进度混合
+    const fx_keyframe_t *prev = &tl->frames[k ? k - 1 : tl->count - 1];
+    fx_render(&prev->effect, prev->duration_ms + t_ms, scratch, n);
+    uint16_t w = (uint16_t)(t_ms * 256 / cur->blend_ms);
+    for (size_t i = 0; i < n; i++)
+    {
+        frame[i] = fx_mix(scratch[i], frame[i], w);
+    }
+}
+
+void fx_lut_build(fx_lut_t *lut, uint8_t brightness, bool gamma)
+{
+    uint32_t scale = brightness + 1;
+    for (int i = 0; i < 256; i++)
+    {
+        lut->v[i] = gamma ? (uint8_t)((s_gamma16[i] * scale) >> 16) : (uint8_t)((i * scale) >> 8);
+    }
+}
+
+void fx_output(const fx_lut_t *lut, const fx_rgb_t *src, size_t n, uint8_t *dst, fx_order_t order)
+{
+    const uint8_t *v = lut->v;
+    if (order == FX_ORDER_GRB)
+    {
+        for (size_t i = 0; i < n; i++, dst += 3)
+        {
+            dst[0] = v[src[i].g];
+            dst[1] = v[src[i].r];
+            dst[2] = v[src[i].b];
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; i++, dst += 3)
+    {
+        dst[0] = v[src[i].r];
+        dst[1] = v[src[i].g];
+        dst[2] = v[src[i].b];
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef __UART_CMD_H__
+#define __UART_CMD_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * 串口命令表：每个命令声明名字、参数（整数，带范围）、说明和处理函数。
+ * cmd_table_init() 对名字找一个没有冲突的哈希种子（完美哈希），查找时只算一次哈希、比较一次名字，
+ * 与命令的个数无关。一行按空白分成命令名和参数，原地解析，不需要以 '\0' 结尾。
+ * 与 ESP-IDF 无关，可以在PC上测试。
+ */
+
+#define CMD_MAX_ARGS 4
+#define CMD_MAX_COMMANDS 32
+#define CMD_HASH_SLOTS 128 /*!< 槽的个数最多这么多（2 的幂） */
+
+typedef struct
+{
+    const char *name; /*!< 用于帮助和错误信息，NULL 表示没有更多参数 */
+    int32_t min;
+    int32_t max;
+} cmd_arg_t;
+
+typedef struct cmd_def_s cmd_def_t;
+
+/**
+ * @brief 处理命令
+ * @param argv 已经检查过范围的参数，个数与 cmd->args 相同
+ * @param ctx cmd_dispatch() 的 ctx
+ */
+typedef esp_err_t (*cmd_handler_t)(const cmd_def_t *cmd, const int32_t *argv, void *ctx);
+
+struct cmd_def_s
+{
+    const char *name;
+    const char *help;
+    cmd_arg_t args[CMD_MAX_ARGS];
+    cmd_handler_t handler;
+    const void *arg; /*!< 给处理函数的数据，几个命令可以共用一个处理函数 */
+};
+
+typedef struct
+{
+    const cmd_def_t *cmds;
+    uint8_t count;
+    uint8_t mask;                  /*!< 槽的个数减一 */
+    uint32_t seed;
+    uint8_t slots[CMD_HASH_SLOTS]; /*!< 命令的下标，0xFF 为空 */
+} cmd_table_t;
+
+/**
+ * @description: 建立查找表，命令表本身不复制，需要一直有效
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG（命令太多、名字重复或为空）/ ESP_ERR_NOT_FOUND（找不到种子）
+ */
+esp_err_t cmd_table_init(cmd_table_t *table, const cmd_def_t *cmds, size_t count);
+
+/**
+ * @description: 按名字查找
+ * @return       命令；没有时返回 NULL
+ */
+const cmd_def_t *cmd_lookup(const cmd_table_t *table, const char *name, size_t len);
+
+/**
+ * @description: 解析一行并调用处理函数，空行什么也不做
+ * @return       处理函数的返回值 / ESP_ERR_NOT_FOUND（没有这个命令）/ ESP_ERR_INVALID_ARG（参数个数、格式或范围不对）
+ * @param {char} *err 出错时写入说明，可以为 NULL
+ */
+esp_err_t cmd_dispatch(const cmd_table_t *table, const uint8_t *line, size_t len, void *ctx, char *err,
+                       size_t err_size);
+
+/**
+ * @description: 一个命令的用法，如 "rgb <r> <g> <b>"
+ * @return       写入的长度（不含 '\0'）
+ */
+size_t cmd_usage(const cmd_def_t *cmd, char *buf, size_t size);
+
+/**
+ * @description: 所有命令的用法和说明，每个命令一行，按表中的顺序
+ * @return       需要的长度（不含 '\0'），大于等于 size 时被截断
+ */
+size_t cmd_help(const cmd_table_t *table, char *buf, size_t size);
+
+#endif /* __UART_CMD_H__ */
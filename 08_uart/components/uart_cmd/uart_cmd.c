@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "uart_cmd.h"
+
+#define CMD_SLOT_EMPTY 0xFF
+#define CMD_SEED_TRIES 1000 // 每种槽数尝试的种子数，槽数是命令数的两倍以上时通常几十个以内就能找到
+
+static inline uint32_t cmd_hash(uint32_t seed, const char *s, size_t len)
+{
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++)
+    {
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+static bool cmd_try_seed(cmd_table_t *table, uint32_t seed)
+{
+    memset(table->slots, CMD_SLOT_EMPTY, sizeof(table->slots));
+    for (int i = 0; i < table->count; i++)
+    {
+        const char *name = table->cmds[i].name;
+        uint32_t slot = cmd_hash(seed, name, strlen(name)) & table->mask;
+        if (table->slots[slot] != CMD_SLOT_EMPTY)
+        {
+            return false;
+        }
+        table->slots[slot] = i;
+    }
+    table->seed = seed;
+    return true;
+}
+
+esp_err_t cmd_table_init(cmd_table_t *table, const cmd_def_t *cmds, size_t count)
+{
+    if (!table || (!cmds && count) || count > CMD_MAX_COMMANDS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!cmds[i].name || !cmds[i].name[0] || !cmds[i].handler)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (size_t j = 0; j < i; j++)
+        {
+            if (strcmp(cmds[i].name, cmds[j].name) == 0)
+            {
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+    }
+    table->cmds = cmds;
+    table->count = count;
+    // 从命令数的两倍开始，找不到种子时槽数加倍
+    size_t slots = 8;
+    while (slots < 2 * count)
+    {
+        slots *= 2;
+    }
+    for (; slots <= CMD_HASH_SLOTS; slots *= 2)
+    {
+        table->mask = slots - 1;
+        for (uint32_t seed = 0; seed < CMD_SEED_TRIES; seed++)
+        {
+            if (cmd_try_seed(table, seed))
+            {
+                return ESP_OK;
+            }
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+const cmd_def_t *cmd_lookup(const cmd_table_t *table, const char *name, size_t len)
+{
+    uint8_t i = table->slots[cmd_hash(table->seed, name, len) & table->mask];
+    if (i == CMD_SLOT_EMPTY)
+    {
+        return NULL;
+    }
+    const cmd_def_t *cmd = &table->cmds[i];
+    return strncmp(cmd->name, name, len) == 0 && cmd->name[len] == '\0' ? cmd : NULL;
+}
+
+static inline bool cmd_is_space(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * @description: 取下一个以空白分隔的词
+ * @return       词的长度，0 表示没有了
+ */
+static size_t cmd_token(const uint8_t **p, const uint8_t *end, const char **token)
+{
+    const uint8_t *s = *p;
+    while (s < end && cmd_is_space(*s))
+    {
+        s++;
+    }
+    const uint8_t *e = s;
+    while (e < end && !cmd_is_space(*e))
+    {
+        e++;
+    }
+    *token = (const char *)s;
+    *p = e;
+    return e - s;
+}
+
+/**
+ * @description: 十进制整数，可以有负号
+ */
+static bool cmd_parse_int(const char *s, size_t len, int32_t *out)
+{
+    bool neg = len > 0 && s[0] == '-';
+    size_t i = neg ? 1 : 0;
+    if (i == len || len - i > 10)
+    {
+        return false;
+    }
+    int64_t v = 0;
+    for (; i < len; i++)
+    {
+        if (s[i] < '0' || s[i] > '9')
+        {
+            return false;
+        }
+        v = v * 10 + (s[i] - '0');
+    }
+    v = neg ? -v : v;
+    if (v < INT32_MIN || v > INT32_MAX)
+    {
+        return false;
+    }
+    *out = (int32_t)v;
+    return true;
+}
+
+static int cmd_nargs(const cmd_def_t *cmd)
+{
+    int n = 0;
+    while (n < CMD_MAX_ARGS && cmd->args[n].name)
+    {
+        n++;
+    }
+    return n;
+}
+
+esp_err_t cmd_dispatch(const cmd_table_t *table, const uint8_t *line, size_t len, void *ctx, char *err,
+                       size_t err_size)
+{
+    const uint8_t *p = line;
+    const uint8_t *end = line + len;
+    const char *token;
+    size_t n = cmd_token(&p, end, &token);
+    if (n == 0)
+    {
+        return ESP_OK;
+    }
+    const cmd_def_t *cmd = cmd_lookup(table, token, n);
+    if (!cmd)
+    {
+        if (err)
+        {
+            snprintf(err, err_size, "unknown command '%.*s', try 'help'", (int)n, token);
+        }
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    int32_t argv[CMD_MAX_ARGS];
+    int nargs = cmd_nargs(cmd);
+    int argc = 0;
+    while ((n = cmd_token(&p, end, &token)) != 0)
+    {
+        if (argc == nargs)
+        {
+            argc++;
+            break;
+        }
+        const cmd_arg_t *arg = &cmd->args[argc];
+        if (!cmd_parse_int(token, n, &argv[argc]))
+        {
+            if (err)
+            {
+                snprintf(err, err_size, "%s: '%.*s' is not a number", arg->name, (int)n, token);
+            }
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (argv[argc] < arg->min || argv[argc] > arg->max)
+        {
+            if (err)
+            {
+                snprintf(err, err_size, "%s: %d out of range %d..%d", arg->name, (int)argv[argc], (int)arg->min,
+                         (int)arg->max);
+            }
+            return ESP_ERR_INVALID_ARG;
+        }
+        argc++;
+    }
+    if (argc != nargs)
+    {
+        if (err)
+        {
+            int used = snprintf(err, err_size, "usage: ");
+            if (used >= 0 && (size_t)used < err_size)
+            {
+                cmd_usage(cmd, err + used, err_size - used);
+            }
+        }
+        return ESP_ERR_INVALID_ARG;
+    }
+    return cmd->handler(cmd, argv, ctx);
+}
+
+size_t cmd_usage(const cmd_def_t *cmd, char *buf, size_t size)
+{
+    size_t used = 0;
+    int n = snprintf(buf, size, "%s", cmd->name);
+    used += n > 0 ? n : 0;
+    for (int i = 0; i < cmd_nargs(cmd); i++)
+    {
+        n = snprintf(buf + (used < size ? used : size), used < size ? size - used : 0, " <%s>", cmd->args[i].name);
+        used += n > 0 ? n : 0;
+    }
+    return used < size ? used : (size ? size - 1 : 0);
+}
+
+size_t cmd_help(const cmd_table_t *table, char *buf, size_t size)
+{
+    size_t used = 0;
+    for (int i = 0; i < table->count; i++)
+    {
+        char usage[64];
+        cmd_usage(&table->cmds[i], usage, sizeof(usage));
+        int n = snprintf(buf + (used < size ? used : size), used < size ? size - used : 0, "%-24s %s\n", usage,
+                         table->cmds[i].help ? table->cmds[i].help : "");
+        used += n > 0 ? n : 0;
+    }
+    return used;
+}
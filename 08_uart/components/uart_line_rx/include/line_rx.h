@@ -0,0 +1,109 @@
+#ifndef __LINE_RX_H__
+#define __LINE_RX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 接收环形缓冲区和分帧，与 ESP-IDF 无关，可以在PC上测试。
+ *
+ * 数据直接读入 line_rx_reserve() 给出的空间，line_rx_next() 在缓冲区中原地找结束符，
+ * 每个完整的行（或帧）以指针和长度给出，不复制；用完后按顺序 line_rx_release()。
+ * 一行总是连续的：写到缓冲区末尾附近时，把还没结束的半行（通常只有几个字节）移到开头再继续，
+ * 这是唯一的复制，每绕一圈最多一次。结束符为 0 时就是 COBS 等以 0 分隔的二进制帧。
+ * 函数不可重入，同一个接收任务中调用。
+ */
+
+typedef struct
+{
+    uint8_t *buf;
+    size_t size;     /*!< 缓冲区大小，至少是 max_line 的两倍 */
+    size_t max_line; /*!< 一行最长的字节数（含结束符），更长的行丢弃到下一个结束符 */
+    uint8_t term;    /*!< 结束符 */
+    bool strip_cr;   /*!< 去掉结束符前的 '\r' */
+} line_rx_config_t;
+
+#define LINE_RX_DEFAULT_CONFIG(b, s) \
+    {                                \
+        .buf = b,                    \
+        .size = s,                   \
+        .max_line = (s) / 4,         \
+        .term = '\n',                \
+        .strip_cr = true,            \
+    }
+
+typedef struct
+{
+    uint32_t bytes;     /*!< 收到的字节数 */
+    uint32_t lines;     /*!< 给出的完整行数 */
+    uint32_t too_long;  /*!< 超过 max_line 丢弃的行数 */
+    uint32_t overruns;  /*!< 缓冲区满，没有空间接收的次数 */
+} line_rx_stats_t;
+
+/**
+ * @brief 一行，data 在缓冲区中，release 之前有效
+ */
+typedef struct
+{
+    const uint8_t *data; /*!< 不含结束符 */
+    size_t len;
+    size_t end;          /*!< 释放到的位置（结束符之后） */
+    uint32_t lap;        /*!< 所在的一圈 */
+} line_rx_view_t;
+
+typedef struct
+{
+    line_rx_config_t config;
+    size_t rd;         /*!< 最旧的还没释放的字节 */
+    size_t line;       /*!< 还没给出的行的开头 */
+    size_t scan;       /*!< 已经找过结束符的位置，每个字节只找一次 */
+    size_t wr;         /*!< 写入的位置 */
+    size_t wrap_end;   /*!< 绕回开头后，上一圈数据的结束位置 */
+    uint32_t lap;
+    bool wrapped;
+    bool discarding;   /*!< 正在丢弃过长的行 */
+    line_rx_stats_t stats;
+} line_rx_t;
+
+/**
+ * @description: 初始化
+ * @return       false：参数不合理（缓冲区小于 2 * max_line）
+ */
+bool line_rx_init(line_rx_t *rx, const line_rx_config_t *config);
+
+/**
+ * @description: 可以直接写入的连续空间
+ * @return       写入位置；没有空间时返回 NULL（先释放已经给出的行）
+ * @param {size_t} *len 输出，可以写入的字节数
+ */
+uint8_t *line_rx_reserve(line_rx_t *rx, size_t *len);
+
+/**
+ * @description: 提交写入 reserve 空间的 n 个字节
+ */
+void line_rx_commit(line_rx_t *rx, size_t n);
+
+/**
+ * @description: 复制一段数据进来（数据不是来自 reserve 时使用）
+ * @return       接收的字节数，小于 len 时缓冲区满
+ */
+size_t line_rx_feed(line_rx_t *rx, const void *data, size_t len);
+
+/**
+ * @description: 取出下一个完整的行
+ * @return       false：没有完整的行
+ */
+bool line_rx_next(line_rx_t *rx, line_rx_view_t *view);
+
+/**
+ * @description: 释放这一行及之前的所有行，必须按给出的顺序释放
+ */
+void line_rx_release(line_rx_t *rx, const line_rx_view_t *view);
+
+/**
+ * @description: 丢弃所有数据（接收出错后重新同步），已经给出的行不再有效
+ */
+void line_rx_reset(line_rx_t *rx);
+
+#endif /* __LINE_RX_H__ */
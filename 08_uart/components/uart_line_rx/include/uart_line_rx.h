@@ -0,0 +1,69 @@
+#ifndef __UART_LINE_RX_H__
+#define __UART_LINE_RX_H__
+
+#include "line_rx.h"
+#include "esp_err.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+
+/*
+ * 事件驱动的串口接收：驱动带事件队列和结束符检测（pattern 中断），
+ * 接收任务收到事件后把数据直接读入 line_rx 的缓冲区，每个完整的行回调一次。
+ */
+
+/**
+ * @brief 收到一行，在接收任务中调用；line 不含结束符，回调返回后失效
+ */
+typedef void (*uart_line_cb_t)(void *ctx, const uint8_t *line, size_t len);
+
+typedef struct
+{
+    uart_port_t port;        /*!< 已经 uart_param_config 和 uart_set_pin */
+    size_t buf_size;         /*!< line_rx 的缓冲区 */
+    size_t max_line;         /*!< 一行最长的字节数，含结束符 */
+    uint8_t term;            /*!< 结束符，同时用于 pattern 中断 */
+    bool strip_cr;
+    int driver_rx_size;      /*!< 驱动的接收缓冲区 */
+    int driver_tx_size;      /*!< 驱动的发送缓冲区，0 时发送阻塞到写入FIFO */
+    int queue_size;          /*!< 驱动的事件队列长度 */
+    uart_line_cb_t cb;
+    void *ctx;
+    UBaseType_t task_priority;
+    uint32_t task_stack;
+} uart_line_rx_config_t;
+
+#define UART_LINE_RX_DEFAULT_CONFIG(p, c, x) \
+    {                                        \
+        .port = p,                           \
+        .buf_size = 1024,                    \
+        .max_line = 256,                     \
+        .term = '\n',                        \
+        .strip_cr = true,                    \
+        .driver_rx_size = 1024,              \
+        .driver_tx_size = 0,                 \
+        .queue_size = 20,                    \
+        .cb = c,                             \
+        .ctx = x,                            \
+        .task_priority = 10,                 \
+        .task_stack = 4096,                  \
+    }
+
+typedef struct uart_line_rx_s *uart_line_rx_handle_t;
+
+/**
+ * @description: 安装串口驱动，开启结束符检测，启动接收任务
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG / ESP_ERR_NO_MEM / 驱动的错误
+ */
+esp_err_t uart_line_rx_start(const uart_line_rx_config_t *config, uart_line_rx_handle_t *out);
+
+/**
+ * @description: 停止接收任务并删除驱动
+ */
+void uart_line_rx_stop(uart_line_rx_handle_t rx);
+
+/**
+ * @description: 接收统计，overruns 包括驱动的 FIFO 和缓冲区溢出
+ */
+void uart_line_rx_get_stats(uart_line_rx_handle_t rx, line_rx_stats_t *stats);
+
+#endif /* __UART_LINE_RX_H__ */
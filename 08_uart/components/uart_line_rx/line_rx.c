@@ -0,0 +1,137 @@
+#include <string.h>
+#include "line_rx.h"
+
+bool line_rx_init(line_rx_t *rx, const line_rx_config_t *config)
+{
+    if (!rx || !config || !config->buf || config->max_line < 2 || config->size < 2 * config->max_line)
+    {
+        return false;
+    }
+    memset(rx, 0, sizeof(*rx));
+    rx->config = *config;
+    return true;
+}
+
+void line_rx_reset(line_rx_t *rx)
+{
+    rx->rd = rx->line = rx->scan = rx->wr = 0;
+    rx->wrapped = false;
+    rx->discarding = false;
+    rx->lap++;
+}
+
+uint8_t *line_rx_reserve(line_rx_t *rx, size_t *len)
+{
+    size_t size = rx->config.size;
+    if (!rx->wrapped && rx->rd == rx->wr)
+    {
+        // 全部释放，也没有半行：从头开始，不必绕回
+        rx->rd = rx->line = rx->scan = rx->wr = 0;
+    }
+    if (!rx->wrapped && size - rx->line < rx->config.max_line && rx->wr - rx->line < rx->rd)
+    {
+        // 当前行在末尾可能放不下，把半行移到开头，前面的行留在原处直到释放
+        size_t partial = rx->wr - rx->line;
+        memmove(rx->config.buf, rx->config.buf + rx->line, partial);
+        rx->wrapped = rx->rd != rx->line;
+        rx->wrap_end = rx->line;
+        rx->rd = rx->wrapped ? rx->rd : 0;
+        rx->scan -= rx->line;
+        rx->line = 0;
+        rx->wr = partial;
+        rx->lap++;
+    }
+    *len = rx->wrapped ? rx->rd - rx->wr : size - rx->wr;
+    if (*len == 0)
+    {
+        rx->stats.overruns++;
+        return NULL;
+    }
+    return rx->config.buf + rx->wr;
+}
+
+void line_rx_commit(line_rx_t *rx, size_t n)
+{
+    rx->wr += n;
+    rx->stats.bytes += n;
+}
+
+size_t line_rx_feed(line_rx_t *rx, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    size_t done = 0;
+    while (done < len)
+    {
+        size_t room;
+        uint8_t *dst = line_rx_reserve(rx, &room);
+        if (!dst)
+        {
+            break;
+        }
+        size_t n = len - done < room ? len - done : room;
+        memcpy(dst, p + done, n);
+        line_rx_commit(rx, n);
+        done += n;
+    }
+    return done;
+}
+
+bool line_rx_next(line_rx_t *rx, line_rx_view_t *view)
+{
+    uint8_t *buf = rx->config.buf;
+    while (rx->scan < rx->wr)
+    {
+        const uint8_t *p = memchr(buf + rx->scan, rx->config.term, rx->wr - rx->scan);
+        if (!p)
+        {
+            rx->scan = rx->wr;
+            break;
+        }
+        size_t pos = p - buf;
+        if (rx->discarding)
+        {
+            // 过长的行到这里结束，丢弃的字节随后面的行一起释放
+            rx->discarding = false;
+            rx->rd = rx->rd == rx->line ? pos + 1 : rx->rd;
+            rx->line = rx->scan = pos + 1;
+            continue;
+        }
+        size_t len = pos - rx->line;
+        if (rx->config.strip_cr && len && buf[pos - 1] == '\r')
+        {
+            len--;
+        }
+        view->data = buf + rx->line;
+        view->len = len;
+        view->end = pos + 1;
+        view->lap = rx->lap;
+        rx->line = rx->scan = pos + 1;
+        rx->stats.lines++;
+        return true;
+    }
+    if (rx->wr - rx->line >= rx->config.max_line)
+    {
+        if (!rx->discarding)
+        {
+            rx->discarding = true;
+            rx->stats.too_long++;
+        }
+        rx->wr = rx->scan = rx->line;
+    }
+    return false;
+}
+
+void line_rx_release(line_rx_t *rx, const line_rx_view_t *view)
+{
+    if (rx->wrapped && view->lap == rx->lap)
+    {
+        // 新一圈的行：上一圈的已经全部释放
+        rx->wrapped = false;
+    }
+    rx->rd = view->end;
+    if (rx->wrapped && rx->rd == rx->wrap_end)
+    {
+        rx->wrapped = false;
+        rx->rd = 0;
+    }
+}
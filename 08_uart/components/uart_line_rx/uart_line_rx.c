@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include "uart_line_rx.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+static const char *TAG = "uart_line_rx";
+
+struct uart_line_rx_s
+{
+    uart_line_rx_config_t config;
+    line_rx_t rx;
+    QueueHandle_t events;   /*!< 驱动的事件队列，UART_EVENT_MAX 让任务退出 */
+    SemaphoreHandle_t done; /*!< 接收任务退出后释放 */
+    uint32_t driver_overruns;
+    uint8_t buf[];
+};
+
+/**
+ * @description: 读出驱动中的全部数据，每读一次就分出完整的行回调
+ */
+static void uart_line_rx_drain(struct uart_line_rx_s *r)
+{
+    size_t avail = 0;
+    uart_get_buffered_data_len(r->config.port, &avail);
+    while (avail > 0)
+    {
+        size_t room;
+        uint8_t *dst = line_rx_reserve(&r->rx, &room);
+        if (!dst)
+        {
+            // 每行回调后立即释放，不会发生
+            line_rx_reset(&r->rx);
+            continue;
+        }
+        int n = uart_read_bytes(r->config.port, dst, avail < room ? avail : room, 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        line_rx_commit(&r->rx, n);
+        avail -= n;
+        line_rx_view_t view;
+        while (line_rx_next(&r->rx, &view))
+        {
+            r->config.cb(r->config.ctx, view.data, view.len);
+            line_rx_release(&r->rx, &view);
+        }
+    }
+}
+
+static void uart_line_rx_task(void *arg)
+{
+    struct uart_line_rx_s *r = (struct uart_line_rx_s *)arg;
+    uart_event_t event;
+    while (xQueueReceive(r->events, &event, portMAX_DELAY) == pdTRUE && event.type != UART_EVENT_MAX)
+    {
+        switch (event.type)
+        {
+        case UART_PATTERN_DET:
+            // 位置由 line_rx 自己找，这里只取出，避免位置队列满
+            uart_pattern_pop_pos(r->config.port);
+            uart_line_rx_drain(r);
+            break;
+        case UART_DATA:
+            uart_line_rx_drain(r);
+            break;
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            // 丢了数据，半行已经不完整，清空后从下一行重新开始
+            ESP_LOGW(TAG, "UART%d rx overflow", r->config.port);
+            r->driver_overruns++;
+            uart_flush_input(r->config.port);
+            line_rx_reset(&r->rx);
+            r->rx.discarding = true;
+            break;
+        default:
+            break;
+        }
+    }
+    xSemaphoreGive(r->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t uart_line_rx_start(const uart_line_rx_config_t *config, uart_line_rx_handle_t *out)
+{
+    if (!config || !out || !config->cb)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct uart_line_rx_s *r = calloc(1, sizeof(struct uart_line_rx_s) + config->buf_size);
+    if (!r)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    r->config = *config;
+    line_rx_config_t rx_config = {
+        .buf = r->buf,
+        .size = config->buf_size,
+        .max_line = config->max_line,
+        .term = config->term,
+        .strip_cr = config->strip_cr,
+    };
+    if (!line_rx_init(&r->rx, &rx_config))
+    {
+        free(r);
+        return ESP_ERR_INVALID_ARG;
+    }
+    r->done = xSemaphoreCreateBinary();
+    if (!r->done)
+    {
+        free(r);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = uart_driver_install(config->port, config->driver_rx_size, config->driver_tx_size,
+                                        config->queue_size, &r->events, 0);
+    if (ret == ESP_OK)
+    {
+        // 结束符单独出现即触发，不要求前后空闲
+        ret = uart_enable_pattern_det_baud_intr(config->port, config->term, 1, 9, 0, 0);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = uart_pattern_queue_reset(config->port, config->queue_size);
+    }
+    if (ret == ESP_OK && xTaskCreate(uart_line_rx_task, "uart_line_rx", config->task_stack, r,
+                                     config->task_priority, NULL) != pdPASS)
+    {
+        ret = ESP_ERR_NO_MEM;
+    }
+    if (ret != ESP_OK)
+    {
+        if (r->events)
+        {
+            uart_driver_delete(config->port);
+        }
+        vSemaphoreDelete(r->done);
+        free(r);
+        return ret;
+    }
+    *out = r;
+    return ESP_OK;
+}
+
+void uart_line_rx_stop(uart_line_rx_handle_t r)
+{
+    if (!r)
+    {
+        return;
+    }
+    uart_event_t event = {.type = UART_EVENT_MAX};
+    xQueueSend(r->events, &event, portMAX_DELAY);
+    xSemaphoreTake(r->done, portMAX_DELAY);
+    uart_driver_delete(r->config.port);
+    vSemaphoreDelete(r->done);
+    free(r);
+}
+
+void uart_line_rx_get_stats(uart_line_rx_handle_t r, line_rx_stats_t *stats)
+{
+    // 在其它任务中读，各个计数之间不保证一致
+    *stats = r->rx.stats;
+    stats->overruns += r->driver_overruns;
+}
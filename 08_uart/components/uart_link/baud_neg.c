@@ -0,0 +1,277 @@
+#include <string.h>
+#include "baud_neg.h"
+
+static const uint32_t s_standard[] = {
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 500000, 921600, 1000000, 1500000, 2000000, 3000000, 4000000,
+};
+
+#define BAUD_STANDARD_COUNT (sizeof(s_standard) / sizeof(s_standard[0]))
+
+bool baud_is_standard(uint32_t baud)
+{
+    for (size_t i = 0; i < BAUD_STANDARD_COUNT; i++)
+    {
+        if (s_standard[i] == baud)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t baud_nearest_standard(uint32_t baud, uint8_t tolerance_pct)
+{
+    // 按相对误差（ppm）比较
+    uint32_t best = 0;
+    uint64_t best_ppm = UINT64_MAX;
+    for (size_t i = 0; i < BAUD_STANDARD_COUNT; i++)
+    {
+        uint32_t err = s_standard[i] > baud ? s_standard[i] - baud : baud - s_standard[i];
+        uint64_t ppm = (uint64_t)err * 1000000 / s_standard[i];
+        if (ppm < best_ppm)
+        {
+            best_ppm = ppm;
+            best = s_standard[i];
+        }
+    }
+    return best_ppm <= (uint64_t)tolerance_pct * 10000 ? best : 0;
+}
+
+uint32_t baud_from_pulses(uint32_t clk_hz, uint32_t low_min, uint32_t high_min, uint8_t tolerance_pct)
+{
+    // 最短的脉冲是一位：取两者中较短的（另一种电平可能一直是连续的几位）
+    uint32_t bit = low_min;
+    if (high_min && (!bit || high_min < bit))
+    {
+        bit = high_min;
+    }
+    if (!bit)
+    {
+        return 0;
+    }
+    return baud_nearest_standard((clk_hz + bit / 2) / bit, tolerance_pct);
+}
+
+esp_err_t baud_neg_init(baud_neg_t *n, const baud_neg_config_t *config, baud_hw_t *hw)
+{
+    if (!n || !config || !hw || !config->base_baud || !config->retries)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(n, 0, sizeof(*n));
+    n->config = *config;
+    n->hw = hw;
+    n->baud = config->base_baud;
+    n->prev_baud = config->base_baud;
+    return ESP_OK;
+}
+
+static void baud_neg_send(baud_neg_t *n, baud_msg_type_t type, uint8_t token, uint32_t baud)
+{
+    uint8_t msg[BAUD_MSG_SIZE] = {type, token, baud & 0xFF, (baud >> 8) & 0xFF, (baud >> 16) & 0xFF, baud >> 24};
+    n->hw->send(n->hw, msg, sizeof(msg));
+}
+
+static bool baud_neg_supported(const baud_neg_t *n, uint32_t baud)
+{
+    return baud_is_standard(baud) && baud <= n->config.max_baud;
+}
+
+static void baud_neg_switch(baud_neg_t *n, uint32_t baud)
+{
+    if (baud != n->baud)
+    {
+        n->hw->set_baud(n->hw, baud);
+        n->baud = baud;
+    }
+}
+
+static void baud_neg_finish(baud_neg_t *n, esp_err_t result)
+{
+    n->state = BAUD_NEG_IDLE;
+    if (n->config.cb)
+    {
+        n->config.cb(n->config.ctx, n->baud, result);
+    }
+}
+
+esp_err_t baud_neg_start(baud_neg_t *n, uint32_t baud)
+{
+    if (n->state != BAUD_NEG_IDLE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!baud_neg_supported(n, baud))
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    n->token++;
+    n->target = baud;
+    n->state = BAUD_NEG_REQUESTED;
+    n->tries = 1;
+    baud_neg_send(n, BAUD_MSG_REQ, n->token, baud);
+    n->next_tx_us = n->hw->now_us(n->hw) + (int64_t)n->config.retry_ms * 1000;
+    return ESP_OK;
+}
+
+/**
+ * @description: 对端：收到 REQ
+ */
+static void baud_neg_on_req(baud_neg_t *n, uint8_t token, uint32_t baud)
+{
+    if (n->state == BAUD_NEG_REQUESTED || n->state == BAUD_NEG_VERIFY || !baud_neg_supported(n, baud))
+    {
+        // 同时发起或不支持
+        n->stats.rejected++;
+        baud_neg_send(n, BAUD_MSG_NAK, token, baud);
+        return;
+    }
+    // ACK 在原来的波特率上发完后才切换
+    n->token = token;
+    n->target = baud;
+    baud_neg_send(n, BAUD_MSG_ACK, n->token, baud);
+    if (n->state == BAUD_NEG_IDLE)
+    {
+        n->prev_baud = n->baud;
+    }
+    baud_neg_switch(n, baud);
+    n->state = BAUD_NEG_ACCEPTED;
+    n->deadline_us = n->hw->now_us(n->hw) + (int64_t)n->config.verify_ms * 2000;
+}
+
+void baud_neg_input(baud_neg_t *n, const uint8_t *data, size_t len)
+{
+    if (len != BAUD_MSG_SIZE)
+    {
+        return;
+    }
+    uint8_t type = data[0];
+    uint8_t token = data[1];
+    uint32_t baud = data[2] | (data[3] << 8) | (data[4] << 16) | ((uint32_t)data[5] << 24);
+    if (type == BAUD_MSG_REQ)
+    {
+        baud_neg_on_req(n, token, baud);
+        return;
+    }
+    if (token != n->token || baud != n->target)
+    {
+        return;
+    }
+    switch (type)
+    {
+    case BAUD_MSG_ACK:
+        if (n->state == BAUD_NEG_REQUESTED)
+        {
+            n->prev_baud = n->baud;
+            baud_neg_switch(n, baud);
+            n->state = BAUD_NEG_VERIFY;
+            int64_t now = n->hw->now_us(n->hw);
+            n->deadline_us = now + (int64_t)n->config.verify_ms * 1000;
+            // 对端可能比本端晚一点切换，第一次 PING 由 poll 稍后发出
+            n->next_tx_us = now + (int64_t)n->config.retry_ms * 1000 / 4;
+        }
+        break;
+    case BAUD_MSG_NAK:
+        if (n->state == BAUD_NEG_REQUESTED)
+        {
+            n->stats.rejected++;
+            baud_neg_finish(n, ESP_ERR_NOT_SUPPORTED);
+        }
+        break;
+    case BAUD_MSG_PING:
+        if (n->state == BAUD_NEG_ACCEPTED || (n->state == BAUD_NEG_IDLE && n->baud == baud))
+        {
+            baud_neg_send(n, BAUD_MSG_PONG, n->token, baud);
+        }
+        break;
+    case BAUD_MSG_PONG:
+        if (n->state == BAUD_NEG_VERIFY)
+        {
+            for (uint8_t i = 0; i < n->config.confirms; i++)
+            {
+                baud_neg_send(n, BAUD_MSG_CONFIRM, n->token, baud);
+            }
+            n->stats.switches++;
+            baud_neg_finish(n, ESP_OK);
+        }
+        break;
+    case BAUD_MSG_CONFIRM:
+        if (n->state == BAUD_NEG_ACCEPTED)
+        {
+            n->stats.switches++;
+            baud_neg_finish(n, ESP_OK);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int64_t baud_neg_poll(baud_neg_t *n)
+{
+    if (n->state == BAUD_NEG_IDLE)
+    {
+        return INT64_MAX;
+    }
+    int64_t now = n->hw->now_us(n->hw);
+    if (n->state != BAUD_NEG_REQUESTED && now >= n->deadline_us)
+    {
+        // 新的波特率不通
+        n->stats.fallbacks++;
+        baud_neg_switch(n, n->prev_baud);
+        baud_neg_finish(n, ESP_ERR_TIMEOUT);
+        return INT64_MAX;
+    }
+    if (n->state != BAUD_NEG_ACCEPTED && now >= n->next_tx_us)
+    {
+        if (n->state == BAUD_NEG_REQUESTED)
+        {
+            if (n->tries >= n->config.retries)
+            {
+                baud_neg_finish(n, ESP_ERR_TIMEOUT);
+                return INT64_MAX;
+            }
+            n->tries++;
+        }
+        baud_neg_send(n, n->state == BAUD_NEG_REQUESTED ? BAUD_MSG_REQ : BAUD_MSG_PING, n->token, n->target);
+        n->next_tx_us = now + (int64_t)n->config.retry_ms * 1000;
+    }
+    int64_t next = n->state == BAUD_NEG_ACCEPTED ? n->deadline_us : n->next_tx_us;
+    if (n->state == BAUD_NEG_VERIFY && n->deadline_us < next)
+    {
+        next = n->deadline_us;
+    }
+    return next > now ? next - now : 0;
+}
+
+void baud_neg_link_lost(baud_neg_t *n)
+{
+    if (n->state == BAUD_NEG_IDLE && n->baud != n->config.base_baud)
+    {
+        n->stats.resets++;
+        n->prev_baud = n->config.base_baud;
+        baud_neg_switch(n, n->config.base_baud);
+        if (n->config.cb)
+        {
+            n->config.cb(n->config.ctx, n->baud, ESP_ERR_TIMEOUT);
+        }
+    }
+}
+
+esp_err_t baud_neg_follow(baud_neg_t *n, uint32_t baud)
+{
+    if (n->state != BAUD_NEG_IDLE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (baud != n->config.base_baud && !baud_neg_supported(n, baud))
+    {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (baud != n->baud)
+    {
+        n->stats.follows++;
+        baud_neg_switch(n, baud);
+    }
+    return ESP_OK;
+}
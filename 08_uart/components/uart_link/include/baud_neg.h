@@ -0,0 +1,161 @@
+#ifndef __BAUD_NEG_H__
+#define __BAUD_NEG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * 运行时切换波特率的协商，与 ESP-IDF 无关，消息放在 link_proto 的控制帧中，ESP32 和PC用同一份代码。
+ *
+ * 发起方在原来的波特率上发 REQ；对端支持这个波特率就回 ACK 并切换，否则回 NAK。
+ * 发起方收到 ACK 后切换，在新的波特率上发 PING，收到 PONG 后确认新的波特率并发 CONFIRM（发几次），
+ * 对端收到 CONFIRM 后确认。verify_ms 内没有完成的一方回到原来的波特率（对端等两倍的时间）。
+ * CONFIRM 全部丢失时两端不一致：发起方在 link_proto 放弃重发后调用 baud_neg_link_lost() 回到 base_baud，
+ * 接收方可以用自动波特率检测（baud_from_pulses）跟上，调用 baud_neg_follow()。
+ * 同时发起时双方都回 NAK，由调用者稍后再试。函数不可重入，由调用者加锁。
+ */
+
+#define BAUD_MSG_SIZE 6 /*!< 类型、编号、波特率（小端） */
+
+typedef enum
+{
+    BAUD_MSG_REQ = 1,
+    BAUD_MSG_ACK,
+    BAUD_MSG_NAK,
+    BAUD_MSG_PING,
+    BAUD_MSG_PONG,
+    BAUD_MSG_CONFIRM,
+} baud_msg_type_t;
+
+typedef enum
+{
+    BAUD_NEG_IDLE = 0,
+    BAUD_NEG_REQUESTED, /*!< 发起方：等 ACK */
+    BAUD_NEG_VERIFY,    /*!< 发起方：已切换，等 PONG */
+    BAUD_NEG_ACCEPTED,  /*!< 对端：已切换，等 CONFIRM */
+} baud_neg_state_t;
+
+typedef struct baud_hw_s baud_hw_t;
+
+/**
+ * @brief 用到的平台操作
+ */
+struct baud_hw_s
+{
+    esp_err_t (*send)(baud_hw_t *hw, const uint8_t *data, size_t len); /*!< 发一个控制帧 */
+    esp_err_t (*set_baud)(baud_hw_t *hw, uint32_t baud);               /*!< 等已写入的数据发完后切换 */
+    int64_t (*now_us)(baud_hw_t *hw);
+};
+
+/**
+ * @brief 协商结束（两端都会调用）
+ * @param baud 现在的波特率
+ * @param result ESP_OK / ESP_ERR_TIMEOUT（没有响应或验证失败，已回到原来的波特率）/ ESP_ERR_NOT_SUPPORTED（对端拒绝）
+ */
+typedef void (*baud_done_cb_t)(void *ctx, uint32_t baud, esp_err_t result);
+
+typedef struct
+{
+    uint32_t base_baud;   /*!< 启动时的波特率，两端失去联系时回到它 */
+    uint32_t max_baud;    /*!< 接受的最高波特率，0 表示不接受切换 */
+    uint32_t retry_ms;    /*!< REQ、PING 的重发间隔 */
+    uint8_t retries;      /*!< REQ 的最多发送次数 */
+    uint32_t verify_ms;   /*!< 切换后验证的时间 */
+    uint8_t confirms;     /*!< CONFIRM 的发送次数 */
+    baud_done_cb_t cb;
+    void *ctx;
+} baud_neg_config_t;
+
+#define BAUD_NEG_DEFAULT_CONFIG(b, m)   \
+    {                                   \
+        .base_baud = b,                 \
+        .max_baud = m,                  \
+        .retry_ms = 50,                 \
+        .retries = 5,                   \
+        .verify_ms = 200,               \
+        .confirms = 3,                  \
+        .cb = NULL,                     \
+        .ctx = NULL,                    \
+    }
+
+typedef struct
+{
+    uint32_t switches;  /*!< 确认了新的波特率 */
+    uint32_t fallbacks; /*!< 验证失败，回到原来的波特率 */
+    uint32_t rejected;  /*!< 发出或收到的 NAK */
+    uint32_t resets;    /*!< 失去联系后回到 base_baud */
+    uint32_t follows;   /*!< 按检测到的波特率切换 */
+} baud_neg_stats_t;
+
+typedef struct
+{
+    baud_neg_config_t config;
+    baud_hw_t *hw;
+    baud_neg_state_t state;
+    uint32_t baud;        /*!< 现在的波特率 */
+    uint32_t prev_baud;   /*!< 验证失败时回到的波特率 */
+    uint32_t target;      /*!< 协商中的波特率 */
+    uint8_t token;        /*!< 协商的编号，发起方每次加一 */
+    uint8_t tries;
+    int64_t deadline_us;  /*!< 验证的截止时间 */
+    int64_t next_tx_us;   /*!< 下一次发 REQ 或 PING 的时间 */
+    baud_neg_stats_t stats;
+} baud_neg_t;
+
+/**
+ * @description: 初始化，现在的波特率为 base_baud
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG
+ */
+esp_err_t baud_neg_init(baud_neg_t *n, const baud_neg_config_t *config, baud_hw_t *hw);
+
+/**
+ * @description: 发起切换，结果在 cb 中
+ * @return       ESP_OK / ESP_ERR_INVALID_STATE（正在协商）/ ESP_ERR_NOT_SUPPORTED（不是标准波特率或超过 max_baud）
+ */
+esp_err_t baud_neg_start(baud_neg_t *n, uint32_t baud);
+
+/**
+ * @description: 处理收到的控制帧
+ */
+void baud_neg_input(baud_neg_t *n, const uint8_t *data, size_t len);
+
+/**
+ * @description: 重发 REQ、PING，验证超时回到原来的波特率
+ * @return       到下一次需要调用的微秒数，空闲时返回 INT64_MAX
+ */
+int64_t baud_neg_poll(baud_neg_t *n);
+
+/**
+ * @description: 对端不再响应（link_proto 放弃重发）时调用，不在 base_baud 就回去
+ */
+void baud_neg_link_lost(baud_neg_t *n);
+
+/**
+ * @description: 按检测到的对端波特率切换，不协商
+ * @return       ESP_OK / ESP_ERR_NOT_SUPPORTED / ESP_ERR_INVALID_STATE（正在协商）
+ */
+esp_err_t baud_neg_follow(baud_neg_t *n, uint32_t baud);
+
+/**
+ * @description: 是否为支持的标准波特率（9600 ~ 4000000）
+ */
+bool baud_is_standard(uint32_t baud);
+
+/**
+ * @description: 最接近的标准波特率
+ * @return       误差超过 tolerance_pct 时返回 0
+ */
+uint32_t baud_nearest_standard(uint32_t baud, uint8_t tolerance_pct);
+
+/**
+ * @description: 从自动波特率检测的最短脉宽估计波特率，取最接近的标准波特率
+ * @return       标准波特率，误差超过 tolerance_pct 或脉宽为 0 时返回 0
+ * @param {uint32_t} clk_hz 计数的时钟
+ * @param {uint32_t} low_min 最短的低电平，计数值
+ * @param {uint32_t} high_min 最短的高电平，计数值；0 表示只用低电平
+ */
+uint32_t baud_from_pulses(uint32_t clk_hz, uint32_t low_min, uint32_t high_min, uint8_t tolerance_pct);
+
+#endif /* __BAUD_NEG_H__ */
@@ -0,0 +1,36 @@
+#ifndef __LINK_FRAME_H__
+#define __LINK_FRAME_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * 二进制帧的编码：COBS 把数据中的 0 去掉，帧之间用一个 0 分隔；CRC-16/CCITT-FALSE 校验。
+ * 每 254 字节多 1 字节开销，接收端任何时候都能在下一个 0 处重新同步。
+ */
+
+/**
+ * @description: 编码后最多的长度（不含分隔的 0）
+ */
+#define COBS_MAX_ENCODED(n) ((n) + (n) / 254 + 1)
+
+/**
+ * @description: COBS 编码，out 至少 COBS_MAX_ENCODED(len) 字节，不能与 in 重叠
+ * @return       编码后的长度，不含分隔的 0
+ */
+size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @description: COBS 解码，out 至少 len 字节，可以与 in 相同（原地解码）
+ * @return       false：数据中有 0 或长度不对
+ * @param {size_t} *out_len 解码后的长度
+ */
+bool cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t *out_len);
+
+/**
+ * @description: CRC-16/CCITT-FALSE（多项式 0x1021），初值传 0xFFFF，可以分段计算
+ */
+uint16_t crc16_ccitt(uint16_t crc, const void *data, size_t len);
+
+#endif /* __LINK_FRAME_H__ */
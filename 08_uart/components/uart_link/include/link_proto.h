@@ -0,0 +1,162 @@
+#ifndef __LINK_PROTO_H__
+#define __LINK_PROTO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * 串口上的二进制传输层，与 ESP-IDF 无关，ESP32 和PC（uart_link_posix）用同一份代码。
+ *
+ * 帧：头 5 字节（类型、本端会话号、序号、对端会话号、确认号）+ 数据 + CRC-16，整体 COBS 编码后以 0 结束。
+ * 收到过对端的数据帧后类型的最高位置 1，表示确认号有效。
+ * 可靠的数据按序号滑动窗口发送（Go-Back-N）：对端按序接收，每帧都带累计确认；
+ * 最旧的未确认帧在预计发完后 rto_ms 内没有确认就重发窗口内的所有帧。
+ * 不可靠的数据报没有序号，出错就丢弃，适合周期性的遥测。
+ * 会话号在每次启动时随机选取：对端看到新的会话号就从序号 0 重新开始，不会把重启前的帧当成重复。
+ * 控制帧和数据报一样不重发，交给 ctrl_cb，供链路本身的管理（如 baud_neg 切换波特率）使用。
+ * 函数不可重入，由调用者加锁。
+ */
+
+#define LINK_MAX_PAYLOAD 512
+#define LINK_MAX_WINDOW 8
+#define LINK_HEADER_SIZE 5
+#define LINK_CRC_SIZE 2
+#define LINK_MAX_FRAME (LINK_HEADER_SIZE + LINK_MAX_PAYLOAD + LINK_CRC_SIZE)
+#define LINK_MAX_ENCODED (LINK_MAX_FRAME + LINK_MAX_FRAME / 254 + 2) /*!< 含结束的 0 */
+
+typedef enum
+{
+    LINK_FRAME_DATA = 1, /*!< 可靠的数据，有序号 */
+    LINK_FRAME_DGRAM,    /*!< 不可靠的数据报 */
+    LINK_FRAME_ACK,      /*!< 只有确认 */
+    LINK_FRAME_CTRL,     /*!< 控制帧，不重发，交给 ctrl_cb */
+} link_frame_type_t;
+
+#define LINK_FRAME_ACK_VALID 0x80
+
+typedef struct link_hw_s link_hw_t;
+
+/**
+ * @brief 用到的平台操作
+ */
+struct link_hw_s
+{
+    esp_err_t (*write)(link_hw_t *hw, const uint8_t *data, size_t len); /*!< 写一个完整的帧（含结束的 0） */
+    int64_t (*now_us)(link_hw_t *hw);
+};
+
+/**
+ * @brief 收到数据，在 link_input() 中调用；data 在返回后失效
+ * @param reliable 可靠的数据（按顺序，不重复）还是数据报
+ */
+typedef void (*link_rx_cb_t)(void *ctx, const uint8_t *data, size_t len, bool reliable);
+
+typedef struct
+{
+    uint32_t baud;       /*!< 用于估计帧发完的时间，0 表示写入即发完 */
+    uint8_t window;      /*!< 未确认帧的个数上限，不超过 LINK_MAX_WINDOW */
+    uint32_t rto_ms;     /*!< 帧发完后等确认的时间 */
+    uint8_t max_retries; /*!< 同一帧重发这么多次后放弃窗口内的所有帧，会话号加一后重新开始 */
+    uint8_t session;     /*!< 本次启动的会话号，应随机选取 */
+    link_rx_cb_t cb;
+    void *ctx;
+    link_rx_cb_t ctrl_cb; /*!< 收到控制帧，reliable 为 false；NULL 时丢弃 */
+    void *ctrl_ctx;
+} link_config_t;
+
+#define LINK_DEFAULT_CONFIG(s, c, x)    \
+    {                                   \
+        .baud = 0,                      \
+        .window = LINK_MAX_WINDOW,      \
+        .rto_ms = 20,                   \
+        .max_retries = 10,              \
+        .session = s,                   \
+        .cb = c,                        \
+        .ctx = x,                       \
+        .ctrl_cb = NULL,                \
+        .ctrl_ctx = NULL,               \
+    }
+
+typedef struct
+{
+    uint32_t tx_frames;   /*!< 发出的帧，含重发和确认 */
+    uint32_t tx_bytes;    /*!< 发出的字节，含编码和结束的 0 */
+    uint32_t retransmits; /*!< 重发的帧 */
+    uint32_t lost;        /*!< 重发太多次放弃的帧 */
+    uint32_t rx_frames;   /*!< 校验正确的帧 */
+    uint32_t rx_errors;   /*!< COBS、长度或 CRC 错误 */
+    uint32_t rx_dropped;  /*!< 序号不对（重复或前面的帧丢了）的数据帧 */
+    uint32_t resyncs;     /*!< 对端的会话号变了 */
+} link_stats_t;
+
+typedef struct
+{
+    int64_t deadline_us; /*!< 到这个时间还没确认就重发 */
+    uint16_t len;
+    uint8_t seq;
+    uint8_t retries;
+    uint8_t data[LINK_MAX_PAYLOAD];
+} link_slot_t;
+
+typedef struct
+{
+    link_config_t config;
+    link_hw_t *hw;
+    int64_t tx_busy_us;      /*!< 估计的串口发完已写入数据的时间 */
+    uint8_t tx_base;         /*!< 最旧的未确认序号 */
+    uint8_t tx_next;         /*!< 下一个发送序号 */
+    uint8_t rx_session;      /*!< 对端的会话号 */
+    uint8_t rx_next;         /*!< 期望对端的下一个序号 */
+    bool rx_synced;          /*!< 收到过对端的数据帧 */
+    bool ack_pending;        /*!< 收到数据帧后还没有发出确认 */
+    link_slot_t slots[LINK_MAX_WINDOW]; /*!< 按序号 % LINK_MAX_WINDOW 存放未确认的帧 */
+    uint8_t tx_raw[LINK_MAX_FRAME];
+    uint8_t tx_frame[LINK_MAX_ENCODED];
+    uint8_t rx_frame[LINK_MAX_ENCODED]; /*!< 接收回调中可以发送，收发分开 */
+    link_stats_t stats;
+} link_t;
+
+/**
+ * @description: 初始化
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG
+ */
+esp_err_t link_init(link_t *link, const link_config_t *config, link_hw_t *hw);
+
+/**
+ * @description: 发送
+ * @return       ESP_OK / ESP_ERR_INVALID_SIZE（超过 LINK_MAX_PAYLOAD）/ ESP_ERR_NO_MEM（窗口满，等确认后再试）/
+ *               写入的错误（只对数据报；可靠的数据进入窗口后写入失败也会重发）
+ * @param {bool} reliable 可靠的数据；false 为数据报
+ */
+esp_err_t link_send(link_t *link, const void *data, size_t len, bool reliable);
+
+/**
+ * @description: 发送控制帧，不重发
+ * @return       ESP_OK / ESP_ERR_INVALID_SIZE / 写入的错误
+ */
+esp_err_t link_send_ctrl(link_t *link, const void *data, size_t len);
+
+/**
+ * @description: 串口换了波特率后调用，用于估计帧发完的时间
+ */
+void link_set_baud(link_t *link, uint32_t baud);
+
+/**
+ * @description: 处理收到的一帧：两个 0 之间的编码数据，不含 0
+ */
+void link_input(link_t *link, const uint8_t *data, size_t len);
+
+/**
+ * @description: 重发超时的帧
+ * @return       到下一次需要调用的微秒数，没有未确认的帧时返回 INT64_MAX
+ */
+int64_t link_poll(link_t *link);
+
+/**
+ * @description: 未确认的帧数
+ */
+uint8_t link_tx_pending(const link_t *link);
+
+#endif /* __LINK_PROTO_H__ */
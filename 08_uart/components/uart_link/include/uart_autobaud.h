@@ -0,0 +1,29 @@
+#ifndef __UART_AUTOBAUD_H__
+#define __UART_AUTOBAUD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driver/uart.h"
+
+/*
+ * ESP32-C3 串口的自动波特率检测：硬件在接收的同时记录 RXD 的边沿数和最短的高、低电平脉宽（时钟数），
+ * 不影响正常接收。脉宽按串口的时钟源计数，这里假设是 APB（UART_SCLK_APB）。
+ */
+
+/**
+ * @description: 开始（或重新开始）测量，计数清零
+ */
+void uart_autobaud_restart(uart_port_t port);
+
+/**
+ * @description: 停止测量
+ */
+void uart_autobaud_stop(uart_port_t port);
+
+/**
+ * @description: 从开始测量以来收到的数据估计对端的波特率
+ * @return       最接近的标准波特率；边沿少于 min_edges 或误差太大时返回 0
+ */
+uint32_t uart_autobaud_read(uart_port_t port, uint32_t min_edges);
+
+#endif /* __UART_AUTOBAUD_H__ */
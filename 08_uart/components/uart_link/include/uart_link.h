@@ -0,0 +1,87 @@
+#ifndef __UART_LINK_H__
+#define __UART_LINK_H__
+
+#include "link_proto.h"
+#include "baud_neg.h"
+#include "uart_txq.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+
+/*
+ * link_proto 在 ESP32 串口上的驱动：uart_line_rx 以 0 分帧接收，esp_timer 到期时通知链路任务重发，
+ * 发送经过驱动的发送缓冲区，不等串口发完；给出 txq 时经过 uart_txq，发送（包括接收回调中的确认）从不等待。
+ * 波特率在启动时从驱动读出，用于估计帧发完的时间。
+ * max_baud 不为 0 时接受对端切换波特率的请求（baud_neg），uart_link_set_baud() 主动切换；
+ * autobaud 时连续收到错误的帧就用 ESP32-C3 的自动波特率检测看对端的波特率，是支持的就跟上。
+ */
+
+typedef struct
+{
+    uart_port_t port;      /*!< 已经 uart_param_config 和 uart_set_pin */
+    int driver_rx_size;
+    int driver_tx_size;    /*!< 至少放得下一个窗口的帧 */
+    uart_txq_handle_t txq; /*!< 同一个串口的发送队列，NULL 时直接写驱动 */
+    uint8_t window;
+    uint32_t rto_ms;
+    uint8_t max_retries;
+    uint32_t max_baud;     /*!< 接受切换的最高波特率，0 表示不切换 */
+    bool autobaud;         /*!< 收不到正确的帧时检测对端的波特率 */
+    link_rx_cb_t cb;       /*!< 在接收任务中调用，回调中可以发送 */
+    void *ctx;
+    UBaseType_t task_priority; /*!< 接收任务和链路任务 */
+    uint32_t task_stack;
+} uart_link_config_t;
+
+#define UART_LINK_DEFAULT_CONFIG(p, c, x)                       \
+    {                                                           \
+        .port = p,                                              \
+        .driver_rx_size = 4096,                                 \
+        .driver_tx_size = LINK_MAX_WINDOW * LINK_MAX_ENCODED,   \
+        .txq = NULL,                                            \
+        .window = LINK_MAX_WINDOW,                              \
+        .rto_ms = 20,                                           \
+        .max_retries = 10,                                      \
+        .max_baud = 0,                                          \
+        .autobaud = false,                                      \
+        .cb = c,                                                \
+        .ctx = x,                                               \
+        .task_priority = 10,                                    \
+        .task_stack = 4096,                                     \
+    }
+
+typedef struct uart_link_s *uart_link_handle_t;
+
+/**
+ * @description: 安装串口驱动，开始接收
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG / ESP_ERR_NO_MEM / 驱动的错误
+ */
+esp_err_t uart_link_start(const uart_link_config_t *config, uart_link_handle_t *out);
+
+/**
+ * @description: 发送，可靠的数据在窗口满时等待确认
+ * @return       ESP_OK / ESP_ERR_INVALID_SIZE / ESP_ERR_TIMEOUT（wait 内窗口一直是满的）
+ */
+esp_err_t uart_link_send(uart_link_handle_t link, const void *data, size_t len, bool reliable, TickType_t wait);
+
+void uart_link_get_stats(uart_link_handle_t link, link_stats_t *stats);
+
+/**
+ * @description: 与对端协商切换波特率，等到验证完成；失败时两端都回到原来的波特率
+ * @return       ESP_OK / ESP_ERR_NOT_SUPPORTED（本端或对端不支持）/ ESP_ERR_TIMEOUT（对端没有响应或新的波特率不通）/
+ *               ESP_ERR_INVALID_STATE（正在协商）
+ */
+esp_err_t uart_link_set_baud(uart_link_handle_t link, uint32_t baud);
+
+/**
+ * @description: 现在的波特率
+ */
+uint32_t uart_link_get_baud(uart_link_handle_t link);
+
+void uart_link_get_baud_stats(uart_link_handle_t link, baud_neg_stats_t *stats);
+
+/**
+ * @description: 停止接收并删除驱动，未确认的帧丢弃
+ */
+void uart_link_stop(uart_link_handle_t link);
+
+#endif /* __UART_LINK_H__ */
@@ -0,0 +1,65 @@
+#ifndef __UART_LINK_POSIX_H__
+#define __UART_LINK_POSIX_H__
+
+#include "link_proto.h"
+#include "baud_neg.h"
+
+/*
+ * link_proto 在 Linux 串口（termios）上的驱动，PC 一端用，与 ESP32 上的 uart_link 互通。
+ * 单线程：uart_link_posix_poll() 读入数据、分帧、回调和重发，发送在窗口满时也在里面等待。
+ * 切换波特率的协商（baud_neg）也在 poll 中处理；默认不接受对端的请求，见 uart_link_posix_accept_baud()。
+ * 不属于 ESP-IDF 组件，在 host/CMakeLists.txt 中编译。
+ */
+
+typedef struct uart_link_posix_s uart_link_posix_t;
+
+/**
+ * @description: 打开串口并设置为原始模式
+ * @return       0 / -errno（不支持的波特率为 -EINVAL）
+ * @param {uint32_t} baud 标准的波特率，最高 4000000
+ * @param {link_config_t} *config baud 字段被忽略
+ */
+int uart_link_posix_open(const char *path, uint32_t baud, const link_config_t *config, uart_link_posix_t **out);
+
+/**
+ * @description: 使用已经打开的文件（如 pty），不改变它的设置，关闭时一起关闭
+ * @return       NULL：内存不足或参数不对
+ */
+uart_link_posix_t *uart_link_posix_attach(int fd, const link_config_t *config);
+
+/**
+ * @description: 等数据或重发的时间，最多 timeout_ms，处理收到的帧
+ * @return       处理的帧数 / -errno
+ */
+int uart_link_posix_poll(uart_link_posix_t *l, int timeout_ms);
+
+/**
+ * @description: 发送，可靠的数据在窗口满时一边 poll 一边等
+ * @return       ESP_OK / ESP_ERR_INVALID_SIZE / ESP_ERR_TIMEOUT / ESP_FAIL（读写出错）
+ */
+esp_err_t uart_link_posix_send(uart_link_posix_t *l, const void *data, size_t len, bool reliable, int timeout_ms);
+
+/**
+ * @description: 等所有可靠的数据被确认（或放弃）
+ * @return       ESP_OK / ESP_ERR_TIMEOUT
+ */
+esp_err_t uart_link_posix_flush(uart_link_posix_t *l, int timeout_ms);
+
+/**
+ * @description: 允许切换到不超过 max_baud 的标准波特率（本端发起或对端请求），0 表示不切换
+ */
+void uart_link_posix_accept_baud(uart_link_posix_t *l, uint32_t max_baud);
+
+/**
+ * @description: 与对端协商切换波特率，一边 poll 一边等结果
+ * @return       ESP_OK / ESP_ERR_NOT_SUPPORTED（超过 max_baud 或对端拒绝）/ ESP_ERR_TIMEOUT（没有响应、验证失败或 timeout_ms 到了）/ ESP_FAIL
+ */
+esp_err_t uart_link_posix_set_baud(uart_link_posix_t *l, uint32_t baud, int timeout_ms);
+
+uint32_t uart_link_posix_get_baud(const uart_link_posix_t *l);
+
+const link_stats_t *uart_link_posix_stats(const uart_link_posix_t *l);
+
+void uart_link_posix_close(uart_link_posix_t *l);
+
+#endif /* __UART_LINK_POSIX_H__ */
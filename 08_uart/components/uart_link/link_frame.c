@@ -0,0 +1,82 @@
+#include "link_frame.h"
+
+size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_pos = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (in[i] == 0)
+        {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF)
+        {
+            // 254 个非零字节，开始新的一段
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+bool cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t *out_len)
+{
+    size_t i = 0;
+    size_t o = 0;
+    while (i < len)
+    {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len)
+        {
+            return false;
+        }
+        for (uint8_t k = 1; k < code; k++)
+        {
+            if (in[i] == 0)
+            {
+                return false;
+            }
+            out[o++] = in[i++];
+        }
+        // 0xFF 段后面没有隐含的 0，最后一段也没有
+        if (code != 0xFF && i < len)
+        {
+            out[o++] = 0;
+        }
+    }
+    *out_len = o;
+    return true;
+}
+
+uint16_t crc16_ccitt(uint16_t crc, const void *data, size_t len)
+{
+    static uint16_t table[256];
+    static bool table_ready = false;
+    if (!table_ready)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint16_t c = i << 8;
+            for (int k = 0; k < 8; k++)
+            {
+                c = (c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1;
+            }
+            table[i] = c;
+        }
+        table_ready = true;
+    }
+    const uint8_t *p = data;
+    while (len--)
+    {
+        crc = (crc << 8) ^ table[(crc >> 8) ^ *p++];
+    }
+    return crc;
+}
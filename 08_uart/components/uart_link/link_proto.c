@@ -0,0 +1,223 @@
+#include <string.h>
+#include "link_proto.h"
+#include "link_frame.h"
+
+esp_err_t link_init(link_t *link, const link_config_t *config, link_hw_t *hw)
+{
+    if (!link || !config || !hw || config->window == 0 || config->window > LINK_MAX_WINDOW)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(link, 0, sizeof(*link));
+    link->config = *config;
+    link->hw = hw;
+    return ESP_OK;
+}
+
+uint8_t link_tx_pending(const link_t *link)
+{
+    return (uint8_t)(link->tx_next - link->tx_base);
+}
+
+static esp_err_t link_write_frame(link_t *link, uint8_t type, uint8_t seq, const uint8_t *data, size_t len)
+{
+    uint8_t *raw = link->tx_raw;
+    raw[0] = type | (link->rx_synced ? LINK_FRAME_ACK_VALID : 0);
+    raw[1] = link->config.session;
+    raw[2] = seq;
+    raw[3] = link->rx_session;
+    raw[4] = link->rx_next;
+    memcpy(raw + LINK_HEADER_SIZE, data, len);
+    len += LINK_HEADER_SIZE;
+    uint16_t crc = crc16_ccitt(0xFFFF, raw, len);
+    raw[len++] = crc & 0xFF;
+    raw[len++] = crc >> 8;
+    size_t n = cobs_encode(raw, len, link->tx_frame);
+    link->tx_frame[n++] = 0;
+    link->ack_pending = false;
+
+    esp_err_t ret = link->hw->write(link->hw, link->tx_frame, n);
+    link->stats.tx_frames++;
+    link->stats.tx_bytes += n;
+    int64_t now = link->hw->now_us(link->hw);
+    link->tx_busy_us = link->tx_busy_us > now ? link->tx_busy_us : now;
+    if (link->config.baud)
+    {
+        // 8N1 每字节 10 位
+        link->tx_busy_us += (int64_t)n * 10 * 1000000 / link->config.baud;
+    }
+    return ret;
+}
+
+static void link_slot_send(link_t *link, link_slot_t *slot)
+{
+    link_write_frame(link, LINK_FRAME_DATA, slot->seq, slot->data, slot->len);
+    slot->deadline_us = link->tx_busy_us + (int64_t)link->config.rto_ms * 1000;
+}
+
+esp_err_t link_send(link_t *link, const void *data, size_t len, bool reliable)
+{
+    if (len > LINK_MAX_PAYLOAD)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!reliable)
+    {
+        return link_write_frame(link, LINK_FRAME_DGRAM, 0, data, len);
+    }
+    if (link_tx_pending(link) >= link->config.window)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    link_slot_t *slot = &link->slots[link->tx_next % LINK_MAX_WINDOW];
+    memcpy(slot->data, data, len);
+    slot->len = len;
+    slot->seq = link->tx_next++;
+    slot->retries = 0;
+    link_slot_send(link, slot);
+    return ESP_OK;
+}
+
+esp_err_t link_send_ctrl(link_t *link, const void *data, size_t len)
+{
+    if (len > LINK_MAX_PAYLOAD)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return link_write_frame(link, LINK_FRAME_CTRL, 0, data, len);
+}
+
+void link_set_baud(link_t *link, uint32_t baud)
+{
+    link->config.baud = baud;
+}
+
+static void link_handle_ack(link_t *link, uint8_t ack)
+{
+    uint8_t acked = ack - link->tx_base;
+    if (acked == 0 || acked > link_tx_pending(link))
+    {
+        return;
+    }
+    link->tx_base = ack;
+}
+
+/**
+ * @description: 对端的数据帧是否按顺序，同时处理对端重启（会话号变化）
+ */
+static bool link_accept(link_t *link, uint8_t session, uint8_t seq)
+{
+    if (!link->rx_synced || session != link->rx_session)
+    {
+        // 本端刚启动时从任何序号开始；对端重启后从 0 开始，0 丢了就等它重发
+        if (link->rx_synced && seq != 0)
+        {
+            return false;
+        }
+        link->stats.resyncs += link->rx_synced;
+        link->rx_synced = true;
+        link->rx_session = session;
+        link->rx_next = seq;
+    }
+    return seq == link->rx_next;
+}
+
+void link_input(link_t *link, const uint8_t *data, size_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+    uint8_t *raw = link->rx_frame;
+    size_t n;
+    if (len > sizeof(link->rx_frame) || !cobs_decode(data, len, raw, &n) ||
+        n < LINK_HEADER_SIZE + LINK_CRC_SIZE || n > LINK_MAX_FRAME)
+    {
+        link->stats.rx_errors++;
+        return;
+    }
+    n -= LINK_CRC_SIZE;
+    uint16_t crc = raw[n] | (raw[n + 1] << 8);
+    if (crc16_ccitt(0xFFFF, raw, n) != crc)
+    {
+        link->stats.rx_errors++;
+        return;
+    }
+    link->stats.rx_frames++;
+    uint8_t type = raw[0] & ~LINK_FRAME_ACK_VALID;
+    uint8_t session = raw[1];
+    uint8_t seq = raw[2];
+    const uint8_t *payload = raw + LINK_HEADER_SIZE;
+    size_t payload_len = n - LINK_HEADER_SIZE;
+    if ((raw[0] & LINK_FRAME_ACK_VALID) && raw[3] == link->config.session)
+    {
+        link_handle_ack(link, raw[4]);
+    }
+
+    switch (type)
+    {
+    case LINK_FRAME_DATA:
+        link->ack_pending = true;
+        if (link_accept(link, session, seq))
+        {
+            link->rx_next++;
+            if (link->config.cb)
+            {
+                link->config.cb(link->config.ctx, payload, payload_len, true);
+            }
+        }
+        else
+        {
+            link->stats.rx_dropped++;
+        }
+        // 回调中发送的帧已经带了确认
+        if (link->ack_pending)
+        {
+            link_write_frame(link, LINK_FRAME_ACK, 0, NULL, 0);
+        }
+        break;
+    case LINK_FRAME_DGRAM:
+        if (link->config.cb)
+        {
+            link->config.cb(link->config.ctx, payload, payload_len, false);
+        }
+        break;
+    case LINK_FRAME_CTRL:
+        if (link->config.ctrl_cb)
+        {
+            link->config.ctrl_cb(link->config.ctrl_ctx, payload, payload_len, false);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int64_t link_poll(link_t *link)
+{
+    uint8_t pending = link_tx_pending(link);
+    if (pending == 0)
+    {
+        return INT64_MAX;
+    }
+    int64_t now = link->hw->now_us(link->hw);
+    link_slot_t *oldest = &link->slots[link->tx_base % LINK_MAX_WINDOW];
+    if (now >= oldest->deadline_us)
+    {
+        if (++oldest->retries > link->config.max_retries)
+        {
+            // 对端没有响应，放弃窗口内的帧；换一个会话号从 0 开始，对端不会一直等放弃的序号
+            link->stats.lost += pending;
+            link->config.session++;
+            link->tx_base = link->tx_next = 0;
+            return INT64_MAX;
+        }
+        // Go-Back-N：对端只接收按顺序的帧，最旧的丢了后面的也都被丢弃
+        for (uint8_t s = link->tx_base; s != link->tx_next; s++)
+        {
+            link_slot_send(link, &link->slots[s % LINK_MAX_WINDOW]);
+            link->stats.retransmits++;
+        }
+    }
+    return oldest->deadline_us > now ? oldest->deadline_us - now : 0;
+}
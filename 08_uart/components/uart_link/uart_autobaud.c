@@ -0,0 +1,30 @@
+#include "uart_autobaud.h"
+#include "baud_neg.h"
+#include "hal/uart_ll.h"
+#include "soc/soc.h"
+
+// 允许的误差：串口本身能容忍约 ±4%，最短脉宽还有一个时钟的量化误差
+#define UART_AUTOBAUD_TOLERANCE_PCT 4
+
+void uart_autobaud_restart(uart_port_t port)
+{
+    uart_dev_t *hw = UART_LL_GET_HW(port);
+    uart_ll_set_autobaud_en(hw, false);
+    uart_ll_set_autobaud_en(hw, true);
+}
+
+void uart_autobaud_stop(uart_port_t port)
+{
+    uart_ll_set_autobaud_en(UART_LL_GET_HW(port), false);
+}
+
+uint32_t uart_autobaud_read(uart_port_t port, uint32_t min_edges)
+{
+    uart_dev_t *hw = UART_LL_GET_HW(port);
+    if (uart_ll_get_rxd_edge_cnt(hw) < min_edges)
+    {
+        return 0;
+    }
+    return baud_from_pulses(APB_CLK_FREQ, uart_ll_get_low_pulse_cnt(hw), uart_ll_get_high_pulse_cnt(hw),
+                            UART_AUTOBAUD_TOLERANCE_PCT);
+}
@@ -0,0 +1,383 @@
+#include <stdlib.h>
+#include "uart_link.h"
+#include "uart_line_rx.h"
+#include "uart_autobaud.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+
+#define UART_LINK_TX_SPACE BIT0
+#define UART_LINK_BAUD_DONE BIT1
+#define UART_LINK_POLL BIT2
+#define UART_LINK_STOP BIT3
+#define UART_LINK_STOPPED BIT4
+
+// 切换波特率前等已写入的数据发完
+#define UART_LINK_DRAIN_TICKS (100 / portTICK_PERIOD_MS)
+// 连续这么多个错误的帧后检测对端的波特率
+#define UART_LINK_AUTOBAUD_FRAMES 3
+#define UART_LINK_AUTOBAUD_EDGES 32
+
+struct uart_link_s
+{
+    link_hw_t parent;
+    link_t link;
+    uart_port_t port;
+    uart_txq_handle_t txq;
+    uart_line_rx_handle_t rx;
+    SemaphoreHandle_t lock;   /*!< 保护 link，递归锁：接收回调中可以发送 */
+    EventGroupHandle_t space; /*!< 窗口有空位，以及链路任务的通知 */
+    esp_timer_handle_t timer; /*!< 到期时通知链路任务 */
+    TaskHandle_t task;        /*!< 链路任务：重发和切换波特率 */
+    baud_hw_t baud_parent;
+    baud_neg_t neg;
+    esp_err_t baud_result;    /*!< 最近一次协商的结果 */
+    bool autobaud;
+    uint8_t bad_frames;       /*!< 连续的错误帧 */
+};
+
+static esp_err_t esp_hw_write(link_hw_t *hw, const uint8_t *data, size_t len)
+{
+    struct uart_link_s *l = __containerof(hw, struct uart_link_s, parent);
+    if (l->txq)
+    {
+        // 队列满时丢弃这一帧，可靠的数据会重发
+        return uart_txq_write(l->txq, data, len);
+    }
+    return uart_write_bytes(l->port, data, len) == (int)len ? ESP_OK : ESP_FAIL;
+}
+
+static int64_t esp_hw_now_us(link_hw_t *hw)
+{
+    return esp_timer_get_time();
+}
+
+static esp_err_t esp_baud_send(baud_hw_t *hw, const uint8_t *data, size_t len)
+{
+    struct uart_link_s *l = __containerof(hw, struct uart_link_s, baud_parent);
+    return link_send_ctrl(&l->link, data, len);
+}
+
+static esp_err_t esp_baud_set(baud_hw_t *hw, uint32_t baud)
+{
+    struct uart_link_s *l = __containerof(hw, struct uart_link_s, baud_parent);
+    // 已写入的帧（如 ACK）用原来的波特率发完
+    if (l->txq)
+    {
+        uart_txq_wait_empty(l->txq, UART_LINK_DRAIN_TICKS);
+    }
+    uart_wait_tx_done(l->port, UART_LINK_DRAIN_TICKS);
+    esp_err_t ret = uart_set_baudrate(l->port, baud);
+    link_set_baud(&l->link, baud);
+    if (l->autobaud)
+    {
+        uart_autobaud_restart(l->port);
+    }
+    return ret;
+}
+
+static int64_t esp_baud_now_us(baud_hw_t *hw)
+{
+    return esp_timer_get_time();
+}
+
+static void uart_link_baud_done(void *ctx, uint32_t baud, esp_err_t result)
+{
+    struct uart_link_s *l = (struct uart_link_s *)ctx;
+    l->baud_result = result;
+    xEventGroupSetBits(l->space, UART_LINK_BAUD_DONE);
+}
+
+static void uart_link_on_ctrl(void *ctx, const uint8_t *data, size_t len, bool reliable)
+{
+    struct uart_link_s *l = (struct uart_link_s *)ctx;
+    baud_neg_input(&l->neg, data, len);
+}
+
+/**
+ * @description: 连续收到错误的帧时看对端是不是换了波特率，调用时持有锁
+ * @param {bool} good 刚收到的是正确的帧
+ */
+static void uart_link_autobaud(struct uart_link_s *l, bool good)
+{
+    if (good)
+    {
+        // 只测量最后一个正确的帧之后的数据
+        l->bad_frames = 0;
+        uart_autobaud_restart(l->port);
+        return;
+    }
+    if (++l->bad_frames < UART_LINK_AUTOBAUD_FRAMES)
+    {
+        return;
+    }
+    l->bad_frames = 0;
+    uint32_t baud = uart_autobaud_read(l->port, UART_LINK_AUTOBAUD_EDGES);
+    if (baud && baud != l->neg.baud)
+    {
+        baud_neg_follow(&l->neg, baud);
+    }
+    uart_autobaud_restart(l->port);
+}
+
+/**
+ * @description: 重发和安排下一次检查，调用时持有锁
+ */
+static void uart_link_poll(struct uart_link_s *l)
+{
+    uint32_t lost = l->link.stats.lost;
+    int64_t next = link_poll(&l->link);
+    if (l->link.stats.lost != lost)
+    {
+        // 对端没有响应：可能两端的波特率不一致，回到启动时的波特率
+        baud_neg_link_lost(&l->neg);
+    }
+    int64_t neg_next = baud_neg_poll(&l->neg);
+    next = neg_next < next ? neg_next : next;
+    esp_timer_stop(l->timer);
+    if (next != INT64_MAX)
+    {
+        esp_timer_start_once(l->timer, next > 100 ? next : 100);
+    }
+    if (link_tx_pending(&l->link) < l->link.config.window)
+    {
+        xEventGroupSetBits(l->space, UART_LINK_TX_SPACE);
+    }
+}
+
+/**
+ * @description: 切换波特率要等发送完，不能阻塞 esp_timer 的任务，只通知链路任务
+ */
+static void uart_link_timer_cb(void *arg)
+{
+    struct uart_link_s *l = (struct uart_link_s *)arg;
+    xEventGroupSetBits(l->space, UART_LINK_POLL);
+}
+
+static void uart_link_task(void *arg)
+{
+    struct uart_link_s *l = (struct uart_link_s *)arg;
+    while (1)
+    {
+        EventBits_t bits =
+            xEventGroupWaitBits(l->space, UART_LINK_POLL | UART_LINK_STOP, pdTRUE, pdFALSE, portMAX_DELAY);
+        if (bits & UART_LINK_STOP)
+        {
+            break;
+        }
+        xSemaphoreTakeRecursive(l->lock, portMAX_DELAY);
+        uart_link_poll(l);
+        xSemaphoreGiveRecursive(l->lock);
+    }
+    xEventGroupSetBits(l->space, UART_LINK_STOPPED);
+    vTaskDelete(NULL);
+}
+
+static void uart_link_on_frame(void *ctx, const uint8_t *frame, size_t len)
+{
+    struct uart_link_s *l = (struct uart_link_s *)ctx;
+    xSemaphoreTakeRecursive(l->lock, portMAX_DELAY);
+    uint32_t frames = l->link.stats.rx_frames;
+    link_input(&l->link, frame, len);
+    if (l->autobaud)
+    {
+        uart_link_autobaud(l, l->link.stats.rx_frames != frames);
+    }
+    uart_link_poll(l);
+    xSemaphoreGiveRecursive(l->lock);
+}
+
+static void uart_link_free(struct uart_link_s *l)
+{
+    if (l->autobaud)
+    {
+        uart_autobaud_stop(l->port);
+    }
+    if (l->task)
+    {
+        xEventGroupSetBits(l->space, UART_LINK_STOP);
+        xEventGroupWaitBits(l->space, UART_LINK_STOPPED, pdTRUE, pdTRUE, portMAX_DELAY);
+    }
+    if (l->timer)
+    {
+        esp_timer_stop(l->timer);
+        esp_timer_delete(l->timer);
+    }
+    if (l->lock)
+    {
+        vSemaphoreDelete(l->lock);
+    }
+    if (l->space)
+    {
+        vEventGroupDelete(l->space);
+    }
+    free(l);
+}
+
+esp_err_t uart_link_start(const uart_link_config_t *config, uart_link_handle_t *out)
+{
+    if (!config || !out)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct uart_link_s *l = calloc(1, sizeof(struct uart_link_s));
+    if (!l)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    l->port = config->port;
+    l->txq = config->txq;
+    l->parent.write = esp_hw_write;
+    l->parent.now_us = esp_hw_now_us;
+    link_config_t link_config = LINK_DEFAULT_CONFIG(esp_random() & 0xFF, config->cb, config->ctx);
+    link_config.window = config->window;
+    link_config.rto_ms = config->rto_ms;
+    link_config.max_retries = config->max_retries;
+    link_config.ctrl_cb = uart_link_on_ctrl;
+    link_config.ctrl_ctx = l;
+    uart_get_baudrate(config->port, &link_config.baud);
+    // 从分频系数算出的波特率与设置的值可能差一点，协商用标准的波特率
+    uint32_t base = baud_nearest_standard(link_config.baud, 2);
+    l->baud_parent.send = esp_baud_send;
+    l->baud_parent.set_baud = esp_baud_set;
+    l->baud_parent.now_us = esp_baud_now_us;
+    baud_neg_config_t neg_config = BAUD_NEG_DEFAULT_CONFIG(base ? base : link_config.baud, config->max_baud);
+    neg_config.cb = uart_link_baud_done;
+    neg_config.ctx = l;
+    esp_err_t ret = link_init(&l->link, &link_config, &l->parent);
+    if (ret == ESP_OK)
+    {
+        ret = baud_neg_init(&l->neg, &neg_config, &l->baud_parent);
+    }
+    if (ret != ESP_OK)
+    {
+        free(l);
+        return ret;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = uart_link_timer_cb,
+        .arg = l,
+        .name = "uart_link",
+    };
+    l->lock = xSemaphoreCreateRecursiveMutex();
+    l->space = xEventGroupCreate();
+    ret = l->lock && l->space ? esp_timer_create(&timer_args, &l->timer) : ESP_ERR_NO_MEM;
+    if (ret == ESP_OK && xTaskCreate(uart_link_task, "uart_link", config->task_stack, l, config->task_priority,
+                                     &l->task) != pdPASS)
+    {
+        ret = ESP_ERR_NO_MEM;
+    }
+    if (ret == ESP_OK)
+    {
+        // 帧以 0 结束，COBS 编码后帧内没有 0
+        uart_line_rx_config_t rx_config = UART_LINE_RX_DEFAULT_CONFIG(config->port, uart_link_on_frame, l);
+        rx_config.buf_size = 4 * LINK_MAX_ENCODED;
+        rx_config.max_line = LINK_MAX_ENCODED;
+        rx_config.term = 0;
+        rx_config.strip_cr = false;
+        rx_config.driver_rx_size = config->driver_rx_size;
+        rx_config.driver_tx_size = config->driver_tx_size;
+        rx_config.task_priority = config->task_priority;
+        rx_config.task_stack = config->task_stack;
+        ret = uart_line_rx_start(&rx_config, &l->rx);
+    }
+    if (ret != ESP_OK)
+    {
+        uart_link_free(l);
+        return ret;
+    }
+    xEventGroupSetBits(l->space, UART_LINK_TX_SPACE);
+    l->autobaud = config->autobaud;
+    if (l->autobaud)
+    {
+        uart_autobaud_restart(l->port);
+    }
+    *out = l;
+    return ESP_OK;
+}
+
+esp_err_t uart_link_send(uart_link_handle_t l, const void *data, size_t len, bool reliable, TickType_t wait)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (1)
+    {
+        xSemaphoreTakeRecursive(l->lock, portMAX_DELAY);
+        esp_err_t ret = link_send(&l->link, data, len, reliable);
+        if (ret == ESP_ERR_NO_MEM)
+        {
+            xEventGroupClearBits(l->space, UART_LINK_TX_SPACE);
+        }
+        else if (reliable && ret == ESP_OK)
+        {
+            uart_link_poll(l);
+        }
+        xSemaphoreGiveRecursive(l->lock);
+        if (ret != ESP_ERR_NO_MEM)
+        {
+            return ret;
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= wait ||
+            !(xEventGroupWaitBits(l->space, UART_LINK_TX_SPACE, pdFALSE, pdTRUE, wait - elapsed) & UART_LINK_TX_SPACE))
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+}
+
+void uart_link_get_stats(uart_link_handle_t l, link_stats_t *stats)
+{
+    xSemaphoreTakeRecursive(l->lock, portMAX_DELAY);
+    *stats = l->link.stats;
+    xSemaphoreGiveRecursive(l->lock);
+}
+
+esp_err_t uart_link_set_baud(uart_link_handle_t l, uint32_t baud)
+{
+    xSemaphoreTakeRecursive(l->lock, portMAX_DELAY);
+    xEventGroupClearBits(l->space, UART_LINK_BAUD_DONE);
+    esp_err_t ret = baud_neg_start(&l->neg, baud);
+    if (ret == ESP_OK)
+    {
+        uart_link_poll(l);
+    }
+    xSemaphoreGiveRecursive(l->lock);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+    // 协商总会结束：REQ 重发完或验证超时
+    xEventGroupWaitBits(l->space, UART_LINK_BAUD_DONE, pdTRUE, pdTRUE, portMAX_DELAY);
+    xSemaphoreTakeRecursive(l->lock, portMAX_DELAY);
+    ret = l->baud_result;
+    xSemaphoreGiveRecursive(l->lock);
+    return ret;
+}
+
+uint32_t uart_link_get_baud(uart_link_handle_t l)
+{
+    xSemaphoreTakeRecursive(l->lock, portMAX_DELAY);
+    uint32_t baud = l->neg.baud;
+    xSemaphoreGiveRecursive(l->lock);
+    return baud;
+}
+
+void uart_link_get_baud_stats(uart_link_handle_t l, baud_neg_stats_t *stats)
+{
+    xSemaphoreTakeRecursive(l->lock, portMAX_DELAY);
+    *stats = l->neg.stats;
+    xSemaphoreGiveRecursive(l->lock);
+}
+
+void uart_link_stop(uart_link_handle_t l)
+{
+    if (!l)
+    {
+        return;
+    }
+    uart_line_rx_stop(l->rx);
+    uart_link_free(l);
+}
@@ -0,0 +1,339 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "uart_link_posix.h"
+#include "line_rx.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+struct uart_link_posix_s
+{
+    link_hw_t parent;
+    link_t link;
+    int fd;
+    int error;   /*!< 读写出错的 errno */
+    line_rx_t rx;
+    uint8_t buf[4 * LINK_MAX_ENCODED];
+    baud_hw_t baud_parent;
+    baud_neg_t neg;
+    bool baud_done;        /*!< 协商结束 */
+    esp_err_t baud_result;
+};
+
+static const struct
+{
+    uint32_t baud;
+    speed_t speed;
+} s_speeds[] = {
+    {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600}, {115200, B115200}, {230400, B230400},
+    {460800, B460800}, {500000, B500000}, {921600, B921600}, {1000000, B1000000}, {1500000, B1500000},
+    {2000000, B2000000}, {3000000, B3000000}, {4000000, B4000000},
+};
+
+static int64_t posix_now_us(link_hw_t *hw)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static esp_err_t posix_write(link_hw_t *hw, const uint8_t *data, size_t len)
+{
+    uart_link_posix_t *l = __containerof(hw, uart_link_posix_t, parent);
+    while (len > 0)
+    {
+        ssize_t n = write(l->fd, data, len);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR))
+        {
+            struct pollfd pfd = {.fd = l->fd, .events = POLLOUT};
+            poll(&pfd, 1, 100);
+            continue;
+        }
+        if (n < 0)
+        {
+            l->error = errno;
+            return ESP_FAIL;
+        }
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static speed_t posix_speed(uint32_t baud)
+{
+    for (size_t i = 0; i < sizeof(s_speeds) / sizeof(s_speeds[0]); i++)
+    {
+        if (s_speeds[i].baud == baud)
+        {
+            return s_speeds[i].speed;
+        }
+    }
+    return 0;
+}
+
+static esp_err_t posix_baud_send(baud_hw_t *hw, const uint8_t *data, size_t len)
+{
+    uart_link_posix_t *l = __containerof(hw, uart_link_posix_t, baud_parent);
+    return link_send_ctrl(&l->link, data, len);
+}
+
+static esp_err_t posix_baud_set(baud_hw_t *hw, uint32_t baud)
+{
+    uart_link_posix_t *l = __containerof(hw, uart_link_posix_t, baud_parent);
+    struct termios tio;
+    speed_t speed = posix_speed(baud);
+    // 已写入的帧用原来的波特率发完
+    tcdrain(l->fd);
+    if (!speed || tcgetattr(l->fd, &tio) != 0)
+    {
+        return ESP_FAIL;
+    }
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    link_set_baud(&l->link, baud);
+    return tcsetattr(l->fd, TCSANOW, &tio) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static int64_t posix_baud_now_us(baud_hw_t *hw)
+{
+    return posix_now_us(NULL);
+}
+
+static void posix_baud_done(void *ctx, uint32_t baud, esp_err_t result)
+{
+    uart_link_posix_t *l = ctx;
+    l->baud_done = true;
+    l->baud_result = result;
+}
+
+static void posix_on_ctrl(void *ctx, const uint8_t *data, size_t len, bool reliable)
+{
+    uart_link_posix_t *l = ctx;
+    baud_neg_input(&l->neg, data, len);
+}
+
+uart_link_posix_t *uart_link_posix_attach(int fd, const link_config_t *config)
+{
+    uart_link_posix_t *l = calloc(1, sizeof(uart_link_posix_t));
+    if (!l)
+    {
+        return NULL;
+    }
+    l->fd = fd;
+    l->parent.write = posix_write;
+    l->parent.now_us = posix_now_us;
+    line_rx_config_t rx_config = LINE_RX_DEFAULT_CONFIG(l->buf, sizeof(l->buf));
+    rx_config.max_line = LINK_MAX_ENCODED;
+    rx_config.term = 0;
+    rx_config.strip_cr = false;
+    link_config_t link_config = *config;
+    link_config.ctrl_cb = posix_on_ctrl;
+    link_config.ctrl_ctx = l;
+    l->baud_parent.send = posix_baud_send;
+    l->baud_parent.set_baud = posix_baud_set;
+    l->baud_parent.now_us = posix_baud_now_us;
+    // 不知道波特率（如 pty）时按 115200，只影响失去联系后回到的波特率
+    uint32_t base = baud_nearest_standard(config->baud, 2);
+    baud_neg_config_t neg_config = BAUD_NEG_DEFAULT_CONFIG(base ? base : 115200, 0);
+    neg_config.cb = posix_baud_done;
+    neg_config.ctx = l;
+    if (link_init(&l->link, &link_config, &l->parent) != ESP_OK || !line_rx_init(&l->rx, &rx_config) ||
+        baud_neg_init(&l->neg, &neg_config, &l->baud_parent) != ESP_OK)
+    {
+        free(l);
+        return NULL;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return l;
+}
+
+int uart_link_posix_open(const char *path, uint32_t baud, const link_config_t *config, uart_link_posix_t **out)
+{
+    speed_t speed = posix_speed(baud);
+    if (!speed)
+    {
+        return -EINVAL;
+    }
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0)
+    {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd, TCSANOW, &tio) != 0)
+    {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    tcflush(fd, TCIOFLUSH);
+
+    link_config_t link_config = *config;
+    link_config.baud = baud;
+    *out = uart_link_posix_attach(fd, &link_config);
+    if (!*out)
+    {
+        close(fd);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+/**
+ * @description: 重发和协商的定时操作
+ * @return       到下一次需要调用的微秒数
+ */
+static int64_t posix_timers(uart_link_posix_t *l)
+{
+    uint32_t lost = l->link.stats.lost;
+    int64_t next_us = link_poll(&l->link);
+    if (l->link.stats.lost != lost)
+    {
+        // 对端没有响应：可能两端的波特率不一致
+        baud_neg_link_lost(&l->neg);
+    }
+    int64_t neg_us = baud_neg_poll(&l->neg);
+    return neg_us < next_us ? neg_us : next_us;
+}
+
+int uart_link_posix_poll(uart_link_posix_t *l, int timeout_ms)
+{
+    int64_t next_us = posix_timers(l);
+    if (next_us != INT64_MAX && next_us / 1000 < timeout_ms)
+    {
+        timeout_ms = (int)((next_us + 999) / 1000);
+    }
+    struct pollfd pfd = {.fd = l->fd, .events = POLLIN};
+    int ret = poll(&pfd, 1, timeout_ms);
+    if (ret < 0)
+    {
+        return errno == EINTR ? 0 : -errno;
+    }
+    int frames = 0;
+    while (ret > 0)
+    {
+        size_t room;
+        uint8_t *dst = line_rx_reserve(&l->rx, &room);
+        if (!dst)
+        {
+            line_rx_reset(&l->rx);
+            continue;
+        }
+        ssize_t n = read(l->fd, dst, room);
+        if (n <= 0)
+        {
+            if (n < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                return -errno;
+            }
+            break;
+        }
+        line_rx_commit(&l->rx, n);
+        line_rx_view_t view;
+        while (line_rx_next(&l->rx, &view))
+        {
+            link_input(&l->link, view.data, view.len);
+            line_rx_release(&l->rx, &view);
+            frames++;
+        }
+    }
+    posix_timers(l);
+    return l->error ? -l->error : frames;
+}
+
+esp_err_t uart_link_posix_send(uart_link_posix_t *l, const void *data, size_t len, bool reliable, int timeout_ms)
+{
+    int64_t deadline = posix_now_us(NULL) + (int64_t)timeout_ms * 1000;
+    esp_err_t ret;
+    while ((ret = link_send(&l->link, data, len, reliable)) == ESP_ERR_NO_MEM)
+    {
+        int64_t left = deadline - posix_now_us(NULL);
+        if (left <= 0)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (uart_link_posix_poll(l, (int)(left / 1000) + 1) < 0)
+        {
+            return ESP_FAIL;
+        }
+    }
+    return ret;
+}
+
+esp_err_t uart_link_posix_flush(uart_link_posix_t *l, int timeout_ms)
+{
+    int64_t deadline = posix_now_us(NULL) + (int64_t)timeout_ms * 1000;
+    while (link_tx_pending(&l->link))
+    {
+        int64_t left = deadline - posix_now_us(NULL);
+        if (left <= 0 || uart_link_posix_poll(l, (int)(left / 1000) + 1) < 0)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+void uart_link_posix_accept_baud(uart_link_posix_t *l, uint32_t max_baud)
+{
+    l->neg.config.max_baud = max_baud;
+}
+
+esp_err_t uart_link_posix_set_baud(uart_link_posix_t *l, uint32_t baud, int timeout_ms)
+{
+    int64_t deadline = posix_now_us(NULL) + (int64_t)timeout_ms * 1000;
+    l->baud_done = false;
+    esp_err_t ret = baud_neg_start(&l->neg, baud);
+    while (ret == ESP_OK && !l->baud_done)
+    {
+        int64_t left = deadline - posix_now_us(NULL);
+        if (left <= 0)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (uart_link_posix_poll(l, (int)(left / 1000) + 1) < 0)
+        {
+            return ESP_FAIL;
+        }
+    }
+    return ret == ESP_OK ? l->baud_result : ret;
+}
+
+uint32_t uart_link_posix_get_baud(const uart_link_posix_t *l)
+{
+    return l->neg.baud;
+}
+
+const link_stats_t *uart_link_posix_stats(const uart_link_posix_t *l)
+{
+    return &l->link.stats;
+}
+
+void uart_link_posix_close(uart_link_posix_t *l)
+{
+    if (l)
+    {
+        close(l->fd);
+        free(l);
+    }
+}
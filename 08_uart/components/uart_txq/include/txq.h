@@ -0,0 +1,118 @@
+#ifndef __TXQ_H__
+#define __TXQ_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * 发送队列，与 ESP-IDF 无关，可以在PC上测试。
+ *
+ * 生产者用 txq_writev() 把几段数据（如帧头、数据、校验）作为一条消息放进环形缓冲区，
+ * 要么整条放入要么返回 ESP_ERR_NO_MEM，从不等待。消费者（串口的发送任务）用 txq_peek() 取连续的一段，
+ * 交给串口后 txq_consume()，整条消息交出后调用它的完成回调。
+ * 缓冲区中的数据达到 high 时通知生产者暂停，降到 low 时通知继续。
+ * 函数不可重入，由调用者加锁；txq_peek() 给出的数据在 txq_consume() 之前不会被生产者改动，读它时可以不持锁。
+ */
+
+#define TXQ_MAX_PENDING 32 /*!< 等待完成回调的消息数 */
+#define TXQ_MAX_IOV 8
+
+typedef struct
+{
+    const void *base;
+    size_t len;
+} txq_iov_t;
+
+/**
+ * @brief 一条消息已经全部交给串口，在 txq_consume() 中调用
+ */
+typedef void (*txq_done_cb_t)(void *ctx, uint32_t id);
+
+/**
+ * @brief 流量控制：ready 为 false 时缓冲区达到 high，为 true 时降到 low
+ */
+typedef void (*txq_flow_cb_t)(void *ctx, bool ready);
+
+typedef struct
+{
+    uint8_t *buf;
+    size_t size;         /*!< 2 的幂 */
+    size_t high;         /*!< 达到这么多字节时暂停 */
+    size_t low;          /*!< 暂停后降到这么多字节时继续 */
+    txq_flow_cb_t flow;  /*!< 可以为 NULL */
+    void *flow_ctx;
+} txq_config_t;
+
+#define TXQ_DEFAULT_CONFIG(b, s)    \
+    {                               \
+        .buf = b,                   \
+        .size = s,                  \
+        .high = (s) * 3 / 4,        \
+        .low = (s) / 4,             \
+        .flow = NULL,               \
+        .flow_ctx = NULL,           \
+    }
+
+typedef struct
+{
+    uint32_t messages; /*!< 放入的消息 */
+    uint32_t bytes;
+    uint32_t rejected; /*!< 缓冲区满没有放入的消息 */
+    uint32_t pauses;   /*!< 达到 high 的次数 */
+    size_t max_fill;
+} txq_stats_t;
+
+typedef struct
+{
+    uint32_t end;      /*!< 消息结束的位置（累计字节数） */
+    uint32_t id;
+    txq_done_cb_t cb;
+    void *ctx;
+} txq_pending_t;
+
+typedef struct
+{
+    txq_config_t config;
+    uint32_t head;     /*!< 累计写入的字节数 */
+    uint32_t tail;     /*!< 累计交出的字节数 */
+    uint32_t next_id;
+    txq_pending_t pending[TXQ_MAX_PENDING];
+    uint8_t pending_head;
+    uint8_t pending_count;
+    bool paused;
+    txq_stats_t stats;
+} txq_t;
+
+/**
+ * @description: 初始化
+ * @return       false：参数不合理
+ */
+bool txq_init(txq_t *q, const txq_config_t *config);
+
+/**
+ * @description: 放入一条由几段组成的消息，不等待
+ * @return       ESP_OK / ESP_ERR_NO_MEM（空间不够或等待回调的消息太多）/ ESP_ERR_INVALID_SIZE（比缓冲区大）
+ * @param {txq_done_cb_t} cb 完成回调，可以为 NULL
+ * @param {uint32_t} *id 输出，消息的编号（完成回调的参数），可以为 NULL
+ */
+esp_err_t txq_writev(txq_t *q, const txq_iov_t *iov, int iovcnt, txq_done_cb_t cb, void *ctx, uint32_t *id);
+
+/**
+ * @description: 可以交出的连续数据
+ * @return       字节数，0 表示没有数据
+ */
+size_t txq_peek(const txq_t *q, const uint8_t **data);
+
+/**
+ * @description: 已经交出 n 字节，调用完成和流量控制回调
+ */
+void txq_consume(txq_t *q, size_t n);
+
+/**
+ * @description: 缓冲区中的字节数
+ */
+size_t txq_fill(const txq_t *q);
+
+#endif /* __TXQ_H__ */
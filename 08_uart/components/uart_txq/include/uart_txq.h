@@ -0,0 +1,70 @@
+#ifndef __UART_TXQ_H__
+#define __UART_TXQ_H__
+
+#include "txq.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+
+/*
+ * txq 在 ESP32 串口上的驱动：生产者放入消息后立即返回，发送任务把数据交给驱动的发送缓冲区，
+ * 由串口的发送中断按波特率送进 FIFO；只有发送任务会在驱动的缓冲区满时等待。
+ * 完成回调在发送任务中调用，表示数据已经全部进入驱动（之后由中断发出）。
+ */
+
+typedef struct
+{
+    uart_port_t port;      /*!< 驱动已经安装，发送缓冲区不为 0 */
+    size_t buf_size;       /*!< 2 的幂 */
+    size_t high;
+    size_t low;
+    txq_flow_cb_t flow;    /*!< 在调用 uart_txq_writev() 的任务或发送任务中调用 */
+    void *flow_ctx;
+    UBaseType_t task_priority;
+    uint32_t task_stack;
+} uart_txq_config_t;
+
+#define UART_TXQ_DEFAULT_CONFIG(p)  \
+    {                               \
+        .port = p,                  \
+        .buf_size = 4096,           \
+        .high = 3072,               \
+        .low = 1024,                \
+        .flow = NULL,               \
+        .flow_ctx = NULL,           \
+        .task_priority = 10,        \
+        .task_stack = 3072,         \
+    }
+
+typedef struct uart_txq_s *uart_txq_handle_t;
+
+/**
+ * @description: 分配缓冲区，启动发送任务
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG / ESP_ERR_NO_MEM
+ */
+esp_err_t uart_txq_start(const uart_txq_config_t *config, uart_txq_handle_t *out);
+
+/**
+ * @description: 放入一条由几段组成的消息，不等待，可以在任何任务中调用
+ * @return       ESP_OK / ESP_ERR_NO_MEM（缓冲区满）/ ESP_ERR_INVALID_SIZE
+ */
+esp_err_t uart_txq_writev(uart_txq_handle_t txq, const txq_iov_t *iov, int iovcnt, txq_done_cb_t cb, void *ctx);
+
+/**
+ * @description: 放入一段数据
+ */
+esp_err_t uart_txq_write(uart_txq_handle_t txq, const void *data, size_t len);
+
+void uart_txq_get_stats(uart_txq_handle_t txq, txq_stats_t *stats);
+
+/**
+ * @description: 等队列中的数据全部交给驱动（如切换波特率之前），之后还要 uart_wait_tx_done
+ * @return       ESP_OK / ESP_ERR_TIMEOUT
+ */
+esp_err_t uart_txq_wait_empty(uart_txq_handle_t txq, TickType_t wait);
+
+/**
+ * @description: 停止发送任务，缓冲区中的数据丢弃，不删除驱动
+ */
+void uart_txq_stop(uart_txq_handle_t txq);
+
+#endif /* __UART_TXQ_H__ */
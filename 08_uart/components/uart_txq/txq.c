@@ -0,0 +1,107 @@
+#include <string.h>
+#include "txq.h"
+
+bool txq_init(txq_t *q, const txq_config_t *config)
+{
+    // 大小是 2 的幂，累计字节数回绕时取余仍然连续
+    if (!q || !config || !config->buf || config->size == 0 || (config->size & (config->size - 1)) ||
+        config->low > config->high || config->high > config->size)
+    {
+        return false;
+    }
+    memset(q, 0, sizeof(*q));
+    q->config = *config;
+    return true;
+}
+
+size_t txq_fill(const txq_t *q)
+{
+    return q->head - q->tail;
+}
+
+esp_err_t txq_writev(txq_t *q, const txq_iov_t *iov, int iovcnt, txq_done_cb_t cb, void *ctx, uint32_t *id)
+{
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        total += iov[i].len;
+    }
+    if (total > q->config.size)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (total > q->config.size - txq_fill(q) || (cb && q->pending_count == TXQ_MAX_PENDING))
+    {
+        q->stats.rejected++;
+        return ESP_ERR_NO_MEM;
+    }
+    size_t size = q->config.size;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        // 最多分两次复制：到缓冲区末尾，再从开头
+        const uint8_t *src = iov[i].base;
+        size_t len = iov[i].len;
+        size_t pos = q->head % size;
+        size_t first = len < size - pos ? len : size - pos;
+        memcpy(q->config.buf + pos, src, first);
+        memcpy(q->config.buf, src + first, len - first);
+        q->head += len;
+    }
+    uint32_t msg_id = q->next_id++;
+    if (cb)
+    {
+        txq_pending_t *p = &q->pending[(q->pending_head + q->pending_count++) % TXQ_MAX_PENDING];
+        p->end = q->head;
+        p->id = msg_id;
+        p->cb = cb;
+        p->ctx = ctx;
+    }
+    if (id)
+    {
+        *id = msg_id;
+    }
+    q->stats.messages++;
+    q->stats.bytes += total;
+    size_t fill = txq_fill(q);
+    q->stats.max_fill = fill > q->stats.max_fill ? fill : q->stats.max_fill;
+    if (!q->paused && fill >= q->config.high)
+    {
+        q->paused = true;
+        q->stats.pauses++;
+        if (q->config.flow)
+        {
+            q->config.flow(q->config.flow_ctx, false);
+        }
+    }
+    return ESP_OK;
+}
+
+size_t txq_peek(const txq_t *q, const uint8_t **data)
+{
+    size_t fill = txq_fill(q);
+    size_t pos = q->tail % q->config.size;
+    *data = q->config.buf + pos;
+    return fill < q->config.size - pos ? fill : q->config.size - pos;
+}
+
+void txq_consume(txq_t *q, size_t n)
+{
+    n = n < txq_fill(q) ? n : txq_fill(q);
+    q->tail += n;
+    // 累计字节数会回绕，按差值比较
+    while (q->pending_count && (int32_t)(q->tail - q->pending[q->pending_head].end) >= 0)
+    {
+        txq_pending_t p = q->pending[q->pending_head];
+        q->pending_head = (q->pending_head + 1) % TXQ_MAX_PENDING;
+        q->pending_count--;
+        p.cb(p.ctx, p.id);
+    }
+    if (q->paused && txq_fill(q) <= q->config.low)
+    {
+        q->paused = false;
+        if (q->config.flow)
+        {
+            q->config.flow(q->config.flow_ctx, true);
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include "uart_txq.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+struct uart_txq_s
+{
+    txq_t q;
+    uart_port_t port;
+    SemaphoreHandle_t lock;   /*!< 保护 q，递归锁：完成回调中可以再放入 */
+    SemaphoreHandle_t done;   /*!< 发送任务退出后释放 */
+    TaskHandle_t task;
+    volatile bool stop;
+    uint8_t buf[];
+};
+
+static void uart_txq_task(void *arg)
+{
+    struct uart_txq_s *t = (struct uart_txq_s *)arg;
+    while (!t->stop)
+    {
+        xSemaphoreTakeRecursive(t->lock, portMAX_DELAY);
+        const uint8_t *data;
+        size_t n = txq_peek(&t->q, &data);
+        xSemaphoreGiveRecursive(t->lock);
+        if (n == 0)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        // 只有这里会在驱动的缓冲区满时等待；peek 给出的数据在 consume 之前不会变
+        int written = uart_write_bytes(t->port, data, n);
+        xSemaphoreTakeRecursive(t->lock, portMAX_DELAY);
+        txq_consume(&t->q, written > 0 ? written : 0);
+        xSemaphoreGiveRecursive(t->lock);
+    }
+    xSemaphoreGive(t->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t uart_txq_start(const uart_txq_config_t *config, uart_txq_handle_t *out)
+{
+    if (!config || !out)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct uart_txq_s *t = calloc(1, sizeof(struct uart_txq_s) + config->buf_size);
+    if (!t)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    t->port = config->port;
+    txq_config_t q_config = {
+        .buf = t->buf,
+        .size = config->buf_size,
+        .high = config->high,
+        .low = config->low,
+        .flow = config->flow,
+        .flow_ctx = config->flow_ctx,
+    };
+    if (!txq_init(&t->q, &q_config))
+    {
+        free(t);
+        return ESP_ERR_INVALID_ARG;
+    }
+    t->lock = xSemaphoreCreateRecursiveMutex();
+    t->done = xSemaphoreCreateBinary();
+    if (!t->lock || !t->done ||
+        xTaskCreate(uart_txq_task, "uart_txq", config->task_stack, t, config->task_priority, &t->task) != pdPASS)
+    {
+        if (t->lock)
+        {
+            vSemaphoreDelete(t->lock);
+        }
+        if (t->done)
+        {
+            vSemaphoreDelete(t->done);
+        }
+        free(t);
+        return ESP_ERR_NO_MEM;
+    }
+    *out = t;
+    return ESP_OK;
+}
+
+esp_err_t uart_txq_writev(uart_txq_handle_t t, const txq_iov_t *iov, int iovcnt, txq_done_cb_t cb, void *ctx)
+{
+    xSemaphoreTakeRecursive(t->lock, portMAX_DELAY);
+    bool idle = txq_fill(&t->q) == 0;
+    esp_err_t ret = txq_writev(&t->q, iov, iovcnt, cb, ctx, NULL);
+    xSemaphoreGiveRecursive(t->lock);
+    if (ret == ESP_OK && idle)
+    {
+        xTaskNotifyGive(t->task);
+    }
+    return ret;
+}
+
+esp_err_t uart_txq_write(uart_txq_handle_t t, const void *data, size_t len)
+{
+    const txq_iov_t iov = {data, len};
+    return uart_txq_writev(t, &iov, 1, NULL, NULL);
+}
+
+void uart_txq_get_stats(uart_txq_handle_t t, txq_stats_t *stats)
+{
+    xSemaphoreTakeRecursive(t->lock, portMAX_DELAY);
+    *stats = t->q.stats;
+    xSemaphoreGiveRecursive(t->lock);
+}
+
+esp_err_t uart_txq_wait_empty(uart_txq_handle_t t, TickType_t wait)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (1)
+    {
+        xSemaphoreTakeRecursive(t->lock, portMAX_DELAY);
+        size_t fill = txq_fill(&t->q);
+        xSemaphoreGiveRecursive(t->lock);
+        if (fill == 0)
+        {
+            return ESP_OK;
+        }
+        if (xTaskGetTickCount() - start >= wait)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(1);
+    }
+}
+
+void uart_txq_stop(uart_txq_handle_t t)
+{
+    if (!t)
+    {
+        return;
+    }
+    t->stop = true;
+    xTaskNotifyGive(t->task);
+    xSemaphoreTake(t->done, portMAX_DELAY);
+    vSemaphoreDelete(t->lock);
+    vSemaphoreDelete(t->done);
+    free(t);
+}
@@ -17,6 +17,8 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 /**
@@ -31,6 +33,35 @@ typedef struct led_strip_s led_strip_t;
 */
 typedef void *led_strip_dev_t;
 
+/**
+* @brief Called when a frame has been sent out, from the interrupt of the device
+*
+* @param strip: LED strip
+* @param arg: argument given to led_strip_set_done_callback
+*/
+typedef void (*led_strip_done_cb_t)(led_strip_t *strip, void *arg);
+
+/**
+* @brief RGB color of a pixel, for the bulk operations
+*
+*/
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} rgb_t;
+
+/**
+* @brief LED chip, selects the bit timing and the byte order of a strip
+*
+*/
+typedef enum {
+    LED_STRIP_WS2812B = 0, /*!< WS2812B, GRB */
+    LED_STRIP_SK6812_RGBW, /*!< SK6812 RGBW, GRBW */
+    LED_STRIP_WS2811,      /*!< WS2811 in 800 kHz mode, RGB */
+    LED_STRIP_CHIP_MAX,
+} led_strip_chip_t;
+
 /**
 * @brief Declare of LED Strip Type
 *
@@ -52,6 +83,71 @@ struct led_strip_s {
     */
     esp_err_t (*set_pixel)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue);
 
+    /**
+    * @brief Set RGBW for a specific pixel of an RGBW strip
+    *
+    * @param strip: LED strip
+    * @param index: index of pixel to set
+    * @param red: red part of color
+    * @param green: green part of color
+    * @param blue: blue part of color
+    * @param white: white part of color
+    *
+    * @return
+    *      - ESP_OK: Set RGBW for a specific pixel successfully
+    *      - ESP_ERR_INVALID_ARG: Set RGBW for a specific pixel failed because of invalid parameters
+    *      - ESP_ERR_NOT_SUPPORTED: The chip of the strip has no white channel
+    */
+    esp_err_t (*set_pixel_rgbw)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
+
+    /**
+    * @brief Set RGB for a range of pixels
+    *
+    * @param strip: LED strip
+    * @param start: index of the first pixel
+    * @param colors: one color per pixel
+    * @param num: number of pixels
+    *
+    * @return
+    *      - ESP_OK: Set the pixels successfully
+    *      - ESP_ERR_INVALID_ARG: colors is NULL or the range is out of the strip
+    *
+    * @note:
+    *      One call for the whole range, converted to the byte order of the chip in a single loop.
+    *      White (if any) is turned off, as with set_pixel.
+    */
+    esp_err_t (*set_pixels)(led_strip_t *strip, uint32_t start, const rgb_t *colors, uint32_t num);
+
+    /**
+    * @brief Set a range of pixels to one color
+    *
+    * @param strip: LED strip
+    * @param start: index of the first pixel
+    * @param num: number of pixels
+    * @param color: color of the pixels
+    *
+    * @return
+    *      - ESP_OK: Fill successfully
+    *      - ESP_ERR_INVALID_ARG: The range is out of the strip
+    */
+    esp_err_t (*fill)(led_strip_t *strip, uint32_t start, uint32_t num, rgb_t color);
+
+    /**
+    * @brief Get the frame being drawn, to render into it directly
+    *
+    * @param strip: LED strip
+    * @param buffer: back buffer, pixels in the byte order of the chip (see led_strip_chip_t)
+    * @param size: size of the buffer in bytes (number of LEDs times 3, or 4 for RGBW chips)
+    *
+    * @return
+    *      - ESP_OK: Success
+    *      - ESP_ERR_INVALID_ARG: buffer is NULL
+    *
+    * @note:
+    *      present, refresh and clear swap the buffers, get the buffer again after each of them.
+    */
+    esp_err_t (*get_buffer)(led_strip_t *strip, uint8_t **buffer, size_t *size);
+
     /**
     * @brief Refresh memory colors to LEDs
     *
@@ -65,9 +161,38 @@ struct led_strip_s {
     *
     * @note:
     *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+    *      Same as present followed by wait_done.
     */
     esp_err_t (*refresh)(led_strip_t *strip, uint32_t timeout_ms);
 
+    /**
+    * @brief Show the frame drawn so far without waiting for the transmission
+    *
+    * @param strip: LED strip
+    *
+    * @return
+    *      - ESP_OK: Transmission started
+    *      - ESP_FAIL: Transmission failed to start
+    *
+    * @note:
+    *      The strip is double buffered: set_pixel draws into the back buffer, present waits for the previous frame
+    *      (if still being sent), swaps the buffers and starts sending. The back buffer then holds a copy of the frame
+    *      just presented, so drawing can go on while it is sent. The done callback fires when the frame is out.
+    */
+    esp_err_t (*present)(led_strip_t *strip);
+
+    /**
+    * @brief Wait until the frame started by present has been sent
+    *
+    * @param strip: LED strip
+    * @param timeout_ms: timeout value
+    *
+    * @return
+    *      - ESP_OK: Nothing is being sent
+    *      - ESP_ERR_TIMEOUT: Still sending after timeout
+    */
+    esp_err_t (*wait_done)(led_strip_t *strip, uint32_t timeout_ms);
+
     /**
     * @brief Clear LED strip (turn off all LEDs)
     *
@@ -100,6 +225,7 @@ struct led_strip_s {
 typedef struct {
     uint32_t max_leds;   /*!< Maximum LEDs in a single strip */
     led_strip_dev_t dev; /*!< LED strip device (e.g. RMT channel, PWM channel, etc) */
+    led_strip_chip_t chip; /*!< LED chip of the strip */
 } led_strip_config_t;
 
 /**
@@ -110,17 +236,55 @@ typedef struct {
     {                                             \
         .max_leds = number,                       \
         .dev = dev_hdl,                           \
+        .chip = LED_STRIP_WS2812B,                \
     }
 
 /**
 * @brief Install a new ws2812 driver (based on RMT peripheral)
 *
+* @note Timing and buffer belong to the strip, several strips can be driven on different RMT channels
+*       (ESP32-C3 has two TX channels, RMT_CHANNEL_0 and RMT_CHANNEL_1).
+*
 * @param config: LED strip configuration
 * @return
 *      LED strip instance or NULL
 */
 led_strip_t *led_strip_new_rmt_ws2812(const led_strip_config_t *config);
 
+/**
+* @brief Set the callback fired when a frame of the strip has been sent
+*
+* @note The callback runs in the RMT interrupt: keep it short, place it in IRAM, use only FromISR APIs
+*       (e.g. vTaskNotifyGiveFromISR to wake the drawing task).
+*
+* @param strip: LED strip
+* @param cb: callback, NULL to remove
+* @param arg: argument of the callback
+*
+* @return
+*      - ESP_OK: Callback set
+*      - ESP_ERR_INVALID_ARG: Strip is NULL
+*      - ESP_FAIL: Failed to wait for the frame being sent
+*/
+esp_err_t led_strip_set_done_callback(led_strip_t *strip, led_strip_done_cb_t cb, void *arg);
+
+/**
+* @brief Refresh several strips at once
+*
+* @note All transmissions are started before waiting for any, so strips on different channels are sent in parallel.
+*       The strips must be on different RMT channels.
+*
+* @param strips: LED strips
+* @param num: number of strips
+* @param timeout_ms: timeout value for each strip
+*
+* @return
+*      - ESP_OK: Refresh successfully
+*      - ESP_ERR_TIMEOUT: Refresh failed because of timeout
+*      - ESP_FAIL: Refresh failed because some other error occurred
+*/
+esp_err_t led_strip_refresh_all(led_strip_t *const strips[], size_t num, uint32_t timeout_ms);
+
 /**
  * @brief Init the RMT peripheral and LED strip configuration.
  *
@@ -132,6 +296,18 @@ led_strip_t *led_strip_new_rmt_ws2812(const led_strip_config_t *config);
  */
 led_strip_t * led_strip_init(uint8_t channel, uint8_t gpio, uint16_t led_num);
 
+/**
+ * @brief Init the RMT peripheral and an LED strip of the given chip.
+ *
+ * @param[in] channel: RMT peripheral channel number.
+ * @param[in] gpio: GPIO number for the RMT data output.
+ * @param[in] led_num: number of addressable LEDs.
+ * @param[in] chip: LED chip of the strip.
+ * @return
+ *      LED strip instance or NULL
+ */
+led_strip_t * led_strip_init_chip(uint8_t channel, uint8_t gpio, uint16_t led_num, led_strip_chip_t chip);
+
 /**
  * @brief Denit the RMT peripheral.
  *
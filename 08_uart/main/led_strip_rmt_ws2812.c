@@ -16,11 +16,10 @@
 #include <sys/cdefs.h>
 #include "esp_log.h"
 #include "esp_attr.h"
+#include "esp_timer.h"
 #include "led_strip.h"
 #include "driver/rmt.h"
 
-#define RMT_TX_CHANNEL RMT_CHANNEL_0
-
 static const char *TAG = "ws2812";
 #define STRIP_CHECK(a, str, goto_tag, ret_value, ...)                             \
     do                                                                            \
@@ -33,28 +32,78 @@ static const char *TAG = "ws2812";
         }                                                                         \
     } while (0)
 
-#define WS2812_T0H_NS (350)
-#define WS2812_T0L_NS (1000)
-#define WS2812_T1H_NS (1000)
-#define WS2812_T1L_NS (350)
-#define WS2812_RESET_US (280)
+/**
+ * @brief Timing and byte layout of an LED chip
+ *
+ */
+typedef struct {
+    uint16_t t0h_ns;         /*!< High time of a logical 0 */
+    uint16_t t0l_ns;         /*!< Low time of a logical 0 */
+    uint16_t t1h_ns;         /*!< High time of a logical 1 */
+    uint16_t t1l_ns;         /*!< Low time of a logical 1 */
+    uint16_t reset_us;       /*!< Low time after a frame before the LEDs latch it */
+    uint8_t bytes_per_pixel; /*!< 3 for RGB chips, 4 for RGBW chips */
+    uint8_t order[4];        /*!< Byte offset of R, G, B, W within a pixel */
+} ws2812_profile_t;
 
-static uint32_t ws2812_t0h_ticks = 0;
-static uint32_t ws2812_t1h_ticks = 0;
-static uint32_t ws2812_t0l_ticks = 0;
-static uint32_t ws2812_t1l_ticks = 0;
+static const ws2812_profile_t ws2812_profiles[LED_STRIP_CHIP_MAX] = {
+    // GRB
+    [LED_STRIP_WS2812B] = { 350, 1000, 1000, 350, 280, 3, { 1, 0, 2, 0 } },
+    // GRBW
+    [LED_STRIP_SK6812_RGBW] = { 300, 900, 600, 600, 80, 4, { 1, 0, 2, 3 } },
+    // RGB, 800 kHz (high speed) mode
+    [LED_STRIP_WS2811] = { 250, 1000, 600, 650, 280, 3, { 0, 1, 2, 0 } },
+};
 
 typedef struct {
     led_strip_t parent;
     rmt_channel_t rmt_channel;
+    const ws2812_profile_t *profile;
     uint32_t strip_len;
-    uint8_t buffer[0];
+    uint32_t frame_size;               // Bytes of one frame
+    uint8_t *front;                    // Frame being transmitted, read by the RMT refill interrupt
+    uint8_t *back;                     // Frame being drawn by set_pixel
+    volatile int64_t last_done_us;     // End of the last transmission (set in the tx end interrupt), the reset time counts from here
+    led_strip_done_cb_t done_cb;
+    void *done_arg;
+    rmt_item32_t nibble_items[16][4];  // RMT items of every nibble value (MSB first) with the timing of this strip
+    uint8_t buffer[0];                 // Two frames
 } ws2812_t;
 
+// Strip of each RMT channel, for the tx end callback which is shared by all channels
+static ws2812_t *ws2812_channels[RMT_CHANNEL_MAX];
+static bool ws2812_tx_end_registered = false;
+static rmt_tx_end_callback_t ws2812_prev_tx_end;
+
+// ns -> ticks, rounded to the nearest tick
+static uint32_t ws2812_ns_to_ticks(uint32_t counter_clk_hz, uint32_t ns)
+{
+    return (uint32_t)(((uint64_t)counter_clk_hz * ns + 500000000) / 1000000000);
+}
+
+static void ws2812_build_nibble_items(ws2812_t *ws2812, uint32_t counter_clk_hz)
+{
+    const ws2812_profile_t *profile = ws2812->profile;
+    rmt_item32_t bit0 = {{{ 0, 1, 0, 0 }}}; //Logical 0
+    rmt_item32_t bit1 = {{{ 0, 1, 0, 0 }}}; //Logical 1
+    bit0.duration0 = ws2812_ns_to_ticks(counter_clk_hz, profile->t0h_ns);
+    bit0.duration1 = ws2812_ns_to_ticks(counter_clk_hz, profile->t0l_ns);
+    bit1.duration0 = ws2812_ns_to_ticks(counter_clk_hz, profile->t1h_ns);
+    bit1.duration1 = ws2812_ns_to_ticks(counter_clk_hz, profile->t1l_ns);
+    for (int nibble = 0; nibble < 16; nibble++) {
+        for (int i = 0; i < 4; i++) {
+            ws2812->nibble_items[nibble][i] = (nibble & (8 >> i)) ? bit1 : bit0;
+        }
+    }
+}
+
 /**
  * @brief Conver RGB data to RMT format.
  *
  * @note For WS2812, R,G,B each contains 256 different choices (i.e. uint8_t)
+ * @note Each byte is expanded with two lookups in the nibble table of the strip, without a branch per bit,
+ *       to keep the refill interrupt short on long strips. The strip is the translator context of the channel,
+ *       so every channel keeps its own timing.
  *
  * @param[in] src: source data, to converted to RMT format
  * @param[in] dest: place where to store the convert result
@@ -66,28 +115,30 @@ typedef struct {
 static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    if (src == NULL || dest == NULL) {
+    ws2812_t *ws2812 = NULL;
+    if (src == NULL || dest == NULL || rmt_translator_get_context(item_num, (void **)&ws2812) != ESP_OK || ws2812 == NULL) {
         *translated_size = 0;
         *item_num = 0;
         return;
     }
-    const rmt_item32_t bit0 = {{{ ws2812_t0h_ticks, 1, ws2812_t0l_ticks, 0 }}}; //Logical 0
-    const rmt_item32_t bit1 = {{{ ws2812_t1h_ticks, 1, ws2812_t1l_ticks, 0 }}}; //Logical 1
     size_t size = 0;
     size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
+    const uint8_t *psrc = (const uint8_t *)src;
     rmt_item32_t *pdest = dest;
     while (size < src_size && num < wanted_num) {
-        for (int i = 0; i < 8; i++) {
-            // MSB first
-            if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bit1.val;
-            } else {
-                pdest->val =  bit0.val;
-            }
-            num++;
-            pdest++;
-        }
+        // MSB first: high nibble, then low nibble
+        const rmt_item32_t *hi = ws2812->nibble_items[*psrc >> 4];
+        const rmt_item32_t *lo = ws2812->nibble_items[*psrc & 0x0F];
+        pdest[0].val = hi[0].val;
+        pdest[1].val = hi[1].val;
+        pdest[2].val = hi[2].val;
+        pdest[3].val = hi[3].val;
+        pdest[4].val = lo[0].val;
+        pdest[5].val = lo[1].val;
+        pdest[6].val = lo[2].val;
+        pdest[7].val = lo[3].val;
+        num += 8;
+        pdest += 8;
         size++;
         psrc++;
     }
@@ -100,38 +151,196 @@ static esp_err_t ws2812_set_pixel(led_strip_t *strip, uint32_t index, uint32_t r
     esp_err_t ret = ESP_OK;
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
     STRIP_CHECK(index < ws2812->strip_len, "index out of the maximum number of leds", err, ESP_ERR_INVALID_ARG);
-    uint32_t start = index * 3;
-    // In thr order of GRB
-    ws2812->buffer[start + 0] = green & 0xFF;
-    ws2812->buffer[start + 1] = red & 0xFF;
-    ws2812->buffer[start + 2] = blue & 0xFF;
+    const ws2812_profile_t *profile = ws2812->profile;
+    // In the byte order of the chip, white (if any) off
+    uint8_t *pixel = ws2812->back + index * profile->bytes_per_pixel;
+    pixel[profile->order[0]] = red & 0xFF;
+    pixel[profile->order[1]] = green & 0xFF;
+    pixel[profile->order[2]] = blue & 0xFF;
+    if (profile->bytes_per_pixel == 4) {
+        pixel[profile->order[3]] = 0;
+    }
     return ESP_OK;
 err:
     return ret;
 }
 
-static esp_err_t ws2812_refresh(led_strip_t *strip, uint32_t timeout_ms)
+static esp_err_t ws2812_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    esp_err_t ret = ESP_OK;
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    const ws2812_profile_t *profile = ws2812->profile;
+    STRIP_CHECK(profile->bytes_per_pixel == 4, "chip has no white channel", err, ESP_ERR_NOT_SUPPORTED);
+    STRIP_CHECK(index < ws2812->strip_len, "index out of the maximum number of leds", err, ESP_ERR_INVALID_ARG);
+    uint8_t *pixel = ws2812->back + index * 4;
+    pixel[profile->order[0]] = red & 0xFF;
+    pixel[profile->order[1]] = green & 0xFF;
+    pixel[profile->order[2]] = blue & 0xFF;
+    pixel[profile->order[3]] = white & 0xFF;
+    return ESP_OK;
+err:
+    return ret;
+}
+
+static esp_err_t ws2812_set_pixels(led_strip_t *strip, uint32_t start, const rgb_t *colors, uint32_t num)
 {
     esp_err_t ret = ESP_OK;
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
-    STRIP_CHECK(rmt_write_sample(ws2812->rmt_channel, ws2812->buffer, ws2812->strip_len * 3, true) == ESP_OK,
+    STRIP_CHECK(colors, "colors can't be null", err, ESP_ERR_INVALID_ARG);
+    STRIP_CHECK(start <= ws2812->strip_len && num <= ws2812->strip_len - start,
+                "range out of the maximum number of leds", err, ESP_ERR_INVALID_ARG);
+    const ws2812_profile_t *profile = ws2812->profile;
+    const uint8_t r = profile->order[0];
+    const uint8_t g = profile->order[1];
+    const uint8_t b = profile->order[2];
+    uint8_t *pixel = ws2812->back + start * profile->bytes_per_pixel;
+    if (profile->bytes_per_pixel == 3) {
+        for (uint32_t i = 0; i < num; i++, pixel += 3) {
+            pixel[r] = colors[i].r;
+            pixel[g] = colors[i].g;
+            pixel[b] = colors[i].b;
+        }
+    } else {
+        const uint8_t w = profile->order[3];
+        for (uint32_t i = 0; i < num; i++, pixel += 4) {
+            pixel[r] = colors[i].r;
+            pixel[g] = colors[i].g;
+            pixel[b] = colors[i].b;
+            pixel[w] = 0;
+        }
+    }
+    return ESP_OK;
+err:
+    return ret;
+}
+
+static esp_err_t ws2812_fill(led_strip_t *strip, uint32_t start, uint32_t num, rgb_t color)
+{
+    esp_err_t ret = ESP_OK;
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    STRIP_CHECK(start <= ws2812->strip_len && num <= ws2812->strip_len - start,
+                "range out of the maximum number of leds", err, ESP_ERR_INVALID_ARG);
+    if (num == 0) {
+        return ESP_OK;
+    }
+    const ws2812_profile_t *profile = ws2812->profile;
+    uint32_t bpp = profile->bytes_per_pixel;
+    uint8_t *first = ws2812->back + start * bpp;
+    first[profile->order[0]] = color.r;
+    first[profile->order[1]] = color.g;
+    first[profile->order[2]] = color.b;
+    if (bpp == 4) {
+        first[profile->order[3]] = 0;
+    }
+    // Copy the pixels already set onto the next ones, doubling each time
+    size_t size = (size_t)num * bpp;
+    size_t done = bpp;
+    while (done < size) {
+        size_t n = done < size - done ? done : size - done;
+        memcpy(first + done, first, n);
+        done += n;
+    }
+    return ESP_OK;
+err:
+    return ret;
+}
+
+static esp_err_t ws2812_get_buffer(led_strip_t *strip, uint8_t **buffer, size_t *size)
+{
+    esp_err_t ret = ESP_OK;
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    STRIP_CHECK(buffer, "buffer can't be null", err, ESP_ERR_INVALID_ARG);
+    *buffer = ws2812->back;
+    if (size) {
+        *size = ws2812->frame_size;
+    }
+    return ESP_OK;
+err:
+    return ret;
+}
+
+static void IRAM_ATTR ws2812_tx_end(rmt_channel_t channel, void *arg)
+{
+    ws2812_t *ws2812 = channel < RMT_CHANNEL_MAX ? ws2812_channels[channel] : NULL;
+    if (ws2812 == NULL) {
+        if (ws2812_prev_tx_end.function) {
+            ws2812_prev_tx_end.function(channel, ws2812_prev_tx_end.arg);
+        }
+        return;
+    }
+    ws2812->last_done_us = esp_timer_get_time();
+    if (ws2812->done_cb) {
+        ws2812->done_cb(&ws2812->parent, ws2812->done_arg);
+    }
+}
+
+static esp_err_t ws2812_wait_done(ws2812_t *ws2812, TickType_t ticks)
+{
+    return rmt_wait_tx_done(ws2812->rmt_channel, ticks);
+}
+
+/**
+ * @brief Swap the buffers and start transmitting the new front buffer without waiting for the end
+ *
+ * @note Waits for the previous frame first, its buffer becomes the back buffer.
+ *       The back buffer then starts as a copy of the frame just presented.
+ */
+static esp_err_t ws2812_start(ws2812_t *ws2812)
+{
+    esp_err_t ret = ESP_OK;
+    STRIP_CHECK(ws2812_wait_done(ws2812, portMAX_DELAY) == ESP_OK, "wait previous frame failed", err, ESP_FAIL);
+    // The line must stay low for the reset time after the previous frame, or the LEDs take both as one frame
+    int64_t reset_end_us = ws2812->last_done_us + ws2812->profile->reset_us;
+    while (esp_timer_get_time() < reset_end_us) {
+    }
+    uint8_t *frame = ws2812->back;
+    ws2812->back = ws2812->front;
+    ws2812->front = frame;
+    STRIP_CHECK(rmt_write_sample(ws2812->rmt_channel, ws2812->front, ws2812->frame_size, false) == ESP_OK,
                 "transmit RMT samples failed", err, ESP_FAIL);
-    return rmt_wait_tx_done(ws2812->rmt_channel, pdMS_TO_TICKS(timeout_ms));
+    // Copy while the frame is being sent, so drawing continues from the frame just presented
+    memcpy(ws2812->back, ws2812->front, ws2812->frame_size);
+    return ESP_OK;
 err:
     return ret;
 }
 
+static esp_err_t ws2812_present(led_strip_t *strip)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    return ws2812_start(ws2812);
+}
+
+static esp_err_t ws2812_wait(led_strip_t *strip, uint32_t timeout_ms)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    return ws2812_wait_done(ws2812, pdMS_TO_TICKS(timeout_ms));
+}
+
+static esp_err_t ws2812_refresh(led_strip_t *strip, uint32_t timeout_ms)
+{
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    esp_err_t ret = ws2812_start(ws2812);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return ws2812_wait_done(ws2812, pdMS_TO_TICKS(timeout_ms));
+}
+
 static esp_err_t ws2812_clear(led_strip_t *strip, uint32_t timeout_ms)
 {
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
     // Write zero to turn off all leds
-    memset(ws2812->buffer, 0, ws2812->strip_len * 3);
+    memset(ws2812->back, 0, ws2812->frame_size);
     return ws2812_refresh(strip, timeout_ms);
 }
 
 static esp_err_t ws2812_del(led_strip_t *strip)
 {
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    // The buffer may still be in use by the RMT refill interrupt
+    ws2812_wait_done(ws2812, portMAX_DELAY);
+    ws2812_channels[ws2812->rmt_channel] = NULL;
     free(ws2812);
     return ESP_OK;
 }
@@ -139,42 +348,102 @@ static esp_err_t ws2812_del(led_strip_t *strip)
 led_strip_t *led_strip_new_rmt_ws2812(const led_strip_config_t *config)
 {
     led_strip_t *ret = NULL;
+    ws2812_t *ws2812 = NULL;
     STRIP_CHECK(config, "configuration can't be null", err, NULL);
+    STRIP_CHECK(config->chip < LED_STRIP_CHIP_MAX, "unknown led chip", err, NULL);
+    STRIP_CHECK((rmt_channel_t)config->dev < RMT_CHANNEL_MAX, "invalid rmt channel", err, NULL);
+    STRIP_CHECK(ws2812_channels[(rmt_channel_t)config->dev] == NULL, "rmt channel already has a strip", err, NULL);
 
-    // 24 bits per led
-    uint32_t ws2812_size = sizeof(ws2812_t) + config->max_leds * 3;
-    ws2812_t *ws2812 = calloc(1, ws2812_size);
+    // 24 or 32 bits per led, two frames
+    const ws2812_profile_t *profile = &ws2812_profiles[config->chip];
+    uint32_t frame_size = config->max_leds * profile->bytes_per_pixel;
+    uint32_t ws2812_size = sizeof(ws2812_t) + frame_size * 2;
+    ws2812 = calloc(1, ws2812_size);
     STRIP_CHECK(ws2812, "request memory for ws2812 failed", err, NULL);
+    ws2812->profile = profile;
+    ws2812->frame_size = frame_size;
+    ws2812->front = ws2812->buffer;
+    ws2812->back = ws2812->buffer + frame_size;
 
     uint32_t counter_clk_hz = 0;
     STRIP_CHECK(rmt_get_counter_clock((rmt_channel_t)config->dev, &counter_clk_hz) == ESP_OK,
                 "get rmt counter clock failed", err, NULL);
-    // ns -> ticks
-    float ratio = (float)counter_clk_hz / 1e9;
-    ws2812_t0h_ticks = (uint32_t)(ratio * WS2812_T0H_NS);
-    ws2812_t0l_ticks = (uint32_t)(ratio * WS2812_T0L_NS);
-    ws2812_t1h_ticks = (uint32_t)(ratio * WS2812_T1H_NS);
-    ws2812_t1l_ticks = (uint32_t)(ratio * WS2812_T1L_NS);
+    ws2812_build_nibble_items(ws2812, counter_clk_hz);
 
-    // set ws2812 to rmt adapter
-    rmt_translator_init((rmt_channel_t)config->dev, ws2812_rmt_adapter);
+    // set ws2812 to rmt adapter, the strip is the context so each channel has its own timing
+    STRIP_CHECK(rmt_translator_init((rmt_channel_t)config->dev, ws2812_rmt_adapter) == ESP_OK,
+                "init rmt translator failed", err, NULL);
+    rmt_translator_set_context((rmt_channel_t)config->dev, ws2812);
 
     ws2812->rmt_channel = (rmt_channel_t)config->dev;
     ws2812->strip_len = config->max_leds;
 
+    ws2812_channels[ws2812->rmt_channel] = ws2812;
+    if (!ws2812_tx_end_registered) {
+        ws2812_prev_tx_end = rmt_register_tx_end_callback(ws2812_tx_end, NULL);
+        ws2812_tx_end_registered = true;
+    }
+
     ws2812->parent.set_pixel = ws2812_set_pixel;
+    ws2812->parent.set_pixel_rgbw = ws2812_set_pixel_rgbw;
+    ws2812->parent.set_pixels = ws2812_set_pixels;
+    ws2812->parent.fill = ws2812_fill;
+    ws2812->parent.get_buffer = ws2812_get_buffer;
     ws2812->parent.refresh = ws2812_refresh;
+    ws2812->parent.present = ws2812_present;
+    ws2812->parent.wait_done = ws2812_wait;
     ws2812->parent.clear = ws2812_clear;
     ws2812->parent.del = ws2812_del;
 
     return &ws2812->parent;
+err:
+    free(ws2812);
+    return ret;
+}
+
+esp_err_t led_strip_set_done_callback(led_strip_t *strip, led_strip_done_cb_t cb, void *arg)
+{
+    esp_err_t ret = ESP_OK;
+    STRIP_CHECK(strip, "strip can't be null", err, ESP_ERR_INVALID_ARG);
+    ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
+    STRIP_CHECK(ws2812_wait_done(ws2812, portMAX_DELAY) == ESP_OK, "wait previous frame failed", err, ESP_FAIL);
+    // Not sending now, the interrupt doesn't read these
+    ws2812->done_arg = arg;
+    ws2812->done_cb = cb;
+err:
+    return ret;
+}
+
+esp_err_t led_strip_refresh_all(led_strip_t *const strips[], size_t num, uint32_t timeout_ms)
+{
+    esp_err_t ret = ESP_OK;
+    STRIP_CHECK(strips || num == 0, "strips can't be null", err, ESP_ERR_INVALID_ARG);
+    // Start every channel first so the transmissions overlap, then wait for all of them
+    size_t started = 0;
+    for (; started < num; started++) {
+        ret = ws2812_start(__containerof(strips[started], ws2812_t, parent));
+        if (ret != ESP_OK) {
+            break;
+        }
+    }
+    for (size_t i = 0; i < started; i++) {
+        esp_err_t done = ws2812_wait_done(__containerof(strips[i], ws2812_t, parent), pdMS_TO_TICKS(timeout_ms));
+        if (ret == ESP_OK) {
+            ret = done;
+        }
+    }
 err:
     return ret;
 }
 
 led_strip_t * led_strip_init(uint8_t channel, uint8_t gpio, uint16_t led_num)
 {
-    static led_strip_t *pStrip;
+    return led_strip_init_chip(channel, gpio, led_num, LED_STRIP_WS2812B);
+}
+
+led_strip_t * led_strip_init_chip(uint8_t channel, uint8_t gpio, uint16_t led_num, led_strip_chip_t chip)
+{
+    led_strip_t *pStrip;
 
     rmt_config_t config = RMT_DEFAULT_CONFIG_TX(gpio, channel);
     // set counter clock to 40MHz
@@ -185,11 +454,13 @@ led_strip_t * led_strip_init(uint8_t channel, uint8_t gpio, uint16_t led_num)
 
     // install ws2812 driver
     led_strip_config_t strip_config = LED_STRIP_DEFAULT_CONFIG(led_num, (led_strip_dev_t)config.channel);
+    strip_config.chip = chip;
 
     pStrip = led_strip_new_rmt_ws2812(&strip_config);
 
     if ( !pStrip ) {
         ESP_LOGE(TAG, "install WS2812 driver failed");
+        rmt_driver_uninstall(config.channel);
         return NULL;
     }
 
@@ -202,6 +473,9 @@ led_strip_t * led_strip_init(uint8_t channel, uint8_t gpio, uint16_t led_num)
 esp_err_t led_strip_denit(led_strip_t *strip)
 {
     ws2812_t *ws2812 = __containerof(strip, ws2812_t, parent);
-    ESP_ERROR_CHECK(rmt_driver_uninstall(ws2812->rmt_channel));
-    return strip->del(strip);
+    rmt_channel_t channel = ws2812->rmt_channel;
+    // del waits for the last frame on the channel and frees the strip, so the driver goes after it
+    esp_err_t ret = strip->del(strip);
+    ESP_ERROR_CHECK(rmt_driver_uninstall(channel));
+    return ret;
 }
@@ -18,14 +18,86 @@
 
 #include "driver/rmt.h"
 #include "led_strip.h"
+#include "uart_line_rx.h"
+#include "uart_cmd.h"
+#include "uart_link.h"
+#include "uart_txq.h"
+#include "lat_trace.h"
+#include "led_fx.h"
+#include "frame_clock.h"
+#include "esp_timer.h"
 
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 // for ws2812
 #define RMT_TX_CHANNEL RMT_CHANNEL_0
 #define WS2812_PIN 38
 #define WS2812_NUM 1
 #define WS2812_LIGHT 50
+#define WS2812_FPS 60
+
+// 命令发给 WS2812 任务的消息
+typedef enum
+{
+    WS2812_MSG_COLOR = 0, /*!< 颜色，亮度按 bright */
+    WS2812_MSG_BRIGHT,    /*!< 亮度，百分比，用 red */
+    WS2812_MSG_FX,        /*!< 灯效，ws2812_fx_t，用 red */
+} ws2812_msg_type_t;
+
+typedef enum
+{
+    WS2812_FX_RAINBOW = 0,
+    WS2812_FX_CHASE,
+    WS2812_FX_FADE,
+    WS2812_FX_GRADIENT,
+    WS2812_FX_SHOW, /*!< 时间线，依次播放上面的灯效 */
+} ws2812_fx_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    int64_t rx_us;     /*!< 收到这一行的时间 */
+    int64_t queued_us; /*!< 放入队列的时间 */
+} ws2812_msg_t;
+
+// 命令到 LED 的延迟：收到一行、解析后放入队列、LED 任务取出、刷新完成
+enum
+{
+    LAT_RX = 0,
+    LAT_QUEUED,
+    LAT_DEQUEUED,
+    LAT_SHOWN,
+    LAT_STAGES,
+};
+
+static const char *const s_lat_names[] = {"parse", "queue", "refresh"};
+static lat_trace_t s_lat;
+static SemaphoreHandle_t s_lat_lock = NULL;
+static int64_t s_line_us; /*!< 正在处理的一行的接收时间，只在 uart_0 的接收任务中使用 */
+
+// 有动画的灯效按 WS2812_FPS 刷新
+static frame_clock_handle_t s_frame_clock = NULL;
+
+static const fx_effect_t s_fx_presets[] = {
+    [WS2812_FX_RAINBOW] = {.type = FX_RAINBOW, .period_ms = 3000, .span = FX_HUE_MAX, .sat = 255, .val = 255},
+    [WS2812_FX_CHASE] = {.type = FX_CHASE, .c0 = {255, 80, 0}, .c1 = {0, 0, 16}, .period_ms = 1000, .span = 6, .width = 2},
+    [WS2812_FX_FADE] = {.type = FX_FADE, .c0 = {0, 0, 0}, .c1 = {46, 49, 124}, .period_ms = 2000},
+    [WS2812_FX_GRADIENT] = {.type = FX_GRADIENT, .c0 = {255, 0, 40}, .c1 = {0, 80, 255}, .period_ms = 4000},
+};
+
+static const fx_keyframe_t s_show_frames[] = {
+    {4000, 0, s_fx_presets[WS2812_FX_RAINBOW]},
+    {3000, 500, s_fx_presets[WS2812_FX_CHASE]},
+    {4000, 500, s_fx_presets[WS2812_FX_FADE]},
+    {4000, 500, s_fx_presets[WS2812_FX_GRADIENT]},
+};
+
+static fx_rgb_t s_frame[WS2812_NUM];
+static fx_rgb_t s_scratch[WS2812_NUM];
 
 // for uart_1
 static const int RX_BUF_SIZE = 1024;
@@ -33,8 +105,43 @@ static const int RX_BUF_SIZE = 1024;
 #define TXD_PIN (GPIO_NUM_4) // to  B7
 #define RXD_PIN (GPIO_NUM_5) //   B6
 
+// uart_1 上的二进制消息，第一个字节是类型
+#define LINK_MSG_STATUS 1
+
+typedef struct __attribute__((packed))
+{
+    uint8_t type;
+    uint32_t uptime_ms;
+    uint32_t count;
+} link_status_msg_t;
+
+static uart_link_handle_t s_link = NULL;
+
+/**
+ * @description: uart_1 收到一条消息，在 uart_link 的接收任务中调用
+ * @return      {*}
+ * @param {void} *ctx
+ * @param {uint8_t} *data 返回后失效
+ * @param {size_t} len
+ * @param {bool} reliable
+ */
+static void link_rx(void *ctx, const uint8_t *data, size_t len, bool reliable)
+{
+    static const char *RX_TASK_TAG = "RX_TASK";
+    if (len == sizeof(link_status_msg_t) && data[0] == LINK_MSG_STATUS)
+    {
+        link_status_msg_t msg;
+        memcpy(&msg, data, sizeof(msg));
+        ESP_LOGD(RX_TASK_TAG, "status %u, peer up %u ms", msg.count, msg.uptime_ms);
+    }
+    else
+    {
+        ESP_LOGD(RX_TASK_TAG, "%u bytes, type %u", len, len ? data[0] : 0);
+    }
+}
+
 /**
- * @description: init uart_1
+ * @description: init uart_1，二进制帧（COBS + CRC-16，带确认和重发）
  * @return      {*}
  */
 void init(void)
@@ -47,22 +154,30 @@ void init(void)
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
         .source_clk = UART_SCLK_APB,
     };
-    // We won't use a buffer for sending data.
-    uart_driver_install(UART_NUM_1, RX_BUF_SIZE * 2, 0, 0, NULL, 0);
     uart_param_config(UART_NUM_1, &uart_config);
     uart_set_pin(UART_NUM_1, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-}
 
-int sendData(const char *logName, const char *data)
-{
-    const int len = strlen(data);
-    const int txBytes = uart_write_bytes(UART_NUM_1, data, len);
-    ESP_LOGI(logName, "Wrote %d bytes", txBytes);
-    return txBytes;
+    // 帧先放进发送队列，由发送任务交给驱动，发送方（包括接收任务中的确认）不等串口
+    uart_txq_handle_t txq;
+    uart_txq_config_t txq_config = UART_TXQ_DEFAULT_CONFIG(UART_NUM_1);
+    txq_config.task_priority = configMAX_PRIORITIES - 1;
+    ESP_ERROR_CHECK(uart_txq_start(&txq_config, &txq));
+
+    uart_link_config_t link_config = UART_LINK_DEFAULT_CONFIG(UART_NUM_1, link_rx, NULL);
+    link_config.driver_rx_size = RX_BUF_SIZE * 2;
+    link_config.driver_tx_size = RX_BUF_SIZE;
+    link_config.txq = txq;
+    // 115200 时一个最长的帧约 46 ms
+    link_config.rto_ms = 100;
+    // 对端可以要求切换到 2 Mbaud 传大量数据；两端不一致时按检测到的波特率跟上
+    link_config.max_baud = 2000000;
+    link_config.autobaud = true;
+    link_config.task_priority = configMAX_PRIORITIES - 1;
+    ESP_ERROR_CHECK(uart_link_start(&link_config, &s_link));
 }
 
 /**
- * @description: uart_1 transmit task 串口1发送任务
+ * @description: uart_1 transmit task 串口1发送任务，每秒发一条状态，每 10 秒打印一次统计
  * @return      {*}
  * @param {void} *arg
  */
@@ -70,38 +185,25 @@ static void tx_task(void *arg)
 {
     static const char *TX_TASK_TAG = "TX_TASK";
     esp_log_level_set(TX_TASK_TAG, ESP_LOG_INFO);
+    link_status_msg_t msg = {.type = LINK_MSG_STATUS};
     while (1)
     {
-        sendData(TX_TASK_TAG, "led on"); // important 重要函数 发送
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-
-        sendData(TX_TASK_TAG, "led off"); // important 重要函数 发送
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-    }
-}
-
-/**
- * @description: uart_1 receive task 串口1接收任务
- * @return      {*}
- * @param {void} *arg
- */
-static void rx_task(void *arg)
-{
-    static const char *RX_TASK_TAG = "RX_TASK";
-    esp_log_level_set(RX_TASK_TAG, ESP_LOG_INFO);
-    uint8_t *data = (uint8_t *)malloc(RX_BUF_SIZE + 1); // 申请一块内存空间 与free()成对出现
-
-    while (1)
-    {
-        const int rxBytes = uart_read_bytes(UART_NUM_1, data, RX_BUF_SIZE, 1000 / portTICK_RATE_MS); // important 重要函数 接收
-        if (rxBytes > 0)
+        msg.uptime_ms = esp_log_timestamp();
+        msg.count++;
+        if (uart_link_send(s_link, &msg, sizeof(msg), true, 1000 / portTICK_PERIOD_MS) != ESP_OK) // important 重要函数 发送
         {
-            data[rxBytes] = 0;
-            ESP_LOGI(RX_TASK_TAG, "Read %d bytes: '%s'", rxBytes, data);
-            ESP_LOG_BUFFER_HEXDUMP(RX_TASK_TAG, data, rxBytes, ESP_LOG_INFO);
+            ESP_LOGW(TX_TASK_TAG, "no acknowledgement from the peer");
         }
+        if (msg.count % 10 == 0)
+        {
+            link_stats_t stats;
+            uart_link_get_stats(s_link, &stats);
+            ESP_LOGI(TX_TASK_TAG, "%u baud, tx %u frames %u bytes, %u retransmits, %u lost; rx %u frames, %u errors",
+                     uart_link_get_baud(s_link), stats.tx_frames, stats.tx_bytes, stats.retransmits, stats.lost,
+                     stats.rx_frames, stats.rx_errors);
+        }
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
     }
-    free(data);
 }
 
 /**
@@ -111,87 +213,276 @@ static void rx_task(void *arg)
  */
 static void ws_2812_task(void *arg)
 {
+    fx_effect_t effect = {.type = FX_SOLID};
+    bool show = false;
+    bool gamma = false;
+    uint32_t bright = 100;
+    bool animating = false;
+    int64_t start_us = 0;
+    fx_lut_t lut;
+    fx_timeline_t show_tl;
 
-    uint32_t red = 0;
-    uint32_t green = 0;
-    uint32_t blue = 0;
-
-    uint8_t ws2812_dat = 0;
+    ws2812_msg_t ws2812_dat = {0};
 
     xQueueHandle xQueue = (xQueueHandle)arg;
 
     //////// ws2812 init begin
-    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(WS2812_PIN, RMT_TX_CHANNEL);
-    // set counter clock to 40MHz
-    config.clk_div = 2;
-
-    ESP_ERROR_CHECK(rmt_config(&config));
-    ESP_ERROR_CHECK(rmt_driver_install(config.channel, 0, 0));
-
-    // install ws2812 driver
-    led_strip_config_t strip_config = LED_STRIP_DEFAULT_CONFIG(WS2812_NUM, (led_strip_dev_t)config.channel);
-    led_strip_t *strip = led_strip_new_rmt_ws2812(&strip_config);
+    // RMT 通道、计数时钟和灯带驱动，初始化后已清空
+    led_strip_t *strip = led_strip_init(RMT_TX_CHANNEL, WS2812_PIN, WS2812_NUM);
     if (!strip)
     {
         ESP_LOGE("WS2812", "install WS2812 driver failed");
+        vTaskDelete(NULL);
+        return;
     }
-    // Clear LED strip (turn off all LEDs)
-    ESP_ERROR_CHECK(strip->clear(strip, 100));
     //////// ws2812 init finish
+    ESP_ERROR_CHECK(fx_timeline_init(&show_tl, s_show_frames, sizeof(s_show_frames) / sizeof(s_show_frames[0]), true));
+    fx_lut_build(&lut, 255, gamma);
 
     while (1)
     {
-        if (xQueueReceive(xQueue, &ws2812_dat, 10) != pdPASS)
+        // 有动画时按帧率等下一帧，只取出已经到的命令；否则一直阻塞，收到命令后立即刷新
+        if (animating)
         {
-            if (ws2812_dat == 1)
-            {
-                red = WS2812_LIGHT;
-                green = 0;
-                blue = 0;
-            }
-            else if (ws2812_dat == 2)
+            frame_clock_wait(s_frame_clock);
+        }
+        int64_t stamps[LAT_STAGES] = {0};
+        bool received = false;
+        bool restart = false;
+        TickType_t wait = animating ? 0 : portMAX_DELAY;
+        while (xQueueReceive(xQueue, &ws2812_dat, wait) == pdPASS)
+        {
+            wait = 0;
+            // 一次取出多条命令时只统计最后一条
+            stamps[LAT_RX] = ws2812_dat.rx_us;
+            stamps[LAT_QUEUED] = ws2812_dat.queued_us;
+            stamps[LAT_DEQUEUED] = esp_timer_get_time();
+            received = true;
+            if (ws2812_dat.type == WS2812_MSG_BRIGHT)
             {
-                red = 0;
-                green = WS2812_LIGHT;
-                blue = 0;
+                bright = ws2812_dat.red;
             }
-            else if (ws2812_dat == 3)
+            else if (ws2812_dat.type == WS2812_MSG_FX)
             {
-                red = 0;
-                green = 0;
-                blue = WS2812_LIGHT;
+                show = ws2812_dat.red == WS2812_FX_SHOW;
+                if (!show)
+                {
+                    effect = s_fx_presets[ws2812_dat.red];
+                }
+                gamma = true;
+                restart = true;
             }
-            else if (ws2812_dat == 4)
+            else
             {
-                red = 0;
-                green = 0;
-                blue = 0;
+                // 纯色不做伽马校正，亮度与原来一样按比例
+                effect = (fx_effect_t){.type = FX_SOLID, .c0 = {ws2812_dat.red, ws2812_dat.green, ws2812_dat.blue}};
+                show = false;
+                gamma = false;
+                restart = true;
             }
-            else if (ws2812_dat == 5)
+        }
+        if (received)
+        {
+            fx_lut_build(&lut, bright * 255 / 100, gamma);
+            if (restart)
             {
-                red = 46;
-                green = 49;
-                blue = 124;
+                start_us = esp_timer_get_time();
             }
-            else if (ws2812_dat == 6)
+            bool was_animating = animating;
+            animating = show || effect.period_ms != 0;
+            if (animating && !was_animating)
             {
-                red = 23;
-                green = 114;
-                blue = 180;
+                frame_clock_restart(s_frame_clock);
             }
-            ESP_ERROR_CHECK(strip->set_pixel(strip, 0, red, green, blue));
-            ESP_ERROR_CHECK(strip->refresh(strip, 100));
         }
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        else if (!animating)
+        {
+            continue;
+        }
+
+        uint32_t t_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+        if (show)
+        {
+            fx_timeline_render(&show_tl, t_ms, s_frame, s_scratch, WS2812_NUM);
+        }
+        else
+        {
+            fx_render(&effect, t_ms, s_frame, WS2812_NUM);
+        }
+        // 亮度和伽马校正一次查表，直接写入灯带的后缓冲区（WS2812B 为 GRB）
+        uint8_t *pixels = NULL;
+        ESP_ERROR_CHECK(strip->get_buffer(strip, &pixels, NULL));
+        fx_output(&lut, s_frame, WS2812_NUM, pixels, FX_ORDER_GRB);
+        // present 不等发送完成，下一帧的渲染与发送同时进行
+        ESP_ERROR_CHECK(strip->present(strip));
+        if (!received)
+        {
+            continue;
+        }
+        // 等 RMT 发完，之后 LED 在复位时间（280 us）内锁存；超时只丢掉这一次的延迟统计
+        esp_err_t ret = strip->wait_done(strip, 100);
+        if (ret != ESP_OK)
+        {
+            ESP_LOGW("WS2812", "wait_done: %s, latency sample skipped", esp_err_to_name(ret));
+            continue;
+        }
+        stamps[LAT_SHOWN] = esp_timer_get_time();
+
+        xSemaphoreTake(s_lat_lock, portMAX_DELAY);
+        lat_trace_record(&s_lat, stamps);
+        xSemaphoreGive(s_lat_lock);
+    }
+}
+
+static const ws2812_msg_t ws2812_red = {WS2812_MSG_COLOR, WS2812_LIGHT, 0, 0};
+static const ws2812_msg_t ws2812_green = {WS2812_MSG_COLOR, 0, WS2812_LIGHT, 0};
+static const ws2812_msg_t ws2812_blue = {WS2812_MSG_COLOR, 0, 0, WS2812_LIGHT};
+static const ws2812_msg_t ws2812_clear = {WS2812_MSG_COLOR, 0, 0, 0};
+static const ws2812_msg_t ws2812_purple = {WS2812_MSG_COLOR, 46, 49, 124};
+static const ws2812_msg_t ws2812_qing = {WS2812_MSG_COLOR, 23, 114, 180};
+static const ws2812_msg_t ws2812_rainbow = {WS2812_MSG_FX, WS2812_FX_RAINBOW};
+static const ws2812_msg_t ws2812_chase = {WS2812_MSG_FX, WS2812_FX_CHASE};
+static const ws2812_msg_t ws2812_fade = {WS2812_MSG_FX, WS2812_FX_FADE};
+static const ws2812_msg_t ws2812_gradient = {WS2812_MSG_FX, WS2812_FX_GRADIENT};
+static const ws2812_msg_t ws2812_show = {WS2812_MSG_FX, WS2812_FX_SHOW};
+
+static esp_err_t ws2812_send(xQueueHandle xQueue, const ws2812_msg_t *msg)
+{
+    ws2812_msg_t stamped = *msg;
+    stamped.rx_us = s_line_us;
+    stamped.queued_us = esp_timer_get_time();
+    if (xQueueSend(xQueue, &stamped, 10) != pdPASS)
+    {
+        ESP_LOGE("rx_task", "xQueueSend failed");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @description: 颜色名或灯效名，消息在 cmd->arg 中
+ */
+static esp_err_t cmd_color(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    return ws2812_send((xQueueHandle)ctx, (const ws2812_msg_t *)cmd->arg);
+}
+
+static esp_err_t cmd_rgb(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    ws2812_msg_t msg = {WS2812_MSG_COLOR, argv[0], argv[1], argv[2]};
+    return ws2812_send((xQueueHandle)ctx, &msg);
+}
+
+static esp_err_t cmd_bright(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    ws2812_msg_t msg = {WS2812_MSG_BRIGHT, argv[0], 0, 0};
+    return ws2812_send((xQueueHandle)ctx, &msg);
+}
+
+/**
+ * @description: 与 uart_1 的对端协商新的波特率，uart_0（控制台）不变
+ */
+static esp_err_t cmd_baud(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    esp_err_t ret = uart_link_set_baud(s_link, argv[0]);
+    ESP_LOGI("rx_task", "uart_1 at %u baud (%s)", uart_link_get_baud(s_link), esp_err_to_name(ret));
+    return ret;
+}
+
+/**
+ * @description: 打印命令到 LED 的延迟统计
+ */
+static esp_err_t cmd_lat(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    char buf[LAT_STAGES * 96];
+    xSemaphoreTake(s_lat_lock, portMAX_DELAY);
+    lat_trace_format(&s_lat, buf, sizeof(buf));
+    xSemaphoreGive(s_lat_lock);
+    printf("%s", buf);
+    return ESP_OK;
+}
+
+static esp_err_t cmd_lat_reset(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    xSemaphoreTake(s_lat_lock, portMAX_DELAY);
+    lat_trace_reset(&s_lat);
+    xSemaphoreGive(s_lat_lock);
+    return ESP_OK;
+}
+
+/**
+ * @description: 修改灯效的帧率并打印帧率统计，统计重新开始
+ */
+static esp_err_t cmd_fps(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    char buf[128];
+    frame_clock_format(s_frame_clock, buf, sizeof(buf));
+    printf("%s", buf);
+    frame_clock_reset_stats(s_frame_clock);
+    return frame_clock_set_fps(s_frame_clock, argv[0]);
+}
+
+static esp_err_t cmd_help_handler(const cmd_def_t *cmd, const int32_t *argv, void *ctx);
+
+static const cmd_def_t u0_cmds[] = {
+    {"red", "red", {{0}}, cmd_color, &ws2812_red},
+    {"green", "green", {{0}}, cmd_color, &ws2812_green},
+    {"blue", "blue", {{0}}, cmd_color, &ws2812_blue},
+    {"clear", "turn the LED off", {{0}}, cmd_color, &ws2812_clear},
+    {"purple", "purple", {{0}}, cmd_color, &ws2812_purple},
+    {"qing", "cyan (qing)", {{0}}, cmd_color, &ws2812_qing},
+    {"rgb", "any colour", {{"r", 0, 255}, {"g", 0, 255}, {"b", 0, 255}}, cmd_rgb, NULL},
+    {"bright", "brightness of the colour", {{"percent", 0, 100}}, cmd_bright, NULL},
+    {"rainbow", "rotating rainbow", {{0}}, cmd_color, &ws2812_rainbow},
+    {"chase", "chasing lights", {{0}}, cmd_color, &ws2812_chase},
+    {"fade", "fade in and out", {{0}}, cmd_color, &ws2812_fade},
+    {"gradient", "moving gradient", {{0}}, cmd_color, &ws2812_gradient},
+    {"show", "all the effects in a loop", {{0}}, cmd_color, &ws2812_show},
+    {"fps", "frame rate of the effects, prints the frame statistics", {{"fps", 1, 200}}, cmd_fps, NULL},
+    {"baud", "switch the uart_1 link to another baud rate", {{"rate", 9600, 2000000}}, cmd_baud, NULL},
+    {"lat", "command-to-LED latency (us)", {{0}}, cmd_lat, NULL},
+    {"lat_reset", "clear the latency statistics", {{0}}, cmd_lat_reset, NULL},
+    {"help", "list the commands", {{0}}, cmd_help_handler, NULL},
+};
+
+static cmd_table_t u0_cmd_table;
+
+static esp_err_t cmd_help_handler(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    char help[1024];
+    cmd_help(&u0_cmd_table, help, sizeof(help));
+    printf("%s", help);
+    return ESP_OK;
+}
+
+/**
+ * @description: uart_0 收到一行，按命令表解析后发给 WS2812 任务
+ * @return      {*}
+ * @param {void} *ctx 队列
+ * @param {uint8_t} *line 不含结束符
+ * @param {size_t} len
+ */
+static void u0_rx_line(void *ctx, const uint8_t *line, size_t len)
+{
+    static const char *RX_TASK_TAG = "RX_TASK";
+    s_line_us = esp_timer_get_time();
+    // 控制台也是 uart_0（115200），每打印一行要几毫秒，会算进命令的延迟
+    ESP_LOGD(RX_TASK_TAG, "Read line: '%.*s'", (int)len, (const char *)line);
+
+    char err[80];
+    esp_err_t ret = cmd_dispatch(&u0_cmd_table, line, len, ctx, err, sizeof(err));
+    if (ret == ESP_ERR_NOT_FOUND || ret == ESP_ERR_INVALID_ARG)
+    {
+        ESP_LOGW(RX_TASK_TAG, "%s", err);
     }
 }
 
 /**
- * @description: uart_0 receive task
+ * @description: init uart_0，按行接收
  * @return      {*}
- * @param {void} *arg
+ * @param {xQueueHandle} xQueue
  */
-static void u0_rx_task(void *arg)
+static void u0_init(xQueueHandle xQueue)
 {
     const uart_config_t uart_config = {
         .baud_rate = 115200,
@@ -201,64 +492,15 @@ static void u0_rx_task(void *arg)
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
         .source_clk = UART_SCLK_APB,
     };
-    // We won't use a buffer for sending data.
-    uart_driver_install(UART_NUM_0, RX_BUF_SIZE * 2, 0, 0, NULL, 0);
     uart_param_config(UART_NUM_0, &uart_config);
     uart_set_pin(UART_NUM_0, 43, 44, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    ESP_ERROR_CHECK(cmd_table_init(&u0_cmd_table, u0_cmds, sizeof(u0_cmds) / sizeof(u0_cmds[0])));
 
-    xQueueHandle xQueue = (xQueueHandle)arg;
-
-    uint8_t ws2812_cnt = 0;
-    static const char *RX_TASK_TAG = "RX_TASK";
-    esp_log_level_set(RX_TASK_TAG, ESP_LOG_INFO);
-    uint8_t *data = (uint8_t *)malloc(RX_BUF_SIZE + 1);
-
-    while (1)
-    {
-        const int rxBytes = uart_read_bytes(UART_NUM_0, data, RX_BUF_SIZE, 1000 / portTICK_RATE_MS);
-        if (rxBytes > 0)
-        {
-            data[rxBytes] = 0;
-            ESP_LOGI(RX_TASK_TAG, "Read %d bytes: '%s'", rxBytes, data);
-
-            ws2812_cnt = 0;
-
-            if (strstr((char *)data, "red") != NULL)
-            {
-                ws2812_cnt = 1;
-            }
-            else if (strstr((char *)data, "green") != NULL)
-            {
-                ws2812_cnt = 2;
-            }
-            else if (strstr((char *)data, "blue") != NULL)
-            {
-                ws2812_cnt = 3;
-            }
-            else if (strstr((char *)data, "clear") != NULL)
-            {
-                ws2812_cnt = 4;
-            }
-            else if (strstr((char *)data, "purple") != NULL)
-            {
-                ws2812_cnt = 5;
-            }
-            else if (strstr((char *)data, "qing") != NULL)
-            {
-                ws2812_cnt = 6;
-            }
-            if (ws2812_cnt != 0)
-            {
-                if (xQueueSend(xQueue, (void *)&ws2812_cnt, 10) != pdPASS)
-                {
-                    ESP_LOGE("rx_task", "xQueueSend failed");
-                }
-            }
-
-            ESP_LOG_BUFFER_HEXDUMP(RX_TASK_TAG, data, rxBytes, ESP_LOG_INFO);
-        }
-    }
-    free(data);
+    uart_line_rx_handle_t rx;
+    uart_line_rx_config_t rx_config = UART_LINE_RX_DEFAULT_CONFIG(UART_NUM_0, u0_rx_line, xQueue);
+    rx_config.driver_rx_size = RX_BUF_SIZE * 2;
+    rx_config.task_priority = configMAX_PRIORITIES - 1;
+    ESP_ERROR_CHECK(uart_line_rx_start(&rx_config, &rx));
 }
 
 void app_main(void)
@@ -266,16 +508,21 @@ void app_main(void)
 
     static xQueueHandle xQueue_UART2WS2812 = NULL;
 
+    lat_trace_init(&s_lat, s_lat_names, LAT_STAGES);
+    s_lat_lock = xSemaphoreCreateMutex();
+    ESP_ERROR_CHECK(frame_clock_create(WS2812_FPS, &s_frame_clock));
+
     init();
 
-    xQueue_UART2WS2812 = xQueueCreate(10, sizeof(uint8_t));
+    xQueue_UART2WS2812 = xQueueCreate(10, sizeof(ws2812_msg_t));
     if (xQueue_UART2WS2812 == NULL)
     {
         ESP_LOGE("app_main", "The queue could not be created");
     }
 
-    xTaskCreate(rx_task, "uart_rx_task", 1024 * 5, NULL, configMAX_PRIORITIES, NULL);
-    xTaskCreate(u0_rx_task, "u0_rx_task", 1024 * 5, (void *)xQueue_UART2WS2812, configMAX_PRIORITIES, NULL);
+    // 接收任务由 uart_line_rx / uart_link 创建，收到完整的一行或一帧才唤醒
+    u0_init(xQueue_UART2WS2812);
+
     xTaskCreate(tx_task, "uart_tx_task", 1024 * 5, NULL, configMAX_PRIORITIES - 1, NULL);
     xTaskCreate(ws_2812_task, "ws_2812_task", 1024 * 10, (void *)xQueue_UART2WS2812, configMAX_PRIORITIES - 2, NULL);
 }
@@ -0,0 +1,113 @@
+/*
+ * ADC 读取和校准的测试（03_ADC_single/components/adc_reader），模拟的 ADC1 带增益和偏移误差
+ *
+ * eFuse 的三种状态：有两点校准值时换算电压，不支持或没有烧写时只有原始读数，初始化都成功；
+ * 精度：每种衰减下扫过量程，校准后的电压与输入相差不超过 2mV，与按理想量程换算的误差比较；
+ * 错误：没有配置位宽时读取失败，通道超出范围时初始化失败。
+ *
+ * 用法：adc_reader_test [增益误差‰] [偏移mV]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "adc_reader.h"
+#include "test_util.h"
+
+#define TEST_CHANNEL ADC1_CHANNEL_2
+
+static void test_efuse(void)
+{
+    printf("efuse\n");
+    adc_reader_t reader;
+    int raw;
+    uint32_t mv = 1;
+    static const struct
+    {
+        esp_err_t efuse;
+        bool calibrated;
+    } cases[] = {
+        {ESP_OK, true},
+        {ESP_ERR_NOT_SUPPORTED, false},
+        {ESP_ERR_INVALID_VERSION, false},
+    };
+    adc_sim_set_input_mv(TEST_CHANNEL, 500);
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        adc_sim_set_efuse(cases[i].efuse);
+        CHECK(adc_reader_init(&reader, TEST_CHANNEL, ADC_ATTEN_DB_6) == ESP_OK, "init (efuse %d)", cases[i].efuse);
+        CHECK(reader.calibrated == cases[i].calibrated, "calibrated %d (efuse %d)", reader.calibrated,
+              cases[i].efuse);
+        CHECK(adc_reader_read(&reader, &raw, &mv) == ESP_OK && raw > 0, "read (efuse %d)", cases[i].efuse);
+        CHECK(cases[i].calibrated ? mv > 0 : mv == 0, "mv %u (efuse %d)", mv, cases[i].efuse);
+    }
+    // 电压可以不要
+    CHECK(adc_reader_read(&reader, &raw, NULL) == ESP_OK, "read without mv");
+    adc_sim_set_efuse(ESP_OK);
+
+    CHECK(adc_reader_init(NULL, TEST_CHANNEL, ADC_ATTEN_DB_6) == ESP_ERR_INVALID_ARG, "no reader");
+    CHECK(adc_reader_init(&reader, ADC1_CHANNEL_MAX, ADC_ATTEN_DB_6) == ESP_ERR_INVALID_ARG, "bad channel");
+}
+
+/**
+ * @description: 扫过 atten 的量程（低端留 5%，高端留 10%，误差使读数超出量程的部分不算），返回校准后的最大误差
+ */
+static int sweep(adc_atten_t atten, int gain_permille, int offset_mv)
+{
+    adc_reader_t reader;
+    adc_reader_init(&reader, TEST_CHANNEL, atten);
+    int full = adc_sim_full_scale_mv(atten);
+    int cal_max = 0;
+    int ideal_max = 0;
+    for (int in = full / 20; in <= full * 9 / 10; in += full / 100)
+    {
+        adc_sim_set_input_mv(TEST_CHANNEL, in);
+        int raw;
+        uint32_t mv;
+        if (adc_reader_read(&reader, &raw, &mv) != ESP_OK)
+        {
+            return full;
+        }
+        int cal_err = abs((int)mv - in);
+        int ideal_err = abs(raw * full / 4095 - in);
+        cal_max = cal_err > cal_max ? cal_err : cal_max;
+        ideal_max = ideal_err > ideal_max ? ideal_err : ideal_max;
+    }
+    printf("  atten %d (0~%d mV): calibrated max error %d mV, uncalibrated %d mV\n", atten, full, cal_max,
+           ideal_max);
+    CHECK((gain_permille == 0 && offset_mv == 0) || ideal_max > cal_max, "calibration does not help");
+    return cal_max;
+}
+
+static void test_accuracy(int gain_permille, int offset_mv)
+{
+    printf("accuracy, gain error %d permille, offset %d mV\n", gain_permille, offset_mv);
+    adc_sim_set_error(gain_permille, offset_mv);
+    for (adc_atten_t atten = ADC_ATTEN_DB_0; atten < ADC_ATTEN_MAX; atten++)
+    {
+        int err = sweep(atten, gain_permille, offset_mv);
+        CHECK(err <= 2, "atten %d max error %d mV", atten, err);
+    }
+    adc_sim_set_error(0, 0);
+}
+
+int main(int argc, char **argv)
+{
+    int gain_permille = argc > 1 ? atoi(argv[1]) : 30;
+    int offset_mv = argc > 2 ? atoi(argv[2]) : 20;
+
+    printf("width not configured\n");
+    adc_reader_t reader = {.channel = TEST_CHANNEL};
+    int raw = 0;
+    CHECK(adc_reader_read(&reader, &raw, NULL) == ESP_FAIL, "read before init");
+    CHECK(adc_sim_get_reads() == 0, "reads %u", adc_sim_get_reads());
+
+    test_efuse();
+    test_accuracy(gain_permille, offset_mv);
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
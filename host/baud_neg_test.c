@@ -0,0 +1,484 @@
+/*
+ * 切换波特率的协商和自动波特率检测的测试（08_uart/components/uart_link/baud_neg.c）
+ *
+ * 两端通过模拟的串口相连（虚拟时间）：每帧按发送时的波特率计算发完的时间，接收端的波特率不同时
+ * 只收到错误的数据。检查：切换成功后两端都在新的波特率上，大量数据传输的时间按比例缩短；
+ * 对端不支持时拒绝；新的波特率不通时两端回到原来的波特率；CONFIRM 全部丢失后，发起方在传输层
+ * 放弃重发时回到 base_baud，或者接收方用检测到的波特率跟上；两端同时发起时都拒绝。
+ * 另外检查从脉宽估计波特率，最后在 pty 上用 uart_link_posix 切换一次。
+ *
+ * 用法：baud_neg_test [消息数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <pty.h>
+#include <termios.h>
+#include "link_proto.h"
+#include "baud_neg.h"
+#include "uart_link_posix.h"
+#include "test_util.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+#define SIM_MAX_FRAMES 64
+#define SIM_LATENCY_US 50
+#define SIM_BASE_BAUD 115200
+#define SIM_CLK_HZ 80000000
+#define SIM_AUTOBAUD_FRAMES 3
+
+static size_t make_msg(uint32_t i, uint8_t *out)
+{
+    size_t len = 4 + (i * 37u) % 200;
+    for (size_t k = 4; k < len; k++)
+    {
+        out[k] = (uint8_t)(i * 7 + k);
+    }
+    memcpy(out, &i, 4);
+    return len;
+}
+
+typedef struct
+{
+    int64_t arrive_us;
+    uint32_t baud;     /*!< 发送时的波特率 */
+    uint16_t len;
+    uint8_t data[LINK_MAX_ENCODED];
+} sim_frame_t;
+
+typedef struct sim_end_s sim_end_t;
+
+struct sim_end_s
+{
+    link_hw_t parent;
+    baud_hw_t baud_parent;
+    link_t link;
+    baud_neg_t neg;
+    sim_end_t *peer;
+    sim_frame_t queue[SIM_MAX_FRAMES];
+    int head;
+    int count;
+    int64_t busy_us;
+    bool autobaud;     /*!< 连续收到错误的帧时按对端的波特率切换 */
+    uint8_t bad_frames;
+    bool done;
+    esp_err_t result;
+    uint32_t next_tx;
+    int64_t last_rx;   /*!< 收到的最后一条消息的编号，-1 表示还没有 */
+    uint32_t received;
+    uint32_t bad_rx;
+};
+
+typedef struct
+{
+    uint32_t max_ok_baud;  /*!< 高于它的波特率上帧全部丢失 */
+    bool drop_confirm;     /*!< 丢掉所有 CONFIRM */
+} sim_channel_t;
+
+static int64_t s_now;
+static sim_channel_t s_chan;
+
+static int64_t sim_now_us(link_hw_t *hw)
+{
+    return s_now;
+}
+
+static int64_t sim_baud_now_us(baud_hw_t *hw)
+{
+    return s_now;
+}
+
+static esp_err_t sim_write(link_hw_t *hw, const uint8_t *data, size_t len)
+{
+    sim_end_t *e = __containerof(hw, sim_end_t, parent);
+    uint32_t baud = e->neg.baud;
+    e->busy_us = (e->busy_us > s_now ? e->busy_us : s_now) + (int64_t)len * 10 * 1000000 / baud;
+    if (e->count == SIM_MAX_FRAMES || (s_chan.max_ok_baud && baud > s_chan.max_ok_baud))
+    {
+        return ESP_OK;
+    }
+    sim_frame_t *f = &e->queue[(e->head + e->count++) % SIM_MAX_FRAMES];
+    f->arrive_us = e->busy_us + SIM_LATENCY_US;
+    f->baud = baud;
+    f->len = len;
+    memcpy(f->data, data, len);
+    return ESP_OK;
+}
+
+static esp_err_t sim_baud_send(baud_hw_t *hw, const uint8_t *data, size_t len)
+{
+    sim_end_t *e = __containerof(hw, sim_end_t, baud_parent);
+    if (s_chan.drop_confirm && data[0] == BAUD_MSG_CONFIRM)
+    {
+        return ESP_OK;
+    }
+    return link_send_ctrl(&e->link, data, len);
+}
+
+static esp_err_t sim_baud_set(baud_hw_t *hw, uint32_t baud)
+{
+    // 已写入的帧带着原来的波特率，相当于发完才切换
+    sim_end_t *e = __containerof(hw, sim_end_t, baud_parent);
+    link_set_baud(&e->link, baud);
+    return ESP_OK;
+}
+
+static void sim_baud_done(void *ctx, uint32_t baud, esp_err_t result)
+{
+    sim_end_t *e = ctx;
+    e->done = true;
+    e->result = result;
+}
+
+static void sim_on_ctrl(void *ctx, const uint8_t *data, size_t len, bool reliable)
+{
+    sim_end_t *e = ctx;
+    baud_neg_input(&e->neg, data, len);
+}
+
+static void sim_on_rx(void *ctx, const uint8_t *data, size_t len, bool reliable)
+{
+    sim_end_t *e = ctx;
+    uint32_t i;
+    memcpy(&i, data, 4);
+    uint8_t expect[LINK_MAX_PAYLOAD];
+    size_t n = make_msg(i, expect);
+    // 放弃重发的消息不会收到，但顺序不能乱
+    e->bad_rx += n != len || memcmp(expect, data, len) != 0 || (int64_t)i <= e->last_rx;
+    e->last_rx = i;
+    e->received++;
+}
+
+static void sim_init(sim_end_t *e, sim_end_t *peer, uint8_t session, uint32_t max_baud)
+{
+    memset(e, 0, sizeof(*e));
+    e->parent.write = sim_write;
+    e->parent.now_us = sim_now_us;
+    e->baud_parent.send = sim_baud_send;
+    e->baud_parent.set_baud = sim_baud_set;
+    e->baud_parent.now_us = sim_baud_now_us;
+    e->peer = peer;
+    e->last_rx = -1;
+    link_config_t config = LINK_DEFAULT_CONFIG(session, sim_on_rx, e);
+    config.baud = SIM_BASE_BAUD;
+    config.rto_ms = 100;
+    config.ctrl_cb = sim_on_ctrl;
+    config.ctrl_ctx = e;
+    link_init(&e->link, &config, &e->parent);
+    baud_neg_config_t neg_config = BAUD_NEG_DEFAULT_CONFIG(SIM_BASE_BAUD, max_baud);
+    neg_config.cb = sim_baud_done;
+    neg_config.ctx = e;
+    baud_neg_init(&e->neg, &neg_config, &e->baud_parent);
+}
+
+/**
+ * @description: 接收端的波特率不对：相当于 uart_link 中收到错误的帧，按需检测对端的波特率
+ */
+static void sim_garbage(sim_end_t *e, uint32_t baud)
+{
+    static const uint8_t garbage[] = {0x31, 0xF0, 0x07};
+    link_input(&e->link, garbage, sizeof(garbage));
+    if (e->autobaud && ++e->bad_frames >= SIM_AUTOBAUD_FRAMES)
+    {
+        // 硬件测得的最短脉宽：一位的时钟数
+        uint32_t pulse = (SIM_CLK_HZ + baud / 2) / baud;
+        baud_neg_follow(&e->neg, baud_from_pulses(SIM_CLK_HZ, pulse, pulse * 2, 4));
+        e->bad_frames = 0;
+    }
+}
+
+static void sim_deliver(sim_end_t *e)
+{
+    while (e->count && e->queue[e->head].arrive_us <= s_now)
+    {
+        sim_frame_t *f = &e->queue[e->head];
+        e->head = (e->head + 1) % SIM_MAX_FRAMES;
+        e->count--;
+        if (f->baud == e->peer->neg.baud)
+        {
+            e->peer->bad_frames = 0;
+            link_input(&e->peer->link, f->data, f->len - 1);
+        }
+        else
+        {
+            sim_garbage(e->peer, f->baud);
+        }
+    }
+}
+
+/**
+ * @description: 与 uart_link_poll 相同：传输层放弃重发时回到 base_baud
+ */
+static void sim_timers(sim_end_t *e)
+{
+    uint32_t lost = e->link.stats.lost;
+    link_poll(&e->link);
+    if (e->link.stats.lost != lost)
+    {
+        baud_neg_link_lost(&e->neg);
+    }
+    baud_neg_poll(&e->neg);
+}
+
+static void sim_send(sim_end_t *e, uint32_t total)
+{
+    uint8_t msg[LINK_MAX_PAYLOAD];
+    while (e->next_tx < total && e->busy_us <= s_now + 200)
+    {
+        size_t len = make_msg(e->next_tx, msg);
+        if (link_send(&e->link, msg, len, true) != ESP_OK)
+        {
+            break;
+        }
+        e->next_tx++;
+    }
+}
+
+/**
+ * @description: 运行到 a 发完 total 条并全部确认，或到时间
+ */
+static int64_t sim_run(sim_end_t *a, sim_end_t *b, uint32_t total, int64_t limit_us)
+{
+    int64_t start = s_now;
+    while (s_now - start < limit_us && (a->next_tx < total || link_tx_pending(&a->link)))
+    {
+        sim_send(a, total);
+        sim_timers(a);
+        sim_timers(b);
+        s_now += 10;
+        sim_deliver(a);
+        sim_deliver(b);
+    }
+    return s_now - start;
+}
+
+/**
+ * @description: 运行到 a 发起的协商在两端都结束
+ */
+static int64_t sim_negotiate(sim_end_t *a, sim_end_t *b)
+{
+    int64_t start = s_now;
+    while (s_now - start < 2000000 && (!a->done || a->neg.state != BAUD_NEG_IDLE || b->neg.state != BAUD_NEG_IDLE))
+    {
+        sim_timers(a);
+        sim_timers(b);
+        s_now += 10;
+        sim_deliver(a);
+        sim_deliver(b);
+    }
+    return s_now - start;
+}
+
+static void test_pulses(void)
+{
+    static const uint32_t rates[] = {9600, 57600, 115200, 460800, 921600, 1000000, 1500000, 2000000, 4000000};
+    int bad = 0;
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        uint32_t pulse = (SIM_CLK_HZ + rates[i] / 2) / rates[i];
+        bad += baud_from_pulses(SIM_CLK_HZ, pulse, 0, 4) != rates[i];
+        bad += baud_from_pulses(SIM_CLK_HZ, pulse * 3, pulse, 4) != rates[i];
+        // 3% 的时钟误差
+        bad += baud_from_pulses(SIM_CLK_HZ, pulse * 103 / 100, 0, 4) != rates[i];
+    }
+    CHECK(bad == 0, "pulses: %d rates not recognised", bad);
+    CHECK(baud_from_pulses(SIM_CLK_HZ, 46, 0, 4) == 0, "pulses: 1.74 Mbaud snapped");
+    CHECK(baud_from_pulses(SIM_CLK_HZ, 0, 0, 4) == 0, "pulses: no edges");
+    CHECK(baud_nearest_standard(115190, 2) == 115200, "nearest: divider rounding");
+}
+
+static void test_switch(uint32_t total)
+{
+    static sim_end_t a, b;
+    memset(&s_chan, 0, sizeof(s_chan));
+    sim_init(&a, &b, 0x11, 2000000);
+    sim_init(&b, &a, 0x22, 2000000);
+    int64_t slow = sim_run(&a, &b, total, 60000000);
+
+    CHECK(baud_neg_start(&a.neg, 2000000) == ESP_OK, "switch: start");
+    CHECK(baud_neg_start(&a.neg, 921600) == ESP_ERR_INVALID_STATE, "switch: second start accepted");
+    int64_t took = sim_negotiate(&a, &b);
+    CHECK(a.done && a.result == ESP_OK && b.done && b.result == ESP_OK, "switch: result %d/%d", a.result,
+          b.result);
+    CHECK(a.neg.baud == 2000000 && b.neg.baud == 2000000, "switch: at %u/%u", a.neg.baud, b.neg.baud);
+
+    a.next_tx = 0;
+    b.last_rx = -1;
+    b.received = 0;
+    int64_t fast = sim_run(&a, &b, total, 60000000);
+    CHECK(b.received == total && b.bad_rx == 0, "switch: %u of %u, %u bad", b.received, total, b.bad_rx);
+    CHECK(fast * 8 < slow, "switch: %lld us at 2 Mbaud vs %lld us", (long long)fast, (long long)slow);
+    printf("%-10s %u messages in %.1f ms at %u, %.1f ms at 2000000 (negotiated in %.1f ms)\n", "switch", total,
+           slow / 1000.0, SIM_BASE_BAUD, fast / 1000.0, took / 1000.0);
+}
+
+static void test_unsupported(void)
+{
+    static sim_end_t a, b;
+    memset(&s_chan, 0, sizeof(s_chan));
+    sim_init(&a, &b, 0x11, 2000000);
+    sim_init(&b, &a, 0x22, 921600);
+    CHECK(baud_neg_start(&a.neg, 1234567) == ESP_ERR_NOT_SUPPORTED, "unsupported: non-standard rate accepted");
+    baud_neg_start(&a.neg, 2000000);
+    sim_negotiate(&a, &b);
+    CHECK(a.done && a.result == ESP_ERR_NOT_SUPPORTED, "unsupported: result %d", a.result);
+    CHECK(a.neg.baud == SIM_BASE_BAUD && b.neg.baud == SIM_BASE_BAUD, "unsupported: at %u/%u", a.neg.baud,
+          b.neg.baud);
+    CHECK(b.neg.stats.rejected == 1, "unsupported: %u rejected", b.neg.stats.rejected);
+}
+
+static void test_fallback(uint32_t total)
+{
+    static sim_end_t a, b;
+    memset(&s_chan, 0, sizeof(s_chan));
+    s_chan.max_ok_baud = 1000000;
+    sim_init(&a, &b, 0x11, 2000000);
+    sim_init(&b, &a, 0x22, 2000000);
+    baud_neg_start(&a.neg, 2000000);
+    sim_negotiate(&a, &b);
+    CHECK(a.done && a.result == ESP_ERR_TIMEOUT && b.done && b.result == ESP_ERR_TIMEOUT, "fallback: result %d/%d",
+          a.result, b.result);
+    CHECK(a.neg.baud == SIM_BASE_BAUD && b.neg.baud == SIM_BASE_BAUD, "fallback: at %u/%u", a.neg.baud, b.neg.baud);
+    sim_run(&a, &b, total, 60000000);
+    CHECK(b.received == total && b.bad_rx == 0, "fallback: %u of %u after", b.received, total);
+    printf("%-10s 2000000 does not work: both back at %u, %u messages after\n", "fallback", a.neg.baud, b.received);
+}
+
+/**
+ * @description: CONFIRM 全部丢失，a 在新的波特率，b 回到原来的；b 检测或不检测对端的波特率
+ */
+static void test_split(uint32_t total, bool autobaud)
+{
+    static sim_end_t a, b;
+    const char *name = autobaud ? "autobaud" : "link lost";
+    memset(&s_chan, 0, sizeof(s_chan));
+    s_chan.drop_confirm = true;
+    sim_init(&a, &b, 0x11, 2000000);
+    sim_init(&b, &a, 0x22, 2000000);
+    b.autobaud = autobaud;
+    // 先传一条，b 的传输层与 a 同步（否则从收到的第一个序号开始，看不出丢了哪些）
+    sim_run(&a, &b, 1, 1000000);
+    baud_neg_start(&a.neg, 2000000);
+    sim_negotiate(&a, &b);
+    CHECK(a.result == ESP_OK && b.result == ESP_ERR_TIMEOUT, "%s: result %d/%d", name, a.result, b.result);
+    CHECK(a.neg.baud == 2000000 && b.neg.baud == SIM_BASE_BAUD, "%s: at %u/%u", name, a.neg.baud, b.neg.baud);
+
+    int64_t took = sim_run(&a, &b, total, 60000000);
+    CHECK(a.neg.baud == b.neg.baud, "%s: still split %u/%u", name, a.neg.baud, b.neg.baud);
+    if (autobaud)
+    {
+        CHECK(b.neg.baud == 2000000 && b.neg.stats.follows == 1 && a.link.stats.lost == 0,
+              "%s: b at %u, %u follows, %u lost", name, b.neg.baud, b.neg.stats.follows, a.link.stats.lost);
+        CHECK(b.received == total, "%s: %u of %u", name, b.received, total);
+    }
+    else
+    {
+        CHECK(a.neg.baud == SIM_BASE_BAUD && a.neg.stats.resets == 1, "%s: a at %u, %u resets", name, a.neg.baud,
+              a.neg.stats.resets);
+        CHECK(b.received + a.link.stats.lost == total, "%s: %u received + %u lost of %u", name, b.received,
+              a.link.stats.lost, total);
+    }
+    CHECK(b.bad_rx == 0, "%s: %u bad", name, b.bad_rx);
+    printf("%-10s confirms lost: both at %u after %.1f ms, %u messages lost\n", name, a.neg.baud, took / 1000.0,
+           a.link.stats.lost);
+}
+
+static void test_collision(void)
+{
+    static sim_end_t a, b;
+    memset(&s_chan, 0, sizeof(s_chan));
+    sim_init(&a, &b, 0x11, 2000000);
+    sim_init(&b, &a, 0x22, 2000000);
+    baud_neg_start(&a.neg, 2000000);
+    baud_neg_start(&b.neg, 921600);
+    sim_negotiate(&a, &b);
+    CHECK(a.result == ESP_ERR_NOT_SUPPORTED && b.result == ESP_ERR_NOT_SUPPORTED, "collision: result %d/%d",
+          a.result, b.result);
+    CHECK(a.neg.baud == SIM_BASE_BAUD && b.neg.baud == SIM_BASE_BAUD, "collision: at %u/%u", a.neg.baud,
+          b.neg.baud);
+}
+
+typedef struct
+{
+    uart_link_posix_t *l;
+    volatile bool stop;
+    uint32_t received;
+} pty_end_t;
+
+static void pty_on_rx(void *ctx, const uint8_t *data, size_t len, bool reliable)
+{
+    pty_end_t *e = ctx;
+    e->received++;
+}
+
+static void *pty_peer_thread(void *arg)
+{
+    pty_end_t *e = arg;
+    while (!e->stop)
+    {
+        uart_link_posix_poll(e->l, 10);
+    }
+    return NULL;
+}
+
+static void test_pty(void)
+{
+    int master, slave;
+    if (openpty(&master, &slave, NULL, NULL, NULL) != 0)
+    {
+        printf("pty        skipped (openpty failed)\n");
+        return;
+    }
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    pty_end_t host = {0}, peer = {0};
+    link_config_t host_config = LINK_DEFAULT_CONFIG(0x55, pty_on_rx, &host);
+    link_config_t peer_config = LINK_DEFAULT_CONFIG(0x66, pty_on_rx, &peer);
+    host.l = uart_link_posix_attach(master, &host_config);
+    peer.l = uart_link_posix_attach(slave, &peer_config);
+    uart_link_posix_accept_baud(host.l, 2000000);
+    uart_link_posix_accept_baud(peer.l, 2000000);
+    pthread_t thread;
+    pthread_create(&thread, NULL, pty_peer_thread, &peer);
+
+    esp_err_t ret = uart_link_posix_set_baud(host.l, 2000000, 2000);
+    uint8_t msg[LINK_MAX_PAYLOAD];
+    int failed = 0;
+    for (uint32_t i = 0; i < 50; i++)
+    {
+        failed += uart_link_posix_send(host.l, msg, make_msg(i, msg), true, 2000) != ESP_OK;
+    }
+    failed += uart_link_posix_flush(host.l, 2000) != ESP_OK;
+    peer.stop = true;
+    pthread_join(thread, NULL);
+    printf("%-10s switched to %u (%s), %u messages after\n", "pty", uart_link_posix_get_baud(host.l),
+           ret == ESP_OK ? "ok" : "failed", peer.received);
+    CHECK(ret == ESP_OK, "pty: switch returned %d", ret);
+    CHECK(uart_link_posix_get_baud(host.l) == 2000000 && uart_link_posix_get_baud(peer.l) == 2000000,
+          "pty: at %u/%u", uart_link_posix_get_baud(host.l), uart_link_posix_get_baud(peer.l));
+    CHECK(failed == 0 && peer.received == 50, "pty: %d failed, %u received", failed, peer.received);
+    uart_link_posix_close(host.l);
+    uart_link_posix_close(peer.l);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t total = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 500;
+    test_pulses();
+    test_switch(total);
+    test_unsupported();
+    test_fallback(total / 4);
+    test_split(total / 4, false);
+    test_split(total / 4, true);
+    test_collision();
+    test_pty();
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * drift_estimator 的测试（07_NTP/components/time_holdover）
+ *
+ * 模拟的振荡器比真实时间快 OSC_PPM，频率带随机游走；SNTP 的测量有 ±NOISE_US 的噪声，
+ * 偶尔因为网络延时突变多出 SPIKE_US。
+ * 1. 开环：按估计器给出的间隔送入样本，检查频率、预测误差是否在 3σ 之内、同步间隔的增长和离群的丢弃；
+ *    频率突变后应重新开始并重新收敛。
+ * 2. 闭环：通过 holdover 持续补偿系统时钟，和固定每小时同步、不补偿比较最大误差和同步次数。
+ *
+ * 用法：drift_estimator_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include "drift_estimator.h"
+#include "holdover.h"
+#include "test_util.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+#define OSC_PPM 120.0
+#define WANDER_PPM 0.05 // 每小时频率随机游走的幅度
+#define NOISE_US 3000
+#define SPIKE_US 150000
+#define SPIKE_PERCENT 5
+#define STEP_S 10
+#define DAY_S 86400
+#define T0_US (1767225600LL * 1000000)
+
+typedef struct
+{
+    int64_t now;      /*!< 真实时间 */
+    double offset;    /*!< 振荡器 - 真实时间 */
+    double ppm;
+    double wander;    /*!< 每 STEP_S 的频率随机游走 */
+    uint32_t seed;
+} osc_t;
+
+static double osc_uniform(osc_t *o)
+{
+    o->seed = o->seed * 1103515245 + 12345;
+    return ((o->seed >> 8) & 0xFFFF) / 65535.0 * 2 - 1;
+}
+
+static void osc_init(osc_t *o, double ppm)
+{
+    memset(o, 0, sizeof(*o));
+    o->now = T0_US;
+    o->ppm = ppm;
+    o->wander = WANDER_PPM / sqrt(3600.0 / STEP_S);
+    o->seed = 7;
+}
+
+static void osc_advance(osc_t *o, int64_t s)
+{
+    for (int64_t i = 0; i < s / STEP_S; i++)
+    {
+        o->ppm += o->wander * osc_uniform(o);
+        o->offset += STEP_S * o->ppm;
+        o->now += STEP_S * 1000000LL;
+    }
+}
+
+/**
+ * @description: 一次 SNTP 测量的噪声，偶尔有网络延时突变
+ */
+static int64_t osc_noise(osc_t *o)
+{
+    int64_t noise = (int64_t)(NOISE_US * osc_uniform(o));
+    if (osc_uniform(o) > 1 - SPIKE_PERCENT / 50.0)
+    {
+        noise += SPIKE_US;
+    }
+    return noise;
+}
+
+static void open_loop(void)
+{
+    printf("open loop: %.0f ppm, wander %.2f ppm/h, noise %d us, %d%% spikes of %d us\n", OSC_PPM, WANDER_PPM,
+           NOISE_US, SPIKE_PERCENT, SPIKE_US);
+    const drift_config_t config = DRIFT_DEFAULT_CONFIG();
+    drift_estimator_t de;
+    drift_reset(&de, &config);
+    osc_t osc;
+    osc_init(&osc, OSC_PPM);
+
+    int samples = 0, outliers = 0, covered = 0, predictions = 0;
+    uint32_t max_poll = 0;
+    for (int64_t t = 0; t < 5 * DAY_S;)
+    {
+        uint32_t poll = de.poll_s;
+        osc_advance(&osc, poll);
+        t += poll;
+        // 预测的误差是否在 3σ 之内（用无噪声的真实偏差比较）
+        if (de.valid)
+        {
+            int64_t err = llabs(drift_predict(&de, osc.now) - (int64_t)osc.offset);
+            covered += err <= drift_error_us(&de, &config, osc.now - de.fit_t_us);
+            predictions++;
+        }
+        // 收敛之后固定注入一次延时突变，确认会被丢弃
+        int64_t noise = samples == 12 ? SPIKE_US : osc_noise(&osc);
+        drift_result_t r = drift_add(&de, &config, osc.now, (int64_t)osc.offset + noise);
+        CHECK(samples != 12 || r == DRIFT_OUTLIER, "spike accepted (%d)", r);
+        samples++;
+        outliers += r == DRIFT_OUTLIER;
+        CHECK(r != DRIFT_RESTARTED, "restarted without a frequency step at %lld s", (long long)t);
+        max_poll = de.poll_s > max_poll ? de.poll_s : max_poll;
+    }
+    printf("  %d samples, %d outliers, poll up to %u s, %d/%d predictions within 3 sigma\n", samples, outliers,
+           max_poll, covered, predictions);
+    printf("  drift %d ± %d ppb (true %.0f), rms %d us\n", de.freq_ppb, de.sigma_ppb, osc.ppm * 1000, de.rms_us);
+    CHECK(de.valid && fabs(de.freq_ppb - osc.ppm * 1000) < 1000, "drift %d ppb", de.freq_ppb);
+    CHECK(max_poll >= 8 * config.min_poll_s, "poll did not grow (%u s)", max_poll);
+    CHECK(outliers > 0, "spikes not rejected");
+    CHECK(covered * 100 >= predictions * 90, "only %d/%d predictions covered", covered, predictions);
+
+    // 频率突变（例如从睡眠改为一直运行）：先按离群丢弃，连续 max_outliers 个后重新开始
+    printf("frequency step +30 ppm\n");
+    osc.ppm += 30;
+    int restarted = -1;
+    for (int i = 0; i < 20 && restarted < 0; i++)
+    {
+        osc_advance(&osc, de.poll_s);
+        if (drift_add(&de, &config, osc.now, (int64_t)osc.offset) == DRIFT_RESTARTED)
+        {
+            restarted = i;
+        }
+    }
+    CHECK(restarted >= 0, "no restart after frequency step");
+    for (int64_t t = 0; t < DAY_S; t += de.poll_s)
+    {
+        osc_advance(&osc, de.poll_s);
+        drift_add(&de, &config, osc.now, (int64_t)osc.offset + (int64_t)(NOISE_US * osc_uniform(&osc)));
+    }
+    printf("  restarted after %d samples, drift %d ± %d ppb (true %.0f)\n", restarted + 1, de.freq_ppb, de.sigma_ppb,
+           osc.ppm * 1000);
+    CHECK(de.valid && fabs(de.freq_ppb - osc.ppm * 1000) < 1000, "drift after step %d ppb", de.freq_ppb);
+}
+
+typedef struct
+{
+    holdover_hw_t parent;
+    osc_t *osc;
+    double corr;       /*!< 对系统时间做过的校正 */
+} sim_sys_t;
+
+static int64_t sim_sys_get(holdover_hw_t *hw)
+{
+    sim_sys_t *s = __containerof(hw, sim_sys_t, parent);
+    return s->osc->now + (int64_t)(s->osc->offset + s->corr);
+}
+
+static void sim_sys_set(holdover_hw_t *hw, int64_t us)
+{
+    sim_sys_t *s = __containerof(hw, sim_sys_t, parent);
+    s->corr = (double)(us - s->osc->now) - s->osc->offset;
+}
+
+static void sim_sys_adjust(holdover_hw_t *hw, int64_t delta_us)
+{
+    __containerof(hw, sim_sys_t, parent)->corr += delta_us;
+}
+
+static esp_err_t sim_rtc_read(holdover_hw_t *hw, int64_t *us)
+{
+    return ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t sim_rtc_write(holdover_hw_t *hw)
+{
+    return ESP_ERR_NOT_FOUND;
+}
+
+/**
+ * @description: 一直联网运行 days 天，adaptive 时按 holdover 给出的间隔同步并持续补偿，否则固定每小时同步
+ * @return       第一天之后的最大误差，us
+ */
+static int64_t closed_loop(bool adaptive, int days, int *polls)
+{
+    holdover_config_t config = HOLDOVER_DEFAULT_CONFIG();
+    config.slew_limit_ms = 0;
+    osc_t osc;
+    osc_init(&osc, OSC_PPM);
+    osc.offset = -(double)osc.now; // 从 1970 年开始
+    sim_sys_t sim = {
+        .parent = {
+            .rtc_read = sim_rtc_read,
+            .rtc_write = sim_rtc_write,
+            .sys_get = sim_sys_get,
+            .sys_set = sim_sys_set,
+            .sys_adjust = sim_sys_adjust,
+        },
+        .osc = &osc,
+    };
+    holdover_state_t state;
+    memset(&state, 0, sizeof(state));
+    holdover_t h;
+    holdover_init(&h, &config, &sim.parent, &state);
+    holdover_boot(&h);
+
+    int64_t worst = 0;
+    int64_t next_poll = 0, next_correct = 0;
+    *polls = 0;
+    for (int64_t t = 0; t < (int64_t)days * DAY_S; t += STEP_S)
+    {
+        if (t >= next_poll)
+        {
+            holdover_on_sntp(&h, osc.now + osc_noise(&osc));
+            holdover_status_t status;
+            holdover_get_status(&h, &status);
+            next_poll = t + (adaptive ? status.poll_s : 3600);
+            (*polls)++;
+        }
+        if (adaptive && t >= next_correct)
+        {
+            holdover_correct(&h);
+            next_correct = t + config.correct_interval_s;
+        }
+        osc_advance(&osc, STEP_S);
+        int64_t err = llabs(sim_sys_get(&sim.parent) - osc.now);
+        if (t >= DAY_S && err > worst)
+        {
+            worst = err;
+        }
+    }
+    return worst;
+}
+
+int main(void)
+{
+    open_loop();
+
+    printf("closed loop, 3 days always online\n");
+    int fixed_polls, adaptive_polls;
+    int64_t fixed = closed_loop(false, 3, &fixed_polls);
+    int64_t adaptive = closed_loop(true, 3, &adaptive_polls);
+    printf("  fixed 1 h poll, step only:      %3d polls, worst error %6lld us\n", fixed_polls, (long long)fixed);
+    printf("  adaptive poll + drift by adjtime: %3d polls, worst error %6lld us\n", adaptive_polls,
+           (long long)adaptive);
+    CHECK(adaptive_polls < fixed_polls, "adaptive polled more often (%d vs %d)", adaptive_polls, fixed_polls);
+    CHECK(adaptive * 2 < fixed, "adaptive error %lld us not below fixed %lld us", (long long)adaptive,
+          (long long)fixed);
+
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * 驱动的性能测量：各工程的驱动代码在模拟的外设上运行，输出每次操作在PC上的 ns
+ *
+ *   oled_char      02_IIC_OLED_ OLED_ShowChar（8x16），另外给出按 100kHz 计算的总线时间
+ *   oled_clear     02_IIC_OLED_ OLED_Clear
+ *   rx8025_get     07_NTP rx8025_get_time，另外给出总线时间
+ *   adc_read       03_ADC_single adc_reader_read（读数和校准换算）
+ *   line_rx        08_uart line_rx 送入一段数据并分出每一行，按行计
+ *   uart_cmd       08_uart cmd_dispatch（分词、查找、参数解析、调用处理函数），按行计
+ *   ws2812         08_uart WS2812 的 RMT 转换函数，按 LED 计
+ *
+ * 总线时间是模拟的 I2C 主机按时钟频率算出的，是真实硬件上的下限，PC上的时间只用于比较驱动代码本身的改动。
+ *
+ * 用法：drv_bench [倍数] [名字...]（名字可以是一部分，不给时全部运行）
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "OLED.h"
+#include "rx8025.h"
+#include "adc_reader.h"
+#include "line_rx.h"
+#include "uart_cmd.h"
+#include "led_strip.h"
+#include "driver/rmt.h"
+#include "ssd1306_sim.h"
+#include "rx8025_sim.h"
+#include "test_util.h"
+
+#define BENCH_CHANNEL RMT_CHANNEL_0
+#define BENCH_LEDS 300
+#define BENCH_REFILL_ITEMS (RMT_SIM_MEM_ITEM_NUM / 2)
+
+typedef struct
+{
+    const char *name;
+    const char *unit;     /*!< 每次操作的单位 */
+    uint32_t iterations;  /*!< 倍数为 1 时的次数 */
+    bool i2c;             /*!< 给出 I2C 总线的时间 */
+    /**
+     * @description: 运行 n 次
+     * @return       操作的个数（按 unit 计）
+     */
+    uint64_t (*run)(uint32_t n);
+} bench_t;
+
+static ssd1306_sim_t s_oled;
+static rx8025_sim_t s_rtc_chip;
+static rx8025_handle_t s_rtc;
+static adc_reader_t s_adc;
+static led_strip_t *s_strip;
+
+/**
+ * @description: 打印 I2C 总线上每次操作的传输次数和时间
+ */
+static void print_bus(uint64_t ops)
+{
+    i2c_sim_stats_t stats;
+    i2c_sim_get_stats(I2C_MASTER_NUM, &stats);
+    printf("  %10.1f us/op on the bus, %.1f transactions\n", stats.bus_ns / 1e3 / ops,
+           (double)stats.transactions / ops);
+}
+
+static uint64_t run_oled_char(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        OLED_ShowChar((i % 16) * 8, (i / 16 % 4) * 2, ' ' + i % 95, 16);
+    }
+    return n;
+}
+
+static uint64_t run_oled_clear(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        OLED_Clear();
+    }
+    return n;
+}
+
+static uint64_t run_rx8025_get(uint32_t n)
+{
+    struct tm tm;
+    esp_err_t ret = ESP_OK;
+    for (uint32_t i = 0; i < n && ret == ESP_OK; i++)
+    {
+        ret = rx8025_get_time(s_rtc, &tm);
+    }
+    CHECK(ret == ESP_OK, "rx8025_get_time");
+    return n;
+}
+
+static uint64_t run_adc_read(uint32_t n)
+{
+    int raw;
+    uint32_t mv;
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        adc_sim_set_input_mv(s_adc.channel, i % 1000);
+        adc_reader_read(&s_adc, &raw, &mv);
+        sum += mv;
+    }
+    CHECK(sum > 0, "adc_reader_read");
+    return n;
+}
+
+static uint64_t run_line_rx(uint32_t n)
+{
+    static uint8_t buf[4096];
+    line_rx_t rx;
+    line_rx_config_t config = LINE_RX_DEFAULT_CONFIG(buf, sizeof(buf));
+    line_rx_init(&rx, &config);
+    // 一次送入约一个 FIFO 的数据，与接收任务一样
+    static const char chunk[] = "rgb 10 20 30\r\nbright 50\r\nred\r\nrgb 255 128 0\r\nclear\r\nfps 60\r\nrainbow\r\n"
+                                "gradient 1 2 3 4 5 6\r\nchase\r\nhelp\r\n";
+    uint64_t lines = 0;
+    size_t len = sizeof(chunk) - 1;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        line_rx_feed(&rx, chunk, len);
+        line_rx_view_t view;
+        while (line_rx_next(&rx, &view))
+        {
+            lines++;
+            line_rx_release(&rx, &view);
+        }
+    }
+    CHECK(lines == (uint64_t)n * 10, "lines %llu", (unsigned long long)lines);
+    return lines;
+}
+
+static esp_err_t count_handler(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    (*(uint32_t *)ctx)++;
+    return ESP_OK;
+}
+
+static const cmd_def_t s_cmds[] = {
+    {"red", "red", {{0}}, count_handler, NULL},
+    {"clear", "turn the LED off", {{0}}, count_handler, NULL},
+    {"rgb", "set any colour", {{"r", 0, 255}, {"g", 0, 255}, {"b", 0, 255}}, count_handler, NULL},
+    {"bright", "brightness in percent", {{"percent", 0, 100}}, count_handler, NULL},
+    {"fps", "frame rate", {{"fps", 1, 200}}, count_handler, NULL},
+    {"help", "list commands", {{0}}, count_handler, NULL},
+};
+
+static uint64_t run_uart_cmd(uint32_t n)
+{
+    static const char *lines[] = {"rgb 10 20 30", "bright 50", "red", "fps 60", "nope"};
+    const size_t count = sizeof(lines) / sizeof(lines[0]);
+    size_t lens[sizeof(lines) / sizeof(lines[0])];
+    for (size_t i = 0; i < count; i++)
+    {
+        lens[i] = strlen(lines[i]);
+    }
+    cmd_table_t table;
+    CHECK(cmd_table_init(&table, s_cmds, sizeof(s_cmds) / sizeof(s_cmds[0])) == ESP_OK, "cmd_table_init");
+    uint32_t calls = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (size_t j = 0; j < count; j++)
+        {
+            cmd_dispatch(&table, (const uint8_t *)lines[j], lens[j], &calls, NULL, 0);
+        }
+    }
+    CHECK(calls == n * (count - 1), "calls %u", calls);
+    return (uint64_t)n * count;
+}
+
+static uint64_t run_ws2812(uint32_t n)
+{
+    static rmt_item32_t mem[BENCH_REFILL_ITEMS + 8];
+    static uint8_t src[BENCH_LEDS * 3];
+    for (size_t i = 0; i < sizeof(src); i++)
+    {
+        src[i] = i * 37;
+    }
+    sample_to_rmt_t fn = rmt_sim_translator(BENCH_CHANNEL);
+    size_t *item_num = rmt_sim_item_num(BENCH_CHANNEL);
+    volatile uint32_t sink = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        // 按中断补数据的方式转换整条灯带
+        const uint8_t *p = src;
+        size_t left = sizeof(src);
+        while (left)
+        {
+            size_t translated = 0;
+            fn(p, mem, left, BENCH_REFILL_ITEMS, &translated, item_num);
+            sink += mem[*item_num - 1].val;
+            p += translated;
+            left -= translated;
+        }
+    }
+    (void)sink;
+    return (uint64_t)n * BENCH_LEDS;
+}
+
+static const bench_t s_benches[] = {
+    {"oled_char", "char", 200, true, run_oled_char},
+    {"oled_clear", "clear", 10, true, run_oled_clear},
+    {"rx8025_get", "read", 2000, true, run_rx8025_get},
+    {"adc_read", "read", 100000, false, run_adc_read},
+    {"line_rx", "line", 20000, false, run_line_rx},
+    {"uart_cmd", "line", 20000, false, run_uart_cmd},
+    {"ws2812", "led", 500, false, run_ws2812},
+};
+
+/**
+ * @description: 外设和设备模型：I2C 上的 OLED 和 RX8025T、ADC1 通道、WS2812 灯带
+ */
+static void bench_setup(void)
+{
+    CHECK(i2c_master_init() == ESP_OK, "i2c_master_init");
+    CHECK(ssd1306_sim_attach(&s_oled, I2C_MASTER_NUM, OLED_ADDR) == ESP_OK, "attach oled");
+    CHECK(rx8025_sim_attach(&s_rtc_chip, I2C_MASTER_NUM, RX8025_I2C_ADDR) == ESP_OK, "attach rx8025");
+    rx8025_config_t config = RX8025_DEFAULT_CONFIG(I2C_MASTER_NUM);
+    CHECK(rx8025_init(&config, &s_rtc, NULL) == ESP_OK, "rx8025_init");
+
+    adc_sim_set_error(30, 20);
+    CHECK(adc_reader_init(&s_adc, ADC1_CHANNEL_2, ADC_ATTEN_DB_11) == ESP_OK && s_adc.calibrated,
+          "adc_reader_init");
+
+    s_strip = led_strip_init(BENCH_CHANNEL, 8, BENCH_LEDS);
+    CHECK(s_strip != NULL, "led_strip_init");
+}
+
+static bool bench_selected(const char *name, int argc, char **argv)
+{
+    if (argc <= 2)
+    {
+        return true;
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        if (strstr(name, argv[i]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t scale = argc > 1 ? (uint32_t)atoi(argv[1]) : 1;
+    if (scale == 0)
+    {
+        scale = 1;
+    }
+
+    bench_setup();
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(s_benches) / sizeof(s_benches[0]); i++)
+    {
+        const bench_t *b = &s_benches[i];
+        if (!bench_selected(b->name, argc, argv))
+        {
+            continue;
+        }
+        printf("%s\n", b->name);
+        // 先运行一次预热缓存
+        b->run(1);
+        i2c_sim_reset_stats(I2C_MASTER_NUM);
+        uint64_t t0 = bench_now_ns();
+        uint64_t ops = b->run(b->iterations * scale);
+        uint64_t dt = bench_now_ns() - t0;
+        printf("  %10.1f ns/%s (%llu)\n", (double)dt / ops, b->unit, (unsigned long long)ops);
+        if (b->i2c)
+        {
+            print_bus(ops);
+        }
+    }
+
+    rx8025_delete(s_rtc);
+    led_strip_denit(s_strip);
+    i2c_driver_delete(I2C_MASTER_NUM);
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
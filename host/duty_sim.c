@@ -0,0 +1,316 @@
+/*
+ * duty_sched 的能耗/时间线模拟（07_NTP/components/duty_cycle）
+ *
+ * 模拟的设备每次唤醒都重新引导（BOOT_MS），调度器的状态只通过"RTC内存"中的 duty_state_t 保留，
+ * 每个操作按功耗模型计入电量：引导、CPU、采样、联网、SNTP、上传和深度睡眠。
+ * 三个任务：每分钟采样一次（本地），定期 SNTP 同步（网络），攒批上传（网络）。
+ * 比较三种策略一天的唤醒次数、联网次数、平均电流和上传延时：
+ *   every wake —— 像原来的例子一样每次醒来都联网同步并上传这一条；
+ *   batched    —— 攒够一批再上传，同步按周期；
+ *   batched + slack —— 网络打开时顺便完成快到期的同步和上传。
+ * 另外模拟一次断网（缓冲区满后丢弃最旧的记录，恢复后全部补传）和一次 RTC 内存丢失。
+ *
+ * 用法：duty_sim [days]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "duty_sched.h"
+#include "test_util.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+// 功耗模型，ESP32-C3 的典型值
+#define SLEEP_UA 8.0         // 深度睡眠，RTC 定时器和 RTC 内存保持
+#define BOOT_MS 45           // 唤醒后 ROM 引导、加载应用、初始化
+#define BOOT_MA 22.0
+#define ACTIVE_MA 24.0       // CPU 运行、醒着等待
+#define SAMPLE_MS 4
+#define RADIO_MA 85.0        // Wi-Fi 收发的平均电流
+#define CONNECT_MS 400       // 直连缓存的 AP、复用地址
+#define SNTP_MS 120
+#define UPLOAD_MS 150        // 一次上传的固定开销
+#define UPLOAD_RECORD_MS 1
+
+#define SAMPLE_PERIOD_S 60
+#define SYNC_PERIOD_S (6 * 3600)
+#define UPLOAD_LATENCY_S 3600
+#define BATTERY_MAH 1000.0
+#define DAY_S 86400LL
+#define TRACE_LINES 14
+
+typedef struct
+{
+    uint32_t t_s;   /*!< 采样时间 */
+    uint32_t seq;   /*!< 采样序号，检查丢失和重复 */
+} sample_record_t;
+
+typedef struct
+{
+    duty_hw_t parent;
+    int64_t now;             /*!< 虚拟时间，us */
+    double charge;           /*!< 消耗的电量，mA·us */
+    double active_us;        /*!< 醒着的时间 */
+    bool net_on;
+    int64_t outage_from;     /*!< 这段时间内联网失败 */
+    int64_t outage_to;
+    bool trace;
+    int trace_lines;
+    // 统计
+    uint32_t sampled;
+    uint32_t uploaded;
+    uint32_t lost;           /*!< 上传时发现的序号缺口 */
+    uint32_t expect_seq;
+    uint32_t syncs;
+    uint32_t cold_starts;    /*!< 第一次上电之外 RTC 内存无效的次数 */
+    int64_t max_latency_us;  /*!< 采样到上传的最长时间 */
+    int64_t max_sync_gap_us; /*!< 两次同步的最长间隔 */
+    int64_t last_sync;
+} sim_t;
+
+static void sim_spend(sim_t *s, int64_t us, double ma)
+{
+    s->now += us;
+    s->charge += us * ma;
+    s->active_us += us;
+}
+
+/**
+ * @description: 打印时间线的前 TRACE_LINES 行，采样只打印开头几次
+ */
+static void sim_trace(sim_t *s, const char *what, bool routine)
+{
+    if (s->trace && s->trace_lines < TRACE_LINES && (!routine || s->trace_lines < 6))
+    {
+        int64_t t = s->now / 1000000;
+        printf("    %02lld:%02lld:%02lld  %s\n", (long long)(t / 3600), (long long)(t / 60 % 60), (long long)(t % 60),
+               what);
+        s->trace_lines++;
+    }
+}
+
+static int64_t sim_now_us(duty_hw_t *hw)
+{
+    return __containerof(hw, sim_t, parent)->now;
+}
+
+static esp_err_t sim_net_up(duty_hw_t *hw)
+{
+    sim_t *s = __containerof(hw, sim_t, parent);
+    sim_spend(s, CONNECT_MS * 1000, RADIO_MA);
+    if (s->now >= s->outage_from && s->now < s->outage_to)
+    {
+        sim_trace(s, "network up failed", false);
+        return ESP_FAIL;
+    }
+    s->net_on = true;
+    sim_trace(s, "network up", false);
+    return ESP_OK;
+}
+
+static void sim_net_down(duty_hw_t *hw)
+{
+    __containerof(hw, sim_t, parent)->net_on = false;
+}
+
+static void sim_delay(duty_hw_t *hw, int64_t us)
+{
+    sim_t *s = __containerof(hw, sim_t, parent);
+    sim_spend(s, us, s->net_on ? RADIO_MA : ACTIVE_MA);
+}
+
+static uint32_t task_sample(duty_t *d, void *arg, uint8_t *data)
+{
+    sim_t *s = (sim_t *)arg;
+    sim_spend(s, SAMPLE_MS * 1000, ACTIVE_MA);
+    // 序号保存在任务的 RTC 状态中，跨越深度睡眠
+    uint32_t seq;
+    memcpy(&seq, data, sizeof(seq));
+    sample_record_t rec = {.t_s = (uint32_t)(s->now / 1000000), .seq = seq++};
+    memcpy(data, &seq, sizeof(seq));
+    duty_push(d, &rec);
+    s->sampled++;
+    sim_trace(s, "sample", true);
+    return 0;
+}
+
+static uint32_t task_sync(duty_t *d, void *arg, uint8_t *data)
+{
+    sim_t *s = (sim_t *)arg;
+    sim_spend(s, SNTP_MS * 1000, RADIO_MA);
+    if (s->syncs && s->now - s->last_sync > s->max_sync_gap_us)
+    {
+        s->max_sync_gap_us = s->now - s->last_sync;
+    }
+    s->last_sync = s->now;
+    s->syncs++;
+    sim_trace(s, "sntp sync", false);
+    return 0;
+}
+
+static uint32_t task_upload(duty_t *d, void *arg, uint8_t *data)
+{
+    sim_t *s = (sim_t *)arg;
+    uint16_t count;
+    const sample_record_t *recs = duty_batch(d, &count);
+    sim_spend(s, (UPLOAD_MS + count * UPLOAD_RECORD_MS) * 1000, RADIO_MA);
+    for (uint16_t i = 0; i < count; i++)
+    {
+        if (recs[i].seq != s->expect_seq)
+        {
+            s->lost += recs[i].seq > s->expect_seq ? recs[i].seq - s->expect_seq : 0;
+        }
+        s->expect_seq = recs[i].seq + 1;
+        int64_t latency = s->now - (int64_t)recs[i].t_s * 1000000;
+        s->max_latency_us = latency > s->max_latency_us ? latency : s->max_latency_us;
+    }
+    s->uploaded += count;
+    duty_consume(d, count);
+    char line[48];
+    snprintf(line, sizeof(line), "upload %u records", count);
+    sim_trace(s, line, false);
+    return 0;
+}
+
+typedef struct
+{
+    const char *name;
+    uint32_t sync_period_s;
+    uint16_t batch_threshold;
+    bool slack;
+} policy_t;
+
+typedef struct
+{
+    uint32_t wakes;
+    uint32_t net_ups;
+    double avg_ua;
+    double active_s;
+} result_t;
+
+/**
+ * @description: 按 policy 运行 days 天，corrupt_at 之后的第一次唤醒时破坏 RTC 内存（0 表示不破坏）
+ */
+static result_t simulate(sim_t *s, const policy_t *p, int days, int64_t corrupt_at)
+{
+    const duty_task_t tasks[] = {
+        {.name = "sample", .kind = DUTY_TASK_LOCAL, .period_s = SAMPLE_PERIOD_S, .slack_s = p->slack ? 5 : 0,
+         .run = task_sample, .arg = s},
+        {.name = "sync", .kind = DUTY_TASK_NETWORK, .period_s = p->sync_period_s,
+         .slack_s = p->slack ? p->sync_period_s / 4 : 0, .run = task_sync, .arg = s},
+        {.name = "upload", .kind = DUTY_TASK_UPLOAD, .period_s = UPLOAD_LATENCY_S,
+         .slack_s = p->slack ? UPLOAD_LATENCY_S : 0, .run = task_upload, .arg = s},
+    };
+    duty_config_t config = DUTY_DEFAULT_CONFIG(tasks, 3, sizeof(sample_record_t));
+    config.batch_threshold = p->batch_threshold;
+    config.net_retry_s = 900;
+    s->parent.now_us = sim_now_us;
+    s->parent.net_up = sim_net_up;
+    s->parent.net_down = sim_net_down;
+    s->parent.delay = sim_delay;
+
+    static duty_state_t rtc_state; // "RTC 内存"：唤醒之间只有它保留
+    memset(&rtc_state, 0xA5, sizeof(rtc_state)); // 上电时内容随机
+    bool corrupted = false;
+    while (s->now < days * DAY_S * 1000000)
+    {
+        if (corrupt_at && !corrupted && s->now >= corrupt_at)
+        {
+            rtc_state.batch[0] ^= 0xFF;
+            corrupted = true;
+        }
+        sim_spend(s, BOOT_MS * 1000, BOOT_MA);
+        duty_t d;
+        duty_init(&d, &config, &s->parent, &rtc_state);
+        if (d.cold && s->now > BOOT_MS * 1000)
+        {
+            s->cold_starts++;
+            sim_trace(s, "rtc memory lost, cold start", false);
+        }
+        int64_t sleep_us = duty_run(&d);
+        s->now += sleep_us;
+        s->charge += sleep_us * (SLEEP_UA / 1000);
+    }
+    result_t r = {
+        .wakes = rtc_state.wakes,
+        .net_ups = rtc_state.net_ups,
+        .avg_ua = s->charge / s->now * 1000,
+        .active_s = s->active_us / 1e6,
+    };
+    return r;
+}
+
+static void print_result(const policy_t *p, const sim_t *s, const result_t *r, int days)
+{
+    printf("  %-16s %6u %6u %8.1f %8.0f %8.0f %10.1f %6u\n", p->name, r->wakes, r->net_ups, r->active_s,
+           r->avg_ua, BATTERY_MAH / (r->avg_ua / 1000) / 24, s->max_latency_us / 60e6, s->syncs);
+}
+
+int main(int argc, char **argv)
+{
+    int days = argc > 1 ? atoi(argv[1]) : 2;
+    days = days < 1 ? 1 : days;
+    const policy_t policies[] = {
+        {.name = "every wake", .sync_period_s = SAMPLE_PERIOD_S, .batch_threshold = 1, .slack = false},
+        {.name = "batched", .sync_period_s = SYNC_PERIOD_S, .batch_threshold = 32, .slack = false},
+        {.name = "batched + slack", .sync_period_s = SYNC_PERIOD_S, .batch_threshold = 32, .slack = true},
+    };
+    result_t results[3];
+    sim_t sims[3];
+
+    printf("timeline, batched + slack:\n");
+    for (int i = 0; i < 3; i++)
+    {
+        memset(&sims[i], 0, sizeof(sims[i]));
+        sims[i].trace = i == 2;
+        results[i] = simulate(&sims[i], &policies[i], days, 0);
+    }
+    printf("%d day(s), sample every %d s, %.0f mAh battery:\n", days, SAMPLE_PERIOD_S, BATTERY_MAH);
+    printf("  %-16s %6s %6s %8s %8s %8s %10s %6s\n", "policy", "wakes", "radio", "active s", "avg uA", "life d",
+           "latency m", "syncs");
+    for (int i = 0; i < 3; i++)
+    {
+        print_result(&policies[i], &sims[i], &results[i], days);
+        const sim_t *s = &sims[i];
+        CHECK(s->lost == 0, "%s: %u samples lost", policies[i].name, s->lost);
+        CHECK(s->uploaded + 32 >= s->sampled, "%s: only %u of %u uploaded", policies[i].name, s->uploaded, s->sampled);
+        CHECK(s->max_latency_us <= (UPLOAD_LATENCY_S + 2 * SAMPLE_PERIOD_S) * 1000000LL, "%s: latency %lld s",
+              policies[i].name, (long long)(s->max_latency_us / 1000000));
+        CHECK(s->max_sync_gap_us <= (int64_t)(policies[i].sync_period_s + SAMPLE_PERIOD_S) * 1000000,
+              "%s: sync gap %lld s", policies[i].name, (long long)(s->max_sync_gap_us / 1000000));
+    }
+    int64_t samples = days * DAY_S / SAMPLE_PERIOD_S;
+    CHECK(results[2].wakes <= samples + samples / 20, "batched + slack woke %u times for %lld samples",
+          results[2].wakes, (long long)samples);
+    CHECK(results[2].net_ups < results[1].net_ups, "slack did not merge network work (%u vs %u)", results[2].net_ups,
+          results[1].net_ups);
+    CHECK(results[2].avg_ua * 4 < results[0].avg_ua, "batched %.0f uA not well below every-wake %.0f uA",
+          results[2].avg_ua, results[0].avg_ua);
+
+    // 断网 3 小时：缓冲区满后丢弃最旧的记录，每 net_retry_s 重试，恢复后补传
+    printf("3 h network outage, then rtc memory lost:\n");
+    sim_t s;
+    memset(&s, 0, sizeof(s));
+    s.outage_from = 6 * 3600 * 1000000LL;
+    s.outage_to = 9 * 3600 * 1000000LL;
+    result_t r = simulate(&s, &policies[2], 1, 0);
+    uint32_t capacity = DUTY_BATCH_BYTES / sizeof(sample_record_t);
+    printf("  %u sampled, %u uploaded, %u lost (buffer %u records), %u radio ups\n", s.sampled, s.uploaded, s.lost,
+           capacity, r.net_ups);
+    CHECK(s.lost > 0 && s.lost <= 3 * 3600 / SAMPLE_PERIOD_S - capacity + 32, "lost %u in outage", s.lost);
+    CHECK(s.uploaded + s.lost + 32 >= s.sampled, "not caught up after outage");
+
+    memset(&s, 0, sizeof(s));
+    r = simulate(&s, &policies[2], 1, 12 * 3600 * 1000000LL);
+    printf("  %u cold start(s) mid-day: %u sampled, %u uploaded, %u syncs\n", s.cold_starts, s.sampled, s.uploaded,
+           s.syncs);
+    CHECK(s.cold_starts == 1, "%u cold starts", s.cold_starts);
+    CHECK(s.uploaded + 32 + 32 >= s.sampled, "too many records lost with rtc memory (%u of %u)", s.uploaded,
+          s.sampled);
+
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/*
+ * 双缓冲刷新和帧率控制的测试（08_uart/main/led_strip_rmt_ws2812.c、08_uart/components/frame_pacer）
+ *
+ * 帧率控制：虚拟时间上检查每一帧的开始时间、错过的帧和统计。
+ * 双缓冲：在模拟的 RMT 通道上 present() 后立即改写后缓冲区，发出的仍是 present 时的一帧；
+ * 后缓冲区从刚发出的一帧开始；每一帧发完调用一次完成回调。
+ * 流水线：300 个 LED（每帧发送约 9.7 ms），60 帧/秒，每帧渲染 12 ms，
+ * 比较 refresh()（渲染和发送依次进行）和 present()（发送与下一帧的渲染同时进行）错过的帧。
+ *
+ * 用法：frame_pacer_test [帧数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "esp_timer.h"
+#include "driver/rmt.h"
+#include "led_strip.h"
+#include "frame_pacer.h"
+#include "test_util.h"
+
+#define TEST_CHANNEL RMT_CHANNEL_0
+#define TEST_LEDS 300
+#define TEST_FPS 60
+#define TEST_RENDER_US 12000
+
+static atomic_int s_done_count;
+
+static void sleep_us(int64_t us)
+{
+    if (us > 0)
+    {
+        struct timespec ts = {us / 1000000, (us % 1000000) * 1000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void on_done(led_strip_t *strip, void *arg)
+{
+    atomic_fetch_add(&s_done_count, 1);
+}
+
+/**
+ * @description: 从发出的 RMT 数据取回一个字节（高电平比低电平长为 1）
+ */
+static int decode_byte(const rmt_item32_t *items)
+{
+    int value = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        value = (value << 1) | (items[i].duration0 > items[i].duration1);
+    }
+    return value;
+}
+
+/**
+ * @description: 发出的第 index 个 LED 的颜色（GRB）是否为 r、g、b
+ */
+static bool sent_pixel_is(uint32_t index, int r, int g, int b)
+{
+    size_t num = 0;
+    const rmt_item32_t *items = rmt_sim_items(TEST_CHANNEL, &num);
+    if (!items || (index + 1) * 24 > num)
+    {
+        return false;
+    }
+    const rmt_item32_t *p = items + index * 24;
+    return decode_byte(p) == g && decode_byte(p + 8) == r && decode_byte(p + 16) == b;
+}
+
+static void test_pacer(void)
+{
+    printf("pacer on virtual time\n");
+    frame_pacer_t p;
+    CHECK(frame_pacer_init(&p, 0, 0) == ESP_ERR_INVALID_ARG, "fps 0");
+    CHECK(frame_pacer_init(&p, 100, 0) == ESP_OK, "init");
+    CHECK(frame_pacer_wait_us(&p, 0) == 0, "first frame starts now");
+    CHECK(frame_pacer_begin(&p, 0) == 0, "first frame");
+    frame_pacer_end(&p, 3000);
+    CHECK(frame_pacer_wait_us(&p, 3000) == 7000, "wait %lld", (long long)frame_pacer_wait_us(&p, 3000));
+    CHECK(frame_pacer_begin(&p, 10000) == 0, "second frame on time");
+    // 工作了 25 ms：20 ms 的时间点错过，这一帧算在 30 ms，晚了 5 ms
+    frame_pacer_end(&p, 35000);
+    CHECK(frame_pacer_wait_us(&p, 35000) == 0, "late, no wait");
+    CHECK(frame_pacer_begin(&p, 35000) == 1, "one frame missed");
+    CHECK(p.next_us == 40000, "next at %lld", (long long)p.next_us);
+    frame_pacer_end(&p, 36000);
+    CHECK(p.stats.frames == 3 && p.stats.dropped == 1, "frames %u dropped %u", p.stats.frames, p.stats.dropped);
+    CHECK(p.stats.late_max_us == 5000, "late max %u", p.stats.late_max_us);
+    CHECK(p.stats.work_max_us == 25000 && p.stats.work_total_us == 29000, "work max %u total %llu", p.stats.work_max_us,
+          (unsigned long long)p.stats.work_total_us);
+    // 比预定的早开始，不算晚
+    CHECK(frame_pacer_begin(&p, 38000) == 0 && p.next_us == 50000, "early begin");
+
+    char line[128];
+    frame_pacer_format(&p, line, sizeof(line));
+    printf("  %s", line);
+    CHECK(strstr(line, "fps 100 frames 4 dropped 1 (20.0%)") != NULL, "format");
+
+    CHECK(frame_pacer_set_fps(&p, 50, 100000) == ESP_OK && p.period_us == 20000 && p.next_us == 100000, "set fps");
+    frame_pacer_reset_stats(&p);
+    CHECK(p.stats.frames == 0 && p.stats.dropped == 0, "reset");
+}
+
+static void test_double_buffer(led_strip_t *strip)
+{
+    printf("double buffer\n");
+    atomic_store(&s_done_count, 0);
+    CHECK(led_strip_set_done_callback(strip, on_done, NULL) == ESP_OK, "set callback");
+
+    for (uint32_t i = 0; i < TEST_LEDS; i++)
+    {
+        strip->set_pixel(strip, i, 10, 20, 30);
+    }
+    CHECK(strip->present(strip) == ESP_OK, "present");
+    // 发送中改写后缓冲区，不影响发出的数据
+    for (uint32_t i = 0; i < TEST_LEDS; i++)
+    {
+        strip->set_pixel(strip, i, 200, 100, 50);
+    }
+    CHECK(strip->wait_done(strip, 100) == ESP_OK, "wait_done");
+    CHECK(sent_pixel_is(0, 10, 20, 30) && sent_pixel_is(TEST_LEDS - 1, 10, 20, 30), "frame changed while sending");
+    CHECK(atomic_load(&s_done_count) == 1, "done count %d", atomic_load(&s_done_count));
+
+    CHECK(strip->present(strip) == ESP_OK, "present");
+    CHECK(strip->wait_done(strip, 100) == ESP_OK, "wait_done");
+    CHECK(sent_pixel_is(0, 200, 100, 50) && sent_pixel_is(TEST_LEDS - 1, 200, 100, 50), "second frame");
+
+    // 后缓冲区从刚发出的一帧开始，只改一个 LED
+    strip->set_pixel(strip, 5, 1, 2, 3);
+    CHECK(strip->refresh(strip, 100) == ESP_OK, "refresh");
+    CHECK(sent_pixel_is(5, 1, 2, 3) && sent_pixel_is(4, 200, 100, 50) && sent_pixel_is(6, 200, 100, 50),
+          "back buffer starts from the last frame");
+    CHECK(atomic_load(&s_done_count) == 3, "done count %d", atomic_load(&s_done_count));
+
+    CHECK(led_strip_set_done_callback(strip, NULL, NULL) == ESP_OK, "remove callback");
+}
+
+/**
+ * @description: 按帧率运行 frames 个时间点，每帧渲染 TEST_RENDER_US
+ * @param {bool} async true 用 present()，false 用 refresh()
+ */
+static frame_pacer_stats_t run_pipeline(led_strip_t *strip, bool async, uint32_t frames)
+{
+    frame_pacer_t p;
+    frame_pacer_init(&p, TEST_FPS, esp_timer_get_time());
+    uint32_t step = 0;
+    while (p.stats.frames + p.stats.dropped < frames)
+    {
+        sleep_us(frame_pacer_wait_us(&p, esp_timer_get_time()));
+        int64_t begin = esp_timer_get_time();
+        step += 1 + frame_pacer_begin(&p, begin);
+        for (uint32_t i = 0; i < TEST_LEDS; i++)
+        {
+            strip->set_pixel(strip, i, (i + step) & 0xFF, step & 0xFF, 0);
+        }
+        // 其余的渲染时间
+        sleep_us(begin + TEST_RENDER_US - esp_timer_get_time());
+        if (async)
+        {
+            strip->present(strip);
+        }
+        else
+        {
+            strip->refresh(strip, 100);
+        }
+        frame_pacer_end(&p, esp_timer_get_time());
+    }
+    strip->wait_done(strip, 100);
+    char line[128];
+    frame_pacer_format(&p, line, sizeof(line));
+    printf("  %-8s %s", async ? "present" : "refresh", line);
+    return p.stats;
+}
+
+static void test_pipeline(led_strip_t *strip, uint32_t frames)
+{
+    printf("%u leds at %u fps, %u us render, %u frames\n", TEST_LEDS, TEST_FPS, TEST_RENDER_US, frames);
+    frame_pacer_stats_t blocking = run_pipeline(strip, false, frames);
+    frame_pacer_stats_t overlapped = run_pipeline(strip, true, frames);
+    // 依次进行时每帧约 21.7 ms，超过 16.7 ms 的帧间隔
+    CHECK(blocking.dropped >= frames / 8, "refresh dropped only %u", blocking.dropped);
+    CHECK(overlapped.dropped <= frames / 30, "present dropped %u", overlapped.dropped);
+    // 最长的一帧受PC上调度的影响，只检查平均值
+    uint32_t work_avg = (uint32_t)(overlapped.work_total_us / overlapped.frames);
+    CHECK(work_avg < 1000000 / TEST_FPS, "present work avg %u us", work_avg);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = argc > 1 ? (uint32_t)atoi(argv[1]) : 60;
+    if (frames < 30)
+    {
+        frames = 30;
+    }
+
+    test_pacer();
+
+    led_strip_t *strip = led_strip_init(TEST_CHANNEL, 8, TEST_LEDS);
+    CHECK(strip != NULL, "led_strip_init");
+    if (strip)
+    {
+        test_double_buffer(strip);
+        test_pipeline(strip, frames);
+        CHECK(led_strip_denit(strip) == ESP_OK, "led_strip_denit");
+    }
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
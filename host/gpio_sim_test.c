@@ -0,0 +1,147 @@
+/*
+ * 模拟的 GPIO 的测试，按 04_generic_gpio 的用法：中断处理函数把引脚号发到队列，任务中读电平
+ *
+ * 中断：上升沿、双边沿、低电平各自触发的次数，删除处理函数后不再触发，没有安装中断服务时不能添加；
+ * 输出：电平和翻转次数，开漏输出与外部电平线与，输入关闭时读到 0；悬空的输入按上拉读到 1。
+ *
+ * 用法：gpio_sim_test
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "driver/gpio.h"
+#include "test_util.h"
+
+#define GPIO_OUTPUT_IO_0 18
+#define GPIO_OUTPUT_IO_1 19
+#define GPIO_INPUT_IO_0 4
+#define GPIO_INPUT_IO_1 5
+#define GPIO_KEY 13
+
+static QueueHandle_t s_evt_queue;
+
+static void gpio_isr_handler(void *arg)
+{
+    uint32_t gpio_num = (uint32_t)(uintptr_t)arg;
+    xQueueSendFromISR(s_evt_queue, &gpio_num, NULL);
+}
+
+/**
+ * @description: 取出队列中引脚 gpio_num 的事件个数，其它引脚的事件也取出
+ */
+static int take_events(uint32_t gpio_num)
+{
+    int n = 0;
+    uint32_t io;
+    while (xQueueReceive(s_evt_queue, &io, 0) == pdTRUE)
+    {
+        n += io == gpio_num;
+    }
+    return n;
+}
+
+static void test_interrupts(void)
+{
+    printf("interrupts\n");
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_POSEDGE,
+        .pin_bit_mask = BIT64(GPIO_INPUT_IO_0) | BIT64(GPIO_INPUT_IO_1),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = 1,
+    };
+    CHECK(gpio_config(&io_conf) == ESP_OK, "gpio_config inputs");
+    CHECK(gpio_set_intr_type(GPIO_INPUT_IO_0, GPIO_INTR_ANYEDGE) == ESP_OK, "set_intr_type");
+
+    CHECK(gpio_isr_handler_add(GPIO_INPUT_IO_0, gpio_isr_handler, (void *)GPIO_INPUT_IO_0) == ESP_ERR_INVALID_STATE,
+          "handler without isr service");
+    CHECK(gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT) == ESP_OK, "install isr service");
+    CHECK(gpio_isr_handler_add(GPIO_INPUT_IO_0, gpio_isr_handler, (void *)GPIO_INPUT_IO_0) == ESP_OK, "add 0");
+    CHECK(gpio_isr_handler_add(GPIO_INPUT_IO_1, gpio_isr_handler, (void *)GPIO_INPUT_IO_1) == ESP_OK, "add 1");
+
+    // 上拉，悬空时为高
+    CHECK(gpio_get_level(GPIO_INPUT_IO_0) == 1, "pulled up");
+    for (int i = 0; i < 3; i++)
+    {
+        gpio_sim_set_input(GPIO_INPUT_IO_0, 0);
+        gpio_sim_set_input(GPIO_INPUT_IO_0, 1);
+        gpio_sim_set_input(GPIO_INPUT_IO_1, 0);
+        gpio_sim_set_input(GPIO_INPUT_IO_1, 1);
+    }
+    // 电平不变不触发
+    gpio_sim_set_input(GPIO_INPUT_IO_1, 1);
+    CHECK(uxQueueMessagesWaiting(s_evt_queue) == 9, "events %u", (unsigned)uxQueueMessagesWaiting(s_evt_queue));
+    uint32_t first;
+    CHECK(xQueueReceive(s_evt_queue, &first, 0) == pdTRUE && first == GPIO_INPUT_IO_0, "first event from %u",
+          first);
+    CHECK(take_events(GPIO_INPUT_IO_0) == 5, "anyedge");
+    gpio_sim_set_input(GPIO_INPUT_IO_1, 0);
+    gpio_sim_set_input(GPIO_INPUT_IO_1, 1);
+    CHECK(take_events(GPIO_INPUT_IO_1) == 1, "posedge");
+
+    // 按键：低电平中断，按住时每次检查都触发
+    gpio_reset_pin(GPIO_KEY);
+    CHECK(gpio_set_direction(GPIO_KEY, GPIO_MODE_INPUT) == ESP_OK, "key input");
+    CHECK(gpio_set_intr_type(GPIO_KEY, GPIO_INTR_LOW_LEVEL) == ESP_OK, "key low level");
+    CHECK(gpio_isr_handler_add(GPIO_KEY, gpio_isr_handler, (void *)GPIO_KEY) == ESP_OK, "add key");
+    gpio_sim_set_input(GPIO_KEY, 0);
+    gpio_sim_set_input(GPIO_KEY, 0);
+    gpio_sim_set_input(GPIO_KEY, 1);
+    CHECK(take_events(GPIO_KEY) == 2, "low level");
+
+    CHECK(gpio_isr_handler_remove(GPIO_INPUT_IO_0) == ESP_OK, "remove");
+    gpio_sim_set_input(GPIO_INPUT_IO_0, 0);
+    CHECK(uxQueueMessagesWaiting(s_evt_queue) == 0, "removed handler");
+    gpio_uninstall_isr_service();
+}
+
+static void test_outputs(void)
+{
+    printf("outputs\n");
+    gpio_config_t io_conf = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = GPIO_MODE_OUTPUT,
+        .pin_bit_mask = BIT64(GPIO_OUTPUT_IO_0) | BIT64(GPIO_OUTPUT_IO_1),
+    };
+    CHECK(gpio_config(&io_conf) == ESP_OK, "gpio_config outputs");
+    uint32_t toggles = gpio_sim_get_toggles(GPIO_OUTPUT_IO_0);
+    for (int i = 0; i < 10; i++)
+    {
+        gpio_set_level(GPIO_OUTPUT_IO_0, i % 2);
+    }
+    gpio_set_level(GPIO_OUTPUT_IO_1, 1);
+    CHECK(gpio_sim_get_toggles(GPIO_OUTPUT_IO_0) - toggles == 9, "toggles %u",
+          gpio_sim_get_toggles(GPIO_OUTPUT_IO_0) - toggles);
+    CHECK(gpio_sim_get_output(GPIO_OUTPUT_IO_0) == 1 && gpio_sim_get_output(GPIO_OUTPUT_IO_1) == 1, "levels");
+    // 输入关闭
+    CHECK(gpio_get_level(GPIO_OUTPUT_IO_1) == 0, "output only reads 0");
+
+    // 开漏，总线上有外部的上拉电阻，其它设备拉低时读到 0
+    CHECK(gpio_set_direction(GPIO_OUTPUT_IO_1, GPIO_MODE_INPUT_OUTPUT_OD) == ESP_OK, "open drain");
+    gpio_sim_set_input(GPIO_OUTPUT_IO_1, 1);
+    CHECK(gpio_get_level(GPIO_OUTPUT_IO_1) == 1, "released line");
+    gpio_sim_set_input(GPIO_OUTPUT_IO_1, 0);
+    CHECK(gpio_get_level(GPIO_OUTPUT_IO_1) == 0, "pulled low by another device");
+    gpio_sim_set_input(GPIO_OUTPUT_IO_1, 1);
+    gpio_set_level(GPIO_OUTPUT_IO_1, 0);
+    CHECK(gpio_get_level(GPIO_OUTPUT_IO_1) == 0, "driven low");
+
+    CHECK(gpio_set_level(GPIO_NUM_MAX, 1) == ESP_ERR_INVALID_ARG, "bad pin");
+    io_conf.pin_bit_mask = BIT64(GPIO_NUM_MAX);
+    CHECK(gpio_config(&io_conf) == ESP_ERR_INVALID_ARG, "bad mask");
+}
+
+int main(void)
+{
+    s_evt_queue = xQueueCreate(16, sizeof(uint32_t));
+    test_interrupts();
+    test_outputs();
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * 延迟统计的测试和性能测量（08_uart/components/lat_trace）
+ *
+ * 直方图：随机的延迟（几 us 到几百 ms）与排序后的准确百分位数比较，误差不超过一格（25%）；
+ * 格式化的输出；每加入一个事件（4 个时间点）的耗时。
+ * 再用两个线程模拟 08_uart 中命令到 LED 的流水线：接收线程每隔 3~23 ms 放入一条命令，
+ * LED 线程按原来的方式（每次等 10 ms、处理后再睡 10 ms）和阻塞等待的方式取出，比较两者的延迟。
+ *
+ * 用法：lat_trace_test [命令数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include "lat_trace.h"
+#include "test_util.h"
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us)
+{
+    struct timespec ts = {us / 1000000, (us % 1000000) * 1000};
+    nanosleep(&ts, NULL);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void test_hist(void)
+{
+    enum { N = 20000 };
+    static uint32_t values[N];
+    lat_hist_t h;
+    lat_hist_reset(&h);
+    CHECK(lat_hist_percentile(&h, 50) == 0, "empty histogram");
+    uint32_t seed = 1;
+    for (int i = 0; i < N; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        // 对数分布：0 ~ 约 500 ms
+        values[i] = (seed >> 8) % (1u << ((seed >> 3) % 19 + 1));
+        lat_hist_add(&h, values[i]);
+    }
+    qsort(values, N, sizeof(values[0]), cmp_u32);
+    static const uint8_t pcts[] = {1, 10, 50, 90, 99, 100};
+    for (size_t i = 0; i < sizeof(pcts); i++)
+    {
+        uint32_t exact = values[((uint64_t)N * pcts[i] + 99) / 100 - 1];
+        uint32_t got = lat_hist_percentile(&h, pcts[i]);
+        // 所在格的上限：不小于准确值，超出不到一格
+        CHECK(got >= exact && (got <= 8 || got <= exact + exact / 4 + 1 || got == h.max_us),
+              "p%u: %u vs exact %u", pcts[i], got, exact);
+    }
+    CHECK(h.min_us == values[0] && h.max_us == values[N - 1], "min/max");
+    CHECK(lat_hist_percentile(&h, 100) == h.max_us, "p100 is not the maximum");
+
+    // 相同的值：百分位数就是它
+    lat_hist_reset(&h);
+    for (int i = 0; i < 100; i++)
+    {
+        lat_hist_add(&h, 1500);
+    }
+    CHECK(lat_hist_percentile(&h, 50) == 1500 && lat_hist_percentile(&h, 99) == 1500, "constant: %u",
+          lat_hist_percentile(&h, 50));
+}
+
+static void test_trace(void)
+{
+    static const char *const names[] = {"parse", "queue", "refresh"};
+    lat_trace_t t;
+    lat_trace_init(&t, names, 4);
+    const int64_t stamps[] = {1000, 1040, 1100, 1400};
+    lat_trace_record(&t, stamps);
+    CHECK(t.hist[0].max_us == 40 && t.hist[1].max_us == 60 && t.hist[2].max_us == 300 && t.hist[3].max_us == 400,
+          "intervals");
+    char buf[512];
+    size_t n = lat_trace_format(&t, buf, sizeof(buf));
+    CHECK(n == strlen(buf) && strstr(buf, "total") && strstr(buf, "refresh"), "format");
+    // 缓冲区不够时截断，仍以 '\0' 结尾
+    char small[32];
+    n = lat_trace_format(&t, small, sizeof(small));
+    CHECK(n == sizeof(small) - 1 && strlen(small) == n, "truncated format");
+
+    const int rounds = 1000000;
+    int64_t s[4] = {0};
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < rounds; i++)
+    {
+        s[1] = s[0] + (i & 63);
+        s[2] = s[1] + (i & 1023);
+        s[3] = s[2] + 30 + (i & 7);
+        lat_trace_record(&t, s);
+    }
+    double ns = (double)(bench_now_ns() - start) / rounds;
+    printf("record   %.1f ns per event (4 time points)\n", ns);
+}
+
+/* 命令队列，相当于 xQueue_UART2WS2812 */
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int64_t items[16][2]; /*!< 收到的时间、放入的时间 */
+    int head;
+    int count;
+    bool done;
+} sim_queue_t;
+
+typedef struct
+{
+    sim_queue_t q;
+    bool polling;      /*!< 原来的方式 */
+    uint32_t commands;
+    lat_trace_t trace;
+} sim_pipeline_t;
+
+/**
+ * @description: 取一条命令，最多等 timeout_us（<0 一直等）
+ */
+static bool sim_receive(sim_queue_t *q, int64_t *item, int64_t timeout_us)
+{
+    pthread_mutex_lock(&q->lock);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t ns = ts.tv_nsec + (timeout_us > 0 ? timeout_us : 0) * 1000;
+    ts.tv_sec += ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    while (!q->count && !q->done)
+    {
+        if (timeout_us < 0)
+        {
+            pthread_cond_wait(&q->cond, &q->lock);
+        }
+        else if (pthread_cond_timedwait(&q->cond, &q->lock, &ts) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    bool got = q->count > 0;
+    if (got)
+    {
+        memcpy(item, q->items[q->head], sizeof(q->items[0]));
+        q->head = (q->head + 1) % 16;
+        q->count--;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return got;
+}
+
+static void *sim_led_thread(void *arg)
+{
+    sim_pipeline_t *p = arg;
+    int64_t item[2];
+    while (1)
+    {
+        bool got = sim_receive(&p->q, item, p->polling ? 10000 : -1);
+        if (got)
+        {
+            int64_t stamps[4] = {item[0], item[1], now_us()};
+            // RMT 发 24 位约 30 us
+            while (now_us() - stamps[2] < 30)
+            {
+            }
+            stamps[3] = now_us();
+            lat_trace_record(&p->trace, stamps);
+        }
+        else if (p->q.done)
+        {
+            return NULL;
+        }
+        if (p->polling)
+        {
+            sleep_us(10000);
+        }
+    }
+}
+
+static void sim_pipeline(sim_pipeline_t *p)
+{
+    static const char *const names[] = {"parse", "queue", "refresh"};
+    pthread_mutex_init(&p->q.lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&p->q.cond, &attr);
+    lat_trace_init(&p->trace, names, 4);
+    pthread_t led;
+    pthread_create(&led, NULL, sim_led_thread, p);
+    uint32_t seed = 7;
+    for (uint32_t i = 0; i < p->commands; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        sleep_us(3000 + (seed >> 8) % 20000);
+        int64_t rx = now_us();
+        // 查命令表约 30 ns，这里忽略
+        pthread_mutex_lock(&p->q.lock);
+        if (p->q.count < 16)
+        {
+            p->q.items[(p->q.head + p->q.count) % 16][0] = rx;
+            p->q.items[(p->q.head + p->q.count) % 16][1] = now_us();
+            p->q.count++;
+            pthread_cond_signal(&p->q.cond);
+        }
+        pthread_mutex_unlock(&p->q.lock);
+    }
+    pthread_mutex_lock(&p->q.lock);
+    p->q.done = true;
+    pthread_cond_signal(&p->q.cond);
+    pthread_mutex_unlock(&p->q.lock);
+    pthread_join(led, NULL);
+}
+
+static void test_pipeline(uint32_t commands)
+{
+    static sim_pipeline_t polling, blocking;
+    polling.polling = true;
+    polling.commands = commands;
+    blocking.commands = commands;
+    sim_pipeline(&polling);
+    sim_pipeline(&blocking);
+    char buf[512];
+    lat_trace_format(&polling.trace, buf, sizeof(buf));
+    printf("polling (10 ms receive + 10 ms delay), %u of %u commands:\n%s", polling.trace.hist[3].count, commands, buf);
+    lat_trace_format(&blocking.trace, buf, sizeof(buf));
+    printf("blocking:\n%s", buf);
+    const lat_hist_t *slow = &polling.trace.hist[3], *fast = &blocking.trace.hist[3];
+    CHECK(fast->count == commands, "blocking: %u of %u commands", fast->count, commands);
+    CHECK(lat_hist_percentile(fast, 50) * 4 < lat_hist_percentile(slow, 50), "blocking p50 %u us vs polling %u us",
+          lat_hist_percentile(fast, 50), lat_hist_percentile(slow, 50));
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t commands = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 200;
+    test_hist();
+    test_trace();
+    test_pipeline(commands);
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,323 @@
+/*
+ * LED 灯效的测试和性能测量（08_uart/components/led_fx）
+ *
+ * 检查 HSV 的基色、混合的两端、亮度/伽马表的两端和单调性，渐变、追逐、淡入淡出的像素，
+ * 以及时间线的切换、过渡和循环。
+ * 再对每种效果渲染整条灯带，和查表输出一起测量每个 LED 的耗时；
+ * 与用浮点数（HSV 和 powf 伽马校正）的实现比较彩虹加输出的耗时。
+ *
+ * 用法：led_fx_bench [LED数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include "led_fx.h"
+#include "test_util.h"
+
+// 每个 LED 渲染加输出的上限（ns），远大于实际值，只用于发现退化
+#define BENCH_LIMIT_NS 200.0
+
+static volatile uint8_t s_sink;
+
+static bool rgb_is(fx_rgb_t c, int r, int g, int b)
+{
+    return c.r == r && c.g == g && c.b == b;
+}
+
+static void test_color(void)
+{
+    printf("hsv, blend, lut\n");
+    CHECK(rgb_is(fx_hsv(0, 255, 255), 255, 0, 0), "red");
+    CHECK(rgb_is(fx_hsv(512, 255, 255), 0, 255, 0), "green");
+    CHECK(rgb_is(fx_hsv(1024, 255, 255), 0, 0, 255), "blue");
+    CHECK(rgb_is(fx_hsv(256, 255, 255), 255, 255, 0), "yellow");
+    CHECK(rgb_is(fx_hsv(FX_HUE_MAX + 512, 255, 255), 0, 255, 0), "hue wraps");
+    CHECK(rgb_is(fx_hsv(700, 0, 200), 200, 200, 200), "no saturation");
+    CHECK(rgb_is(fx_hsv(300, 255, 0), 0, 0, 0), "no value");
+    // 相邻的色相变化不超过 1
+    fx_rgb_t prev = fx_hsv(0, 255, 255);
+    int jump = 0;
+    for (int h = 1; h <= FX_HUE_MAX; h++)
+    {
+        fx_rgb_t c = fx_hsv(h, 255, 255);
+        jump += abs(c.r - prev.r) > 1 || abs(c.g - prev.g) > 1 || abs(c.b - prev.b) > 1;
+        prev = c;
+    }
+    CHECK(jump == 0, "%d hue steps jump", jump);
+
+    fx_rgb_t a = {10, 200, 0};
+    fx_rgb_t b = {250, 0, 100};
+    CHECK(rgb_is(fx_blend(a, b, 0), 10, 200, 0), "blend 0");
+    CHECK(rgb_is(fx_blend(a, b, 255), 250, 0, 100), "blend 255");
+    fx_rgb_t m = fx_blend(a, b, 128);
+    CHECK(abs(m.r - 130) <= 1 && abs(m.g - 100) <= 1 && abs(m.b - 50) <= 1, "blend 128: %d %d %d", m.r, m.g, m.b);
+
+    fx_lut_t lut;
+    fx_lut_build(&lut, 255, false);
+    bool identity = true;
+    for (int i = 0; i < 256; i++)
+    {
+        identity &= lut.v[i] == i;
+    }
+    CHECK(identity, "linear lut at full brightness");
+    fx_lut_build(&lut, 127, false);
+    CHECK(lut.v[0] == 0 && lut.v[255] == 127 && lut.v[128] == 64, "linear lut at half");
+    fx_lut_build(&lut, 255, true);
+    bool monotonic = true;
+    for (int i = 1; i < 256; i++)
+    {
+        monotonic &= lut.v[i] >= lut.v[i - 1];
+    }
+    CHECK(monotonic && lut.v[0] == 0 && lut.v[255] == 255, "gamma lut");
+    CHECK(abs(lut.v[128] - 56) <= 1, "gamma 128 -> %d", lut.v[128]);
+    fx_lut_build(&lut, 50, true);
+    CHECK(lut.v[255] == 50 && lut.v[1] == 0, "gamma lut at 50: %d", lut.v[255]);
+
+    fx_rgb_t src[2] = {{1, 2, 3}, {40, 50, 60}};
+    uint8_t dst[6];
+    fx_lut_build(&lut, 255, false);
+    fx_output(&lut, src, 2, dst, FX_ORDER_GRB);
+    CHECK(dst[0] == 2 && dst[1] == 1 && dst[2] == 3 && dst[3] == 50 && dst[4] == 40 && dst[5] == 60, "GRB output");
+    fx_output(&lut, src, 2, dst, FX_ORDER_RGB);
+    CHECK(dst[0] == 1 && dst[1] == 2 && dst[2] == 3 && dst[3] == 40, "RGB output");
+}
+
+static void test_effects(void)
+{
+    printf("effects\n");
+    fx_rgb_t frame[16];
+    const fx_rgb_t black = {0, 0, 0};
+    const fx_rgb_t white = {255, 255, 255};
+
+    fx_effect_t grad = {.type = FX_GRADIENT, .c0 = black, .c1 = white};
+    fx_render(&grad, 1234, frame, 16);
+    CHECK(rgb_is(frame[0], 0, 0, 0) && rgb_is(frame[15], 255, 255, 255), "static gradient ends");
+    bool rising = true;
+    for (int i = 1; i < 16; i++)
+    {
+        rising &= frame[i].r > frame[i - 1].r && abs(frame[i].r - i * 17) <= 1;
+    }
+    CHECK(rising, "static gradient steps");
+
+    grad.period_ms = 1000;
+    fx_render(&grad, 0, frame, 16);
+    CHECK(frame[0].r == 0 && frame[8].r == 255 && frame[4].r > 120 && frame[4].r < 135, "moving gradient: %d %d %d",
+          frame[0].r, frame[4].r, frame[8].r);
+    fx_render(&grad, 500, frame, 16);
+    CHECK(frame[0].r == 255 && frame[8].r == 0, "moving gradient half period");
+
+    fx_effect_t chase = {.type = FX_CHASE, .c0 = white, .c1 = black, .period_ms = 400, .span = 4, .width = 1};
+    fx_render(&chase, 0, frame, 16);
+    int lit = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        lit += frame[i].r != 0;
+    }
+    CHECK(lit == 4 && frame[0].r && frame[4].r && !frame[1].r, "chase at 0");
+    fx_render(&chase, 100, frame, 16);
+    CHECK(frame[1].r && frame[5].r && !frame[0].r, "chase moves forward");
+    fx_render(&chase, 399, frame, 16);
+    CHECK(frame[3].r && !frame[0].r, "chase at end of period");
+
+    fx_effect_t fade = {.type = FX_FADE, .c0 = black, .c1 = {200, 100, 0}, .period_ms = 1000};
+    fx_render(&fade, 0, frame, 4);
+    CHECK(rgb_is(frame[0], 0, 0, 0), "fade at 0");
+    fx_render(&fade, 500, frame, 4);
+    CHECK(abs(frame[3].r - 200) <= 1 && abs(frame[3].g - 100) <= 1, "fade at half: %d", frame[3].r);
+    fx_render(&fade, 750, frame, 4);
+    CHECK(abs(frame[2].r - 100) <= 2, "fade back: %d", frame[2].r);
+
+    fx_effect_t rainbow = {.type = FX_RAINBOW, .span = FX_HUE_MAX, .sat = 255, .val = 255, .period_ms = 600};
+    fx_render(&rainbow, 0, frame, 12);
+    CHECK(rgb_is(frame[0], 255, 0, 0) && rgb_is(frame[4], 0, 255, 0) && rgb_is(frame[8], 0, 0, 255), "rainbow");
+    fx_render(&rainbow, 200, frame, 12);
+    CHECK(rgb_is(frame[0], 0, 255, 0) && rgb_is(frame[8], 255, 0, 0), "rainbow turns");
+
+    fx_render(&(fx_effect_t){.type = FX_SOLID, .c0 = {1, 2, 3}}, 0, frame, 16);
+    CHECK(rgb_is(frame[15], 1, 2, 3), "solid");
+}
+
+static void test_timeline(void)
+{
+    printf("timeline\n");
+    const fx_keyframe_t keys[] = {
+        {1000, 0, {.type = FX_SOLID, .c0 = {255, 0, 0}}},
+        {1000, 200, {.type = FX_SOLID, .c0 = {0, 0, 255}}},
+        {500, 100, {.type = FX_SOLID, .c0 = {0, 255, 0}}},
+    };
+    fx_timeline_t tl;
+    const fx_keyframe_t bad = {0, 0, {.type = FX_SOLID}};
+    CHECK(fx_timeline_init(&tl, &bad, 1, false) == ESP_ERR_INVALID_ARG, "zero duration");
+    CHECK(fx_timeline_init(&tl, keys, 0, false) == ESP_ERR_INVALID_ARG, "no frames");
+    CHECK(fx_timeline_init(&tl, keys, 3, false) == ESP_OK && tl.total_ms == 2500, "init");
+
+    fx_rgb_t frame[4];
+    fx_rgb_t scratch[4];
+    fx_timeline_render(&tl, 0, frame, scratch, 4);
+    CHECK(rgb_is(frame[0], 255, 0, 0), "first segment, no blend without loop");
+    fx_timeline_render(&tl, 1100, frame, scratch, 4);
+    CHECK(abs(frame[0].r - 128) <= 1 && abs(frame[0].b - 128) <= 1, "blend half: %d %d", frame[0].r, frame[0].b);
+    fx_timeline_render(&tl, 1200, frame, scratch, 4);
+    CHECK(rgb_is(frame[0], 0, 0, 255), "blend done");
+    fx_timeline_render(&tl, 9999, frame, scratch, 4);
+    CHECK(rgb_is(frame[3], 0, 255, 0), "holds the last segment");
+
+    CHECK(fx_timeline_init(&tl, keys, 3, true) == ESP_OK, "init loop");
+    fx_timeline_render(&tl, 2500 + 1500, frame, scratch, 4);
+    CHECK(rgb_is(frame[0], 0, 0, 255), "loops");
+    fx_timeline_render(&tl, 2550, frame, scratch, 4);
+    CHECK(rgb_is(frame[0], 255, 0, 0), "first segment has no blend");
+}
+
+/**
+ * @description: 浮点数的 HSV（h 0 ~ 360）
+ */
+static fx_rgb_t float_hsv(float h, float s, float v)
+{
+    float c = v * s;
+    float x = c * (1.0f - fabsf(fmodf(h / 60.0f, 2.0f) - 1.0f));
+    float m = v - c;
+    float r, g, b;
+    if (h < 60)
+    {
+        r = c, g = x, b = 0;
+    }
+    else if (h < 120)
+    {
+        r = x, g = c, b = 0;
+    }
+    else if (h < 180)
+    {
+        r = 0, g = c, b = x;
+    }
+    else if (h < 240)
+    {
+        r = 0, g = x, b = c;
+    }
+    else if (h < 300)
+    {
+        r = x, g = 0, b = c;
+    }
+    else
+    {
+        r = c, g = 0, b = x;
+    }
+    return (fx_rgb_t){(uint8_t)((r + m) * 255), (uint8_t)((g + m) * 255), (uint8_t)((b + m) * 255)};
+}
+
+static uint8_t float_correct(uint8_t v, float brightness)
+{
+    return (uint8_t)(powf(v / 255.0f, 2.2f) * brightness * 255.0f);
+}
+
+/**
+ * @description: 浮点数实现的彩虹加伽马校正和亮度，输出 GRB
+ */
+static void float_rainbow(uint32_t t_ms, uint8_t *dst, size_t n)
+{
+    float offset = (float)(t_ms % 2000) / 2000.0f * 360.0f;
+    for (size_t i = 0; i < n; i++, dst += 3)
+    {
+        fx_rgb_t c = float_hsv(fmodf(offset + 360.0f * i / n, 360.0f), 1.0f, 1.0f);
+        dst[0] = float_correct(c.g, 0.5f);
+        dst[1] = float_correct(c.r, 0.5f);
+        dst[2] = float_correct(c.b, 0.5f);
+    }
+}
+
+/**
+ * @description: 渲染 rounds 帧加输出，返回每个 LED 的 ns
+ */
+static double bench_effect(const fx_effect_t *e, const fx_lut_t *lut, fx_rgb_t *frame, uint8_t *out, size_t n,
+                           int rounds)
+{
+    uint64_t start = bench_now_ns();
+    for (int r = 0; r < rounds; r++)
+    {
+        fx_render(e, r * 16, frame, n);
+        fx_output(lut, frame, n, out, FX_ORDER_GRB);
+        s_sink = out[(r * 7) % (n * 3)];
+    }
+    return (double)(bench_now_ns() - start) / rounds / n;
+}
+
+static void bench(size_t n)
+{
+    printf("%zu leds, ns per led (render + lut output)\n", n);
+    fx_rgb_t *frame = malloc(n * sizeof(fx_rgb_t));
+    uint8_t *out = malloc(n * 3);
+    int rounds = (int)(2000000 / n) + 1;
+    fx_lut_t lut;
+    fx_lut_build(&lut, 128, true);
+
+    const fx_rgb_t c0 = {255, 40, 0};
+    const fx_rgb_t c1 = {0, 80, 255};
+    const struct
+    {
+        const char *name;
+        fx_effect_t e;
+    } cases[] = {
+        {"solid", {.type = FX_SOLID, .c0 = c0}},
+        {"gradient", {.type = FX_GRADIENT, .c0 = c0, .c1 = c1, .period_ms = 3000}},
+        {"rainbow", {.type = FX_RAINBOW, .span = FX_HUE_MAX, .sat = 255, .val = 255, .period_ms = 2000}},
+        {"fade", {.type = FX_FADE, .c0 = c0, .c1 = c1, .period_ms = 2000}},
+        {"chase", {.type = FX_CHASE, .c0 = c0, .c1 = c1, .period_ms = 1000, .span = 8, .width = 3}},
+    };
+    double rainbow_ns = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        double ns = bench_effect(&cases[i].e, &lut, frame, out, n, rounds);
+        printf("  %-10s %6.2f ns/led  %7.1f us/frame\n", cases[i].name, ns, ns * n / 1000.0);
+        CHECK(ns < BENCH_LIMIT_NS, "%s %.2f ns/led", cases[i].name, ns);
+        if (cases[i].e.type == FX_RAINBOW)
+        {
+            rainbow_ns = ns;
+        }
+    }
+
+    uint64_t start = bench_now_ns();
+    for (int r = 0; r < rounds; r++)
+    {
+        fx_output(&lut, frame, n, out, FX_ORDER_GRB);
+        s_sink = out[(r * 7) % (n * 3)];
+    }
+    printf("  %-10s %6.2f ns/led\n", "output", (double)(bench_now_ns() - start) / rounds / n);
+
+    start = bench_now_ns();
+    for (int r = 0; r < rounds; r++)
+    {
+        float_rainbow(r * 16, out, n);
+        s_sink = out[(r * 7) % (n * 3)];
+    }
+    double float_ns = (double)(bench_now_ns() - start) / rounds / n;
+    printf("  %-10s %6.2f ns/led (float hsv + powf), fixed point %.1fx faster\n", "float", float_ns,
+           float_ns / rainbow_ns);
+
+    free(out);
+    free(frame);
+}
+
+int main(int argc, char **argv)
+{
+    size_t leds = argc > 1 ? (size_t)atoi(argv[1]) : 1024;
+    if (leds < 16)
+    {
+        leds = 16;
+    }
+
+    test_color();
+    test_effects();
+    test_timeline();
+    bench(leds);
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * line_rx 的测试（08_uart/components/uart_line_rx）
+ *
+ * 生成长度不一的行（有空行和 "\r\n"），按随机大小的块送入：一个字节一块模拟逐字节到达，
+ * 几百字节一块模拟一次读到多行。给出的行暂时不释放，随机地攒几行再按顺序释放，
+ * 让缓冲区绕回时还有行在用。检查每一行的内容（给出时和释放时各一次）、没有复制、
+ * 过长的行被丢弃而后面的行不受影响，以及以 0 结束的二进制帧。
+ *
+ * 用法：line_rx_test [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "line_rx.h"
+#include "test_util.h"
+
+#define BUF_SIZE 512
+#define MAX_LINE 128
+#define MAX_PENDING 6
+
+/**
+ * @description: 第 i 行的内容（不含结束符），长度 0..100
+ */
+static size_t make_line(unsigned i, char *out)
+{
+    unsigned len = (i * 2654435761u >> 8) % 101;
+    if (i % 17 == 0)
+    {
+        len = 0;
+    }
+    int n = snprintf(out, MAX_LINE, "%u:", i);
+    for (unsigned k = n; k < len; k++)
+    {
+        out[k] = 'a' + (i + k) % 26;
+    }
+    return len < (unsigned)n ? (size_t)n : len;
+}
+
+static bool line_matches(unsigned i, const line_rx_view_t *v)
+{
+    char expect[MAX_LINE];
+    size_t len = make_line(i, expect);
+    return v->len == len && memcmp(v->data, expect, len) == 0;
+}
+
+static size_t build_stream(unsigned lines, uint8_t *out)
+{
+    size_t pos = 0;
+    for (unsigned i = 0; i < lines; i++)
+    {
+        pos += make_line(i, (char *)out + pos);
+        if (i % 3 == 0)
+        {
+            out[pos++] = '\r';
+        }
+        out[pos++] = '\n';
+    }
+    return pos;
+}
+
+typedef struct
+{
+    line_rx_view_t view;
+    unsigned index;
+} pending_t;
+
+/**
+ * @description: 随机块大小送入 lines 行，max_chunk 为 1 时逐字节
+ */
+static void run_stream(const char *name, unsigned lines, size_t max_chunk, unsigned seed)
+{
+    static uint8_t stream[4000 * 110];
+    size_t total = build_stream(lines, stream);
+    uint8_t buf[BUF_SIZE];
+    line_rx_t rx;
+    line_rx_config_t config = LINE_RX_DEFAULT_CONFIG(buf, sizeof(buf));
+    config.max_line = MAX_LINE;
+    line_rx_init(&rx, &config);
+    srand(seed);
+
+    pending_t pending[MAX_PENDING];
+    int npending = 0;
+    unsigned next_index = 0;
+    unsigned bad = 0;
+    unsigned full = 0;
+    size_t pos = 0;
+    while (pos < total)
+    {
+        size_t room;
+        uint8_t *dst = line_rx_reserve(&rx, &room);
+        if (!dst)
+        {
+            // 攒着的行占满了缓冲区，全部释放
+            full++;
+            for (int k = 0; k < npending; k++)
+            {
+                bad += !line_matches(pending[k].index, &pending[k].view);
+            }
+            if (npending)
+            {
+                line_rx_release(&rx, &pending[npending - 1].view);
+            }
+            npending = 0;
+            continue;
+        }
+        size_t n = 1 + (size_t)rand() % max_chunk;
+        n = n < room ? n : room;
+        n = n < total - pos ? n : total - pos;
+        memcpy(dst, stream + pos, n);
+        line_rx_commit(&rx, n);
+        pos += n;
+
+        line_rx_view_t v;
+        while (line_rx_next(&rx, &v))
+        {
+            bad += !line_matches(next_index, &v);
+            bad += v.data < buf || v.data + v.len > buf + sizeof(buf);
+            if (npending == MAX_PENDING || rand() % 3 == 0)
+            {
+                // 释放到最新的一行为止（按顺序释放之前的所有行）
+                for (int k = 0; k < npending; k++)
+                {
+                    bad += !line_matches(pending[k].index, &pending[k].view);
+                }
+                bad += !line_matches(next_index, &v);
+                line_rx_release(&rx, &v);
+                npending = 0;
+            }
+            else
+            {
+                pending[npending++] = (pending_t){.view = v, .index = next_index};
+            }
+            next_index++;
+        }
+    }
+    printf("%-12s %u lines, %zu bytes, chunks up to %zu: %u lines out, %u buffer full\n", name, lines, total,
+           max_chunk, next_index, full);
+    CHECK(next_index == lines, "%s: %u of %u lines", name, next_index, lines);
+    CHECK(bad == 0, "%s: %u bad lines", name, bad);
+    CHECK(rx.stats.lines == lines && rx.stats.bytes == total && rx.stats.too_long == 0, "%s: stats", name);
+}
+
+static void test_coalesced(void)
+{
+    uint8_t buf[64];
+    line_rx_t rx;
+    line_rx_config_t config = LINE_RX_DEFAULT_CONFIG(buf, sizeof(buf));
+    line_rx_init(&rx, &config);
+    const char *input = "red\r\n\ngreen\nrgb 23 114 180\r\nbri";
+    CHECK(line_rx_feed(&rx, input, strlen(input)) == strlen(input), "feed");
+    const char *expect[] = {"red", "", "green", "rgb 23 114 180"};
+    line_rx_view_t v;
+    for (int i = 0; i < 4; i++)
+    {
+        CHECK(line_rx_next(&rx, &v) && v.len == strlen(expect[i]) && memcmp(v.data, expect[i], v.len) == 0,
+              "line %d", i);
+        line_rx_release(&rx, &v);
+    }
+    CHECK(!line_rx_next(&rx, &v), "partial line returned");
+    line_rx_feed(&rx, "ght 50\n", 7);
+    CHECK(line_rx_next(&rx, &v) && v.len == 9 && memcmp(v.data, "bright 50", 9) == 0, "split line");
+    line_rx_release(&rx, &v);
+}
+
+static void test_too_long(void)
+{
+    uint8_t buf[64];
+    line_rx_t rx;
+    line_rx_config_t config = LINE_RX_DEFAULT_CONFIG(buf, sizeof(buf));
+    line_rx_init(&rx, &config); // max_line = 16
+    line_rx_view_t v;
+    line_rx_view_t ok;
+    line_rx_feed(&rx, "ok\n", 3);
+    CHECK(line_rx_next(&rx, &ok), "line before");
+    // 前一行还没释放时丢弃过长的行
+    for (int i = 0; i < 10; i++)
+    {
+        line_rx_feed(&rx, "0123456789", 10);
+        CHECK(!line_rx_next(&rx, &v), "too long line returned");
+    }
+    line_rx_feed(&rx, "tail\nblue\n", 10);
+    CHECK(ok.len == 2 && memcmp(ok.data, "ok", 2) == 0, "line before overwritten");
+    line_rx_release(&rx, &ok);
+    CHECK(line_rx_next(&rx, &v) && v.len == 4 && memcmp(v.data, "blue", 4) == 0, "line after");
+    line_rx_release(&rx, &v);
+    CHECK(rx.stats.too_long == 1, "too_long %u", rx.stats.too_long);
+
+    // 恰好 max_line - 1 个字符加结束符可以放下
+    line_rx_feed(&rx, "abcdefghijklmno\n", 16);
+    CHECK(line_rx_next(&rx, &v) && v.len == 15, "longest line");
+    line_rx_release(&rx, &v);
+}
+
+static void test_frames(void)
+{
+    uint8_t buf[64];
+    line_rx_t rx;
+    line_rx_config_t config = LINE_RX_DEFAULT_CONFIG(buf, sizeof(buf));
+    config.term = 0;
+    config.strip_cr = false;
+    line_rx_init(&rx, &config);
+    const uint8_t input[] = {0x03, 0x0D, 0x0A, 0x00, 0x01, 0x00, 0x02, 0xFF};
+    line_rx_feed(&rx, input, sizeof(input));
+    line_rx_view_t v;
+    CHECK(line_rx_next(&rx, &v) && v.len == 3 && v.data[1] == 0x0D && v.data[2] == 0x0A, "frame with \\r\\n");
+    line_rx_release(&rx, &v);
+    CHECK(line_rx_next(&rx, &v) && v.len == 1 && v.data[0] == 0x01, "short frame");
+    line_rx_release(&rx, &v);
+    CHECK(!line_rx_next(&rx, &v), "partial frame returned");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 0) : 1;
+    test_coalesced();
+    test_too_long();
+    test_frames();
+    run_stream("bytewise", 500, 1, seed);
+    run_stream("fragmented", 4000, 20, seed);
+    run_stream("coalesced", 4000, 400, seed);
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
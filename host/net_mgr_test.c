@@ -0,0 +1,262 @@
+/*
+ * net_mgr_fsm 的测试（07_NTP/components/net_manager）
+ *
+ * 模拟的驱动记录 Wi-Fi、SNTP 的启停和设置的超时，事件由测试按顺序送入。
+ * 检查正常联网、连上后断开重连、失败后按加倍的间隔重试直到 FAILED、停止，
+ * 以及订阅者收到的状态序列（按 mask 过滤、订阅时立即回调、回调中取消订阅）。
+ *
+ * 用法：net_mgr_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "net_mgr_fsm.h"
+#include "test_util.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+#define MAX_SEEN 16
+
+typedef struct
+{
+    net_mgr_driver_t parent;
+    int64_t now;           /*!< 虚拟时间，us */
+    bool wifi_on;
+    bool sntp_on;
+    bool wifi_start_fails; /*!< wifi_start 返回错误 */
+    int wifi_starts;
+    int wifi_stops;
+    int sntp_starts;
+    uint32_t timeout_ms;   /*!< 当前设置的超时，0 表示没有 */
+} sim_drv_t;
+
+static esp_err_t sim_wifi_start(net_mgr_driver_t *drv)
+{
+    sim_drv_t *d = __containerof(drv, sim_drv_t, parent);
+    d->wifi_starts++;
+    if (d->wifi_start_fails)
+    {
+        return ESP_FAIL;
+    }
+    d->wifi_on = true;
+    return ESP_OK;
+}
+
+static void sim_wifi_stop(net_mgr_driver_t *drv)
+{
+    sim_drv_t *d = __containerof(drv, sim_drv_t, parent);
+    d->wifi_stops++;
+    d->wifi_on = false;
+}
+
+static esp_err_t sim_sntp_start(net_mgr_driver_t *drv)
+{
+    sim_drv_t *d = __containerof(drv, sim_drv_t, parent);
+    d->sntp_starts++;
+    d->sntp_on = true;
+    return ESP_OK;
+}
+
+static void sim_sntp_stop(net_mgr_driver_t *drv)
+{
+    __containerof(drv, sim_drv_t, parent)->sntp_on = false;
+}
+
+static void sim_set_timeout(net_mgr_driver_t *drv, uint32_t ms)
+{
+    __containerof(drv, sim_drv_t, parent)->timeout_ms = ms;
+}
+
+static int64_t sim_now_us(net_mgr_driver_t *drv)
+{
+    return __containerof(drv, sim_drv_t, parent)->now;
+}
+
+static void sim_init(sim_drv_t *d)
+{
+    memset(d, 0, sizeof(*d));
+    d->parent.wifi_start = sim_wifi_start;
+    d->parent.wifi_stop = sim_wifi_stop;
+    d->parent.sntp_start = sim_sntp_start;
+    d->parent.sntp_stop = sim_sntp_stop;
+    d->parent.set_timeout = sim_set_timeout;
+    d->parent.now_us = sim_now_us;
+}
+
+typedef struct
+{
+    net_state_t seen[MAX_SEEN];
+    int count;
+    net_mgr_t *m;
+    bool unsubscribe_on_synced; /*!< 收到 SYNCED 后在回调中取消订阅 */
+} recorder_t;
+
+static void record_cb(void *ctx, net_state_t state, net_state_t prev)
+{
+    recorder_t *r = (recorder_t *)ctx;
+    if (r->count < MAX_SEEN)
+    {
+        r->seen[r->count++] = state;
+    }
+    if (r->unsubscribe_on_synced && state == NET_STATE_SYNCED)
+    {
+        net_mgr_unsubscribe(r->m, record_cb, ctx);
+    }
+}
+
+static bool seen_equals(const recorder_t *r, const net_state_t *expect, int n)
+{
+    return r->count == n && memcmp(r->seen, expect, n * sizeof(net_state_t)) == 0;
+}
+
+static void test_normal(void)
+{
+    printf("normal bring-up\n");
+    sim_drv_t d;
+    sim_init(&d);
+    net_mgr_config_t config = NET_MGR_DEFAULT_CONFIG();
+    net_mgr_t m;
+    net_mgr_init(&m, &config, &d.parent);
+    recorder_t all = {.m = &m}, synced = {.m = &m};
+    CHECK(net_mgr_subscribe(&m, NET_STATE_ALL, record_cb, &all) == ESP_OK, "subscribe all");
+    CHECK(net_mgr_subscribe(&m, NET_STATE_BIT(NET_STATE_SYNCED), record_cb, &synced) == ESP_OK, "subscribe synced");
+    CHECK(all.count == 1 && all.seen[0] == NET_STATE_OFF, "missing immediate callback with the current state");
+    all.count = 0;
+
+    CHECK(net_mgr_handle(&m, NET_EVENT_START) == NET_STATE_CONNECTING, "start");
+    CHECK(d.wifi_on && !d.sntp_on, "wifi not started");
+    // SNTP 只在取得地址后开始，之前的同步事件忽略
+    CHECK(net_mgr_handle(&m, NET_EVENT_TIME_SYNCED) == NET_STATE_CONNECTING, "synced before ip");
+    d.now = 850000;
+    CHECK(net_mgr_handle(&m, NET_EVENT_WIFI_UP) == NET_STATE_ONLINE, "online");
+    CHECK(d.sntp_on, "sntp not started");
+    d.now = 1200000;
+    CHECK(net_mgr_handle(&m, NET_EVENT_TIME_SYNCED) == NET_STATE_SYNCED, "synced");
+    CHECK(net_mgr_handle(&m, NET_EVENT_TIME_SYNCED) == NET_STATE_SYNCED, "second sync");
+
+    const net_state_t expect[] = {NET_STATE_CONNECTING, NET_STATE_ONLINE, NET_STATE_SYNCED};
+    CHECK(seen_equals(&all, expect, 3), "subscriber saw %d states", all.count);
+    CHECK(synced.count == 1 && synced.seen[0] == NET_STATE_SYNCED, "masked subscriber saw %d states", synced.count);
+
+    // 晚订阅的子系统立即收到当前状态
+    recorder_t late = {.m = &m};
+    net_mgr_subscribe(&m, NET_STATE_BIT(NET_STATE_SYNCED), record_cb, &late);
+    CHECK(late.count == 1 && late.seen[0] == NET_STATE_SYNCED, "late subscriber missed SYNCED");
+
+    net_mgr_status_t status;
+    net_mgr_get_status(&m, &status);
+    printf("  ip after %u ms, sync after %u ms, %u syncs\n", status.time_to_ip_ms, status.time_to_sync_ms,
+           status.syncs);
+    CHECK(status.time_to_ip_ms == 850 && status.time_to_sync_ms == 1200, "times %u / %u", status.time_to_ip_ms,
+          status.time_to_sync_ms);
+    CHECK(status.syncs == 2, "syncs %u", status.syncs);
+
+    CHECK(net_mgr_handle(&m, NET_EVENT_STOP) == NET_STATE_OFF, "stop");
+    CHECK(!d.wifi_on && !d.sntp_on, "stop left wifi %d sntp %d", d.wifi_on, d.sntp_on);
+}
+
+static void test_reconnect(void)
+{
+    printf("disconnect while online\n");
+    sim_drv_t d;
+    sim_init(&d);
+    net_mgr_config_t config = NET_MGR_DEFAULT_CONFIG();
+    net_mgr_t m;
+    net_mgr_init(&m, &config, &d.parent);
+    recorder_t r = {.m = &m, .unsubscribe_on_synced = true};
+    net_mgr_subscribe(&m, NET_STATE_ALL & ~NET_STATE_BIT(NET_STATE_OFF), record_cb, &r);
+
+    net_mgr_handle(&m, NET_EVENT_START);
+    net_mgr_handle(&m, NET_EVENT_WIFI_UP);
+    CHECK(net_mgr_handle(&m, NET_EVENT_WIFI_DOWN) == NET_STATE_CONNECTING, "drop before sync");
+    CHECK(!d.sntp_on, "sntp still running while disconnected");
+    CHECK(net_mgr_handle(&m, NET_EVENT_WIFI_UP) == NET_STATE_ONLINE, "reconnected");
+    CHECK(d.sntp_on && d.sntp_starts == 2, "sntp not restarted");
+    net_mgr_handle(&m, NET_EVENT_TIME_SYNCED);
+    // 同步过之后断开再连上，直接回到 SYNCED
+    net_mgr_handle(&m, NET_EVENT_WIFI_DOWN);
+    CHECK(net_mgr_handle(&m, NET_EVENT_WIFI_UP) == NET_STATE_SYNCED, "reconnect after sync");
+    CHECK(d.wifi_starts == 1, "wifi restarted %d times, driver reconnects by itself", d.wifi_starts);
+
+    const net_state_t expect[] = {NET_STATE_CONNECTING, NET_STATE_ONLINE, NET_STATE_CONNECTING, NET_STATE_ONLINE,
+                                  NET_STATE_SYNCED};
+    CHECK(seen_equals(&r, expect, 5), "subscriber saw %d states (unsubscribed in callback)", r.count);
+    net_mgr_status_t status;
+    net_mgr_get_status(&m, &status);
+    CHECK(status.disconnects == 2, "disconnects %u", status.disconnects);
+}
+
+static void test_backoff(void)
+{
+    printf("connection failures\n");
+    sim_drv_t d;
+    sim_init(&d);
+    net_mgr_config_t config = NET_MGR_DEFAULT_CONFIG();
+    config.retry_ms = 1000;
+    config.max_retry_ms = 3000;
+    config.max_rounds = 4;
+    net_mgr_t m;
+    net_mgr_init(&m, &config, &d.parent);
+
+    net_mgr_handle(&m, NET_EVENT_START);
+    const uint32_t waits[] = {1000, 2000};
+    for (int i = 0; i < 2; i++)
+    {
+        CHECK(net_mgr_handle(&m, NET_EVENT_WIFI_FAILED) == NET_STATE_BACKOFF, "round %d not in backoff", i + 1);
+        CHECK(d.timeout_ms == waits[i], "round %d waits %u ms", i + 1, d.timeout_ms);
+        CHECK(net_mgr_handle(&m, NET_EVENT_TIMEOUT) == NET_STATE_CONNECTING, "round %d no retry", i + 1);
+    }
+    // wifi_start 本身失败也算一轮，间隔不超过 max_retry_ms
+    d.wifi_start_fails = true;
+    net_mgr_handle(&m, NET_EVENT_WIFI_FAILED);
+    CHECK(d.timeout_ms == 3000, "third wait %u ms", d.timeout_ms);
+    CHECK(net_mgr_handle(&m, NET_EVENT_TIMEOUT) == NET_STATE_FAILED, "not failed after %d rounds", config.max_rounds);
+    CHECK(!d.wifi_on && d.timeout_ms == 0, "failed left wifi %d timeout %u", d.wifi_on, d.timeout_ms);
+    printf("  %d connection rounds before giving up\n", d.wifi_starts);
+    CHECK(d.wifi_starts == 4, "wifi_start %d times", d.wifi_starts);
+
+    // FAILED 之后可以重新开始，一次成功后重试间隔复位
+    d.wifi_start_fails = false;
+    CHECK(net_mgr_handle(&m, NET_EVENT_START) == NET_STATE_CONNECTING, "restart after failed");
+    net_mgr_handle(&m, NET_EVENT_WIFI_UP);
+    net_mgr_handle(&m, NET_EVENT_WIFI_DOWN);
+    net_mgr_handle(&m, NET_EVENT_WIFI_FAILED);
+    CHECK(d.timeout_ms == 1000, "backoff not reset (%u ms)", d.timeout_ms);
+    CHECK(net_mgr_handle(&m, NET_EVENT_STOP) == NET_STATE_OFF && d.timeout_ms == 0, "stop in backoff");
+}
+
+static void test_no_sntp(void)
+{
+    printf("without sntp\n");
+    sim_drv_t d;
+    sim_init(&d);
+    net_mgr_config_t config = NET_MGR_DEFAULT_CONFIG();
+    config.sntp = false;
+    net_mgr_t m;
+    net_mgr_init(&m, &config, &d.parent);
+    net_mgr_handle(&m, NET_EVENT_START);
+    CHECK(net_mgr_handle(&m, NET_EVENT_WIFI_UP) == NET_STATE_ONLINE && d.sntp_starts == 0, "sntp started");
+
+    recorder_t r[NET_MGR_MAX_SUBSCRIBERS + 1];
+    int ok = 0;
+    for (int i = 0; i <= NET_MGR_MAX_SUBSCRIBERS; i++)
+    {
+        r[i] = (recorder_t){.m = &m};
+        ok += net_mgr_subscribe(&m, NET_STATE_BIT(NET_STATE_FAILED), record_cb, &r[i]) == ESP_OK;
+    }
+    CHECK(ok == NET_MGR_MAX_SUBSCRIBERS, "%d subscriptions accepted", ok);
+    CHECK(net_mgr_unsubscribe(&m, record_cb, &r[NET_MGR_MAX_SUBSCRIBERS]) == ESP_ERR_NOT_FOUND, "unsubscribe unknown");
+}
+
+int main(void)
+{
+    test_normal();
+    test_reconnect();
+    test_backoff();
+    test_no_sntp();
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * OLED 驱动的测试（02_IIC_OLED_/components/OLED），在模拟的 I2C 总线上挂一个 SSD1306 控制器
+ *
+ * 初始化：显示打开、电荷泵、对比度，清屏后显存全为 0；
+ * 字符和字符串：显存中的列与字库一致，字符串到行尾换行，数字前面的 0 显示为空格；
+ * 传输：每个字节一次传输，统计清屏的传输次数和按 100kHz 计算的总线时间；设备不应答时返回 ESP_FAIL。
+ *
+ * 用法：oled_test
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "OLED.h"
+#include "ssd1306_sim.h"
+#include "test_util.h"
+
+static ssd1306_sim_t s_oled;
+
+/**
+ * @description: 显存中从 (x, page) 开始的 n 列是否与 glyph 相同
+ */
+static bool ram_is(int x, int page, const unsigned char *glyph, int n)
+{
+    return memcmp(&s_oled.ram[page][x], glyph, n) == 0;
+}
+
+static bool ram_blank(void)
+{
+    for (int page = 0; page < SSD1306_SIM_PAGES; page++)
+    {
+        for (int x = 0; x < SSD1306_SIM_WIDTH; x++)
+        {
+            if (s_oled.ram[page][x])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @description: 8x16 字符 chr 是否在 (x, page) 上
+ */
+static bool char16_at(int x, int page, char chr)
+{
+    const unsigned char *glyph = &F8X16[(chr - ' ') * 16];
+    return ram_is(x, page, glyph, 8) && ram_is(x, page + 1, glyph + 8, 8);
+}
+
+static void test_init(void)
+{
+    printf("init\n");
+    // 上电时显存是随机的
+    memset(s_oled.ram, 0xA5, sizeof(s_oled.ram));
+    i2c_sim_reset_stats(I2C_MASTER_NUM);
+    OLED_Init();
+    CHECK(s_oled.display_on && s_oled.charge_pump, "display on %d charge pump %d", s_oled.display_on,
+          s_oled.charge_pump);
+    CHECK(s_oled.contrast == 0xFF, "contrast %02X", s_oled.contrast);
+    CHECK(s_oled.pending == 0, "command arguments left %u", s_oled.pending);
+    CHECK(ram_blank(), "cleared");
+
+    i2c_sim_stats_t stats;
+    i2c_sim_get_stats(I2C_MASTER_NUM, &stats);
+    // 27 个命令字节，清屏每页 3 个命令和 128 个数据字节
+    CHECK(stats.transactions == 27 + 8 * (3 + 128), "transactions %u", stats.transactions);
+    CHECK(stats.bytes == stats.transactions * 2 && stats.nacks == 0, "bytes %u nacks %u", stats.bytes, stats.nacks);
+}
+
+static void test_text(void)
+{
+    printf("text\n");
+    OLED_ShowChar(16, 2, 'A', 16);
+    CHECK(char16_at(16, 2, 'A'), "8x16 'A'");
+    // 'A' 的字形在中间一列有点亮的像素，上下两页都有
+    bool upper = false, lower = false;
+    for (int y = 16; y < 24; y++)
+    {
+        upper |= ssd1306_sim_pixel(&s_oled, 20, y);
+    }
+    for (int y = 24; y < 32; y++)
+    {
+        lower |= ssd1306_sim_pixel(&s_oled, 20, y);
+    }
+    CHECK(upper && lower, "pixels of 'A'");
+    CHECK(!ssd1306_sim_pixel(&s_oled, 15, 20) && !ssd1306_sim_pixel(&s_oled, 24, 20), "no pixels beside 'A'");
+
+    OLED_ShowChar(100, 7, 'z', 8);
+    CHECK(ram_is(100, 7, F6x8['z' - ' '], 6), "6x8 'z'");
+
+    OLED_Clear();
+    CHECK(ram_blank(), "clear");
+
+    // 16 个字符一行，第 17 个换到下一行
+    const char *text = "0123456789ABCDEFGH";
+    OLED_ShowString(0, 0, (char *)text, 16);
+    bool ok = true;
+    for (int i = 0; i < 16; i++)
+    {
+        ok &= char16_at(i * 8, 0, text[i]);
+    }
+    CHECK(ok, "first line");
+    CHECK(char16_at(0, 2, 'G') && char16_at(8, 2, 'H'), "wrapped to the second line");
+
+    OLED_ShowNum(0, 4, 42, 4, 16);
+    CHECK(char16_at(0, 4, ' ') && char16_at(8, 4, ' ') && char16_at(16, 4, '4') && char16_at(24, 4, '2'),
+          "ShowNum pads with spaces");
+    OLED_ShowNum(0, 6, 0, 3, 16);
+    CHECK(char16_at(16, 6, '0'), "last digit of 0");
+}
+
+static void test_bus(void)
+{
+    printf("bus\n");
+    i2c_sim_stats_t stats;
+    i2c_sim_reset_stats(I2C_MASTER_NUM);
+    OLED_ShowChar(0, 0, 'B', 16);
+    i2c_sim_get_stats(I2C_MASTER_NUM, &stats);
+    CHECK(stats.transactions == 2 * (3 + 8), "ShowChar transactions %u", stats.transactions);
+
+    i2c_sim_reset_stats(I2C_MASTER_NUM);
+    OLED_Clear();
+    i2c_sim_get_stats(I2C_MASTER_NUM, &stats);
+    // 每次传输：起始、地址、两个字节、停止，29 个时钟
+    CHECK(stats.bus_ns == (uint64_t)stats.transactions * 290000, "bus time %llu ns",
+          (unsigned long long)stats.bus_ns);
+    printf("  clear: %u transactions, %.1f ms at %d Hz\n", stats.transactions, stats.bus_ns / 1e6,
+           I2C_MASTER_FREQ_HZ);
+
+    // 取下设备，不应答
+    i2c_sim_attach(I2C_MASTER_NUM, OLED_ADDR, NULL);
+    i2c_sim_reset_stats(I2C_MASTER_NUM);
+    CHECK(OLED_WR_Byte(0xAE, OLED_CMD) == ESP_FAIL, "no device");
+    i2c_sim_get_stats(I2C_MASTER_NUM, &stats);
+    CHECK(stats.nacks == 1, "nacks %u", stats.nacks);
+    CHECK(s_oled.display_on, "display unchanged");
+}
+
+int main(void)
+{
+    CHECK(OLED_WR_Byte(0xAE, OLED_CMD) == ESP_ERR_INVALID_STATE, "driver not installed");
+    CHECK(i2c_master_init() == ESP_OK, "i2c_master_init");
+    CHECK(ssd1306_sim_attach(&s_oled, I2C_MASTER_NUM, OLED_ADDR) == ESP_OK, "attach");
+
+    test_init();
+    test_text();
+    test_bus();
+
+    CHECK(i2c_driver_delete(I2C_MASTER_NUM) == ESP_OK, "i2c_driver_delete");
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * RX8025T 驱动的测试（07_NTP/components/rx8025），在模拟的 I2C 总线上挂一个按 esp_timer 走时的芯片
+ *
+ * 初始化：写扩展和控制寄存器，上电后 VLF 置位报告掉电，设置时间后清除；
+ * 读写时间：BCD 和独热码的星期往返一致，年份超出 2000~2099 时不写；
+ * 秒的边沿：芯片处在一秒的 900ms 时，get_time_edge() 约 100ms 后返回下一秒，返回时离边沿不超过几毫秒；
+ * 芯片停振时 1.1 秒后超时；没有芯片或不应答时返回 I2C 的错误。
+ *
+ * 用法：rx8025_test
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "rx8025.h"
+#include "rx8025_sim.h"
+#include "esp_timer.h"
+#include "test_util.h"
+
+#define TEST_PORT I2C_NUM_0
+// 2024-02-29 23:59:58 UTC，星期四
+#define TEST_TIME 1709251198
+
+static rx8025_sim_t s_chip;
+
+static void test_init(void)
+{
+    printf("init\n");
+    rx8025_config_t config = RX8025_DEFAULT_CONFIG(TEST_PORT);
+    rx8025_handle_t rtc = NULL;
+    bool power_lost = false;
+    CHECK(rx8025_init(&config, &rtc, &power_lost) == ESP_OK && rtc, "init");
+    CHECK(power_lost, "VLF after power on");
+    CHECK(s_chip.regs[0x0D] == 0x42 && s_chip.regs[0x0F] == 0x40, "ext %02X ctrl %02X", s_chip.regs[0x0D],
+          s_chip.regs[0x0F]);
+
+    struct tm tm;
+    time_t t = TEST_TIME;
+    gmtime_r(&t, &tm);
+    CHECK(rx8025_set_time(rtc, &tm) == ESP_OK, "set_time");
+    CHECK(rx8025_sim_get_time(&s_chip) == TEST_TIME, "chip time %lld", (long long)rx8025_sim_get_time(&s_chip));
+    rx8025_delete(rtc);
+
+    // 再次初始化（相当于重新启动），时间已经设置过
+    CHECK(rx8025_init(&config, &rtc, &power_lost) == ESP_OK, "init again");
+    CHECK(!power_lost, "VLF cleared by set_time");
+    rx8025_delete(rtc);
+
+    config.addr = RX8025_I2C_ADDR + 1;
+    CHECK(rx8025_init(&config, &rtc, NULL) == ESP_FAIL, "no device");
+    CHECK(rx8025_init(NULL, &rtc, NULL) == ESP_ERR_INVALID_ARG, "no config");
+}
+
+static void test_time(rx8025_handle_t rtc)
+{
+    printf("get/set time\n");
+    struct tm set;
+    time_t t = TEST_TIME;
+    gmtime_r(&t, &set);
+    CHECK(rx8025_set_time(rtc, &set) == ESP_OK, "set_time");
+    struct tm got;
+    CHECK(rx8025_get_time(rtc, &got) == ESP_OK, "get_time");
+    CHECK(got.tm_year == set.tm_year && got.tm_mon == set.tm_mon && got.tm_mday == set.tm_mday &&
+              got.tm_hour == set.tm_hour && got.tm_min == set.tm_min && got.tm_sec == set.tm_sec,
+          "roundtrip %04d-%02d-%02d %02d:%02d:%02d", got.tm_year + 1900, got.tm_mon + 1, got.tm_mday, got.tm_hour,
+          got.tm_min, got.tm_sec);
+    CHECK(got.tm_wday == 4, "weekday %d", got.tm_wday);
+
+    struct tm bad = set;
+    bad.tm_year = 99;
+    CHECK(rx8025_set_time(rtc, &bad) == ESP_ERR_INVALID_ARG, "year 1999");
+    bad.tm_year = 200;
+    CHECK(rx8025_set_time(rtc, &bad) == ESP_ERR_INVALID_ARG, "year 2100");
+    CHECK(rx8025_sim_get_time(&s_chip) == TEST_TIME, "time unchanged");
+}
+
+static void test_edge(rx8025_handle_t rtc)
+{
+    printf("second edge\n");
+    // 跨过闰日的午夜
+    rx8025_sim_set_time(&s_chip, TEST_TIME + 1, 900000);
+    uint32_t reads = s_chip.reads;
+    int64_t start = esp_timer_get_time();
+    struct tm tm;
+    CHECK(rx8025_get_time_edge(rtc, &tm) == ESP_OK, "get_time_edge");
+    int64_t now = esp_timer_get_time();
+    int64_t waited = now - start;
+    // 返回时离这一秒开始的时间
+    int64_t phase = (now - s_chip.base_us) % 1000000;
+    CHECK(tm.tm_mon == 2 && tm.tm_mday == 1 && tm.tm_hour == 0 && tm.tm_sec == 0, "%02d-%02d %02d:%02d:%02d",
+          tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+    CHECK(waited > 90000 && waited < 150000, "waited %lld us", (long long)waited);
+    CHECK(phase < 5000, "%lld us after the edge", (long long)phase);
+    printf("  waited %.1f ms, %u reads, returned %.2f ms after the edge\n", waited / 1e3, s_chip.reads - reads,
+           phase / 1e3);
+
+    printf("stopped oscillator\n");
+    s_chip.stopped = true;
+    start = esp_timer_get_time();
+    CHECK(rx8025_get_time_edge(rtc, &tm) == ESP_ERR_TIMEOUT, "timeout");
+    waited = esp_timer_get_time() - start;
+    CHECK(waited >= 1100000 && waited < 1300000, "timeout after %lld us", (long long)waited);
+    s_chip.stopped = false;
+    rx8025_sim_set_time(&s_chip, TEST_TIME, 0);
+
+    printf("no acknowledge\n");
+    s_chip.nack = true;
+    CHECK(rx8025_get_time(rtc, &tm) == ESP_FAIL, "get_time");
+    CHECK(rx8025_get_time_edge(rtc, &tm) == ESP_FAIL, "get_time_edge");
+    CHECK(rx8025_set_time(rtc, &tm) == ESP_FAIL, "set_time");
+    s_chip.nack = false;
+}
+
+int main(void)
+{
+    i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .master.clk_speed = 400000,
+    };
+    CHECK(i2c_param_config(TEST_PORT, &conf) == ESP_OK, "i2c_param_config");
+    CHECK(i2c_driver_install(TEST_PORT, conf.mode, 0, 0, 0) == ESP_OK, "i2c_driver_install");
+    CHECK(rx8025_sim_attach(&s_chip, TEST_PORT, RX8025_I2C_ADDR) == ESP_OK, "attach");
+
+    test_init();
+
+    rx8025_config_t config = RX8025_DEFAULT_CONFIG(TEST_PORT);
+    rx8025_handle_t rtc = NULL;
+    CHECK(rx8025_init(&config, &rtc, NULL) == ESP_OK, "init");
+    if (rtc)
+    {
+        test_time(rtc);
+        test_edge(rtc);
+        rx8025_delete(rtc);
+    }
+
+    i2c_driver_delete(TEST_PORT);
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * PC上运行SD卡吞吐量测试，与ESP32上用的是同一份测试代码（06_sdmmc/components/sd_bench）
+ *
+ * 用法：sd_bench <测试文件路径> [文件大小KiB] [最小块] [最大块]
+ * 例如对挂载的SD卡：sd_bench /media/sdcard/bench.bin 4096 512 65536
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "sd_bench.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file> [size_kib] [min_chunk] [max_chunk]\n", argv[0]);
+        return 2;
+    }
+    sd_bench_config_t config = SD_BENCH_DEFAULT_CONFIG(argv[1]);
+    if (argc > 2)
+    {
+        config.file_size = strtoull(argv[2], NULL, 0) * 1024;
+    }
+    if (argc > 3)
+    {
+        config.min_chunk = strtoul(argv[3], NULL, 0);
+    }
+    if (argc > 4)
+    {
+        config.max_chunk = strtoul(argv[4], NULL, 0);
+    }
+
+    sd_bench_io_t *io = sd_bench_io_new_posix();
+    if (!io)
+    {
+        return 1;
+    }
+    sd_bench_print_header();
+    esp_err_t ret = sd_bench_run(io, &config, sd_bench_print_result, NULL);
+    io->del(io);
+    if (ret != ESP_OK)
+    {
+        fprintf(stderr, "sd_bench_run failed: 0x%x\n", ret);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * sd_block_cache 的测试和性能测量：生成一个 tslog 文件，按回放的方式逐块（512字节）读出并解码，比较
+ *   - 直接读：每块一次读调用，和原来按调用者的长度读文件一样
+ *   - 缓存：按缓存块读，没有预读
+ *   - 缓存+预读：解码当前块的同时后台读后面的块
+ * 文件设备在每次读调用上加 latency_us 模拟SD卡的命令开销，每个 tslog 块解码后再空转 decode_us 模拟MCU上的解码耗时。
+ * 三种方式解码出的样本必须完全相同；最后随机偏移、随机长度读并与文件内容比对。
+ *
+ * 用法：sd_cache_bench [文件] [样本数] [latency_us] [decode_us]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sd_block_cache.h"
+#include "tslog.h"
+#include "esp_timer.h"
+
+typedef struct
+{
+    uint64_t samples;
+    uint64_t sum;
+} replay_sum_t;
+
+typedef struct
+{
+    const char *name;
+    uint16_t readahead; /*!< 0xFFFF 表示不用缓存 */
+} replay_mode_t;
+
+static uint32_t bench_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static esp_err_t bench_write(void *ctx, const uint8_t *block)
+{
+    return fwrite(block, TSLOG_BLOCK_SIZE, 1, ctx) == 1 ? ESP_OK : ESP_FAIL;
+}
+
+static bool bench_sum_sample(void *ctx, uint64_t t, const int32_t *values, uint8_t channels)
+{
+    replay_sum_t *s = ctx;
+    s->sum = s->sum * 31 + t;
+    for (uint8_t c = 0; c < channels; c++)
+    {
+        s->sum = s->sum * 31 + (uint32_t)values[c];
+    }
+    s->samples++;
+    return true;
+}
+
+static void bench_busy_wait(uint32_t us)
+{
+    int64_t end = esp_timer_get_time() + us;
+    while (esp_timer_get_time() < end)
+    {
+    }
+}
+
+/**
+ * @description: 生成模拟的4通道数据并编码成 tslog 文件
+ * @return       文件字节数，失败返回0
+ */
+static uint64_t bench_make_file(const char *path, uint64_t samples)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        perror(path);
+        return 0;
+    }
+    tslog_encoder_t enc;
+    tslog_encoder_init(&enc, 4, 0, bench_write, f);
+    uint32_t rng = 1;
+    int32_t values[4] = {2048, 1024, 3000, 500};
+    for (uint64_t i = 0; i < samples; i++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            values[c] += (int32_t)(bench_rand(&rng) % 9) - 4;
+        }
+        tslog_encoder_add(&enc, i * 1000 + bench_rand(&rng) % 50, values);
+    }
+    tslog_encoder_flush(&enc);
+    uint64_t size = enc.blocks * TSLOG_BLOCK_SIZE;
+    fclose(f);
+    return size;
+}
+
+static int bench_replay(const char *path, const replay_mode_t *mode, uint32_t latency_us, uint32_t decode_us,
+                        replay_sum_t *sum)
+{
+    sd_cache_file_config_t file_config = {.path = path, .latency_us = latency_us};
+    sd_cache_dev_t *dev = sd_cache_dev_new_file(&file_config);
+    if (!dev)
+    {
+        return 1;
+    }
+    sd_cache_handle_t cache = NULL;
+    if (mode->readahead != 0xFFFF)
+    {
+        sd_cache_config_t config = SD_CACHE_DEFAULT_CONFIG();
+        config.readahead = mode->readahead;
+        if (sd_cache_create(dev, &config, &cache) != ESP_OK)
+        {
+            dev->del(dev);
+            return 1;
+        }
+    }
+    uint64_t size;
+    dev->size(dev, &size);
+
+    uint8_t block[TSLOG_BLOCK_SIZE];
+    memset(sum, 0, sizeof(*sum));
+    int64_t start = esp_timer_get_time();
+    for (uint64_t offset = 0; offset < size; offset += TSLOG_BLOCK_SIZE)
+    {
+        esp_err_t ret = cache ? sd_cache_read(cache, offset, block, TSLOG_BLOCK_SIZE, NULL)
+                              : dev->read(dev, offset, block, TSLOG_BLOCK_SIZE);
+        if (ret != ESP_OK || tslog_block_decode(block, bench_sum_sample, sum) != ESP_OK)
+        {
+            printf("%s: block at %llu failed\n", mode->name, (unsigned long long)offset);
+            return 1;
+        }
+        bench_busy_wait(decode_us);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    printf("%-16s %8.1f ms %8.1f KB/s", mode->name, elapsed / 1000.0, size * 1e6 / 1024 / elapsed);
+    if (cache)
+    {
+        sd_cache_stats_t stats;
+        sd_cache_get_stats(cache, &stats);
+        printf("  hits %u misses %u waits %u prefetched %u (used %u)", (unsigned)stats.hits, (unsigned)stats.misses,
+               (unsigned)stats.waits, (unsigned)stats.prefetched, (unsigned)stats.prefetch_used);
+        sd_cache_delete(cache);
+    }
+    else
+    {
+        dev->del(dev);
+    }
+    printf("\n");
+    return 0;
+}
+
+/**
+ * @description: 随机偏移和长度读，与文件内容比对，中间穿插顺序读和作废
+ * @return       出错的次数
+ */
+static int bench_random_check(const char *path, uint64_t size)
+{
+    uint8_t *expect = malloc(size);
+    FILE *f = fopen(path, "rb");
+    if (!expect || !f || fread(expect, 1, size, f) != size)
+    {
+        free(expect);
+        if (f)
+        {
+            fclose(f);
+        }
+        return 1;
+    }
+    fclose(f);
+
+    sd_cache_file_config_t file_config = {.path = path};
+    sd_cache_config_t config = SD_CACHE_DEFAULT_CONFIG();
+    config.block_size = 4096;
+    sd_cache_handle_t cache;
+    if (sd_cache_create(sd_cache_dev_new_file(&file_config), &config, &cache) != ESP_OK)
+    {
+        free(expect);
+        return 1;
+    }
+    uint8_t buf[20000];
+    uint32_t rng = 7;
+    int errors = 0;
+    uint64_t offset = 0;
+    for (int i = 0; i < 20000 && errors == 0; i++)
+    {
+        size_t len = bench_rand(&rng) % sizeof(buf);
+        // 大部分是接着上次读，保证预读会启动
+        if (bench_rand(&rng) % 4 == 0)
+        {
+            offset = ((uint64_t)bench_rand(&rng) << 16 ^ bench_rand(&rng)) % (size + 1000);
+        }
+        if (i % 5000 == 4999)
+        {
+            sd_cache_invalidate(cache);
+        }
+        size_t got;
+        esp_err_t ret = sd_cache_read(cache, offset, buf, len, &got);
+        size_t want = offset >= size ? 0 : (size - offset < len ? size - offset : len);
+        if (ret != ESP_OK || got != want || memcmp(buf, expect + (offset < size ? offset : 0), got) != 0)
+        {
+            printf("random read at %llu len %zu: ret 0x%x, got %zu, want %zu\n", (unsigned long long)offset, len, ret,
+                   got, want);
+            errors++;
+        }
+        offset += got;
+    }
+    sd_cache_stats_t stats;
+    sd_cache_get_stats(cache, &stats);
+    printf("random reads: hits %u misses %u waits %u prefetched %u (used %u) evicted %u\n", (unsigned)stats.hits,
+           (unsigned)stats.misses, (unsigned)stats.waits, (unsigned)stats.prefetched, (unsigned)stats.prefetch_used,
+           (unsigned)stats.evicted);
+    sd_cache_delete(cache);
+    free(expect);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "sd_cache_bench.tsl";
+    uint64_t samples = argc > 2 ? strtoull(argv[2], NULL, 0) : 200000;
+    uint32_t latency_us = argc > 3 ? strtoul(argv[3], NULL, 0) : 1000;
+    uint32_t decode_us = argc > 4 ? strtoul(argv[4], NULL, 0) : 50;
+
+    uint64_t size = bench_make_file(path, samples);
+    if (size == 0)
+    {
+        return 1;
+    }
+    printf("%llu samples, %llu bytes, read latency %u us, decode %u us per block\n", (unsigned long long)samples,
+           (unsigned long long)size, (unsigned)latency_us, (unsigned)decode_us);
+
+    static const replay_mode_t modes[] = {
+        {"direct", 0xFFFF},
+        {"cache", 0},
+        {"cache+readahead", 4},
+    };
+    replay_sum_t sums[3];
+    int failures = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        failures += bench_replay(path, &modes[i], latency_us, decode_us, &sums[i]);
+        if (sums[i].samples != samples || sums[i].sum != sums[0].sum)
+        {
+            printf("%s: decoded %llu samples, checksum mismatch\n", modes[i].name, (unsigned long long)sums[i].samples);
+            failures++;
+        }
+    }
+    failures += bench_random_check(path, size);
+    remove(path);
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * 从SD卡上的连续日志文件（06_sdmmc/components/sd_contig_log）中取出有效数据
+ *
+ * 用法：sd_contig_extract <日志文件> [输出文件]
+ * 不给输出文件时只打印头信息
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "sd_contig_log_header.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <log file> [output]\n", argv[0]);
+        return 2;
+    }
+    FILE *in = fopen(argv[1], "rb");
+    if (!in)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    uint8_t sectors[SD_CONTIG_LOG_HEADER_SECTORS * SD_CONTIG_LOG_SECTOR_SIZE];
+    sd_contig_log_header_t header;
+    if (fread(sectors, 1, sizeof(sectors), in) != sizeof(sectors) ||
+        sd_contig_log_header_pick(sectors, &header) != ESP_OK)
+    {
+        fprintf(stderr, "%s: no valid header\n", argv[1]);
+        fclose(in);
+        return 1;
+    }
+    printf("capacity %llu, fill %llu, generation %u\n",
+           (unsigned long long)header.capacity, (unsigned long long)header.fill, (unsigned)header.generation);
+    if (argc < 3)
+    {
+        fclose(in);
+        return 0;
+    }
+
+    FILE *out = fopen(argv[2], "wb");
+    if (!out)
+    {
+        perror(argv[2]);
+        fclose(in);
+        return 1;
+    }
+    static uint8_t buf[64 * 1024];
+    uint64_t left = header.fill;
+    while (left)
+    {
+        size_t n = left > sizeof(buf) ? sizeof(buf) : left;
+        if (fread(buf, 1, n, in) != n || fwrite(buf, 1, n, out) != n)
+        {
+            fprintf(stderr, "short read/write, %llu bytes missing\n", (unsigned long long)left);
+            break;
+        }
+        left -= n;
+    }
+    fclose(in);
+    fclose(out);
+    return left ? 1 : 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * sd_journal 的掉电故障注入测试（06_sdmmc/components/sd_journal）
+ *
+ * 读写接口是内存中的"磁盘"：fsync 之前的写入都只是挂起的，模拟掉电时每个挂起的写入
+ * 随机地完整落盘、只落盘前面若干扇区或完全丢失（顺序也不保证）。
+ * 每轮随机追加、提交后掉电，重新打开并检查：
+ *   - 读出的记录按写入顺序排列，内容正确
+ *   - 所有已提交（sd_journal_commit 返回 ESP_OK）的记录都在
+ *   - 打开时读的块数不超过 log2(n) + 3 * sync_every
+ * 另外随机让写入和 fsync 返回错误，检查出错后继续追加、提交的行为。
+ *
+ * 用法：sd_journal_faults [轮数] [随机种子]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sd_journal.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+#define SECTOR 512
+#define MAX_PENDING 4096
+
+typedef struct
+{
+    uint64_t offset;
+    uint32_t len;
+} pending_t;
+
+typedef struct
+{
+    sd_journal_io_t parent;
+    uint8_t *cur;         /*!< 掉电前看到的内容 */
+    uint8_t *durable;     /*!< 已落盘的内容 */
+    uint64_t cur_size;
+    uint64_t durable_size;
+    uint64_t capacity;
+    pending_t pending[MAX_PENDING];
+    uint32_t pending_count;
+    uint32_t fail_permille; /*!< 写入和 fsync 返回错误的概率 */
+    bool dead;              /*!< 已掉电，所有写入和 fsync 都失败 */
+    uint32_t *rng;
+} mem_disk_t;
+
+static uint32_t test_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static esp_err_t mem_read(sd_journal_io_t *io, uint64_t offset, void *buf, size_t len)
+{
+    mem_disk_t *d = __containerof(io, mem_disk_t, parent);
+    memset(buf, 0, len);
+    if (offset < d->cur_size)
+    {
+        size_t n = d->cur_size - offset < len ? d->cur_size - offset : len;
+        memcpy(buf, d->cur + offset, n);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t mem_write(sd_journal_io_t *io, uint64_t offset, const void *buf, size_t len)
+{
+    mem_disk_t *d = __containerof(io, mem_disk_t, parent);
+    if (offset + len > d->capacity || d->pending_count == MAX_PENDING)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    if (d->dead || test_rand(d->rng) % 1000 < d->fail_permille)
+    {
+        return ESP_FAIL;
+    }
+    memcpy(d->cur + offset, buf, len);
+    if (offset + len > d->cur_size)
+    {
+        d->cur_size = offset + len;
+    }
+    d->pending[d->pending_count++] = (pending_t){offset, len};
+    return ESP_OK;
+}
+
+static esp_err_t mem_sync(sd_journal_io_t *io)
+{
+    mem_disk_t *d = __containerof(io, mem_disk_t, parent);
+    if (d->dead || test_rand(d->rng) % 1000 < d->fail_permille)
+    {
+        return ESP_FAIL;
+    }
+    for (uint32_t i = 0; i < d->pending_count; i++)
+    {
+        memcpy(d->durable + d->pending[i].offset, d->cur + d->pending[i].offset, d->pending[i].len);
+    }
+    d->durable_size = d->cur_size;
+    d->pending_count = 0;
+    return ESP_OK;
+}
+
+static esp_err_t mem_size(sd_journal_io_t *io, uint64_t *size)
+{
+    *size = __containerof(io, mem_disk_t, parent)->cur_size;
+    return ESP_OK;
+}
+
+static esp_err_t mem_del(sd_journal_io_t *io)
+{
+    return ESP_OK; // 磁盘在测试中反复使用，由 main 释放
+}
+
+/**
+ * @description: 模拟掉电：挂起的写入按扇区随机落盘，之后只剩已落盘的内容
+ */
+static void mem_power_loss(mem_disk_t *d)
+{
+    for (uint32_t i = 0; i < d->pending_count; i++)
+    {
+        const pending_t *p = &d->pending[i];
+        for (uint32_t s = 0; s < p->len; s += SECTOR)
+        {
+            // 同一个块后面的扇区比前面的更可能丢失，也允许中间缺一块
+            if (test_rand(d->rng) % 4 == 0)
+            {
+                continue;
+            }
+            uint32_t n = p->len - s < SECTOR ? p->len - s : SECTOR;
+            memcpy(d->durable + p->offset + s, d->cur + p->offset + s, n);
+            if (p->offset + s + n > d->durable_size)
+            {
+                d->durable_size = p->offset + s + n;
+            }
+        }
+    }
+    d->pending_count = 0;
+    d->dead = false;
+    memcpy(d->cur, d->durable, d->cur_size > d->durable_size ? d->cur_size : d->durable_size);
+    d->cur_size = d->durable_size;
+}
+
+// 第 seq 条记录的长度和内容由 seq 决定，读回时可以直接校验
+static size_t record_make(uint32_t seq, uint8_t *buf, size_t max)
+{
+    size_t len = 4 + (seq * 2654435761u >> 7) % (max - 4);
+    memcpy(buf, &seq, 4);
+    for (size_t i = 4; i < len; i++)
+    {
+        buf[i] = (uint8_t)(seq + i * 7);
+    }
+    return len;
+}
+
+typedef struct
+{
+    const uint8_t *acked;   /*!< 每条记录是否已提交 */
+    int64_t last_seq;
+    uint32_t count;
+    uint32_t errors;
+    size_t max_len;
+} verify_t;
+
+static bool verify_record(void *ctx, const void *data, size_t len)
+{
+    verify_t *v = ctx;
+    uint8_t expect[1024];
+    uint32_t seq;
+    if (len < 4)
+    {
+        v->errors++;
+        return false;
+    }
+    memcpy(&seq, data, 4);
+    if ((int64_t)seq <= v->last_seq || record_make(seq, expect, v->max_len) != len || memcmp(expect, data, len) != 0)
+    {
+        printf("  bad record: seq %u after %lld, len %zu\n", (unsigned)seq, (long long)v->last_seq, len);
+        v->errors++;
+        return false;
+    }
+    // 上一条读到的记录和这一条之间不能缺少已提交的记录
+    for (uint32_t s = (uint32_t)(v->last_seq + 1); s < seq; s++)
+    {
+        if (v->acked[s])
+        {
+            printf("  committed record %u lost (read %u after %lld)\n", (unsigned)s, (unsigned)seq, (long long)v->last_seq);
+            v->errors++;
+            break;
+        }
+    }
+    v->last_seq = seq;
+    v->count++;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rounds = argc > 1 ? strtoul(argv[1], NULL, 0) : 200;
+    uint32_t rng = argc > 2 ? strtoul(argv[2], NULL, 0) : 12345;
+    const uint32_t max_records = 400000;
+
+    mem_disk_t disk = {
+        .capacity = 64 * 1024 * 1024,
+        .rng = &rng,
+        .parent = {mem_read, mem_write, mem_sync, mem_size, mem_del},
+    };
+    disk.cur = calloc(1, disk.capacity);
+    disk.durable = calloc(1, disk.capacity);
+    uint8_t *acked = calloc(1, max_records);
+    if (!disk.cur || !disk.durable || !acked)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    sd_journal_config_t config = SD_JOURNAL_DEFAULT_CONFIG();
+    config.block_size = 1024;
+    config.sync_every = 8;
+    config.nonce = 0x5EED;
+    const size_t max_len = 300;
+
+    uint32_t seq = 0;
+    uint32_t failures = 0;
+    uint32_t max_reads = 0;
+    uint32_t stale = 0;
+    uint8_t buf[1024];
+    for (uint32_t round = 0; round < rounds && seq < max_records - 5000; round++)
+    {
+        disk.fail_permille = round % 3 == 2 ? 20 : 0;
+        // 注入的读写错误可能让打开失败，像应用一样重试几次
+        sd_journal_handle_t j;
+        esp_err_t ret = ESP_FAIL;
+        for (int attempt = 0; attempt < 5 && ret != ESP_OK; attempt++)
+        {
+            ret = sd_journal_open(&disk.parent, &config, &j);
+        }
+        if (ret != ESP_OK)
+        {
+            printf("round %u: open failed (0x%x)\n", (unsigned)round, ret);
+            failures++;
+            continue;
+        }
+
+        // 检查打开时读的块数
+        sd_journal_info_t info;
+        sd_journal_get_info(j, &info);
+        uint32_t limit = 2 + 3 * config.sync_every;
+        for (uint32_t n = info.blocks; n; n >>= 1)
+        {
+            limit++;
+        }
+        if (info.mount_reads > limit)
+        {
+            printf("round %u: %u reads to mount %u blocks (limit %u)\n",
+                   (unsigned)round, (unsigned)info.mount_reads, (unsigned)info.blocks, (unsigned)limit);
+            failures++;
+        }
+        max_reads = info.mount_reads > max_reads ? info.mount_reads : max_reads;
+        stale += info.stale_cleared;
+
+        verify_t v = {.acked = acked, .last_seq = -1, .max_len = max_len};
+        if (sd_journal_read(j, verify_record, &v) != ESP_OK || v.errors)
+        {
+            failures++;
+        }
+        for (uint32_t s = (uint32_t)(v.last_seq + 1); s < seq; s++)
+        {
+            if (acked[s])
+            {
+                printf("round %u: committed record %u lost at tail\n", (unsigned)round, (unsigned)s);
+                failures++;
+                break;
+            }
+        }
+
+        // 随机追加和提交，然后掉电
+        uint32_t ops = 50 + test_rand(&rng) % 1500;
+        uint32_t first_unacked = seq;
+        for (uint32_t i = 0; i < ops; i++)
+        {
+            size_t len = record_make(seq, buf, max_len);
+            if (sd_journal_append(j, buf, len) == ESP_OK)
+            {
+                seq++;
+            }
+            if (test_rand(&rng) % 100 == 0 && sd_journal_commit(j) == ESP_OK)
+            {
+                for (; first_unacked < seq; first_unacked++)
+                {
+                    acked[first_unacked] = 1;
+                }
+            }
+        }
+        // 先掉电再关闭，关闭时的提交全部失败，只释放句柄
+        disk.dead = true;
+        sd_journal_close(j);
+        mem_power_loss(&disk);
+    }
+
+    printf("rounds %u, records %u, largest file %u blocks, max mount reads %u, stale blocks cleared %u\n",
+           (unsigned)rounds, (unsigned)seq, (unsigned)(disk.durable_size / config.block_size),
+           (unsigned)max_reads, (unsigned)stale);
+    printf("%s (%u failures)\n", failures ? "FAILED" : "PASSED", (unsigned)failures);
+    free(disk.cur);
+    free(disk.durable);
+    free(acked);
+    return failures ? 1 : 0;
+}
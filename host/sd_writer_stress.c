@@ -0,0 +1,125 @@
+/*
+ * 在PC上验证 06_sdmmc/components/sd_async_writer：
+ * 生产者以固定频率追加记录，文件输出端注入写延时和周期性的长时间停顿（模拟SD卡擦除/垃圾回收），
+ * 结束后打印统计并读回文件，确认记录连续、丢弃数与统计一致。
+ * 给出 flush 间隔时每隔这么多条记录调用一次不等待的 sd_writer_flush()，停顿中超时返回的 flush 不能让追加阻塞。
+ *
+ * 用法：sd_writer_stress [输出文件] [频率Hz] [秒数] [停顿ms] [缓冲区块数] [flush间隔（条），0不flush]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "sd_async_writer.h"
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t timestamp_us;
+    int16_t samples[12];
+} record_t;
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "sd_writer_stress.bin";
+    uint32_t rate_hz = argc > 2 ? strtoul(argv[2], NULL, 0) : 4000;
+    uint32_t seconds = argc > 3 ? strtoul(argv[3], NULL, 0) : 3;
+    uint32_t stall_ms = argc > 4 ? strtoul(argv[4], NULL, 0) : 150;
+    uint32_t buffers = argc > 5 ? strtoul(argv[5], NULL, 0) : 4;
+    uint32_t flush_every = argc > 6 ? strtoul(argv[6], NULL, 0) : 0;
+
+    sd_writer_file_config_t file_config = {
+        .path = path,
+        .latency_us = 2000,
+        .stall_every = 16,
+        .stall_us = stall_ms * 1000,
+    };
+    sd_writer_sink_t *sink = sd_writer_sink_new_file(&file_config);
+    if (!sink)
+    {
+        return 1;
+    }
+    sd_writer_config_t config = SD_WRITER_DEFAULT_CONFIG();
+    config.buffer_count = buffers;
+    sd_writer_handle_t writer = sd_writer_create(&config, sink);
+    if (!writer)
+    {
+        return 1;
+    }
+
+    // 生产者从不阻塞（timeout = 0），记录单次追加的最长耗时
+    uint32_t total = rate_hz * seconds;
+    uint32_t accepted = 0;
+    int64_t worst_append = 0;
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < total; i++)
+    {
+        int64_t due = start + (int64_t)i * 1000000 / rate_hz;
+        while (esp_timer_get_time() < due)
+        {
+        }
+        record_t rec = {.seq = i, .timestamp_us = (uint32_t)(due - start)};
+        for (int s = 0; s < 12; s++)
+        {
+            rec.samples[s] = (int16_t)(i * 7 + s);
+        }
+        int64_t t0 = esp_timer_get_time();
+        if (sd_writer_append(writer, &rec, sizeof(rec), 0) == ESP_OK)
+        {
+            accepted++;
+        }
+        int64_t dt = esp_timer_get_time() - t0;
+        worst_append = dt > worst_append ? dt : worst_append;
+        if (flush_every && i % flush_every == flush_every - 1)
+        {
+            sd_writer_flush(writer, 0);
+        }
+    }
+
+    // 不等待的 flush 通常超时返回；之后删除时的 flush 和停止仍要等各自的那一次完成
+    esp_err_t early = sd_writer_flush(writer, 0);
+    sd_writer_stats_t stats;
+    sd_writer_get_stats(writer, &stats);
+    esp_err_t ret = sd_writer_delete(writer);
+    printf("flush without waiting: 0x%x, delete: 0x%x\n", early, ret);
+
+    printf("records: %u accepted, %u dropped (%.2f%%)\n", (unsigned)stats.records, (unsigned)stats.records_dropped,
+           100.0 * stats.records_dropped / total);
+    printf("buffers written: %u full, %u partial, %u syncs\n",
+           (unsigned)stats.buffers_written, (unsigned)stats.partial_writes, (unsigned)stats.syncs);
+    printf("worst append: %lld us, worst sink write: %u us, max in flight: %u/%u\n",
+           (long long)worst_append, (unsigned)stats.max_write_us, stats.max_in_flight, (unsigned)buffers - 1);
+
+    // 读回校验：序号严格递增，个数等于接受的记录数
+    FILE *f = fopen(path, "rb");
+    if (!f || ret != ESP_OK)
+    {
+        fprintf(stderr, "flush/readback failed\n");
+        return 1;
+    }
+    record_t rec;
+    uint32_t count = 0;
+    int64_t last = -1;
+    bool ok = true;
+    while (fread(&rec, sizeof(rec), 1, f) == 1)
+    {
+        if ((int64_t)rec.seq <= last || rec.samples[11] != (int16_t)(rec.seq * 7 + 11))
+        {
+            ok = false;
+        }
+        last = rec.seq;
+        count++;
+    }
+    fclose(f);
+    ok = ok && count == accepted && accepted == stats.records;
+    printf("readback: %u records, %s\n", (unsigned)count, ok ? "OK" : "MISMATCH");
+    // 生产者不等待，卡的停顿不应该传到追加上
+    if (stall_ms && worst_append >= (int64_t)stall_ms * 1000 / 2)
+    {
+        printf("append blocked by the sink stall\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+// 模拟的 ADC1：12 位读数，按衰减的量程换算输入电压，带增益和偏移误差；校准系数由同一误差得出
+#include <stdbool.h>
+#include "driver/adc.h"
+#include "esp_adc_cal.h"
+
+#define ADC_SIM_MAX_RAW 4095
+
+// ESP32-C3 各衰减下的量程（约）
+static const int s_full_scale_mv[ADC_ATTEN_MAX] = {750, 1050, 1300, 2500};
+
+static int s_input_mv[ADC1_CHANNEL_MAX];
+static adc_atten_t s_atten[ADC1_CHANNEL_MAX];
+static bool s_width_set = false;
+static int s_gain_permille = 0;
+static int s_offset_mv = 0;
+static esp_err_t s_efuse = ESP_OK;
+static uint32_t s_reads = 0;
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit)
+{
+    if (width_bit != ADC_WIDTH_BIT_12)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_width_set = true;
+    return ESP_OK;
+}
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten)
+{
+    if ((unsigned)channel >= ADC1_CHANNEL_MAX || (unsigned)atten >= ADC_ATTEN_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_atten[channel] = atten;
+    return ESP_OK;
+}
+
+int adc1_get_raw(adc1_channel_t channel)
+{
+    if ((unsigned)channel >= ADC1_CHANNEL_MAX || !s_width_set)
+    {
+        return -1;
+    }
+    s_reads++;
+    int64_t full = s_full_scale_mv[s_atten[channel]];
+    // 读数对应的电压，四舍五入到最近的读数
+    int64_t seen_uv = (int64_t)s_input_mv[channel] * (1000 + s_gain_permille) + (int64_t)s_offset_mv * 1000;
+    int64_t raw = (seen_uv * ADC_SIM_MAX_RAW + full * 500) / (full * 1000);
+    return raw < 0 ? 0 : raw > ADC_SIM_MAX_RAW ? ADC_SIM_MAX_RAW : (int)raw;
+}
+
+void adc_sim_set_input_mv(adc1_channel_t channel, int mv)
+{
+    if ((unsigned)channel < ADC1_CHANNEL_MAX)
+    {
+        s_input_mv[channel] = mv;
+    }
+}
+
+void adc_sim_set_error(int gain_permille, int offset_mv)
+{
+    s_gain_permille = gain_permille;
+    s_offset_mv = offset_mv;
+}
+
+int adc_sim_full_scale_mv(adc_atten_t atten)
+{
+    return (unsigned)atten < ADC_ATTEN_MAX ? s_full_scale_mv[atten] : 0;
+}
+
+uint32_t adc_sim_get_reads(void)
+{
+    return s_reads;
+}
+
+void adc_sim_set_efuse(esp_err_t tp_result)
+{
+    s_efuse = tp_result;
+}
+
+esp_err_t esp_adc_cal_check_efuse(esp_adc_cal_value_t value_type)
+{
+    if (value_type == ESP_ADC_CAL_VAL_EFUSE_TP)
+    {
+        return s_efuse;
+    }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num, adc_atten_t atten, adc_bits_width_t bit_width,
+                                             uint32_t default_vref, esp_adc_cal_characteristics_t *chars)
+{
+    bool tp = s_efuse == ESP_OK;
+    int gain = tp ? s_gain_permille : 0;
+    int offset = tp ? s_offset_mv : 0;
+    int64_t full = s_full_scale_mv[(unsigned)atten < ADC_ATTEN_MAX ? atten : 0];
+    *chars = (esp_adc_cal_characteristics_t){
+        .adc_num = adc_num,
+        .atten = atten,
+        .bit_width = bit_width,
+        // 电压 = (读数 × 量程 / 4095 - 偏移) × 1000 / (1000 + 增益)
+        .coeff_a = (uint32_t)((full * 1000 * 65536) / ((int64_t)ADC_SIM_MAX_RAW * (1000 + gain))),
+        .coeff_b = (uint32_t)(int32_t)(-(int64_t)offset * 1000 / (1000 + gain)),
+        .vref = tp ? 0 : default_vref,
+        .version = 1,
+    };
+    return tp ? ESP_ADC_CAL_VAL_EFUSE_TP : ESP_ADC_CAL_VAL_DEFAULT_VREF;
+}
+
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t *chars)
+{
+    int64_t mv = (((int64_t)adc_reading * chars->coeff_a + 32768) >> 16) + (int32_t)chars->coeff_b;
+    return mv < 0 ? 0 : (uint32_t)mv;
+}
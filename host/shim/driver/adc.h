@@ -0,0 +1,65 @@
+// PC上编译用的 driver/adc.h（ESP-IDF v4.4 的 ADC1 单次读取），ADC 由 adc_sim.c 模拟：
+// 测试用 adc_sim_set_input_mv() 设置每个通道上的电压，读数按衰减的量程换算，并带有芯片的增益和偏移误差
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum
+{
+    ADC_UNIT_1 = 1,
+    ADC_UNIT_2 = 2,
+} adc_unit_t;
+
+typedef enum
+{
+    ADC_ATTEN_DB_0 = 0,
+    ADC_ATTEN_DB_2_5,
+    ADC_ATTEN_DB_6,
+    ADC_ATTEN_DB_11,
+    ADC_ATTEN_MAX,
+} adc_atten_t;
+
+typedef enum
+{
+    ADC_WIDTH_BIT_12 = 3,
+    ADC_WIDTH_MAX,
+} adc_bits_width_t;
+
+#define ADC_WIDTH_BIT_DEFAULT ADC_WIDTH_BIT_12
+
+typedef enum
+{
+    ADC1_CHANNEL_0 = 0,
+    ADC1_CHANNEL_1,
+    ADC1_CHANNEL_2,
+    ADC1_CHANNEL_3,
+    ADC1_CHANNEL_4,
+    ADC1_CHANNEL_MAX,
+} adc1_channel_t;
+
+typedef int adc_channel_t;
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit);
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten);
+int adc1_get_raw(adc1_channel_t channel);
+
+/**
+ * @description: 通道上的输入电压
+ */
+void adc_sim_set_input_mv(adc1_channel_t channel, int mv);
+
+/**
+ * @description: 芯片的误差：读数对应的电压 = 输入 × (1000 + gain_permille) / 1000 + offset_mv
+ */
+void adc_sim_set_error(int gain_permille, int offset_mv);
+
+/**
+ * @description: 各衰减下 4095 对应的电压（mV）
+ */
+int adc_sim_full_scale_mv(adc_atten_t atten);
+
+/**
+ * @description: 读取的次数
+ */
+uint32_t adc_sim_get_reads(void);
@@ -0,0 +1,92 @@
+// PC上编译用的 driver/gpio.h，引脚由 gpio_sim.c 模拟：
+// 输出的电平保存起来，测试用 gpio_sim_get_output() 取出；输入的电平由测试用 gpio_sim_set_input() 设置，
+// 按中断类型在调用者的线程中调用 gpio_isr_handler_add() 注册的处理函数（相当于在中断中）
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC (-1)
+#define GPIO_NUM_MAX 49
+#define GPIO_SIM_NUM GPIO_NUM_MAX
+
+#define BIT64(nr) (1ULL << (nr))
+#define ESP_INTR_FLAG_DEFAULT 0
+
+typedef enum
+{
+    GPIO_MODE_DISABLE = 0,
+    GPIO_MODE_INPUT = 1,
+    GPIO_MODE_OUTPUT = 2,
+    GPIO_MODE_OUTPUT_OD = 6,
+    GPIO_MODE_INPUT_OUTPUT_OD = 7,
+    GPIO_MODE_INPUT_OUTPUT = 3,
+} gpio_mode_t;
+
+typedef enum
+{
+    GPIO_PULLUP_DISABLE = 0,
+    GPIO_PULLUP_ENABLE = 1,
+} gpio_pullup_t;
+
+typedef enum
+{
+    GPIO_PULLDOWN_DISABLE = 0,
+    GPIO_PULLDOWN_ENABLE = 1,
+} gpio_pulldown_t;
+
+typedef enum
+{
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_POSEDGE,
+    GPIO_INTR_NEGEDGE,
+    GPIO_INTR_ANYEDGE,
+    GPIO_INTR_LOW_LEVEL,
+    GPIO_INTR_HIGH_LEVEL,
+    GPIO_INTR_MAX,
+} gpio_int_type_t;
+
+typedef struct
+{
+    uint64_t pin_bit_mask;
+    gpio_mode_t mode;
+    gpio_pullup_t pull_up_en;
+    gpio_pulldown_t pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+
+typedef void (*gpio_isr_t)(void *arg);
+
+esp_err_t gpio_config(const gpio_config_t *config);
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num);
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode);
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+int gpio_get_level(gpio_num_t gpio_num);
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type);
+esp_err_t gpio_install_isr_service(int intr_alloc_flags);
+void gpio_uninstall_isr_service(void);
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args);
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num);
+
+/**
+ * @description: 设置输入引脚外部的电平，符合中断类型时调用中断处理函数
+ */
+void gpio_sim_set_input(gpio_num_t gpio_num, int level);
+
+/**
+ * @description: 输出引脚的电平
+ */
+int gpio_sim_get_output(gpio_num_t gpio_num);
+
+/**
+ * @description: 输出引脚电平变化的次数
+ */
+uint32_t gpio_sim_get_toggles(gpio_num_t gpio_num);
+
+/**
+ * @description: 所有引脚回到复位状态，删除中断服务
+ */
+void gpio_sim_reset(void);
@@ -0,0 +1,80 @@
+// PC上编译用的 driver/i2c.h（ESP-IDF v4.4），总线由 i2c_sim.c 模拟：
+// 测试用 i2c_sim_attach() 在某个地址上挂一个设备（写、读两个回调），没有设备的地址不应答（ESP_FAIL）；
+// 传输不等待，按时钟频率累计总线的时间（每字节 9 位，加上起始、地址和停止），测试用 i2c_sim_get_stats() 取出
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+
+typedef int i2c_port_t;
+
+#define I2C_NUM_0 0
+#define I2C_NUM_MAX 1
+
+typedef enum
+{
+    I2C_MODE_SLAVE = 0,
+    I2C_MODE_MASTER,
+    I2C_MODE_MAX,
+} i2c_mode_t;
+
+typedef struct
+{
+    i2c_mode_t mode;
+    int sda_io_num;
+    int scl_io_num;
+    bool sda_pullup_en;
+    bool scl_pullup_en;
+    union
+    {
+        struct
+        {
+            uint32_t clk_speed;
+        } master;
+    };
+    uint32_t clk_flags;
+} i2c_config_t;
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf);
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len, size_t slv_tx_buf_len,
+                             int intr_alloc_flags);
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num);
+esp_err_t i2c_master_write_to_device(i2c_port_t i2c_num, uint8_t device_address, const uint8_t *write_buffer,
+                                     size_t write_size, TickType_t ticks_to_wait);
+esp_err_t i2c_master_read_from_device(i2c_port_t i2c_num, uint8_t device_address, uint8_t *read_buffer,
+                                      size_t read_size, TickType_t ticks_to_wait);
+esp_err_t i2c_master_write_read_device(i2c_port_t i2c_num, uint8_t device_address, const uint8_t *write_buffer,
+                                       size_t write_size, uint8_t *read_buffer, size_t read_size,
+                                       TickType_t ticks_to_wait);
+
+/**
+ * @brief 模拟的 I2C 从机，回调在主机的线程中调用
+ */
+typedef struct
+{
+    esp_err_t (*write)(void *ctx, const uint8_t *data, size_t len); /*!< 一次写传输的全部数据，返回非 ESP_OK 表示不应答 */
+    esp_err_t (*read)(void *ctx, uint8_t *data, size_t len);        /*!< 一次读传输，填满 data */
+    void *ctx;
+} i2c_sim_device_t;
+
+typedef struct
+{
+    uint32_t transactions; /*!< 起始到停止的次数，写后读（重复起始）算一次 */
+    uint32_t bytes;        /*!< 数据字节数，不含地址 */
+    uint32_t nacks;        /*!< 没有设备或设备不应答 */
+    uint64_t bus_ns;       /*!< 按时钟频率计算的总线时间 */
+} i2c_sim_stats_t;
+
+/**
+ * @description: 在 addr 上挂一个设备，device 为 NULL 时取下
+ * @return       ESP_OK / ESP_ERR_INVALID_ARG
+ */
+esp_err_t i2c_sim_attach(i2c_port_t i2c_num, uint8_t addr, const i2c_sim_device_t *device);
+
+void i2c_sim_get_stats(i2c_port_t i2c_num, i2c_sim_stats_t *stats);
+
+void i2c_sim_reset_stats(i2c_port_t i2c_num);
@@ -0,0 +1,118 @@
+// PC上编译用的 driver/rmt.h（ESP-IDF v4.4 的旧驱动接口），发送通道由 rmt_sim.c 模拟：
+// rmt_write_sample() 按硬件的方式分段调用转换函数（先填满一块通道内存，其余的在发送中补充），
+// 转换出的 RMT 数据保存起来，测试用 rmt_sim_items() 取出；
+// 按数据的时长计算发送结束的时间，各通道同时发送，结束时调用 rmt_register_tx_end_callback() 注册的回调
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+
+#define RMT_SIM_MEM_ITEM_NUM 48 /*!< 每个通道一块内存的 RMT 数据个数（ESP32-C3） */
+
+typedef enum
+{
+    RMT_CHANNEL_0,
+    RMT_CHANNEL_1,
+    RMT_CHANNEL_2,
+    RMT_CHANNEL_3,
+    RMT_CHANNEL_MAX,
+} rmt_channel_t;
+
+typedef enum
+{
+    RMT_MODE_TX,
+    RMT_MODE_RX,
+} rmt_mode_t;
+
+typedef struct
+{
+    union
+    {
+        struct
+        {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
+
+typedef void (*sample_to_rmt_t)(const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num,
+                                size_t *translated_size, size_t *item_num);
+
+typedef void (*rmt_tx_end_fn_t)(rmt_channel_t channel, void *arg);
+
+typedef struct
+{
+    rmt_tx_end_fn_t function;
+    void *arg;
+} rmt_tx_end_callback_t;
+
+typedef struct
+{
+    bool loop_en;
+    bool carrier_en;
+    bool idle_output_en;
+    int idle_level;
+} rmt_tx_config_t;
+
+typedef struct
+{
+    rmt_mode_t rmt_mode;
+    rmt_channel_t channel;
+    gpio_num_t gpio_num;
+    uint8_t clk_div;
+    uint8_t mem_block_num;
+    uint32_t flags;
+    rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) \
+    {                                           \
+        .rmt_mode = RMT_MODE_TX,                \
+        .channel = channel_id,                  \
+        .gpio_num = gpio,                       \
+        .clk_div = 80,                          \
+        .mem_block_num = 1,                     \
+        .flags = 0,                             \
+        .tx_config = {                          \
+            .loop_en = false,                   \
+            .carrier_en = false,                \
+            .idle_output_en = true,             \
+            .idle_level = 0,                    \
+        },                                      \
+    }
+
+esp_err_t rmt_config(const rmt_config_t *rmt_param);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags);
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel);
+esp_err_t rmt_get_counter_clock(rmt_channel_t channel, uint32_t *clock_hz);
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn);
+esp_err_t rmt_translator_set_context(rmt_channel_t channel, void *context);
+esp_err_t rmt_translator_get_context(const size_t *item_num, void **context);
+rmt_tx_end_callback_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void *arg);
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done);
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time);
+
+/**
+ * @description: 通道注册的转换函数，用于单独测量
+ */
+sample_to_rmt_t rmt_sim_translator(rmt_channel_t channel);
+
+/**
+ * @description: 单独调用转换函数时传给它的 item_num，转换函数由这个地址取得通道的上下文
+ */
+size_t *rmt_sim_item_num(rmt_channel_t channel);
+
+/**
+ * @description: 最近一次 rmt_write_sample() 转换出的 RMT 数据
+ * @return       数据，没有发送过时返回 NULL
+ * @param {size_t} *num 数据个数
+ */
+const rmt_item32_t *rmt_sim_items(rmt_channel_t channel, size_t *num);
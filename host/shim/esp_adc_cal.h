@@ -0,0 +1,43 @@
+// PC上编译用的 esp_adc_cal.h，校准由 adc_sim.c 模拟：
+// eFuse 的状态由 adc_sim_set_efuse() 设置；eFuse 中有校准值时按模拟芯片的误差得出系数，读数换算后与输入一致，
+// 否则按理想的量程换算（同 ESP-IDF 没有校准值时的做法）
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/adc.h"
+
+typedef enum
+{
+    ESP_ADC_CAL_VAL_EFUSE_VREF = 0,
+    ESP_ADC_CAL_VAL_EFUSE_TP = 1,
+    ESP_ADC_CAL_VAL_DEFAULT_VREF = 2,
+    ESP_ADC_CAL_VAL_EFUSE_TP_FIT = 3,
+    ESP_ADC_CAL_VAL_MAX,
+    ESP_ADC_CAL_VAL_NOT_SUPPORTED = ESP_ADC_CAL_VAL_MAX,
+} esp_adc_cal_value_t;
+
+typedef struct
+{
+    adc_unit_t adc_num;
+    adc_atten_t atten;
+    adc_bits_width_t bit_width;
+    uint32_t coeff_a;    /*!< 每个读数的电压，16 位小数 */
+    uint32_t coeff_b;    /*!< 偏移（mV，有符号） */
+    uint32_t vref;
+    const uint32_t *low_curve;
+    const uint32_t *high_curve;
+    uint8_t version;
+} esp_adc_cal_characteristics_t;
+
+esp_err_t esp_adc_cal_check_efuse(esp_adc_cal_value_t value_type);
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num, adc_atten_t atten, adc_bits_width_t bit_width,
+                                             uint32_t default_vref, esp_adc_cal_characteristics_t *chars);
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t *chars);
+
+/**
+ * @description: esp_adc_cal_check_efuse(ESP_ADC_CAL_VAL_EFUSE_TP) 的返回值：
+ *               ESP_OK、ESP_ERR_NOT_SUPPORTED（不支持）或 ESP_ERR_INVALID_VERSION（eFuse 没有烧写）
+ */
+void adc_sim_set_efuse(esp_err_t tp_result);
@@ -0,0 +1,7 @@
+// PC上编译用的 esp_attr.h，放到 IRAM、DRAM 的属性在 PC 上没有意义
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
@@ -0,0 +1,7 @@
+// PC上编译用的 esp_rom_crc.h
+#pragma once
+
+#include <stdint.h>
+
+// CRC32（IEEE 802.3，与 zlib 相同），crc 传入上一次的结果，第一次传 0
+uint32_t esp_rom_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len);
@@ -0,0 +1,7 @@
+// PC上编译用的 esp_rom_sys.h
+#pragma once
+
+#include <stdint.h>
+
+// 忙等待，与 ROM 中的实现一样不让出 CPU
+void esp_rom_delay_us(uint32_t us);
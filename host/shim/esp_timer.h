@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// 单调时钟，微秒
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,43 @@
+// PC上编译用的 FreeRTOS 最小实现（基于 pthread），只包含本仓库组件用到的接口
+// 节拍固定为 1ms；临界区用一把全局递归锁实现
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 25
+#define configMAX_TASK_NAME_LEN 16
+#define configUSE_TRACE_FACILITY 0
+#define configGENERATE_RUN_TIME_STATS 0
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+typedef struct
+{
+    int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+#define portENTER_CRITICAL(mux) vPortEnterCritical()
+#define portEXIT_CRITICAL(mux) vPortExitCritical()
+#define portENTER_CRITICAL_ISR(mux) vPortEnterCritical()
+#define portEXIT_CRITICAL_ISR(mux) vPortExitCritical()
+#define portYIELD_FROM_ISR(...) ((void)0)
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct host_queue_s *QueueHandle_t;
+typedef QueueHandle_t xQueueHandle;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t q);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t timeout);
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t timeout);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t timeout);
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t timeout);
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item);
+BaseType_t xQueueReset(QueueHandle_t q);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q);
+
+#define xQueueSendToBack(q, item, timeout) xQueueSend(q, item, timeout)
+#define xQueueSendFromISR(q, item, woken) xQueueSend(q, item, 0)
+#define xQueueReceiveFromISR(q, item, woken) xQueueReceive(q, item, 0)
+#define xQueueOverwriteFromISR(q, item, woken) xQueueOverwrite(q, item)
@@ -0,0 +1,17 @@
+#pragma once
+
+// 与 FreeRTOS 相同，信号量就是元素大小为0的队列
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+
+#define xSemaphoreTake(sem, timeout) xQueueReceive(sem, NULL, timeout)
+#define xSemaphoreGive(sem) xQueueSend(sem, NULL, 0)
+#define xSemaphoreGiveFromISR(sem, woken) xQueueSend(sem, NULL, 0)
+#define xSemaphoreTakeFromISR(sem, woken) xQueueReceive(sem, NULL, 0)
+#define vSemaphoreDelete(sem) vQueueDelete(sem)
+#define uxSemaphoreGetCount(sem) uxQueueMessagesWaiting(sem)
@@ -0,0 +1,472 @@
+// FreeRTOS 接口在 PC 上的 pthread 实现，语义尽量与 FreeRTOS 一致，性能不作要求
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+struct host_task_s
+{
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    char name[configMAX_TASK_NAME_LEN];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+struct host_queue_s
+{
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+static pthread_mutex_t s_critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static __thread struct host_task_s *s_current = NULL;
+
+void vPortEnterCritical(void)
+{
+    pthread_mutex_lock(&s_critical);
+}
+
+void vPortExitCritical(void)
+{
+    pthread_mutex_unlock(&s_critical);
+}
+
+static uint64_t host_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// ticks 转成 pthread_cond_timedwait 的绝对时间（单调时钟）
+static struct timespec host_deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+static void host_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+// 在 cond 上等待，直到 ready 为真或超时；返回 ready 的结果
+#define HOST_WAIT(cond, lock, ready, ticks)                                        \
+    ({                                                                             \
+        bool ok_ = true;                                                           \
+        if (!(ready))                                                              \
+        {                                                                          \
+            if ((ticks) == 0)                                                      \
+            {                                                                      \
+                ok_ = false;                                                       \
+            }                                                                      \
+            else if ((ticks) == portMAX_DELAY)                                     \
+            {                                                                      \
+                while (!(ready))                                                   \
+                {                                                                  \
+                    pthread_cond_wait(cond, lock);                                 \
+                }                                                                  \
+            }                                                                      \
+            else                                                                   \
+            {                                                                      \
+                struct timespec dl_ = host_deadline(ticks);                        \
+                while (!(ready))                                                   \
+                {                                                                  \
+                    if (pthread_cond_timedwait(cond, lock, &dl_) == ETIMEDOUT)     \
+                    {                                                              \
+                        ok_ = (ready);                                             \
+                        break;                                                     \
+                    }                                                              \
+                }                                                                  \
+            }                                                                      \
+        }                                                                          \
+        ok_;                                                                       \
+    })
+
+static struct host_task_s *host_task_alloc(const char *name)
+{
+    struct host_task_s *t = calloc(1, sizeof(struct host_task_s));
+    if (!t)
+    {
+        return NULL;
+    }
+    strncpy(t->name, name ? name : "", sizeof(t->name) - 1);
+    pthread_mutex_init(&t->lock, NULL);
+    host_cond_init(&t->cond);
+    return t;
+}
+
+static void *host_task_entry(void *arg)
+{
+    struct host_task_s *t = arg;
+    s_current = t;
+    t->fn(t->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle)
+{
+    struct host_task_s *t = host_task_alloc(name);
+    if (!t)
+    {
+        return pdFAIL;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    if (handle)
+    {
+        *handle = t;
+    }
+    if (pthread_create(&t->thread, NULL, host_task_entry, t) != 0)
+    {
+        free(t);
+        return pdFAIL;
+    }
+    pthread_detach(t->thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    return xTaskCreate(fn, name, stack, arg, prio, handle);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == s_current)
+    {
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    uint64_t us = (uint64_t)ticks * portTICK_PERIOD_MS * 1000;
+    struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+void vTaskDelayUntil(TickType_t *prev, TickType_t inc)
+{
+    TickType_t target = *prev + inc;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(target - now) > 0)
+    {
+        vTaskDelay(target - now);
+    }
+    *prev = target;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    static uint64_t start = 0;
+    if (start == 0)
+    {
+        start = host_now_ms();
+    }
+    return (TickType_t)((host_now_ms() - start) / portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (!s_current)
+    {
+        // 不是由 xTaskCreate 创建的线程（例如 main），第一次调用时补一个任务结构
+        s_current = host_task_alloc("main");
+        s_current->thread = pthread_self();
+    }
+    return s_current;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t t, uint32_t value, eNotifyAction action)
+{
+    BaseType_t ret = pdPASS;
+    pthread_mutex_lock(&t->lock);
+    switch (action)
+    {
+    case eSetBits:
+        t->notify_value |= value;
+        break;
+    case eIncrement:
+        t->notify_value++;
+        break;
+    case eSetValueWithOverwrite:
+        t->notify_value = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (t->notify_pending)
+        {
+            ret = pdFAIL;
+        }
+        else
+        {
+            t->notify_value = value;
+        }
+        break;
+    default:
+        break;
+    }
+    t->notify_pending = true;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return ret;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t value, eNotifyAction action, BaseType_t *woken)
+{
+    return xTaskNotify(t, value, action);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t timeout)
+{
+    struct host_task_s *t = xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&t->lock);
+    if (!t->notify_pending)
+    {
+        t->notify_value &= ~clear_on_entry;
+    }
+    bool ok = HOST_WAIT(&t->cond, &t->lock, t->notify_pending, timeout);
+    if (value)
+    {
+        *value = t->notify_value;
+    }
+    if (ok)
+    {
+        t->notify_value &= ~clear_on_exit;
+        t->notify_pending = false;
+    }
+    pthread_mutex_unlock(&t->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+    return xTaskNotify(t, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken)
+{
+    xTaskNotify(t, 0, eIncrement);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t timeout)
+{
+    struct host_task_s *t = xTaskGetCurrentTaskHandle();
+    pthread_mutex_lock(&t->lock);
+    HOST_WAIT(&t->cond, &t->lock, t->notify_value != 0, timeout);
+    uint32_t value = t->notify_value;
+    if (value)
+    {
+        t->notify_value = clear ? 0 : value - 1;
+    }
+    t->notify_pending = false;
+    pthread_mutex_unlock(&t->lock);
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue_s *q = calloc(1, sizeof(struct host_queue_s));
+    if (!q)
+    {
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+    if (item_size)
+    {
+        q->storage = malloc((size_t)length * item_size);
+        if (!q->storage)
+        {
+            free(q);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    host_cond_init(&q->not_empty);
+    host_cond_init(&q->not_full);
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (!q)
+    {
+        return;
+    }
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    free(q->storage);
+    free(q);
+}
+
+static BaseType_t host_queue_send(QueueHandle_t q, const void *item, TickType_t timeout, bool front, bool overwrite)
+{
+    pthread_mutex_lock(&q->lock);
+    if (overwrite && q->count == q->length)
+    {
+        // 覆盖写只用于长度为1的队列
+        q->count = 0;
+    }
+    if (!HOST_WAIT(&q->not_full, &q->lock, q->count < q->length, timeout))
+    {
+        pthread_mutex_unlock(&q->lock);
+        return pdFAIL;
+    }
+    if (q->item_size)
+    {
+        UBaseType_t slot;
+        if (front)
+        {
+            q->head = (q->head + q->length - 1) % q->length;
+            slot = q->head;
+        }
+        else
+        {
+            slot = (q->head + q->count) % q->length;
+        }
+        memcpy(q->storage + (size_t)slot * q->item_size, item, q->item_size);
+    }
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t timeout)
+{
+    return host_queue_send(q, item, timeout, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t timeout)
+{
+    return host_queue_send(q, item, timeout, true, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item)
+{
+    return host_queue_send(q, item, 0, false, true);
+}
+
+static BaseType_t host_queue_receive(QueueHandle_t q, void *item, TickType_t timeout, bool peek)
+{
+    pthread_mutex_lock(&q->lock);
+    if (!HOST_WAIT(&q->not_empty, &q->lock, q->count > 0, timeout))
+    {
+        pthread_mutex_unlock(&q->lock);
+        return pdFAIL;
+    }
+    if (q->item_size && item)
+    {
+        memcpy(item, q->storage + (size_t)q->head * q->item_size, q->item_size);
+    }
+    if (!peek)
+    {
+        if (q->item_size)
+        {
+            q->head = (q->head + 1) % q->length;
+        }
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t timeout)
+{
+    return host_queue_receive(q, item, timeout, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t q, void *item, TickType_t timeout)
+{
+    return host_queue_receive(q, item, timeout, true);
+}
+
+BaseType_t xQueueReset(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->head = 0;
+    q->count = 0;
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t n = q->length - q->count;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t s = xQueueCreate(1, 0);
+    if (s)
+    {
+        s->count = 1;
+    }
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    SemaphoreHandle_t s = xQueueCreate(max, 0);
+    if (s)
+    {
+        s->count = initial;
+    }
+    return s;
+}
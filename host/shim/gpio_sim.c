@@ -0,0 +1,250 @@
+// 模拟的 GPIO：每个引脚的方向、输出和输入电平、中断类型和处理函数
+#include <string.h>
+#include <pthread.h>
+#include "driver/gpio.h"
+
+typedef struct
+{
+    gpio_mode_t mode;
+    bool pull_up;
+    int out;       /*!< 输出寄存器 */
+    int in;        /*!< 外部的电平，-1 表示悬空 */
+    uint32_t toggles;
+    gpio_int_type_t intr_type;
+    gpio_isr_t isr;
+    void *isr_arg;
+} gpio_sim_pin_t;
+
+static gpio_sim_pin_t s_pins[GPIO_SIM_NUM];
+static bool s_isr_service = false;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+
+static void gpio_sim_reset_pins(void)
+{
+    memset(s_pins, 0, sizeof(s_pins));
+    for (int i = 0; i < GPIO_SIM_NUM; i++)
+    {
+        s_pins[i].in = -1;
+    }
+}
+
+static gpio_sim_pin_t *gpio_sim_pin(gpio_num_t gpio_num)
+{
+    pthread_once(&s_once, gpio_sim_reset_pins);
+    return gpio_num >= 0 && gpio_num < GPIO_SIM_NUM ? &s_pins[gpio_num] : NULL;
+}
+
+/**
+ * @description: 引脚上读到的电平：输出打开时为输出电平（开漏时与外部电平线与），否则为外部电平，悬空时按上拉
+ */
+static int gpio_sim_level(const gpio_sim_pin_t *p)
+{
+    int ext = p->in >= 0 ? p->in : p->pull_up;
+    if (p->mode & GPIO_MODE_OUTPUT)
+    {
+        return (p->mode & 4) ? (p->out && ext) : p->out;
+    }
+    return ext;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    if (!config || config->pin_bit_mask == 0 || (config->pin_bit_mask >> GPIO_SIM_NUM))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < GPIO_SIM_NUM; i++)
+    {
+        if (config->pin_bit_mask & BIT64(i))
+        {
+            gpio_sim_pin_t *p = gpio_sim_pin(i);
+            pthread_mutex_lock(&s_lock);
+            p->mode = config->mode;
+            p->pull_up = config->pull_up_en;
+            p->intr_type = config->intr_type;
+            pthread_mutex_unlock(&s_lock);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    if (!p)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 与 ESP-IDF 一样：关闭输入输出，打开上拉，关闭中断
+    pthread_mutex_lock(&s_lock);
+    p->mode = GPIO_MODE_DISABLE;
+    p->pull_up = true;
+    p->intr_type = GPIO_INTR_DISABLE;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    if (!p)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    p->mode = mode;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    if (!p)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    int out = level ? 1 : 0;
+    if (out != p->out)
+    {
+        p->toggles++;
+    }
+    p->out = out;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    if (!p)
+    {
+        return 0;
+    }
+    pthread_mutex_lock(&s_lock);
+    // 输入关闭时读到 0
+    int level = (p->mode & GPIO_MODE_INPUT) ? gpio_sim_level(p) : 0;
+    pthread_mutex_unlock(&s_lock);
+    return level;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    if (!p || intr_type >= GPIO_INTR_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    p->intr_type = intr_type;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    pthread_mutex_lock(&s_lock);
+    esp_err_t ret = s_isr_service ? ESP_ERR_INVALID_STATE : ESP_OK;
+    s_isr_service = true;
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+void gpio_uninstall_isr_service(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_isr_service = false;
+    for (int i = 0; i < GPIO_SIM_NUM; i++)
+    {
+        s_pins[i].isr = NULL;
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    if (!p)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    esp_err_t ret = s_isr_service ? ESP_OK : ESP_ERR_INVALID_STATE;
+    if (ret == ESP_OK)
+    {
+        p->isr = isr_handler;
+        p->isr_arg = args;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    return gpio_isr_handler_add(gpio_num, NULL, NULL);
+}
+
+void gpio_sim_set_input(gpio_num_t gpio_num, int level)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    if (!p)
+    {
+        return;
+    }
+    pthread_mutex_lock(&s_lock);
+    int before = gpio_sim_level(p);
+    p->in = level ? 1 : 0;
+    int after = gpio_sim_level(p);
+    bool fire = false;
+    switch (p->intr_type)
+    {
+    case GPIO_INTR_POSEDGE:
+        fire = !before && after;
+        break;
+    case GPIO_INTR_NEGEDGE:
+        fire = before && !after;
+        break;
+    case GPIO_INTR_ANYEDGE:
+        fire = before != after;
+        break;
+    case GPIO_INTR_LOW_LEVEL:
+        fire = !after;
+        break;
+    case GPIO_INTR_HIGH_LEVEL:
+        fire = after;
+        break;
+    default:
+        break;
+    }
+    gpio_isr_t isr = (fire && (p->mode & GPIO_MODE_INPUT)) ? p->isr : NULL;
+    void *arg = p->isr_arg;
+    pthread_mutex_unlock(&s_lock);
+    // 处理函数中可以读引脚
+    if (isr)
+    {
+        isr(arg);
+    }
+}
+
+int gpio_sim_get_output(gpio_num_t gpio_num)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    return p ? p->out : 0;
+}
+
+uint32_t gpio_sim_get_toggles(gpio_num_t gpio_num)
+{
+    gpio_sim_pin_t *p = gpio_sim_pin(gpio_num);
+    return p ? p->toggles : 0;
+}
+
+void gpio_sim_reset(void)
+{
+    pthread_mutex_lock(&s_lock);
+    pthread_once(&s_once, gpio_sim_reset_pins);
+    gpio_sim_reset_pins();
+    s_isr_service = false;
+    pthread_mutex_unlock(&s_lock);
+}
@@ -0,0 +1,176 @@
+// 模拟的 I2C 主机：按地址分发给挂上的设备，统计传输次数、字节数和按时钟频率计算的总线时间
+#include <string.h>
+#include <pthread.h>
+#include "driver/i2c.h"
+
+#define I2C_SIM_ADDR_NUM 128
+
+typedef struct
+{
+    bool configured;
+    bool installed;
+    uint32_t clk_speed;
+    i2c_sim_device_t devices[I2C_SIM_ADDR_NUM];
+    i2c_sim_stats_t stats;
+} i2c_sim_port_t;
+
+static i2c_sim_port_t s_ports[I2C_NUM_MAX];
+// 与驱动一样，一个端口上的传输依次进行
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static i2c_sim_port_t *i2c_sim_port(i2c_port_t i2c_num)
+{
+    return i2c_num >= 0 && i2c_num < I2C_NUM_MAX ? &s_ports[i2c_num] : NULL;
+}
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf)
+{
+    i2c_sim_port_t *p = i2c_sim_port(i2c_num);
+    if (!p || !i2c_conf || i2c_conf->mode != I2C_MODE_MASTER || i2c_conf->master.clk_speed == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    p->clk_speed = i2c_conf->master.clk_speed;
+    p->configured = true;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len, size_t slv_tx_buf_len,
+                             int intr_alloc_flags)
+{
+    i2c_sim_port_t *p = i2c_sim_port(i2c_num);
+    if (!p || mode != I2C_MODE_MASTER)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    esp_err_t ret = p->installed ? ESP_FAIL : ESP_OK;
+    p->installed = true;
+    if (!p->configured)
+    {
+        p->clk_speed = 100000;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num)
+{
+    i2c_sim_port_t *p = i2c_sim_port(i2c_num);
+    if (!p)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    esp_err_t ret = p->installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+    p->installed = false;
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+/**
+ * @description: 一次传输的总线时间：起始、地址、每字节 9 位、停止，重复起始再加一个地址
+ */
+static void i2c_sim_account(i2c_sim_port_t *p, size_t wlen, size_t rlen, bool ok)
+{
+    size_t frames = 1 + wlen + rlen + (wlen && rlen ? 1 : 0);
+    p->stats.transactions++;
+    p->stats.bytes += wlen + rlen;
+    p->stats.nacks += !ok;
+    // 起始和停止各算一位
+    p->stats.bus_ns += (uint64_t)(frames * 9 + 2) * 1000000000ull / p->clk_speed;
+}
+
+static esp_err_t i2c_sim_transfer(i2c_port_t i2c_num, uint8_t addr, const uint8_t *wbuf, size_t wlen, uint8_t *rbuf,
+                                  size_t rlen)
+{
+    i2c_sim_port_t *p = i2c_sim_port(i2c_num);
+    if (!p || addr >= I2C_SIM_ADDR_NUM || (wlen && !wbuf) || (rlen && !rbuf))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    if (!p->installed)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    const i2c_sim_device_t *dev = &p->devices[addr];
+    esp_err_t ret = ESP_OK;
+    if (!dev->write && !dev->read)
+    {
+        ret = ESP_FAIL;
+    }
+    if (ret == ESP_OK && wlen)
+    {
+        ret = dev->write ? dev->write(dev->ctx, wbuf, wlen) : ESP_FAIL;
+    }
+    if (ret == ESP_OK && rlen)
+    {
+        ret = dev->read ? dev->read(dev->ctx, rbuf, rlen) : ESP_FAIL;
+    }
+    i2c_sim_account(p, wlen, rlen, ret == ESP_OK);
+    pthread_mutex_unlock(&s_lock);
+    // 不应答时驱动返回 ESP_FAIL
+    return ret == ESP_OK ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2c_master_write_to_device(i2c_port_t i2c_num, uint8_t device_address, const uint8_t *write_buffer,
+                                     size_t write_size, TickType_t ticks_to_wait)
+{
+    return i2c_sim_transfer(i2c_num, device_address, write_buffer, write_size, NULL, 0);
+}
+
+esp_err_t i2c_master_read_from_device(i2c_port_t i2c_num, uint8_t device_address, uint8_t *read_buffer,
+                                      size_t read_size, TickType_t ticks_to_wait)
+{
+    return i2c_sim_transfer(i2c_num, device_address, NULL, 0, read_buffer, read_size);
+}
+
+esp_err_t i2c_master_write_read_device(i2c_port_t i2c_num, uint8_t device_address, const uint8_t *write_buffer,
+                                       size_t write_size, uint8_t *read_buffer, size_t read_size,
+                                       TickType_t ticks_to_wait)
+{
+    return i2c_sim_transfer(i2c_num, device_address, write_buffer, write_size, read_buffer, read_size);
+}
+
+esp_err_t i2c_sim_attach(i2c_port_t i2c_num, uint8_t addr, const i2c_sim_device_t *device)
+{
+    i2c_sim_port_t *p = i2c_sim_port(i2c_num);
+    if (!p || addr >= I2C_SIM_ADDR_NUM)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    if (device)
+    {
+        p->devices[addr] = *device;
+    }
+    else
+    {
+        memset(&p->devices[addr], 0, sizeof(p->devices[addr]));
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+void i2c_sim_get_stats(i2c_port_t i2c_num, i2c_sim_stats_t *stats)
+{
+    i2c_sim_port_t *p = i2c_sim_port(i2c_num);
+    pthread_mutex_lock(&s_lock);
+    *stats = p ? p->stats : (i2c_sim_stats_t){0};
+    pthread_mutex_unlock(&s_lock);
+}
+
+void i2c_sim_reset_stats(i2c_port_t i2c_num)
+{
+    i2c_sim_port_t *p = i2c_sim_port(i2c_num);
+    if (p)
+    {
+        pthread_mutex_lock(&s_lock);
+        memset(&p->stats, 0, sizeof(p->stats));
+        pthread_mutex_unlock(&s_lock);
+    }
+}
@@ -0,0 +1,362 @@
+// 模拟的 RMT 发送通道：计数时钟按 80MHz APB 时钟分频，转换函数按硬件的方式分段调用
+// rmt_write_sample() 只转换第一块通道内存，其余的由模拟中断的线程在发送结束时转换（与硬件一样，
+// 发送中修改源数据会改变发出的数据）。发送的时间按第一段数据估计，结束时调用发送完成的回调。
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/cdefs.h>
+#include "esp_timer.h"
+#include "driver/rmt.h"
+
+#define RMT_SIM_APB_CLK_HZ 80000000
+
+typedef struct
+{
+    bool configured;
+    bool installed;
+    uint8_t clk_div;
+    uint8_t mem_block_num;
+    sample_to_rmt_t translator;
+    void *context;
+    size_t item_num;     /*!< 传给转换函数的 item_num，由它找到通道的上下文 */
+    bool busy;           /*!< 正在发送 */
+    int64_t done_us;     /*!< 发送结束的时间 */
+    const uint8_t *src;  /*!< 还没有转换的源数据 */
+    size_t src_size;
+    rmt_item32_t *items; /*!< 最近一次发送的数据 */
+    size_t num;
+    size_t cap;
+} rmt_sim_channel_t;
+
+static rmt_sim_channel_t s_channels[RMT_CHANNEL_MAX];
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond; /*!< 开始发送、发送结束，用单调时钟 */
+static bool s_isr_started = false;
+static rmt_tx_end_callback_t s_tx_end = {NULL, NULL};
+
+static rmt_sim_channel_t *rmt_sim_get(rmt_channel_t channel)
+{
+    return (unsigned)channel < RMT_CHANNEL_MAX ? &s_channels[channel] : NULL;
+}
+
+static struct timespec rmt_sim_abstime(int64_t until_us)
+{
+    // esp_timer_get_time() 与 CLOCK_MONOTONIC 相同，条件变量也用这个时钟
+    struct timespec ts = {until_us / 1000000, (until_us % 1000000) * 1000};
+    return ts;
+}
+
+static void rmt_sim_init_cond(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static pthread_cond_t *rmt_sim_cond(void)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, rmt_sim_init_cond);
+    return &s_cond;
+}
+
+/**
+ * @description: 转换源数据，wanted 为 0 时转换全部（按半块补充）
+ * @return       ESP_OK / ESP_ERR_NO_MEM / ESP_FAIL（转换函数的结果不对）
+ */
+static esp_err_t rmt_sim_translate(rmt_sim_channel_t *ch, size_t wanted)
+{
+    size_t block = (size_t)RMT_SIM_MEM_ITEM_NUM * ch->mem_block_num;
+    bool all = wanted == 0;
+    do
+    {
+        if (ch->src_size == 0)
+        {
+            break;
+        }
+        if (all)
+        {
+            wanted = block / 2;
+        }
+        if (ch->cap < ch->num + wanted + 8)
+        {
+            size_t cap = ch->cap ? ch->cap * 2 : block * 4;
+            while (cap < ch->num + wanted + 8)
+            {
+                cap *= 2;
+            }
+            rmt_item32_t *items = realloc(ch->items, cap * sizeof(rmt_item32_t));
+            if (!items)
+            {
+                return ESP_ERR_NO_MEM;
+            }
+            ch->items = items;
+            ch->cap = cap;
+        }
+        size_t translated = 0;
+        ch->item_num = 0;
+        ch->translator(ch->src, ch->items + ch->num, ch->src_size, wanted, &translated, &ch->item_num);
+        // 转换函数以字节为单位，最多多转换 7 个
+        if (translated == 0 || translated > ch->src_size || ch->item_num > wanted + 7)
+        {
+            ch->src_size = 0;
+            return ESP_FAIL;
+        }
+        ch->src += translated;
+        ch->src_size -= translated;
+        ch->num += ch->item_num;
+    } while (all);
+    return ESP_OK;
+}
+
+/**
+ * @description: 模拟发送结束的中断：到时间后转换剩下的数据，调用回调
+ */
+static void *rmt_sim_isr_thread(void *arg)
+{
+    pthread_mutex_lock(&s_lock);
+    while (1)
+    {
+        rmt_sim_channel_t *next = NULL;
+        for (int i = 0; i < RMT_CHANNEL_MAX; i++)
+        {
+            if (s_channels[i].busy && (!next || s_channels[i].done_us < next->done_us))
+            {
+                next = &s_channels[i];
+            }
+        }
+        if (!next)
+        {
+            pthread_cond_wait(rmt_sim_cond(), &s_lock);
+            continue;
+        }
+        if (esp_timer_get_time() < next->done_us)
+        {
+            struct timespec ts = rmt_sim_abstime(next->done_us);
+            pthread_cond_timedwait(rmt_sim_cond(), &s_lock, &ts);
+            continue;
+        }
+        rmt_sim_translate(next, 0);
+        // 中断返回之前任务不会运行：先调用回调，再让等待的任务继续
+        rmt_tx_end_callback_t cb = s_tx_end;
+        rmt_channel_t channel = (rmt_channel_t)(next - s_channels);
+        pthread_mutex_unlock(&s_lock);
+        if (cb.function)
+        {
+            cb.function(channel, cb.arg);
+        }
+        pthread_mutex_lock(&s_lock);
+        next->busy = false;
+        pthread_cond_broadcast(rmt_sim_cond());
+    }
+    return NULL;
+}
+
+/**
+ * @description: 等到通道空闲，调用时已加锁
+ * @return       ESP_OK / ESP_ERR_TIMEOUT
+ */
+static esp_err_t rmt_sim_wait_idle(rmt_sim_channel_t *ch, int64_t until_us)
+{
+    struct timespec ts = rmt_sim_abstime(until_us);
+    while (ch->busy)
+    {
+        if (pthread_cond_timedwait(rmt_sim_cond(), &s_lock, &ts) == ETIMEDOUT && ch->busy)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_config(const rmt_config_t *rmt_param)
+{
+    rmt_sim_channel_t *ch = rmt_param ? rmt_sim_get(rmt_param->channel) : NULL;
+    if (!ch || rmt_param->clk_div == 0 || rmt_param->mem_block_num == 0 ||
+        rmt_param->channel + rmt_param->mem_block_num > RMT_CHANNEL_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ch->configured = true;
+    ch->clk_div = rmt_param->clk_div;
+    ch->mem_block_num = rmt_param->mem_block_num;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    if (!ch || !ch->configured)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    esp_err_t ret = ESP_OK;
+    if (ch->installed)
+    {
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    else
+    {
+        ch->installed = true;
+        if (!s_isr_started)
+        {
+            pthread_t thread;
+            s_isr_started = pthread_create(&thread, NULL, rmt_sim_isr_thread, NULL) == 0;
+            if (s_isr_started)
+            {
+                pthread_detach(thread);
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    if (!ch || !ch->installed)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pthread_mutex_lock(&s_lock);
+    rmt_sim_wait_idle(ch, INT64_MAX / 2);
+    free(ch->items);
+    memset(ch, 0, sizeof(*ch));
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_get_counter_clock(rmt_channel_t channel, uint32_t *clock_hz)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    if (!ch || !ch->configured || !clock_hz)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *clock_hz = RMT_SIM_APB_CLK_HZ / ch->clk_div;
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    if (!ch || !fn)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ch->translator = fn;
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_set_context(rmt_channel_t channel, void *context)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    if (!ch)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ch->context = context;
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_get_context(const size_t *item_num, void **context)
+{
+    // 与驱动一样由 item_num 的地址找到通道
+    if (!item_num || !context)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const rmt_sim_channel_t *ch = __containerof(item_num, rmt_sim_channel_t, item_num);
+    *context = ch->context;
+    return ESP_OK;
+}
+
+rmt_tx_end_callback_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void *arg)
+{
+    pthread_mutex_lock(&s_lock);
+    rmt_tx_end_callback_t prev = s_tx_end;
+    s_tx_end.function = function;
+    s_tx_end.arg = arg;
+    pthread_mutex_unlock(&s_lock);
+    return prev;
+}
+
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    if (!ch || !ch->installed || !ch->translator)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    pthread_mutex_lock(&s_lock);
+    // 上一次还没发完时等待，与驱动一致
+    rmt_sim_wait_idle(ch, INT64_MAX / 2);
+    ch->num = 0;
+    ch->src = src;
+    ch->src_size = src_size;
+    // 先填满通道内存
+    size_t total = src_size;
+    esp_err_t ret = rmt_sim_translate(ch, (size_t)RMT_SIM_MEM_ITEM_NUM * ch->mem_block_num);
+    if (ret != ESP_OK || src_size == 0)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return ret;
+    }
+    // 按已转换的部分估计全部的时长
+    uint64_t ticks = 0;
+    for (size_t i = 0; i < ch->num; i++)
+    {
+        ticks += ch->items[i].duration0 + ch->items[i].duration1;
+    }
+    ticks = ticks * total / (total - ch->src_size);
+    uint32_t clk_hz = RMT_SIM_APB_CLK_HZ / ch->clk_div;
+    ch->done_us = esp_timer_get_time() + (int64_t)(ticks * 1000000 / clk_hz);
+    ch->busy = true;
+    pthread_cond_broadcast(rmt_sim_cond());
+    if (wait_tx_done)
+    {
+        rmt_sim_wait_idle(ch, INT64_MAX / 2);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    if (!ch || !ch->installed)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int64_t until = wait_time == portMAX_DELAY ? INT64_MAX / 2
+                                               : esp_timer_get_time() + (int64_t)wait_time * 1000 * portTICK_PERIOD_MS;
+    pthread_mutex_lock(&s_lock);
+    esp_err_t ret = rmt_sim_wait_idle(ch, until);
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+sample_to_rmt_t rmt_sim_translator(rmt_channel_t channel)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    return ch ? ch->translator : NULL;
+}
+
+size_t *rmt_sim_item_num(rmt_channel_t channel)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    return ch ? &ch->item_num : NULL;
+}
+
+const rmt_item32_t *rmt_sim_items(rmt_channel_t channel, size_t *num)
+{
+    rmt_sim_channel_t *ch = rmt_sim_get(channel);
+    *num = ch ? ch->num : 0;
+    return ch ? ch->items : NULL;
+}
@@ -0,0 +1,9 @@
+// PC上编译用的 sys/cdefs.h：系统的定义之外补上 newlib 中的 __containerof
+#pragma once
+
+#include_next <sys/cdefs.h>
+#include <stddef.h>
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
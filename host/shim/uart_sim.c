@@ -0,0 +1,434 @@
+// 模拟的串口：接收缓冲区是环形缓冲区，事件队列和结束符位置队列与驱动的行为一致，发送的数据保存在另一个缓冲区
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include "driver/uart.h"
+
+#define UART_SIM_TX_SIZE 65536
+
+typedef struct
+{
+    bool installed;
+    uint32_t baud_rate;
+    QueueHandle_t events;
+    uint8_t *rx;        /*!< 环形接收缓冲区 */
+    size_t rx_size;
+    size_t rx_head;     /*!< 下一个读的位置 */
+    size_t rx_len;
+    size_t rx_total;    /*!< 读出的总字节数，结束符位置由此换算 */
+    bool pattern_en;
+    uint8_t pattern;
+    int *pos;           /*!< 结束符位置队列（相对接收缓冲区开头） */
+    int pos_size;
+    int pos_head;
+    int pos_len;
+    uint8_t *tx;
+    size_t tx_len;
+    uint32_t events_sent;
+    uint32_t events_dropped;
+} uart_sim_port_t;
+
+static uart_sim_port_t s_ports[UART_NUM_MAX];
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_rx_cond;
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+
+static void uart_sim_init_cond(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s_rx_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static uart_sim_port_t *uart_sim_port(uart_port_t uart_num)
+{
+    pthread_once(&s_once, uart_sim_init_cond);
+    return uart_num >= 0 && uart_num < UART_NUM_MAX ? &s_ports[uart_num] : NULL;
+}
+
+static uart_sim_port_t *uart_sim_installed(uart_port_t uart_num)
+{
+    uart_sim_port_t *p = uart_sim_port(uart_num);
+    return p && p->installed ? p : NULL;
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config)
+{
+    uart_sim_port_t *p = uart_sim_port(uart_num);
+    if (!p || !uart_config || uart_config->baud_rate <= 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    p->baud_rate = uart_config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+    return uart_sim_port(uart_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t *uart_queue, int intr_alloc_flags)
+{
+    uart_sim_port_t *p = uart_sim_port(uart_num);
+    // 与驱动一样，接收缓冲区要大于 FIFO
+    if (!p || rx_buffer_size <= UART_SIM_FIFO_LEN)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    if (p->installed)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_FAIL;
+    }
+    p->rx = malloc(rx_buffer_size);
+    p->tx = malloc(UART_SIM_TX_SIZE);
+    p->events = (queue_size > 0 && uart_queue) ? xQueueCreate(queue_size, sizeof(uart_event_t)) : NULL;
+    if (!p->rx || !p->tx || (queue_size > 0 && uart_queue && !p->events))
+    {
+        free(p->rx);
+        free(p->tx);
+        if (p->events)
+        {
+            vQueueDelete(p->events);
+        }
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    p->rx_size = rx_buffer_size;
+    p->rx_head = p->rx_len = p->rx_total = 0;
+    p->tx_len = 0;
+    p->pattern_en = false;
+    p->events_sent = p->events_dropped = 0;
+    if (p->baud_rate == 0)
+    {
+        p->baud_rate = 115200;
+    }
+    p->installed = true;
+    if (uart_queue)
+    {
+        *uart_queue = p->events;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p)
+    {
+        return ESP_FAIL;
+    }
+    pthread_mutex_lock(&s_lock);
+    p->installed = false;
+    free(p->rx);
+    free(p->tx);
+    free(p->pos);
+    p->rx = p->tx = NULL;
+    p->pos = NULL;
+    p->pos_size = 0;
+    if (p->events)
+    {
+        vQueueDelete(p->events);
+        p->events = NULL;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+/**
+ * @description: 在锁外发出一个事件，队列满时丢弃（驱动也是这样）
+ */
+static void uart_sim_post(uart_sim_port_t *p, uart_event_type_t type, size_t size)
+{
+    uart_event_t event = {.type = type, .size = size};
+    p->events_sent++;
+    if (p->events && xQueueSend(p->events, &event, 0) != pdPASS)
+    {
+        p->events_dropped++;
+    }
+}
+
+int uart_sim_inject(uart_port_t uart_num, const void *data, size_t len)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p || (!data && len))
+    {
+        return -1;
+    }
+    const uint8_t *src = (const uint8_t *)data;
+    size_t accepted = 0;
+    // 每次最多一个 FIFO 的数据，与接收中断的粒度相同
+    while (len > 0)
+    {
+        size_t chunk = len < UART_SIM_FIFO_LEN ? len : UART_SIM_FIFO_LEN;
+        uart_event_type_t types[UART_SIM_FIFO_LEN + 1];
+        int n_events = 0;
+        bool full = false;
+        pthread_mutex_lock(&s_lock);
+        size_t stored = 0;
+        for (; stored < chunk && p->rx_len < p->rx_size; stored++)
+        {
+            uint8_t c = src[stored];
+            size_t at = (p->rx_head + p->rx_len) % p->rx_size;
+            p->rx[at] = c;
+            if (p->pattern_en && c == p->pattern)
+            {
+                if (p->pos_len < p->pos_size)
+                {
+                    // 位置相对于读出的位置，取出时再换算
+                    p->pos[(p->pos_head + p->pos_len) % p->pos_size] = (int)(p->rx_total + p->rx_len);
+                    p->pos_len++;
+                }
+                types[n_events++] = UART_PATTERN_DET;
+            }
+            p->rx_len++;
+        }
+        full = stored < chunk;
+        pthread_cond_broadcast(&s_rx_cond);
+        pthread_mutex_unlock(&s_lock);
+
+        if (n_events == 0 && stored)
+        {
+            uart_sim_post(p, UART_DATA, stored);
+        }
+        for (int i = 0; i < n_events; i++)
+        {
+            uart_sim_post(p, types[i], 0);
+        }
+        accepted += stored;
+        if (full)
+        {
+            uart_sim_post(p, UART_BUFFER_FULL, 0);
+            break;
+        }
+        src += chunk;
+        len -= chunk;
+    }
+    return (int)accepted;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p || (!buf && length))
+    {
+        return -1;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    uint64_t ms = ticks_to_wait == portMAX_DELAY ? 0 : (uint64_t)ticks_to_wait * portTICK_PERIOD_MS;
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    uint8_t *dst = (uint8_t *)buf;
+    size_t got = 0;
+    pthread_mutex_lock(&s_lock);
+    while (got < length)
+    {
+        while (p->rx_len > 0 && got < length)
+        {
+            dst[got++] = p->rx[p->rx_head];
+            p->rx_head = (p->rx_head + 1) % p->rx_size;
+            p->rx_len--;
+            p->rx_total++;
+        }
+        if (got == length || ticks_to_wait == 0)
+        {
+            break;
+        }
+        int err = ticks_to_wait == portMAX_DELAY ? pthread_cond_wait(&s_rx_cond, &s_lock)
+                                                 : pthread_cond_timedwait(&s_rx_cond, &s_lock, &deadline);
+        if (err == ETIMEDOUT || !p->installed)
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return (int)got;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p || (!src && size))
+    {
+        return -1;
+    }
+    pthread_mutex_lock(&s_lock);
+    size_t n = size < UART_SIM_TX_SIZE - p->tx_len ? size : UART_SIM_TX_SIZE - p->tx_len;
+    memcpy(p->tx + p->tx_len, src, n);
+    p->tx_len += n;
+    pthread_mutex_unlock(&s_lock);
+    return (int)size;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait)
+{
+    return uart_sim_installed(uart_num) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p || !size)
+    {
+        return ESP_FAIL;
+    }
+    pthread_mutex_lock(&s_lock);
+    *size = p->rx_len;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p)
+    {
+        return ESP_FAIL;
+    }
+    pthread_mutex_lock(&s_lock);
+    p->rx_total += p->rx_len;
+    p->rx_head = (p->rx_head + p->rx_len) % p->rx_size;
+    p->rx_len = 0;
+    p->pos_head = p->pos_len = 0;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t uart_num, uint32_t baudrate)
+{
+    uart_sim_port_t *p = uart_sim_port(uart_num);
+    if (!p || baudrate == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    p->baud_rate = baudrate;
+    return ESP_OK;
+}
+
+esp_err_t uart_get_baudrate(uart_port_t uart_num, uint32_t *baudrate)
+{
+    uart_sim_port_t *p = uart_sim_port(uart_num);
+    if (!p || !baudrate)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *baudrate = p->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t uart_num, char pattern_chr, uint8_t chr_num, int chr_tout,
+                                            int post_idle, int pre_idle)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    // 只模拟单个字符的结束符
+    if (!p || chr_num != 1)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    p->pattern = (uint8_t)pattern_chr;
+    p->pattern_en = true;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_disable_pattern_det_intr(uart_port_t uart_num)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p)
+    {
+        return ESP_FAIL;
+    }
+    p->pattern_en = false;
+    return ESP_OK;
+}
+
+esp_err_t uart_pattern_queue_reset(uart_port_t uart_num, int queue_length)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p || queue_length <= 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int *pos = malloc(sizeof(int) * queue_length);
+    if (!pos)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    pthread_mutex_lock(&s_lock);
+    free(p->pos);
+    p->pos = pos;
+    p->pos_size = queue_length;
+    p->pos_head = p->pos_len = 0;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+int uart_pattern_pop_pos(uart_port_t uart_num)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p)
+    {
+        return -1;
+    }
+    int ret = -1;
+    pthread_mutex_lock(&s_lock);
+    // 已经被读走的位置不再有效，与驱动一样跳过
+    while (p->pos_len > 0 && ret < 0)
+    {
+        int abs = p->pos[p->pos_head];
+        p->pos_head = (p->pos_head + 1) % p->pos_size;
+        p->pos_len--;
+        if ((size_t)abs >= p->rx_total)
+        {
+            ret = (int)((size_t)abs - p->rx_total);
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+size_t uart_sim_take_tx(uart_port_t uart_num, void *buf, size_t size)
+{
+    uart_sim_port_t *p = uart_sim_installed(uart_num);
+    if (!p)
+    {
+        return 0;
+    }
+    pthread_mutex_lock(&s_lock);
+    size_t n = size < p->tx_len ? size : p->tx_len;
+    memcpy(buf, p->tx, n);
+    memmove(p->tx, p->tx + n, p->tx_len - n);
+    p->tx_len -= n;
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
+
+void uart_sim_get_event_counts(uart_port_t uart_num, uint32_t *events, uint32_t *dropped)
+{
+    uart_sim_port_t *p = uart_sim_port(uart_num);
+    pthread_mutex_lock(&s_lock);
+    if (events)
+    {
+        *events = p ? p->events_sent : 0;
+    }
+    if (dropped)
+    {
+        *dropped = p ? p->events_dropped : 0;
+    }
+    pthread_mutex_unlock(&s_lock);
+}
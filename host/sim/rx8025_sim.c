@@ -0,0 +1,137 @@
+#include <string.h>
+#include "rx8025_sim.h"
+#include "esp_timer.h"
+
+#define RX8025_SIM_REG_SEC 0x00
+#define RX8025_SIM_REG_YEAR 0x06
+#define RX8025_SIM_REG_FLAG 0x0E
+#define RX8025_SIM_FLAG_VLF 0x02
+
+static uint8_t rx8025_sim_bcd(int v)
+{
+    return ((v / 10) << 4) | (v % 10);
+}
+
+static int rx8025_sim_bin(uint8_t v)
+{
+    return (v >> 4) * 10 + (v & 0x0F);
+}
+
+time_t rx8025_sim_get_time(const rx8025_sim_t *sim)
+{
+    if (sim->stopped)
+    {
+        return sim->base;
+    }
+    return sim->base + (esp_timer_get_time() - sim->base_us) / 1000000;
+}
+
+/**
+ * @description: 当前时间写入时间寄存器
+ */
+static void rx8025_sim_latch(rx8025_sim_t *sim)
+{
+    time_t t = rx8025_sim_get_time(sim);
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    sim->regs[0] = rx8025_sim_bcd(tm.tm_sec);
+    sim->regs[1] = rx8025_sim_bcd(tm.tm_min);
+    sim->regs[2] = rx8025_sim_bcd(tm.tm_hour);
+    sim->regs[3] = 1 << tm.tm_wday;
+    sim->regs[4] = rx8025_sim_bcd(tm.tm_mday);
+    sim->regs[5] = rx8025_sim_bcd(tm.tm_mon + 1);
+    sim->regs[6] = rx8025_sim_bcd(tm.tm_year % 100);
+}
+
+/**
+ * @description: 时间寄存器写入后重新开始计时
+ */
+static void rx8025_sim_load(rx8025_sim_t *sim, bool reset_divider)
+{
+    struct tm tm = {
+        .tm_sec = rx8025_sim_bin(sim->regs[0] & 0x7F),
+        .tm_min = rx8025_sim_bin(sim->regs[1] & 0x7F),
+        .tm_hour = rx8025_sim_bin(sim->regs[2] & 0x3F),
+        .tm_mday = rx8025_sim_bin(sim->regs[4] & 0x3F),
+        .tm_mon = rx8025_sim_bin(sim->regs[5] & 0x1F) - 1,
+        .tm_year = rx8025_sim_bin(sim->regs[6]) + 100,
+    };
+    int64_t now = esp_timer_get_time();
+    int64_t frac = sim->stopped ? 0 : (now - sim->base_us) % 1000000;
+    sim->base = timegm(&tm);
+    sim->base_us = reset_divider ? now : now - frac;
+}
+
+static esp_err_t rx8025_sim_write(void *ctx, const uint8_t *data, size_t len)
+{
+    rx8025_sim_t *sim = (rx8025_sim_t *)ctx;
+    if (sim->nack)
+    {
+        return ESP_FAIL;
+    }
+    sim->writes++;
+    sim->ptr = data[0] & 0x0F;
+    if (len == 1)
+    {
+        return ESP_OK;
+    }
+    rx8025_sim_latch(sim);
+    bool time_written = false;
+    bool sec_written = false;
+    for (size_t i = 1; i < len; i++)
+    {
+        if (sim->ptr <= RX8025_SIM_REG_YEAR)
+        {
+            time_written = true;
+            sec_written |= sim->ptr == RX8025_SIM_REG_SEC;
+        }
+        if (sim->ptr == RX8025_SIM_REG_FLAG)
+        {
+            // 标志位只能写 0 清除
+            sim->regs[sim->ptr] &= data[i];
+        }
+        else
+        {
+            sim->regs[sim->ptr] = data[i];
+        }
+        sim->ptr = (sim->ptr + 1) & 0x0F;
+    }
+    if (time_written)
+    {
+        rx8025_sim_load(sim, sec_written);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t rx8025_sim_read(void *ctx, uint8_t *data, size_t len)
+{
+    rx8025_sim_t *sim = (rx8025_sim_t *)ctx;
+    if (sim->nack)
+    {
+        return ESP_FAIL;
+    }
+    sim->reads++;
+    // 读的时候芯片锁存时间寄存器，一次读出的时间是一致的
+    rx8025_sim_latch(sim);
+    for (size_t i = 0; i < len; i++)
+    {
+        data[i] = sim->regs[sim->ptr];
+        sim->ptr = (sim->ptr + 1) & 0x0F;
+    }
+    return ESP_OK;
+}
+
+esp_err_t rx8025_sim_attach(rx8025_sim_t *sim, i2c_port_t port, uint8_t addr)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->regs[RX8025_SIM_REG_FLAG] = RX8025_SIM_FLAG_VLF;
+    rx8025_sim_set_time(sim, 946684800, 0);
+    const i2c_sim_device_t dev = {.write = rx8025_sim_write, .read = rx8025_sim_read, .ctx = sim};
+    return i2c_sim_attach(port, addr, &dev);
+}
+
+void rx8025_sim_set_time(rx8025_sim_t *sim, time_t t, int64_t elapsed_us)
+{
+    sim->base = t;
+    sim->base_us = esp_timer_get_time() - elapsed_us;
+}
@@ -0,0 +1,36 @@
+// 模拟的 EPSON RX8025T 实时时钟，挂在 i2c_sim 上：
+// 16 个寄存器，写传输的第一个字节是寄存器地址，读写时地址自动加一；
+// 时间按 esp_timer 走，写秒寄存器时秒以下的计数清零
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "driver/i2c.h"
+
+typedef struct
+{
+    uint8_t regs[16];
+    uint8_t ptr;          /*!< 当前寄存器地址 */
+    time_t base;          /*!< base_us 时的时间（UTC） */
+    int64_t base_us;      /*!< 秒以下的计数清零的时刻 */
+    bool stopped;         /*!< 振荡器停止，时间不走 */
+    bool nack;            /*!< 不应答，模拟断线 */
+    uint32_t reads;       /*!< 读传输的次数 */
+    uint32_t writes;      /*!< 写传输的次数 */
+} rx8025_sim_t;
+
+/**
+ * @description: 上电状态（VLF 置位，时间 2000-01-01 00:00:00）并挂到 port 的 addr 上
+ */
+esp_err_t rx8025_sim_attach(rx8025_sim_t *sim, i2c_port_t port, uint8_t addr);
+
+/**
+ * @description: 设置芯片的时间，elapsed_us 为这一秒已经过去的时间
+ */
+void rx8025_sim_set_time(rx8025_sim_t *sim, time_t t, int64_t elapsed_us);
+
+/**
+ * @description: 芯片当前的时间
+ */
+time_t rx8025_sim_get_time(const rx8025_sim_t *sim);
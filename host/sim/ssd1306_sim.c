@@ -0,0 +1,101 @@
+#include <string.h>
+#include "ssd1306_sim.h"
+
+/**
+ * @description: 带参数的命令还要的参数个数
+ */
+static uint8_t ssd1306_sim_args(uint8_t cmd)
+{
+    switch (cmd)
+    {
+    case 0x20: // 寻址模式
+    case 0x81: // 对比度
+    case 0x8D: // 电荷泵
+    case 0xA8: // 复用率
+    case 0xD3: // 显示偏移
+    case 0xD5: // 时钟分频
+    case 0xD8: // 颜色模式
+    case 0xD9: // 预充电
+    case 0xDA: // COM 引脚
+    case 0xDB: // Vcomh
+        return 1;
+    case 0x21: // 列地址范围
+    case 0x22: // 页地址范围
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+static void ssd1306_sim_command(ssd1306_sim_t *sim, uint8_t b)
+{
+    sim->commands++;
+    if (sim->pending)
+    {
+        sim->pending--;
+        if (sim->last_cmd == 0x81)
+        {
+            sim->contrast = b;
+        }
+        else if (sim->last_cmd == 0x8D)
+        {
+            sim->charge_pump = b & 0x04;
+        }
+        return;
+    }
+    sim->last_cmd = b;
+    sim->pending = ssd1306_sim_args(b);
+    if (b <= 0x0F)
+    {
+        sim->col = (sim->col & 0xF0) | b;
+    }
+    else if (b <= 0x1F)
+    {
+        sim->col = ((b & 0x0F) << 4) | (sim->col & 0x0F);
+    }
+    else if (b >= 0xB0 && b <= 0xB7)
+    {
+        sim->page = b & 0x07;
+    }
+    else if (b == 0xAE || b == 0xAF)
+    {
+        sim->display_on = b & 1;
+    }
+}
+
+static esp_err_t ssd1306_sim_write(void *ctx, const uint8_t *data, size_t len)
+{
+    ssd1306_sim_t *sim = (ssd1306_sim_t *)ctx;
+    // Co 位为 0：之后全是命令或全是数据
+    bool is_data = data[0] & 0x40;
+    for (size_t i = 1; i < len; i++)
+    {
+        if (!is_data)
+        {
+            ssd1306_sim_command(sim, data[i]);
+            continue;
+        }
+        // 页寻址模式：列到头后回到 0，页不变
+        sim->ram[sim->page][sim->col & 0x7F] = data[i];
+        sim->col = (sim->col + 1) & 0x7F;
+        sim->data_bytes++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ssd1306_sim_attach(ssd1306_sim_t *sim, i2c_port_t port, uint8_t addr)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->contrast = 0x7F;
+    const i2c_sim_device_t dev = {.write = ssd1306_sim_write, .read = NULL, .ctx = sim};
+    return i2c_sim_attach(port, addr, &dev);
+}
+
+bool ssd1306_sim_pixel(const ssd1306_sim_t *sim, int x, int y)
+{
+    if (x < 0 || x >= SSD1306_SIM_WIDTH || y < 0 || y >= SSD1306_SIM_PAGES * 8)
+    {
+        return false;
+    }
+    return sim->ram[y / 8][x] & (1 << (y % 8));
+}
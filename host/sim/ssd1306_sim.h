@@ -0,0 +1,34 @@
+// 模拟的 SSD1306 OLED 控制器（128x64，I2C），挂在 i2c_sim 上：
+// 每次写传输的第一个字节是控制字节（0x00 命令，0x40 数据），页寻址模式下数据写入显存的当前页和列
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driver/i2c.h"
+
+#define SSD1306_SIM_WIDTH 128
+#define SSD1306_SIM_PAGES 8
+
+typedef struct
+{
+    uint8_t ram[SSD1306_SIM_PAGES][SSD1306_SIM_WIDTH]; /*!< 显存，每个字节是一列上的 8 个像素，bit0 在上 */
+    uint8_t page;
+    uint8_t col;
+    bool display_on;
+    bool charge_pump;
+    uint8_t contrast;
+    uint8_t pending;      /*!< 上一条命令还要的参数个数 */
+    uint8_t last_cmd;
+    uint32_t commands;    /*!< 收到的命令字节（含参数） */
+    uint32_t data_bytes;  /*!< 写入显存的字节 */
+} ssd1306_sim_t;
+
+/**
+ * @description: 复位并挂到 port 的 addr 上
+ */
+esp_err_t ssd1306_sim_attach(ssd1306_sim_t *sim, i2c_port_t port, uint8_t addr);
+
+/**
+ * @description: 像素 (x, y) 是否点亮
+ */
+bool ssd1306_sim_pixel(const ssd1306_sim_t *sim, int x, int y);
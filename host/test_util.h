@@ -0,0 +1,27 @@
+// PC上的测试和性能测量共用：失败计数、CHECK 和单调时钟
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+// 只做性能测量的程序不用它
+static int s_failures __attribute__((unused)) = 0;
+
+#define CHECK(cond, ...)                    \
+    do                                      \
+    {                                       \
+        if (!(cond))                        \
+        {                                   \
+            printf("  FAIL: " __VA_ARGS__); \
+            printf("\n");                   \
+            s_failures++;                   \
+        }                                   \
+    } while (0)
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
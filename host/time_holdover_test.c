@@ -0,0 +1,307 @@
+/*
+ * holdover 的测试（07_NTP/components/time_holdover）
+ *
+ * 模拟的系统时钟比真实时间快 SYS_DRIFT_PPM，RTC快 RTC_DRIFT_PPM；读RTC要等到它的秒跳变，
+ * 写RTC要等到系统时间的整秒。设备每 WAKE_S 秒唤醒一次，需要同步时得到带噪声的 SNTP 时间。
+ * 检查冷启动、断电后从RTC恢复、漂移的测量、估计的误差是否总是覆盖实际误差，以及一天内同步的次数；
+ * 分步读RTC期间 SNTP 又同步时丢弃读出的结果。
+ *
+ * 用法：time_holdover_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "holdover.h"
+#include "test_util.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+#define SYS_DRIFT_PPM 150.0
+#define RTC_DRIFT_PPM 3.0
+#define SNTP_NOISE_US 5000
+#define RTC_JITTER_US 300
+#define WAKE_S 600
+#define T0_US (1767225600LL * 1000000) // 2026-01-01 00:00:00 UTC
+
+typedef struct
+{
+    holdover_hw_t parent;
+    int64_t now;          /*!< 真实时间 */
+    double sys_offset;    /*!< 系统时间 - 真实时间 */
+    double rtc_offset;    /*!< RTC - 真实时间 */
+    double sys_ppm;
+    double rtc_ppm;
+    bool rtc_present;
+    bool rtc_power_lost;
+    uint32_t rtc_reads;
+    uint32_t rtc_writes;
+    uint32_t steps;
+    uint32_t slews;
+    uint32_t seed;
+} sim_clock_t;
+
+static int32_t sim_noise(sim_clock_t *s, int32_t amplitude)
+{
+    s->seed = s->seed * 1103515245 + 12345;
+    return (int32_t)((s->seed >> 8) % (2 * amplitude + 1)) - amplitude;
+}
+
+static void sim_advance(sim_clock_t *s, int64_t us)
+{
+    s->now += us;
+    s->sys_offset += us * s->sys_ppm * 1e-6;
+    s->rtc_offset += us * s->rtc_ppm * 1e-6;
+}
+
+static int64_t sim_sys(const sim_clock_t *s)
+{
+    return s->now + (int64_t)s->sys_offset;
+}
+
+static esp_err_t sim_rtc_read(holdover_hw_t *hw, int64_t *us)
+{
+    sim_clock_t *s = __containerof(hw, sim_clock_t, parent);
+    if (!s->rtc_present)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (s->rtc_power_lost)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s->rtc_reads++;
+    int64_t rtc = s->now + (int64_t)s->rtc_offset;
+    int64_t edge = (rtc / 1000000 + 1) * 1000000;
+    sim_advance(s, edge - rtc);
+    *us = edge;
+    sim_advance(s, RTC_JITTER_US / 2 + sim_noise(s, RTC_JITTER_US / 2)); // 查询间隔带来的误差
+    return ESP_OK;
+}
+
+static esp_err_t sim_rtc_write(holdover_hw_t *hw)
+{
+    sim_clock_t *s = __containerof(hw, sim_clock_t, parent);
+    if (!s->rtc_present)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    int64_t sys = sim_sys(s);
+    sim_advance(s, (sys / 1000000 + 1) * 1000000 - sys);
+    s->rtc_offset = s->sys_offset;
+    s->rtc_power_lost = false;
+    s->rtc_writes++;
+    return ESP_OK;
+}
+
+static int64_t sim_sys_get(holdover_hw_t *hw)
+{
+    return sim_sys(__containerof(hw, sim_clock_t, parent));
+}
+
+static void sim_sys_set(holdover_hw_t *hw, int64_t us)
+{
+    sim_clock_t *s = __containerof(hw, sim_clock_t, parent);
+    s->sys_offset = (double)(us - s->now);
+    s->steps++;
+}
+
+// adjtime 按立即生效处理，sys_get 本来就包括没调整完的部分
+static void sim_sys_adjust(holdover_hw_t *hw, int64_t delta_us)
+{
+    sim_clock_t *s = __containerof(hw, sim_clock_t, parent);
+    s->sys_offset += delta_us;
+    s->slews++;
+}
+
+static void sim_init(sim_clock_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->parent.rtc_read = sim_rtc_read;
+    s->parent.rtc_write = sim_rtc_write;
+    s->parent.sys_get = sim_sys_get;
+    s->parent.sys_set = sim_sys_set;
+    s->parent.sys_adjust = sim_sys_adjust;
+    s->now = T0_US;
+    s->sys_offset = -(double)T0_US; // 上电时系统时间从 1970 年开始
+    s->sys_ppm = SYS_DRIFT_PPM;
+    s->rtc_ppm = RTC_DRIFT_PPM;
+    s->rtc_present = true;
+    s->seed = 1;
+}
+
+/**
+ * @description: 断电：系统时间从 0 开始，RTC 内存丢失（填入随机内容）
+ */
+static void sim_power_cycle(sim_clock_t *s, holdover_state_t *state)
+{
+    s->sys_offset = -(double)s->now;
+    for (size_t i = 0; i < sizeof(*state); i++)
+    {
+        ((uint8_t *)state)[i] = (uint8_t)sim_noise(s, 127);
+    }
+}
+
+static void sim_sntp(sim_clock_t *s, holdover_t *h)
+{
+    holdover_on_sntp(h, s->now + sim_noise(s, SNTP_NOISE_US));
+    esp_err_t ret = holdover_sync_rtc(h);
+    CHECK(ret == ESP_OK || !s->rtc_present, "sync_rtc: %d", ret);
+}
+
+static int64_t sim_error(const sim_clock_t *s)
+{
+    int64_t e = sim_sys(s) - s->now;
+    return e < 0 ? -e : e;
+}
+
+/**
+ * @description: 一次唤醒：初始化、启动，需要时同步；检查估计的误差覆盖实际误差
+ * @return       是否同步了
+ */
+static bool sim_wake(sim_clock_t *s, holdover_state_t *state, const holdover_config_t *config, holdover_status_t *status)
+{
+    holdover_t h;
+    holdover_init(&h, config, &s->parent, state);
+    holdover_boot(&h);
+    holdover_get_status(&h, status);
+    if (status->source != HOLDOVER_SOURCE_NONE)
+    {
+        CHECK(sim_error(s) <= status->uncertainty_us, "error %lld us > estimate %lld us (%s)",
+              (long long)sim_error(s), (long long)status->uncertainty_us, holdover_source_name(status->source));
+    }
+    bool synced = status->sync_due;
+    if (synced)
+    {
+        sim_sntp(s, &h);
+        holdover_get_status(&h, status);
+        CHECK(!status->sync_due, "sync still due after sntp");
+    }
+    return synced;
+}
+
+int main(void)
+{
+    const holdover_config_t config = HOLDOVER_DEFAULT_CONFIG();
+    holdover_state_t state;
+    holdover_status_t status;
+    holdover_t h;
+    sim_clock_t sim;
+    sim_init(&sim);
+    sim_power_cycle(&sim, &state);
+
+    // 第一次上电，RTC 掉电过：时间未知，需要同步；同步后写入RTC
+    printf("cold boot, rtc lost power\n");
+    sim.rtc_power_lost = true;
+    holdover_init(&h, &config, &sim.parent, &state);
+    CHECK(holdover_boot(&h) == HOLDOVER_SOURCE_NONE, "source %s", holdover_source_name(state.source));
+    holdover_get_status(&h, &status);
+    CHECK(status.sync_due && status.uncertainty_us == INT64_MAX, "no time but sync not due");
+    sim_sntp(&sim, &h);
+    CHECK(sim.rtc_writes == 1 && !sim.rtc_power_lost, "rtc not written");
+    CHECK(sim.steps == 1 && sim_error(&sim) <= SNTP_NOISE_US, "first sntp: error %lld us", (long long)sim_error(&sim));
+
+    // 断电一小时后：不等网络，从RTC得到时间
+    printf("power cycle, time from rtc\n");
+    sim_advance(&sim, 3600LL * 1000000);
+    sim_power_cycle(&sim, &state);
+    holdover_init(&h, &config, &sim.parent, &state);
+    CHECK(holdover_boot(&h) == HOLDOVER_SOURCE_RTC, "source %s", holdover_source_name(state.source));
+    holdover_get_status(&h, &status);
+    printf("  error %lld us, estimate %lld us, sync due %d\n", (long long)sim_error(&sim),
+           (long long)status.uncertainty_us, status.sync_due);
+    CHECK(sim_error(&sim) < 30000, "rtc time error %lld us", (long long)sim_error(&sim));
+    CHECK(status.sync_due, "rtc history lost but sync not due");
+
+    // 每 WAKE_S 唤醒一次，运行两天：前一天学习漂移，第二天统计同步次数
+    printf("deep sleep every %d s for 2 days\n", WAKE_S);
+    int syncs[2] = {0, 0};
+    int rtc_reads_day2 = 0;
+    int64_t worst = 0;
+    for (int day = 0; day < 2; day++)
+    {
+        uint32_t reads = sim.rtc_reads;
+        for (int i = 0; i < 86400 / WAKE_S; i++)
+        {
+            sim_advance(&sim, (int64_t)WAKE_S * 1000000);
+            syncs[day] += sim_wake(&sim, &state, &config, &status);
+            worst = sim_error(&sim) > worst ? sim_error(&sim) : worst;
+        }
+        if (day == 1)
+        {
+            rtc_reads_day2 = sim.rtc_reads - reads;
+        }
+    }
+    printf("  syncs %d + %d, rtc reads on day 2 %d, worst error %lld us\n", syncs[0], syncs[1], rtc_reads_day2,
+           (long long)worst);
+    printf("  sys drift %d ppb (true %.0f), rtc drift %d ppb (true %.0f)\n", status.sys_drift_ppb,
+           SYS_DRIFT_PPM * 1000, status.rtc_drift_ppb, RTC_DRIFT_PPM * 1000);
+    CHECK(status.sys_drift_valid && abs(status.sys_drift_ppb - (int32_t)(SYS_DRIFT_PPM * 1000)) < 5000,
+          "sys drift not measured");
+    CHECK(status.rtc_drift_valid && abs(status.rtc_drift_ppb - (int32_t)(RTC_DRIFT_PPM * 1000)) < 500,
+          "rtc drift not measured");
+    CHECK(syncs[1] <= 2, "%d syncs on day 2", syncs[1]);
+    CHECK(worst <= (int64_t)config.max_error_ms * 1000, "worst error %lld us", (long long)worst);
+    CHECK(sim.slews > 0, "small offsets not slewed");
+
+    // 系统时钟的漂移变大（温度变化），误差仍应在估计之内，靠RTC或同步拉回来
+    printf("sys drift changes to %.0f ppm\n", SYS_DRIFT_PPM + 40);
+    sim.sys_ppm = SYS_DRIFT_PPM + 40;
+    for (int i = 0; i < 86400 / WAKE_S; i++)
+    {
+        sim_advance(&sim, (int64_t)WAKE_S * 1000000);
+        sim_wake(&sim, &state, &config, &status);
+    }
+    printf("  sys drift %d ppb\n", status.sys_drift_ppb);
+
+    // RTC 内存被破坏：按冷启动处理，从RTC读
+    printf("corrupt state\n");
+    state.crc ^= 1;
+    sim_advance(&sim, (int64_t)WAKE_S * 1000000);
+    holdover_init(&h, &config, &sim.parent, &state);
+    CHECK(state.source == HOLDOVER_SOURCE_NONE, "corrupt state accepted");
+    sim.sys_offset = -(double)sim.now;
+    CHECK(holdover_boot(&h) == HOLDOVER_SOURCE_RTC, "source %s", holdover_source_name(state.source));
+
+    // 分步读RTC（ESP32上不持锁），其间 SNTP 又同步：读出的结果丢弃
+    printf("sntp while reading rtc\n");
+    holdover_on_sntp(&h, sim.now);
+    sim.rtc_offset += 100000;
+    holdover_rtc_sample_t sample;
+    bool rewrite = true;
+    CHECK(holdover_sync_rtc_begin(&h) == ESP_OK, "sync_rtc_begin");
+    holdover_rtc_sample(&h, &sample);
+    holdover_on_sntp(&h, sim.now);
+    uint32_t writes = sim.rtc_writes;
+    CHECK(holdover_sync_rtc_measured(&h, &sample, &rewrite) == ESP_ERR_INVALID_STATE && !rewrite, "stale sample used");
+    CHECK(holdover_sync_rtc_begin(&h) == ESP_OK, "sync_rtc_begin");
+    holdover_rtc_sample(&h, &sample);
+    CHECK(holdover_sync_rtc_measured(&h, &sample, &rewrite) == ESP_OK && rewrite, "rtc 100 ms off not rewritten");
+    CHECK(holdover_sync_rtc_written(&h, sim_rtc_write(&sim.parent)) == ESP_OK && sim.rtc_writes == writes + 1,
+          "rtc_written");
+
+    sim_power_cycle(&sim, &state);
+    holdover_init(&h, &config, &sim.parent, &state);
+    CHECK(holdover_check_begin(&h), "time unknown, rtc not read");
+    holdover_rtc_sample(&h, &sample);
+    holdover_on_sntp(&h, sim.now);
+    uint32_t steps = sim.steps;
+    holdover_check_rtc(&h, &sample);
+    CHECK(state.source == HOLDOVER_SOURCE_SNTP && sim.steps == steps, "rtc overrode sntp time");
+
+    // 没有RTC：时间未知，同步后正常；sync_rtc 报告没有RTC
+    printf("no rtc\n");
+    sim.rtc_present = false;
+    sim_power_cycle(&sim, &state);
+    holdover_init(&h, &config, &sim.parent, &state);
+    CHECK(holdover_boot(&h) == HOLDOVER_SOURCE_NONE, "source %s", holdover_source_name(state.source));
+    holdover_on_sntp(&h, sim.now);
+    CHECK(holdover_sync_rtc(&h) == ESP_ERR_NOT_FOUND, "sync_rtc without rtc");
+    holdover_get_status(&h, &status);
+    CHECK(status.source == HOLDOVER_SOURCE_SNTP && !status.sync_due, "sntp without rtc");
+
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * tslog 编码格式的测试和性能测量：生成模拟的传感器数据，编码、解码并逐个样本比对，
+ * 打印每个样本的字节数和编码/解码耗时
+ *
+ * 用法：tslog_bench [样本数] [通道数] [采样率Hz] [时间抖动us] [输出文件]
+ * 给出输出文件时保存编码结果，可以用 tslog_dump 查看
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "tslog.h"
+#include "test_util.h"
+
+typedef struct
+{
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} bench_out_t;
+
+typedef struct
+{
+    const uint64_t *t;
+    const int32_t *values;
+    uint8_t channels;
+    uint64_t index;
+    uint64_t errors;
+} bench_check_t;
+
+static esp_err_t bench_write(void *ctx, const uint8_t *block)
+{
+    bench_out_t *out = ctx;
+    if (out->len + TSLOG_BLOCK_SIZE > out->cap)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(out->data + out->len, block, TSLOG_BLOCK_SIZE);
+    out->len += TSLOG_BLOCK_SIZE;
+    return ESP_OK;
+}
+
+static bool bench_check_sample(void *ctx, uint64_t t, const int32_t *values, uint8_t channels)
+{
+    bench_check_t *c = ctx;
+    if (t != c->t[c->index] || memcmp(values, c->values + c->index * c->channels, channels * sizeof(int32_t)) != 0)
+    {
+        c->errors++;
+    }
+    c->index++;
+    return true;
+}
+
+static esp_err_t bench_read(void *ctx, uint32_t index, uint8_t *block)
+{
+    memcpy(block, ((bench_out_t *)ctx)->data + (size_t)index * TSLOG_BLOCK_SIZE, TSLOG_BLOCK_SIZE);
+    return ESP_OK;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t samples = argc > 1 ? strtoull(argv[1], NULL, 0) : 1000000;
+    uint8_t channels = argc > 2 ? atoi(argv[2]) : 4;
+    uint32_t rate = argc > 3 ? strtoul(argv[3], NULL, 0) : 1000;
+    uint32_t jitter = argc > 4 ? strtoul(argv[4], NULL, 0) : 0;
+    if (samples == 0 || channels == 0 || channels > TSLOG_MAX_CHANNELS || rate == 0)
+    {
+        fprintf(stderr, "usage: %s [samples] [channels 1-%d] [rate_hz] [jitter_us] [output]\n", argv[0], TSLOG_MAX_CHANNELS);
+        return 2;
+    }
+
+    // 模拟数据：12位ADC上的慢变正弦加噪声，各通道频率不同，时间戳带随机抖动
+    uint64_t *t = malloc(samples * sizeof(uint64_t));
+    int32_t *values = malloc(samples * channels * sizeof(int32_t));
+    bench_out_t out = {.cap = samples * (10 + 5 * channels) + 64 * TSLOG_BLOCK_SIZE};
+    out.data = malloc(out.cap);
+    if (!t || !values || !out.data)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    uint32_t rng = 1;
+    for (uint64_t i = 0; i < samples; i++)
+    {
+        rng = rng * 1103515245 + 12345;
+        t[i] = 1700000000000000ULL + i * (1000000 / rate) + (jitter ? (rng >> 8) % (jitter + 1) : 0);
+        for (uint8_t c = 0; c < channels; c++)
+        {
+            rng = rng * 1103515245 + 12345;
+            double s = sin((double)i / rate * (c + 1) * 0.5);
+            values[i * channels + c] = 2048 + (int32_t)(1500 * s) + (int32_t)((rng >> 16) % 7) - 3;
+        }
+    }
+
+    tslog_encoder_t enc;
+    tslog_encoder_init(&enc, channels, 0, bench_write, &out);
+    uint64_t start = bench_now_ns();
+    for (uint64_t i = 0; i < samples; i++)
+    {
+        if (tslog_encoder_add(&enc, t[i], values + i * channels) != ESP_OK)
+        {
+            fprintf(stderr, "encode failed at sample %llu\n", (unsigned long long)i);
+            return 1;
+        }
+    }
+    tslog_encoder_flush(&enc);
+    uint64_t encode_ns = bench_now_ns() - start;
+
+    bench_check_t check = {.t = t, .values = values, .channels = channels};
+    start = bench_now_ns();
+    for (size_t off = 0; off < out.len; off += TSLOG_BLOCK_SIZE)
+    {
+        if (tslog_block_decode(out.data + off, bench_check_sample, &check) != ESP_OK)
+        {
+            fprintf(stderr, "decode failed at block %zu\n", off / TSLOG_BLOCK_SIZE);
+            return 1;
+        }
+    }
+    uint64_t decode_ns = bench_now_ns() - start;
+
+    // 按时间随机查找，统计每次查找读了多少块
+    uint32_t blocks = out.len / TSLOG_BLOCK_SIZE;
+    uint8_t block[TSLOG_BLOCK_SIZE];
+    uint64_t seek_errors = 0;
+    for (int k = 0; k < 1000; k++)
+    {
+        rng = rng * 1103515245 + 12345;
+        uint64_t i = (rng >> 4) % samples;
+        uint32_t index;
+        if (tslog_seek(bench_read, &out, blocks, t[i], &index, block) != ESP_OK)
+        {
+            seek_errors++;
+            continue;
+        }
+        // 找到的块必须包含样本i，且前一块的所有样本都早于它
+        tslog_block_header_t h;
+        tslog_block_check(block, &h);
+        if (h.t_min > t[i] || h.t_max < t[i])
+        {
+            seek_errors++;
+        }
+        if (index > 0)
+        {
+            tslog_block_check(out.data + (size_t)(index - 1) * TSLOG_BLOCK_SIZE, &h);
+            seek_errors += h.t_max >= t[i];
+        }
+    }
+
+    double raw = 8 + 4.0 * channels;
+    double per_sample = (double)out.len / samples;
+    printf("samples %llu, channels %u, %u Hz, jitter %u us\n",
+           (unsigned long long)samples, channels, (unsigned)rate, (unsigned)jitter);
+    printf("blocks %u, %.1f samples/block\n", blocks, (double)samples / blocks);
+    printf("bytes/sample %.2f (raw %.0f, ratio %.2fx)\n", per_sample, raw, raw / per_sample);
+    printf("encode %.1f ns/sample, decode %.1f ns/sample\n",
+           (double)encode_ns / samples, (double)decode_ns / samples);
+    printf("verify: %llu mismatches, %llu/%llu decoded, %llu seek errors\n",
+           (unsigned long long)check.errors, (unsigned long long)check.index,
+           (unsigned long long)samples, (unsigned long long)seek_errors);
+
+    if (argc > 5)
+    {
+        FILE *f = fopen(argv[5], "wb");
+        if (!f || fwrite(out.data, 1, out.len, f) != out.len)
+        {
+            perror(argv[5]);
+        }
+        if (f)
+        {
+            fclose(f);
+        }
+    }
+
+    free(t);
+    free(values);
+    free(out.data);
+    return check.errors || check.index != samples || seek_errors ? 1 : 0;
+}
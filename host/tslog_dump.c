@@ -0,0 +1,92 @@
+/*
+ * 把 tslog 文件解码成CSV（时间,通道0,通道1,...），可以只取一段时间
+ *
+ * 用法：tslog_dump <文件> [起始时间] [结束时间]
+ * 起始时间用块头二分查找定位，不扫描整个文件；损坏的块跳过并在stderr中提示
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "tslog.h"
+
+typedef struct
+{
+    uint64_t from;
+    uint64_t to;
+    bool done;
+} dump_range_t;
+
+static esp_err_t dump_read(void *ctx, uint32_t index, uint8_t *block)
+{
+    FILE *f = ctx;
+    if (fseeko(f, (off_t)index * TSLOG_BLOCK_SIZE, SEEK_SET) != 0 || fread(block, 1, TSLOG_BLOCK_SIZE, f) != TSLOG_BLOCK_SIZE)
+    {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static bool dump_sample(void *ctx, uint64_t t, const int32_t *values, uint8_t channels)
+{
+    dump_range_t *range = ctx;
+    if (t > range->to)
+    {
+        range->done = true;
+        return false;
+    }
+    if (t < range->from)
+    {
+        return true;
+    }
+    printf("%" PRIu64, t);
+    for (uint8_t c = 0; c < channels; c++)
+    {
+        printf(",%" PRId32, values[c]);
+    }
+    printf("\n");
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <file> [from] [to]\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    if (!f)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    fseeko(f, 0, SEEK_END);
+    uint32_t blocks = ftello(f) / TSLOG_BLOCK_SIZE;
+    dump_range_t range = {
+        .from = argc > 2 ? strtoull(argv[2], NULL, 0) : 0,
+        .to = argc > 3 ? strtoull(argv[3], NULL, 0) : UINT64_MAX,
+    };
+
+    uint8_t block[TSLOG_BLOCK_SIZE];
+    uint32_t index;
+    esp_err_t ret = tslog_seek(dump_read, f, blocks, range.from, &index, block);
+    if (ret != ESP_OK)
+    {
+        fclose(f);
+        return ret == ESP_ERR_NOT_FOUND ? 0 : 1;
+    }
+    for (; index < blocks && !range.done; index++)
+    {
+        if (dump_read(f, index, block) != ESP_OK)
+        {
+            break;
+        }
+        ret = tslog_block_decode(block, dump_sample, &range);
+        if (ret != ESP_OK && ret != ESP_ERR_NOT_FOUND)
+        {
+            fprintf(stderr, "block %u: bad (0x%x), skipped\n", (unsigned)index, ret);
+        }
+    }
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * uart_cmd 的测试和性能测量（08_uart/components/uart_cmd）
+ *
+ * 测试：08_uart 的命令集和 CMD_MAX_COMMANDS 个生成的名字都能建立完美哈希；查找不存在的名字、
+ * 前缀和加长的名字返回 NULL；参数个数、格式和范围的错误；帮助文本。
+ * 性能：同一组命令行（颜色名、带参数的 rgb/bright、未知命令）反复解析，比较
+ *   - strstr 链：原来 u0_rx_task 的做法，每行依次 strstr 六个颜色名，没有参数
+ *   - 命令表：cmd_dispatch，包括分词、查找、参数解析和调用处理函数
+ * 输出每行的 ns。
+ *
+ * 用法：uart_cmd_bench [次数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "uart_cmd.h"
+#include "test_util.h"
+
+typedef struct
+{
+    int calls;
+    int32_t sum;
+    const cmd_def_t *last;
+} bench_ctx_t;
+
+static esp_err_t count_handler(const cmd_def_t *cmd, const int32_t *argv, void *ctx)
+{
+    bench_ctx_t *b = ctx;
+    b->calls++;
+    b->last = cmd;
+    for (int i = 0; i < CMD_MAX_ARGS && cmd->args[i].name; i++)
+    {
+        b->sum += argv[i];
+    }
+    return ESP_OK;
+}
+
+#define RGB_ARG(n) {n, 0, 255}
+
+static const cmd_def_t s_cmds[] = {
+    {"red", "red", {{0}}, count_handler, NULL},
+    {"green", "green", {{0}}, count_handler, NULL},
+    {"blue", "blue", {{0}}, count_handler, NULL},
+    {"clear", "turn the LED off", {{0}}, count_handler, NULL},
+    {"purple", "purple", {{0}}, count_handler, NULL},
+    {"qing", "cyan", {{0}}, count_handler, NULL},
+    {"rgb", "set any colour", {RGB_ARG("r"), RGB_ARG("g"), RGB_ARG("b")}, count_handler, NULL},
+    {"bright", "brightness in percent", {{"percent", 0, 100}}, count_handler, NULL},
+    {"help", "list commands", {{0}}, count_handler, NULL},
+};
+#define CMD_COUNT (sizeof(s_cmds) / sizeof(s_cmds[0]))
+
+static esp_err_t dispatch_str(const cmd_table_t *t, const char *line, bench_ctx_t *ctx, char *err)
+{
+    return cmd_dispatch(t, (const uint8_t *)line, strlen(line), ctx, err, 80);
+}
+
+static void test_lookup(void)
+{
+    cmd_table_t t;
+    CHECK(cmd_table_init(&t, s_cmds, CMD_COUNT) == ESP_OK, "init");
+    for (size_t i = 0; i < CMD_COUNT; i++)
+    {
+        CHECK(cmd_lookup(&t, s_cmds[i].name, strlen(s_cmds[i].name)) == &s_cmds[i], "lookup %s", s_cmds[i].name);
+    }
+    CHECK(!cmd_lookup(&t, "re", 2), "prefix found");
+    CHECK(!cmd_lookup(&t, "redd", 4), "longer name found");
+    CHECK(!cmd_lookup(&t, "led", 3), "unknown name found");
+    CHECK(!cmd_lookup(&t, "", 0), "empty name found");
+    printf("%zu commands in %d slots, seed %u\n", CMD_COUNT, t.mask + 1, t.seed);
+
+    // 命令最多时也能找到种子
+    static char names[CMD_MAX_COMMANDS][12];
+    static cmd_def_t many[CMD_MAX_COMMANDS];
+    for (int i = 0; i < CMD_MAX_COMMANDS; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "cmd%d", i * 7);
+        many[i] = (cmd_def_t){.name = names[i], .handler = count_handler};
+    }
+    CHECK(cmd_table_init(&t, many, CMD_MAX_COMMANDS) == ESP_OK, "init %d commands", CMD_MAX_COMMANDS);
+    int found = 0;
+    for (int i = 0; i < CMD_MAX_COMMANDS; i++)
+    {
+        found += cmd_lookup(&t, names[i], strlen(names[i])) == &many[i];
+    }
+    CHECK(found == CMD_MAX_COMMANDS, "%d of %d found", found, CMD_MAX_COMMANDS);
+    printf("%d commands in %d slots, seed %u\n", CMD_MAX_COMMANDS, t.mask + 1, t.seed);
+
+    many[3].name = many[5].name;
+    CHECK(cmd_table_init(&t, many, CMD_MAX_COMMANDS) == ESP_ERR_INVALID_ARG, "duplicate accepted");
+    CHECK(cmd_table_init(&t, many, CMD_MAX_COMMANDS + 1) == ESP_ERR_INVALID_ARG, "too many accepted");
+}
+
+static void test_dispatch(void)
+{
+    cmd_table_t t;
+    cmd_table_init(&t, s_cmds, CMD_COUNT);
+    bench_ctx_t ctx = {0};
+    char err[80] = "";
+
+    CHECK(dispatch_str(&t, "  rgb 23\t114 180 ", &ctx, err) == ESP_OK && ctx.sum == 23 + 114 + 180 &&
+              ctx.last == &s_cmds[6], "rgb");
+    CHECK(dispatch_str(&t, "bright 50", &ctx, err) == ESP_OK && ctx.last == &s_cmds[7], "bright");
+    CHECK(dispatch_str(&t, "", &ctx, err) == ESP_OK && dispatch_str(&t, "   ", &ctx, err) == ESP_OK &&
+              ctx.calls == 2, "empty line");
+    CHECK(dispatch_str(&t, "led on", &ctx, err) == ESP_ERR_NOT_FOUND, "unknown");
+    CHECK(strcmp(err, "unknown command 'led', try 'help'") == 0, "'%s'", err);
+    CHECK(dispatch_str(&t, "rgb 1 2", &ctx, err) == ESP_ERR_INVALID_ARG, "too few");
+    CHECK(strcmp(err, "usage: rgb <r> <g> <b>") == 0, "'%s'", err);
+    CHECK(dispatch_str(&t, "red 1", &ctx, err) == ESP_ERR_INVALID_ARG, "too many");
+    CHECK(dispatch_str(&t, "bright 101", &ctx, err) == ESP_ERR_INVALID_ARG, "range");
+    CHECK(strcmp(err, "percent: 101 out of range 0..100") == 0, "'%s'", err);
+    CHECK(dispatch_str(&t, "bright -1", &ctx, err) == ESP_ERR_INVALID_ARG, "negative");
+    CHECK(dispatch_str(&t, "bright 5x", &ctx, err) == ESP_ERR_INVALID_ARG, "not a number");
+    CHECK(dispatch_str(&t, "bright 99999999999", &ctx, err) == ESP_ERR_INVALID_ARG, "overflow");
+    CHECK(ctx.calls == 2, "handler called on error");
+
+    // 行在缓冲区中，后面紧跟着别的数据
+    const char *buf = "red\ngreen";
+    CHECK(cmd_dispatch(&t, (const uint8_t *)buf, 3, &ctx, err, sizeof(err)) == ESP_OK && ctx.last == &s_cmds[0],
+          "line not terminated");
+
+    char help[512];
+    size_t n = cmd_help(&t, help, sizeof(help));
+    CHECK(n < sizeof(help) && strstr(help, "rgb <r> <g> <b>") && strstr(help, "bright <percent>"), "help");
+    char small[16];
+    CHECK(cmd_help(&t, small, sizeof(small)) == n && strlen(small) == sizeof(small) - 1, "help truncated");
+}
+
+/* 原来 u0_rx_task 的匹配方式 */
+static int strstr_chain(const char *data)
+{
+    if (strstr(data, "red") != NULL)
+        return 1;
+    else if (strstr(data, "green") != NULL)
+        return 2;
+    else if (strstr(data, "blue") != NULL)
+        return 3;
+    else if (strstr(data, "clear") != NULL)
+        return 4;
+    else if (strstr(data, "purple") != NULL)
+        return 5;
+    else if (strstr(data, "qing") != NULL)
+        return 6;
+    return 0;
+}
+
+static void bench(unsigned iterations)
+{
+    static const char *lines[] = {"red", "green", "blue", "clear", "purple", "qing", "rgb 23 114 180",
+                                  "bright 50", "led on", "qing"};
+    const int nlines = sizeof(lines) / sizeof(lines[0]);
+    size_t lens[sizeof(lines) / sizeof(lines[0])];
+    size_t name_lens[sizeof(lines) / sizeof(lines[0])];
+    for (int i = 0; i < nlines; i++)
+    {
+        lens[i] = strlen(lines[i]);
+        name_lens[i] = strcspn(lines[i], " ");
+    }
+    cmd_table_t t;
+    cmd_table_init(&t, s_cmds, CMD_COUNT);
+    bench_ctx_t ctx = {0};
+
+    volatile int sink = 0;
+    uint64_t start = bench_now_ns();
+    for (unsigned k = 0; k < iterations; k++)
+    {
+        for (int i = 0; i < nlines; i++)
+        {
+            sink += strstr_chain(lines[i]);
+        }
+    }
+    uint64_t chain_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for (unsigned k = 0; k < iterations; k++)
+    {
+        for (int i = 0; i < nlines; i++)
+        {
+            cmd_dispatch(&t, (const uint8_t *)lines[i], lens[i], &ctx, NULL, 0);
+        }
+    }
+    uint64_t table_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for (unsigned k = 0; k < iterations; k++)
+    {
+        for (int i = 0; i < nlines; i++)
+        {
+            sink += cmd_lookup(&t, lines[i], name_lens[i]) != NULL;
+        }
+    }
+    uint64_t lookup_ns = bench_now_ns() - start;
+
+    double ops = (double)iterations * nlines;
+    printf("%-12s %8.1f ns/line (colour names only, no arguments)\n", "strstr chain", chain_ns / ops);
+    printf("%-12s %8.1f ns/line (tokenize, lookup, parse arguments, call)\n", "cmd_dispatch", table_ns / ops);
+    printf("%-12s %8.1f ns/name\n", "cmd_lookup", lookup_ns / ops);
+    CHECK(ctx.calls == (int)(iterations * (nlines - 1)), "%d handler calls", ctx.calls);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned iterations = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 0) : 1000000;
+    test_lookup();
+    test_dispatch();
+    bench(iterations);
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * 事件驱动的串口接收的测试（08_uart/components/uart_line_rx），模拟的串口驱动和 pthread 实现的 FreeRTOS
+ *
+ * 分段：一行分在几次接收中、一次接收中有几行、CRLF；
+ * 事件：一次收到的行数超过事件队列的长度，丢掉的事件不丢行；
+ * 溢出：回调阻塞时驱动的接收缓冲区满（UART_BUFFER_FULL），不完整的一行丢弃，之后的行正常；
+ * 停止：接收任务退出，驱动删除。
+ *
+ * 用法：uart_line_rx_test
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "uart_line_rx.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "test_util.h"
+
+#define TEST_PORT UART_NUM_1
+#define TEST_RX_SIZE 256
+#define TEST_MAX_LINES 64
+#define TEST_LINE_LEN 64
+
+static char s_lines[TEST_MAX_LINES][TEST_LINE_LEN];
+static int s_count = 0;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static SemaphoreHandle_t s_gate;
+static volatile bool s_block = false;
+
+static void on_line(void *ctx, const uint8_t *line, size_t len)
+{
+    pthread_mutex_lock(&s_lock);
+    if (s_count < TEST_MAX_LINES)
+    {
+        size_t n = len < TEST_LINE_LEN - 1 ? len : TEST_LINE_LEN - 1;
+        memcpy(s_lines[s_count], line, n);
+        s_lines[s_count][n] = '\0';
+    }
+    s_count++;
+    pthread_mutex_unlock(&s_lock);
+    // 模拟处理得慢的回调
+    if (s_block)
+    {
+        xSemaphoreTake(s_gate, portMAX_DELAY);
+    }
+}
+
+static int line_count(void)
+{
+    pthread_mutex_lock(&s_lock);
+    int n = s_count;
+    pthread_mutex_unlock(&s_lock);
+    return n;
+}
+
+static void clear_lines(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_count = 0;
+    pthread_mutex_unlock(&s_lock);
+}
+
+/**
+ * @description: 等到收到 n 行，最多 1 秒
+ */
+static bool wait_lines(int n)
+{
+    for (int i = 0; i < 1000; i++)
+    {
+        if (line_count() >= n)
+        {
+            return true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return false;
+}
+
+static void inject(const char *s)
+{
+    uart_sim_inject(TEST_PORT, s, strlen(s));
+}
+
+static void test_split(void)
+{
+    printf("split lines\n");
+    clear_lines();
+    inject("hel");
+    inject("lo\nwor");
+    vTaskDelay(pdMS_TO_TICKS(5));
+    CHECK(line_count() == 1, "only the complete line, got %d", line_count());
+    inject("ld\r\n\nfoo\r");
+    inject("\n");
+    CHECK(wait_lines(4), "lines %d", line_count());
+    CHECK(strcmp(s_lines[0], "hello") == 0, "'%s'", s_lines[0]);
+    CHECK(strcmp(s_lines[1], "world") == 0, "CRLF '%s'", s_lines[1]);
+    CHECK(s_lines[2][0] == '\0', "empty line '%s'", s_lines[2]);
+    CHECK(strcmp(s_lines[3], "foo") == 0, "'%s'", s_lines[3]);
+}
+
+static void test_burst(uart_line_rx_handle_t rx)
+{
+    printf("burst\n");
+    clear_lines();
+    uint32_t events, dropped;
+    uart_sim_get_event_counts(TEST_PORT, &events, &dropped);
+    // 30 行（不超过驱动的接收缓冲区），每行一个结束符事件，超过 20 个的事件队列
+    char burst[30 * 8 + 1];
+    for (int i = 0; i < 30; i++)
+    {
+        sprintf(&burst[i * 8], "line %02d\n", i);
+    }
+    inject(burst);
+    CHECK(wait_lines(30), "lines %d", line_count());
+    bool ordered = true;
+    for (int i = 0; i < 30 && i < line_count(); i++)
+    {
+        char expect[16];
+        sprintf(expect, "line %02d", i);
+        ordered &= strcmp(s_lines[i], expect) == 0;
+    }
+    CHECK(ordered && line_count() == 30, "lines in order");
+    uint32_t events2, dropped2;
+    uart_sim_get_event_counts(TEST_PORT, &events2, &dropped2);
+    printf("  %u events, %u dropped\n", events2 - events, dropped2 - dropped);
+
+    line_rx_stats_t stats;
+    uart_line_rx_get_stats(rx, &stats);
+    CHECK(stats.overruns == 0, "overruns %u", stats.overruns);
+}
+
+static void test_overflow(uart_line_rx_handle_t rx)
+{
+    printf("overflow\n");
+    clear_lines();
+    // 回调阻塞在第一行，其间收到的数据超过驱动的接收缓冲区
+    s_block = true;
+    inject("first\n");
+    CHECK(wait_lines(1), "first line");
+    char flood[3 * TEST_RX_SIZE];
+    memset(flood, 'x', sizeof(flood));
+    int accepted = uart_sim_inject(TEST_PORT, flood, sizeof(flood));
+    CHECK(accepted == TEST_RX_SIZE, "accepted %d", accepted);
+    s_block = false;
+    xSemaphoreGive(s_gate);
+
+    // 等接收任务处理完 UART_BUFFER_FULL（清空驱动的缓冲区）
+    line_rx_stats_t stats = {0};
+    for (int i = 0; i < 1000 && stats.overruns == 0; i++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1));
+        uart_line_rx_get_stats(rx, &stats);
+    }
+    CHECK(stats.overruns == 1, "overruns %u", stats.overruns);
+    vTaskDelay(pdMS_TO_TICKS(5));
+
+    // 断掉的一行剩下的部分丢弃到结束符，之后的行正常
+    inject("tail\nafter\n");
+    CHECK(wait_lines(2), "lines %d", line_count());
+    vTaskDelay(pdMS_TO_TICKS(5));
+    CHECK(line_count() == 2 && strcmp(s_lines[1], "after") == 0, "after overflow: %d lines, '%s'", line_count(),
+          s_lines[1]);
+}
+
+int main(void)
+{
+    s_gate = xSemaphoreCreateBinary();
+    uart_config_t uart_config = {
+        .baud_rate = 115200,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_APB,
+    };
+    CHECK(uart_param_config(TEST_PORT, &uart_config) == ESP_OK, "uart_param_config");
+
+    uart_line_rx_config_t config = UART_LINE_RX_DEFAULT_CONFIG(TEST_PORT, on_line, NULL);
+    config.driver_rx_size = TEST_RX_SIZE;
+    uart_line_rx_handle_t rx = NULL;
+    config.cb = NULL;
+    CHECK(uart_line_rx_start(&config, &rx) == ESP_ERR_INVALID_ARG, "no callback");
+    config.cb = on_line;
+    CHECK(uart_line_rx_start(&config, &rx) == ESP_OK && rx, "start");
+    if (rx)
+    {
+        test_split();
+        test_burst(rx);
+        test_overflow(rx);
+
+        printf("stop\n");
+        uart_line_rx_stop(rx);
+        CHECK(uart_sim_inject(TEST_PORT, "x\n", 2) < 0, "driver deleted");
+    }
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,388 @@
+/*
+ * uart_link 传输层的测试和性能测量（08_uart/components/uart_link）
+ *
+ * 帧：COBS 编解码各种长度（有很多 0、没有 0、254 字节的边界），CRC-16 的校验值。
+ * 协议：两端通过模拟的串口相连（虚拟时间，按波特率计算每帧发完的时间），双向发送长度不一的可靠数据，
+ * 检查按顺序、不重复、内容正确地收到，统计有效吞吐量占线路速率的比例。信道可以丢帧和改错字节；
+ * 中途重启一端（新的会话号），对端重新同步；数据报不重发也不重复。
+ * 最后在 pty 上用 uart_link_posix 两端（两个线程）实际收发一遍。
+ *
+ * 用法：uart_link_test [消息数] [波特率]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <pty.h>
+#include <termios.h>
+#include "link_frame.h"
+#include "link_proto.h"
+#include "line_rx.h"
+#include "uart_link_posix.h"
+#include "test_util.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+#define SIM_MAX_FRAMES 64
+#define SIM_LATENCY_US 50
+
+static uint32_t sim_rand(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/**
+ * @description: 第 i 条消息的长度和内容，有 0 也有 0xFF
+ */
+static size_t make_msg(uint32_t i, uint8_t *out)
+{
+    size_t len = (i * 37u) % (LINK_MAX_PAYLOAD + 1);
+    for (size_t k = 0; k < len; k++)
+    {
+        out[k] = (k % 9 == 0) ? 0 : (uint8_t)(i * 7 + k);
+    }
+    if (len >= 4)
+    {
+        memcpy(out, &i, 4);
+    }
+    return len;
+}
+
+static void test_frame(void)
+{
+    CHECK(crc16_ccitt(0xFFFF, "123456789", 9) == 0x29B1, "crc16 check value");
+    static uint8_t in[1200], enc[COBS_MAX_ENCODED(1200)], dec[1200];
+    uint32_t seed = 1;
+    int bad = 0;
+    for (size_t len = 0; len < sizeof(in); len += (len < 600 ? 1 : 37))
+    {
+        for (int pattern = 0; pattern < 3; pattern++)
+        {
+            for (size_t k = 0; k < len; k++)
+            {
+                uint8_t v = sim_rand(&seed);
+                in[k] = pattern == 0 ? v : pattern == 1 ? (v | 1) : (v & 1);
+            }
+            size_t n = cobs_encode(in, len, enc);
+            size_t out_len = 0;
+            bad += n > COBS_MAX_ENCODED(len) || memchr(enc, 0, n) != NULL;
+            bad += !cobs_decode(enc, n, dec, &out_len) || out_len != len || memcmp(in, dec, len) != 0;
+            // 原地解码
+            bad += !cobs_decode(enc, n, enc, &out_len) || out_len != len || memcmp(in, enc, len) != 0;
+        }
+    }
+    CHECK(bad == 0, "%d cobs round trips failed", bad);
+    size_t out_len;
+    const uint8_t broken[] = {0x05, 0x11, 0x22};
+    CHECK(!cobs_decode(broken, sizeof(broken), dec, &out_len), "truncated frame decoded");
+}
+
+typedef struct
+{
+    int64_t arrive_us;
+    uint16_t len;
+    uint8_t data[LINK_MAX_ENCODED];
+} sim_frame_t;
+
+typedef struct sim_end_s sim_end_t;
+
+struct sim_end_s
+{
+    link_hw_t parent;
+    link_t link;
+    line_rx_t rx;
+    uint8_t rx_buf[4 * LINK_MAX_ENCODED];
+    sim_end_t *peer;
+    sim_frame_t queue[SIM_MAX_FRAMES]; /*!< 发往对端、还在线路上的帧 */
+    int head;
+    int count;
+    int64_t busy_us;                   /*!< 线路发完的时间 */
+    uint32_t next_tx;                  /*!< 下一条要发的消息 */
+    uint32_t next_rx;                  /*!< 期望收到的下一条消息 */
+    uint32_t bad_rx;
+    uint32_t dgrams;
+    uint64_t rx_payload;
+};
+
+typedef struct
+{
+    uint32_t baud;
+    uint32_t drop_ppm;    /*!< 丢帧的概率 */
+    uint32_t corrupt_ppm; /*!< 改错一个字节的概率 */
+    uint32_t rand;
+} sim_channel_t;
+
+static int64_t s_now;
+static sim_channel_t s_chan;
+
+static int64_t sim_now_us(link_hw_t *hw)
+{
+    return s_now;
+}
+
+static esp_err_t sim_write(link_hw_t *hw, const uint8_t *data, size_t len)
+{
+    sim_end_t *e = __containerof(hw, sim_end_t, parent);
+    // 帧在线路上排队：上一帧发完才开始发
+    e->busy_us = (e->busy_us > s_now ? e->busy_us : s_now) + (int64_t)len * 10 * 1000000 / s_chan.baud;
+    if (e->count == SIM_MAX_FRAMES || sim_rand(&s_chan.rand) % 1000000 < s_chan.drop_ppm)
+    {
+        return ESP_OK;
+    }
+    sim_frame_t *f = &e->queue[(e->head + e->count++) % SIM_MAX_FRAMES];
+    f->arrive_us = e->busy_us + SIM_LATENCY_US;
+    f->len = len;
+    memcpy(f->data, data, len);
+    if (sim_rand(&s_chan.rand) % 1000000 < s_chan.corrupt_ppm)
+    {
+        f->data[sim_rand(&s_chan.rand) % len] ^= 1 << (sim_rand(&s_chan.rand) % 8);
+    }
+    return ESP_OK;
+}
+
+static void sim_on_rx(void *ctx, const uint8_t *data, size_t len, bool reliable)
+{
+    sim_end_t *e = ctx;
+    if (!reliable)
+    {
+        e->dgrams++;
+        return;
+    }
+    uint8_t expect[LINK_MAX_PAYLOAD];
+    size_t n = make_msg(e->next_rx, expect);
+    e->bad_rx += n != len || memcmp(expect, data, len) != 0;
+    e->next_rx++;
+    e->rx_payload += len;
+}
+
+static void sim_init(sim_end_t *e, sim_end_t *peer, uint8_t session)
+{
+    memset(e, 0, sizeof(*e));
+    e->parent.write = sim_write;
+    e->parent.now_us = sim_now_us;
+    e->peer = peer;
+    link_config_t config = LINK_DEFAULT_CONFIG(session, sim_on_rx, e);
+    config.baud = s_chan.baud;
+    link_init(&e->link, &config, &e->parent);
+    line_rx_config_t rx_config = LINE_RX_DEFAULT_CONFIG(e->rx_buf, sizeof(e->rx_buf));
+    rx_config.max_line = LINK_MAX_ENCODED;
+    rx_config.term = 0;
+    rx_config.strip_cr = false;
+    line_rx_init(&e->rx, &rx_config);
+}
+
+/**
+ * @description: 把已经到达的帧交给对端
+ */
+static void sim_deliver(sim_end_t *e)
+{
+    while (e->count && e->queue[e->head].arrive_us <= s_now)
+    {
+        sim_frame_t *f = &e->queue[e->head];
+        line_rx_feed(&e->peer->rx, f->data, f->len);
+        e->head = (e->head + 1) % SIM_MAX_FRAMES;
+        e->count--;
+        line_rx_view_t view;
+        while (line_rx_next(&e->peer->rx, &view))
+        {
+            link_input(&e->peer->link, view.data, view.len);
+            line_rx_release(&e->peer->rx, &view);
+        }
+    }
+}
+
+/**
+ * @description: 发送方在线路空闲时发下一条，避免写入的帧在线路上排太久
+ */
+static void sim_send(sim_end_t *e, uint32_t total)
+{
+    uint8_t msg[LINK_MAX_PAYLOAD];
+    while (e->next_tx < total && e->busy_us <= s_now + 200)
+    {
+        size_t len = make_msg(e->next_tx, msg);
+        if (link_send(&e->link, msg, len, true) != ESP_OK)
+        {
+            break;
+        }
+        e->next_tx++;
+    }
+}
+
+static int64_t sim_run(sim_end_t *a, sim_end_t *b, uint32_t a_total, uint32_t b_total, int64_t limit_us)
+{
+    int64_t start = s_now;
+    while ((a->next_rx < b_total || b->next_rx < a_total) && s_now - start < limit_us)
+    {
+        sim_send(a, a_total);
+        sim_send(b, b_total);
+        link_poll(&a->link);
+        link_poll(&b->link);
+        s_now += 10;
+        sim_deliver(a);
+        sim_deliver(b);
+    }
+    return s_now - start;
+}
+
+static void report(const char *name, const sim_end_t *a, const sim_end_t *b, int64_t elapsed_us)
+{
+    uint64_t payload = a->rx_payload + b->rx_payload;
+    double wire = (double)s_chan.baud / 10 * elapsed_us / 1e6 * 2; // 两个方向
+    printf("%-10s %6.1f ms, payload %7.1f KiB/s per direction (%4.1f%% of the line), retransmits %u+%u, "
+           "crc/cobs errors %u, out of order %u\n",
+           name, elapsed_us / 1000.0, payload / 2.0 / 1024 / (elapsed_us / 1e6), 100.0 * payload / wire,
+           a->link.stats.retransmits, b->link.stats.retransmits, a->link.stats.rx_errors + b->link.stats.rx_errors,
+           a->link.stats.rx_dropped + b->link.stats.rx_dropped);
+}
+
+static void test_link(const char *name, uint32_t total, uint32_t drop_ppm, uint32_t corrupt_ppm)
+{
+    static sim_end_t a, b;
+    s_chan.drop_ppm = drop_ppm;
+    s_chan.corrupt_ppm = corrupt_ppm;
+    s_chan.rand = 12345;
+    sim_init(&a, &b, 0x11);
+    sim_init(&b, &a, 0x22);
+    int64_t elapsed = sim_run(&a, &b, total, total, 60000000);
+    report(name, &a, &b, elapsed);
+    CHECK(a.next_rx == total && b.next_rx == total, "%s: received %u/%u of %u", name, a.next_rx, b.next_rx, total);
+    CHECK(a.bad_rx == 0 && b.bad_rx == 0, "%s: %u/%u bad messages", name, a.bad_rx, b.bad_rx);
+    CHECK(a.link.stats.lost == 0 && b.link.stats.lost == 0, "%s: frames given up", name);
+    if (!drop_ppm && !corrupt_ppm)
+    {
+        CHECK(a.link.stats.retransmits == 0 && b.link.stats.retransmits == 0, "%s: retransmits on a clean line", name);
+    }
+}
+
+static void test_restart(uint32_t total)
+{
+    static sim_end_t a, b;
+    s_chan.drop_ppm = 10000;
+    s_chan.corrupt_ppm = 0;
+    s_chan.rand = 777;
+    sim_init(&a, &b, 0x33);
+    sim_init(&b, &a, 0x44);
+    sim_run(&a, &b, total / 2, 0, 60000000);
+    CHECK(b.next_rx == total / 2, "restart: %u before", b.next_rx);
+
+    // a 重启：新的会话号，消息从头编号，线路上还有旧的帧
+    uint32_t b_rx = b.next_rx;
+    link_config_t config = a.link.config;
+    config.session = 0x35;
+    link_init(&a.link, &config, &a.parent);
+    a.next_tx = 0;
+    b.next_rx = 0;
+    sim_run(&a, &b, total / 2, 0, 60000000);
+    CHECK(b.next_rx == total / 2 && b.bad_rx == 0, "restart: %u after, %u bad", b.next_rx, b.bad_rx);
+    CHECK(b.link.stats.resyncs == 1, "restart: %u resyncs", b.link.stats.resyncs);
+    printf("%-10s %u + %u messages across a restart, %u resync\n", "restart", b_rx, b.next_rx,
+           b.link.stats.resyncs);
+}
+
+static void test_dgram(void)
+{
+    static sim_end_t a, b;
+    s_chan.drop_ppm = 100000;
+    s_chan.corrupt_ppm = 100000;
+    s_chan.rand = 99;
+    sim_init(&a, &b, 1);
+    sim_init(&b, &a, 2);
+    uint8_t msg[64] = {0};
+    for (int i = 0; i < 1000; i++)
+    {
+        link_send(&a.link, msg, sizeof(msg), false);
+        s_now += 400;
+        sim_deliver(&a);
+    }
+    s_now += 100000;
+    sim_deliver(&a);
+    CHECK(b.dgrams > 700 && b.dgrams < 900, "dgram: %u of 1000", b.dgrams);
+    CHECK(a.link.stats.retransmits == 0 && link_tx_pending(&a.link) == 0, "dgram retransmitted");
+    CHECK(b.link.stats.tx_frames == 0, "dgram acknowledged");
+}
+
+typedef struct
+{
+    uart_link_posix_t *l;
+    uint32_t expect;
+    uint32_t received;
+    uint32_t bad;
+} pty_end_t;
+
+static void pty_on_rx(void *ctx, const uint8_t *data, size_t len, bool reliable)
+{
+    pty_end_t *e = ctx;
+    uint8_t expect[LINK_MAX_PAYLOAD];
+    size_t n = make_msg(e->received++, expect);
+    e->bad += n != len || memcmp(expect, data, len) != 0;
+}
+
+static void *pty_rx_thread(void *arg)
+{
+    pty_end_t *e = arg;
+    for (int idle = 0; e->received < e->expect && idle < 50;)
+    {
+        idle = uart_link_posix_poll(e->l, 100) > 0 ? 0 : idle + 1;
+    }
+    // 再等一会，让最后的确认发出去
+    uart_link_posix_poll(e->l, 20);
+    return NULL;
+}
+
+static void test_pty(uint32_t total)
+{
+    int master, slave;
+    if (openpty(&master, &slave, NULL, NULL, NULL) != 0)
+    {
+        printf("pty        skipped (openpty failed)\n");
+        return;
+    }
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    pty_end_t tx = {0}, rx = {.expect = total};
+    link_config_t tx_config = LINK_DEFAULT_CONFIG(0x55, pty_on_rx, &tx);
+    link_config_t rx_config = LINK_DEFAULT_CONFIG(0x66, pty_on_rx, &rx);
+    tx.l = uart_link_posix_attach(master, &tx_config);
+    rx.l = uart_link_posix_attach(slave, &rx_config);
+    pthread_t thread;
+    pthread_create(&thread, NULL, pty_rx_thread, &rx);
+
+    uint8_t msg[LINK_MAX_PAYLOAD];
+    int failed = 0;
+    for (uint32_t i = 0; i < total; i++)
+    {
+        size_t len = make_msg(i, msg);
+        failed += uart_link_posix_send(tx.l, msg, len, true, 2000) != ESP_OK;
+    }
+    failed += uart_link_posix_flush(tx.l, 2000) != ESP_OK;
+    pthread_join(thread, NULL);
+    printf("%-10s %u messages, %u retransmits\n", "pty", rx.received, uart_link_posix_stats(tx.l)->retransmits);
+    CHECK(failed == 0, "pty: %d sends failed", failed);
+    CHECK(rx.received == total && rx.bad == 0, "pty: received %u of %u, %u bad", rx.received, total, rx.bad);
+    uart_link_posix_close(tx.l);
+    uart_link_posix_close(rx.l);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t total = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 2000;
+    s_chan.baud = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 2000000;
+    test_frame();
+    printf("%u messages each way, %u baud\n", total, s_chan.baud);
+    test_link("clean", total, 0, 0);
+    test_link("lossy", total, 20000, 10000);
+    test_restart(total);
+    test_dgram();
+    test_pty(total / 4);
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,347 @@
+/*
+ * txq 的测试和性能测量（08_uart/components/uart_txq）
+ *
+ * 模拟的串口：一个线程按波特率从队列中取数据（每次最多一个 FIFO 的 128 字节），发完后 consume，
+ * 数据环回给检查器，逐条核对消息（帧头、数据、校验三段用 writev 放入）。几个生产者线程同时发送，
+ * 队列满时等流量控制的通知。与直接写串口（没有发送缓冲区，调用返回时数据已经进入 FIFO）比较
+ * 生产者每次调用的耗时；同时统计完成回调的延迟和线路利用率。
+ *
+ * 用法：uart_txq_bench [每个生产者的消息数] [波特率]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "txq.h"
+#include "test_util.h"
+
+#define PRODUCERS 4
+#define FIFO_SIZE 128
+#define QUEUE_SIZE 4096
+#define MAX_MSGS 20000
+
+typedef struct __attribute__((packed))
+{
+    uint8_t producer;
+    uint16_t seq;
+    uint16_t len;
+} msg_header_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t t)
+{
+    uint64_t now = now_ns();
+    if (t > now)
+    {
+        struct timespec ts = {(t - now) / 1000000000ull, (t - now) % 1000000000ull};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static size_t make_payload(int producer, uint32_t seq, uint8_t *out)
+{
+    size_t len = 8 + (seq * 53 + producer * 17) % 200;
+    for (size_t k = 0; k < len; k++)
+    {
+        out[k] = (uint8_t)(seq + k * producer);
+    }
+    return len;
+}
+
+static uint8_t checksum(const uint8_t *p, size_t len)
+{
+    uint8_t s = 0;
+    while (len--)
+    {
+        s += *p++;
+    }
+    return s;
+}
+
+/* 环回的检查器：按消息格式解析串口上出现的字节 */
+typedef struct
+{
+    uint8_t buf[sizeof(msg_header_t) + 256];
+    size_t have;
+    uint32_t next_seq[PRODUCERS];
+    uint32_t messages;
+    uint32_t bad;
+} checker_t;
+
+static void checker_feed(checker_t *c, const uint8_t *data, size_t len)
+{
+    while (len--)
+    {
+        c->buf[c->have++] = *data++;
+        if (c->have < sizeof(msg_header_t))
+        {
+            continue;
+        }
+        msg_header_t h;
+        memcpy(&h, c->buf, sizeof(h));
+        if (h.producer >= PRODUCERS || h.len > 256)
+        {
+            c->bad++;
+            c->have = 0;
+            continue;
+        }
+        if (c->have < sizeof(h) + h.len + 1)
+        {
+            continue;
+        }
+        uint8_t expect[256];
+        size_t n = make_payload(h.producer, h.seq, expect);
+        c->bad += h.seq != (uint16_t)c->next_seq[h.producer] || n != h.len ||
+                  memcmp(expect, c->buf + sizeof(h), n) != 0 || c->buf[sizeof(h) + n] != checksum(expect, n);
+        c->next_seq[h.producer] = h.seq + 1;
+        c->messages++;
+        c->have = 0;
+    }
+}
+
+/* 与串口驱动中的锁相同：保护 txq */
+typedef struct
+{
+    txq_t q;
+    uint8_t buf[QUEUE_SIZE];
+    pthread_mutex_t lock;
+    pthread_cond_t ready;   /*!< 流量控制：可以继续放入 */
+    bool paused;
+    bool direct;            /*!< 比较用：生产者直接写串口，等到进入 FIFO */
+    uint32_t baud;
+    uint64_t wire_ns;       /*!< 线路发完已取出数据的时间 */
+    uint64_t enqueue_ns[MAX_MSGS * PRODUCERS];
+    uint64_t done_ns_sum;
+    uint64_t done_ns_max;
+    uint32_t done_count;
+    uint64_t call_ns[PRODUCERS];
+    uint64_t call_ns_max[PRODUCERS];
+    uint32_t waits[PRODUCERS];
+    uint32_t per_producer;
+    checker_t checker;
+    bool finished;
+} bench_t;
+
+static bench_t s_bench;
+
+static void on_flow(void *ctx, bool ready)
+{
+    bench_t *b = ctx;
+    b->paused = !ready;
+    if (ready)
+    {
+        pthread_cond_broadcast(&b->ready);
+    }
+}
+
+static void on_done(void *ctx, uint32_t id)
+{
+    bench_t *b = ctx;
+    uint64_t latency = now_ns() - b->enqueue_ns[id];
+    b->done_ns_sum += latency;
+    b->done_ns_max = latency > b->done_ns_max ? latency : b->done_ns_max;
+    b->done_count++;
+}
+
+/**
+ * @description: 发出 n 字节：等线路发完，再交给检查器
+ */
+static void wire_send(bench_t *b, const uint8_t *data, size_t n)
+{
+    uint64_t now = now_ns();
+    b->wire_ns = (b->wire_ns > now ? b->wire_ns : now) + (uint64_t)n * 10 * 1000000000ull / b->baud;
+    sleep_until_ns(b->wire_ns);
+    checker_feed(&b->checker, data, n);
+}
+
+static void *wire_thread(void *arg)
+{
+    bench_t *b = arg;
+    pthread_mutex_lock(&b->lock);
+    while (!b->finished || txq_fill(&b->q))
+    {
+        const uint8_t *data;
+        size_t n = txq_peek(&b->q, &data);
+        if (n == 0)
+        {
+            pthread_mutex_unlock(&b->lock);
+            sleep_until_ns(now_ns() + 20000);
+            pthread_mutex_lock(&b->lock);
+            continue;
+        }
+        n = n < FIFO_SIZE ? n : FIFO_SIZE;
+        pthread_mutex_unlock(&b->lock);
+        wire_send(b, data, n);
+        pthread_mutex_lock(&b->lock);
+        txq_consume(&b->q, n);
+    }
+    pthread_mutex_unlock(&b->lock);
+    return NULL;
+}
+
+static void *producer_thread(void *arg)
+{
+    int p = (int)(intptr_t)arg;
+    bench_t *b = &s_bench;
+    uint8_t payload[256];
+    for (uint32_t seq = 0; seq < b->per_producer; seq++)
+    {
+        msg_header_t h = {.producer = p, .seq = seq};
+        h.len = make_payload(p, seq, payload);
+        uint8_t sum = checksum(payload, h.len);
+        const txq_iov_t iov[] = {{&h, sizeof(h)}, {payload, h.len}, {&sum, 1}};
+
+        uint64_t start = now_ns();
+        if (b->direct)
+        {
+            // 没有发送缓冲区：整条消息按 FIFO 大小一段段写入，返回时已经进入 FIFO
+            pthread_mutex_lock(&b->lock);
+            uint8_t msg[sizeof(h) + 256 + 1];
+            memcpy(msg, &h, sizeof(h));
+            memcpy(msg + sizeof(h), payload, h.len);
+            msg[sizeof(h) + h.len] = sum;
+            size_t len = sizeof(h) + h.len + 1;
+            for (size_t off = 0; off < len; off += FIFO_SIZE)
+            {
+                wire_send(b, msg + off, len - off < FIFO_SIZE ? len - off : FIFO_SIZE);
+            }
+            pthread_mutex_unlock(&b->lock);
+        }
+        else
+        {
+            pthread_mutex_lock(&b->lock);
+            uint32_t id;
+            while (txq_writev(&b->q, iov, 3, on_done, b, &id) == ESP_ERR_NO_MEM)
+            {
+                // 队列满：等流量控制通知，不计入调用耗时
+                b->waits[p]++;
+                uint64_t wait_start = now_ns();
+                while (b->paused || txq_fill(&b->q) + sizeof(h) + h.len + 1 > QUEUE_SIZE)
+                {
+                    pthread_cond_wait(&b->ready, &b->lock);
+                }
+                start += now_ns() - wait_start;
+            }
+            b->enqueue_ns[id] = start;
+            pthread_mutex_unlock(&b->lock);
+        }
+        uint64_t took = now_ns() - start;
+        b->call_ns[p] += took;
+        b->call_ns_max[p] = took > b->call_ns_max[p] ? took : b->call_ns_max[p];
+    }
+    return NULL;
+}
+
+static void run(const char *name, bool direct, uint32_t per_producer, uint32_t baud)
+{
+    bench_t *b = &s_bench;
+    memset(b, 0, sizeof(*b));
+    b->direct = direct;
+    b->baud = baud;
+    b->per_producer = per_producer;
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->ready, NULL);
+    txq_config_t config = TXQ_DEFAULT_CONFIG(b->buf, sizeof(b->buf));
+    config.flow = on_flow;
+    config.flow_ctx = b;
+    txq_init(&b->q, &config);
+
+    uint64_t start = now_ns();
+    pthread_t wire, producers[PRODUCERS];
+    pthread_create(&wire, NULL, wire_thread, b);
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        pthread_create(&producers[p], NULL, producer_thread, (void *)(intptr_t)p);
+    }
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        pthread_join(producers[p], NULL);
+    }
+    pthread_mutex_lock(&b->lock);
+    b->finished = true;
+    pthread_mutex_unlock(&b->lock);
+    pthread_join(wire, NULL);
+    double elapsed = (now_ns() - start) / 1e9;
+
+    uint64_t call_sum = 0, call_max = 0;
+    uint32_t waits = 0;
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        call_sum += b->call_ns[p];
+        call_max = b->call_ns_max[p] > call_max ? b->call_ns_max[p] : call_max;
+        waits += b->waits[p];
+    }
+    uint32_t total = per_producer * PRODUCERS;
+    uint64_t bytes = b->q.stats.bytes;
+    if (direct)
+    {
+        printf("%-8s call %9.1f us avg %9.1f us max\n", name, call_sum / 1e3 / total, call_max / 1e3);
+    }
+    else
+    {
+        printf("%-8s call %9.1f us avg %9.1f us max, %4.1f%% of the line, done after %.1f ms avg %.1f ms max, "
+               "%u pauses, %u waits, fill max %zu\n",
+               name, call_sum / 1e3 / total, call_max / 1e3, 100.0 * bytes * 10 / baud / elapsed,
+               b->done_count ? b->done_ns_sum / 1e6 / b->done_count : 0, b->done_ns_max / 1e6, b->q.stats.pauses,
+               waits, b->q.stats.max_fill);
+        CHECK(b->done_count == total, "%s: %u of %u completions", name, b->done_count, total);
+    }
+    CHECK(b->checker.messages == total && b->checker.bad == 0, "%s: %u of %u messages, %u bad", name,
+          b->checker.messages, total, b->checker.bad);
+}
+
+static void test_wrap(void)
+{
+    // 单线程：消息跨过缓冲区末尾、部分交出、完成回调的顺序
+    static uint8_t buf[64];
+    txq_t q;
+    txq_config_t config = TXQ_DEFAULT_CONFIG(buf, sizeof(buf));
+    CHECK(txq_init(&q, &config), "init");
+    config.size = 60;
+    txq_t q2;
+    CHECK(!txq_init(&q2, &config), "size not a power of two accepted");
+
+    uint8_t msg[40];
+    for (int i = 0; i < 40; i++)
+    {
+        msg[i] = i;
+    }
+    const txq_iov_t iov[] = {{msg, 30}, {msg + 30, 10}};
+    s_bench.done_count = 0;
+    CHECK(txq_writev(&q, iov, 2, NULL, NULL, NULL) == ESP_OK, "first");
+    CHECK(txq_writev(&q, iov, 2, NULL, NULL, NULL) == ESP_ERR_NO_MEM, "overfill accepted");
+    const uint8_t *data;
+    CHECK(txq_peek(&q, &data) == 40 && memcmp(data, msg, 40) == 0, "peek");
+    txq_consume(&q, 40);
+    uint32_t id;
+    CHECK(txq_writev(&q, iov, 2, NULL, NULL, &id) == ESP_OK && id == 1, "wrapped write");
+    size_t n = txq_peek(&q, &data);
+    CHECK(n == 24 && memcmp(data, msg, 24) == 0, "first part %zu", n);
+    txq_consume(&q, n);
+    n = txq_peek(&q, &data);
+    CHECK(n == 16 && memcmp(data, msg + 24, 16) == 0, "second part %zu", n);
+    txq_consume(&q, n);
+    CHECK(txq_fill(&q) == 0, "not empty");
+    const txq_iov_t big = {buf, 65};
+    CHECK(txq_writev(&q, &big, 1, NULL, NULL, NULL) == ESP_ERR_INVALID_SIZE, "too big accepted");
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t per_producer = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 500;
+    uint32_t baud = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 2000000;
+    per_producer = per_producer < MAX_MSGS ? per_producer : MAX_MSGS;
+    test_wrap();
+    printf("%d producers x %u messages (13..212 bytes), %u baud\n", PRODUCERS, per_producer, baud);
+    run("direct", true, per_producer, baud);
+    run("txq", false, per_producer, baud);
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
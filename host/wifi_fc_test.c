@@ -0,0 +1,302 @@
+/*
+ * wifi_fc_fsm 的测试（07_NTP/components/wifi_fast_connect）
+ *
+ * 模拟的驱动按虚拟时钟安排事件：扫描连接 2.5 s，指定 BSSID 和信道直连 150 ms，
+ * DHCP 800 ms，静态地址 20 ms。AP 可以关机、换信道，DHCP 可以不应答，断开可以不发事件。
+ * 每个场景检查状态机的结果和 RTC 缓存，打印连接耗时。
+ *
+ * 用法：wifi_fc_test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "wifi_fc_fsm.h"
+#include "test_util.h"
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
+#define SCAN_MS 2500
+#define FAST_MS 150
+#define FAST_MISS_MS 300
+#define DHCP_MS 800
+#define STATIC_MS 20
+#define MAX_EVENTS 8
+#define NO_TIME INT64_MAX
+
+typedef struct
+{
+    int64_t at;
+    wifi_fc_event_t event;
+} sim_event_t;
+
+typedef struct
+{
+    wifi_fc_driver_t parent;
+    int64_t now;             /*!< 虚拟时间，us */
+    int64_t rtc_offset;      /*!< rtc_us() 比 now 多出来的部分，模拟深度睡眠的时间 */
+    int64_t timeout_at;
+    sim_event_t events[MAX_EVENTS];
+    int event_count;
+    // AP
+    bool ap_online;
+    uint8_t ap_bssid[6];
+    uint8_t ap_channel;
+    uint32_t dhcp_failures;  /*!< 接下来几次 DHCP 不应答 */
+    bool silent_disconnect;  /*!< disconnect() 不产生断开事件 */
+    // 当前连接
+    bool static_ip;
+    wifi_fc_ip_t ip;
+    uint32_t scans;
+    uint32_t fast_connects;
+} sim_driver_t;
+
+static const wifi_fc_ip_t s_lease = {0x6401A8C0, 0x00FFFFFF, 0x0101A8C0, 0x0101A8C0}; // 192.168.1.100
+
+static void sim_schedule(sim_driver_t *s, int64_t delay_ms, wifi_fc_event_t event)
+{
+    if (s->event_count < MAX_EVENTS)
+    {
+        s->events[s->event_count++] = (sim_event_t){s->now + delay_ms * 1000, event};
+    }
+}
+
+static esp_err_t sim_connect(wifi_fc_driver_t *drv, const uint8_t *bssid, uint8_t channel)
+{
+    sim_driver_t *s = __containerof(drv, sim_driver_t, parent);
+    s->event_count = 0;
+    if (bssid)
+    {
+        s->fast_connects++;
+        bool found = s->ap_online && channel == s->ap_channel && memcmp(bssid, s->ap_bssid, 6) == 0;
+        sim_schedule(s, found ? FAST_MS : FAST_MISS_MS, found ? WIFI_FC_EVENT_ASSOCIATED : WIFI_FC_EVENT_DISCONNECTED);
+    }
+    else
+    {
+        s->scans++;
+        sim_schedule(s, SCAN_MS, s->ap_online ? WIFI_FC_EVENT_ASSOCIATED : WIFI_FC_EVENT_DISCONNECTED);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_set_ip(wifi_fc_driver_t *drv, const wifi_fc_ip_t *ip)
+{
+    sim_driver_t *s = __containerof(drv, sim_driver_t, parent);
+    s->static_ip = ip != NULL;
+    if (ip)
+    {
+        s->ip = *ip;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_disconnect(wifi_fc_driver_t *drv)
+{
+    sim_driver_t *s = __containerof(drv, sim_driver_t, parent);
+    s->event_count = 0;
+    if (!s->silent_disconnect)
+    {
+        sim_schedule(s, 10, WIFI_FC_EVENT_DISCONNECTED);
+    }
+    return ESP_OK;
+}
+
+static void sim_set_timeout(wifi_fc_driver_t *drv, uint32_t ms)
+{
+    sim_driver_t *s = __containerof(drv, sim_driver_t, parent);
+    s->timeout_at = ms ? s->now + (int64_t)ms * 1000 : NO_TIME;
+}
+
+static int64_t sim_now_us(wifi_fc_driver_t *drv)
+{
+    return __containerof(drv, sim_driver_t, parent)->now;
+}
+
+static int64_t sim_rtc_us(wifi_fc_driver_t *drv)
+{
+    sim_driver_t *s = __containerof(drv, sim_driver_t, parent);
+    return s->now + s->rtc_offset;
+}
+
+/**
+ * @description: 按时间顺序送出事件直到连上、失败或超过 60 s
+ */
+static wifi_fc_state_t sim_run(sim_driver_t *s, wifi_fc_t *fc)
+{
+    wifi_fc_start(fc);
+    while (fc->state != WIFI_FC_STATE_CONNECTED && fc->state != WIFI_FC_STATE_FAILED && s->now < 60000000)
+    {
+        int next = -1;
+        for (int i = 0; i < s->event_count; i++)
+        {
+            if (next < 0 || s->events[i].at < s->events[next].at)
+            {
+                next = i;
+            }
+        }
+        if (next < 0 && s->timeout_at == NO_TIME)
+        {
+            break; // 没有事件也没有超时，状态机卡住了
+        }
+        if (next < 0 || s->timeout_at <= s->events[next].at)
+        {
+            s->now = s->timeout_at;
+            s->timeout_at = NO_TIME;
+            wifi_fc_handle(fc, WIFI_FC_EVENT_TIMEOUT, NULL);
+            continue;
+        }
+        sim_event_t e = s->events[next];
+        s->events[next] = s->events[--s->event_count];
+        s->now = e.at;
+        wifi_fc_event_data_t data = {0};
+        if (e.event == WIFI_FC_EVENT_ASSOCIATED)
+        {
+            memcpy(data.bssid, s->ap_bssid, 6);
+            data.channel = s->ap_channel;
+            if (s->static_ip)
+            {
+                sim_schedule(s, STATIC_MS, WIFI_FC_EVENT_GOT_IP);
+            }
+            else if (s->dhcp_failures)
+            {
+                s->dhcp_failures--;
+            }
+            else
+            {
+                sim_schedule(s, DHCP_MS, WIFI_FC_EVENT_GOT_IP);
+            }
+        }
+        else if (e.event == WIFI_FC_EVENT_GOT_IP)
+        {
+            data.ip = s->static_ip ? s->ip : s_lease;
+        }
+        wifi_fc_handle(fc, e.event, &data);
+    }
+    return fc->state;
+}
+
+typedef struct
+{
+    const char *name;
+    wifi_fc_state_t state;
+    int fast;       /*!< 期望的 result.fast，-1 不检查 */
+    int static_ip;
+    int fell_back;
+    uint32_t scans; /*!< 期望的扫描次数 */
+    uint32_t fast_connects;
+} expect_t;
+
+/**
+ * @description: 模拟一次唤醒：虚拟时钟归零（esp_timer 重新计时），RTC 时间前进 sleep_s
+ */
+static void sim_wake(sim_driver_t *s, int64_t sleep_s, const wifi_fc_config_t *config, wifi_fc_cache_t *cache,
+                     const expect_t *expect)
+{
+    s->rtc_offset += s->now + sleep_s * 1000000;
+    s->now = 0;
+    s->event_count = 0;
+    s->timeout_at = NO_TIME;
+    s->scans = 0;
+    s->fast_connects = 0;
+    wifi_fc_t fc;
+    wifi_fc_init(&fc, config, &s->parent, cache);
+    sim_run(s, &fc);
+    const wifi_fc_result_t *r = &fc.result;
+    bool ok = fc.state == expect->state && (expect->fast < 0 || r->fast == expect->fast) &&
+              (expect->static_ip < 0 || r->static_ip == expect->static_ip) &&
+              (expect->fell_back < 0 || r->fell_back == expect->fell_back) && s->scans == expect->scans &&
+              s->fast_connects == expect->fast_connects;
+    // 连上后缓存必须指向当前的 AP，地址是 DHCP 分的
+    if (ok && fc.state == WIFI_FC_STATE_CONNECTED)
+    {
+        ok = wifi_fc_cache_valid(cache, config->ssid) && cache->channel == s->ap_channel &&
+             memcmp(cache->bssid, s->ap_bssid, 6) == 0 && cache->fast_failures == 0 && cache->ip.ip == s_lease.ip &&
+             cache->last_time_to_ip_ms == r->time_to_ip_ms;
+    }
+    printf("%-34s %-9s %-6s %-9s %-9s scans %u  %6u ms  %s\n", expect->name, wifi_fc_state_name(fc.state),
+           r->fast ? "fast" : "-", r->static_ip ? "static" : "dhcp", r->fell_back ? "fallback" : "-",
+           (unsigned)s->scans, (unsigned)r->time_to_ip_ms, ok ? "ok" : "FAILED");
+    if (!ok)
+    {
+        s_failures++;
+    }
+}
+
+int main(void)
+{
+    sim_driver_t sim = {
+        .parent = {sim_connect, sim_set_ip, sim_disconnect, sim_set_timeout, sim_now_us, sim_rtc_us},
+        .ap_online = true,
+        .ap_bssid = {0x24, 0x0A, 0xC4, 0x11, 0x22, 0x33},
+        .ap_channel = 6,
+        .rtc_offset = 1700000000LL * 1000000,
+    };
+    wifi_fc_config_t config = WIFI_FC_DEFAULT_CONFIG("llx");
+    wifi_fc_cache_t cache;
+    wifi_fc_cache_clear(&cache);
+
+    const expect_t cold = {"cold boot, empty cache", WIFI_FC_STATE_CONNECTED, 0, 0, 0, 1, 0};
+    sim_wake(&sim, 0, &config, &cache, &cold);
+    uint32_t cold_ms = cache.last_time_to_ip_ms;
+
+    const expect_t warm = {"wake, cached AP and IP", WIFI_FC_STATE_CONNECTED, 1, 1, 0, 0, 1};
+    sim_wake(&sim, 10, &config, &cache, &warm);
+    uint32_t warm_ms = cache.last_time_to_ip_ms;
+    // 静态复用地址不应延长有效期：连续唤醒到 ip_reuse_s 之后必须重新 DHCP
+    sim_wake(&sim, config.ip_reuse_s - 20, &config, &cache, &warm);
+
+    const expect_t stale = {"wake, IP older than ip_reuse_s", WIFI_FC_STATE_CONNECTED, 1, 0, 0, 0, 1};
+    sim_wake(&sim, 30, &config, &cache, &stale);
+
+    sim.ap_channel = 11;
+    const expect_t moved = {"AP moved to another channel", WIFI_FC_STATE_CONNECTED, 0, 0, 1, 1, 1};
+    sim_wake(&sim, 10, &config, &cache, &moved);
+
+    cache.ip_time_us ^= 1; // CRC 不再匹配
+    const expect_t corrupt = {"corrupted cache", WIFI_FC_STATE_CONNECTED, 0, 0, 0, 1, 0};
+    sim_wake(&sim, 10, &config, &cache, &corrupt);
+
+    wifi_fc_config_t other = config;
+    other.ssid = "other";
+    const expect_t ssid = {"SSID changed", WIFI_FC_STATE_CONNECTED, 0, 0, 0, 1, 0};
+    sim_wake(&sim, 10, &other, &cache, &ssid);
+    sim_wake(&sim, 10, &config, &cache, &cold);
+
+    // AP 关机：直连失败一次，扫描重试用完后失败；缓存保留，失败次数记一次
+    sim.ap_online = false;
+    const expect_t off = {"AP off", WIFI_FC_STATE_FAILED, 0, -1, 1, 1u + config.max_retry, 1};
+    sim_wake(&sim, 10, &config, &cache, &off);
+    if (!wifi_fc_cache_valid(&cache, config.ssid) || cache.fast_failures != 1)
+    {
+        printf("  cache after failure: valid %d, fast_failures %u\n", wifi_fc_cache_valid(&cache, config.ssid),
+               cache.fast_failures);
+        s_failures++;
+    }
+    sim.ap_online = true;
+    sim_wake(&sim, 10, &config, &cache, &warm);
+
+    // 直连时 DHCP 不应答且断开不产生事件：超时、放弃、再等放弃超时后扫描
+    sim.dhcp_failures = 1;
+    sim.silent_disconnect = true;
+    const expect_t no_dhcp = {"cached AP, DHCP silent", WIFI_FC_STATE_CONNECTED, 0, 0, 1, 1, 1};
+    sim_wake(&sim, config.ip_reuse_s, &config, &cache, &no_dhcp);
+    sim.silent_disconnect = false;
+
+    // 连续直连失败达到 max_fast_failures 后不再直连，扫描成功后恢复
+    sim.ap_online = false;
+    for (uint8_t i = 0; i < config.max_fast_failures; i++)
+    {
+        sim_wake(&sim, 10, &config, &cache, &off);
+    }
+    sim.ap_online = true;
+    const expect_t skip = {"fast connect failed too often", WIFI_FC_STATE_CONNECTED, 0, 0, 0, 1, 0};
+    sim_wake(&sim, 10, &config, &cache, &skip);
+    sim_wake(&sim, 10, &config, &cache, &warm);
+
+    printf("cold %u ms, cached %u ms (%.1fx)\n", (unsigned)cold_ms, (unsigned)warm_ms,
+           warm_ms ? (double)cold_ms / warm_ms : 0.0);
+    printf("%s (%d failures)\n", s_failures ? "FAILED" : "PASSED", s_failures);
+    return s_failures ? 1 : 0;
+}
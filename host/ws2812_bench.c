@@ -0,0 +1,475 @@
+/*
+ * WS2812 的 RMT 转换函数的测试和性能测量（08_uart/main/led_strip_rmt_ws2812.c）
+ *
+ * 在模拟的 RMT 通道上初始化灯带，随机的颜色刷新后，检查转换出的每一位的高低电平时间
+ * （40MHz 计数时钟：0 为 14/40，1 为 40/14）和 GRB 顺序。
+ * set_pixels()、fill() 和 get_buffer() 写入的数据与逐个 set_pixel() 相同，超出范围时报错；
+ * 在 1024 个 LED 的灯带上比较逐个 set_pixel()、set_pixels()、fill() 和直接写缓冲区每个 LED 的耗时。
+ * 第二个通道上依次接 SK6812 RGBW 和 WS2811，检查各自的时间和字节顺序，第一个通道不受影响；
+ * 两条灯带分别刷新和用 led_strip_refresh_all() 同时刷新，比较所用的时间。
+ * 再单独测量转换函数：查表的实现与原来逐位判断的实现（复制在下面）对 256 个字节值的输出一致，
+ * 按中断中每次补 24 个 RMT 数据（3 字节）的方式转换整条灯带，比较每个 LED 的耗时。
+ *
+ * 用法：ws2812_bench [LED数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_timer.h"
+#include "driver/rmt.h"
+#include "led_strip.h"
+#include "test_util.h"
+
+#define BENCH_CHANNEL RMT_CHANNEL_0
+#define BENCH_CHANNEL2 RMT_CHANNEL_1
+#define BENCH_REFILL_ITEMS (RMT_SIM_MEM_ITEM_NUM / 2)
+
+static const rmt_item32_t s_bit0 = {{{14, 1, 40, 0}}};
+static const rmt_item32_t s_bit1 = {{{40, 1, 14, 0}}};
+
+static uint32_t bench_rand(uint32_t *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/**
+ * @description: 原来的实现：每一位判断一次
+ */
+static void bitloop_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
+                            size_t wanted_num, size_t *translated_size, size_t *item_num)
+{
+    size_t size = 0;
+    size_t num = 0;
+    const uint8_t *psrc = (const uint8_t *)src;
+    rmt_item32_t *pdest = dest;
+    while (size < src_size && num < wanted_num)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            if (*psrc & (1 << (7 - i)))
+            {
+                pdest->val = s_bit1.val;
+            }
+            else
+            {
+                pdest->val = s_bit0.val;
+            }
+            num++;
+            pdest++;
+        }
+        size++;
+        psrc++;
+    }
+    *translated_size = size;
+    *item_num = num;
+}
+
+/**
+ * @description: 按给定的 0、1 检查一个字节转换出的 8 个 RMT 数据
+ */
+static bool check_byte_with(const rmt_item32_t *items, uint8_t value, rmt_item32_t bit0, rmt_item32_t bit1)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        const rmt_item32_t *expect = (value & (0x80 >> i)) ? &bit1 : &bit0;
+        if (items[i].val != expect->val)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_byte(const rmt_item32_t *items, uint8_t value)
+{
+    return check_byte_with(items, value, s_bit0, s_bit1);
+}
+
+static void test_strip(led_strip_t *strip, uint32_t leds)
+{
+    printf("refresh through simulated RMT (%u leds)\n", leds);
+    uint8_t *rgb = malloc(leds * 3);
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < leds * 3; i++)
+    {
+        rgb[i] = bench_rand(&seed) & 0xFF;
+    }
+    for (uint32_t i = 0; i < leds; i++)
+    {
+        CHECK(strip->set_pixel(strip, i, rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]) == ESP_OK, "set_pixel %u", i);
+    }
+    CHECK(strip->set_pixel(strip, leds, 1, 2, 3) == ESP_ERR_INVALID_ARG, "set_pixel out of range");
+    CHECK(strip->refresh(strip, 100) == ESP_OK, "refresh");
+
+    size_t num = 0;
+    const rmt_item32_t *items = rmt_sim_items(BENCH_CHANNEL, &num);
+    CHECK(items && num == (size_t)leds * 24, "%zu items, expect %u", num, leds * 24);
+    uint32_t bad = 0;
+    for (uint32_t i = 0; items && i < leds && (size_t)i * 24 < num; i++)
+    {
+        // GRB
+        bad += !check_byte(items + i * 24, rgb[i * 3 + 1]);
+        bad += !check_byte(items + i * 24 + 8, rgb[i * 3]);
+        bad += !check_byte(items + i * 24 + 16, rgb[i * 3 + 2]);
+    }
+    CHECK(bad == 0, "%u bytes encoded wrong", bad);
+
+    CHECK(strip->clear(strip, 100) == ESP_OK, "clear");
+    items = rmt_sim_items(BENCH_CHANNEL, &num);
+    bad = 0;
+    for (size_t i = 0; items && i < num; i++)
+    {
+        bad += items[i].val != s_bit0.val;
+    }
+    CHECK(bad == 0, "%u items not zero after clear", bad);
+    free(rgb);
+}
+
+/**
+ * @description: 后缓冲区中的颜色（GRB）
+ */
+static bool buffer_pixel_is(led_strip_t *strip, uint32_t index, int r, int g, int b)
+{
+    uint8_t *buf = NULL;
+    size_t size = 0;
+    if (strip->get_buffer(strip, &buf, &size) != ESP_OK || (index + 1) * 3 > size)
+    {
+        return false;
+    }
+    return buf[index * 3] == g && buf[index * 3 + 1] == r && buf[index * 3 + 2] == b;
+}
+
+static void test_bulk(led_strip_t *strip, uint32_t leds)
+{
+    printf("set_pixels, fill, get_buffer\n");
+    rgb_t *colors = malloc(leds * sizeof(rgb_t));
+    uint32_t seed = 3;
+    for (uint32_t i = 0; i < leds; i++)
+    {
+        uint32_t v = bench_rand(&seed);
+        colors[i] = (rgb_t){v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF};
+    }
+    CHECK(strip->set_pixels(strip, 0, colors, leds) == ESP_OK, "set_pixels");
+    CHECK(strip->refresh(strip, 100) == ESP_OK, "refresh");
+    size_t num = 0;
+    const rmt_item32_t *items = rmt_sim_items(BENCH_CHANNEL, &num);
+    uint32_t bad = 0;
+    for (uint32_t i = 0; items && i < leds && (size_t)(i + 1) * 24 <= num; i++)
+    {
+        bad += !check_byte(items + i * 24, colors[i].g) + !check_byte(items + i * 24 + 8, colors[i].r) +
+               !check_byte(items + i * 24 + 16, colors[i].b);
+    }
+    CHECK(num == (size_t)leds * 24 && bad == 0, "set_pixels: %u bytes encoded wrong", bad);
+
+    CHECK(strip->set_pixels(strip, 1, colors, leds) == ESP_ERR_INVALID_ARG, "set_pixels out of range");
+    CHECK(strip->set_pixels(strip, 0, NULL, 1) == ESP_ERR_INVALID_ARG, "set_pixels NULL");
+    CHECK(strip->set_pixels(strip, leds, colors, 0) == ESP_OK, "set_pixels nothing at the end");
+    CHECK(strip->fill(strip, leds, 1, colors[0]) == ESP_ERR_INVALID_ARG, "fill out of range");
+    CHECK(strip->fill(strip, 0, UINT32_MAX, colors[0]) == ESP_ERR_INVALID_ARG, "fill overflow");
+
+    // 只改中间的一段，两边保持刚发出的一帧
+    uint32_t from = leds / 3;
+    uint32_t count = leds - from - leds / 4;
+    CHECK(strip->fill(strip, from, count, (rgb_t){1, 2, 3}) == ESP_OK, "fill");
+    bool ok = true;
+    for (uint32_t i = 0; i < leds; i++)
+    {
+        bool inside = i >= from && i < from + count;
+        ok &= inside ? buffer_pixel_is(strip, i, 1, 2, 3)
+                     : buffer_pixel_is(strip, i, colors[i].r, colors[i].g, colors[i].b);
+    }
+    CHECK(ok, "fill range");
+
+    uint8_t *buf = NULL;
+    size_t size = 0;
+    CHECK(strip->get_buffer(strip, &buf, &size) == ESP_OK && size == (size_t)leds * 3, "get_buffer");
+    CHECK(strip->get_buffer(strip, NULL, NULL) == ESP_ERR_INVALID_ARG, "get_buffer NULL");
+    if (buf)
+    {
+        buf[0] = 0x12;
+        buf[1] = 0x34;
+        buf[2] = 0x56;
+        CHECK(strip->refresh(strip, 100) == ESP_OK, "refresh");
+        items = rmt_sim_items(BENCH_CHANNEL, &num);
+        CHECK(items && check_byte(items, 0x12) && check_byte(items + 8, 0x34) && check_byte(items + 16, 0x56),
+              "written through get_buffer");
+    }
+    free(colors);
+}
+
+/**
+ * @description: 逐个 set_pixel()、set_pixels()、fill() 和直接写缓冲区的耗时
+ */
+static void bench_bulk(uint32_t leds)
+{
+    printf("update %u leds, ns per led\n", leds);
+    led_strip_t *strip = led_strip_init(BENCH_CHANNEL2, 9, leds);
+    CHECK(strip != NULL, "init %u leds", leds);
+    if (!strip)
+    {
+        return;
+    }
+    rgb_t *colors = malloc(leds * sizeof(rgb_t));
+    for (uint32_t i = 0; i < leds; i++)
+    {
+        colors[i] = (rgb_t){i & 0xFF, (i * 3) & 0xFF, (i * 7) & 0xFF};
+    }
+    int rounds = 20000000 / (int)leds + 10;
+    uint8_t *buf = NULL;
+    strip->get_buffer(strip, &buf, NULL);
+    volatile uint8_t sink = 0;
+
+    uint64_t t0 = bench_now_ns();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (uint32_t i = 0; i < leds; i++)
+        {
+            strip->set_pixel(strip, i, colors[i].r, colors[i].g, colors[i].b + r);
+        }
+        sink += buf[r % leds];
+    }
+    double ns_pixel = (double)(bench_now_ns() - t0) / rounds / leds;
+
+    t0 = bench_now_ns();
+    for (int r = 0; r < rounds; r++)
+    {
+        colors[r % leds].b++;
+        strip->set_pixels(strip, 0, colors, leds);
+        sink += buf[r % leds];
+    }
+    double ns_pixels = (double)(bench_now_ns() - t0) / rounds / leds;
+
+    t0 = bench_now_ns();
+    for (int r = 0; r < rounds; r++)
+    {
+        strip->fill(strip, 0, leds, (rgb_t){r, 2, 3});
+        sink += buf[r % leds];
+    }
+    double ns_fill = (double)(bench_now_ns() - t0) / rounds / leds;
+
+    // 调用方按 GRB 直接渲染
+    t0 = bench_now_ns();
+    for (int r = 0; r < rounds; r++)
+    {
+        uint8_t *p = buf;
+        for (uint32_t i = 0; i < leds; i++, p += 3)
+        {
+            p[0] = colors[i].g;
+            p[1] = colors[i].r;
+            p[2] = colors[i].b + r;
+        }
+        sink += buf[r % leds];
+    }
+    double ns_direct = (double)(bench_now_ns() - t0) / rounds / leds;
+    (void)sink;
+
+    printf("  set_pixel:  %6.2f ns/led\n", ns_pixel);
+    printf("  set_pixels: %6.2f ns/led (%.1fx)\n", ns_pixels, ns_pixel / ns_pixels);
+    printf("  fill:       %6.2f ns/led (%.1fx)\n", ns_fill, ns_pixel / ns_fill);
+    printf("  direct:     %6.2f ns/led (%.1fx)\n", ns_direct, ns_pixel / ns_direct);
+    CHECK(ns_pixels < ns_pixel && ns_fill < ns_pixel, "bulk operations slower than set_pixel");
+    free(colors);
+    CHECK(led_strip_denit(strip) == ESP_OK, "denit %u leds", leds);
+}
+
+static void test_chips(led_strip_t *strip, uint32_t leds)
+{
+    printf("second channel: SK6812 RGBW, WS2811\n");
+    CHECK(strip->set_pixel_rgbw(strip, 0, 1, 2, 3, 4) == ESP_ERR_NOT_SUPPORTED, "rgbw on WS2812B");
+
+    // SK6812：300/900、600/600 ns，GRBW
+    const rmt_item32_t sk0 = {{{12, 1, 36, 0}}};
+    const rmt_item32_t sk1 = {{{24, 1, 24, 0}}};
+    led_strip_t *sk = led_strip_init_chip(BENCH_CHANNEL2, 9, 4, LED_STRIP_SK6812_RGBW);
+    CHECK(sk != NULL, "init SK6812");
+    if (sk)
+    {
+        CHECK(sk->set_pixel_rgbw(sk, 1, 0x11, 0x22, 0x33, 0x44) == ESP_OK, "rgbw on SK6812");
+        CHECK(sk->set_pixel(sk, 2, 0xA1, 0xB2, 0xC3) == ESP_OK, "rgb on SK6812");
+        CHECK(sk->refresh(sk, 100) == ESP_OK, "refresh SK6812");
+        size_t num = 0;
+        const rmt_item32_t *items = rmt_sim_items(BENCH_CHANNEL2, &num);
+        CHECK(num == 4 * 32, "SK6812: %zu items", num);
+        if (num == 4 * 32)
+        {
+            const uint8_t expect[8] = {0x22, 0x11, 0x33, 0x44, 0xB2, 0xA1, 0xC3, 0x00};
+            for (int i = 0; i < 8; i++)
+            {
+                CHECK(check_byte_with(items + 32 + i * 8, expect[i], sk0, sk1), "SK6812 byte %d", i);
+            }
+            CHECK(check_byte_with(items, 0, sk0, sk1), "SK6812 timing of 0");
+        }
+        CHECK(led_strip_denit(sk) == ESP_OK, "denit SK6812");
+    }
+
+    // WS2811：250/1000、600/650 ns，RGB
+    const rmt_item32_t ws11_0 = {{{10, 1, 40, 0}}};
+    const rmt_item32_t ws11_1 = {{{24, 1, 26, 0}}};
+    led_strip_t *ws11 = led_strip_init_chip(BENCH_CHANNEL2, 9, 2, LED_STRIP_WS2811);
+    CHECK(ws11 != NULL, "init WS2811");
+    if (ws11)
+    {
+        CHECK(ws11->set_pixel(ws11, 1, 0x5A, 0x0F, 0xF0) == ESP_OK, "rgb on WS2811");
+        CHECK(ws11->refresh(ws11, 100) == ESP_OK, "refresh WS2811");
+        size_t num = 0;
+        const rmt_item32_t *items = rmt_sim_items(BENCH_CHANNEL2, &num);
+        CHECK(num == 2 * 24, "WS2811: %zu items", num);
+        if (num == 2 * 24)
+        {
+            CHECK(check_byte_with(items + 24, 0x5A, ws11_0, ws11_1) && check_byte_with(items + 32, 0x0F, ws11_0, ws11_1) &&
+                      check_byte_with(items + 40, 0xF0, ws11_0, ws11_1),
+                  "WS2811 RGB order / timing");
+        }
+        CHECK(led_strip_denit(ws11) == ESP_OK, "denit WS2811");
+    }
+
+    // 第一条灯带的时间没有被改变
+    CHECK(strip->set_pixel(strip, 0, 0x0F, 0xF0, 0x3C) == ESP_OK, "set_pixel");
+    CHECK(strip->refresh(strip, 100) == ESP_OK, "refresh");
+    size_t num = 0;
+    const rmt_item32_t *items = rmt_sim_items(BENCH_CHANNEL, &num);
+    CHECK(num == (size_t)leds * 24 && check_byte(items, 0xF0) && check_byte(items + 8, 0x0F) && check_byte(items + 16, 0x3C),
+          "first strip after other chips");
+}
+
+static void test_parallel(led_strip_t *strip, uint32_t leds)
+{
+    printf("two strips of %u leds: one by one vs led_strip_refresh_all\n", leds);
+    led_strip_t *other = led_strip_init(BENCH_CHANNEL2, 9, leds);
+    CHECK(other != NULL, "init second strip");
+    if (!other)
+    {
+        return;
+    }
+    led_strip_t *const strips[2] = {strip, other};
+    // 先刷新一次，之后的测量不包括复位时间
+    CHECK(led_strip_refresh_all(strips, 2, 100) == ESP_OK, "refresh_all");
+
+    int64_t t0 = esp_timer_get_time();
+    CHECK(strip->refresh(strip, 100) == ESP_OK && other->refresh(other, 100) == ESP_OK, "refresh one by one");
+    int64_t t1 = esp_timer_get_time();
+    CHECK(led_strip_refresh_all(strips, 2, 100) == ESP_OK, "refresh_all");
+    int64_t t2 = esp_timer_get_time();
+    printf("  one by one: %6lld us\n", (long long)(t1 - t0));
+    printf("  all:        %6lld us\n", (long long)(t2 - t1));
+    // 一条灯带每个 LED 24 位 × 1.35 us
+    int64_t frame_us = (int64_t)leds * 24 * 1350 / 1000;
+    CHECK(t1 - t0 >= 2 * frame_us, "one by one took %lld us, expect >= %lld", (long long)(t1 - t0), (long long)(2 * frame_us));
+    CHECK(t2 - t1 < frame_us * 3 / 2, "refresh_all took %lld us, expect about %lld", (long long)(t2 - t1), (long long)frame_us);
+    CHECK(led_strip_denit(other) == ESP_OK, "denit second strip");
+}
+
+static void test_all_bytes(sample_to_rmt_t lut, size_t *lut_num)
+{
+    printf("all byte values: lut vs bit loop\n");
+    uint8_t src[256];
+    for (int i = 0; i < 256; i++)
+    {
+        src[i] = i;
+    }
+    static rmt_item32_t a[256 * 8], b[256 * 8];
+    // 转换函数由 item_num 的地址取得通道的上下文，要用通道的 item_num
+    size_t ta = 0, tb = 0, nb = 0;
+    size_t na = 0;
+    lut(src, a, sizeof(src), sizeof(a) / sizeof(a[0]), &ta, lut_num);
+    na = *lut_num;
+    bitloop_adapter(src, b, sizeof(src), sizeof(b) / sizeof(b[0]), &tb, &nb);
+    CHECK(ta == 256 && na == 256 * 8, "lut translated %zu bytes, %zu items", ta, na);
+    CHECK(ta == tb && na == nb && memcmp(a, b, sizeof(a)) == 0, "lut output differs from bit loop");
+
+    // 不满一个字节的请求也要转换一个字节，与原来的行为一致
+    lut(src + 0xA5, a, 5, 3, &ta, lut_num);
+    na = *lut_num;
+    CHECK(ta == 1 && na == 8 && check_byte(a, 0xA5), "short request: %zu bytes, %zu items", ta, na);
+    lut(NULL, a, 5, 24, &ta, lut_num);
+    na = *lut_num;
+    CHECK(ta == 0 && na == 0, "NULL source");
+}
+
+/**
+ * @description: 按中断补数据的方式转换整条灯带
+ * @return       每个 LED 的纳秒数
+ */
+static double bench_translator(sample_to_rmt_t fn, size_t *item_num, const uint8_t *src, size_t size, int rounds)
+{
+    static rmt_item32_t mem[BENCH_REFILL_ITEMS + 8];
+    volatile uint32_t sink = 0;
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < rounds; r++)
+    {
+        uint64_t t0 = bench_now_ns();
+        const uint8_t *p = src;
+        size_t left = size;
+        while (left)
+        {
+            size_t translated = 0;
+            fn(p, mem, left, BENCH_REFILL_ITEMS, &translated, item_num);
+            sink += mem[*item_num - 1].val;
+            p += translated;
+            left -= translated;
+        }
+        uint64_t dt = bench_now_ns() - t0;
+        if (dt < best)
+        {
+            best = dt;
+        }
+    }
+    (void)sink;
+    return (double)best / (size / 3);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t leds = argc > 1 ? (uint32_t)atoi(argv[1]) : 300;
+    if (leds == 0)
+    {
+        leds = 1;
+    }
+
+    led_strip_t *strip = led_strip_init(BENCH_CHANNEL, 8, leds);
+    CHECK(strip != NULL, "led_strip_init");
+    if (!strip)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    test_strip(strip, leds);
+    test_bulk(strip, leds);
+    bench_bulk(1024);
+
+    test_chips(strip, leds);
+    test_parallel(strip, leds);
+
+    sample_to_rmt_t lut = rmt_sim_translator(BENCH_CHANNEL);
+    size_t *lut_num = rmt_sim_item_num(BENCH_CHANNEL);
+    test_all_bytes(lut, lut_num);
+
+    printf("translator, %u leds, %d items per refill\n", leds, BENCH_REFILL_ITEMS);
+    size_t size = (size_t)leds * 3;
+    uint8_t *src = malloc(size);
+    uint32_t seed = 7;
+    for (size_t i = 0; i < size; i++)
+    {
+        src[i] = bench_rand(&seed) & 0xFF;
+    }
+    int rounds = 20000000 / (int)size + 10;
+    size_t bit_num = 0;
+    double ns_bit = bench_translator(bitloop_adapter, &bit_num, src, size, rounds);
+    double ns_lut = bench_translator(lut, lut_num, src, size, rounds);
+    printf("  bit loop: %7.2f ns/led\n", ns_bit);
+    printf("  lut:      %7.2f ns/led (%.2fx)\n", ns_lut, ns_bit / ns_lut);
+    free(src);
+
+    CHECK(led_strip_denit(strip) == ESP_OK, "led_strip_denit");
+
+    if (s_failures)
+    {
+        printf("FAILED (%d failures)\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}